@@ -0,0 +1,312 @@
+/*! @file avx512_mathfun.h
+ *  @brief AVX-512 implementation of sin, cos, sincos, exp, log, tanh and
+ *  the logistic function.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *  The algorithms are the same cephes ones as in avx_mathfun.h, rewritten
+ *  with AVX-512F integer operations, FMA and mask registers, so only
+ *  AVX-512F is required.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef INC_SIMD_AVX512_MATHFUN_H_
+#define INC_SIMD_AVX512_MATHFUN_H_
+
+#include <math.h>
+#include <simd/avx_mathfun.h>
+
+/* GCC 12 reports the self-initialized __Y of _mm512_undefined_ps() and co.
+   in avx512fintrin.h as maybe uninitialized when the unmasked intrinsics are
+   inlined, fixed in GCC 12.3 */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+/* broadcasts the constant declared in avx_mathfun.h */
+#define _PS512(Name) _mm512_set1_ps(_ps256_##Name[0])
+#define _PI32_512(Name) _mm512_set1_epi32(_pi32_256_##Name[0])
+
+static inline __m512 abs512_ps(__m512 x) {
+  return _mm512_castsi512_ps(_mm512_and_si512(
+      _mm512_castps_si512(x), _mm512_set1_epi32(0x7fffffff)));
+}
+
+static inline __m512 xor512_ps(__m512 x, __m512i sign) {
+  return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(x), sign));
+}
+
+/* natural logarithm computed for 16 simultaneous float,
+   returns NaN for x <= 0 and NaN */
+static inline __m512 log512_ps(__m512 x) {
+  const __m512 one = _PS512(1);
+  __mmask16 invalid = _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_NGT_UQ);
+
+  /* cut off denormalized stuff */
+  __m512i bits = _mm512_castps_si512(_mm512_max_ps(
+      x, _mm512_castsi512_ps(_mm512_set1_epi32(0x00800000))));
+  __m512i imm0 = _mm512_sub_epi32(_mm512_srli_epi32(bits, 23),
+                                  _PI32_512(0x7f));
+  __m512 e = _mm512_add_ps(_mm512_cvtepi32_ps(imm0), one);
+
+  /* keep only the fractional part, x is in [0.5, 1) */
+  x = _mm512_castsi512_ps(_mm512_or_si512(
+      _mm512_and_si512(bits, _mm512_set1_epi32(~0x7f800000)),
+      _mm512_castps_si512(_PS512(0p5))));
+
+  /* if (x < SQRTHF) { e -= 1; x = x + x - 1.0; } else { x = x - 1.0; } */
+  __mmask16 mask = _mm512_cmp_ps_mask(x, _PS512(cephes_SQRTHF), _CMP_LT_OS);
+  x = _mm512_mask_add_ps(x, mask, x, x);
+  x = _mm512_sub_ps(x, one);
+  e = _mm512_mask_sub_ps(e, mask, e, one);
+
+  __m512 z = _mm512_mul_ps(x, x);
+  __m512 y = _PS512(cephes_log_p0);
+  y = _mm512_fmadd_ps(y, x, _PS512(cephes_log_p1));
+  y = _mm512_fmadd_ps(y, x, _PS512(cephes_log_p2));
+  y = _mm512_fmadd_ps(y, x, _PS512(cephes_log_p3));
+  y = _mm512_fmadd_ps(y, x, _PS512(cephes_log_p4));
+  y = _mm512_fmadd_ps(y, x, _PS512(cephes_log_p5));
+  y = _mm512_fmadd_ps(y, x, _PS512(cephes_log_p6));
+  y = _mm512_fmadd_ps(y, x, _PS512(cephes_log_p7));
+  y = _mm512_fmadd_ps(y, x, _PS512(cephes_log_p8));
+  y = _mm512_mul_ps(y, x);
+  y = _mm512_mul_ps(y, z);
+  y = _mm512_fmadd_ps(e, _PS512(cephes_log_q1), y);
+  y = _mm512_fnmadd_ps(z, _PS512(0p5), y);
+  x = _mm512_add_ps(x, y);
+  x = _mm512_fmadd_ps(e, _PS512(cephes_log_q2), x);
+  return _mm512_mask_mov_ps(x, invalid, _mm512_set1_ps(NAN));
+}
+
+/* exp(x) computed for 16 simultaneous float. Unlike exp256_ps(), 2^n is
+   applied with VSCALEFPS, so the results near the float range boundaries
+   are correctly rounded to infinity, denormals and zero */
+static inline __m512 exp512_ps(__m512 x) {
+  x = _mm512_min_ps(x, _mm512_set1_ps(89.f));
+  x = _mm512_max_ps(x, _mm512_set1_ps(-104.f));
+
+  /* express exp(x) as exp(g + n*log(2)) */
+  __m512 fx = _mm512_fmadd_ps(x, _PS512(cephes_LOG2EF), _PS512(0p5));
+  fx = _mm512_roundscale_ps(fx, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+  x = _mm512_fnmadd_ps(fx, _PS512(cephes_exp_C1), x);
+  x = _mm512_fnmadd_ps(fx, _PS512(cephes_exp_C2), x);
+
+  __m512 z = _mm512_mul_ps(x, x);
+  __m512 y = _PS512(cephes_exp_p0);
+  y = _mm512_fmadd_ps(y, x, _PS512(cephes_exp_p1));
+  y = _mm512_fmadd_ps(y, x, _PS512(cephes_exp_p2));
+  y = _mm512_fmadd_ps(y, x, _PS512(cephes_exp_p3));
+  y = _mm512_fmadd_ps(y, x, _PS512(cephes_exp_p4));
+  y = _mm512_fmadd_ps(y, x, _PS512(cephes_exp_p5));
+  y = _mm512_fmadd_ps(y, z, x);
+  y = _mm512_add_ps(y, _PS512(1));
+  return _mm512_scalef_ps(y, fx);
+}
+
+/* evaluation of 16 sines and cosines at once, see sincos256_ps() */
+static inline void sincos512_ps(__m512 x, __m512 *s, __m512 *c) {
+  __m512i sign_bit_sin = _mm512_and_si512(_mm512_castps_si512(x),
+                                          _mm512_set1_epi32(0x80000000));
+  x = abs512_ps(x);
+
+  /* scale by 4/Pi, j=(j+1) & (~1) (see the cephes sources) */
+  __m512 y = _mm512_mul_ps(x, _PS512(cephes_FOPI));
+  __m512i j = _mm512_cvttps_epi32(y);
+  j = _mm512_add_epi32(j, _PI32_512(1));
+  j = _mm512_and_si512(j, _PI32_512(inv1));
+  y = _mm512_cvtepi32_ps(j);
+
+  /* there is one polynom for 0 <= x <= Pi/4 and another one for
+     Pi/4 < x <= Pi/2, both are computed */
+  __mmask16 cos_poly = _mm512_test_epi32_mask(j, _PI32_512(2));
+  sign_bit_sin = _mm512_xor_si512(sign_bit_sin, _mm512_slli_epi32(
+      _mm512_and_si512(j, _PI32_512(4)), 29));
+  __m512i sign_bit_cos = _mm512_slli_epi32(_mm512_andnot_si512(
+      _mm512_sub_epi32(j, _PI32_512(2)), _PI32_512(4)), 29);
+
+  /* The magic pass: "Extended precision modular arithmetic"
+     x = ((x - y * DP1) - y * DP2) - y * DP3; */
+  x = _mm512_fmadd_ps(y, _PS512(minus_cephes_DP1), x);
+  x = _mm512_fmadd_ps(y, _PS512(minus_cephes_DP2), x);
+  x = _mm512_fmadd_ps(y, _PS512(minus_cephes_DP3), x);
+
+  __m512 z = _mm512_mul_ps(x, x);
+  __m512 y1 = _PS512(coscof_p0);
+  y1 = _mm512_fmadd_ps(y1, z, _PS512(coscof_p1));
+  y1 = _mm512_fmadd_ps(y1, z, _PS512(coscof_p2));
+  y1 = _mm512_mul_ps(_mm512_mul_ps(y1, z), z);
+  y1 = _mm512_fnmadd_ps(z, _PS512(0p5), y1);
+  y1 = _mm512_add_ps(y1, _PS512(1));
+
+  __m512 y2 = _PS512(sincof_p0);
+  y2 = _mm512_fmadd_ps(y2, z, _PS512(sincof_p1));
+  y2 = _mm512_fmadd_ps(y2, z, _PS512(sincof_p2));
+  y2 = _mm512_mul_ps(y2, z);
+  y2 = _mm512_fmadd_ps(y2, x, x);
+
+  *s = xor512_ps(_mm512_mask_blend_ps(cos_poly, y2, y1), sign_bit_sin);
+  *c = xor512_ps(_mm512_mask_blend_ps(cos_poly, y1, y2), sign_bit_cos);
+}
+
+static inline __m512 sin512_ps(__m512 x) {
+  __m512 s, c;
+  sincos512_ps(x, &s, &c);
+  return s;
+}
+
+static inline __m512 cos512_ps(__m512 x) {
+  __m512 s, c;
+  sincos512_ps(x, &s, &c);
+  return c;
+}
+
+/// @brief Calculates y^x.
+static inline __m512 pow512_ps(__m512 y, __m512 x) {
+  return exp512_ps(_mm512_mul_ps(log512_ps(y), x));
+}
+
+/// @brief Calculates tanh(x), see tanh256_ps().
+static inline __m512 tanh512_ps(__m512 x) {
+  __m512i sign_bit = _mm512_and_si512(_mm512_castps_si512(x),
+                                      _mm512_set1_epi32(0x80000000));
+  __m512 ax = abs512_ps(x);
+
+  __m512 z = _mm512_mul_ps(x, x);
+  __m512 y = _PS512(cephes_tanh_p0);
+  y = _mm512_fmadd_ps(y, z, _PS512(cephes_tanh_p1));
+  y = _mm512_fmadd_ps(y, z, _PS512(cephes_tanh_p2));
+  y = _mm512_fmadd_ps(y, z, _PS512(cephes_tanh_p3));
+  y = _mm512_fmadd_ps(y, z, _PS512(cephes_tanh_p4));
+  y = _mm512_mul_ps(y, z);
+  y = _mm512_fmadd_ps(y, x, x);
+
+  /* exp512_ps() overflows to infinity, so the large arguments give 1 */
+  __m512 e = exp512_ps(_mm512_add_ps(ax, ax));
+  __m512 t = _mm512_sub_ps(_PS512(1), _mm512_div_ps(
+      _PS512(2), _mm512_add_ps(e, _PS512(1))));
+  t = _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(t), sign_bit));
+
+  __mmask16 small = _mm512_cmp_ps_mask(ax, _PS512(tanh_threshold),
+                                       _CMP_LT_OS);
+  return _mm512_mask_blend_ps(small, t, y);
+}
+
+/// @brief Calculates the logistic function 1 / (1 + exp(-x)).
+static inline __m512 sigmoid512_ps(__m512 x) {
+  __m512 e = exp512_ps(xor512_ps(x, _mm512_set1_epi32(0x80000000)));
+  return _mm512_div_ps(_PS512(1), _mm512_add_ps(e, _PS512(1)));
+}
+
+/* The fast accuracy tier, see exp256_fast_ps() and the following */
+
+/// @brief Calculates exp(x), 2^n is applied with VSCALEFPS.
+static inline __m512 exp512_fast_ps(__m512 x) {
+  __m512 t = _mm512_mul_ps(x, _PS512(cephes_LOG2EF));
+  __m512 n = _mm512_roundscale_ps(t, _MM_FROUND_TO_NEAREST_INT |
+                                     _MM_FROUND_NO_EXC);
+  __m512 f = _mm512_sub_ps(t, n);
+  __m512 y = _PS512(fast_exp2_p3);
+  y = _mm512_fmadd_ps(y, f, _PS512(fast_exp2_p2));
+  y = _mm512_fmadd_ps(y, f, _PS512(fast_exp2_p1));
+  y = _mm512_fmadd_ps(y, f, _PS512(fast_exp2_p0));
+  return _mm512_scalef_ps(y, n);
+}
+
+/// @brief Calculates log(x), x must be a normal positive number.
+static inline __m512 log512_fast_ps(__m512 x) {
+  /* the mantissa in [1, 2) and the matching exponent */
+  __m512 m = _mm512_getmant_ps(x, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_src);
+  __m512 e = _mm512_getexp_ps(x);
+  /* if (sqrt(2) < m) { m /= 2; e += 1; } */
+  __mmask16 big = _mm512_cmp_ps_mask(_PS512(fast_SQRT2), m, _CMP_LT_OS);
+  e = _mm512_mask_add_ps(e, big, e, _PS512(1));
+  m = _mm512_mask_mul_ps(m, big, m, _PS512(0p5));
+  __m512 u = _mm512_sub_ps(m, _PS512(1));
+  __m512 y = _PS512(fast_log_p4);
+  y = _mm512_fmadd_ps(y, u, _PS512(fast_log_p3));
+  y = _mm512_fmadd_ps(y, u, _PS512(fast_log_p2));
+  y = _mm512_fmadd_ps(y, u, _PS512(fast_log_p1));
+  y = _mm512_fmadd_ps(y, u, _PS512(fast_log_p0));
+  return _mm512_fmadd_ps(e, _PS512(fast_LN2), _mm512_mul_ps(y, u));
+}
+
+/* sin(x - shift * Pi) * (-1)^flip, see sin256_fast_shifted() */
+static inline __m512 sin512_fast_shifted(__m512 x, __m512 shift,
+                                         __m512i flip) {
+  __m512i k = _mm512_cvtps_epi32(_mm512_fmsub_ps(x, _PS512(fast_1_PI),
+                                                 shift));
+  __m512 kf = _mm512_add_ps(_mm512_cvtepi32_ps(k), shift);
+  __m512 r = _mm512_fmadd_ps(kf, _PS512(minus_fast_PI_A), x);
+  r = _mm512_fmadd_ps(kf, _PS512(minus_fast_PI_B), r);
+  __m512 z = _mm512_mul_ps(r, r);
+  __m512 y = _PS512(fast_sin_p3);
+  y = _mm512_fmadd_ps(y, z, _PS512(fast_sin_p2));
+  y = _mm512_fmadd_ps(y, z, _PS512(fast_sin_p1));
+  y = _mm512_fmadd_ps(y, z, _PS512(fast_sin_p0));
+  y = _mm512_mul_ps(y, r);
+  return xor512_ps(y, _mm512_slli_epi32(_mm512_add_epi32(k, flip), 31));
+}
+
+/// @brief Calculates sin(x), the absolute error grows with |x|.
+static inline __m512 sin512_fast_ps(__m512 x) {
+  return sin512_fast_shifted(x, _mm512_setzero_ps(), _mm512_setzero_si512());
+}
+
+/// @brief Calculates cos(x) = -sin(x - Pi / 2).
+static inline __m512 cos512_fast_ps(__m512 x) {
+  return sin512_fast_shifted(x, _PS512(0p5), _mm512_set1_epi32(1));
+}
+
+/// @brief Calculates tanh(x), see tanh256_fast_ps().
+static inline __m512 tanh512_fast_ps(__m512 x) {
+  __m512i sign_bit = _mm512_and_si512(_mm512_castps_si512(x),
+                                      _mm512_set1_epi32(0x80000000));
+  __m512 ax = abs512_ps(x);
+  __m512 z = _mm512_mul_ps(x, x);
+  __m512 y = _mm512_fmadd_ps(_PS512(fast_tanh_p2), z, _PS512(fast_tanh_p1));
+  y = _mm512_fmadd_ps(_mm512_mul_ps(y, z), x, x);
+  __m512 e = exp512_fast_ps(_mm512_add_ps(ax, ax));
+  __m512 t = _mm512_sub_ps(_PS512(1), _mm512_div_ps(
+      _PS512(2), _mm512_add_ps(e, _PS512(1))));
+  t = _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(t), sign_bit));
+  __mmask16 small = _mm512_cmp_ps_mask(ax, _PS512(fast_tanh_threshold),
+                                       _CMP_LT_OS);
+  return _mm512_mask_blend_ps(small, t, y);
+}
+
+/// @brief Calculates the logistic function 1 / (1 + exp(-x)).
+static inline __m512 sigmoid512_fast_ps(__m512 x) {
+  __m512 e = exp512_fast_ps(xor512_ps(x, _mm512_set1_epi32(0x80000000)));
+  return _mm512_div_ps(_PS512(1), _mm512_add_ps(e, _PS512(1)));
+}
+
+/// @brief Calculates y^x, y must be a normal positive number.
+static inline __m512 pow512_fast_ps(__m512 y, __m512 x) {
+  return exp512_fast_ps(_mm512_mul_ps(log512_fast_ps(y), x));
+}
+
+#pragma GCC diagnostic pop
+
+#endif  // INC_SIMD_AVX512_MATHFUN_H_
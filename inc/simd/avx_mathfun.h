@@ -27,13 +27,18 @@
   3. This notice may not be removed or altered from any source distribution.
 
   (this is the zlib license)
+
+  Altered for libSimd: native AVX2 integer operations, FMA in the
+  polynoms, tanh256_ps, sigmoid256_ps and the fast accuracy tier.
 */
 
 #ifndef INC_SIMD_AVX_MATHFUN_H_
 #define INC_SIMD_AVX_MATHFUN_H_
 
 #pragma GCC diagnostic push
+#ifdef __cplusplus
 #pragma GCC diagnostic ignored "-Wold-style-cast"
+#endif
 
 #include <simd/instruction_set.h>
 
@@ -60,18 +65,22 @@ _PI32AVX_CONST(4, 4);
   static const ALIGN32_BEG float _ps256_##Name[8] ALIGN32_END = { Val, Val, Val, Val, Val, Val, Val, Val }
 #define _PI32_CONST256(Name, Val)                                            \
   static const ALIGN32_BEG int _pi32_256_##Name[8] ALIGN32_END = { Val, Val, Val, Val, Val, Val, Val, Val }
-#define _PS256_CONST_TYPE(Name, Type, Val)                                 \
-  static const ALIGN32_BEG Type _ps256_##Name[8] ALIGN32_END = { Val, Val, Val, Val, Val, Val, Val, Val }
+/* the bit masks are built from int-s, reading them through a float pointer
+   would break strict aliasing */
+#define _PS256_MASK(Name, Val)                                             \
+  static inline v8sf _ps256_##Name(void) {                                \
+    return _mm256_castsi256_ps(_mm256_set1_epi32((int)(Val)));             \
+  }
 
 _PS256_CONST(1  , 1.0f);
 _PS256_CONST(0p5, 0.5f);
 /* the smallest non denormalized float number */
-_PS256_CONST_TYPE(min_norm_pos, int, 0x00800000);
-_PS256_CONST_TYPE(mant_mask, int, 0x7f800000);
-_PS256_CONST_TYPE(inv_mant_mask, int, ~0x7f800000);
+_PS256_MASK(min_norm_pos, 0x00800000);
+_PS256_MASK(mant_mask, 0x7f800000);
+_PS256_MASK(inv_mant_mask, ~0x7f800000);
 
-_PS256_CONST_TYPE(sign_mask, unsigned, 0x80000000);
-_PS256_CONST_TYPE(inv_sign_mask, int, ~0x80000000);
+_PS256_MASK(sign_mask, 0x80000000);
+_PS256_MASK(inv_sign_mask, ~0x80000000);
 
 _PI32_CONST256(0, 0);
 _PI32_CONST256(1, 1);
@@ -126,7 +135,7 @@ static inline v8si _mm256_##fn(v8si x, int a) \
   return(ret); \
 }
 
-#pragma message "Warning: using SSE2 to perform AVX2 bitshift ops"
+/* The AVX tiers without AVX2 perform the bitshift ops with SSE2 */
 AVX2_BITOP_USING_SSE2(slli_epi32)
 AVX2_BITOP_USING_SSE2(srli_epi32)
 
@@ -145,7 +154,7 @@ static inline v8si _mm256_##fn(v8si x, v8si y) \
   return(ret); \
 }
 
-#pragma message "Warning: using SSE2 to perform AVX2 integer ops"
+/* The AVX tiers without AVX2 perform the integer ops with SSE2 */
 AVX2_INTOP_USING_SSE2(and_si128)
 AVX2_INTOP_USING_SSE2(andnot_si128)
 AVX2_INTOP_USING_SSE2(cmpeq_epi32)
@@ -154,6 +163,15 @@ AVX2_INTOP_USING_SSE2(add_epi32)
 
 #endif /* __AVX2__ */
 
+/* a * b + c, fused when FMA is available */
+#ifdef __FMA__
+#define fmadd256_ps _mm256_fmadd_ps
+#else
+static inline v8sf fmadd256_ps(v8sf a, v8sf b, v8sf c) {
+  return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+}
+#endif
+
 
 /* natural logarithm computed for 8 simultaneous float 
    return NaN for x <= 0
@@ -165,13 +183,13 @@ static inline v8sf log256_ps(v8sf x) {
   //v8sf invalid_mask = _mm256_cmple_ps(x, _mm256_setzero_ps());
   v8sf invalid_mask = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LE_OS);
 
-  x = _mm256_max_ps(x, *(v8sf*)_ps256_min_norm_pos);  /* cut off denormalized stuff */
+  x = _mm256_max_ps(x, _ps256_min_norm_pos());  /* cut off denormalized stuff */
 
   // can be done with AVX2
   imm0 = _mm256_srli_epi32(_mm256_castps_si256(x), 23);
 
   /* keep only the fractional part */
-  x = _mm256_and_ps(x, *(v8sf*)_ps256_inv_mant_mask);
+  x = _mm256_and_ps(x, _ps256_inv_mant_mask());
   x = _mm256_or_ps(x, *(v8sf*)_ps256_0p5);
 
   // this is again another AVX2 instruction
@@ -196,22 +214,14 @@ static inline v8sf log256_ps(v8sf x) {
   v8sf z = _mm256_mul_ps(x,x);
 
   v8sf y = *(v8sf*)_ps256_cephes_log_p0;
-  y = _mm256_mul_ps(y, x);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_cephes_log_p1);
-  y = _mm256_mul_ps(y, x);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_cephes_log_p2);
-  y = _mm256_mul_ps(y, x);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_cephes_log_p3);
-  y = _mm256_mul_ps(y, x);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_cephes_log_p4);
-  y = _mm256_mul_ps(y, x);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_cephes_log_p5);
-  y = _mm256_mul_ps(y, x);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_cephes_log_p6);
-  y = _mm256_mul_ps(y, x);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_cephes_log_p7);
-  y = _mm256_mul_ps(y, x);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_cephes_log_p8);
+  y = fmadd256_ps(y, x, *(v8sf*)_ps256_cephes_log_p1);
+  y = fmadd256_ps(y, x, *(v8sf*)_ps256_cephes_log_p2);
+  y = fmadd256_ps(y, x, *(v8sf*)_ps256_cephes_log_p3);
+  y = fmadd256_ps(y, x, *(v8sf*)_ps256_cephes_log_p4);
+  y = fmadd256_ps(y, x, *(v8sf*)_ps256_cephes_log_p5);
+  y = fmadd256_ps(y, x, *(v8sf*)_ps256_cephes_log_p6);
+  y = fmadd256_ps(y, x, *(v8sf*)_ps256_cephes_log_p7);
+  y = fmadd256_ps(y, x, *(v8sf*)_ps256_cephes_log_p8);
   y = _mm256_mul_ps(y, x);
 
   y = _mm256_mul_ps(y, z);
@@ -260,13 +270,9 @@ static inline v8sf exp256_ps(v8sf x) {
   //imm0 = _mm256_cvttps_epi32(fx);
   //tmp  = _mm256_cvtepi32_ps(imm0);
   
-  tmp = _mm256_floor_ps(fx);
-
-  /* if greater, substract 1 */
-  //v8sf mask = _mm256_cmpgt_ps(tmp, fx);    
-  v8sf mask = _mm256_cmp_ps(tmp, fx, _CMP_GT_OS);    
-  mask = _mm256_and_ps(mask, one);
-  fx = _mm256_sub_ps(tmp, mask);
+  /* unlike the truncation, floor needs no "if greater, substract 1"
+     correction (which used _CMP_GT_OS, unsupported by the SSE emulation) */
+  fx = _mm256_floor_ps(fx);
 
   tmp = _mm256_mul_ps(fx, *(v8sf*)_ps256_cephes_exp_C1);
   v8sf z = _mm256_mul_ps(fx, *(v8sf*)_ps256_cephes_exp_C2);
@@ -276,18 +282,12 @@ static inline v8sf exp256_ps(v8sf x) {
   z = _mm256_mul_ps(x,x);
   
   v8sf y = *(v8sf*)_ps256_cephes_exp_p0;
-  y = _mm256_mul_ps(y, x);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_cephes_exp_p1);
-  y = _mm256_mul_ps(y, x);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_cephes_exp_p2);
-  y = _mm256_mul_ps(y, x);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_cephes_exp_p3);
-  y = _mm256_mul_ps(y, x);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_cephes_exp_p4);
-  y = _mm256_mul_ps(y, x);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_cephes_exp_p5);
-  y = _mm256_mul_ps(y, z);
-  y = _mm256_add_ps(y, x);
+  y = fmadd256_ps(y, x, *(v8sf*)_ps256_cephes_exp_p1);
+  y = fmadd256_ps(y, x, *(v8sf*)_ps256_cephes_exp_p2);
+  y = fmadd256_ps(y, x, *(v8sf*)_ps256_cephes_exp_p3);
+  y = fmadd256_ps(y, x, *(v8sf*)_ps256_cephes_exp_p4);
+  y = fmadd256_ps(y, x, *(v8sf*)_ps256_cephes_exp_p5);
+  y = fmadd256_ps(y, z, x);
   y = _mm256_add_ps(y, one);
 
   /* build 2^n */
@@ -335,9 +335,9 @@ static inline v8sf sin256_ps(v8sf x) { // any x
 
   sign_bit = x;
   /* take the absolute value */
-  x = _mm256_and_ps(x, *(v8sf*)_ps256_inv_sign_mask);
+  x = _mm256_and_ps(x, _ps256_inv_sign_mask());
   /* extract the sign bit (upper one) */
-  sign_bit = _mm256_and_ps(sign_bit, *(v8sf*)_ps256_sign_mask);
+  sign_bit = _mm256_and_ps(sign_bit, _ps256_sign_mask());
   
   /* scale by 4/Pi */
   y = _mm256_mul_ps(x, *(v8sf*)_ps256_cephes_FOPI);
@@ -354,11 +354,11 @@ static inline v8sf sin256_ps(v8sf x) { // any x
   /* j=(j+1) & (~1) (see the cephes sources) */
   // another two AVX2 instruction
   imm2 = _mm256_add_epi32(imm2, *(v8si*)_pi32_256_1);
-  imm2 = _mm256_and_si128(imm2, *(v8si*)_pi32_256_inv1);
+  imm2 = _mm256_and_si256(imm2, *(v8si*)_pi32_256_inv1);
   y = _mm256_cvtepi32_ps(imm2);
 
   /* get the swap sign flag */
-  imm0 = _mm256_and_si128(imm2, *(v8si*)_pi32_256_4);
+  imm0 = _mm256_and_si256(imm2, *(v8si*)_pi32_256_4);
   imm0 = _mm256_slli_epi32(imm0, 29);
   /* get the polynom selection mask 
      there is one polynom for 0 <= x <= Pi/4
@@ -366,7 +366,7 @@ static inline v8sf sin256_ps(v8sf x) { // any x
 
      Both branches will be computed.
   */
-  imm2 = _mm256_and_si128(imm2, *(v8si*)_pi32_256_2);
+  imm2 = _mm256_and_si256(imm2, *(v8si*)_pi32_256_2);
   imm2 = _mm256_cmpeq_epi32(imm2,*(v8si*)_pi32_256_0);
 #else
   /* we use SSE2 routines to perform the integer ops */
@@ -407,21 +407,16 @@ static inline v8sf sin256_ps(v8sf x) { // any x
   xmm1 = *(v8sf*)_ps256_minus_cephes_DP1;
   xmm2 = *(v8sf*)_ps256_minus_cephes_DP2;
   xmm3 = *(v8sf*)_ps256_minus_cephes_DP3;
-  xmm1 = _mm256_mul_ps(y, xmm1);
-  xmm2 = _mm256_mul_ps(y, xmm2);
-  xmm3 = _mm256_mul_ps(y, xmm3);
-  x = _mm256_add_ps(x, xmm1);
-  x = _mm256_add_ps(x, xmm2);
-  x = _mm256_add_ps(x, xmm3);
+  x = fmadd256_ps(y, xmm1, x);
+  x = fmadd256_ps(y, xmm2, x);
+  x = fmadd256_ps(y, xmm3, x);
 
   /* Evaluate the first polynom  (0 <= x <= Pi/4) */
   y = *(v8sf*)_ps256_coscof_p0;
   v8sf z = _mm256_mul_ps(x,x);
 
-  y = _mm256_mul_ps(y, z);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_coscof_p1);
-  y = _mm256_mul_ps(y, z);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_coscof_p2);
+  y = fmadd256_ps(y, z, *(v8sf*)_ps256_coscof_p1);
+  y = fmadd256_ps(y, z, *(v8sf*)_ps256_coscof_p2);
   y = _mm256_mul_ps(y, z);
   y = _mm256_mul_ps(y, z);
   v8sf tmp = _mm256_mul_ps(z, *(v8sf*)_ps256_0p5);
@@ -431,13 +426,10 @@ static inline v8sf sin256_ps(v8sf x) { // any x
   /* Evaluate the second polynom  (Pi/4 <= x <= 0) */
 
   v8sf y2 = *(v8sf*)_ps256_sincof_p0;
+  y2 = fmadd256_ps(y2, z, *(v8sf*)_ps256_sincof_p1);
+  y2 = fmadd256_ps(y2, z, *(v8sf*)_ps256_sincof_p2);
   y2 = _mm256_mul_ps(y2, z);
-  y2 = _mm256_add_ps(y2, *(v8sf*)_ps256_sincof_p1);
-  y2 = _mm256_mul_ps(y2, z);
-  y2 = _mm256_add_ps(y2, *(v8sf*)_ps256_sincof_p2);
-  y2 = _mm256_mul_ps(y2, z);
-  y2 = _mm256_mul_ps(y2, x);
-  y2 = _mm256_add_ps(y2, x);
+  y2 = fmadd256_ps(y2, x, x);
 
   /* select the correct result from the two polynoms */  
   xmm3 = poly_mask;
@@ -461,7 +453,7 @@ static inline v8sf cos256_ps(v8sf x) { // any x
 #endif
 
   /* take the absolute value */
-  x = _mm256_and_ps(x, *(v8sf*)_ps256_inv_sign_mask);
+  x = _mm256_and_ps(x, _ps256_inv_sign_mask());
   
   /* scale by 4/Pi */
   y = _mm256_mul_ps(x, *(v8sf*)_ps256_cephes_FOPI);
@@ -471,15 +463,15 @@ static inline v8sf cos256_ps(v8sf x) { // any x
   imm2 = _mm256_cvttps_epi32(y);
   /* j=(j+1) & (~1) (see the cephes sources) */
   imm2 = _mm256_add_epi32(imm2, *(v8si*)_pi32_256_1);
-  imm2 = _mm256_and_si128(imm2, *(v8si*)_pi32_256_inv1);
+  imm2 = _mm256_and_si256(imm2, *(v8si*)_pi32_256_inv1);
   y = _mm256_cvtepi32_ps(imm2);
   imm2 = _mm256_sub_epi32(imm2, *(v8si*)_pi32_256_2);
   
   /* get the swap sign flag */
-  imm0 = _mm256_andnot_si128(imm2, *(v8si*)_pi32_256_4);
+  imm0 = _mm256_andnot_si256(imm2, *(v8si*)_pi32_256_4);
   imm0 = _mm256_slli_epi32(imm0, 29);
   /* get the polynom selection mask */
-  imm2 = _mm256_and_si128(imm2, *(v8si*)_pi32_256_2);
+  imm2 = _mm256_and_si256(imm2, *(v8si*)_pi32_256_2);
   imm2 = _mm256_cmpeq_epi32(imm2, *(v8si*)_pi32_256_0);
 #else
 
@@ -523,21 +515,16 @@ static inline v8sf cos256_ps(v8sf x) { // any x
   xmm1 = *(v8sf*)_ps256_minus_cephes_DP1;
   xmm2 = *(v8sf*)_ps256_minus_cephes_DP2;
   xmm3 = *(v8sf*)_ps256_minus_cephes_DP3;
-  xmm1 = _mm256_mul_ps(y, xmm1);
-  xmm2 = _mm256_mul_ps(y, xmm2);
-  xmm3 = _mm256_mul_ps(y, xmm3);
-  x = _mm256_add_ps(x, xmm1);
-  x = _mm256_add_ps(x, xmm2);
-  x = _mm256_add_ps(x, xmm3);
+  x = fmadd256_ps(y, xmm1, x);
+  x = fmadd256_ps(y, xmm2, x);
+  x = fmadd256_ps(y, xmm3, x);
   
   /* Evaluate the first polynom  (0 <= x <= Pi/4) */
   y = *(v8sf*)_ps256_coscof_p0;
   v8sf z = _mm256_mul_ps(x,x);
 
-  y = _mm256_mul_ps(y, z);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_coscof_p1);
-  y = _mm256_mul_ps(y, z);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_coscof_p2);
+  y = fmadd256_ps(y, z, *(v8sf*)_ps256_coscof_p1);
+  y = fmadd256_ps(y, z, *(v8sf*)_ps256_coscof_p2);
   y = _mm256_mul_ps(y, z);
   y = _mm256_mul_ps(y, z);
   v8sf tmp = _mm256_mul_ps(z, *(v8sf*)_ps256_0p5);
@@ -547,13 +534,10 @@ static inline v8sf cos256_ps(v8sf x) { // any x
   /* Evaluate the second polynom  (Pi/4 <= x <= 0) */
 
   v8sf y2 = *(v8sf*)_ps256_sincof_p0;
+  y2 = fmadd256_ps(y2, z, *(v8sf*)_ps256_sincof_p1);
+  y2 = fmadd256_ps(y2, z, *(v8sf*)_ps256_sincof_p2);
   y2 = _mm256_mul_ps(y2, z);
-  y2 = _mm256_add_ps(y2, *(v8sf*)_ps256_sincof_p1);
-  y2 = _mm256_mul_ps(y2, z);
-  y2 = _mm256_add_ps(y2, *(v8sf*)_ps256_sincof_p2);
-  y2 = _mm256_mul_ps(y2, z);
-  y2 = _mm256_mul_ps(y2, x);
-  y2 = _mm256_add_ps(y2, x);
+  y2 = fmadd256_ps(y2, x, x);
 
   /* select the correct result from the two polynoms */  
   xmm3 = poly_mask;
@@ -581,9 +565,9 @@ static inline void sincos256_ps(v8sf x, v8sf *s, v8sf *c) {
 
   sign_bit_sin = x;
   /* take the absolute value */
-  x = _mm256_and_ps(x, *(v8sf*)_ps256_inv_sign_mask);
+  x = _mm256_and_ps(x, _ps256_inv_sign_mask());
   /* extract the sign bit (upper one) */
-  sign_bit_sin = _mm256_and_ps(sign_bit_sin, *(v8sf*)_ps256_sign_mask);
+  sign_bit_sin = _mm256_and_ps(sign_bit_sin, _ps256_sign_mask());
   
   /* scale by 4/Pi */
   y = _mm256_mul_ps(x, *(v8sf*)_ps256_cephes_FOPI);
@@ -594,18 +578,18 @@ static inline void sincos256_ps(v8sf x, v8sf *s, v8sf *c) {
 
   /* j=(j+1) & (~1) (see the cephes sources) */
   imm2 = _mm256_add_epi32(imm2, *(v8si*)_pi32_256_1);
-  imm2 = _mm256_and_si128(imm2, *(v8si*)_pi32_256_inv1);
+  imm2 = _mm256_and_si256(imm2, *(v8si*)_pi32_256_inv1);
 
   y = _mm256_cvtepi32_ps(imm2);
   imm4 = imm2;
 
   /* get the swap sign flag for the sine */
-  imm0 = _mm256_and_si128(imm2, *(v8si*)_pi32_256_4);
+  imm0 = _mm256_and_si256(imm2, *(v8si*)_pi32_256_4);
   imm0 = _mm256_slli_epi32(imm0, 29);
   //v8sf swap_sign_bit_sin = _mm256_castsi256_ps(imm0);
 
   /* get the polynom selection mask for the sine*/
-  imm2 = _mm256_and_si128(imm2, *(v8si*)_pi32_256_2);
+  imm2 = _mm256_and_si256(imm2, *(v8si*)_pi32_256_2);
   imm2 = _mm256_cmpeq_epi32(imm2, *(v8si*)_pi32_256_0);
   //v8sf poly_mask = _mm256_castsi256_ps(imm2);
 #else
@@ -648,16 +632,13 @@ static inline void sincos256_ps(v8sf x, v8sf *s, v8sf *c) {
   xmm1 = *(v8sf*)_ps256_minus_cephes_DP1;
   xmm2 = *(v8sf*)_ps256_minus_cephes_DP2;
   xmm3 = *(v8sf*)_ps256_minus_cephes_DP3;
-  xmm1 = _mm256_mul_ps(y, xmm1);
-  xmm2 = _mm256_mul_ps(y, xmm2);
-  xmm3 = _mm256_mul_ps(y, xmm3);
-  x = _mm256_add_ps(x, xmm1);
-  x = _mm256_add_ps(x, xmm2);
-  x = _mm256_add_ps(x, xmm3);
+  x = fmadd256_ps(y, xmm1, x);
+  x = fmadd256_ps(y, xmm2, x);
+  x = fmadd256_ps(y, xmm3, x);
 
 #ifdef __AVX2__
   imm4 = _mm256_sub_epi32(imm4, *(v8si*)_pi32_256_2);
-  imm4 = _mm256_andnot_si128(imm4, *(v8si*)_pi32_256_4);
+  imm4 = _mm256_andnot_si256(imm4, *(v8si*)_pi32_256_4);
   imm4 = _mm256_slli_epi32(imm4, 29);
 #else
   imm4_1 = _mm_sub_epi32(imm4_1, *(v4si*)_pi32avx_2);
@@ -680,10 +661,8 @@ static inline void sincos256_ps(v8sf x, v8sf *s, v8sf *c) {
   v8sf z = _mm256_mul_ps(x,x);
   y = *(v8sf*)_ps256_coscof_p0;
 
-  y = _mm256_mul_ps(y, z);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_coscof_p1);
-  y = _mm256_mul_ps(y, z);
-  y = _mm256_add_ps(y, *(v8sf*)_ps256_coscof_p2);
+  y = fmadd256_ps(y, z, *(v8sf*)_ps256_coscof_p1);
+  y = fmadd256_ps(y, z, *(v8sf*)_ps256_coscof_p2);
   y = _mm256_mul_ps(y, z);
   y = _mm256_mul_ps(y, z);
   v8sf tmp = _mm256_mul_ps(z, *(v8sf*)_ps256_0p5);
@@ -693,13 +672,10 @@ static inline void sincos256_ps(v8sf x, v8sf *s, v8sf *c) {
   /* Evaluate the second polynom  (Pi/4 <= x <= 0) */
 
   v8sf y2 = *(v8sf*)_ps256_sincof_p0;
+  y2 = fmadd256_ps(y2, z, *(v8sf*)_ps256_sincof_p1);
+  y2 = fmadd256_ps(y2, z, *(v8sf*)_ps256_sincof_p2);
   y2 = _mm256_mul_ps(y2, z);
-  y2 = _mm256_add_ps(y2, *(v8sf*)_ps256_sincof_p1);
-  y2 = _mm256_mul_ps(y2, z);
-  y2 = _mm256_add_ps(y2, *(v8sf*)_ps256_sincof_p2);
-  y2 = _mm256_mul_ps(y2, z);
-  y2 = _mm256_mul_ps(y2, x);
-  y2 = _mm256_add_ps(y2, x);
+  y2 = fmadd256_ps(y2, x, x);
 
   /* select the correct result from the two polynoms */  
   xmm3 = poly_mask;
@@ -724,6 +700,180 @@ static inline v8sf pow256_ps(v8sf y, v8sf x) {
   return ret;
 }
 
+_PS256_CONST(2, 2.0f);
+_PS256_CONST(tanh_threshold, 0.625f);
+_PS256_CONST(cephes_tanh_p0, -5.70498872745E-3);
+_PS256_CONST(cephes_tanh_p1, 2.06390887954E-2);
+_PS256_CONST(cephes_tanh_p2, -5.37397155531E-2);
+_PS256_CONST(cephes_tanh_p3, 1.33314422036E-1);
+_PS256_CONST(cephes_tanh_p4, -3.33332819422E-1);
+
+/// @brief Calculates tanh(x), the rewriting of the cephes tanhf function:
+/// the odd polynom for |x| < 0.625 and 1 - 2 / (exp(2|x|) + 1) otherwise.
+static inline v8sf tanh256_ps(v8sf x) {
+  v8sf sign_mask = _ps256_sign_mask();
+  v8sf sign_bit = _mm256_and_ps(x, sign_mask);
+  v8sf ax = _mm256_andnot_ps(sign_mask, x);
+
+  v8sf z = _mm256_mul_ps(x, x);
+  v8sf y = *(v8sf*)_ps256_cephes_tanh_p0;
+  y = fmadd256_ps(y, z, *(v8sf*)_ps256_cephes_tanh_p1);
+  y = fmadd256_ps(y, z, *(v8sf*)_ps256_cephes_tanh_p2);
+  y = fmadd256_ps(y, z, *(v8sf*)_ps256_cephes_tanh_p3);
+  y = fmadd256_ps(y, z, *(v8sf*)_ps256_cephes_tanh_p4);
+  y = _mm256_mul_ps(y, z);
+  y = fmadd256_ps(y, x, x);
+
+  /* exp256_ps() saturates, so the large arguments give exactly 1 */
+  v8sf e = exp256_ps(_mm256_add_ps(ax, ax));
+  v8sf t = _mm256_sub_ps(*(v8sf*)_ps256_1, _mm256_div_ps(
+      *(v8sf*)_ps256_2, _mm256_add_ps(e, *(v8sf*)_ps256_1)));
+  t = _mm256_or_ps(t, sign_bit);
+
+  v8sf small = _mm256_cmp_ps(ax, *(v8sf*)_ps256_tanh_threshold, _CMP_LT_OS);
+  return _mm256_blendv_ps(t, y, small);
+}
+
+/// @brief Calculates the logistic function 1 / (1 + exp(-x)).
+static inline v8sf sigmoid256_ps(v8sf x) {
+  v8sf e = exp256_ps(_mm256_xor_ps(
+      x, _ps256_sign_mask()));
+  return _mm256_div_ps(*(v8sf*)_ps256_1, _mm256_add_ps(e, *(v8sf*)_ps256_1));
+}
+
+/* The fast accuracy tier: shorter minimax polynoms, about 1e-4 relative
+   error, no handling of the special values (NaN, infinities, x <= 0 for
+   the logarithm) */
+
+_PS256_CONST(fast_exp_hi, 88.3f);
+_PS256_CONST(fast_exp_lo, -87.3f);
+_PS256_CONST(fast_exp2_p0, 9.999280735e-01f);
+_PS256_CONST(fast_exp2_p1, 6.932609855e-01f);
+_PS256_CONST(fast_exp2_p2, 2.426111222e-01f);
+_PS256_CONST(fast_exp2_p3, 5.517166907e-02f);
+
+/// @brief Calculates exp(x) = 2^n * 2^f, |f| <= 0.5, 2^f is the cubic
+/// minimax polynom.
+static inline v8sf exp256_fast_ps(v8sf x) {
+  x = _mm256_min_ps(x, *(v8sf*)_ps256_fast_exp_hi);
+  x = _mm256_max_ps(x, *(v8sf*)_ps256_fast_exp_lo);
+  v8sf t = _mm256_mul_ps(x, *(v8sf*)_ps256_cephes_LOG2EF);
+  v8si n = _mm256_cvtps_epi32(t);
+  v8sf f = _mm256_sub_ps(t, _mm256_cvtepi32_ps(n));
+  v8sf y = *(v8sf*)_ps256_fast_exp2_p3;
+  y = fmadd256_ps(y, f, *(v8sf*)_ps256_fast_exp2_p2);
+  y = fmadd256_ps(y, f, *(v8sf*)_ps256_fast_exp2_p1);
+  y = fmadd256_ps(y, f, *(v8sf*)_ps256_fast_exp2_p0);
+  /* add n to the exponent bits */
+  v8si bits = _mm256_add_epi32(_mm256_castps_si256(y),
+                               _mm256_slli_epi32(n, 23));
+  return _mm256_castsi256_ps(bits);
+}
+
+_PS256_CONST(fast_SQRT2, 1.41421356237f);
+_PS256_CONST(fast_LN2, 0.693147180560f);
+_PS256_CONST(fast_log_p0, 9.999661814e-01f);
+_PS256_CONST(fast_log_p1, -4.994506475e-01f);
+_PS256_CONST(fast_log_p2, 3.363888424e-01f);
+_PS256_CONST(fast_log_p3, -2.709459943e-01f);
+_PS256_CONST(fast_log_p4, 1.765805420e-01f);
+
+/// @brief Calculates log(x) = e * ln(2) + log(1 + u),
+/// u in [sqrt(1/2) - 1, sqrt(2) - 1], log(1 + u) / u is the quartic
+/// minimax polynom. x must be a normal positive number.
+static inline v8sf log256_fast_ps(v8sf x) {
+  v8si bits = _mm256_castps_si256(x);
+  v8sf e = _mm256_cvtepi32_ps(_mm256_sub_epi32(
+      _mm256_srli_epi32(bits, 23), *(v8si*)_pi32_256_0x7f));
+  /* the mantissa in [1, 2) */
+  v8sf m = _mm256_or_ps(
+      _mm256_and_ps(x, _ps256_inv_mant_mask()),
+      *(v8sf*)_ps256_1);
+  /* if (sqrt(2) < m) { m /= 2; e += 1; } */
+  v8sf big = _mm256_cmp_ps(*(v8sf*)_ps256_fast_SQRT2, m, _CMP_LT_OS);
+  m = _mm256_blendv_ps(m, _mm256_mul_ps(m, *(v8sf*)_ps256_0p5), big);
+  e = _mm256_add_ps(e, _mm256_and_ps(big, *(v8sf*)_ps256_1));
+  v8sf u = _mm256_sub_ps(m, *(v8sf*)_ps256_1);
+  v8sf y = *(v8sf*)_ps256_fast_log_p4;
+  y = fmadd256_ps(y, u, *(v8sf*)_ps256_fast_log_p3);
+  y = fmadd256_ps(y, u, *(v8sf*)_ps256_fast_log_p2);
+  y = fmadd256_ps(y, u, *(v8sf*)_ps256_fast_log_p1);
+  y = fmadd256_ps(y, u, *(v8sf*)_ps256_fast_log_p0);
+  return fmadd256_ps(e, *(v8sf*)_ps256_fast_LN2, _mm256_mul_ps(y, u));
+}
+
+_PS256_CONST(fast_1_PI, 0.318309886184f);
+_PS256_CONST(minus_fast_PI_A, -3.140625f);
+_PS256_CONST(minus_fast_PI_B, -9.67653589793e-4f);
+_PS256_CONST(fast_sin_p0, 9.999990609e-01f);
+_PS256_CONST(fast_sin_p1, -1.666555409e-01f);
+_PS256_CONST(fast_sin_p2, 8.311899801e-03f);
+_PS256_CONST(fast_sin_p3, -1.848814029e-04f);
+
+/* sin(x - shift * Pi) * (-1)^flip: x = (k + shift) * Pi + r, |r| <= Pi / 2,
+   sin(r) / r is the cubic minimax polynom of r^2 */
+static inline v8sf sin256_fast_shifted(v8sf x, v8sf shift, v8si flip) {
+  v8si k = _mm256_cvtps_epi32(_mm256_sub_ps(
+      _mm256_mul_ps(x, *(v8sf*)_ps256_fast_1_PI), shift));
+  v8sf kf = _mm256_add_ps(_mm256_cvtepi32_ps(k), shift);
+  v8sf r = fmadd256_ps(kf, *(v8sf*)_ps256_minus_fast_PI_A, x);
+  r = fmadd256_ps(kf, *(v8sf*)_ps256_minus_fast_PI_B, r);
+  v8sf z = _mm256_mul_ps(r, r);
+  v8sf y = *(v8sf*)_ps256_fast_sin_p3;
+  y = fmadd256_ps(y, z, *(v8sf*)_ps256_fast_sin_p2);
+  y = fmadd256_ps(y, z, *(v8sf*)_ps256_fast_sin_p1);
+  y = fmadd256_ps(y, z, *(v8sf*)_ps256_fast_sin_p0);
+  y = _mm256_mul_ps(y, r);
+  /* sin(k * Pi + r) = (-1)^k * sin(r) */
+  v8si sign = _mm256_slli_epi32(_mm256_add_epi32(k, flip), 31);
+  return _mm256_xor_ps(y, _mm256_castsi256_ps(sign));
+}
+
+/// @brief Calculates sin(x), the absolute error grows with |x|.
+static inline v8sf sin256_fast_ps(v8sf x) {
+  return sin256_fast_shifted(x, _mm256_setzero_ps(), *(v8si*)_pi32_256_0);
+}
+
+/// @brief Calculates cos(x) = -sin(x - Pi / 2).
+static inline v8sf cos256_fast_ps(v8sf x) {
+  return sin256_fast_shifted(x, *(v8sf*)_ps256_0p5, *(v8si*)_pi32_256_1);
+}
+
+_PS256_CONST(fast_tanh_threshold, 0.3f);
+_PS256_CONST(fast_tanh_p1, -3.333333333e-01f);
+_PS256_CONST(fast_tanh_p2, 1.333333333e-01f);
+
+/// @brief Calculates tanh(x): the Taylor polynom for |x| < 0.3 and
+/// 1 - 2 / (exp(2|x|) + 1) otherwise.
+static inline v8sf tanh256_fast_ps(v8sf x) {
+  v8sf sign_mask = _ps256_sign_mask();
+  v8sf sign_bit = _mm256_and_ps(x, sign_mask);
+  v8sf ax = _mm256_andnot_ps(sign_mask, x);
+  v8sf z = _mm256_mul_ps(x, x);
+  v8sf y = fmadd256_ps(*(v8sf*)_ps256_fast_tanh_p2, z,
+                       *(v8sf*)_ps256_fast_tanh_p1);
+  y = fmadd256_ps(_mm256_mul_ps(y, z), x, x);
+  v8sf e = exp256_fast_ps(_mm256_add_ps(ax, ax));
+  v8sf t = _mm256_sub_ps(*(v8sf*)_ps256_1, _mm256_div_ps(
+      *(v8sf*)_ps256_2, _mm256_add_ps(e, *(v8sf*)_ps256_1)));
+  t = _mm256_or_ps(t, sign_bit);
+  v8sf small = _mm256_cmp_ps(ax, *(v8sf*)_ps256_fast_tanh_threshold,
+                             _CMP_LT_OS);
+  return _mm256_blendv_ps(t, y, small);
+}
+
+/// @brief Calculates the logistic function 1 / (1 + exp(-x)).
+static inline v8sf sigmoid256_fast_ps(v8sf x) {
+  v8sf e = exp256_fast_ps(_mm256_xor_ps(
+      x, _ps256_sign_mask()));
+  return _mm256_div_ps(*(v8sf*)_ps256_1, _mm256_add_ps(e, *(v8sf*)_ps256_1));
+}
+
+/// @brief Calculates y^x, y must be a normal positive number.
+static inline v8sf pow256_fast_ps(v8sf y, v8sf x) {
+  return exp256_fast_ps(_mm256_mul_ps(log256_fast_ps(y), x));
+}
+
 #pragma GCC diagnostic pop
 
 #endif // INC_SIMD_AVX_MATHFUN_H_
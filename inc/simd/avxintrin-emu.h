@@ -83,7 +83,8 @@
 
 #endif
 
-#pragma message ("Warning: AVX intrinsics are emulated with SSE")
+/* The SSE4 kernel tier is built on this emulation on purpose (see
+ * instruction_set.h), so it does not announce itself with #pragma message. */
 
 /*
  * Intel(R) AVX compiler intrinsics.
@@ -172,7 +173,7 @@ static __emu_inline type_128 __emu_mm256_##func( __emu##type m256_param1 ) \
 {   type_128 res, tmp; \
     res = _mm_##func( m256_param1.__emu_m128[0] ); \
     tmp = _mm_##func( m256_param1.__emu_m128[1] ); \
-    *(((__emu_int64_t*)&res)+1) = *(__emu_int64_t*)&tmp; \
+    __builtin_memcpy( ((__emu_int64_t*)&res)+1, &tmp, sizeof(__emu_int64_t) ); \
     return ( res ); \
 }
 
@@ -0,0 +1,101 @@
+/*! @file biquad.h
+ *  @brief Cascades of IIR biquad sections.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef INC_SIMD_BIQUAD_H_
+#define INC_SIMD_BIQUAD_H_
+
+#include <stddef.h>
+#include <simd/common.h>
+#include <simd/attributes.h>
+
+SIMD_API_BEGIN
+
+/// @brief The coefficients of a second order section
+/// H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2).
+typedef struct {
+  float b0;
+  float b1;
+  float b2;
+  float a1;
+  float a2;
+} BiquadCoefficients;
+
+/// @brief The state of the cascade of biquad sections applied to each
+/// channel of the signal, see biquad_cascade_initialize().
+/// @details The fields are private, use the functions below.
+typedef struct {
+  int sections;
+  int channels;
+  BiquadCoefficients *coefficients;
+  /// The delays of the transposed direct form II, z1 and z2 of every
+  /// section and channel: state[(section * 2 + k) * channels + channel].
+  float *state;
+} BiquadCascade;
+
+/// @brief Prepares for the filtering with the cascade of biquad sections.
+/// @param coefficients The sections, the output of each one is the input
+/// of the next. They are copied.
+/// @param sections The number of the sections.
+/// @param channels The number of the channels, each one is filtered
+/// independently with the same sections.
+/// @return The state for biquad_cascade_process(), it must be freed with
+/// biquad_cascade_finalize().
+BiquadCascade biquad_cascade_initialize(
+    const BiquadCoefficients *coefficients, int sections, int channels)
+    NOTNULL(1);
+
+/// @brief Filters the next block of the signal.
+/// @param simd Value indicating whether to use SIMD acceleration or not.
+/// @param cascade The state obtained from biquad_cascade_initialize().
+/// @param x The interleaved block of the signal, frames * channels float-s.
+/// @param frames The number of the frames in the block.
+/// @param result The filtered block of the same layout. It may be the same
+/// array as x.
+/// @details The delays are kept in cascade, so the blocks join seamlessly.
+/// The channels are vectorized as a whole vector of them at a time, the
+/// remaining ones run the sections in the vector lanes, each lane one
+/// sample behind the previous, so that one channel is vectorized too.
+void biquad_cascade_process(int simd, BiquadCascade *cascade,
+                            const float *x, size_t frames, float *result)
+    NOTNULL(2, 3, 5);
+
+/// @brief Zeroes the delays, so that the next block is treated as the
+/// beginning of the signal.
+/// @param cascade The state obtained from biquad_cascade_initialize().
+void biquad_cascade_reset(BiquadCascade *cascade) NOTNULL(1);
+
+/// @brief Frees any resources allocated by biquad_cascade_initialize().
+/// @param cascade The state obtained from biquad_cascade_initialize().
+void biquad_cascade_finalize(BiquadCascade *cascade) NOTNULL(1);
+
+SIMD_API_END
+
+#endif  // INC_SIMD_BIQUAD_H_
@@ -35,9 +35,16 @@
 #include <simd/common.h>
 #include <simd/attributes.h>
 #include <simd/convolve_structs.h>
+#include <simd/thread_pool.h>
 
 SIMD_API_BEGIN
 
+/// @brief The alignment of the workspace passed to
+/// convolve_fft_initialize_in_place() and
+/// convolve_overlap_save_initialize_in_place(), the same as
+/// malloc_aligned() provides.
+#define CONVOLUTION_WORKSPACE_ALIGNMENT 64
+
 typedef struct ConvolutionFFTHandle ConvolutionFFTHandle;
 
 /// @brief Prepares for the calculation of linear convolution of two signals
@@ -47,6 +54,45 @@ typedef struct ConvolutionFFTHandle ConvolutionFFTHandle;
 /// @return The handle for convolve_fft().
 ConvolutionFFTHandle convolve_fft_initialize(size_t xLength, size_t hLength);
 
+/// @brief Turns on or off the FFT lengths of the form 2^a 3^b 5^c in
+/// convolve_fft_initialize().
+/// @param enabled If nonzero (the default), the cheapest of such lengths
+/// which fits the result is taken, so that the tail just above a power of 2
+/// does not double the work. Otherwise, the nearest power of 2 is taken,
+/// which the FFTF backends supporting only such lengths require.
+/// @note The handles and the workspace sizes obtained before the call
+/// keep the old lengths.
+void convolve_set_smooth_fft_lengths(int enabled);
+
+/// @brief Returns nonzero if the smooth FFT lengths are on,
+/// see convolve_set_smooth_fft_lengths().
+int convolve_smooth_fft_lengths(void);
+
+/// @brief Returns the FFT length which the library takes for the transform
+/// of at least the specified number of samples: the cheapest 2^a 3^b 5^c
+/// one or the nearest power of 2, see convolve_set_smooth_fft_lengths().
+int convolve_fft_good_length(int length);
+
+/// @brief Returns the size of the workspace which
+/// convolve_fft_initialize_in_place() needs.
+/// @param xLength The length of the first array in float-s.
+/// @param hLength The length of the second array in float-s.
+/// @return The size in bytes.
+size_t convolve_fft_workspace_size(size_t xLength, size_t hLength);
+
+/// @brief Acts like convolve_fft_initialize(), but all the buffers of
+/// the handle are placed in the specified memory block.
+/// @param xLength The length of the first array in float-s.
+/// @param hLength The length of the second array in float-s.
+/// @param workspace The memory block of convolve_fft_workspace_size() bytes,
+/// aligned to CONVOLUTION_WORKSPACE_ALIGNMENT. It must outlive the handle
+/// and is not freed by convolve_fft_finalize().
+/// @return The handle for convolve_fft().
+/// @note Memory is allocated only if the plan cache has no idle plans of
+/// the needed length, see convolve_plan_cache_prepare().
+ConvolutionFFTHandle convolve_fft_initialize_in_place(
+    size_t xLength, size_t hLength, void *workspace) NOTNULL(3);
+
 /// @brief Calculates the linear convolution of two signals using
 /// the FFT method.
 /// @param handle The structure obtained from convolve_fft_initialize().
@@ -72,6 +118,27 @@ typedef struct ConvolutionOverlapSaveHandle ConvolutionOverlapSaveHandle;
 ConvolutionOverlapSaveHandle convolve_overlap_save_initialize(
     size_t xLength, size_t hLength);
 
+/// @brief Returns the size of the workspace which
+/// convolve_overlap_save_initialize_in_place() needs.
+/// @param xLength The length of the first array in float-s.
+/// @param hLength The length of the second array in float-s.
+/// @return The size in bytes.
+size_t convolve_overlap_save_workspace_size(size_t xLength, size_t hLength);
+
+/// @brief Acts like convolve_overlap_save_initialize(), but all the buffers
+/// of the handle are placed in the specified memory block.
+/// @param xLength The length of the first array in float-s.
+/// @param hLength The length of the second array in float-s.
+/// @param workspace The memory block of
+/// convolve_overlap_save_workspace_size() bytes, aligned to
+/// CONVOLUTION_WORKSPACE_ALIGNMENT. It must outlive the handle and is not
+/// freed by convolve_overlap_save_finalize().
+/// @return The handle for convolve_overlap_save().
+/// @note Memory is allocated only if the plan cache has no idle plans of
+/// the needed length, see convolve_plan_cache_prepare().
+ConvolutionOverlapSaveHandle convolve_overlap_save_initialize_in_place(
+    size_t xLength, size_t hLength, void *workspace) NOTNULL(3);
+
 /// @brief Calculates the linear convolution of two signals using
 /// the overlap-save method.
 /// @param handle The structure obtained from convolve_overlap_save_initialize().
@@ -88,6 +155,166 @@ void convolve_overlap_save(ConvolutionOverlapSaveHandle handle,
 /// @param handle The structure obtained from convolve_overlap_save_initialize().
 void convolve_overlap_save_finalize(ConvolutionOverlapSaveHandle handle);
 
+typedef struct ConvolutionStreamHandle ConvolutionStreamHandle;
+
+/// @brief Prepares for the calculation of linear convolution of a signal
+/// which arrives block by block with the fixed filter, using the
+/// overlap-save method.
+/// @param h The filter, it is copied and transformed only once.
+/// @param hLength The length of the filter in float-s.
+/// @param blockLength The maximal length of the block passed to
+/// convolve_stream_process().
+/// @return The handle for convolve_stream_process().
+ConvolutionStreamHandle convolve_stream_initialize(
+    const float *h, size_t hLength, size_t blockLength) NOTNULL(1);
+
+/// @brief Convolves the next block of the signal with the filter.
+/// @param handle The structure obtained from convolve_stream_initialize().
+/// @param x The next block of the signal.
+/// @param length The length of the block, it must not be greater than
+/// the value passed to convolve_stream_initialize().
+/// @param result The convolution samples which correspond to x, of length
+/// length. It may be the same array as x.
+/// @details The last hLength - 1 samples of the signal are kept in handle,
+/// so the concatenated results of the consecutive calls are equal to the
+/// first samples of the convolution of the concatenated blocks.
+/// Pass zeros to get the tail of the convolution.
+void convolve_stream_process(ConvolutionStreamHandle handle,
+                             const float *x, size_t length,
+                             float *result) NOTNULL(2, 4);
+
+/// @brief Forgets the previous blocks, so that the next one is treated
+/// as the beginning of the signal.
+/// @param handle The structure obtained from convolve_stream_initialize().
+void convolve_stream_reset(ConvolutionStreamHandle handle);
+
+/// @brief Frees any resources allocated by convolve_stream_initialize().
+/// @param handle The structure obtained from convolve_stream_initialize().
+void convolve_stream_finalize(ConvolutionStreamHandle handle);
+
+typedef struct ConvolutionPartitionedHandle ConvolutionPartitionedHandle;
+
+/// @brief Prepares for the calculation of linear convolution of a signal
+/// which arrives block by block with the long fixed filter, using
+/// the uniformly partitioned overlap-save method.
+/// @param h The filter. It is split into the parts of blockLength samples,
+/// which are transformed only once.
+/// @param hLength The length of the filter in float-s. It may be much
+/// greater than blockLength.
+/// @param blockLength The length of the block passed to
+/// convolve_partitioned_process(). It is the latency of the method.
+/// @return The handle for convolve_partitioned_process().
+/// @details Every block costs two FFTs of
+/// convolve_fft_good_length(2 * blockLength), so that any blockLength works,
+/// and hLength / blockLength complex multiplications of the spectra kept in
+/// the frequency domain delay line, so the memory is O(hLength) regardless
+/// of the signal length.
+ConvolutionPartitionedHandle convolve_partitioned_initialize(
+    const float *h, size_t hLength, size_t blockLength) NOTNULL(1);
+
+/// @brief Convolves the next block of the signal with the filter.
+/// @param handle The structure obtained from
+/// convolve_partitioned_initialize().
+/// @param x The next block of the signal, of length blockLength.
+/// @param result The convolution samples which correspond to x, of length
+/// blockLength. It may be the same array as x.
+/// @details The concatenated results of the consecutive calls are equal to
+/// the first samples of the convolution of the concatenated blocks.
+/// Pass zeros to get the tail of the convolution.
+void convolve_partitioned_process(ConvolutionPartitionedHandle handle,
+                                  const float *x, float *result)
+    NOTNULL(2, 3);
+
+/// @brief Forgets the previous blocks, so that the next one is treated
+/// as the beginning of the signal.
+/// @param handle The structure obtained from
+/// convolve_partitioned_initialize().
+void convolve_partitioned_reset(ConvolutionPartitionedHandle handle);
+
+/// @brief Frees any resources allocated by convolve_partitioned_initialize().
+/// @param handle The structure obtained from
+/// convolve_partitioned_initialize().
+void convolve_partitioned_finalize(ConvolutionPartitionedHandle handle);
+
+typedef struct ConvolutionBatchHandle ConvolutionBatchHandle;
+
+/// @brief Prepares for the calculation of linear convolution of several
+/// signals (channels) of the same length with the same filter, using
+/// the FFT method.
+/// @param xLength The length of every channel in float-s.
+/// @param h The filter, its spectrum is calculated only once.
+/// @param hLength The length of the filter in float-s.
+/// @param channels The number of channels.
+/// @return The handle for convolve_batch() and convolve_batch_strided().
+/// @details All the channels are transformed by the single batched FFT plan.
+ConvolutionBatchHandle convolve_batch_initialize(
+    size_t xLength, const float *h, size_t hLength, int channels) NOTNULL(2);
+
+/// @brief Convolves every channel with the filter.
+/// @param handle The structure obtained from convolve_batch_initialize().
+/// @param x The array of the channels, each of length xLength.
+/// @param result The array of the resulting signals, each of length
+/// xLength + hLength - 1. They may be the same arrays as the channels
+/// if they are long enough.
+void convolve_batch(ConvolutionBatchHandle handle,
+                    const float *const *x, float *const *result)
+    NOTNULL(2, 3);
+
+/// @brief Convolves every channel with the filter, the channels being
+/// stored one after another.
+/// @param handle The structure obtained from convolve_batch_initialize().
+/// @param x The first channel.
+/// @param xStride The distance between the beginnings of the channels
+/// in float-s, not less than xLength.
+/// @param result The first resulting signal.
+/// @param resultStride The distance between the beginnings of the resulting
+/// signals in float-s, not less than xLength + hLength - 1.
+void convolve_batch_strided(ConvolutionBatchHandle handle,
+                            const float *x, size_t xStride,
+                            float *result, size_t resultStride)
+    NOTNULL(2, 4);
+
+/// @brief Frees any resources allocated by convolve_batch_initialize().
+/// @param handle The structure obtained from convolve_batch_initialize().
+void convolve_batch_finalize(ConvolutionBatchHandle handle);
+
+typedef struct ConvolutionOverlapSaveParallelHandle
+    ConvolutionOverlapSaveParallelHandle;
+
+/// @brief Prepares for the calculation of linear convolution of two signals
+/// using the overlap-save method, the blocks being processed on several
+/// threads.
+/// @param xLength The length of the first array in float-s.
+/// @param hLength The length of the second array in float-s.
+/// @param pool The thread pool to run on. If it is NULL, the default one is
+/// taken, see thread_pool_default().
+/// @param threads The maximal number of threads to use, including the
+/// calling one. If it is 0, all the threads of the pool are used.
+/// @return The handle for convolve_overlap_save_parallel().
+/// @details Every thread gets its own buffer and FFT plans.
+ConvolutionOverlapSaveParallelHandle
+convolve_overlap_save_parallel_initialize(size_t xLength, size_t hLength,
+                                          ThreadPool *pool, int threads);
+
+/// @brief Calculates the linear convolution of two signals using
+/// the overlap-save method on several threads.
+/// @param handle The structure obtained from
+/// convolve_overlap_save_parallel_initialize().
+/// @param x The first signal (long one).
+/// @param h The second signal (short one).
+/// @param result The resulting signal of length xLength + hLength - 1.
+/// @note result and x may NOT be the same arrays.
+void convolve_overlap_save_parallel(ConvolutionOverlapSaveParallelHandle handle,
+                                    const float *x, const float *h,
+                                    float *result) NOTNULL(2, 3, 4);
+
+/// @brief Frees any resources allocated by
+/// convolve_overlap_save_parallel_initialize().
+/// @param handle The structure obtained from
+/// convolve_overlap_save_parallel_initialize().
+void convolve_overlap_save_parallel_finalize(
+    ConvolutionOverlapSaveParallelHandle handle);
+
 /// @brief Calculates the linear convolution of two signals using
 /// the "brute force" method.
 /// @param simd Value indicating whether to use SIMD acceleration or not.
@@ -101,13 +328,74 @@ void convolve_simd(int simd,
                    const float *__restrict h, size_t hLength,
                    float *__restrict result) NOTNULL(2, 4, 6);
 
+/// @brief Calculates the linear convolution of two double precision signals
+/// using the "brute force" method.
+/// @param simd Value indicating whether to use SIMD acceleration or not.
+/// @param x The first signal (long one).
+/// @param xLength The length of the first array in double-s.
+/// @param h The second signal (short one).
+/// @param hLength The length of the second array in double-s.
+/// @param result The resulting signal of length xLength + hLength - 1.
+void convolve_simd_double(int simd,
+                          const double *__restrict x, size_t xLength,
+                          const double *__restrict h, size_t hLength,
+                          double *__restrict result) NOTNULL(2, 4, 6);
+
 typedef struct ConvolutionHandle ConvolutionHandle;
 
+/// @brief Turns on or off the autotuning of convolve_initialize() and
+/// cross_correlate_initialize().
+/// @param enabled If nonzero, the algorithm for every new pair of lengths
+/// is chosen by measuring all of them and the decision is remembered in
+/// the process-wide table. Otherwise, the fixed thresholds are used.
+/// @note The decisions which are already in the table (including the ones
+/// loaded with convolve_autotuning_load()) are used only when autotuning
+/// is on.
+void convolve_set_autotuning(int enabled);
+
+/// @brief Returns nonzero if the autotuning is on,
+/// see convolve_set_autotuning().
+int convolve_autotuning(void);
+
+/// @brief Returns the algorithm convolve_initialize() would choose.
+/// @param xLength The length of the first array in float-s.
+/// @param hLength The length of the second array in float-s.
+/// @details If the autotuning is on and the lengths are not in the table
+/// yet, the algorithms are benchmarked, which takes a few milliseconds.
+ConvolutionAlgorithm convolve_select_algorithm(size_t xLength,
+                                               size_t hLength);
+
+/// @brief Writes the autotuning table to the text file.
+/// @param path The path to the file, it is overwritten.
+/// @return 0 on success, -1 on failure (errno is set).
+int convolve_autotuning_save(const char *path) NOTNULL(1);
+
+/// @brief Merges the autotuning table written by convolve_autotuning_save()
+/// into the current one.
+/// @param path The path to the file.
+/// @return The number of loaded decisions or -1 if the file could not be
+/// read.
+int convolve_autotuning_load(const char *path) NOTNULL(1);
+
+/// @brief Forgets all the autotuning decisions.
+void convolve_autotuning_clear(void);
+
+/// @brief Prepares for the calculation of linear convolution of two signals
+/// using the specified method.
+/// @param xLength The length of the first array in float-s.
+/// @param hLength The length of the second array in float-s.
+/// @param algorithm The method to use. Overlap-save requires
+/// hLength < xLength / 2.
+/// @return The handle for convolve().
+ConvolutionHandle convolve_initialize_algorithm(
+    size_t xLength, size_t hLength, ConvolutionAlgorithm algorithm);
+
 /// @brief Prepares for the calculation of linear convolution of two signals
 /// using the best method.
 /// @param xLength The length of the first array in float-s.
 /// @param hLength The length of the second array in float-s.
 /// @return The handle for convolve().
+/// @details The method is chosen by convolve_select_algorithm().
 ConvolutionHandle convolve_initialize(size_t xLength, size_t hLength);
 
 /// @brief Calculates the linear convolution of two signals using
@@ -120,8 +408,95 @@ void convolve(ConvolutionHandle handle,
               const float *__restrict x, const float *__restrict h,
               float *__restrict result) NOTNULL(2, 3, 4);
 
+/// @brief Prepares for the calculation of linear convolution of signals
+/// with the fixed filter using the best method.
+/// @param xLength The length of the first array in float-s.
+/// @param h The filter (shorter signal). Its spectrum is calculated here
+/// once instead of during every call.
+/// @param hLength The length of the filter in float-s.
+/// @return The handle for convolve_with_kernel(), it must be freed with
+/// convolve_finalize().
+ConvolutionHandle convolve_initialize_with_kernel(
+    size_t xLength, const float *h, size_t hLength) NOTNULL(2);
+
+/// @brief Calculates the linear convolution of the signal with the filter
+/// passed to convolve_initialize_with_kernel().
+/// @param handle The structure obtained from
+/// convolve_initialize_with_kernel().
+/// @param x The signal (longer).
+/// @param result The resulting signal of length xLength + hLength - 1.
+void convolve_with_kernel(ConvolutionHandle handle,
+                          const float *__restrict x,
+                          float *__restrict result) NOTNULL(2, 3);
+
+/// @brief Acts like convolve_initialize_with_kernel(), but uses
+/// the specified method.
+/// @param xLength The length of the first array in float-s.
+/// @param h The filter (shorter signal).
+/// @param hLength The length of the filter in float-s.
+/// @param algorithm The method to use. Overlap-save requires
+/// hLength < xLength / 2.
+/// @return The handle for convolve_with_kernel(), it must be freed with
+/// convolve_finalize().
+ConvolutionHandle convolve_initialize_algorithm_with_kernel(
+    size_t xLength, const float *h, size_t hLength,
+    ConvolutionAlgorithm algorithm) NOTNULL(2);
+
+/// @brief Creates the FFT plans which the specified number of the handles
+/// of the specified shape need and puts them into the plan cache.
+/// @param xLength The length of the first array in float-s.
+/// @param hLength The length of the second array in float-s.
+/// @param algorithm The method of the handles, brute force needs no plans.
+/// @param count The number of the handles which are going to exist at
+/// the same time.
+/// @details The forward and the backward plans of the convolution handles
+/// are taken from the process wide cache on initialization and returned to
+/// it on finalization, so the planning happens only once per length.
+/// The plans are bound to their buffers, so every live handle has its own.
+/// The cache keeps up to 64 idle plans, this function is thread safe.
+void convolve_plan_cache_prepare(size_t xLength, size_t hLength,
+                                 ConvolutionAlgorithm algorithm, int count);
+
+/// @brief Destroys all the idle plans in the cache.
+void convolve_plan_cache_clear(void);
+
+/// @brief Returns the number of the idle plans in the cache.
+int convolve_plan_cache_size(void);
+
+typedef struct ConvolutionScratch ConvolutionScratch;
+
+/// @brief Allocates the buffers and the FFT plans which one thread needs to
+/// call convolve_with_kernel_scratch() with the specified handle.
+/// @param handle The structure obtained from
+/// convolve_initialize_with_kernel() or
+/// cross_correlate_initialize_with_kernel(). It must outlive the scratch.
+/// @return The scratch for convolve_with_kernel_scratch().
+/// @details The FFT plans are bound to their buffers, so every scratch has
+/// its own plans, while the spectrum of the filter stays in the handle.
+ConvolutionScratch convolve_scratch_initialize(ConvolutionHandle handle);
+
+/// @brief Calculates the linear convolution of the signal with the filter
+/// passed to convolve_initialize_with_kernel(), using the buffers of
+/// the scratch.
+/// @param handle The structure obtained from
+/// convolve_initialize_with_kernel(). It is not modified, so several threads
+/// may use it at the same time, each with its own scratch.
+/// @param scratch The structure obtained from convolve_scratch_initialize()
+/// which is not used by any other thread at the moment.
+/// @param x The signal (longer).
+/// @param result The resulting signal of length xLength + hLength - 1.
+void convolve_with_kernel_scratch(ConvolutionHandle handle,
+                                  ConvolutionScratch scratch,
+                                  const float *__restrict x,
+                                  float *__restrict result) NOTNULL(3, 4);
+
+/// @brief Frees any resources allocated by convolve_scratch_initialize().
+/// @param scratch The structure obtained from convolve_scratch_initialize().
+void convolve_scratch_finalize(ConvolutionScratch scratch);
+
 /// @brief Frees any resources allocated by convolve_overlap_initialize().
-/// @param handle The structure obtained from convolve_overlap_initialize().
+/// @param handle The structure obtained from convolve_overlap_initialize()
+/// or convolve_initialize_with_kernel().
 void convolve_finalize(ConvolutionHandle handle);
 
 SIMD_API_END
@@ -0,0 +1,234 @@
+/*! @file convolve2d.h
+ *  @brief Defines functions to calculate 2D convolution and
+ *  cross-correlation of images.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef INC_SIMD_CONVOLVE2D_H_
+#define INC_SIMD_CONVOLVE2D_H_
+
+#include <stddef.h>
+#include <simd/common.h>
+#include <simd/attributes.h>
+#include <simd/convolve_structs.h>
+
+SIMD_API_BEGIN
+
+/// @brief Calculates the full linear 2D convolution of the image with
+/// the kernel using the "brute force" method.
+/// @param simd Value indicating whether to use SIMD acceleration or not.
+/// @param x The image, xHeight rows of xWidth float-s.
+/// @param xStride The distance between the rows of x in float-s.
+/// @param xWidth The width of x.
+/// @param xHeight The height of x.
+/// @param h The kernel, hHeight rows of hWidth float-s without gaps.
+/// @param hWidth The width of h.
+/// @param hHeight The height of h.
+/// @param result The resulting image of (xHeight + hHeight - 1) rows of
+/// (xWidth + hWidth - 1) float-s.
+/// @param resultStride The distance between the rows of result in float-s.
+/// @details The register blocked kernel of convolve_simd() runs over all
+/// the kernel rows, so every output is stored once.
+void convolve2D_simd(int simd, const float *__restrict x, size_t xStride,
+                     size_t xWidth, size_t xHeight,
+                     const float *__restrict h, size_t hWidth,
+                     size_t hHeight, float *__restrict result,
+                     size_t resultStride) NOTNULL(2, 6, 9);
+
+/// @brief The kernels of not more samples are always convolved directly
+/// by convolve2D_initialize().
+#define CONVOLUTION_2D_DIRECT_THRESHOLD 64
+
+/// @brief The handle of the 2D convolution, see convolve2D_initialize().
+typedef struct {
+  /// kConvolutionAlgorithmBruteForce means convolve2D_simd(), the others
+  /// work on the rows padded to the output width and flattened.
+  ConvolutionAlgorithm algorithm;
+  size_t x_width;
+  size_t x_height;
+  size_t h_width;
+  size_t h_height;
+  int reverse;
+  /// The 1D convolution of the flattened images.
+  struct ConvolutionHandle line;
+  /// The reversed kernel of the cross-correlation.
+  float *kernel;
+  /// The flattened image, kernel and result.
+  float *x_flat;
+  float *h_flat;
+  float *result_flat;
+  void *workspace;
+} Convolution2DHandle;
+
+/// @brief Returns the algorithm convolve2D_initialize() would choose.
+/// @details The small kernels are convolved directly, otherwise an FFT
+/// based method is taken by convolve_select_algorithm() for the lengths of
+/// the flattened images, so the autotuning applies as well.
+ConvolutionAlgorithm convolve2D_select_algorithm(size_t xWidth,
+                                                 size_t xHeight,
+                                                 size_t hWidth,
+                                                 size_t hHeight);
+
+/// @brief Prepares for the calculation of the 2D convolution using the
+/// specified method.
+/// @param xWidth The width of the image.
+/// @param xHeight The height of the image.
+/// @param hWidth The width of the kernel.
+/// @param hHeight The height of the kernel.
+/// @param algorithm The method to use. Overlap-save requires the flattened
+/// kernel to be shorter than the half of the flattened image.
+/// @return The handle for convolve2D().
+/// @details The FFT based methods pad every row to the output width
+/// and run the 1D convolution of the flattened images, which contains the
+/// 2D one row by row since the padding stops the rows from overlapping.
+Convolution2DHandle convolve2D_initialize_algorithm(
+    size_t xWidth, size_t xHeight, size_t hWidth, size_t hHeight,
+    ConvolutionAlgorithm algorithm);
+
+/// @brief Prepares for the calculation of the 2D convolution using the
+/// best method, see convolve2D_select_algorithm().
+/// @return The handle for convolve2D().
+Convolution2DHandle convolve2D_initialize(size_t xWidth, size_t xHeight,
+                                          size_t hWidth, size_t hHeight);
+
+/// @brief Calculates the full linear 2D convolution.
+/// @param handle The structure obtained from convolve2D_initialize().
+/// @param x The image, see convolve2D_simd().
+/// @param xStride The distance between the rows of x in float-s.
+/// @param h The kernel, hHeight rows of hWidth float-s without gaps.
+/// @param result The resulting image of (xHeight + hHeight - 1) rows of
+/// (xWidth + hWidth - 1) float-s.
+/// @param resultStride The distance between the rows of result in float-s.
+void convolve2D(Convolution2DHandle handle,
+                const float *__restrict x, size_t xStride,
+                const float *__restrict h,
+                float *__restrict result, size_t resultStride)
+    NOTNULL(2, 4, 5);
+
+/// @brief Frees any resources allocated by convolve2D_initialize().
+/// @param handle The structure obtained from convolve2D_initialize().
+void convolve2D_finalize(Convolution2DHandle handle);
+
+/// @brief The handle of the 2D convolution with the separable kernel,
+/// see convolve2D_separable_initialize().
+typedef struct {
+  size_t x_width;
+  size_t x_height;
+  size_t h_row_length;
+  size_t h_column_length;
+  int reverse;
+  /// The 1D convolution of the rows.
+  struct ConvolutionHandle rows;
+  /// The rows convolved with the row filter.
+  float *buffer;
+  /// The reversed column filter of the cross-correlation.
+  float *column;
+} Convolution2DSeparableHandle;
+
+/// @brief Prepares for the calculation of the 2D convolution with the
+/// kernel which is the outer product of the column and the row filters.
+/// @param xWidth The width of the image.
+/// @param xHeight The height of the image.
+/// @param hRowLength The length of the row filter, the width of the kernel.
+/// @param hColumnLength The length of the column filter, the height of the
+/// kernel.
+/// @return The handle for convolve2D_separable().
+/// @details The rows are convolved by the method which
+/// convolve_initialize() selects, the columns directly, whole rows at a
+/// time, so nothing is transposed.
+Convolution2DSeparableHandle convolve2D_separable_initialize(
+    size_t xWidth, size_t xHeight, size_t hRowLength, size_t hColumnLength);
+
+/// @brief Calculates the full linear 2D convolution with the separable
+/// kernel h[i][j] = hColumn[i] * hRow[j].
+/// @param handle The structure obtained from
+/// convolve2D_separable_initialize().
+/// @param x The image, see convolve2D_simd().
+/// @param xStride The distance between the rows of x in float-s.
+/// @param hRow The row filter.
+/// @param hColumn The column filter.
+/// @param result The resulting image, see convolve2D().
+/// @param resultStride The distance between the rows of result in float-s.
+void convolve2D_separable(Convolution2DSeparableHandle handle,
+                          const float *__restrict x, size_t xStride,
+                          const float *__restrict hRow,
+                          const float *__restrict hColumn,
+                          float *__restrict result, size_t resultStride)
+    NOTNULL(2, 4, 5, 6);
+
+/// @brief Frees any resources allocated by
+/// convolve2D_separable_initialize().
+/// @param handle The structure obtained from
+/// convolve2D_separable_initialize().
+void convolve2D_separable_finalize(Convolution2DSeparableHandle handle);
+
+/// @brief Acts like convolve2D_initialize() for the 2D cross-correlation.
+/// @details The cross-correlation at the lag (k, l) is written to
+/// result[k + hHeight - 1][l + hWidth - 1], the same way as
+/// cross_correlate() does in 1D.
+Convolution2DHandle cross_correlate2D_initialize(size_t xWidth,
+                                                 size_t xHeight,
+                                                 size_t hWidth,
+                                                 size_t hHeight);
+
+/// @brief Calculates the full 2D cross-correlation, see convolve2D().
+/// @param handle The structure obtained from cross_correlate2D_initialize().
+void cross_correlate2D(Convolution2DHandle handle,
+                       const float *__restrict x, size_t xStride,
+                       const float *__restrict h,
+                       float *__restrict result, size_t resultStride)
+    NOTNULL(2, 4, 5);
+
+/// @brief Frees any resources allocated by cross_correlate2D_initialize().
+void cross_correlate2D_finalize(Convolution2DHandle handle);
+
+/// @brief Acts like convolve2D_separable_initialize() for the 2D
+/// cross-correlation.
+Convolution2DSeparableHandle cross_correlate2D_separable_initialize(
+    size_t xWidth, size_t xHeight, size_t hRowLength, size_t hColumnLength);
+
+/// @brief Calculates the full 2D cross-correlation with the separable
+/// kernel, see convolve2D_separable().
+/// @param handle The structure obtained from
+/// cross_correlate2D_separable_initialize().
+void cross_correlate2D_separable(Convolution2DSeparableHandle handle,
+                                 const float *__restrict x, size_t xStride,
+                                 const float *__restrict hRow,
+                                 const float *__restrict hColumn,
+                                 float *__restrict result,
+                                 size_t resultStride) NOTNULL(2, 4, 5, 6);
+
+/// @brief Frees any resources allocated by
+/// cross_correlate2D_separable_initialize().
+void cross_correlate2D_separable_finalize(
+    Convolution2DSeparableHandle handle);
+
+SIMD_API_END
+
+#endif  // INC_SIMD_CONVOLVE2D_H_
@@ -36,40 +36,108 @@
 
 SIMD_API_BEGIN
 
+struct FFTPlan;
+struct FFTPlans;
+
 struct ConvolutionOverlapSaveHandle {
-  void *fft_plan;
-  void *fft_inverse_plan;
+  struct FFTPlan *fft_plan;
+  struct FFTPlan *fft_inverse_plan;
+  struct FFTPlans *plans;
   float *fft_boiler_plate;
   float *H;
   size_t x_length;
   size_t h_length;
   int *L;
   int reverse;
+  void *workspace;
+};
+
+struct ConvolutionOverlapSaveParallelHandle {
+  struct ThreadPool *pool;
+  int threads;
+  struct ConvolutionOverlapSaveHandle *workers;
 };
 
 struct ConvolutionFFTHandle {
-  void *fft_plan;
-  void *fft_inverse_plan;
+  struct FFTPlan *fft_plan;
+  struct FFTPlan *fft_inverse_plan;
+  struct FFTPlans *plans;
   int *M;
   int x_length;
   int h_length;
   float **inputs;
   int reverse;
+  void *workspace;
+};
+
+struct ConvolutionStreamHandle {
+  struct FFTPlan *fft_plan;
+  struct FFTPlan *fft_inverse_plan;
+  struct FFTPlans *plans;
+  float *fft_boiler_plate;
+  float *H;
+  float *history;
+  size_t h_length;
+  size_t block_length;
+  int *L;
+};
+
+struct ConvolutionBatchHandle {
+  struct FFTPlan *fft_plan;
+  struct FFTPlan *fft_inverse_plan;
+  float *buffers;
+  float **inputs;
+  float *H;
+  int *M;
+  size_t x_length;
+  size_t h_length;
+  size_t stride;
+  int channels;
+};
+
+struct ConvolutionPartitionedHandle {
+  struct FFTPlan *fft_plan;
+  struct FFTPlan *fft_inverse_plan;
+  struct FFTPlans *plans;
+  float *fft_boiler_plate;
+  float *H;
+  float *fdl;
+  float *accumulator;
+  float *history;
+  float *block;
+  size_t h_length;
+  size_t block_length;
+  int partitions;
+  int *N;
+  int *position;
+  int reverse;
 };
 
 typedef enum {
   kConvolutionAlgorithmBruteForce,
   kConvolutionAlgorithmFFT,
-  kConvolutionAlgorithmOverlapSave
+  kConvolutionAlgorithmOverlapSave,
+  kConvolutionAlgorithmPartitioned
 } ConvolutionAlgorithm;
 
 struct ConvolutionHandle {
   ConvolutionAlgorithm algorithm;
   int x_length;
   int h_length;
+  float *kernel;
+  union {
+    struct ConvolutionFFTHandle fft;
+    struct ConvolutionOverlapSaveHandle os;
+    struct ConvolutionPartitionedHandle partitioned;
+  } handle;
+};
+
+struct ConvolutionScratch {
+  ConvolutionAlgorithm algorithm;
   union {
     struct ConvolutionFFTHandle fft;
     struct ConvolutionOverlapSaveHandle os;
+    struct ConvolutionPartitionedHandle partitioned;
   } handle;
 };
 
@@ -35,6 +35,8 @@
 #include <simd/common.h>
 #include <simd/attributes.h>
 #include <simd/convolve_structs.h>
+#include <simd/detect_peaks.h>
+#include <simd/thread_pool.h>
 
 SIMD_API_BEGIN
 
@@ -48,6 +50,16 @@ typedef struct ConvolutionFFTHandle CrossCorrelationFFTHandle;
 CrossCorrelationFFTHandle cross_correlate_fft_initialize(size_t xLength,
                                                          size_t hLength);
 
+/// @brief Acts like cross_correlate_fft_initialize(), but all the buffers
+/// of the handle are placed in the specified memory block.
+/// @param xLength The length of the first array in float-s.
+/// @param hLength The length of the second array in float-s.
+/// @param workspace The memory block of convolve_fft_workspace_size() bytes,
+/// see convolve_fft_initialize_in_place().
+/// @return The handle for cross_correlate_fft().
+CrossCorrelationFFTHandle cross_correlate_fft_initialize_in_place(
+    size_t xLength, size_t hLength, void *workspace) NOTNULL(3);
+
 /// @brief Calculates the cross-correlation of two signals using
 /// the FFT method.
 /// @param handle The structure obtained from cross_correlate_fft_initialize().
@@ -73,6 +85,18 @@ typedef struct ConvolutionOverlapSaveHandle CrossCorrelationOverlapSaveHandle;
 CrossCorrelationOverlapSaveHandle cross_correlate_overlap_save_initialize(
     size_t xLength, size_t hLength);
 
+/// @brief Acts like cross_correlate_overlap_save_initialize(), but all
+/// the buffers of the handle are placed in the specified memory block.
+/// @param xLength The length of the first array in float-s.
+/// @param hLength The length of the second array in float-s.
+/// @param workspace The memory block of
+/// convolve_overlap_save_workspace_size() bytes, see
+/// convolve_overlap_save_initialize_in_place().
+/// @return The handle for cross_correlate_overlap_save().
+CrossCorrelationOverlapSaveHandle
+cross_correlate_overlap_save_initialize_in_place(
+    size_t xLength, size_t hLength, void *workspace) NOTNULL(3);
+
 /// @brief Calculates the cross-correlation of two signals using
 /// the overlap-save method.
 /// @param handle The structure obtained from
@@ -93,6 +117,88 @@ void cross_correlate_overlap_save(CrossCorrelationOverlapSaveHandle handle,
 void cross_correlate_overlap_save_finalize(
     CrossCorrelationOverlapSaveHandle handle);
 
+typedef struct ConvolutionBatchHandle CrossCorrelationBatchHandle;
+
+/// @brief Prepares for the calculation of cross-correlation of several
+/// signals (channels) of the same length with the same template, using
+/// the FFT method.
+/// @param xLength The length of every channel in float-s.
+/// @param h The template, its spectrum is calculated only once.
+/// @param hLength The length of the template in float-s.
+/// @param channels The number of channels.
+/// @return The handle for cross_correlate_batch() and
+/// cross_correlate_batch_strided().
+CrossCorrelationBatchHandle cross_correlate_batch_initialize(
+    size_t xLength, const float *h, size_t hLength, int channels) NOTNULL(2);
+
+/// @brief Calculates the cross-correlation of every channel with
+/// the template.
+/// @param handle The structure obtained from
+/// cross_correlate_batch_initialize().
+/// @param x The array of the channels, each of length xLength.
+/// @param result The array of the resulting signals, each of length
+/// xLength + hLength - 1.
+void cross_correlate_batch(CrossCorrelationBatchHandle handle,
+                           const float *const *x, float *const *result)
+    NOTNULL(2, 3);
+
+/// @brief Calculates the cross-correlation of every channel with
+/// the template, the channels being stored one after another.
+/// @param handle The structure obtained from
+/// cross_correlate_batch_initialize().
+/// @param x The first channel.
+/// @param xStride The distance between the beginnings of the channels
+/// in float-s.
+/// @param result The first resulting signal.
+/// @param resultStride The distance between the beginnings of the resulting
+/// signals in float-s.
+void cross_correlate_batch_strided(CrossCorrelationBatchHandle handle,
+                                   const float *x, size_t xStride,
+                                   float *result, size_t resultStride)
+    NOTNULL(2, 4);
+
+/// @brief Frees any resources allocated by
+/// cross_correlate_batch_initialize().
+/// @param handle The structure obtained from
+/// cross_correlate_batch_initialize().
+void cross_correlate_batch_finalize(CrossCorrelationBatchHandle handle);
+
+typedef struct ConvolutionOverlapSaveParallelHandle
+    CrossCorrelationOverlapSaveParallelHandle;
+
+/// @brief Prepares for the calculation of cross-correlation of two signals
+/// using the overlap-save method, the blocks being processed on several
+/// threads.
+/// @param xLength The length of the first array in float-s.
+/// @param hLength The length of the second array in float-s.
+/// @param pool The thread pool to run on. If it is NULL, the default one is
+/// taken, see thread_pool_default().
+/// @param threads The maximal number of threads to use, including the
+/// calling one. If it is 0, all the threads of the pool are used.
+/// @return The handle for cross_correlate_overlap_save_parallel().
+CrossCorrelationOverlapSaveParallelHandle
+cross_correlate_overlap_save_parallel_initialize(
+    size_t xLength, size_t hLength, ThreadPool *pool, int threads);
+
+/// @brief Calculates the cross-correlation of two signals using
+/// the overlap-save method on several threads.
+/// @param handle The structure obtained from
+/// cross_correlate_overlap_save_parallel_initialize().
+/// @param x The first signal (long one).
+/// @param h The second signal (short one).
+/// @param result The resulting signal of length xLength + hLength - 1.
+/// @note result and x may NOT be the same arrays.
+void cross_correlate_overlap_save_parallel(
+    CrossCorrelationOverlapSaveParallelHandle handle,
+    const float *x, const float *h, float *result) NOTNULL(2, 3, 4);
+
+/// @brief Frees any resources allocated by
+/// cross_correlate_overlap_save_parallel_initialize().
+/// @param handle The structure obtained from
+/// cross_correlate_overlap_save_parallel_initialize().
+void cross_correlate_overlap_save_parallel_finalize(
+    CrossCorrelationOverlapSaveParallelHandle handle);
+
 /// @brief Calculates the cross-correlation of two signals using
 /// the "brute force" method.
 /// @param simd Value indicating whether to use SIMD acceleration or not.
@@ -117,6 +223,16 @@ typedef struct ConvolutionHandle CrossCorrelationHandle;
 CrossCorrelationHandle cross_correlate_initialize(size_t xLength,
                                                   size_t hLength);
 
+/// @brief Prepares for the calculation of cross-correlation of
+/// two signals using the specified method.
+/// @param xLength The length of the first array in float-s.
+/// @param hLength The length of the second array in float-s.
+/// @param algorithm The method to use. Overlap-save requires
+/// hLength < xLength / 2.
+/// @return The handle for cross_correlate().
+CrossCorrelationHandle cross_correlate_initialize_algorithm(
+    size_t xLength, size_t hLength, ConvolutionAlgorithm algorithm);
+
 /// @brief Calculates the cross-correlation of two signals using
 /// the best method.
 /// @param handle The structure obtained from cross_correlate_initialize().
@@ -128,12 +244,253 @@ void cross_correlate(CrossCorrelationHandle handle,
                      const float *__restrict x, const float *__restrict h,
                      float *__restrict result) NOTNULL(2, 3, 4);
 
+/// @brief Prepares for the calculation of cross-correlation of signals
+/// with the fixed template using the best method.
+/// @param xLength The length of the first array in float-s.
+/// @param h The template (shorter signal). Its spectrum is calculated here
+/// once instead of during every call.
+/// @param hLength The length of the template in float-s.
+/// @return The handle for cross_correlate_with_kernel(), it must be freed
+/// with cross_correlate_finalize().
+CrossCorrelationHandle cross_correlate_initialize_with_kernel(
+    size_t xLength, const float *h, size_t hLength) NOTNULL(2);
+
+/// @brief Calculates the cross-correlation of the signal with the template
+/// passed to cross_correlate_initialize_with_kernel().
+/// @param handle The structure obtained from
+/// cross_correlate_initialize_with_kernel().
+/// @param x The signal (long one).
+/// @param result The resulting signal of length xLength + hLength - 1.
+void cross_correlate_with_kernel(CrossCorrelationHandle handle,
+                                 const float *__restrict x,
+                                 float *__restrict result) NOTNULL(2, 3);
+
+/// @brief Calculates the cross-correlation of the signal with the template
+/// passed to cross_correlate_initialize_with_kernel(), using the buffers of
+/// the scratch, so that several threads may share the handle.
+/// @param handle The structure obtained from
+/// cross_correlate_initialize_with_kernel().
+/// @param scratch The structure obtained from convolve_scratch_initialize()
+/// for this handle, see convolve_with_kernel_scratch().
+/// @param x The signal (long one).
+/// @param result The resulting signal of length xLength + hLength - 1.
+void cross_correlate_with_kernel_scratch(CrossCorrelationHandle handle,
+                                         struct ConvolutionScratch scratch,
+                                         const float *__restrict x,
+                                         float *__restrict result)
+    NOTNULL(3, 4);
+
 /// @brief Frees any resources allocated by
 /// cross_correlate_overlap_initialize().
 /// @param handle The structure obtained from
 /// cross_correlate_overlap_initialize().
 void cross_correlate_finalize(CrossCorrelationHandle handle);
 
+/// @brief The predefined lag ranges of cross_correlate_mode_initialize().
+/// @details The cross-correlation at lag l is
+/// @code
+/// c[l] = sum(x[m + l] * h[m]), m = 0..hLength-1,
+/// @endcode
+/// x being zero outside of its bounds.
+typedef enum {
+  /// l = -(hLength - 1)..xLength - 1, the same xLength + hLength - 1 values
+  /// as cross_correlate() returns.
+  kCrossCorrelationFull,
+  /// l = 0..xLength - hLength, where h is entirely inside x. It requires
+  /// hLength <= xLength.
+  kCrossCorrelationValid,
+  /// xLength values centered with respect to the full output, that is,
+  /// l = -(hLength / 2)..xLength - 1 - hLength / 2.
+  kCrossCorrelationSame
+} CrossCorrelationMode;
+
+/// @brief The handle of the cross-correlation over a window of lags,
+/// which multiplies by the conjugated spectrum of h instead of convolving
+/// with the reversed h.
+typedef struct {
+  struct FFTPlans *plans;
+  float *H;
+  size_t x_length;
+  size_t h_length;
+  /// The first calculated lag.
+  int min_lag;
+  /// The last calculated lag, cross_correlate_lags() writes
+  /// max_lag - min_lag + 1 values.
+  int max_lag;
+  /// Only x[x_offset..x_offset + x_segment) contribute to the lags.
+  size_t x_offset;
+  size_t x_segment;
+  int *N;
+  void *workspace;
+} CrossCorrelationLagsHandle;
+
+/// @brief Prepares for the calculation of cross-correlation of two signals
+/// at the specified lags only.
+/// @param xLength The length of the first array in float-s.
+/// @param hLength The length of the second array in float-s.
+/// @param minLag The first lag to calculate, -(hLength - 1) or greater.
+/// @param maxLag The last lag to calculate, xLength - 1 or less.
+/// @return The handle for cross_correlate_lags().
+/// @details The FFT length depends on the number of the lags and the part
+/// of x they touch, not on xLength + hLength - 1, so the narrow windows are
+/// cheaper than the full cross-correlation.
+CrossCorrelationLagsHandle cross_correlate_lags_initialize(
+    size_t xLength, size_t hLength, int minLag, int maxLag);
+
+/// @brief Acts like cross_correlate_lags_initialize() with the lag range
+/// of the specified mode.
+CrossCorrelationLagsHandle cross_correlate_mode_initialize(
+    size_t xLength, size_t hLength, CrossCorrelationMode mode);
+
+/// @brief Calculates the cross-correlation of two signals at the lags of
+/// the handle.
+/// @param handle The structure obtained from
+/// cross_correlate_lags_initialize() or cross_correlate_mode_initialize().
+/// @param x The first signal (long one).
+/// @param h The second signal (short one).
+/// @param result The resulting signal of length
+/// handle.max_lag - handle.min_lag + 1, result[i] = c[handle.min_lag + i].
+/// @note result and x may be the same arrays.
+void cross_correlate_lags(CrossCorrelationLagsHandle handle,
+                          const float *x, const float *h,
+                          float *result) NOTNULL(2, 3, 4);
+
+/// @brief Frees any resources allocated by
+/// cross_correlate_lags_initialize().
+/// @param handle The structure obtained from
+/// cross_correlate_lags_initialize().
+void cross_correlate_lags_finalize(CrossCorrelationLagsHandle handle);
+
+/// @brief Normalizes the valid part of the cross-correlation with the
+/// zero mean template, so that it becomes the Pearson correlation
+/// coefficient of the template and each window of x.
+/// @param x The signal, it must contain at least length + hLength - 1
+/// elements.
+/// @param hLength The length of the template in float-s.
+/// @param hNorm The Euclidean norm of the zero mean template.
+/// @param correlation The cross-correlation with the zero mean template at
+/// the lags 0..length - 1, that is, the full one shifted by hLength - 1.
+/// @param length The number of lags.
+/// @param result The normalized values in [-1, 1]. The windows with zero
+/// variance (and any window if hNorm is zero) produce 0.
+/// @note result and correlation may be the same arrays.
+/// @details The window sums and sums of squares are calculated in double
+/// via the prefix sums of x[l + hLength] - x[l], so the cost does not
+/// depend on hLength.
+void cross_correlate_normalize(const float *x, size_t hLength, float hNorm,
+                               const float *correlation, size_t length,
+                               float *result) NOTNULL(1, 4, 6);
+
+/// @brief The handle of the normalized cross-correlation (template
+/// matching) with the fixed template.
+typedef struct {
+  CrossCorrelationHandle correlation;
+  /// The full cross-correlation with the zero mean template.
+  float *buffer;
+  size_t x_length;
+  size_t h_length;
+  /// The Euclidean norm of the zero mean template.
+  float h_norm;
+} NormalizedCrossCorrelationHandle;
+
+/// @brief Prepares for the calculation of the normalized cross-correlation
+/// of signals with the fixed template.
+/// @param xLength The length of the signal in float-s.
+/// @param h The template. Its mean is subtracted and its spectrum is
+/// calculated here once.
+/// @param hLength The length of the template in float-s, hLength <= xLength.
+/// @return The handle for normalized_cross_correlate(), it must be freed
+/// with normalized_cross_correlate_finalize().
+NormalizedCrossCorrelationHandle normalized_cross_correlate_initialize(
+    size_t xLength, const float *h, size_t hLength) NOTNULL(2);
+
+/// @brief Calculates the normalized cross-correlation of the signal with
+/// the template passed to normalized_cross_correlate_initialize().
+/// @param handle The structure obtained from
+/// normalized_cross_correlate_initialize().
+/// @param x The signal (long one).
+/// @param result The resulting signal of length xLength - hLength + 1,
+/// result[l] is the correlation coefficient of h and x[l..l + hLength).
+void normalized_cross_correlate(NormalizedCrossCorrelationHandle handle,
+                                const float *__restrict x,
+                                float *__restrict result) NOTNULL(2, 3);
+
+/// @brief Frees any resources allocated by
+/// normalized_cross_correlate_initialize().
+/// @param handle The structure obtained from
+/// normalized_cross_correlate_initialize().
+void normalized_cross_correlate_finalize(
+    NormalizedCrossCorrelationHandle handle);
+
+/// @brief The handle of the cross-correlation of one signal with many
+/// fixed templates, see cross_correlate_bank_initialize().
+typedef struct {
+  struct FFTPlans *plans;
+  /// The spectra of the templates scaled by 1 / N, N + 2 float-s each.
+  float *H;
+  /// The spectrum of the last signal.
+  float *X;
+  /// The full cross-correlation for cross_correlate_bank_peaks().
+  float *buffer;
+  size_t x_length;
+  size_t *h_lengths;
+  int templates;
+  int *N;
+  void *workspace;
+} CrossCorrelationBankHandle;
+
+/// @brief Prepares for the calculation of cross-correlation of signals
+/// with the bank of fixed templates.
+/// @param xLength The length of the signal in float-s.
+/// @param h The templates. Their spectra are calculated here once.
+/// @param hLengths The lengths of the templates in float-s, they may differ.
+/// @param templates The number of the templates.
+/// @return The handle for cross_correlate_bank(), it must be freed with
+/// cross_correlate_bank_finalize().
+/// @details All the templates share one FFT length, so the signal is
+/// transformed once per call, and each template costs one spectrum
+/// multiplication and one inverse transform.
+CrossCorrelationBankHandle cross_correlate_bank_initialize(
+    size_t xLength, const float *const *h, const size_t *hLengths,
+    int templates) NOTNULL(2, 3);
+
+/// @brief Calculates the cross-correlation of the signal with each
+/// template of the bank.
+/// @param handle The structure obtained from
+/// cross_correlate_bank_initialize().
+/// @param x The signal (long one).
+/// @param result The resulting signals, result[i] has the length
+/// xLength + hLengths[i] - 1, the same as cross_correlate() returns.
+void cross_correlate_bank(CrossCorrelationBankHandle handle,
+                          const float *x, float *const *result) NOTNULL(2, 3);
+
+/// @brief Calculates the cross-correlation of the signal with each
+/// template of the bank and extracts the extrema from each one.
+/// @param handle The structure obtained from
+/// cross_correlate_bank_initialize().
+/// @param x The signal (long one).
+/// @param type The type of the extracted extrema.
+/// @param filters The filters, see detect_peaks_filtered(). If NULL, all
+/// the extrema are returned.
+/// @param results results[i] is set to the array of the extrema of the
+/// i-th cross-correlation, which should be disposed with free(). The
+/// positions are in the full cross-correlation, that is, the lag is
+/// position - (hLengths[i] - 1).
+/// @param resultsLengths The numbers of the found extrema.
+/// @details The cross-correlations are not stored, each one is scanned
+/// right after the inverse transform while it is still in the cache.
+void cross_correlate_bank_peaks(CrossCorrelationBankHandle handle,
+                                const float *x, ExtremumType type,
+                                const DetectPeaksFilters *filters,
+                                ExtremumPoint **results,
+                                size_t *resultsLengths) NOTNULL(2, 5, 6);
+
+/// @brief Frees any resources allocated by
+/// cross_correlate_bank_initialize().
+/// @param handle The structure obtained from
+/// cross_correlate_bank_initialize().
+void cross_correlate_bank_finalize(CrossCorrelationBankHandle handle);
+
 SIMD_API_END
 
 #endif  // INC_SIMD_CORRELATE_H_
@@ -0,0 +1,90 @@
+/*! @file cpu.h
+ *  @brief Runtime detection of the supported instruction sets and the
+ *  selection of the kernels.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef INC_SIMD_CPU_H_
+#define INC_SIMD_CPU_H_
+
+#include <simd/common.h>
+
+SIMD_API_BEGIN
+
+/// @brief Instruction set tiers the library kernels are built for.
+/// @details x86 tiers are ordered, each next one is a superset of the
+/// previous, the same is true for the ARM ones.
+typedef enum {
+  kInstructionSetNone = 0,
+  /// SSE4.2 and POPCNT. 256-bit operations are emulated with SSE pairs.
+  kInstructionSetSSE4,
+  /// AVX.
+  kInstructionSetAVX,
+  /// AVX2, FMA and F16C.
+  kInstructionSetAVX2,
+  /// AVX-512 F, CD, BW, DQ and VL.
+  kInstructionSetAVX512,
+  /// ARM NEON.
+  kInstructionSetNEON,
+  /// ARMv8 AArch64 Advanced SIMD: fused multiply-add, the reductions across
+  /// the vector and 32 quad registers.
+  kInstructionSetAArch64
+} InstructionSet;
+
+/// @brief Name of the environment variable which limits the instruction
+/// set used by the kernels, e.g. SIMD_INSTRUCTION_SET=avx.
+#define SIMD_INSTRUCTION_SET_ENV "SIMD_INSTRUCTION_SET"
+
+/// @brief Queries the processor and the operating system (CPUID/XGETBV)
+/// for the best instruction set tier they support.
+/// @return The best supported tier. The result is cached.
+InstructionSet simd_cpu_instruction_set(void);
+
+/// @brief Returns the instruction set tier of the kernels which are
+/// currently called through the public API.
+/// @details It is chosen once during library loading: the best tier which
+/// was compiled in and is supported by the processor, optionally limited
+/// by SIMD_INSTRUCTION_SET environment variable.
+InstructionSet simd_instruction_set(void);
+
+/// @brief Switches the kernels to the specified instruction set tier.
+/// @param isa The requested tier. If it is not compiled in or is not
+/// supported by the processor, the best lower one is taken instead, or
+/// the lowest compiled in if there is no such.
+/// @return The tier which was actually activated.
+/// @note This function is not thread safe with regard to the running
+/// kernels and is intended for testing and benchmarking.
+InstructionSet simd_set_instruction_set(InstructionSet isa);
+
+/// @brief Returns the lower case name of the instruction set tier,
+/// the same which is accepted by SIMD_INSTRUCTION_SET environment variable.
+const char *simd_instruction_set_name(InstructionSet isa);
+
+SIMD_API_END
+
+#endif  // INC_SIMD_CPU_H_
@@ -62,6 +62,141 @@ void detect_peaks(int simd, const float *data, size_t size, ExtremumType type,
                   ExtremumPoint **results, size_t *resultsLength)
     NOTNULL(2, 5, 6);
 
+/// @brief The filters of detect_peaks_filtered().
+typedef struct {
+  /// The maxima less than it are skipped.
+  float maximumThreshold;
+  /// The minima greater than it are skipped.
+  float minimumThreshold;
+  /// The minimal distance between two extrema of the same kind, in samples.
+  /// Of the closer ones, the most extreme is kept.
+  int distance;
+  /// The minimal prominence of the extrema. The prominence of a maximum is
+  /// its height over the higher of the two bases, the lowest points between
+  /// it and the nearest higher sample, or the end of the signal, to the left
+  /// and to the right. The same for a minimum, upside down.
+  float prominence;
+  /// The maximal number of the extrema, the most prominent ones are kept.
+  size_t topK;
+} DetectPeaksFilters;
+
+/// @brief Sets all the filters to the values which disable them:
+/// both thresholds are infinite, distance, prominence and topK are 0.
+void detect_peaks_filters_initialize(DetectPeaksFilters *filters) NOTNULL(1);
+
+/// @brief The same as detect_peaks(), but only the extrema which pass the
+/// filters are returned.
+/// @param simd Value indicating whether to use SIMD acceleration.
+/// @param data The array of floating point numbers representing the signal.
+/// @param size The length of the array (in float-s, not in bytes).
+/// @param type The type of the extracted extrema.
+/// @param filters The filters, see detect_peaks_filters_initialize().
+/// @param results The pointer to the array of ExtremumPoint-s, ordered by
+/// position. It should be disposed with free(). If no points are found,
+/// it is set to NULL.
+/// @param resultsLength The number of found extremum points.
+/// @details The thresholds are applied inside the vectorized scan. The
+/// prominence is found with the stack of the candidates, chunk by chunk,
+/// while the samples are still in the cache. The distance and topK filters
+/// work on the candidates only. A plateau is not an extremum, so it does not
+/// bound the bases.
+void detect_peaks_filtered(int simd, const float *data, size_t size,
+                           ExtremumType type,
+                           const DetectPeaksFilters *filters,
+                           ExtremumPoint **results, size_t *resultsLength)
+    NOTNULL(2, 5, 6, 7);
+
+/// @brief The state of the extrema detection in the signal which arrives
+/// block by block, see detect_peaks_stream_initialize().
+/// @details The fields are private, use the functions below.
+typedef struct {
+  ExtremumType type;
+  /// The ring buffer of the found points, provided by the caller.
+  ExtremumPoint *points;
+  size_t capacity;
+  /// The index of the oldest point in the ring buffer.
+  size_t first;
+  /// The number of the points in the ring buffer.
+  size_t count;
+  /// The number of the points which were overwritten before being popped.
+  size_t lost;
+  /// The number of the samples pushed since the last flush.
+  size_t position;
+  /// The last samples of the previous blocks.
+  float history[2];
+  /// The number of the valid samples in history.
+  int known;
+} DetectPeaksStream;
+
+/// @brief Prepares for the extraction of the extrema from the signal which
+/// arrives block by block.
+/// @param stream The state to initialize.
+/// @param type The type of the extracted extrema.
+/// @param buffer The ring buffer for the found points. It must outlive
+/// the stream. Nothing is ever allocated by the stream functions.
+/// @param capacity The length of buffer. If the points are not popped in
+/// time, the oldest ones are overwritten and counted in stream->lost.
+void detect_peaks_stream_initialize(DetectPeaksStream *stream,
+                                    ExtremumType type, ExtremumPoint *buffer,
+                                    size_t capacity) NOTNULL(1);
+
+/// @brief Extracts the extrema from the next block of the signal.
+/// @param simd Value indicating whether to use SIMD acceleration.
+/// @param stream The state obtained from detect_peaks_stream_initialize().
+/// @param data The next block of the signal, of any length.
+/// @param length The length of the block (in float-s, not in bytes).
+/// @details The last two samples are kept in stream, so the extrema at
+/// the borders of the blocks are found too. The last sample of the block
+/// is checked when the next one arrives. The positions of the points are
+/// counted from the beginning of the signal.
+void detect_peaks_stream_push(int simd, DetectPeaksStream *stream,
+                              const float *data, size_t length)
+    NOTNULL(2, 3);
+
+/// @brief Takes the oldest found points out of the ring buffer.
+/// @param stream The state obtained from detect_peaks_stream_initialize().
+/// @param dest The array to copy the points to.
+/// @param maxCount The length of dest.
+/// @return The number of the copied points.
+size_t detect_peaks_stream_pop(DetectPeaksStream *stream, ExtremumPoint *dest,
+                               size_t maxCount) NOTNULL(1);
+
+/// @brief Ends the signal: the kept samples are dropped, so that the next
+/// block starts a new signal with positions counted from 0.
+/// @param stream The state obtained from detect_peaks_stream_initialize().
+/// @note The points in the ring buffer are not touched. The last sample of
+/// a signal is never an extremum since it has no right neighbour.
+void detect_peaks_stream_flush(DetectPeaksStream *stream) NOTNULL(1);
+
+/// @brief Finds the positions and the values of the minimum and the
+/// maximum in one pass.
+/// @param simd Value indicating whether to use SIMD acceleration.
+/// @param data The array of floating point numbers.
+/// @param size The length of the array (in float-s, not in bytes).
+/// @param min The pointer to the resulting minimum. If NULL, it is not
+/// returned.
+/// @param max The pointer to the resulting maximum. If NULL, it is not
+/// returned.
+/// @details Of the equal extrema, the first one is taken.
+void argminmax1D(int simd, const float *data, size_t size,
+                 ExtremumPoint *min, ExtremumPoint *max) NOTNULL(2);
+
+/// @brief Selects the K greatest or the K least values without sorting
+/// the whole array.
+/// @param simd Value indicating whether to use SIMD acceleration.
+/// @param data The array of floating point numbers.
+/// @param size The length of the array (in float-s, not in bytes).
+/// @param type kExtremumTypeMaximum or kExtremumTypeMinimum.
+/// @param k The number of the values to select.
+/// @param results The array of at least k points to write the selected
+/// values to, from the most extreme one. Of the equal values, the earlier
+/// one goes first.
+/// @return The number of the selected values, min(k, size).
+/// @details The vectorized scan compares the values with the current K-th
+/// one, so only the few which beat it are inserted into the heap.
+size_t topk1D(int simd, const float *data, size_t size, ExtremumType type,
+              size_t k, ExtremumPoint *results) NOTNULL(2, 6);
+
 SIMD_API_END
 
 #endif  // INC_SIMD_DETECT_PEAKS_H_
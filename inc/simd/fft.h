@@ -0,0 +1,127 @@
+/*! @file fft.h
+ *  @brief Planned real and complex FFT and the power spectrum.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef INC_SIMD_FFT_H_
+#define INC_SIMD_FFT_H_
+
+#include <stddef.h>
+#include <simd/common.h>
+#include <simd/attributes.h>
+
+SIMD_API_BEGIN
+
+/// @brief The kind of the transformed data.
+typedef enum {
+  /// length real numbers <-> length / 2 + 1 interleaved complex numbers
+  /// (length + 2 float-s), the imaginary parts of the first and the last
+  /// of them being 0.
+  kFFTTypeReal,
+  /// length interleaved complex numbers <-> length interleaved complex
+  /// numbers (2 * length float-s).
+  kFFTTypeComplex
+} FFTType;
+
+typedef enum {
+  /// X[k] = sum x[n] exp(-2 pi i k n / length).
+  kFFTDirectionForward,
+  /// x[n] = sum X[k] exp(2 pi i k n / length), not normalized, so that
+  /// the forward transform followed by the backward one multiplies
+  /// the signal by length.
+  kFFTDirectionBackward
+} FFTDirection;
+
+/// @brief Plan the transform with the built-in implementation even if
+/// FFTF is available.
+#define kFFTFlagBuiltin 1
+
+/// @brief The transform bound to its input and output, see
+/// fft_initialize(). The fields are private.
+typedef struct FFTPlan FFTPlan;
+
+/// @brief Plans the transform of the specified arrays.
+/// @details FFTF is used if the library was built with it and it can
+/// transform the length, the built-in implementation otherwise. The latter
+/// supports the complex transforms of length 2^a 3^b 5^c and the real ones
+/// of the twice as long lengths, in particular all the lengths returned by
+/// convolve_fft_good_length().
+/// @param type The kind of the data.
+/// @param direction The direction of the transform.
+/// @param length The number of the samples of the signal.
+/// @param input The array which fft_execute() transforms, see FFTType for
+/// its size.
+/// @param output The array which fft_execute() writes, it may be
+/// the same as input.
+/// @param flags 0 or kFFTFlagBuiltin.
+/// @return The plan to pass to fft_execute() or NULL if the length is not
+/// supported.
+/// @note The plan keeps the pointers to input and output, so they must be
+/// valid until fft_finalize().
+FFTPlan *fft_initialize(FFTType type, FFTDirection direction, int length,
+                        const float *input, float *output, int flags)
+    NOTNULL(4, 5);
+
+/// @brief Plans the same transform of several pairs of arrays at once,
+/// see fft_initialize().
+/// @param batch The number of the pairs.
+/// @param inputs batch arrays which fft_execute() transforms.
+/// @param outputs batch arrays which fft_execute() writes, they may be
+/// the same as inputs.
+FFTPlan *fft_initialize_batch(FFTType type, FFTDirection direction,
+                              int length, int batch,
+                              const float *const *inputs,
+                              float *const *outputs, int flags)
+    NOTNULL(5, 6);
+
+/// @brief Transforms the input(s) of the plan to its output(s).
+/// @details The plans are not reentrant: the same plan must not be
+/// executed in several threads at the same time.
+void fft_execute(const FFTPlan *plan) NOTNULL(1);
+
+/// @brief Returns nonzero if the plan uses the built-in implementation.
+int fft_is_builtin(const FFTPlan *plan) NOTNULL(1);
+
+/// @brief Frees the resources of the plan, NULL is ignored.
+void fft_finalize(FFTPlan *plan);
+
+/// @brief Calculates the squared magnitudes of the complex numbers.
+/// @param simd Value indicating whether to use SIMD acceleration.
+/// @param spectrum length interleaved complex numbers, e.g. the output
+/// of the forward real transform.
+/// @param length The number of the complex numbers, length / 2 + 1 for
+/// the real transform of length samples.
+/// @param result The squared magnitudes, re^2 + im^2. It may be the same
+/// as spectrum.
+void fft_power_spectrum(int simd, const float *spectrum, size_t length,
+                        float *result) NOTNULL(2, 4);
+
+SIMD_API_END
+
+#endif  // INC_SIMD_FFT_H_
@@ -0,0 +1,234 @@
+/*! @file fixed.h
+ *  @brief C++ kernels specialized at compile time for the fixed sizes.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ *
+ *  @section Usage
+ *  The sizes are template parameters, so the loops over the taps and over
+ *  the inner dimension are unrolled and the taps stay in registers. They
+ *  are meant for the short hot loops, e.g. an 8-tap FIR, a 16x16 product or
+ *  db4 at length 64; the C functions with the runtime sizes are faster for
+ *  the large ones. The results are equal to convolve_simd(),
+ *  matrix_multiply() and wavelet_apply_na() up to the float rounding.
+ *  @code
+ *  simd::convolve<1024, 8>(x, h, result);
+ *  simd::matrix_multiply<16, 16, 16>(m1, m2, res);
+ *  simd::Wavelet<WAVELET_TYPE_DAUBECHIES, 8> db4;
+ *  db4.apply<64>(src, desthi, destlo);
+ *  @endcode
+ */
+
+
+#ifndef INC_SIMD_FIXED_H_
+#define INC_SIMD_FIXED_H_
+
+#ifndef __cplusplus
+#error simd/fixed.h is a C++ header
+#endif
+
+#include <cassert>
+#include <cstddef>
+#include <simd/wavelet.h>
+
+namespace simd {
+
+namespace internal {
+
+/// @brief Calls f(i) for i = Begin..End-1, unrolled at compile time.
+template <int Begin, int End>
+struct Unroll {
+  template <class F>
+  static inline __attribute__((always_inline)) void apply(const F &f) {
+    f(Begin);
+    Unroll<Begin + 1, End>::apply(f);
+  }
+};
+
+template <int End>
+struct Unroll<End, End> {
+  template <class F>
+  static inline __attribute__((always_inline)) void apply(const F &) {
+  }
+};
+
+/// @brief Tells whether the order is in the tables of the wavelet type,
+/// see wavelet_validate_order().
+template <WaveletType Type, int Order>
+struct ValidOrder {
+  static const bool value = Order >= 2 && Order <= 76 && Order % 2 == 0;
+};
+
+template <int Order>
+struct ValidOrder<WAVELET_TYPE_COIFLET, Order> {
+  static const bool value = Order >= 6 && Order <= 30 && Order % 6 == 0;
+};
+
+}  // namespace internal
+
+/// @brief Calculates the linear convolution of two signals using
+/// the "brute force" method, like convolve_simd().
+/// @param x The first signal (long one) of length XLength.
+/// @param h The second signal (short one) of length HLength.
+/// @param result The resulting signal of length XLength + HLength - 1.
+template <size_t XLength, size_t HLength>
+void convolve(const float *__restrict x, const float *__restrict h,
+              float *__restrict result) {
+  static_assert(HLength > 0 && HLength <= XLength,
+                "h must not be longer than x");
+  assert(x && h && result);
+  const int M = HLength, N = XLength;
+  float taps[M];
+  internal::Unroll<0, M>::apply([&](int m) { taps[m] = h[m]; });
+  // The head and the tail do not overlap the whole h
+  for (int n = 0; n < M - 1; n++) {
+    float sum = 0.f;
+    for (int m = 0; m <= n; m++) {
+      sum += taps[m] * x[n - m];
+    }
+    result[n] = sum;
+  }
+  for (int n = M - 1; n < N; n++) {
+    float sum = 0.f;
+    internal::Unroll<0, M>::apply([&](int m) { sum += taps[m] * x[n - m]; });
+    result[n] = sum;
+  }
+  for (int n = N; n < N + M - 1; n++) {
+    float sum = 0.f;
+    for (int m = n - N + 1; m < M; m++) {
+      sum += taps[m] * x[n - m];
+    }
+    result[n] = sum;
+  }
+}
+
+/// @brief Multiplies two matrices, like matrix_multiply().
+/// @param m1 The first matrix in row-major format, W1 columns and H1 rows.
+/// @param m2 The second matrix in row-major format, W2 columns and W1 rows.
+/// @param res The resulting matrix, of size W2 x H1.
+template <size_t W1, size_t H1, size_t W2>
+void matrix_multiply(const float *__restrict m1, const float *__restrict m2,
+                     float *__restrict res) {
+  static_assert(W1 > 0 && H1 > 0 && W2 > 0, "the sizes must be positive");
+  assert(m1 && m2 && res);
+  for (size_t i = 0; i < H1; i++) {
+    float row[W2];
+    for (size_t j = 0; j < W2; j++) {
+      row[j] = 0.f;
+    }
+    // The row of the result stays in registers for the small W2
+    internal::Unroll<0, W1>::apply([&](int k) {
+      float a = m1[i * W1 + k];
+      for (size_t j = 0; j < W2; j++) {
+        row[j] += a * m2[k * W2 + j];
+      }
+    });
+    for (size_t j = 0; j < W2; j++) {
+      res[i * W2 + j] = row[j];
+    }
+  }
+}
+
+/// @brief The decimated wavelet transform of the fixed type and order.
+/// @details The filters are taken from wavelet_handle_initialize() once in
+/// the constructor, apply() does not allocate.
+template <WaveletType Type, int Order,
+          ExtensionType Ext = EXTENSION_TYPE_PERIODIC>
+class Wavelet {
+ public:
+  static_assert(internal::ValidOrder<Type, Order>::value,
+                "the order is not supported by the wavelet type");
+
+  Wavelet() {
+    WaveletHandle handle = wavelet_handle_initialize(Type, Order, 0, Ext);
+    const float *lowpass = handle.taps + ((Order + 15) & ~15);
+    for (int i = 0; i < Order; i++) {
+      highpass_[i] = handle.taps[i];
+      lowpass_[i] = lowpass[i];
+    }
+    wavelet_handle_finalize(handle);
+  }
+
+  /// @brief Performs a single wavelet transform, like wavelet_apply_na().
+  /// @param src The signal to transform of length Length, in the plain
+  /// format (it does not need wavelet_prepare_array()).
+  /// @param desthi The highpass part of the result, Length / 2 long.
+  /// @param destlo The lowpass part of the result, Length / 2 long.
+  template <size_t Length>
+  void apply(const float *__restrict src, float *__restrict desthi,
+             float *__restrict destlo) const {
+    static_assert(Length > 0 && Length % 2 == 0, "Length must be even");
+    assert(src && desthi && destlo);
+    const int length = Length;
+    float ext[Order];
+    for (int i = 0; i < Order; i++) {
+      switch (Ext) {
+        case EXTENSION_TYPE_PERIODIC:
+          ext[i] = src[i % length];
+          break;
+        case EXTENSION_TYPE_MIRROR:
+          ext[i] = src[length - 1 - (i % length)];
+          break;
+        case EXTENSION_TYPE_CONSTANT:
+          ext[i] = src[length - 1];
+          break;
+        case EXTENSION_TYPE_ZERO:
+          ext[i] = 0;
+          break;
+      }
+    }
+    int i = 0;
+    for (; i + Order <= length; i += 2) {
+      float reshi = 0.f, reslo = 0.f;
+      internal::Unroll<0, Order>::apply([&](int j) {
+        reshi += highpass_[j] * src[i + j];
+        reslo += lowpass_[j] * src[i + j];
+      });
+      desthi[i / 2] = reshi;
+      destlo[i / 2] = reslo;
+    }
+    // Finish with the extended end
+    for (; i < length; i += 2) {
+      float reshi = 0.f, reslo = 0.f;
+      internal::Unroll<0, Order>::apply([&](int j) {
+        int index = i + j;
+        float srcval = index < length? src[index] : ext[index - length];
+        reshi += highpass_[j] * srcval;
+        reslo += lowpass_[j] * srcval;
+      });
+      desthi[i / 2] = reshi;
+      destlo[i / 2] = reslo;
+    }
+  }
+
+ private:
+  float highpass_[Order];
+  float lowpass_[Order];
+};
+
+}  // namespace simd
+
+#endif  // INC_SIMD_FIXED_H_
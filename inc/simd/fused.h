@@ -0,0 +1,109 @@
+/*! @file fused.h
+ *  @brief Fused element-wise evaluation of the chains of array operations.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef INC_SIMD_FUSED_H_
+#define INC_SIMD_FUSED_H_
+
+#include <stddef.h>
+#include <simd/common.h>
+#include <simd/attributes.h>
+
+SIMD_API_BEGIN
+
+/// @brief The operation applied to the intermediate result y of the chain.
+typedef enum {
+  /// y = y + scalar.
+  kFusedOpAddScalar,
+  /// y = y * scalar.
+  kFusedOpMultiplyScalar,
+  /// y = min(y, scalar).
+  kFusedOpMinScalar,
+  /// y = max(y, scalar).
+  kFusedOpMaxScalar,
+  /// y = y + array[i].
+  kFusedOpAddArray,
+  /// y = y * array[i].
+  kFusedOpMultiplyArray,
+  /// y = y * array[i] + scalar.
+  kFusedOpMultiplyArrayAddScalar,
+  /// y = y * array, both are interleaved complex numbers, see
+  /// complex_multiply_array().
+  kFusedOpComplexMultiplyArray,
+  /// y = exp(y), see exp_psv().
+  kFusedOpExp,
+  /// y = log(y), see log_psv().
+  kFusedOpLog,
+  /// y = sin(y), see sin_psv().
+  kFusedOpSin,
+  /// y = cos(y), see cos_psv().
+  kFusedOpCos,
+  /// y = tanh(y), see tanh_psv().
+  kFusedOpTanh,
+  /// y = 1 / (1 + exp(-y)), see sigmoid_psv().
+  kFusedOpSigmoid,
+  /// y = y^scalar, see pow_psv().
+  kFusedOpPow
+} FusedOpType;
+
+/// @brief One link of the chain.
+typedef struct {
+  FusedOpType type;
+  /// The scalar operand, if any.
+  float scalar;
+  /// The array operand, if any. It has the same length as the source.
+  const float *array;
+} FusedOp;
+
+/// @brief The number of elements which pass through the whole chain before
+/// the next ones are loaded. The intermediate results (4 * 2048 bytes)
+/// stay in L1 cache.
+#define FUSED_BLOCK_LENGTH 2048
+
+/// @brief Evaluates the chain of element-wise operations in a single pass
+/// over memory: each block of FUSED_BLOCK_LENGTH elements of src goes
+/// through all the operations before the next block is touched.
+/// @details For example, y = exp(x) * scale is
+/// { { kFusedOpExp, 0, NULL }, { kFusedOpMultiplyScalar, scale, NULL } }.
+/// The math operations give the same results as the corresponding
+/// *_psv() functions, including the chosen MathAccuracy.
+/// @param src The source array.
+/// @param length The length of the arrays (in float-s, not in bytes). It must
+/// be even if the chain contains kFusedOpComplexMultiplyArray.
+/// @param ops The operations, applied in order to every element of src.
+/// @param ops_count The number of operations. If it is zero, src is copied.
+/// @param res The resulting array. It may be the same as src.
+void fused_apply(const float *src, size_t length, const FusedOp *ops,
+                 int ops_count, float *res) NOTNULL(1, 5);
+
+SIMD_API_END
+
+#endif  // INC_SIMD_FUSED_H_
@@ -57,19 +57,46 @@
 #include <avx2intrin.h>
 #endif
 #endif
+#if defined(__FMA__) && !defined(SIMD_IMMINTRIN_INCLUDED)
+#include <fmaintrin.h>
+#endif
+#if defined(__F16C__) && !defined(SIMD_IMMINTRIN_INCLUDED)
+#include <f16cintrin.h>
+#endif
+#if defined(__AVX512F__) && !defined(SIMD_IMMINTRIN_INCLUDED)
+/* The same order as in immintrin.h, the later ones depend on the former */
+#include <avx512fintrin.h>
+#include <avx512cdintrin.h>
+#include <avx512vlintrin.h>
+#include <avx512bwintrin.h>
+#include <avx512dqintrin.h>
+#include <avx512vlbwintrin.h>
+#include <avx512vldqintrin.h>
+#endif
 #else
+/* 256-bit operations are emulated with pairs of SSE instructions */
 #include <simd/avxintrin-emu.h>
 #define __AVX__
+#define SIMD_AVX_EMULATION
 #endif
-#elif defined(__ARM_NEON__)
+#elif defined(__SSE2__)
+/* SSE2 is the x86-64 baseline, the generic tier relies on it */
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
 #include <arm_neon.h>
+/* AArch64 compilers define only __ARM_NEON, Advanced SIMD is mandatory there
+ * and the NEON code paths are a subset of it */
+#ifndef __ARM_NEON__
+#define __ARM_NEON__
+#endif
 #endif
 
-#ifdef __AVX__
+#if defined(__i386__) || defined(__x86_64__)
 
 #ifndef __xgetbv
 static __attribute__((always_inline)) inline unsigned long long __xgetbv() {
-#if defined(__GNUC__) && __GNUC_PREREQ(4, 4)
+#if defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 4))
   unsigned int index = 0;
   unsigned int eax, edx;
   __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
@@ -84,6 +111,10 @@ static __attribute__((always_inline)) inline unsigned long long __xgetbv() {
 }
 #endif  // __xgetbv
 
+#endif  // defined(__i386__) || defined(__x86_64__)
+
+#ifdef __AVX__
+
 #if defined(__cplusplus) && \
   __GNUC__ == 4 && __GNUC_MINOR__ < 8 && !defined(__clang__)
 
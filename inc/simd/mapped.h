@@ -0,0 +1,143 @@
+/*! @file mapped.h
+ *  @brief Out-of-core processing of the memory mapped signals.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef INC_SIMD_MAPPED_H_
+#define INC_SIMD_MAPPED_H_
+
+#include <stddef.h>
+#include <simd/common.h>
+#include <simd/detect_peaks.h>
+#include <simd/wavelet_types.h>
+
+SIMD_API_BEGIN
+
+/// @brief The default number of samples processed at once by the functions
+/// below, when 0 is passed.
+#define MAPPED_DEFAULT_CHUNK (1 << 16)
+
+/// @brief A file of raw native endian float-s mapped into memory.
+typedef struct {
+  /// The samples, NULL if the file is empty.
+  float *data;
+  /// The number of the samples.
+  size_t length;
+  /// The file descriptor.
+  int fd;
+  /// Nonzero if data may be written to.
+  int writable;
+} MappedSignal;
+
+/// @brief Maps the existing file of float-s.
+/// @param path The path to the file.
+/// @param writable If nonzero, the changes of data are written to the file.
+/// @param signal The resulting mapping.
+/// @return 0 on success, otherwise -1 and errno is set.
+int mapped_signal_open(const char *path, int writable, MappedSignal *signal)
+    NOTNULL(1, 3);
+
+/// @brief Creates or truncates the file to hold length float-s and maps it
+/// for writing.
+/// @param path The path to the file.
+/// @param length The number of the samples.
+/// @param signal The resulting mapping.
+/// @return 0 on success, otherwise -1 and errno is set.
+int mapped_signal_create(const char *path, size_t length,
+                         MappedSignal *signal) NOTNULL(1, 3);
+
+/// @brief Unmaps the signal and closes the file.
+void mapped_signal_close(MappedSignal *signal) NOTNULL(1);
+
+/// @brief Drops the pages of the samples offset..offset+length-1 from the
+/// resident memory of the process. The changes stay in the page cache and
+/// are written to the file, the next access reads them again.
+/// @details The functions below call it for every processed chunk, so that
+/// the resident memory stays bounded by the chunk size.
+void mapped_signal_release(const MappedSignal *signal, size_t offset,
+                           size_t length) NOTNULL(1);
+
+/// @brief Calculates the linear convolution of the mapped signal with
+/// the filter, chunk by chunk.
+/// @param x The signal.
+/// @param h The filter.
+/// @param hLength The length of the filter.
+/// @param result The resulting signal of length x->length + hLength - 1,
+/// e.g. from mapped_signal_create().
+/// @param chunkLength The number of samples convolved at once, 0 means
+/// MAPPED_DEFAULT_CHUNK.
+/// @details The chunks go through convolve_stream_process(), which keeps
+/// the last hLength - 1 samples of the previous chunk, so the result is
+/// the same as of convolve() up to the float rounding. The memory used
+/// is O(chunkLength + hLength).
+void convolve_mapped(const MappedSignal *x, const float *h, size_t hLength,
+                     const MappedSignal *result, size_t chunkLength)
+    NOTNULL(1, 2, 4);
+
+/// @brief Performs a single wavelet transform of the mapped signal, chunk
+/// by chunk.
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param ext The way to extend the signal.
+/// @param src The signal of even length.
+/// @param desthi The highpass part of the result, src->length / 2 long.
+/// @param destlo The lowpass part of the result, src->length / 2 long.
+/// @param chunkLength The number of the source samples transformed at
+/// once, 0 means MAPPED_DEFAULT_CHUNK.
+/// @details Every chunk is read together with the next order - 2 samples,
+/// and the last one with the extension of the whole signal, so the result
+/// is equal to wavelet_apply_na(). Neither wavelet_prepare_array() nor
+/// a copy of the signal is needed.
+void wavelet_apply_mapped(WaveletType type, int order, ExtensionType ext,
+                          const MappedSignal *src,
+                          const MappedSignal *desthi,
+                          const MappedSignal *destlo, size_t chunkLength)
+    NOTNULL(4, 5, 6);
+
+/// @brief Extracts the extrema from the mapped signal, chunk by chunk.
+/// @param simd Value indicating whether to use SIMD acceleration.
+/// @param data The signal, at most INT_MAX samples long since the positions
+/// of ExtremumPoint are int-s.
+/// @param type The type of the extracted extrema.
+/// @param chunkLength The number of the samples scanned at once, 0 means
+/// MAPPED_DEFAULT_CHUNK.
+/// @param results The pointer to the array of ExtremumPoint-s, see
+/// detect_peaks().
+/// @param resultsLength The number of found extremum points.
+/// @details The chunks go through detect_peaks_stream_push(), so the
+/// extrema at the borders of the chunks are found and the result is equal
+/// to detect_peaks().
+void detect_peaks_mapped(int simd, const MappedSignal *data,
+                         ExtremumType type, size_t chunkLength,
+                         ExtremumPoint **results, size_t *resultsLength)
+    NOTNULL(2, 5, 6);
+
+SIMD_API_END
+
+#endif  // INC_SIMD_MAPPED_H_
@@ -32,11 +32,55 @@
 #define INC_SIMD_MATRIX_H_
 
 #include <stddef.h>
+#include <stdint.h>
 #include <simd/common.h>
 #include <simd/attributes.h>
+#include <simd/thread_pool.h>
 
 SIMD_API_BEGIN
 
+/// @brief The activation function of MatrixEpilogue.
+typedef enum {
+  /// y = x.
+  kMatrixActivationNone,
+  /// y = max(x, 0).
+  kMatrixActivationReLU,
+  /// y = 1 / (1 + exp(-x)), see sigmoid_psv().
+  kMatrixActivationSigmoid,
+  /// y = tanh(x), see tanh_psv().
+  kMatrixActivationTanh
+} MatrixActivation;
+
+/// @brief The element-wise operations which matrix_multiply_fused() applies
+/// to the product, res = activation(scale * m1 * m2 + bias).
+typedef struct {
+  /// The multiplier of the product.
+  float scale;
+  /// The vector which is added to every row of the scaled product, of
+  /// length equal to the width of the result. It may be NULL.
+  const float *bias;
+  /// The function which is applied last. sigmoid and tanh follow the
+  /// accuracy tier chosen by mathfun_set_accuracy().
+  MatrixActivation activation;
+} MatrixEpilogue;
+
+/// @brief The sparse matrix in the compressed sparse row (CSR) format.
+/// @details The nonzero values of row i are
+/// values[row_starts[i]] ... values[row_starts[i + 1] - 1] and lie in the
+/// corresponding columns. See matrix_to_csr().
+typedef struct {
+  /// The number of columns.
+  size_t width;
+  /// The number of rows.
+  size_t height;
+  /// The offsets of the rows in columns and values, of length height + 1.
+  const int *row_starts;
+  /// The column indices of the nonzero values.
+  const int *columns;
+  /// The nonzero values.
+  const float *values;
+} CSRMatrix;
+
 /// @brief Sums two matrices.
 /// @param simd Value which indicates whether to use SIMD acceleration or not.
 /// @param m1 The first matrix.
@@ -83,11 +127,364 @@ void matrix_multiply(int simd, const float *m1, const float *m2,
 /// in original matrix.
 /// @param res The resulting matrix, of size h2 x h1.
 /// @pre w1 must be equal to w2.
-/// @note This function typically performs 10% faster than matrix_multiply().
 void matrix_multiply_transposed(int simd, const float *m1, const float *m2,
                                 size_t w1, size_t h1, size_t w2, size_t h2,
                                 float *res) NOTNULL(2,3,8);
 
+/// @brief Multiplies two matrices and accumulates the result,
+/// res = alpha * m1 * m2 + beta * res.
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// @param m1 The first matrix in row-major format.
+/// @param m2 The seconds matrix in row-major format.
+/// @param w1 The width of the first matrix (the number of columns).
+/// @param h1 The height of the first matrix (the number of rows).
+/// @param w2 The width of the second matrix (the number of columns).
+/// @param h2 The height of the second matrix (the number of rows).
+/// @param alpha The multiplier of the product.
+/// @param beta The multiplier of the previous contents of res. If it is 0,
+/// res is not read, so it may contain anything, e.g. NaN-s.
+/// @param res The resulting matrix, of size w2 x h1.
+/// @pre w1 must be equal to h2.
+void matrix_multiply_accumulate(int simd, const float *m1, const float *m2,
+                                size_t w1, size_t h1, size_t w2, size_t h2,
+                                float alpha, float beta,
+                                float *res) NOTNULL(2,3,10);
+
+/// @brief Multiplies two matrices, the second one being stored transposed,
+/// and accumulates the result, res = alpha * m1 * m2^T + beta * res.
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// @param m1 The first matrix in row-major format.
+/// @param m2 The seconds matrix in row-major format.
+/// @param w1 The width of the first matrix (the number of columns).
+/// @param h1 The height of the first matrix (the number of rows).
+/// @param w2 The width of the second (transposed) matrix
+/// (the number of columns).
+/// @param h2 The height of the second (transposed) matrix
+/// (the number of rows).
+/// @param alpha The multiplier of the product.
+/// @param beta The multiplier of the previous contents of res. If it is 0,
+/// res is not read.
+/// @param res The resulting matrix, of size h2 x h1.
+/// @pre w1 must be equal to w2.
+void matrix_multiply_transposed_accumulate(int simd, const float *m1,
+                                           const float *m2,
+                                           size_t w1, size_t h1,
+                                           size_t w2, size_t h2,
+                                           float alpha, float beta,
+                                           float *res) NOTNULL(2,3,10);
+
+/// @brief Multiplies two matrices and applies the epilogue,
+/// res = activation(scale * m1 * m2 + bias).
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// @param m1 The first matrix in row-major format.
+/// @param m2 The seconds matrix in row-major format.
+/// @param w1 The width of the first matrix (the number of columns).
+/// @param h1 The height of the first matrix (the number of rows).
+/// @param w2 The width of the second matrix (the number of columns).
+/// @param h2 The height of the second matrix (the number of rows).
+/// @param epilogue The scale, the bias of length w2 and the activation.
+/// @param res The resulting matrix, of size w2 x h1.
+/// @details The epilogue is applied by the micro kernel while the block of
+/// the result is still in registers, so there are no extra passes over
+/// res.
+/// @pre w1 must be equal to h2.
+void matrix_multiply_fused(int simd, const float *m1, const float *m2,
+                           size_t w1, size_t h1, size_t w2, size_t h2,
+                           const MatrixEpilogue *epilogue,
+                           float *res) NOTNULL(2,3,8,9);
+
+/// @brief Multiplies two matrices, the second one being stored transposed,
+/// and applies the epilogue, res = activation(scale * m1 * m2^T + bias).
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// @param m1 The first matrix in row-major format.
+/// @param m2 The seconds matrix in row-major format.
+/// @param w1 The width of the first matrix (the number of columns).
+/// @param h1 The height of the first matrix (the number of rows).
+/// @param w2 The width of the second (transposed) matrix
+/// (the number of columns).
+/// @param h2 The height of the second (transposed) matrix
+/// (the number of rows).
+/// @param epilogue The scale, the bias of length h2 and the activation.
+/// @param res The resulting matrix, of size h2 x h1.
+/// @pre w1 must be equal to w2.
+void matrix_multiply_transposed_fused(int simd, const float *m1,
+                                      const float *m2,
+                                      size_t w1, size_t h1,
+                                      size_t w2, size_t h2,
+                                      const MatrixEpilogue *epilogue,
+                                      float *res) NOTNULL(2,3,8,9);
+
+/// @brief Multiplies many pairs of small matrices of the same shape,
+/// res[i] = m1[i] * m2[i].
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// @param m1 The first matrices in row-major format, stored one after
+/// another.
+/// @param m2 The second matrices in row-major format, stored one after
+/// another.
+/// @param w1 The width of the first matrices (the number of columns).
+/// @param h1 The height of the first matrices (the number of rows).
+/// @param w2 The width of the second matrices (the number of columns).
+/// @param h2 The height of the second matrices (the number of rows).
+/// @param count The number of the products.
+/// @param res The resulting matrices, of size w2 x h1 each, stored one
+/// after another.
+/// @details The kernel is chosen once for the whole batch. The products
+/// with w1 * w2 up to 4096 (e.g. 32x32 by 32x32) are calculated without
+/// packing the operands, so unlike matrix_multiply() there is no
+/// per-call allocation.
+/// @pre w1 must be equal to h2.
+void matrix_multiply_batch(int simd, const float *m1, const float *m2,
+                           size_t w1, size_t h1, size_t w2, size_t h2,
+                           size_t count, float *res) NOTNULL(2,3,9);
+
+/// @brief Multiplies the matrix by the vector and accumulates the result,
+/// res = alpha * m * v + beta * res.
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// @param m The matrix in row-major format.
+/// @param v The vector of length w.
+/// @param w The width of the matrix (the number of columns).
+/// @param h The height of the matrix (the number of rows).
+/// @param alpha The multiplier of the product, pass 1 for the plain product.
+/// @param beta The multiplier of the previous contents of res. If it is 0,
+/// res is not read.
+/// @param res The resulting vector of length h.
+void matrix_vector_multiply(int simd, const float *m, const float *v,
+                            size_t w, size_t h, float alpha, float beta,
+                            float *res) NOTNULL(2,3,8);
+
+/// @brief Multiplies the transposed matrix by the vector and accumulates
+/// the result, res = alpha * m^T * v + beta * res.
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// @param m The matrix in row-major format (not transposed).
+/// @param v The vector of length h.
+/// @param w The width of the matrix (the number of columns).
+/// @param h The height of the matrix (the number of rows).
+/// @param alpha The multiplier of the product, pass 1 for the plain product.
+/// @param beta The multiplier of the previous contents of res. If it is 0,
+/// res is not read.
+/// @param res The resulting vector of length w.
+void matrix_vector_multiply_transposed(int simd, const float *m,
+                                       const float *v, size_t w, size_t h,
+                                       float alpha, float beta,
+                                       float *res) NOTNULL(2,3,8);
+
+/// @brief Transposes the matrix.
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// @param m The matrix in row-major format.
+/// @param w The width of the matrix (the number of columns).
+/// @param h The height of the matrix (the number of rows).
+/// @param res The resulting matrix, of size h x w. It must not overlap
+/// with m.
+/// @details The matrix is processed in cache sized tiles which are
+/// transposed 8x8 (AVX) or 4x4 (NEON) blocks at a time in registers.
+void matrix_transpose(int simd, const float *m, size_t w, size_t h,
+                      float *res) NOTNULL(2,5);
+
+/// @brief Transposes the matrix in place.
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// @param m The matrix in row-major format. It becomes h x w.
+/// @param w The width of the matrix (the number of columns).
+/// @param h The height of the matrix (the number of rows).
+/// @details Square matrices are transposed by swapping the symmetric
+/// blocks, the rest are transposed into a temporary copy.
+void matrix_transpose_inplace(int simd, float *m, size_t w,
+                              size_t h) NOTNULL(2);
+
+/// @brief Multiplies two int16 matrices with int32 accumulation.
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// @param m1 The first matrix in row-major format.
+/// @param m2 The seconds matrix in row-major format.
+/// @param w1 The width of the first matrix (the number of columns).
+/// @param h1 The height of the first matrix (the number of rows).
+/// @param w2 The width of the second matrix (the number of columns).
+/// @param h2 The height of the second matrix (the number of rows).
+/// @param res The resulting matrix, of size w2 x h1.
+/// @details The sums wrap around on int32 overflow. The only pair of
+/// adjacent products which overflows by itself is
+/// (-32768) * (-32768) + (-32768) * (-32768).
+/// @pre w1 must be equal to h2.
+void matrix_multiply_int16(int simd, const int16_t *m1, const int16_t *m2,
+                           size_t w1, size_t h1, size_t w2, size_t h2,
+                           int32_t *res) NOTNULL(2,3,8);
+
+/// @brief Multiplies two int8 matrices with int32 accumulation.
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// @param m1 The first matrix in row-major format.
+/// @param m2 The seconds matrix in row-major format.
+/// @param w1 The width of the first matrix (the number of columns).
+/// @param h1 The height of the first matrix (the number of rows).
+/// @param w2 The width of the second matrix (the number of columns).
+/// @param h2 The height of the second matrix (the number of rows).
+/// @param res The resulting matrix, of size w2 x h1.
+/// @details The whole int8 range is supported, including -128. The
+/// operands are widened to int16 while being packed and go through the
+/// same kernel as matrix_multiply_int16().
+/// @pre w1 must be equal to h2.
+void matrix_multiply_int8(int simd, const int8_t *m1, const int8_t *m2,
+                          size_t w1, size_t h1, size_t w2, size_t h2,
+                          int32_t *res) NOTNULL(2,3,8);
+
+/// @brief Converts the int32 result of the integer product to float,
+/// res = scale * src + bias.
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// @param src The matrix in row-major format.
+/// @param w The width of the matrix (the number of columns).
+/// @param h The height of the matrix (the number of rows).
+/// @param scale The multiplier, usually the product of the scales of the
+/// quantized operands.
+/// @param bias The vector of length w which is added to every row. It may
+/// be NULL.
+/// @param res The resulting matrix of the same size. It may be the same as
+/// src.
+void matrix_requantize_float(int simd, const int32_t *src, size_t w,
+                             size_t h, float scale, const float *bias,
+                             float *res) NOTNULL(2,7);
+
+/// @brief Converts the int32 result of the integer product to int8,
+/// res = saturate(round(scale * src + bias)).
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// @param src The matrix in row-major format.
+/// @param w The width of the matrix (the number of columns).
+/// @param h The height of the matrix (the number of rows).
+/// @param scale The multiplier, usually the product of the scales of the
+/// quantized operands divided by the scale of the result.
+/// @param bias The vector of length w which is added to every row before
+/// rounding. It may be NULL.
+/// @param res The resulting matrix of the same size.
+/// @details The values are rounded to the nearest even and saturated to
+/// [-128, 127].
+void matrix_requantize_int8(int simd, const int32_t *src, size_t w, size_t h,
+                            float scale, const float *bias,
+                            int8_t *res) NOTNULL(2,7);
+
+/// @brief Counts the nonzero elements of the dense matrix.
+/// @param m The matrix in row-major format.
+/// @param w The width of the matrix (the number of columns).
+/// @param h The height of the matrix (the number of rows).
+/// @return The number of nonzero elements, the length of the CSR arrays.
+size_t matrix_count_nonzero(const float *m, size_t w, size_t h) NOTNULL(1);
+
+/// @brief Converts the dense matrix to the compressed sparse row format.
+/// @param m The matrix in row-major format.
+/// @param w The width of the matrix (the number of columns).
+/// @param h The height of the matrix (the number of rows).
+/// @param row_starts The resulting row offsets, of length h + 1.
+/// @param columns The resulting column indices, of length
+/// matrix_count_nonzero().
+/// @param values The resulting nonzero values, of the same length.
+void matrix_to_csr(const float *m, size_t w, size_t h, int *row_starts,
+                   int *columns, float *values) NOTNULL(1,4);
+
+/// @brief Multiplies the sparse matrix by the dense vector, res = m * v.
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// @param m The sparse matrix.
+/// @param v The vector of length m->width.
+/// @param res The resulting vector of length m->height.
+/// @details The elements of v are fetched with gathers where the CPU has
+/// them (AVX2), only the nonzero values are visited.
+void matrix_csr_vector_multiply(int simd, const CSRMatrix *m, const float *v,
+                                float *res) NOTNULL(2,3,4);
+
+/// @brief Multiplies the sparse matrix by the dense one, res = m1 * m2.
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// @param m1 The sparse matrix.
+/// @param m2 The dense matrix in row-major format, of height m1->width.
+/// @param w2 The width of m2 (the number of columns).
+/// @param res The resulting matrix, of size w2 x m1->height.
+/// @details Every row of the result is the linear combination of the rows
+/// of m2 selected by the nonzero values, it is accumulated in registers.
+void matrix_csr_multiply(int simd, const CSRMatrix *m1, const float *m2,
+                         size_t w2, float *res) NOTNULL(2,3,5);
+
+/// @brief Multiplies the square banded matrix by the vector, res = m * v.
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// @param diagonals The diagonals of the matrix, lower + upper + 1 rows of
+/// length n, m[i][i + d] is diagonals[(d + lower) * n + i]. The elements
+/// which fall outside of the matrix are ignored.
+/// @param n The size of the matrix.
+/// @param lower The number of the subdiagonals.
+/// @param upper The number of the superdiagonals.
+/// @param v The vector of length n.
+/// @param res The resulting vector of length n.
+/// @details E.g., the FIR filter as the Toeplitz matrix has the constant
+/// diagonals. The cost is O(n * (lower + upper + 1)).
+void matrix_banded_vector_multiply(int simd, const float *diagonals,
+                                   size_t n, int lower, int upper,
+                                   const float *v, float *res)
+    NOTNULL(2,6,7);
+
+/// @brief Multiplies the square banded matrix by the dense one,
+/// res = m1 * m2.
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// @param diagonals The diagonals of m1, see
+/// matrix_banded_vector_multiply().
+/// @param n The size of m1.
+/// @param lower The number of the subdiagonals.
+/// @param upper The number of the superdiagonals.
+/// @param m2 The dense matrix in row-major format, of height n.
+/// @param w2 The width of m2 (the number of columns).
+/// @param res The resulting matrix, of size w2 x n.
+void matrix_banded_multiply(int simd, const float *diagonals, size_t n,
+                            int lower, int upper, const float *m2,
+                            size_t w2, float *res) NOTNULL(2,6,8);
+
+/// @brief Multiplies two matrices on several threads and accumulates the
+/// result, res = alpha * m1 * m2 + beta * res.
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// Without it the product is calculated on the calling thread.
+/// @param pool The thread pool to run on. If it is NULL, the default one is
+/// taken, see thread_pool_default().
+/// @param threads The maximal number of threads to use, including the
+/// calling one. If it is 0, all the threads of the pool are used.
+/// @param m1 The first matrix in row-major format.
+/// @param m2 The seconds matrix in row-major format.
+/// @param w1 The width of the first matrix (the number of columns).
+/// @param h1 The height of the first matrix (the number of rows).
+/// @param w2 The width of the second matrix (the number of columns).
+/// @param h2 The height of the second matrix (the number of rows).
+/// @param alpha The multiplier of the product, pass 1 for the plain product.
+/// @param beta The multiplier of the previous contents of res, pass 0 for
+/// the plain product.
+/// @param res The resulting matrix, of size w2 x h1.
+/// @details The resulting matrix is split into the tiles which are
+/// calculated independently, the small products are not split at all.
+/// @pre w1 must be equal to h2.
+void matrix_multiply_parallel(int simd, ThreadPool *pool, int threads,
+                              const float *m1, const float *m2,
+                              size_t w1, size_t h1, size_t w2, size_t h2,
+                              float alpha, float beta,
+                              float *res) NOTNULL(4,5,12);
+
+/// @brief Multiplies two matrices on several threads, the second one being
+/// stored transposed, and accumulates the result,
+/// res = alpha * m1 * m2^T + beta * res.
+/// @param simd Value which indicates whether to use SIMD acceleration or not.
+/// Without it the product is calculated on the calling thread.
+/// @param pool The thread pool to run on. If it is NULL, the default one is
+/// taken, see thread_pool_default().
+/// @param threads The maximal number of threads to use, including the
+/// calling one. If it is 0, all the threads of the pool are used.
+/// @param m1 The first matrix in row-major format.
+/// @param m2 The seconds matrix in row-major format.
+/// @param w1 The width of the first matrix (the number of columns).
+/// @param h1 The height of the first matrix (the number of rows).
+/// @param w2 The width of the second (transposed) matrix
+/// (the number of columns).
+/// @param h2 The height of the second (transposed) matrix
+/// (the number of rows).
+/// @param alpha The multiplier of the product, pass 1 for the plain product.
+/// @param beta The multiplier of the previous contents of res, pass 0 for
+/// the plain product.
+/// @param res The resulting matrix, of size h2 x h1.
+/// @pre w1 must be equal to w2.
+void matrix_multiply_transposed_parallel(int simd, ThreadPool *pool,
+                                         int threads,
+                                         const float *m1, const float *m2,
+                                         size_t w1, size_t h1,
+                                         size_t w2, size_t h2,
+                                         float alpha, float beta,
+                                         float *res) NOTNULL(4,5,12);
+
 SIMD_API_END
 
 #endif  // INC_SIMD_MATRIX_H_
@@ -31,15 +31,14 @@
 #ifndef INC_SIMD_MEMORY_H_
 #define INC_SIMD_MEMORY_H_
 
+#include <stdint.h>
 #include <string.h>
 #include <simd/common.h>
 #include <simd/attributes.h>
+#include <simd/instruction_set.h>
 
 SIMD_API_BEGIN
 
-#ifdef __AVX__
-#include <stdint.h>  // NOLINT(build/include_order)
-
 /// @brief Returns the alignment complement of a pointer to a floating point
 /// number array.
 /// @param ptr The pointer to a floating point number array.
@@ -84,19 +83,20 @@ int align_complement_i32(const int32_t *ptr) NOTNULL(1);
 /// @endcode
 /// else 0.
 int align_complement_u32(const uint32_t *ptr) NOTNULL(1);
-#endif
 
 /// @brief Allocates an aligned block in the memory.
 /// @param size The size of the new block in bytes.
 /// @return The newly allocated memory aligned to 32 or 64 bytes (depending on
-/// SIMD variant)which should be disposed with free().
+/// SIMD variant) which should be disposed with free_aligned(). free() is
+/// fine as well unless a custom allocator is installed, see SimdAllocator.
 void *malloc_aligned(size_t size) MALLOC;
 
 /// @brief Allocates a block in the memory with the specified offset relative
 /// to 32 or 64 bytes alignment (depending on SIMD variant).
 /// @param size The size of the new block in bytes.
 /// @param offset The alignment offset in bytes.
-/// @return The newly allocated memory which should be disposed with free().
+/// @return The newly allocated memory which should be disposed with
+/// free_aligned() of the pointer minus offset.
 void *malloc_aligned_offset(size_t size, int offset) MALLOC;
 
 /// @brief Allocates an array of floating point numbers aligned to
@@ -105,6 +105,121 @@ void *malloc_aligned_offset(size_t size, int offset) MALLOC;
 /// in bytes).
 float *mallocf(size_t length) MALLOC;
 
+/// @brief The size of a transparent huge page on x86-64 and AArch64 Linux.
+#define SIMD_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/// @brief The hints for malloc_aligned_ex(), they can be or-ed.
+typedef enum {
+  kMemoryFlagNone = 0,
+  /// Backs the block with transparent huge pages (madvise(MADV_HUGEPAGE))
+  /// to reduce the TLB misses. It is ignored for the blocks smaller than
+  /// SIMD_HUGE_PAGE_SIZE.
+  kMemoryFlagHugePages = 1,
+  /// Zeroes the block in parallel on thread_pool_default(), so that its pages
+  /// are distributed among the NUMA nodes of the threads which are going to
+  /// process the corresponding parts.
+  kMemoryFlagFirstTouch = 2
+} MemoryFlags;
+
+/// @brief Requests malloc_aligned_ex() to bind the pages of the block to
+/// the specified NUMA node, e.g. kMemoryFlagHugePages | MEMORY_NUMA_NODE(1).
+#define MEMORY_NUMA_NODE(node) (((node) + 1) << 8)
+
+/// @brief Allocates an aligned block in the memory with the placement hints.
+/// @param size The size of the new block in bytes.
+/// @param flags The combination of MemoryFlags and MEMORY_NUMA_NODE().
+/// @return The newly allocated memory aligned to at least 64 bytes which
+/// should be disposed with free_aligned().
+/// @details The hints are applied only with the default allocator (see
+/// SimdAllocator) and they are silently dropped if the system does not
+/// support them, so the call never fails because of them. The library
+/// allocates its large internal buffers with kMemoryFlagHugePages.
+/// @note kMemoryFlagFirstTouch runs the tasks on thread_pool_default(), so
+/// it must not be used from inside them.
+void *malloc_aligned_ex(size_t size, int flags) MALLOC;
+
+/// @brief Allocates an array of floating point numbers with
+/// malloc_aligned_ex().
+/// @param length The length of the block to allocate (in float-s, not
+/// in bytes).
+/// @param flags The combination of MemoryFlags and MEMORY_NUMA_NODE().
+float *mallocf_ex(size_t length, int flags) MALLOC;
+
+/// @brief Disposes the memory returned by malloc_aligned(), mallocf(),
+/// zeropadding() or zeropaddingex().
+/// @param ptr The pointer to release, may be NULL.
+/// @details It calls the release callback of the current allocator, that is,
+/// free() unless simd_set_allocator() or simd_set_thread_allocator() has
+/// installed another one.
+void free_aligned(void *ptr);
+
+/// @brief The set of callbacks which malloc_aligned() and free_aligned() are
+/// routed to. The library allocates its temporaries and the buffers owned by
+/// the handles (e.g. ConvolutionHandle) through them, too.
+typedef struct {
+  /// @brief Returns a block of size bytes aligned to alignment bytes, or NULL.
+  void *(*allocate)(size_t size, size_t alignment, void *context);
+  /// @brief Disposes a block previously returned by allocate, never NULL.
+  void (*release)(void *ptr, void *context);
+  /// @brief The opaque value passed to both callbacks.
+  void *context;
+} SimdAllocator;
+
+/// @brief Installs the allocator for all the threads which do not have
+/// their own one set with simd_set_thread_allocator().
+/// @param allocator The callbacks to use, they are copied. NULL restores
+/// the default posix_memalign() / free() pair.
+/// @note While a custom allocator is active, the memory must be disposed with
+/// free_aligned() and the handles must be finalized under the same allocator
+/// they were initialized with.
+/// @note This function is not thread safe with regard to the running
+/// allocations and is intended to be called during the program start.
+void simd_set_allocator(const SimdAllocator *allocator);
+
+/// @brief Installs the allocator for the calling thread only, it takes
+/// precedence over the one set with simd_set_allocator().
+/// @param allocator The callbacks to use, they are copied. NULL falls back
+/// to the global allocator.
+void simd_set_thread_allocator(const SimdAllocator *allocator);
+
+/// @brief Returns the allocator in effect for the calling thread.
+const SimdAllocator *simd_allocator(void);
+
+/// @brief The opaque bump (linear) memory arena.
+typedef struct SimdArena SimdArena;
+
+/// @brief Creates a new arena.
+/// @param capacity The initial size of the arena in bytes. When it is
+/// exhausted, the arena grows by allocating additional chunks.
+/// @return The new arena which should be disposed with simd_arena_destroy().
+SimdArena *simd_arena_create(size_t capacity) MALLOC;
+
+/// @brief Releases all the blocks allocated from the arena at once.
+/// @details If the arena had to grow since the last reset, its chunks are
+/// merged into a single one large enough to hold them all, so that repeating
+/// the same sequence of allocations does not touch the system allocator.
+void simd_arena_reset(SimdArena *arena) NOTNULL(1);
+
+/// @brief Disposes the arena and all the memory allocated from it.
+void simd_arena_destroy(SimdArena *arena);
+
+/// @brief Returns the number of bytes currently allocated from the arena,
+/// including the alignment padding.
+size_t simd_arena_used(const SimdArena *arena) NOTNULL(1);
+
+/// @brief Returns the allocator which takes the blocks from the arena.
+/// @details The release callback frees the block only if it was the last
+/// one taken, otherwise the space is reclaimed by simd_arena_reset().
+/// Typical request-scoped usage:
+/// @code
+/// simd_set_thread_allocator(simd_arena_allocator(arena));
+/// ... process the request ...
+/// simd_set_thread_allocator(NULL);
+/// simd_arena_reset(arena);
+/// @endcode
+/// @note An arena must not be used by several threads simultaneously.
+const SimdAllocator *simd_arena_allocator(SimdArena *arena) NOTNULL(1);
+
 /// @brief Sets the contents of a floating point array to the specified value.
 /// @param ptr The array of floating point numbers.
 /// @param value The value to set for all of the array content.
@@ -116,17 +231,53 @@ float *mallocf(size_t length) MALLOC;
 /// @endcode
 /// So array[i] becomes equal to 1.0f, i = 0..99.
 /// @note This function tries to use SIMD instructions available on the host.
+/// The arrays larger than memory_streaming_threshold() are filled with
+/// non-temporal stores, see memsetf_stream().
 void memsetf(float *ptr, float value, size_t length) NOTNULL(1);
 
+/// @brief Acts like memsetf(), but always writes with non-temporal
+/// (streaming) stores which bypass the cache.
+/// @details This is faster for the arrays which do not fit into the last
+/// level cache and keeps the data of the next kernel in it. Use it instead
+/// of memsetf() when the array is not going to be read soon.
+void memsetf_stream(float *ptr, float value, size_t length) NOTNULL(1);
+
+/// @brief memcpy() for arrays of floating point numbers which switches to
+/// non-temporal stores for the arrays larger than
+/// memory_streaming_threshold().
+/// @param dest The destination array, it must not overlap with src.
+/// @param src The source array.
+/// @param length The length of the arrays (in float-s, not in bytes).
+/// @return dest.
+float *memcpyf(float *__restrict dest,
+               const float *__restrict src, size_t length) NOTNULL(1, 2);
+
+/// @brief Acts like memcpyf(), but always writes with non-temporal
+/// (streaming) stores, see memsetf_stream().
+float *memcpyf_stream(float *__restrict dest,
+                      const float *__restrict src, size_t length)
+NOTNULL(1, 2);
+
+/// @brief Returns the size in bytes starting from which memsetf() and
+/// memcpyf() use non-temporal stores.
+/// @details By default it is the size of the last level cache reported by
+/// the system, or 8 MiB if it is unknown.
+size_t memory_streaming_threshold(void);
+
+/// @brief Overrides the value returned by memory_streaming_threshold().
+/// @param bytes The new threshold. 0 restores the default one, SIZE_MAX
+/// disables the non-temporal stores in memsetf() and memcpyf().
+void memory_set_streaming_threshold(size_t bytes);
+
 /// @brief Allocates a new aligned memory block of size
-/// (nearest power of 2 greater than length) * 2, the contents in
-/// the difference in lengths being set to zero.
+/// nearest power of 2 greater than or equal to length * 2 - 1, the contents
+/// in the difference in lengths being set to zero.
 /// @param ptr The array of floating point number which will be zero padded.
 /// @param length The length of ptr array (in float-s, not in bytes).
 /// @param newLength The pointer to the variable which will hold
 /// the new length.
 /// @return A newly allocated memory pointer which should be disposed
-/// with usual free().
+/// with free_aligned().
 /// @details Here is an example of what this function does. Suggest we have
 /// a floating point array of length 100:
 /// @code
@@ -138,8 +289,9 @@ void memsetf(float *ptr, float value, size_t length) NOTNULL(1);
 /// float *paddedArray = zeropadding(array, 100, &newLength);
 /// @endcode
 /// Now the following is true:
-/// 1. newLength == 256 (since 256 = 2 * 128 and 128 is the nearest power
-/// of 2 greater than 100).
+/// 1. newLength == 256 (since 256 is the nearest power of 2 greater than
+/// or equal to 199). The linear convolution of two arrays of length 100 fits
+/// into it without aliasing. For length 1024 newLength is 2048.
 /// 2. paddedArray[i] = 0.0f, i = 100..255.
 /// 3. paddedArray is aligned to 32 or 64 bytes (depending on SIMD variant).
 /// Finally, we free the new array:
@@ -159,9 +311,9 @@ NOTNULL(1, 3) MALLOC;
 /// the new length.
 /// @param additionalLength Extra length to be allocated. For example,
 /// if length is 100, additionalLength is 5, *newLength will be
-/// 128 * 2 + 5 = 261 float-s.
+/// 256 and 256 + 5 = 261 float-s will be allocated.
 /// @return A newly allocated memory pointer which should be disposed
-/// with usual free().
+/// with free_aligned().
 /// @note This function tries to use SIMD instructions available on the host.
 float *zeropaddingex(const float *ptr, size_t length, size_t *newLength,
                      size_t additionalLength)
@@ -175,9 +327,69 @@ float *rmemcpyf(float *__restrict dest,
 /// @brief Reverse memcpy() for arrays of floating point complex numbers.
 /// That is, dest[i] = src[n - i - 2], i = 0..(n-1), i += 2;
 /// dest[i + 1] = src[n - i - 1], i = 1..(n-1), i += 2.
+/// @param length The length of the arrays in float-s, it must be even.
+/// @note This function tries to use SIMD instructions available on the host.
 float *crmemcpyf(float *__restrict dest,
                  const float *__restrict src, size_t length) NOTNULL(1, 2);
 
+/// @brief Reverses an array of floating point numbers in place, that is,
+/// the result of rmemcpyf() without a temporary array.
+/// @param ptr The array to reverse.
+/// @param length The length of the array (in float-s, not in bytes).
+/// @note This function tries to use SIMD instructions available on the host.
+void reversef(float *ptr, size_t length) NOTNULL(1);
+
+/// @brief Reverses an array of floating point complex numbers in place, that
+/// is, the result of crmemcpyf() without a temporary array.
+/// @param ptr The array of interleaved real and imaginary parts.
+/// @param length The length of the array in float-s, it must be even.
+/// @note This function tries to use SIMD instructions available on the host.
+void creversef(float *ptr, size_t length) NOTNULL(1);
+
+/// @brief Splits interleaved multichannel samples into planar channels.
+/// That is, dest[c * frames + i] = src[i * channels + c].
+/// @param src The interleaved samples, frames * channels float-s.
+/// @param frames The number of samples in each channel.
+/// @param channels The number of channels. Any number is accepted; the ones
+/// which are multiples of 2 (stereo, 4.0, 5.1, 7.1) are fully vectorized.
+/// @param dest The planar channels stored one after another,
+/// frames * channels float-s.
+/// @note This function tries to use SIMD instructions available on the host.
+void deinterleavef(const float *__restrict src, size_t frames, int channels,
+                   float *__restrict dest) NOTNULL(1, 4);
+
+/// @brief Merges planar channels into interleaved multichannel samples.
+/// That is, dest[i * channels + c] = src[c * frames + i].
+/// @param src The planar channels stored one after another,
+/// frames * channels float-s.
+/// @param frames The number of samples in each channel.
+/// @param channels The number of channels, see deinterleavef().
+/// @param dest The interleaved samples, frames * channels float-s.
+/// @note This function tries to use SIMD instructions available on the host.
+void interleavef(const float *__restrict src, size_t frames, int channels,
+                 float *__restrict dest) NOTNULL(1, 4);
+
+/// @brief The same as deinterleavef(), but for short integers.
+void deinterleave_i16(const int16_t *__restrict src, size_t frames,
+                      int channels, int16_t *__restrict dest) NOTNULL(1, 4);
+
+/// @brief The same as interleavef(), but for short integers.
+void interleave_i16(const int16_t *__restrict src, size_t frames,
+                    int channels, int16_t *__restrict dest) NOTNULL(1, 4);
+
+/// @brief Splits interleaved short integer samples into planar floating
+/// point channels, converting them as int16_to_float() does.
+/// That is, dest[c * frames + i] = src[i * channels + c].
+/// @param src The interleaved samples, frames * channels int16_t-s.
+/// @param frames The number of samples in each channel.
+/// @param channels The number of channels, see deinterleavef().
+/// @param dest The planar channels stored one after another,
+/// frames * channels float-s.
+/// @note This function tries to use SIMD instructions available on the host.
+void deinterleave_i16_to_float(const int16_t *__restrict src, size_t frames,
+                               int channels, float *__restrict dest)
+NOTNULL(1, 4);
+
 SIMD_API_END
 
 #endif  // INC_SIMD_MEMORY_H_
@@ -23,6 +23,9 @@
   3. This notice may not be removed or altered from any source distribution.
 
   (this is the zlib license)
+
+  Altered for libSimd: div_ps, tanh_ps, sigmoid_ps and the fast accuracy
+  tier.
 */
 
 #ifndef INC_SIMD_NEON_MATHFUN_H_
@@ -331,6 +334,170 @@ static inline v4sf sqrt_ps(v4sf val) {
   return est;
 }
 
+/* a / b, two Newton-Raphson steps refine the reciprocal estimate on ARMv7 */
+static inline v4sf div_ps(v4sf a, v4sf b) {
+#ifdef __aarch64__
+  return vdivq_f32(a, b);
+#else
+  v4sf rcp = vrecpeq_f32(b);
+  rcp = vmulq_f32(vrecpsq_f32(b, rcp), rcp);
+  rcp = vmulq_f32(vrecpsq_f32(b, rcp), rcp);
+  return vmulq_f32(a, rcp);
+#endif
+}
+
+#define c_tanh_threshold 0.625f
+#define c_cephes_tanh_p0 -5.70498872745E-3
+#define c_cephes_tanh_p1 2.06390887954E-2
+#define c_cephes_tanh_p2 -5.37397155531E-2
+#define c_cephes_tanh_p3 1.33314422036E-1
+#define c_cephes_tanh_p4 -3.33332819422E-1
+
+/* tanh(x), the rewriting of the cephes tanhf function: the odd polynom for
+   |x| < 0.625 and 1 - 2 / (exp(2|x|) + 1) otherwise */
+static inline v4sf tanh_ps(v4sf x) {
+  v4sf ax = vabsq_f32(x);
+  v4sf z = vmulq_f32(x, x);
+  v4sf y = vdupq_n_f32(c_cephes_tanh_p0);
+  y = vmlaq_f32(vdupq_n_f32(c_cephes_tanh_p1), y, z);
+  y = vmlaq_f32(vdupq_n_f32(c_cephes_tanh_p2), y, z);
+  y = vmlaq_f32(vdupq_n_f32(c_cephes_tanh_p3), y, z);
+  y = vmlaq_f32(vdupq_n_f32(c_cephes_tanh_p4), y, z);
+  y = vmulq_f32(y, z);
+  y = vmlaq_f32(x, y, x);
+
+  v4sf one = vdupq_n_f32(1);
+  v4sf e = exp_ps(vaddq_f32(ax, ax));
+  v4sf t = vsubq_f32(one, div_ps(vdupq_n_f32(2), vaddq_f32(e, one)));
+  /* copy the sign of x */
+  t = vbslq_f32(vdupq_n_u32(0x80000000), x, t);
+  return vbslq_f32(vcltq_f32(ax, vdupq_n_f32(c_tanh_threshold)), y, t);
+}
+
+/* the logistic function 1 / (1 + exp(-x)) */
+static inline v4sf sigmoid_ps(v4sf x) {
+  v4sf one = vdupq_n_f32(1);
+  return div_ps(one, vaddq_f32(exp_ps(vnegq_f32(x)), one));
+}
+
+/* The fast accuracy tier, see exp256_fast_ps() and the following in
+   avx_mathfun.h */
+
+#define c_fast_exp_hi 88.3f
+#define c_fast_exp_lo -87.3f
+#define c_fast_exp2_p0 9.999280735e-01f
+#define c_fast_exp2_p1 6.932609855e-01f
+#define c_fast_exp2_p2 2.426111222e-01f
+#define c_fast_exp2_p3 5.517166907e-02f
+#define c_fast_SQRT2 1.41421356237f
+#define c_fast_LN2 0.693147180560f
+#define c_fast_log_p0 9.999661814e-01f
+#define c_fast_log_p1 -4.994506475e-01f
+#define c_fast_log_p2 3.363888424e-01f
+#define c_fast_log_p3 -2.709459943e-01f
+#define c_fast_log_p4 1.765805420e-01f
+#define c_fast_1_PI 0.318309886184f
+#define c_fast_PI_A 3.140625f
+#define c_fast_PI_B 9.67653589793e-4f
+#define c_fast_sin_p0 9.999990609e-01f
+#define c_fast_sin_p1 -1.666555409e-01f
+#define c_fast_sin_p2 8.311899801e-03f
+#define c_fast_sin_p3 -1.848814029e-04f
+#define c_fast_tanh_threshold 0.3f
+#define c_fast_tanh_p1 -3.333333333e-01f
+#define c_fast_tanh_p2 1.333333333e-01f
+
+/* rounds to the nearest integer, ARMv7 has only the truncating conversion */
+static inline v4si round_ps(v4sf x) {
+  v4sf half = vbslq_f32(vdupq_n_u32(0x80000000), x, vdupq_n_f32(0.5f));
+  return vcvtq_s32_f32(vaddq_f32(x, half));
+}
+
+static inline v4sf exp_fast_ps(v4sf x) {
+  x = vminq_f32(x, vdupq_n_f32(c_fast_exp_hi));
+  x = vmaxq_f32(x, vdupq_n_f32(c_fast_exp_lo));
+  v4sf t = vmulq_f32(x, vdupq_n_f32(c_cephes_LOG2EF));
+  v4si n = round_ps(t);
+  v4sf f = vsubq_f32(t, vcvtq_f32_s32(n));
+  v4sf y = vdupq_n_f32(c_fast_exp2_p3);
+  y = vmlaq_f32(vdupq_n_f32(c_fast_exp2_p2), y, f);
+  y = vmlaq_f32(vdupq_n_f32(c_fast_exp2_p1), y, f);
+  y = vmlaq_f32(vdupq_n_f32(c_fast_exp2_p0), y, f);
+  /* add n to the exponent bits */
+  return vreinterpretq_f32_s32(vaddq_s32(vreinterpretq_s32_f32(y),
+                                         vshlq_n_s32(n, 23)));
+}
+
+/* x must be a normal positive number */
+static inline v4sf log_fast_ps(v4sf x) {
+  v4sf one = vdupq_n_f32(1);
+  v4si ux = vreinterpretq_s32_f32(x);
+  v4sf e = vcvtq_f32_s32(vsubq_s32(vshrq_n_s32(ux, 23), vdupq_n_s32(0x7f)));
+  /* the mantissa in [1, 2) */
+  v4sf m = vreinterpretq_f32_s32(vorrq_s32(
+      vandq_s32(ux, vdupq_n_s32(c_inv_mant_mask)),
+      vreinterpretq_s32_f32(one)));
+  /* if (sqrt(2) < m) { m /= 2; e += 1; } */
+  v4su big = vcgtq_f32(m, vdupq_n_f32(c_fast_SQRT2));
+  m = vbslq_f32(big, vmulq_f32(m, vdupq_n_f32(0.5f)), m);
+  e = vaddq_f32(e, vreinterpretq_f32_u32(vandq_u32(
+      vreinterpretq_u32_f32(one), big)));
+  v4sf u = vsubq_f32(m, one);
+  v4sf y = vdupq_n_f32(c_fast_log_p4);
+  y = vmlaq_f32(vdupq_n_f32(c_fast_log_p3), y, u);
+  y = vmlaq_f32(vdupq_n_f32(c_fast_log_p2), y, u);
+  y = vmlaq_f32(vdupq_n_f32(c_fast_log_p1), y, u);
+  y = vmlaq_f32(vdupq_n_f32(c_fast_log_p0), y, u);
+  return vmlaq_f32(vmulq_f32(y, u), e, vdupq_n_f32(c_fast_LN2));
+}
+
+/* sin(x - shift * Pi) * (-1)^flip */
+static inline v4sf sin_fast_shifted(v4sf x, v4sf shift, v4si flip) {
+  v4si k = round_ps(vsubq_f32(vmulq_f32(x, vdupq_n_f32(c_fast_1_PI)), shift));
+  v4sf kf = vaddq_f32(vcvtq_f32_s32(k), shift);
+  v4sf r = vmlsq_f32(x, kf, vdupq_n_f32(c_fast_PI_A));
+  r = vmlsq_f32(r, kf, vdupq_n_f32(c_fast_PI_B));
+  v4sf z = vmulq_f32(r, r);
+  v4sf y = vdupq_n_f32(c_fast_sin_p3);
+  y = vmlaq_f32(vdupq_n_f32(c_fast_sin_p2), y, z);
+  y = vmlaq_f32(vdupq_n_f32(c_fast_sin_p1), y, z);
+  y = vmlaq_f32(vdupq_n_f32(c_fast_sin_p0), y, z);
+  y = vmulq_f32(y, r);
+  v4si sign = vshlq_n_s32(vaddq_s32(k, flip), 31);
+  return vreinterpretq_f32_s32(veorq_s32(vreinterpretq_s32_f32(y), sign));
+}
+
+static inline v4sf sin_fast_ps(v4sf x) {
+  return sin_fast_shifted(x, vdupq_n_f32(0), vdupq_n_s32(0));
+}
+
+static inline v4sf cos_fast_ps(v4sf x) {
+  return sin_fast_shifted(x, vdupq_n_f32(0.5f), vdupq_n_s32(1));
+}
+
+static inline v4sf tanh_fast_ps(v4sf x) {
+  v4sf one = vdupq_n_f32(1);
+  v4sf ax = vabsq_f32(x);
+  v4sf z = vmulq_f32(x, x);
+  v4sf y = vmlaq_f32(vdupq_n_f32(c_fast_tanh_p1),
+                     vdupq_n_f32(c_fast_tanh_p2), z);
+  y = vmlaq_f32(x, vmulq_f32(y, z), x);
+  v4sf e = exp_fast_ps(vaddq_f32(ax, ax));
+  v4sf t = vsubq_f32(one, div_ps(vdupq_n_f32(2), vaddq_f32(e, one)));
+  t = vbslq_f32(vdupq_n_u32(0x80000000), x, t);
+  return vbslq_f32(vcltq_f32(ax, vdupq_n_f32(c_fast_tanh_threshold)), y, t);
+}
+
+static inline v4sf sigmoid_fast_ps(v4sf x) {
+  v4sf one = vdupq_n_f32(1);
+  return div_ps(one, vaddq_f32(exp_fast_ps(vnegq_f32(x)), one));
+}
+
+/* y^x, y must be a normal positive number */
+static inline v4sf pow_fast_ps(v4sf y, v4sf x) {
+  return exp_fast_ps(vmulq_f32(log_fast_ps(y), x));
+}
+
 #pragma GCC diagnostic pop
 
 #endif  // INC_SIMD_NEON_MATHFUN_H_
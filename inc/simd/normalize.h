@@ -33,9 +33,21 @@
 
 #include <stdint.h>
 #include <simd/common.h>
+#include <simd/attributes.h>
+#include <simd/thread_pool.h>
 
 SIMD_API_BEGIN
 
+/// @brief The element format of the normalized plane.
+typedef enum {
+  /// float, [-1, 1].
+  NORMALIZE_OUTPUT_FLOAT,
+  /// IEEE 754 half precision stored in uint16_t, [-1, 1].
+  NORMALIZE_OUTPUT_FP16,
+  /// int8_t, [-1, 1] scaled by 127 and rounded.
+  NORMALIZE_OUTPUT_INT8
+} NormalizeOutput;
+
 /// @brief Performs the plane normalization [min, max] -> [-1, 1]. Minimum
 /// and maximum is determined from the array.
 /// @param simd Value indicating whether to use available SIMD acceleration.
@@ -78,6 +90,52 @@ void normalize2D_minmax(int simd, uint8_t min, uint8_t max,
                         int width, int height, float *dst, int dst_stride)
     NOTNULL(4, 8);
 
+/// @brief Performs the plane normalization [min, max] -> [-1, 1] with the
+/// known range, e.g. the one of the previous video frame, and finds the
+/// range of this plane in the same pass.
+/// @param simd Value indicating whether to use available SIMD acceleration.
+/// @param min The minimum value to normalize with.
+/// @param max The maximum value to normalize with.
+/// @param src The source byte array, stored in row-major format.
+/// @param src_stride The stride (the actual width) of the plane.
+/// @param width The width of the plane.
+/// @param height The height of the plane.
+/// @param dst The resulting floating point array, the values outside
+/// [min, max] are clamped to -1 or 1.
+/// @param dst_stride The stride of dst.
+/// @param frameMin The pointer to the minimum of src, to be passed with the
+/// next frame. If NULL, it is not returned.
+/// @param frameMax The pointer to the maximum of src, to be passed with the
+/// next frame. If NULL, it is not returned.
+/// @details The plane is processed in the bands of rows which fit in cache,
+/// so each byte is read from memory only once.
+void normalize2D_stream(int simd, uint8_t min, uint8_t max,
+                        const uint8_t *src, int src_stride,
+                        int width, int height, float *dst, int dst_stride,
+                        uint8_t *frameMin, uint8_t *frameMax) NOTNULL(4, 8);
+
+/// @brief The same as normalize2D(), but the bands of rows are processed on
+/// several threads.
+/// @param simd Value indicating whether to use available SIMD acceleration.
+/// @param pool The thread pool to run on. If it is NULL, the default one is
+/// taken, see thread_pool_default().
+/// @param threads The maximal number of threads to use, including the
+/// calling one. If it is 0, all the threads of the pool are used.
+/// @param src The source byte array, stored in row-major format.
+/// @param src_stride The stride (the actual width) of the plane.
+/// @param width The width of the plane.
+/// @param height The height of the plane.
+/// @param dst The resulting floating point array.
+/// @param dst_stride The stride of dst.
+/// @details The exact range must be known before the first value is
+/// written, so the plane is still read twice: the ranges of the bands are
+/// found in parallel and merged, then the bands are normalized in parallel.
+/// The planes below 1 megapixel are not split.
+void normalize2D_parallel(int simd, ThreadPool *pool, int threads,
+                          const uint8_t *src, int src_stride,
+                          int width, int height, float *dst, int dst_stride)
+    NOTNULL(4, 8);
+
 /// @brief Finds the minimum and the maximum value in the specified array.
 /// @param simd Value indicating whether to use available SIMD acceleration.
 /// @param src The source floating point array.
@@ -89,6 +147,162 @@ void normalize2D_minmax(int simd, uint8_t min, uint8_t max,
 void minmax1D(int simd, const float *src, int length, float *min,
               float *max) NOTNULL(2);
 
+/// @brief Finds the minimum and the maximum value in the specified array.
+/// @param simd Value indicating whether to use available SIMD acceleration.
+/// @param src The source array of 16-bit samples, stored in row-major format.
+/// @param src_stride The stride (the actual width) of the plane.
+/// @param width The width of the plane.
+/// @param height The height of the plane.
+/// @param min The pointer to the resulting minimum. If NULL, minimum is not
+/// returned.
+/// @param max The pointer to the resulting maximum. If NULL, maximum is not
+/// returned.
+void minmax2D_uint16(int simd, const uint16_t *src, int src_stride,
+                     int width, int height, uint16_t *min, uint16_t *max)
+    NOTNULL(2);
+
+/// @brief Finds the minimum and the maximum value in the specified array.
+/// @param simd Value indicating whether to use available SIMD acceleration.
+/// @param src The source floating point array, stored in row-major format.
+/// @param src_stride The stride (the actual width) of the plane, in float-s.
+/// @param width The width of the plane.
+/// @param height The height of the plane.
+/// @param min The pointer to the resulting minimum. If NULL, minimum is not
+/// returned.
+/// @param max The pointer to the resulting maximum. If NULL, maximum is not
+/// returned.
+void minmax2D_float(int simd, const float *src, int src_stride,
+                    int width, int height, float *min, float *max)
+    NOTNULL(2);
+
+/// @brief The same as normalize2D(), but writes the plane in the specified
+/// format.
+/// @param simd Value indicating whether to use available SIMD acceleration.
+/// @param src The source byte array, stored in row-major format.
+/// @param src_stride The stride (the actual width) of the plane.
+/// @param width The width of the plane.
+/// @param height The height of the plane.
+/// @param format The element format of dst.
+/// @param dst The resulting array of float, uint16_t (fp16) or int8_t.
+/// @param dst_stride The stride of dst, in elements.
+void normalize2D_uint8(int simd, const uint8_t *src, int src_stride,
+                       int width, int height, NormalizeOutput format,
+                       void *dst, int dst_stride) NOTNULL(2, 7);
+
+/// @brief Performs the plane normalization [min, max] -> [-1, 1] of 16-bit
+/// samples, e.g. 12-bit camera images. Minimum and maximum is determined
+/// from the array.
+/// @param simd Value indicating whether to use available SIMD acceleration.
+/// @param src The source array of 16-bit samples, stored in row-major format.
+/// @param src_stride The stride (the actual width) of the plane.
+/// @param width The width of the plane.
+/// @param height The height of the plane.
+/// @param format The element format of dst.
+/// @param dst The resulting array of float, uint16_t (fp16) or int8_t.
+/// @param dst_stride The stride of dst, in elements.
+void normalize2D_uint16(int simd, const uint16_t *src, int src_stride,
+                        int width, int height, NormalizeOutput format,
+                        void *dst, int dst_stride) NOTNULL(2, 7);
+
+/// @brief The same as normalize2D_uint16() with the precalculated range.
+void normalize2D_uint16_minmax(int simd, uint16_t min, uint16_t max,
+                               const uint16_t *src, int src_stride,
+                               int width, int height, NormalizeOutput format,
+                               void *dst, int dst_stride) NOTNULL(4, 9);
+
+/// @brief Performs the plane normalization [min, max] -> [-1, 1] of
+/// floating point values. Minimum and maximum is determined from the array.
+/// @param simd Value indicating whether to use available SIMD acceleration.
+/// @param src The source floating point array, stored in row-major format.
+/// @param src_stride The stride (the actual width) of the plane, in float-s.
+/// @param width The width of the plane.
+/// @param height The height of the plane.
+/// @param format The element format of dst.
+/// @param dst The resulting array of float, uint16_t (fp16) or int8_t.
+/// @param dst_stride The stride of dst, in elements.
+void normalize2D_float(int simd, const float *src, int src_stride,
+                       int width, int height, NormalizeOutput format,
+                       void *dst, int dst_stride) NOTNULL(2, 7);
+
+/// @brief The same as normalize2D_float() with the precalculated range.
+void normalize2D_float_minmax(int simd, float min, float max,
+                              const float *src, int src_stride,
+                              int width, int height, NormalizeOutput format,
+                              void *dst, int dst_stride) NOTNULL(4, 9);
+
+/// @brief Calculates the mean and the standard deviation of the array.
+/// @param simd Value indicating whether to use available SIMD acceleration.
+/// @param src The source floating point array.
+/// @param length The size of the array (in float-s, not in bytes).
+/// @param mean The pointer to the resulting mean. If NULL, it is not
+/// returned.
+/// @param stddev The pointer to the resulting population standard
+/// deviation. If NULL, it is not returned.
+/// @details The array is read once, in blocks which stay in cache; the
+/// moments of the blocks are merged in double precision (Chan et al.), so
+/// the variance is stable even when the mean is large.
+void meanstd1D(int simd, const float *src, int length,
+               float *mean, float *stddev) NOTNULL(2);
+
+/// @brief Calculates the mean and the standard deviation of the plane.
+/// @param simd Value indicating whether to use available SIMD acceleration.
+/// @param src The source floating point array, stored in row-major format.
+/// @param src_stride The stride (the actual width) of the plane, in float-s.
+/// @param width The width of the plane.
+/// @param height The height of the plane.
+/// @param mean The pointer to the resulting mean. If NULL, it is not
+/// returned.
+/// @param stddev The pointer to the resulting population standard
+/// deviation. If NULL, it is not returned.
+void meanstd2D(int simd, const float *src, int src_stride,
+               int width, int height, float *mean, float *stddev) NOTNULL(2);
+
+/// @brief Performs the z-score normalization (src - mean) / stddev.
+/// @param simd Value indicating whether to use available SIMD acceleration.
+/// @param src The source floating point array.
+/// @param length The size of the array (in float-s, not in bytes).
+/// @param dst The resulting array, may be the same as src. If the standard
+/// deviation is 0, it is filled with zeros.
+void normalize1D_zscore(int simd, const float *src, int length, float *dst)
+    NOTNULL(2, 4);
+
+/// @brief Performs the z-score normalization (src - mean) / stddev of the
+/// plane.
+/// @param simd Value indicating whether to use available SIMD acceleration.
+/// @param src The source floating point array, stored in row-major format.
+/// @param src_stride The stride (the actual width) of the plane, in float-s.
+/// @param width The width of the plane.
+/// @param height The height of the plane.
+/// @param dst The resulting array, may be the same as src if the strides
+/// are equal.
+/// @param dst_stride The stride of dst.
+void normalize2D_zscore(int simd, const float *src, int src_stride,
+                        int width, int height, float *dst, int dst_stride)
+    NOTNULL(2, 6);
+
+/// @brief Calculates the mean and the standard deviation of each channel
+/// of the interleaved data, e.g. the features of each frame.
+/// @param simd Value indicating whether to use available SIMD acceleration.
+/// @param src The source array of frames * channels float-s.
+/// @param frames The number of frames.
+/// @param channels The number of channels (values in one frame).
+/// @param mean The array of channels resulting means. If NULL, they are
+/// not returned.
+/// @param stddev The array of channels resulting population standard
+/// deviations. If NULL, they are not returned.
+void meanstd_channels(int simd, const float *src, int frames, int channels,
+                      float *mean, float *stddev) NOTNULL(2);
+
+/// @brief Performs the z-score normalization of each channel of the
+/// interleaved data.
+/// @param simd Value indicating whether to use available SIMD acceleration.
+/// @param src The source array of frames * channels float-s.
+/// @param frames The number of frames.
+/// @param channels The number of channels (values in one frame).
+/// @param dst The resulting array, may be the same as src.
+void normalize_zscore_channels(int simd, const float *src, int frames,
+                               int channels, float *dst) NOTNULL(2, 5);
+
 SIMD_API_END
 
 #endif  // INC_SIMD_NORMALIZE_H_
@@ -0,0 +1,163 @@
+/*! @file profile.h
+ *  @brief Hardware counters and roofline accounting of the kernels.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef INC_SIMD_PROFILE_H_
+#define INC_SIMD_PROFILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <simd/common.h>
+#include <simd/attributes.h>
+#include <simd/convolve_structs.h>
+
+SIMD_API_BEGIN
+
+/// @brief The instrumented entry points.
+typedef enum {
+  /// convolve(), including cross_correlate() with the FFT based
+  /// algorithms which delegates to it.
+  kSimdProfileConvolve,
+  /// wavelet_apply().
+  kSimdProfileWaveletApply,
+  /// matrix_multiply().
+  kSimdProfileMatrixMultiply,
+  /// normalize2D().
+  kSimdProfileNormalize2D,
+  /// The number of the instrumented entry points.
+  kSimdProfileCount
+} SimdProfileKernel;
+
+/// @brief The totals of all the calls of one entry point since the last
+/// simd_profile_reset().
+typedef struct {
+  /// The number of the calls.
+  uint64_t calls;
+  /// The wall clock time.
+  uint64_t nanoseconds;
+  /// The CPU cycles, 0 if the hardware counters are not available.
+  uint64_t cycles;
+  /// The retired instructions, 0 if the hardware counters are not
+  /// available.
+  uint64_t instructions;
+  /// The last level cache misses, 0 if the hardware counters are not
+  /// available.
+  uint64_t llc_misses;
+  /// The floating point operations of the algorithm. FFT based convolution
+  /// is estimated as 2.5 N log2(N) per real transform of size N.
+  uint64_t flops;
+  /// The compulsory memory traffic: the inputs are read and the outputs
+  /// are written once.
+  uint64_t bytes;
+} SimdProfileCounters;
+
+/// @brief Name of the environment variable which enables the profiling at
+/// load time, SIMD_PROFILE=1.
+#define SIMD_PROFILE_ENV "SIMD_PROFILE"
+
+/// @brief Turns the profiling of the entry points in SimdProfileKernel on
+/// or off. It is off by default, then the cost is a single branch per call.
+/// @details The hardware counters are opened with perf_event_open() for
+/// each calling thread on its first profiled call. If the kernel does not
+/// permit it (see /proc/sys/kernel/perf_event_paranoid), only the time,
+/// flops and bytes are accounted.
+void simd_profile_set_enabled(int enabled);
+
+/// @brief Returns nonzero if the entry points are profiled.
+int simd_profile_enabled(void);
+
+/// @brief Returns nonzero if the hardware counters are available in the
+/// calling thread. It opens them if they were not opened yet.
+int simd_profile_hardware_counters(void);
+
+/// @brief Reads the totals of the specified entry point.
+/// @param kernel The entry point.
+/// @param counters The resulting totals.
+/// @details The arithmetic intensity of the roofline plot is
+/// flops / bytes and the performance is flops / nanoseconds (GFLOP/s).
+/// This function is thread safe.
+void simd_profile_get(SimdProfileKernel kernel,
+                      SimdProfileCounters *counters) NOTNULL(2);
+
+/// @brief Zeroes the totals of all the entry points.
+void simd_profile_reset(void);
+
+/// @brief Returns the name of the entry point, e.g. "matrix_multiply".
+const char *simd_profile_kernel_name(SimdProfileKernel kernel);
+
+/// @brief The traced dispatch points, see simd_profile_set_trace().
+typedef enum {
+  /// convolve().
+  kSimdTraceConvolve,
+  /// cross_correlate().
+  kSimdTraceCrossCorrelate,
+  /// convolve_with_kernel() and convolve_with_kernel_scratch(), including
+  /// cross_correlate_with_kernel*() which delegate to them.
+  kSimdTraceConvolveWithKernel,
+  /// convolve_select_algorithm(), including the autotuning benchmark.
+  kSimdTraceSelectAlgorithm
+} SimdTraceEntry;
+
+/// @brief A single traced call.
+typedef struct {
+  /// The dispatch point.
+  SimdTraceEntry entry;
+  /// The algorithm which ran or was selected.
+  ConvolutionAlgorithm algorithm;
+  /// The length of the signal.
+  size_t x_length;
+  /// The length of the filter.
+  size_t h_length;
+  /// The FFT length: M of the FFT method, L of overlap-save or N of the
+  /// partitioned method. 0 for brute force and kSimdTraceSelectAlgorithm.
+  size_t fft_length;
+  /// The wall clock time of the call.
+  uint64_t nanoseconds;
+} SimdTraceEvent;
+
+/// @brief The function which receives the traced calls.
+/// @param event The call, valid only during the callback.
+/// @param user_data The pointer passed to simd_profile_set_trace().
+typedef void (*SimdTraceCallback)(const SimdTraceEvent *event,
+                                  void *user_data);
+
+/// @brief Sets the function which is called after every call of the
+/// dispatch points in SimdTraceEntry, in the calling thread.
+/// @param callback The function to call, NULL disables the tracing. Then
+/// the cost is the same single branch as of the disabled profiling.
+/// @param user_data The pointer to pass to callback.
+/// @details The tracing is independent of simd_profile_set_enabled().
+/// The callback must not be changed while the traced functions run in
+/// the other threads.
+void simd_profile_set_trace(SimdTraceCallback callback, void *user_data);
+
+SIMD_API_END
+
+#endif  // INC_SIMD_PROFILE_H_
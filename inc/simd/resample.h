@@ -0,0 +1,133 @@
+/*! @file resample.h
+ *  @brief Polyphase FIR resampling, decimation and interpolation.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef INC_SIMD_RESAMPLE_H_
+#define INC_SIMD_RESAMPLE_H_
+
+#include <stddef.h>
+#include <simd/common.h>
+#include <simd/attributes.h>
+
+SIMD_API_BEGIN
+
+/// @brief The state of the rational resampler, see resample_initialize().
+/// @details The fields are private, use the functions below.
+typedef struct {
+  /// The interpolation factor L.
+  int up;
+  /// The decimation factor M.
+  int down;
+  /// The number of the taps of each phase, ceil(hLength / up).
+  int taps;
+  /// up phases of taps reversed coefficients each.
+  float *phases;
+  /// The last taps - 1 samples of the signal, followed by the room for
+  /// the first taps - 1 samples of the next block.
+  float *history;
+  /// The phase of the next output, (n * down) % up.
+  int phase;
+  /// The index of the newest input sample of the next output, counted from
+  /// the beginning of the next block.
+  size_t index;
+} ResampleHandle;
+
+/// @brief Prepares for the resampling by the rational factor up / down.
+/// @param up The interpolation factor L.
+/// @param down The decimation factor M.
+/// @param h The lowpass filter designed for the rate up times the input
+/// one, see resample_design_filter(). It is split into the phases once.
+/// @param hLength The length of the filter in float-s.
+/// @return The state for resample_process(), it must be freed with
+/// resample_finalize().
+/// @details The output is the same as the convolution of h with the
+/// signal upsampled by inserting up - 1 zeros after each sample, taking
+/// every down-th sample, but only the kept outputs are calculated and only
+/// the nonzero inputs are multiplied, about hLength / up multiplications
+/// per output. The signal starts with zeros, as in convolve_stream_process().
+ResampleHandle resample_initialize(int up, int down, const float *h,
+                                   size_t hLength) NOTNULL(3);
+
+/// @brief Prepares for the decimation by the integer factor, the same as
+/// resample_initialize(1, factor, h, hLength).
+ResampleHandle resample_decimate_initialize(int factor, const float *h,
+                                            size_t hLength) NOTNULL(2);
+
+/// @brief Prepares for the interpolation by the integer factor, the same as
+/// resample_initialize(factor, 1, h, hLength).
+ResampleHandle resample_interpolate_initialize(int factor, const float *h,
+                                               size_t hLength) NOTNULL(2);
+
+/// @brief Designs the Blackman windowed sinc lowpass filter for
+/// resample_initialize().
+/// @param up The interpolation factor L.
+/// @param down The decimation factor M.
+/// @param tapsPerPhase The number of the taps of each phase, the greater,
+/// the steeper the transition band.
+/// @param h The resulting filter of length up * tapsPerPhase. Its cutoff is
+/// the lower of the two Nyquist frequencies and every phase sums to about 1,
+/// so that a constant signal keeps its level.
+void resample_design_filter(int up, int down, int tapsPerPhase, float *h)
+    NOTNULL(4);
+
+/// @brief Returns the number of the samples which resample_process() will
+/// write for the next block of the specified length.
+/// @param handle The state obtained from resample_initialize().
+/// @param length The length of the next block.
+size_t resample_output_length(const ResampleHandle *handle, size_t length)
+    NOTNULL(1);
+
+/// @brief Resamples the next block of the signal.
+/// @param simd Value indicating whether to use SIMD acceleration or not.
+/// @param handle The state obtained from resample_initialize().
+/// @param x The next block of the signal, of any length.
+/// @param length The length of the block.
+/// @param result The resampled samples, resample_output_length() of them,
+/// which is at most length * up / down + 1.
+/// @return The number of the written samples.
+/// @details The last taps - 1 samples are kept in handle, so the
+/// concatenated results of the consecutive calls are the same as the result
+/// of the concatenated blocks. The block is not copied.
+size_t resample_process(int simd, ResampleHandle *handle,
+                        const float *__restrict x, size_t length,
+                        float *__restrict result) NOTNULL(2, 3, 5);
+
+/// @brief Forgets the previous blocks, so that the next one is treated
+/// as the beginning of the signal.
+/// @param handle The state obtained from resample_initialize().
+void resample_reset(ResampleHandle *handle) NOTNULL(1);
+
+/// @brief Frees any resources allocated by resample_initialize().
+/// @param handle The state obtained from resample_initialize().
+void resample_finalize(ResampleHandle *handle) NOTNULL(1);
+
+SIMD_API_END
+
+#endif  // INC_SIMD_RESAMPLE_H_
@@ -0,0 +1,140 @@
+/*! @file sliding.h
+ *  @brief Incremental statistics over the sliding window of a signal.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef INC_SIMD_SLIDING_H_
+#define INC_SIMD_SLIDING_H_
+
+#include <stddef.h>
+#include <simd/common.h>
+#include <simd/detect_peaks.h>
+
+SIMD_API_BEGIN
+
+/// @brief The number of the samples which one step of
+/// sliding_stats_process() and sliding_stats_detect_peaks() works on.
+#define SLIDING_CHUNK 256
+
+/// @brief A sample kept in the monotonic deque of SlidingStats.
+typedef struct {
+  /// The number of the samples pushed before it, since the last reset.
+  size_t position;
+  float value;
+} SlidingPoint;
+
+/// @brief The ring buffer of the candidates for the minimum or the maximum
+/// of the window. The values are monotonic from the oldest to the newest.
+typedef struct {
+  SlidingPoint *points;
+  int first;
+  int count;
+} SlidingDeque;
+
+/// @brief The state of the statistics over the last window samples of the
+/// signal which arrives block by block, see sliding_stats_initialize().
+/// @details The fields are private, use the functions below.
+typedef struct {
+  int window;
+  /// The last window samples, sample p is at history[p % window].
+  float *history;
+  /// The number of the samples pushed since the last reset.
+  size_t position;
+  /// The first sample, the moments are of the samples minus it, which
+  /// reduces the cancellation in the variance.
+  float shift;
+  /// The sums of the shifted samples of the window and of their squares.
+  double sum;
+  double sumSquares;
+  SlidingDeque minimums;
+  SlidingDeque maximums;
+} SlidingStats;
+
+/// @brief Prepares for calculating the statistics over the sliding window.
+/// @param window The number of the last samples which the statistics are
+/// calculated over, must be positive.
+/// @return The state for sliding_stats_process(), it must be freed with
+/// sliding_stats_finalize().
+SlidingStats sliding_stats_initialize(int window);
+
+/// @brief Calculates the statistics of the windows which end at each sample
+/// of the next block of the signal.
+/// @param simd Value indicating whether to use SIMD acceleration.
+/// @param stats The state obtained from sliding_stats_initialize().
+/// @param x The next block of the signal, of any length.
+/// @param length The length of the block (in float-s, not in bytes).
+/// @param min The minimums of the windows, length float-s, may be NULL.
+/// @param max The maximums of the windows, length float-s, may be NULL.
+/// @param mean The means of the windows, length float-s, may be NULL.
+/// @param variance The population variances of the windows, length float-s,
+/// may be NULL.
+/// @details The window of x[i] is the last window samples up to and
+/// including x[i], the previous blocks included, or all the samples since
+/// the reset if there are fewer. Each sample costs O(1) amortized
+/// regardless of the window: the minimums and the maximums are the fronts
+/// of the monotonic deques, the moments are running sums in double.
+/// The sums are updated with the differences of the entering and the
+/// leaving samples, which are vectorized, as well as the final division.
+void sliding_stats_process(int simd, SlidingStats *stats, const float *x,
+                           size_t length, float *min, float *max,
+                           float *mean, float *variance) NOTNULL(2, 3);
+
+/// @brief Finds the extrema of the next block of the signal which stand
+/// out of their windows: the maxima of at least mean + deviations * sigma
+/// and the minima of at most mean - deviations * sigma, where mean and
+/// sigma are the statistics of the window which ends at the extremum.
+/// @param simd Value indicating whether to use SIMD acceleration.
+/// @param stats The state obtained from sliding_stats_initialize().
+/// @param deviations The number of the standard deviations.
+/// @param stream The state obtained from detect_peaks_stream_initialize(),
+/// the points which passed go to its ring buffer.
+/// @param x The next block of the signal, of any length.
+/// @param length The length of the block (in float-s, not in bytes).
+/// @details The block goes through detect_peaks_stream_push() and
+/// sliding_stats_process() piece by piece, the new points are filtered in
+/// the ring buffer. So the ring buffer should hold the unfiltered points of
+/// SLIDING_CHUNK samples, otherwise the older points may be counted as lost
+/// although they would not pass. stats and stream must be reset together.
+void sliding_stats_detect_peaks(int simd, SlidingStats *stats,
+                                float deviations, DetectPeaksStream *stream,
+                                const float *x, size_t length)
+    NOTNULL(2, 4, 5);
+
+/// @brief Forgets the pushed samples, so that the next block starts a new
+/// signal.
+/// @param stats The state obtained from sliding_stats_initialize().
+void sliding_stats_reset(SlidingStats *stats) NOTNULL(1);
+
+/// @brief Frees any resources allocated by sliding_stats_initialize().
+/// @param stats The state obtained from sliding_stats_initialize().
+void sliding_stats_finalize(SlidingStats *stats) NOTNULL(1);
+
+SIMD_API_END
+
+#endif  // INC_SIMD_SLIDING_H_
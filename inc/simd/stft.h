@@ -0,0 +1,168 @@
+/*! @file stft.h
+ *  @brief Short-time Fourier transform and spectrograms.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef INC_SIMD_STFT_H_
+#define INC_SIMD_STFT_H_
+
+#include <stddef.h>
+#include <simd/common.h>
+#include <simd/attributes.h>
+
+SIMD_API_BEGIN
+
+/// @brief What every frame of the STFT turns into, bins = fftSize / 2 + 1.
+typedef enum {
+  /// The spectrum, bins interleaved complex numbers (2 * bins float-s).
+  kSTFTOutputComplex,
+  /// |X[k]|, bins float-s.
+  kSTFTOutputMagnitude,
+  /// |X[k]|^2, bins float-s.
+  kSTFTOutputPower,
+  /// log(|X[k]|^2 + STFT_LOG_FLOOR), bins float-s.
+  kSTFTOutputLogPower,
+  /// log(mel filter bank x |X|^2 + STFT_LOG_FLOOR), one float per band.
+  kSTFTOutputLogMel
+} STFTOutput;
+
+/// @brief The number of the frames which are transformed by one batched
+/// FFT.
+#define STFT_BATCH_FRAMES 16
+
+/// @brief The value which is added to the power before the logarithm.
+#define STFT_LOG_FLOOR 1e-10f
+
+struct FFTPlan;
+
+/// @brief The state of the STFT, see stft_initialize().
+/// @details The fields are private, use the functions below.
+typedef struct {
+  STFTOutput output;
+  int window_length;
+  int hop;
+  int fft_size;
+  float *window;
+  /// STFT_BATCH_FRAMES windowed frames, slot_stride float-s apart, which
+  /// are transformed in place.
+  float *slots;
+  size_t slot_stride;
+  struct FFTPlan *batch_plan;
+  /// Transforms the first slot only, for the frames beyond the last full
+  /// batch.
+  struct FFTPlan *plan;
+  /// The power spectrum, followed by the mel bands.
+  float *spectrum;
+  int mel_bands;
+  /// The first bin and the number of the bins of every band.
+  int *mel_bins;
+  /// The nonzero weights of the bands one after another.
+  float *mel_weights;
+  /// The samples of the stream which did not make a frame yet,
+  /// window_length float-s.
+  float *history;
+  size_t buffered;
+  /// The number of the next stream samples which fall between the frames
+  /// if the hop is longer than the window.
+  size_t skip;
+} STFTHandle;
+
+/// @brief Prepares the STFT.
+/// @param window window_length coefficients which every frame is
+/// multiplied by. If it is NULL, the periodic Hann window is taken.
+/// @param windowLength The length of every frame.
+/// @param hop The distance between the beginnings of the adjacent frames.
+/// @param fftSize The length of the transform, not less than windowLength,
+/// the frames are padded with zeros to it. It must be supported by
+/// fft_initialize(), e.g. be returned by convolve_fft_good_length().
+/// @param output What every frame turns into, but kSTFTOutputLogMel,
+/// see stft_initialize_log_mel().
+/// @return The state for stft_process() and stft_stream(), it must be
+/// freed with stft_finalize().
+STFTHandle stft_initialize(const float *window, int windowLength, int hop,
+                           int fftSize, STFTOutput output);
+
+/// @brief Prepares the log-mel spectrogram, see stft_initialize().
+/// @param bands The number of the triangular mel bands.
+/// @param sampleRate The sampling rate of the signal in Hz.
+/// @param minFrequency The lower edge of the first band in Hz.
+/// @param maxFrequency The upper edge of the last band in Hz, it must not
+/// exceed sampleRate / 2.
+/// @details The bands are spaced evenly in the HTK mel scale,
+/// 2595 log10(1 + f / 700), and peak at 1.
+STFTHandle stft_initialize_log_mel(const float *window, int windowLength,
+                                   int hop, int fftSize, int bands,
+                                   float sampleRate, float minFrequency,
+                                   float maxFrequency);
+
+/// @brief Returns the number of the float-s which every frame turns into.
+size_t stft_frame_size(const STFTHandle *handle) NOTNULL(1);
+
+/// @brief Returns the number of the frames which fit into the signal,
+/// (length - windowLength) / hop + 1 or 0.
+size_t stft_frames(const STFTHandle *handle, size_t length) NOTNULL(1);
+
+/// @brief Calculates the spectrogram of the whole signal.
+/// @param simd Value indicating whether to use SIMD acceleration or not.
+/// @param handle The state obtained from stft_initialize(), the stream
+/// state is not touched.
+/// @param x The signal.
+/// @param length The length of the signal.
+/// @param result stft_frames() rows of stft_frame_size() float-s.
+/// @return The number of the frames, stft_frames().
+size_t stft_process(int simd, STFTHandle *handle, const float *x,
+                    size_t length, float *result) NOTNULL(2, 3, 5);
+
+/// @brief Returns the number of the frames which stft_stream() will write
+/// for the next block of the specified length.
+size_t stft_stream_frames(const STFTHandle *handle, size_t length)
+    NOTNULL(1);
+
+/// @brief Feeds the next block of the live signal and calculates the frames
+/// which it completes.
+/// @param simd Value indicating whether to use SIMD acceleration or not.
+/// @param handle The state obtained from stft_initialize().
+/// @param x The next block of the signal, of any length.
+/// @param length The length of the block.
+/// @param result stft_stream_frames() rows of stft_frame_size() float-s.
+/// @return The number of the written frames.
+/// @details The concatenation of the results is the same as stft_process()
+/// of the concatenated blocks.
+size_t stft_stream(int simd, STFTHandle *handle, const float *x,
+                   size_t length, float *result) NOTNULL(2, 3, 5);
+
+/// @brief Drops the buffered samples of the stream.
+void stft_reset(STFTHandle *handle) NOTNULL(1);
+
+/// @brief Frees the resources of the handle.
+void stft_finalize(STFTHandle *handle) NOTNULL(1);
+
+SIMD_API_END
+
+#endif  // INC_SIMD_STFT_H_
@@ -0,0 +1,158 @@
+/*! @file thread_pool.h
+ *  @brief Thread pools which run the parallel kernels.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef INC_SIMD_THREAD_POOL_H_
+#define INC_SIMD_THREAD_POOL_H_
+
+#include <simd/common.h>
+#include <simd/attributes.h>
+
+SIMD_API_BEGIN
+
+/// @brief Name of the environment variable which sets the size of the
+/// default thread pool, e.g. SIMD_NUM_THREADS=8.
+#define SIMD_NUM_THREADS_ENV "SIMD_NUM_THREADS"
+
+/// @brief A piece of work executed by a thread pool.
+/// @param arg The opaque pointer passed to thread_pool_run().
+/// @param index The index of the task, from 0 to count - 1.
+typedef void (*ThreadPoolTask)(void *arg, int index);
+
+/// @brief Runs the tasks on a caller supplied thread pool.
+/// @param context The opaque pointer passed to thread_pool_create_external().
+/// @param count The number of tasks.
+/// @param threads The maximal number of threads to use, including the
+/// calling one.
+/// @param task The function to call for every index in [0, count).
+/// @param arg The first argument of task.
+/// @details It must return only after all the tasks have finished.
+typedef void (*ThreadPoolExecutor)(void *context, int count, int threads,
+                                   ThreadPoolTask task, void *arg);
+
+/// @brief Opaque thread pool handle.
+typedef struct ThreadPool ThreadPool;
+
+/// @brief Creates the pool of the library owned threads.
+/// @param threads The number of threads which run the tasks, including the
+/// one which calls thread_pool_run(), so threads - 1 of them are spawned.
+/// If it is 0, the number of online processors is taken.
+/// @return The new pool or NULL if the threads could not be started.
+ThreadPool *thread_pool_create(int threads) MALLOC WARN_UNUSED_RESULT;
+
+/// @brief Wraps the caller's own thread pool, so that the parallel kernels
+/// share the threads with the rest of the application.
+/// @param threads The number of threads the executor may run the tasks on.
+/// @param executor The function which runs the tasks.
+/// @param context The first argument of executor.
+/// @return The new pool handle, it must be freed with thread_pool_destroy().
+ThreadPool *thread_pool_create_external(
+    int threads, ThreadPoolExecutor executor, void *context)
+    NOTNULL(2) MALLOC WARN_UNUSED_RESULT;
+
+/// @brief Stops the threads and frees the pool.
+/// @param pool The pool created with thread_pool_create() or
+/// thread_pool_create_external(). It must be idle, with no queued jobs.
+void thread_pool_destroy(ThreadPool *pool) NOTNULL(1);
+
+/// @brief Returns the pool which is used when NULL is passed instead of one.
+/// @details It is created on the first call with SIMD_NUM_THREADS threads
+/// or as many as there are online processors if the variable is not set,
+/// and lives until the process exits.
+ThreadPool *thread_pool_default(void);
+
+/// @brief Returns the number of threads the pool runs the tasks on.
+int thread_pool_size(const ThreadPool *pool) NOTNULL(1);
+
+/// @brief Calls task(arg, i) for every i in [0, count) and waits until all
+/// of them finish.
+/// @param pool The pool to run the tasks on.
+/// @param count The number of tasks.
+/// @param threads The maximal number of threads to use, including the
+/// calling one. If it is 0 or greater than the pool size, all the pool
+/// threads are used.
+/// @param task The function to call.
+/// @param arg The first argument of task.
+/// @details The tasks are submitted as the jobs of thread_pool_submit(), so
+/// the concurrent calls and the asynchronous jobs share the threads of the
+/// pool instead of oversubscribing the cores, and it may be called from
+/// inside the tasks and the jobs.
+void thread_pool_run(ThreadPool *pool, int count, int threads,
+                     ThreadPoolTask task, void *arg) NOTNULL(1, 4);
+
+/// @brief An asynchronous job, see thread_pool_submit().
+/// @param arg The opaque pointer passed to thread_pool_submit().
+typedef void (*ThreadPoolJob)(void *arg);
+
+/// @brief Opaque counter of the unfinished jobs, see thread_pool_wait().
+typedef struct ThreadPoolWaitGroup ThreadPoolWaitGroup;
+
+/// @brief Creates an empty wait group.
+/// @return The new group or NULL if there is not enough memory.
+ThreadPoolWaitGroup *thread_pool_wait_group_create(void)
+    MALLOC WARN_UNUSED_RESULT;
+
+/// @brief Frees the wait group. It must have no pending jobs.
+void thread_pool_wait_group_destroy(ThreadPoolWaitGroup *group) NOTNULL(1);
+
+/// @brief Returns the number of the submitted jobs of the group which have
+/// not finished yet. A group of a single job is polled like a future.
+int thread_pool_wait_group_pending(const ThreadPoolWaitGroup *group)
+    NOTNULL(1);
+
+/// @brief Queues the job to run on the pool and returns immediately.
+/// @param pool The pool to run the job on.
+/// @param group The group which counts the job until it finishes, may be
+/// NULL. All the jobs of a group must be submitted to the same pool.
+/// @param job The function to call, e.g. a wrapper of convolve().
+/// @param done The completion callback which is called with arg in the
+/// thread which ran job, after it returns. May be NULL.
+/// @param arg The argument of job and done.
+/// @details Every thread of the pool owns a queue of jobs; the jobs
+/// submitted from a worker go to its own queue, the idle workers steal
+/// the oldest jobs of the others. The pools created with
+/// thread_pool_create_external() or with a single thread have no threads
+/// to run the job later, so it runs in the calling thread before this
+/// function returns.
+void thread_pool_submit(ThreadPool *pool, ThreadPoolWaitGroup *group,
+                        ThreadPoolJob job, ThreadPoolJob done, void *arg)
+    NOTNULL(1, 3);
+
+/// @brief Waits until all the jobs of the group finish.
+/// @param pool The pool the jobs were submitted to.
+/// @param group The wait group.
+/// @details The calling thread runs the queued jobs of the pool while it
+/// waits, so it may be called from inside the jobs.
+void thread_pool_wait(ThreadPool *pool, ThreadPoolWaitGroup *group)
+    NOTNULL(1, 2);
+
+SIMD_API_END
+
+#endif  // INC_SIMD_THREAD_POOL_H_
@@ -32,6 +32,7 @@
 #define INC_SIMD_WAVELET_H_
 
 #include <stddef.h>
+#include <stdint.h>
 #include <simd/common.h>
 #include <simd/attributes.h>
 #include <simd/wavelet_types.h>
@@ -116,6 +117,28 @@ void wavelet_apply_na(WaveletType type, int order, ExtensionType ext,
                       float *__restrict desthi, float *__restrict destlo)
     NOTNULL(4, 6, 7);
 
+/// @brief Performs a single wavelet transform on series of real numbers
+/// which are not prepared with wavelet_prepare_array().
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param ext The way to extend the signal.
+/// @param src An array of floating point numbers to transform, no alignment
+/// is required.
+/// @param length The length of src (in float-s, not in bytes).
+/// @param desthi The high frequency part of result (highpass), length / 2
+/// floats, no alignment is required.
+/// @param destlo The low frequency part of result (lowpass), length / 2
+/// floats, no alignment is required.
+/// @details The even and the odd samples are split in registers with
+/// unaligned loads and permutes, so neither the shifted copies of
+/// wavelet_prepare_array() nor wavelet_allocate_destination() are needed.
+/// The results are equal to wavelet_apply_na().
+/// @pre length must be even.
+void wavelet_apply_plain(WaveletType type, int order, ExtensionType ext,
+                         const float *__restrict src, size_t length,
+                         float *__restrict desthi, float *__restrict destlo)
+    NOTNULL(4, 6, 7);
+
 /// @brief Performs a single stationary (undecimated) wavelet transform
 /// on series of real numbers.
 /// @param type The wavelet type.
@@ -161,6 +184,401 @@ void stationary_wavelet_apply_na(WaveletType type, int order, int level,
                                  float *__restrict destlo)
     NOTNULL(5, 7, 8);
 
+/// @brief Performs the multi-level wavelet decomposition of series of real
+/// numbers.
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param ext The way to extend the signal.
+/// @param levels The number of the decomposition levels.
+/// @param src An array of floating point numbers to transform. It does not
+/// need to be prepared with wavelet_prepare_array().
+/// @param length The length of src (in float-s, not in bytes).
+/// @param coeffs The resulting coefficients of size length, laid out as
+/// [approximation at levels, detail at levels, ..., detail at 1]. That is,
+/// the approximation occupies [0, length >> levels) and the details at
+/// level k occupy [length >> k, length >> (k - 1)).
+/// @details The source is prepared only once and the lowpass part of each
+/// level is produced in the format which the next level accepts as is, so
+/// the levels do not allocate and do not copy anything except the results.
+/// @pre length must be divisible by 2^levels.
+void wavelet_decompose(WaveletType type, int order, ExtensionType ext,
+                       int levels, const float *__restrict src, size_t length,
+                       float *__restrict coeffs) NOTNULL(5, 7);
+
+/// @brief Performs the multi-level stationary (undecimated) wavelet
+/// decomposition of series of real numbers.
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param ext The way to extend the signal.
+/// @param levels The number of the decomposition levels.
+/// @param src An array of floating point numbers to transform.
+/// @param length The length of src (in float-s, not in bytes).
+/// @param coeffs The resulting coefficients of size (levels + 1) * length,
+/// laid out as [approximation at levels, detail at levels, ...,
+/// detail at 1], each of length floats.
+void stationary_wavelet_decompose(WaveletType type, int order,
+                                  ExtensionType ext, int levels,
+                                  const float *__restrict src, size_t length,
+                                  float *__restrict coeffs) NOTNULL(5, 7);
+
+/// @brief Performs a single inverse wavelet transform, that is, restores
+/// the signal from the result of wavelet_apply().
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param srchi The high frequency part (highpass) of size length/2.
+/// @param srclo The low frequency part (lowpass) of size length/2.
+/// @param length The length of the restored signal (in float-s, not in
+/// bytes).
+/// @param dest The restored signal of size length.
+/// @details The synthesis is the scaled transpose of the circular analysis,
+/// so it is exact if the transform was applied with EXTENSION_TYPE_PERIODIC.
+/// The other extensions lose information at the end of the signal, and
+/// then order - 2 samples at each end are approximate.
+/// @pre length must be even.
+void inverse_wavelet_apply(WaveletType type, int order,
+                           const float *__restrict srchi,
+                           const float *__restrict srclo, size_t length,
+                           float *__restrict dest) NOTNULL(3, 4, 6);
+
+/// @brief Performs a single inverse wavelet transform (no SIMD acceleration
+/// is used).
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param srchi The high frequency part (highpass) of size length/2.
+/// @param srclo The low frequency part (lowpass) of size length/2.
+/// @param length The length of the restored signal (in float-s, not in
+/// bytes).
+/// @param dest The restored signal of size length.
+/// @pre length must be even.
+void inverse_wavelet_apply_na(WaveletType type, int order,
+                              const float *__restrict srchi,
+                              const float *__restrict srclo, size_t length,
+                              float *__restrict dest) NOTNULL(3, 4, 6);
+
+/// @brief Performs a single inverse stationary (undecimated) wavelet
+/// transform, that is, restores the signal from the result of
+/// stationary_wavelet_apply().
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param level The decomposition level.
+/// @param srchi The high frequency part (highpass) of size length.
+/// @param srclo The low frequency part (lowpass) of size length.
+/// @param length The length of the restored signal (in float-s, not in
+/// bytes).
+/// @param dest The restored signal of size length.
+/// @details The result is the average of the circular synthesis of both
+/// parts. It is exact if the transform was applied with
+/// EXTENSION_TYPE_PERIODIC, otherwise (order - 1) * 2^(level - 1) samples
+/// at each end are approximate.
+void inverse_stationary_wavelet_apply(WaveletType type, int order, int level,
+                                      const float *__restrict srchi,
+                                      const float *__restrict srclo,
+                                      size_t length,
+                                      float *__restrict dest)
+    NOTNULL(4, 5, 7);
+
+/// @brief Performs a single inverse stationary (undecimated) wavelet
+/// transform (no SIMD acceleration is used).
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param level The decomposition level.
+/// @param srchi The high frequency part (highpass) of size length.
+/// @param srclo The low frequency part (lowpass) of size length.
+/// @param length The length of the restored signal (in float-s, not in
+/// bytes).
+/// @param dest The restored signal of size length.
+void inverse_stationary_wavelet_apply_na(WaveletType type, int order,
+                                         int level,
+                                         const float *__restrict srchi,
+                                         const float *__restrict srclo,
+                                         size_t length,
+                                         float *__restrict dest)
+    NOTNULL(4, 5, 7);
+
+/// @brief Restores the signal from the result of wavelet_decompose().
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param levels The number of the decomposition levels.
+/// @param coeffs The coefficients of size length in wavelet_decompose()
+/// layout.
+/// @param length The length of the restored signal (in float-s, not in
+/// bytes).
+/// @param dest The restored signal of size length.
+/// @details See inverse_wavelet_apply() about the extensions.
+/// @pre length must be divisible by 2^levels.
+void wavelet_recompose(WaveletType type, int order, int levels,
+                       const float *__restrict coeffs, size_t length,
+                       float *__restrict dest) NOTNULL(4, 6);
+
+/// @brief Restores the signal from the result of
+/// stationary_wavelet_decompose().
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param levels The number of the decomposition levels.
+/// @param coeffs The coefficients of size (levels + 1) * length in
+/// stationary_wavelet_decompose() layout.
+/// @param length The length of the restored signal (in float-s, not in
+/// bytes).
+/// @param dest The restored signal of size length.
+/// @details See inverse_stationary_wavelet_apply() about the extensions.
+void stationary_wavelet_recompose(WaveletType type, int order, int levels,
+                                  const float *__restrict coeffs,
+                                  size_t length, float *__restrict dest)
+    NOTNULL(4, 6);
+
+/// @brief Thresholds the wavelet detail coefficients.
+/// @param shrinkage The thresholding rule.
+/// @param threshold The non-negative threshold.
+/// @param src The coefficients to threshold.
+/// @param length The length of src and dest (in float-s, not in bytes).
+/// @param dest The thresholded coefficients, it may be the same as src.
+void wavelet_shrink(ShrinkageType shrinkage, float threshold,
+                    const float *src, size_t length, float *dest)
+    NOTNULL(3, 5);
+
+/// @brief Estimates the universal (VisuShrink) threshold
+/// sigma * sqrt(2 * ln(signalLength)), where the noise level sigma is the
+/// median absolute deviation of the finest detail coefficients divided
+/// by 0.6745.
+/// @param detail The detail coefficients of the first level.
+/// @param length The length of detail (in float-s, not in bytes).
+/// @param signalLength The length of the transformed signal.
+float wavelet_universal_threshold(const float *detail, size_t length,
+                                  size_t signalLength) NOTNULL(1);
+
+/// @brief Denoises the signal with the wavelet shrinkage: decomposes it,
+/// thresholds the details and restores it.
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param levels The number of the decomposition levels.
+/// @param shrinkage The thresholding rule.
+/// @param thresholds The thresholds of the detail coefficients at each
+/// level, starting from the first one. If it is NULL, the universal
+/// threshold is estimated from the first level, see
+/// wavelet_universal_threshold().
+/// @param src The signal to denoise.
+/// @param length The length of src and dest (in float-s, not in bytes).
+/// @param dest The denoised signal.
+/// @details Each band is thresholded right after it is decomposed, while
+/// it is still in cache. The signal is extended periodically, so that it
+/// is restored exactly.
+/// @pre length must be divisible by 2^levels.
+void wavelet_denoise(WaveletType type, int order, int levels,
+                     ShrinkageType shrinkage, const float *thresholds,
+                     const float *__restrict src, size_t length,
+                     float *__restrict dest) NOTNULL(6, 8);
+
+/// @brief Denoises the signal with the stationary (undecimated, also known
+/// as translation invariant) wavelet shrinkage.
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param levels The number of the decomposition levels.
+/// @param shrinkage The thresholding rule.
+/// @param thresholds The thresholds of the detail coefficients at each
+/// level, starting from the first one. If it is NULL, the universal
+/// threshold is estimated from the first level, see
+/// wavelet_universal_threshold().
+/// @param src The signal to denoise.
+/// @param length The length of src and dest (in float-s, not in bytes).
+/// @param dest The denoised signal.
+/// @details See wavelet_denoise().
+void stationary_wavelet_denoise(WaveletType type, int order, int levels,
+                                ShrinkageType shrinkage,
+                                const float *thresholds,
+                                const float *__restrict src, size_t length,
+                                float *__restrict dest) NOTNULL(6, 8);
+
+/// @brief Performs a single 2D wavelet transform of the image: the rows
+/// and then the columns are convolved, both are decimated.
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param ext The way to extend the image to the right and to the bottom.
+/// @param src The image to transform.
+/// @param src_stride The stride (the actual width) of the image.
+/// @param width The width of the image.
+/// @param height The height of the image.
+/// @param ll The approximation subband: lowpass along the rows and along
+/// the columns.
+/// @param lh The horizontal edges: lowpass along the rows, highpass along
+/// the columns.
+/// @param hl The vertical edges: highpass along the rows, lowpass along
+/// the columns.
+/// @param hh The diagonal details: highpass along both.
+/// @param dst_stride The stride of the subbands, each of them is
+/// width / 2 by height / 2.
+/// @details The subbands are equal to wavelet_apply_na() over the rows
+/// followed by wavelet_apply_na() over the columns. The column pass works
+/// on the rows directly, so no transposition takes place. To get the
+/// conventional quadrant layout, point ll, hl, lh and hh to the quadrants
+/// of one width by height plane and pass its stride.
+/// @pre width and height must be even.
+void wavelet_apply2D(WaveletType type, int order, ExtensionType ext,
+                     const float *src, int src_stride, int width, int height,
+                     float *ll, float *lh, float *hl, float *hh,
+                     int dst_stride) NOTNULL(4, 8, 9, 10, 11);
+
+/// @brief The same as wavelet_apply2D(), but the image is 8-bit grayscale.
+void wavelet_apply2D_uint8(WaveletType type, int order, ExtensionType ext,
+                           const uint8_t *src, int src_stride,
+                           int width, int height,
+                           float *ll, float *lh, float *hl, float *hh,
+                           int dst_stride) NOTNULL(4, 8, 9, 10, 11);
+
+/// @brief Performs a single 2D stationary wavelet transform of the image:
+/// the rows and then the columns are convolved without the decimation.
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param level The level of the transform, the filters are dilated with
+/// 2^(level - 1) - 1 zeros between the taps.
+/// @param ext The way to extend the image to the right and to the bottom.
+/// @param src The image to transform.
+/// @param src_stride The stride (the actual width) of the image.
+/// @param width The width of the image.
+/// @param height The height of the image.
+/// @param ll The approximation subband.
+/// @param lh The horizontal edges.
+/// @param hl The vertical edges.
+/// @param hh The diagonal details.
+/// @param dst_stride The stride of the subbands, each of them is
+/// width by height.
+/// @details The subbands are equal to stationary_wavelet_apply_na() over
+/// the rows followed by stationary_wavelet_apply_na() over the columns,
+/// see wavelet_apply2D().
+void stationary_wavelet_apply2D(WaveletType type, int order, int level,
+                                ExtensionType ext, const float *src,
+                                int src_stride, int width, int height,
+                                float *ll, float *lh, float *hl, float *hh,
+                                int dst_stride) NOTNULL(5, 9, 10, 11, 12);
+
+/// @brief The same as stationary_wavelet_apply2D(), but the image is 8-bit
+/// grayscale.
+void stationary_wavelet_apply2D_uint8(WaveletType type, int order, int level,
+                                      ExtensionType ext, const uint8_t *src,
+                                      int src_stride, int width, int height,
+                                      float *ll, float *lh, float *hl,
+                                      float *hh, int dst_stride)
+    NOTNULL(5, 9, 10, 11, 12);
+
+/// @brief Performs a single wavelet transform on each of the many signals
+/// of the same length.
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param ext The way to extend the signals.
+/// @param layout The layout of src, desthi and destlo.
+/// @param src The signals to transform.
+/// @param length The length of each signal (in float-s, not in bytes).
+/// @param count The number of the signals.
+/// @param desthi The highpass parts of the results, length / 2 per signal
+/// in the same layout as src.
+/// @param destlo The lowpass parts of the results, length / 2 per signal
+/// in the same layout as src.
+/// @details The filters are initialized once and the SIMD lanes are filled
+/// with different signals, so this is much faster than wavelet_apply()
+/// per signal when the signals are short. The results are equal to
+/// wavelet_apply_na() of each signal. Neither src nor the destinations
+/// need wavelet_prepare_array() or wavelet_allocate_destination().
+/// @pre length must be even.
+void wavelet_apply_batch(WaveletType type, int order, ExtensionType ext,
+                         WaveletBatchLayout layout,
+                         const float *__restrict src, size_t length,
+                         size_t count, float *__restrict desthi,
+                         float *__restrict destlo) NOTNULL(5, 8, 9);
+
+/// @brief Sets up the filter bank of the wavelet once, so that it is not
+/// initialized in every call like wavelet_apply() does.
+/// @param type The wavelet type.
+/// @param order The order of the wavelet.
+/// @param level 0 for the decimated transform (wavelet_apply()), otherwise
+/// the level of the stationary one (stationary_wavelet_apply()).
+/// @param ext The way to extend the signals.
+/// @return The handle for wavelet_handle_apply().
+WaveletHandle wavelet_handle_initialize(WaveletType type, int order,
+                                        int level, ExtensionType ext);
+
+/// @brief Performs a single wavelet transform with the prepared filter bank.
+/// @param handle The structure obtained from wavelet_handle_initialize().
+/// @param src The signal to transform, in the plain format (it does not
+/// need wavelet_prepare_array()).
+/// @param length The length of src (in float-s, not in bytes).
+/// @param desthi The highpass part of the result, length / 2 long for the
+/// decimated transform and length long for the stationary one.
+/// @param destlo The lowpass part of the result, the same length as desthi.
+/// @details The results are equal to wavelet_apply_na() or
+/// stationary_wavelet_apply_na(). Neither the filters nor the scratch
+/// buffers are set up in the call, so it is suited for the short signals.
+/// @pre length must be even.
+void wavelet_handle_apply(WaveletHandle handle, const float *__restrict src,
+                          size_t length, float *__restrict desthi,
+                          float *__restrict destlo) NOTNULL(2, 4, 5);
+
+/// @brief Frees any resources allocated by wavelet_handle_initialize().
+/// @param handle The structure obtained from wavelet_handle_initialize().
+void wavelet_handle_finalize(WaveletHandle handle);
+
+/// @brief Performs a single wavelet transform on series of double precision
+/// numbers.
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param ext The way to extend the signal.
+/// @param src The signal to transform, in the plain format.
+/// @param length The length of src (in double-s, not in bytes).
+/// @param desthi The highpass part of the result, length / 2 long.
+/// @param destlo The lowpass part of the result, length / 2 long.
+/// @details The filters are taken from the full precision tables, so the
+/// result is suited for the deep decompositions where the float rounding
+/// accumulates. Otherwise, it is equal to wavelet_apply_plain().
+/// @pre length must be even.
+void wavelet_apply_double(WaveletType type, int order, ExtensionType ext,
+                          const double *__restrict src, size_t length,
+                          double *__restrict desthi,
+                          double *__restrict destlo) NOTNULL(4, 6, 7);
+
+/// @brief Performs a single stationary wavelet transform on series of double
+/// precision numbers, see wavelet_apply_double().
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param level The level of the transform.
+/// @param ext The way to extend the signal.
+/// @param src The signal to transform.
+/// @param length The length of src, desthi and destlo (in double-s, not in
+/// bytes).
+/// @param desthi The highpass part of the result.
+/// @param destlo The lowpass part of the result.
+void stationary_wavelet_apply_double(WaveletType type, int order, int level,
+                                     ExtensionType ext,
+                                     const double *__restrict src,
+                                     size_t length,
+                                     double *__restrict desthi,
+                                     double *__restrict destlo)
+    NOTNULL(5, 7, 8);
+
+/// @brief Checks if the wavelet can be applied with
+/// wavelet_lifting_apply().
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to check.
+/// @return 1 if the lifting factorization of the wavelet is supported,
+/// otherwise 0.
+int wavelet_lifting_validate_order(WaveletType type, int order);
+
+/// @brief Performs a single wavelet transform on series of real numbers
+/// in place, using the lifting factorization of the wavelet.
+/// @param type The wavelet type.
+/// @param order The order of the wavelet to apply.
+/// @param ext The way to extend the signal.
+/// @param data An array of floating point numbers to transform. On return,
+/// data[2 * i] is the lowpass and data[2 * i + 1] is the highpass part
+/// of wavelet_apply() result at i.
+/// @param length The length of data (in float-s, not in bytes).
+/// @details The lifting steps take about half of the multiplications of
+/// the direct convolution and need neither wavelet_prepare_array() nor
+/// the destination buffers. The results are equal to wavelet_apply_na()
+/// within the floating point rounding.
+/// @pre wavelet_lifting_validate_order(type, order) must be 1.
+/// @pre length must be greater than or equal to order.
+/// @pre length must be even.
+void wavelet_lifting_apply(WaveletType type, int order, ExtensionType ext,
+                           float *data, size_t length) NOTNULL(4);
+
 SIMD_API_END
 
 #endif  // INC_SIMD_WAVELET_H_
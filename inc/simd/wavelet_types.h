@@ -52,6 +52,39 @@ typedef enum {
   EXTENSION_TYPE_ZERO,
 } ExtensionType;
 
+typedef enum {
+  /// @brief sign(x) * max(|x| - t, 0)
+  SHRINKAGE_TYPE_SOFT,
+  /// @brief |x| > t? x : 0
+  SHRINKAGE_TYPE_HARD,
+  /// @brief |x| > t? x - t^2 / x : 0 (non-negative garrote)
+  SHRINKAGE_TYPE_GARROTE,
+} ShrinkageType;
+
+typedef enum {
+  /// @brief The signals follow each other: src[s * length + i]
+  WAVELET_BATCH_LAYOUT_ROWS,
+  /// @brief The samples of all the signals are interleaved (structure of
+  /// arrays): src[i * count + s]
+  WAVELET_BATCH_LAYOUT_INTERLEAVED,
+} WaveletBatchLayout;
+
+/// @brief The filter bank of a wavelet which is set up once and applied
+/// many times, see wavelet_handle_initialize().
+typedef struct {
+  WaveletType type;
+  int order;
+  /// @brief 0 for the decimated transform, otherwise the level of the
+  /// stationary one.
+  int level;
+  ExtensionType ext;
+  /// @brief The distance between the taps of the dilated filters.
+  int stride;
+  /// @brief The aligned highpass taps, followed by the lowpass ones at
+  /// offset (order + 15) & ~15.
+  float *taps;
+} WaveletHandle;
+
 SIMD_API_END
 
 
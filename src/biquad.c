@@ -0,0 +1,285 @@
+/*! @file biquad.c
+ *  @brief Cascades of IIR biquad sections.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#define LIBSIMD_IMPLEMENTATION
+#include "src/dispatch.h"
+#define biquad_cascade_initialize KERNEL(biquad_cascade_initialize)
+#define biquad_cascade_process KERNEL(biquad_cascade_process)
+#define biquad_cascade_reset KERNEL(biquad_cascade_reset)
+#define biquad_cascade_finalize KERNEL(biquad_cascade_finalize)
+#include "inc/simd/biquad.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <simd/instruction_set.h>
+#include <simd/memory.h>
+#include "src/dot_product.h"
+
+/// @brief The number of the sections which run in the vector lanes at once,
+/// see biquad_sections_lanes().
+#define BIQUAD_LANES 4
+
+BiquadCascade biquad_cascade_initialize(
+    const BiquadCoefficients *coefficients, int sections, int channels) {
+  assert(coefficients);
+  assert(sections > 0);
+  assert(channels > 0);
+  BiquadCascade cascade;
+  cascade.sections = sections;
+  cascade.channels = channels;
+  cascade.coefficients = malloc(sections * sizeof(BiquadCoefficients));
+  assert(cascade.coefficients);
+  memcpy(cascade.coefficients, coefficients,
+         sections * sizeof(BiquadCoefficients));
+  cascade.state = mallocf((size_t)sections * 2 * channels);
+  assert(cascade.state);
+  biquad_cascade_reset(&cascade);
+  return cascade;
+}
+
+/// @brief Filters one channel with one section, the transposed direct
+/// form II.
+static void biquad_section(const BiquadCoefficients *k, float *z1p,
+                           float *z2p, const float *x, size_t stride,
+                           size_t frames, float *result) {
+  float z1 = *z1p, z2 = *z2p;
+  for (size_t t = 0; t < frames; t++) {
+    float v = x[t * stride];
+    float y = k->b0 * v + z1;
+    z1 = k->b1 * v - k->a1 * y + z2;
+    z2 = k->b2 * v - k->a2 * y;
+    result[t * stride] = y;
+  }
+  *z1p = z1;
+  *z2p = z2;
+}
+
+#ifdef __AVX__
+
+/// @brief The number of the channels biquad_section_channels() filters.
+#define BIQUAD_CHANNELS 8
+
+/// @brief Filters BIQUAD_CHANNELS consecutive channels with one section.
+static void biquad_section_channels(const BiquadCoefficients *k, float *z1p,
+                                    float *z2p, const float *x,
+                                    size_t stride, size_t frames,
+                                    float *result) {
+  const __m256 b0 = _mm256_set1_ps(k->b0), b1 = _mm256_set1_ps(k->b1);
+  const __m256 b2 = _mm256_set1_ps(k->b2);
+  const __m256 na1 = _mm256_set1_ps(-k->a1), na2 = _mm256_set1_ps(-k->a2);
+  __m256 z1 = _mm256_loadu_ps(z1p), z2 = _mm256_loadu_ps(z2p);
+  for (size_t t = 0; t < frames; t++) {
+    __m256 v = _mm256_loadu_ps(x + t * stride);
+    __m256 y = madd256(b0, v, z1);
+    z1 = madd256(b1, v, madd256(na1, y, z2));
+    z2 = madd256(b2, v, _mm256_mul_ps(na2, y));
+    _mm256_storeu_ps(result + t * stride, y);
+  }
+  _mm256_storeu_ps(z1p, z1);
+  _mm256_storeu_ps(z2p, z2);
+}
+
+#elif defined(__ARM_NEON__)
+
+#define BIQUAD_CHANNELS 4
+
+static void biquad_section_channels(const BiquadCoefficients *k, float *z1p,
+                                    float *z2p, const float *x,
+                                    size_t stride, size_t frames,
+                                    float *result) {
+  const float32x4_t b0 = vdupq_n_f32(k->b0), b1 = vdupq_n_f32(k->b1);
+  const float32x4_t b2 = vdupq_n_f32(k->b2);
+  const float32x4_t na1 = vdupq_n_f32(-k->a1), na2 = vdupq_n_f32(-k->a2);
+  float32x4_t z1 = vld1q_f32(z1p), z2 = vld1q_f32(z2p);
+  for (size_t t = 0; t < frames; t++) {
+    float32x4_t v = vld1q_f32(x + t * stride);
+    float32x4_t y = vmlaq_f32(z1, b0, v);
+    z1 = vmlaq_f32(vmlaq_f32(z2, na1, y), b1, v);
+    z2 = vmlaq_f32(vmulq_f32(na2, y), b2, v);
+    vst1q_f32(result + t * stride, y);
+  }
+  vst1q_f32(z1p, z1);
+  vst1q_f32(z2p, z2);
+}
+
+#endif
+
+#if defined(__SSE4_1__) || defined(__ARM_NEON__)
+
+#ifdef __SSE4_1__
+typedef __m128 biquad_vec;
+typedef __m128 biquad_mask;
+#define biquad_load(ptr) _mm_loadu_ps(ptr)
+#define biquad_store(ptr, vec) _mm_storeu_ps(ptr, vec)
+#ifdef __FMA__
+#define biquad_madd(a, b, c) _mm_fmadd_ps(a, b, c)
+#else
+#define biquad_madd(a, b, c) _mm_add_ps(_mm_mul_ps(a, b), c)
+#endif
+#define biquad_mul(a, b) _mm_mul_ps(a, b)
+/* [v, y0, y1, y2] */
+#define biquad_shift_in(y, v) _mm_move_ss(_mm_castsi128_ps( \
+    _mm_slli_si128(_mm_castps_si128(y), 4)), _mm_set_ss(v))
+#define biquad_last(y) _mm_cvtss_f32(_mm_shuffle_ps(y, y, 3))
+#define biquad_load_mask(ptr) \
+    _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(ptr)))
+#define biquad_select(mask, a, b) _mm_blendv_ps(b, a, mask)
+#else
+typedef float32x4_t biquad_vec;
+typedef uint32x4_t biquad_mask;
+#define biquad_load(ptr) vld1q_f32(ptr)
+#define biquad_store(ptr, vec) vst1q_f32(ptr, vec)
+#define biquad_madd(a, b, c) vmlaq_f32(c, a, b)
+#define biquad_mul(a, b) vmulq_f32(a, b)
+#define biquad_shift_in(y, v) vextq_f32(vdupq_n_f32(v), y, 3)
+#define biquad_last(y) vgetq_lane_f32(y, 3)
+#define biquad_load_mask(ptr) vld1q_u32(ptr)
+#define biquad_select(mask, a, b) vbslq_f32(mask, a, b)
+#endif
+
+/// @brief Filters one channel with up to BIQUAD_LANES consecutive
+/// sections, each in its own vector lane.
+/// @details Lane l processes the sample t - l at the step t, taking the
+/// output of lane l - 1 of the previous step, so all the sections advance
+/// together. The missing sections are the identity ones. During the first
+/// and the last BIQUAD_LANES - 1 steps some lanes have no sample, and
+/// their delays are kept.
+static void biquad_sections_lanes(const BiquadCoefficients *k, int count,
+                                  float *state, int channels,
+                                  const float *x, size_t stride,
+                                  size_t frames, float *result) {
+  float b0[BIQUAD_LANES], b1[BIQUAD_LANES], b2[BIQUAD_LANES];
+  float na1[BIQUAD_LANES], na2[BIQUAD_LANES];
+  float z1[BIQUAD_LANES], z2[BIQUAD_LANES];
+  for (int l = 0; l < BIQUAD_LANES; l++) {
+    int active = l < count;
+    b0[l] = active? k[l].b0 : 1.f;
+    b1[l] = active? k[l].b1 : 0.f;
+    b2[l] = active? k[l].b2 : 0.f;
+    na1[l] = active? -k[l].a1 : 0.f;
+    na2[l] = active? -k[l].a2 : 0.f;
+    z1[l] = active? state[(l * 2) * channels] : 0.f;
+    z2[l] = active? state[(l * 2 + 1) * channels] : 0.f;
+  }
+  const biquad_vec vb0 = biquad_load(b0), vb1 = biquad_load(b1);
+  const biquad_vec vb2 = biquad_load(b2);
+  const biquad_vec vna1 = biquad_load(na1), vna2 = biquad_load(na2);
+  biquad_vec vz1 = biquad_load(z1), vz2 = biquad_load(z2);
+  biquad_vec y = vz1;
+  const size_t delay = BIQUAD_LANES - 1;
+  for (size_t t = 0; t < frames + delay; t++) {
+    biquad_vec v = biquad_shift_in(y, t < frames? x[t * stride] : 0.f);
+    y = biquad_madd(vb0, v, vz1);
+    biquad_vec nz1 = biquad_madd(vb1, v, biquad_madd(vna1, y, vz2));
+    biquad_vec nz2 = biquad_madd(vb2, v, biquad_mul(vna2, y));
+    if (t >= delay && t < frames) {
+      vz1 = nz1;
+      vz2 = nz2;
+    } else {
+      uint32_t bits[BIQUAD_LANES];
+      for (int l = 0; l < BIQUAD_LANES; l++) {
+        bits[l] = t >= (size_t)l && t - l < frames? UINT32_MAX : 0;
+      }
+      biquad_mask mask = biquad_load_mask(bits);
+      vz1 = biquad_select(mask, nz1, vz1);
+      vz2 = biquad_select(mask, nz2, vz2);
+    }
+    if (t >= delay) {
+      result[(t - delay) * stride] = biquad_last(y);
+    }
+  }
+  biquad_store(z1, vz1);
+  biquad_store(z2, vz2);
+  for (int l = 0; l < count; l++) {
+    state[(l * 2) * channels] = z1[l];
+    state[(l * 2 + 1) * channels] = z2[l];
+  }
+}
+
+#endif  // defined(__SSE4_1__) || defined(__ARM_NEON__)
+
+void biquad_cascade_process(int simd, BiquadCascade *cascade,
+                            const float *x, size_t frames, float *result) {
+  assert(cascade);
+  assert(x);
+  assert(result);
+  const int channels = cascade->channels, sections = cascade->sections;
+  const BiquadCoefficients *k = cascade->coefficients;
+  float *state = cascade->state;
+  int c = 0;
+  // Every section but the first one filters the result in place
+  if (simd) {
+#if defined(__AVX__) || defined(__ARM_NEON__)
+    for (; c + BIQUAD_CHANNELS <= channels; c += BIQUAD_CHANNELS) {
+      for (int s = 0; s < sections; s++) {
+        biquad_section_channels(
+            k + s, state + (s * 2) * channels + c,
+            state + (s * 2 + 1) * channels + c,
+            (s == 0? x : result) + c, channels, frames, result + c);
+      }
+    }
+#endif
+#if defined(__SSE4_1__) || defined(__ARM_NEON__)
+    if (sections > 1) {
+      for (; c < channels; c++) {
+        for (int s = 0; s < sections; s += BIQUAD_LANES) {
+          int count = sections - s < BIQUAD_LANES? sections - s : BIQUAD_LANES;
+          biquad_sections_lanes(k + s, count, state + (s * 2) * channels + c,
+                                channels, (s == 0? x : result) + c, channels,
+                                frames, result + c);
+        }
+      }
+    }
+#endif
+  }
+  for (; c < channels; c++) {
+    for (int s = 0; s < sections; s++) {
+      biquad_section(k + s, state + (s * 2) * channels + c,
+                     state + (s * 2 + 1) * channels + c,
+                     (s == 0? x : result) + c, channels, frames, result + c);
+    }
+  }
+}
+
+void biquad_cascade_reset(BiquadCascade *cascade) {
+  assert(cascade);
+  memsetf(cascade->state, 0.f,
+          (size_t)cascade->sections * 2 * cascade->channels);
+}
+
+void biquad_cascade_finalize(BiquadCascade *cascade) {
+  assert(cascade);
+  free(cascade->coefficients);
+  free_aligned(cascade->state);
+  cascade->coefficients = NULL;
+  cascade->state = NULL;
+}
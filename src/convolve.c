@@ -28,142 +28,101 @@
  *  under the License.
  */
 
-#ifndef NO_FFTF
+/* clock_gettime() is not in C99 */
+#define _POSIX_C_SOURCE 200112L
 #define LIBSIMD_IMPLEMENTATION
 #include "inc/simd/convolve.h"
 #include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <fftf/api.h>
+#include <time.h>
+#include <simd/fft.h>
 #include "inc/simd/arithmetic.h"
+#include "src/fft_plan_cache.h"
+#include "src/profile_counters.h"
 
-void convolve_simd(int simd,
-                   const float *__restrict x, size_t xLength,
-                   const float *__restrict h, size_t hLength,
-                   float *__restrict result) {
-  assert(x);
-  assert(h);
-  assert(result);
+/// @brief Rounds the size of a workspace part up to the alignment of
+/// malloc_aligned(), so that every part is aligned.
+static size_t convolve_workspace_align(size_t size) {
+  return (size + CONVOLUTION_WORKSPACE_ALIGNMENT - 1) &
+      ~(size_t)(CONVOLUTION_WORKSPACE_ALIGNMENT - 1);
+}
+
+/// @brief Returns the FFT length of the overlap-save method: h is zero
+/// padded to the next power of 2 greater than twice its length.
+static int convolve_overlap_save_length(size_t hLength) {
+  int L = hLength;
+  int log = 2;
+  while (L >>= 1) {
+    log++;
+  }
+  return 1 << log;
+}
+
+size_t convolve_overlap_save_workspace_size(size_t xLength, size_t hLength) {
   assert(xLength > 0);
   assert(hLength > 0);
-  for (int n = 0; n < (int)(xLength + hLength - 1); n++) {
-    float sum = 0.f;
-    int beg = n < (int)xLength? 0 : n - xLength + 1;
-    int end = n + 1;
-    if (end > (int)hLength) {
-      end = hLength;
-    }
-    if (simd) {
-#ifdef __AVX__
-      int simdEnd =  beg + ((end - beg) & ~7);
-      __m256 accum = _mm256_setzero_ps();
-      for (int m = beg; m < simdEnd; m += 8) {
-        __m256 xvec = _mm256_loadu_ps(x + n - m - 7);
-        __m256 hvec = _mm256_loadu_ps(h + m);
-        xvec = _mm256_permute2f128_ps(xvec, xvec, 1);
-        xvec = _mm256_permute_ps(xvec, 27);
-        __m256 mulres = _mm256_mul_ps(xvec, hvec);
-        accum = _mm256_add_ps(accum, mulres);
-      }
-      accum = _mm256_hadd_ps(accum, accum);
-      accum = _mm256_hadd_ps(accum, accum);
-      sum = _mm256_get_ps(accum, 0) + _mm256_get_ps(accum, 4);
-      for (int m = simdEnd; m < end; m++) {
-        sum += h[m] * x[n - m];
-      }
-    } else {
-#elif defined(__ARM_NEON__)
-      int simdEnd = beg + ((end - beg) & ~3);
-      float32x4_t accum = vdupq_n_f32(0.f);
-      for (int m = beg; m < simdEnd; m += 4) {
-        float32x4_t xvec = vld1q_f32(x + n - m - 3);
-        float32x4_t hvec = vld1q_f32(h + m);
-        xvec = vrev64q_f32(xvec);
-        xvec = vcombine_f32(vget_high_f32(xvec), vget_low_f32(xvec));
-        accum = vmlaq_f32(accum, xvec, hvec);
-      }
-      float32x2_t accum2 = vpadd_f32(vget_high_f32(accum),
-                                     vget_low_f32(accum));
-      sum = vget_lane_f32(accum2, 0) + vget_lane_f32(accum2, 1);
-      for (int m = simdEnd; m < end; m++) {
-        sum += h[m] * x[n - m];
-      }
-    } else {
-#else
-    } {
-#endif
-      for (int m = beg; m < end; m++) {
-        sum += h[m] * x[n - m];
-      }
-    }
-   result[n] = sum;
- }
+  // H with extra 2 float-s, the buffer belongs to the cached plans
+  int L = convolve_overlap_save_length(hLength);
+  return convolve_workspace_align((L + 2) * sizeof(float));
 }
 
-ConvolutionOverlapSaveHandle convolve_overlap_save_initialize(
-    size_t xLength, size_t hLength) {
+/// @brief Takes the buffer and the plans of length L from the cache.
+static void convolve_overlap_save_acquire_plans(
+    ConvolutionOverlapSaveHandle *handle, int L) {
+  handle->plans = fft_plans_acquire(L);
+  handle->fft_boiler_plate = handle->plans->buffer;
+  handle->fft_plan = handle->plans->forward;
+  handle->fft_inverse_plan = handle->plans->backward;
+  handle->L = &handle->plans->length;
+}
+
+ConvolutionOverlapSaveHandle convolve_overlap_save_initialize_in_place(
+    size_t xLength, size_t hLength, void *workspace) {
   assert(hLength < xLength / 2);
   assert(xLength > 0);
   assert(hLength > 0);
+  assert(workspace != NULL);
+  assert(((uintptr_t)workspace & (CONVOLUTION_WORKSPACE_ALIGNMENT - 1)) == 0);
 
   ConvolutionOverlapSaveHandle handle;
   size_t M = hLength;  //  usual designation
   handle.x_length = xLength;
   handle.h_length = hLength;
   handle.reverse = 0;
+  handle.workspace = NULL;
 
   // Do zero padding of h to the next power of 2 + extra 2 float-s
-  int L = M;
-  int log = 2;
-  while (L >>= 1) {
-    log++;
-  }
-  L = (1 << log);
-  handle.H = mallocf(L + 2);
-  assert(handle.H);
+  int L = convolve_overlap_save_length(M);
+  handle.H = workspace;
   memsetf(handle.H + M, 0.f, L - M);
-  handle.L = malloc(sizeof(L));
-  *handle.L = L;
-
-  handle.fft_boiler_plate = mallocf(L + 2);
-  assert(handle.fft_boiler_plate);
-
-  handle.fft_plan = fftf_init(FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD,
-                              FFTF_DIMENSION_1D, handle.L,
-                              FFTF_NO_OPTIONS, handle.fft_boiler_plate,
-                              handle.fft_boiler_plate);
-
-  assert(handle.fft_plan);
-
-  handle.fft_inverse_plan = fftf_init(
-      FFTF_TYPE_REAL, FFTF_DIRECTION_BACKWARD,
-      FFTF_DIMENSION_1D, handle.L,
-      FFTF_NO_OPTIONS, handle.fft_boiler_plate,
-      handle.fft_boiler_plate);
-  assert(handle.fft_inverse_plan);
+  convolve_overlap_save_acquire_plans(&handle, L);
+  return handle;
+}
 
+ConvolutionOverlapSaveHandle convolve_overlap_save_initialize(
+    size_t xLength, size_t hLength) {
+  void *workspace = malloc_aligned_ex(
+      convolve_overlap_save_workspace_size(xLength, hLength), kMemoryFlagHugePages);
+  assert(workspace);
+  ConvolutionOverlapSaveHandle handle =
+      convolve_overlap_save_initialize_in_place(xLength, hLength, workspace);
+  handle.workspace = workspace;
   return handle;
 }
 
 void convolve_overlap_save_finalize(ConvolutionOverlapSaveHandle handle) {
-  free(handle.fft_boiler_plate);
-  fftf_destroy(handle.fft_plan);
-  fftf_destroy(handle.fft_inverse_plan);
-  free(handle.L);
-  free(handle.H);
+  fft_plans_release(handle.plans);
+  free_aligned(handle.workspace);
 }
 
-void convolve_overlap_save(ConvolutionOverlapSaveHandle handle,
-                           const float *x,
-                           const float *h,
-                           float *result) {
-  assert(x != NULL);
-  assert(h != NULL);
-  assert(result != NULL);
-
-  size_t M = handle.h_length;  //  usual designation
+/// @brief Calculates H = FFT(paddedH, L).
+static void convolve_overlap_save_transform_kernel(
+    ConvolutionOverlapSaveHandle handle, const float *h) {
   int L = *handle.L;
-
   if (handle.reverse) {
     rmemcpyf(handle.fft_boiler_plate, h, handle.h_length);
   } else {
@@ -171,14 +130,30 @@ void convolve_overlap_save(ConvolutionOverlapSaveHandle handle,
   }
   memsetf(handle.fft_boiler_plate + handle.h_length, 0.f, L - handle.h_length);
 
-  // H = FFT(paddedH, L)
-  fftf_calc(handle.fft_plan);
+  fft_execute(handle.fft_plan);
   memcpy(handle.H, handle.fft_boiler_plate, (L + 2) * sizeof(float));
+}
+
+/// @brief Convolves x with the already transformed kernel in handle.H,
+/// producing the results from begin to end.
+/// @pre begin is a multiple of the step.
+static void convolve_overlap_save_range(ConvolutionOverlapSaveHandle handle,
+                                        const float *x, float *result,
+                                        size_t begin, size_t end) {
+  size_t M = handle.h_length;  //  usual designation
+  int L = *handle.L;
 
   int step = L - (M - 1);
-  // Note: no "#pragma omp parallel for" here since
-  // handle.fft_boiler_plate is shared AND FFTF should utilize all available resources.
-  for (size_t i = 0; i < handle.x_length + M - 1; i += step) {
+  if (end > handle.x_length + M - 1) {
+    end = handle.x_length + M - 1;
+  }
+  // The results are not read back, keep them out of the cache if they are
+  // going to evict H and the boiler plate anyway
+  float *(*store)(float *__restrict, const float *__restrict, size_t) =
+      (handle.x_length + M - 1) * sizeof(float) >=
+      memory_streaming_threshold()? memcpyf_stream : memcpyf;
+  // handle.fft_boiler_plate is shared, see convolve_overlap_save_parallel()
+  for (size_t i = begin; i < end; i += step) {
     // X = [zeros(1, M - 1), x, zeros(1, L-1)];
     // we must run FFT on X[i, i + L].
     // No X is really needed, some index arithmetic is used.
@@ -192,49 +167,174 @@ void convolve_overlap_save(ConvolutionOverlapSaveHandle handle,
         memsetf(handle.fft_boiler_plate + cl, 0.f, L - cl);
       }
     } else {
+      size_t cl = (size_t)step < handle.x_length? (size_t)step :
+          handle.x_length;
       memsetf(handle.fft_boiler_plate, 0.f, M - 1);
-      memcpy(handle.fft_boiler_plate + M - 1, x, step * sizeof(float));
+      memcpy(handle.fft_boiler_plate + M - 1, x, cl * sizeof(float));
+      memsetf(handle.fft_boiler_plate + M - 1 + cl, 0.f, step - cl);
     }
-    fftf_calc(handle.fft_plan);
+    fft_execute(handle.fft_plan);
 
     // fftBoilerPlate = fftBoilerPlate * H (complex arithmetic)
-    int cciStart = 0;
-#ifdef SIMD
-    cciStart = L;
-    for (int cci = 0; cci < L; cci += FLOAT_STEP) {
-      complex_multiply(handle.fft_boiler_plate + cci, handle.H + cci,
-                       handle.fft_boiler_plate + cci);
-    }
-#endif
-    for (int cci = cciStart; cci < L + 2; cci += 2) {
-      complex_multiply_na(handle.fft_boiler_plate + cci,
-                          handle.H + cci,
-                          handle.fft_boiler_plate + cci);
-    }
+    complex_multiply_array(handle.fft_boiler_plate, handle.H, L + 2,
+                           handle.fft_boiler_plate);
 
     // Return back from the Fourier representation
-    fftf_calc(handle.fft_inverse_plan);
+    fft_execute(handle.fft_inverse_plan);
     // Normalize
     real_multiply_scalar(handle.fft_boiler_plate + M - 1, step, 1.0f / L,
                          handle.fft_boiler_plate + M - 1);
 
     if (i + step < handle.x_length + handle.h_length) {
-      memcpy(result + i, handle.fft_boiler_plate + M - 1,
-             step * sizeof(float));
+      store(result + i, handle.fft_boiler_plate + M - 1, step);
     } else {
-      memcpy(result + i, handle.fft_boiler_plate + M - 1,
-             (handle.x_length + handle.h_length - 1 - i) * sizeof(float));
+      store(result + i, handle.fft_boiler_plate + M - 1,
+            handle.x_length + handle.h_length - 1 - i);
     }
   }
 }
 
-ConvolutionFFTHandle convolve_fft_initialize(size_t xLength, size_t hLength) {
-  assert(hLength > 0);
-  assert(xLength > 0);
+/// @brief Convolves x with the already transformed kernel in handle.H.
+static void convolve_overlap_save_blocks(ConvolutionOverlapSaveHandle handle,
+                                         const float *x, float *result) {
+  convolve_overlap_save_range(handle, x, result, 0,
+                              handle.x_length + handle.h_length - 1);
+}
 
-  ConvolutionFFTHandle handle;
+void convolve_overlap_save(ConvolutionOverlapSaveHandle handle,
+                           const float *x,
+                           const float *h,
+                           float *result) {
+  assert(x != NULL);
+  assert(h != NULL);
+  assert(result != NULL);
+
+  convolve_overlap_save_transform_kernel(handle, h);
+  convolve_overlap_save_blocks(handle, x, result);
+}
+
+ConvolutionOverlapSaveParallelHandle
+convolve_overlap_save_parallel_initialize(size_t xLength, size_t hLength,
+                                          ThreadPool *pool, int threads) {
+  assert(threads >= 0);
+  ConvolutionOverlapSaveParallelHandle handle;
+  handle.pool = pool != NULL? pool : thread_pool_default();
+  handle.threads = thread_pool_size(handle.pool);
+  if (threads > 0 && threads < handle.threads) {
+    handle.threads = threads;
+  }
+  // Every thread needs its own buffer and plans
+  handle.workers = malloc_aligned(handle.threads * sizeof(handle.workers[0]));
+  assert(handle.workers);
+  for (int i = 0; i < handle.threads; i++) {
+    handle.workers[i] = convolve_overlap_save_initialize(xLength, hLength);
+  }
+  return handle;
+}
+
+void convolve_overlap_save_parallel_finalize(
+    ConvolutionOverlapSaveParallelHandle handle) {
+  for (int i = 0; i < handle.threads; i++) {
+    convolve_overlap_save_finalize(handle.workers[i]);
+  }
+  free_aligned(handle.workers);
+}
+
+typedef struct {
+  const ConvolutionOverlapSaveParallelHandle *handle;
+  const float *x;
+  float *result;
+  size_t blocksPerTask;
+  size_t step;
+} OverlapSaveTask;
+
+static void convolve_overlap_save_task(void *arg, int index) {
+  const OverlapSaveTask *task = arg;
+  size_t begin = index * task->blocksPerTask * task->step;
+  convolve_overlap_save_range(task->handle->workers[index], task->x,
+                              task->result, begin,
+                              begin + task->blocksPerTask * task->step);
+}
+
+void convolve_overlap_save_parallel(ConvolutionOverlapSaveParallelHandle handle,
+                                    const float *x, const float *h,
+                                    float *result) {
+  assert(x != NULL);
+  assert(h != NULL);
+  assert(result != NULL);
+
+  ConvolutionOverlapSaveHandle *first = handle.workers;
+  convolve_overlap_save_transform_kernel(*first, h);
+  int L = *first->L;
+  for (int i = 1; i < handle.threads; i++) {
+    memcpy(handle.workers[i].H, first->H, (L + 2) * sizeof(float));
+  }
+  OverlapSaveTask task;
+  task.handle = &handle;
+  task.x = x;
+  task.result = result;
+  task.step = L - (first->h_length - 1);
+  size_t blocks = (first->x_length + first->h_length - 1 + task.step - 1) /
+      task.step;
+  // One contiguous range of blocks per thread, they use its buffers
+  task.blocksPerTask = (blocks + handle.threads - 1) / handle.threads;
+  int tasks = (blocks + task.blocksPerTask - 1) / task.blocksPerTask;
+  thread_pool_run(handle.pool, tasks, handle.threads,
+                  convolve_overlap_save_task, &task);
+}
+
+static int smooth_fft_lengths = 1;
+
+void convolve_set_smooth_fft_lengths(int enabled) {
+  smooth_fft_lengths = enabled;
+}
+
+int convolve_smooth_fft_lengths(void) {
+  return smooth_fft_lengths;
+}
 
-  int M = xLength + hLength - 1;
+/// @brief Returns the cheapest even length of the form 2^a 3^b 5^c which
+/// is not less than the specified one.
+/// @details The cost of the transform is estimated as m log2(m), radix 3
+/// and radix 5 passes being 10% and 20% more expensive per element than
+/// the radix 2 ones.
+static int convolve_smooth_length(int length) {
+  // log2(3) and log2(5) with the penalties
+  const double cost3 = 1.1 * 1.5849625, cost5 = 1.2 * 2.3219281;
+  int best = 2, a = 1;
+  while (best < length) {
+    best <<= 1;
+    a++;
+  }
+  double bestCost = (double)best * a;
+  for (long p2 = 2, i = 1; p2 < best; p2 <<= 1, i++) {
+    for (long p3 = p2, j = 0; p3 < best; p3 *= 3, j++) {
+      for (long p5 = p3, k = 0; p5 < best; p5 *= 5, k++) {
+        if (p5 < length) {
+          continue;
+        }
+        double cost = p5 * (i + j * cost3 + k * cost5);
+        if (cost < bestCost) {
+          best = p5;
+          bestCost = cost;
+        }
+        // Greater multiples are only more expensive
+        break;
+      }
+    }
+  }
+  return best;
+}
+
+int convolve_fft_good_length(int M) {
+  assert(M > 0);
+  if (smooth_fft_lengths) {
+    return convolve_smooth_length(M);
+  }
+  if (M < 2) {
+    // The real transforms are of even lengths
+    return 2;
+  }
   if ((M & (M - 1)) != 0) {
     int log = 1;
     while (M >>= 1) {
@@ -242,48 +342,71 @@ ConvolutionFFTHandle convolve_fft_initialize(size_t xLength, size_t hLength) {
     }
     M = (1 << log);
   }
-  handle.M = malloc(sizeof(M));
-  *handle.M = M;
+  return M;
+}
+
+/// @brief Returns the FFT length of the FFT method, which fits the result.
+static int convolve_fft_length(size_t xLength, size_t hLength) {
+  return convolve_fft_good_length(xLength + hLength - 1);
+}
+
+size_t convolve_fft_workspace_size(size_t xLength, size_t hLength) {
+  assert(xLength > 0);
+  assert(hLength > 0);
+  // H with extra 2 float-s and the input pointers, X belongs to the cached
+  // plans
+  int M = convolve_fft_length(xLength, hLength);
+  return convolve_workspace_align((M + 2) * sizeof(float)) +
+      2 * sizeof(float *);
+}
+
+/// @brief Takes X and the plans of length M from the cache.
+static void convolve_fft_acquire_plans(ConvolutionFFTHandle *handle, int M) {
+  handle->plans = fft_plans_acquire(M);
+  handle->inputs[0] = handle->plans->buffer;
+  handle->fft_plan = handle->plans->forward;
+  handle->fft_inverse_plan = handle->plans->backward;
+  handle->M = &handle->plans->length;
+}
+
+ConvolutionFFTHandle convolve_fft_initialize_in_place(
+    size_t xLength, size_t hLength, void *workspace) {
+  assert(hLength > 0);
+  assert(xLength > 0);
+  assert(workspace != NULL);
+  assert(((uintptr_t)workspace & (CONVOLUTION_WORKSPACE_ALIGNMENT - 1)) == 0);
+
+  ConvolutionFFTHandle handle;
+
+  int M = convolve_fft_length(xLength, hLength);
+  size_t part = convolve_workspace_align((M + 2) * sizeof(float));
+  char *ptr = workspace;
   handle.x_length = xLength;
   handle.h_length = hLength;
   handle.reverse = 0;
+  handle.workspace = NULL;
 
   // Now M is the nearest greater than or equal power of 2.
-  // Do zero padding of x and h
   // Allocate 2 extra samples for the M/2 complex number.
-  float *X = mallocf(M + 2);
-  memsetf(X + xLength, 0.f, M + 2 - xLength);
-  float *H = mallocf(M + 2);
-  memsetf(H + hLength, 0.f, M + 2 - hLength);
-
-  handle.inputs = malloc(2 * sizeof(float *));
-  handle.inputs[0] = X;
-  handle.inputs[1] = H;
-
-  // Prepare the forward FFT plan
-  handle.fft_plan = fftf_init_batch(
-      FFTF_TYPE_REAL, FFTF_DIRECTION_FORWARD,
-      FFTF_DIMENSION_1D, handle.M,
-      FFTF_NO_OPTIONS, 2, (const float *const *)handle.inputs,
-      handle.inputs);
-  assert(handle.fft_plan);
+  handle.inputs = (float **)(ptr + part);
+  handle.inputs[1] = (float *)ptr;
+  convolve_fft_acquire_plans(&handle, M);
+  return handle;
+}
 
-  // Prepare the inverse FFT plan
-  handle.fft_inverse_plan = fftf_init(
-    FFTF_TYPE_REAL, FFTF_DIRECTION_BACKWARD,
-    FFTF_DIMENSION_1D, handle.M,
-    FFTF_NO_OPTIONS, X, X);
-  assert(handle.fft_inverse_plan);
+ConvolutionFFTHandle convolve_fft_initialize(size_t xLength, size_t hLength) {
+  void *workspace = malloc_aligned_ex(
+      convolve_fft_workspace_size(xLength, hLength), kMemoryFlagHugePages);
+  assert(workspace);
+  ConvolutionFFTHandle handle =
+      convolve_fft_initialize_in_place(xLength, hLength, workspace);
+  handle.workspace = workspace;
   return handle;
 }
 
 void convolve_fft_finalize(ConvolutionFFTHandle handle) {
-  free(handle.inputs[0]);
-  free(handle.inputs[1]);
-  free(handle.inputs);
-  free(handle.M);
-  fftf_destroy(handle.fft_plan);
-  fftf_destroy(handle.fft_inverse_plan);
+  fft_plans_release(handle.plans);
+  free_aligned(handle.workspace);
 }
 
 void convolve_fft(ConvolutionFFTHandle handle,
@@ -298,74 +421,761 @@ void convolve_fft(ConvolutionFFTHandle handle,
   int xLength = handle.x_length;
   int hLength = handle.h_length;
   int M = *handle.M;
-  memcpy(X, x, xLength * sizeof(x[0]));
+  // X is the only transform buffer, so fft(H) goes first.
+  // The padding is overwritten by the previous call's transforms.
   if (handle.reverse) {
-    rmemcpyf(H, h, hLength);
+    rmemcpyf(X, h, hLength);
   } else {
-    memcpy(H, h, hLength * sizeof(h[0]));
+    memcpy(X, h, hLength * sizeof(h[0]));
   }
+  memsetf(X + hLength, 0.f, M + 2 - hLength);
+  fft_execute(handle.fft_plan);
+  memcpy(H, X, (M + 2) * sizeof(float));
 
-  // fft(X), fft(H)
-  fftf_calc(handle.fft_plan);
+  memcpy(X, x, xLength * sizeof(x[0]));
+  memsetf(X + xLength, 0.f, M + 2 - xLength);
+  fft_execute(handle.fft_plan);
 
-  int istart = 0;
-#ifdef SIMD
-  istart = M;
-  for (int i = 0; i < M; i += FLOAT_STEP) {
-    complex_multiply(X + i, H + i, X + i);
-  }
-#endif
-  for (int i = istart; i < M + 2; i += 2) {
-    complex_multiply_na(X + i, H + i, X + i);
-  }
+  complex_multiply_array(X, H, M + 2, X);
 
   // Return back from the Fourier representation
-  fftf_calc(handle.fft_inverse_plan);
+  fft_execute(handle.fft_inverse_plan);
   // Normalize
   real_multiply_scalar(X, xLength + hLength - 1, 1.0f / M, result);
 }
 
-ConvolutionHandle convolve_initialize(size_t xLength, size_t hLength) {
-  ConvolutionHandle handle;
+/// @brief Same as convolve_fft_initialize(), but H is transformed here once.
+static ConvolutionFFTHandle convolve_fft_initialize_with_kernel(
+    size_t xLength, const float *h, size_t hLength) {
+  ConvolutionFFTHandle handle = convolve_fft_initialize(xLength, hLength);
+  float *X = handle.inputs[0];
+  float *H = handle.inputs[1];
+  int M = *handle.M;
+  memcpy(X, h, hLength * sizeof(h[0]));
+  memsetf(X + hLength, 0.f, M + 2 - hLength);
+  fft_execute(handle.fft_plan);
+  // Normalize here instead of the result
+  real_multiply_scalar(X, M + 2, 1.0f / M, H);
+  return handle;
+}
+
+static void convolve_fft_with_kernel(ConvolutionFFTHandle handle,
+                                     const float *x, float *result) {
+  float *X = handle.inputs[0];
+  float *H = handle.inputs[1];
+  int xLength = handle.x_length;
+  int M = *handle.M;
+  memcpy(X, x, xLength * sizeof(x[0]));
+  memsetf(X + xLength, 0.f, M + 2 - xLength);
+  fft_execute(handle.fft_plan);
+  complex_multiply_array(X, H, M + 2, X);
+  fft_execute(handle.fft_inverse_plan);
+  memcpyf(result, X, xLength + handle.h_length - 1);
+}
+
+ConvolutionStreamHandle convolve_stream_initialize(
+    const float *h, size_t hLength, size_t blockLength) {
+  assert(h != NULL);
+  assert(hLength > 0);
+  assert(blockLength > 0);
+
+  ConvolutionStreamHandle handle;
+  size_t M = hLength;  //  usual designation
+  handle.h_length = hLength;
+  handle.block_length = blockLength;
+
+  // The frame is [the last M - 1 samples, the block], padded to a power of 2
+  int L = 2;
+  while ((size_t)L < M - 1 + blockLength) {
+    L <<= 1;
+  }
+  handle.plans = fft_plans_acquire(L);
+  handle.fft_boiler_plate = handle.plans->buffer;
+  handle.fft_plan = handle.plans->forward;
+  handle.fft_inverse_plan = handle.plans->backward;
+  handle.L = &handle.plans->length;
+
+  handle.history = mallocf(M);
+  assert(handle.history);
+  memsetf(handle.history, 0.f, M);
+
+  handle.H = mallocf(L + 2);
+  assert(handle.H);
+
+  // H = FFT(paddedH, L) / L, so that the results need no normalization
+  memcpy(handle.fft_boiler_plate, h, M * sizeof(float));
+  memsetf(handle.fft_boiler_plate + M, 0.f, L + 2 - M);
+  fft_execute(handle.fft_plan);
+  real_multiply_scalar(handle.fft_boiler_plate, L + 2, 1.0f / L, handle.H);
+  return handle;
+}
+
+void convolve_stream_finalize(ConvolutionStreamHandle handle) {
+  fft_plans_release(handle.plans);
+  free_aligned(handle.H);
+  free_aligned(handle.history);
+}
+
+void convolve_stream_reset(ConvolutionStreamHandle handle) {
+  memsetf(handle.history, 0.f, handle.h_length);
+}
+
+void convolve_stream_process(ConvolutionStreamHandle handle,
+                             const float *x, size_t length,
+                             float *result) {
+  assert(x != NULL);
+  assert(result != NULL);
+  assert(length <= handle.block_length);
+
+  size_t M = handle.h_length;  //  usual designation
+  int L = *handle.L;
+  if (length == 0) {
+    return;
+  }
+
+  // The frame is [history, x, zeros], the aliased samples are before M - 1
+  memcpy(handle.fft_boiler_plate, handle.history, (M - 1) * sizeof(float));
+  memcpy(handle.fft_boiler_plate + M - 1, x, length * sizeof(float));
+  memsetf(handle.fft_boiler_plate + M - 1 + length, 0.f,
+          L + 2 - (M - 1 + length));
+
+  // Update the history before result overwrites x
+  if (length >= M - 1) {
+    memcpy(handle.history, x + length - (M - 1), (M - 1) * sizeof(float));
+  } else {
+    memmove(handle.history, handle.history + length,
+            (M - 1 - length) * sizeof(float));
+    memcpy(handle.history + M - 1 - length, x, length * sizeof(float));
+  }
+
+  fft_execute(handle.fft_plan);
+  complex_multiply_array(handle.fft_boiler_plate, handle.H, L + 2,
+                         handle.fft_boiler_plate);
+  fft_execute(handle.fft_inverse_plan);
+  memcpy(result, handle.fft_boiler_plate + M - 1, length * sizeof(float));
+}
+
+ConvolutionBatchHandle convolve_batch_initialize(
+    size_t xLength, const float *h, size_t hLength, int channels) {
+  assert(h != NULL);
+  assert(xLength > 0);
+  assert(hLength > 0);
+  assert(channels > 0);
+
+  ConvolutionBatchHandle handle;
   handle.x_length = xLength;
   handle.h_length = hLength;
-#ifdef __ARM_NEON__
-  if (xLength > hLength * 2) {
-    if (xLength > 200) {
-      handle.algorithm = kConvolutionAlgorithmOverlapSave;
-      handle.handle.os = convolve_overlap_save_initialize(xLength, hLength);
+  handle.channels = channels;
+
+  int M = 1;
+  while ((size_t)M < xLength + hLength - 1) {
+    M <<= 1;
+  }
+  handle.M = malloc_aligned(sizeof(M));
+  *handle.M = M;
+
+  // Keep every channel aligned, 2 extra samples are for M/2 complex number
+  handle.stride = (M + 2 + 15) & ~15;
+  handle.buffers = mallocf_ex(handle.stride * channels, kMemoryFlagHugePages);
+  assert(handle.buffers);
+  handle.inputs = malloc_aligned(channels * sizeof(float *));
+  assert(handle.inputs);
+  for (int i = 0; i < channels; i++) {
+    handle.inputs[i] = handle.buffers + i * handle.stride;
+  }
+
+  // H = FFT(paddedH, M) / M, so that the results need no normalization
+  handle.H = mallocf(M + 2);
+  assert(handle.H);
+  memcpy(handle.H, h, hLength * sizeof(h[0]));
+  memsetf(handle.H + hLength, 0.f, M + 2 - hLength);
+  FFTPlan *hplan = fft_initialize(kFFTTypeReal, kFFTDirectionForward, M,
+                                  handle.H, handle.H, 0);
+  assert(hplan);
+  fft_execute(hplan);
+  fft_finalize(hplan);
+  real_multiply_scalar(handle.H, M + 2, 1.0f / M, handle.H);
+
+  handle.fft_plan = fft_initialize_batch(
+      kFFTTypeReal, kFFTDirectionForward, M, channels,
+      (const float *const *)handle.inputs, handle.inputs, 0);
+  assert(handle.fft_plan);
+  handle.fft_inverse_plan = fft_initialize_batch(
+      kFFTTypeReal, kFFTDirectionBackward, M, channels,
+      (const float *const *)handle.inputs, handle.inputs, 0);
+  assert(handle.fft_inverse_plan);
+  return handle;
+}
+
+void convolve_batch_finalize(ConvolutionBatchHandle handle) {
+  fft_finalize(handle.fft_plan);
+  fft_finalize(handle.fft_inverse_plan);
+  free_aligned(handle.buffers);
+  free_aligned(handle.inputs);
+  free_aligned(handle.H);
+  free_aligned(handle.M);
+}
+
+/// @brief Transforms the channels which are already copied to
+/// handle.inputs, multiplies them by H and transforms back.
+static void convolve_batch_calc(ConvolutionBatchHandle handle) {
+  int M = *handle.M;
+  fft_execute(handle.fft_plan);
+  for (int i = 0; i < handle.channels; i++) {
+    complex_multiply_array(handle.inputs[i], handle.H, M + 2,
+                           handle.inputs[i]);
+  }
+  fft_execute(handle.fft_inverse_plan);
+}
+
+static void convolve_batch_load(ConvolutionBatchHandle handle, int channel,
+                                const float *x) {
+  int M = *handle.M;
+  float *X = handle.inputs[channel];
+  memcpy(X, x, handle.x_length * sizeof(x[0]));
+  memsetf(X + handle.x_length, 0.f, M + 2 - handle.x_length);
+}
+
+void convolve_batch(ConvolutionBatchHandle handle,
+                    const float *const *x, float *const *result) {
+  assert(x != NULL);
+  assert(result != NULL);
+  for (int i = 0; i < handle.channels; i++) {
+    convolve_batch_load(handle, i, x[i]);
+  }
+  convolve_batch_calc(handle);
+  size_t length = handle.x_length + handle.h_length - 1;
+  for (int i = 0; i < handle.channels; i++) {
+    memcpy(result[i], handle.inputs[i], length * sizeof(float));
+  }
+}
+
+void convolve_batch_strided(ConvolutionBatchHandle handle,
+                            const float *x, size_t xStride,
+                            float *result, size_t resultStride) {
+  assert(x != NULL);
+  assert(result != NULL);
+  size_t length = handle.x_length + handle.h_length - 1;
+  assert(handle.channels == 1 || xStride >= handle.x_length);
+  assert(handle.channels == 1 || resultStride >= length);
+  for (int i = 0; i < handle.channels; i++) {
+    convolve_batch_load(handle, i, x + i * xStride);
+  }
+  convolve_batch_calc(handle);
+  for (int i = 0; i < handle.channels; i++) {
+    memcpy(result + i * resultStride, handle.inputs[i],
+           length * sizeof(float));
+  }
+}
+
+/// @brief The distance between the real and the imaginary parts of
+/// a spectrum of the frame of length N in the split layout. H and fdl keep
+/// the spectra split, so the delay line is multiplied without shuffles.
+static size_t convolve_partitioned_plane(int N) {
+  return (N / 2 + 1 + 15) & ~(size_t)15;
+}
+
+/// @brief Allocates the partitioned convolution without the filter.
+/// @param H The spectra of the filter parts to share, or NULL to allocate
+/// them.
+static ConvolutionPartitionedHandle convolve_partitioned_create(
+    size_t hLength, size_t blockLength, float *H) {
+  assert(hLength > 0);
+  assert(blockLength > 0);
+
+  ConvolutionPartitionedHandle handle;
+  handle.h_length = hLength;
+  handle.block_length = blockLength;
+  handle.partitions = (hLength + blockLength - 1) / blockLength;
+  handle.reverse = 0;
+  // The frame is [the last N - B samples, the current block], N is at least
+  // 2 * B and rounded up to a length which the FFT supports
+  int N = convolve_fft_good_length(2 * blockLength);
+  handle.plans = fft_plans_acquire(N);
+  handle.fft_boiler_plate = handle.plans->buffer;
+  handle.fft_plan = handle.plans->forward;
+  handle.fft_inverse_plan = handle.plans->backward;
+  handle.N = &handle.plans->length;
+  handle.position = malloc_aligned(sizeof(int));
+  assert(handle.position);
+
+  size_t spectrum = 2 * convolve_partitioned_plane(N);
+  handle.H = H != NULL? H :
+      mallocf_ex(spectrum * handle.partitions, kMemoryFlagHugePages);
+  handle.fdl = mallocf_ex(spectrum * handle.partitions, kMemoryFlagHugePages);
+  handle.accumulator = mallocf(spectrum);
+  handle.history = mallocf(N - blockLength);
+  handle.block = mallocf(blockLength);
+  assert(handle.H && handle.fdl && handle.accumulator && handle.history &&
+         handle.block);
+  convolve_partitioned_reset(handle);
+  return handle;
+}
+
+/// @brief Calculates the spectra of the filter parts, scaled by 1 / N,
+/// so that the results need no normalization.
+static void convolve_partitioned_transform_kernel(
+    ConvolutionPartitionedHandle handle, const float *h) {
+  int N = *handle.N;
+  size_t B = handle.block_length;
+  size_t plane = convolve_partitioned_plane(N);
+  for (int p = 0; p < handle.partitions; p++) {
+    size_t offset = p * B;
+    size_t length = handle.h_length - offset < B? handle.h_length - offset : B;
+    if (handle.reverse) {
+      rmemcpyf(handle.fft_boiler_plate,
+               h + handle.h_length - offset - length, length);
     } else {
-      handle.algorithm = kConvolutionAlgorithmBruteForce;
+      memcpy(handle.fft_boiler_plate, h + offset, length * sizeof(float));
     }
-  } else {
-    if (xLength > 50) {
-      handle.algorithm = kConvolutionAlgorithmFFT;
-      handle.handle.fft = convolve_fft_initialize(xLength, hLength);
+    memsetf(handle.fft_boiler_plate + length, 0.f, N + 2 - length);
+    fft_execute(handle.fft_plan);
+    real_multiply_scalar(handle.fft_boiler_plate, N + 2, 1.0f / N,
+                         handle.fft_boiler_plate);
+    float *H = handle.H + p * 2 * plane;
+    complex_split(handle.fft_boiler_plate, N / 2 + 1, H, H + plane);
+  }
+}
+
+ConvolutionPartitionedHandle convolve_partitioned_initialize(
+    const float *h, size_t hLength, size_t blockLength) {
+  assert(h != NULL);
+  ConvolutionPartitionedHandle handle = convolve_partitioned_create(
+      hLength, blockLength, NULL);
+  convolve_partitioned_transform_kernel(handle, h);
+  return handle;
+}
+
+/// @brief Frees everything but the spectra of the filter parts.
+static void convolve_partitioned_destroy_state(
+    ConvolutionPartitionedHandle handle) {
+  fft_plans_release(handle.plans);
+  free_aligned(handle.fdl);
+  free_aligned(handle.accumulator);
+  free_aligned(handle.history);
+  free_aligned(handle.block);
+  free_aligned(handle.position);
+}
+
+void convolve_partitioned_finalize(ConvolutionPartitionedHandle handle) {
+  free_aligned(handle.H);
+  convolve_partitioned_destroy_state(handle);
+}
+
+void convolve_partitioned_reset(ConvolutionPartitionedHandle handle) {
+  memsetf(handle.history, 0.f, *handle.N - handle.block_length);
+  memsetf(handle.fdl, 0.f,
+          2 * convolve_partitioned_plane(*handle.N) * handle.partitions);
+  *handle.position = 0;
+}
+
+void convolve_partitioned_process(ConvolutionPartitionedHandle handle,
+                                  const float *x, float *result) {
+  assert(x != NULL);
+  assert(result != NULL);
+
+  int N = *handle.N;
+  int P = handle.partitions;
+  size_t B = handle.block_length;
+  size_t K = N / 2 + 1;
+  size_t plane = convolve_partitioned_plane(N);
+  size_t spectrum = 2 * plane;
+
+  size_t kept = N - B;
+  memcpy(handle.fft_boiler_plate, handle.history, kept * sizeof(float));
+  memcpy(handle.fft_boiler_plate + kept, x, B * sizeof(float));
+  memcpy(handle.history, handle.fft_boiler_plate + B, kept * sizeof(float));
+  handle.fft_boiler_plate[N] = handle.fft_boiler_plate[N + 1] = 0;
+  fft_execute(handle.fft_plan);
+
+  // The frequency domain delay line, the newest spectrum is at position
+  int position = (*handle.position + 1) % P;
+  *handle.position = position;
+  float *newest = handle.fdl + position * spectrum;
+  complex_split(handle.fft_boiler_plate, K, newest, newest + plane);
+
+  // Y = sum(X[k - p] * H[p]), split once per block instead of per partition
+  float *Y = handle.accumulator;
+  complex_multiply_split(newest, newest + plane, handle.H, handle.H + plane,
+                         K, Y, Y + plane);
+  for (int p = 1; p < P; p++) {
+    const float *X = handle.fdl + ((position - p + P) % P) * spectrum;
+    const float *H = handle.H + p * spectrum;
+    complex_multiply_add_split(X, X + plane, H, H + plane, K, Y, Y + plane);
+  }
+  complex_interleave(Y, Y + plane, K, handle.fft_boiler_plate);
+  fft_execute(handle.fft_inverse_plan);
+  // The first N - B samples are aliased
+  memcpy(result, handle.fft_boiler_plate + kept, B * sizeof(float));
+}
+
+/// @brief Convolves the whole signal block by block with the already
+/// transformed filter.
+static void convolve_partitioned_signal(ConvolutionPartitionedHandle handle,
+                                        const float *x, size_t xLength,
+                                        float *result) {
+  size_t B = handle.block_length;
+  size_t length = xLength + handle.h_length - 1;
+  convolve_partitioned_reset(handle);
+  for (size_t i = 0; i < length; i += B) {
+    const float *input = x + i;
+    if (i + B > xLength) {
+      // The end of the signal and the zeros which flush the tail
+      size_t cl = i < xLength? xLength - i : 0;
+      memcpy(handle.block, x + i, cl * sizeof(float));
+      memsetf(handle.block + cl, 0.f, B - cl);
+      input = handle.block;
+    }
+    if (i + B <= length) {
+      convolve_partitioned_process(handle, input, result + i);
     } else {
-      handle.algorithm = kConvolutionAlgorithmBruteForce;
+      convolve_partitioned_process(handle, input, handle.block);
+      memcpy(result + i, handle.block, (length - i) * sizeof(float));
     }
   }
+}
+
+/// @brief Chooses the block of the partitioned method when the latency
+/// does not matter: the FFT cost grows with it, the delay line cost falls.
+static size_t convolve_partitioned_block_length(size_t hLength) {
+  size_t block = 64;
+  while (block < 8192 && block * block < hLength * 16) {
+    block <<= 1;
+  }
+  return block;
+}
+
+/// @brief The thresholds measured on a single machine, used when
+/// autotuning is off.
+static ConvolutionAlgorithm convolve_heuristic_algorithm(size_t xLength,
+                                                         size_t hLength) {
+#ifdef __ARM_NEON__
+  const size_t fftThreshold = 50;
 #else
+  const size_t fftThreshold = 350;
+#endif
   if (xLength > hLength * 2) {
     if (xLength > 200) {
-      handle.algorithm = kConvolutionAlgorithmOverlapSave;
+      return kConvolutionAlgorithmOverlapSave;
+    }
+    return kConvolutionAlgorithmBruteForce;
+  }
+  if (xLength > fftThreshold) {
+    return kConvolutionAlgorithmFFT;
+  }
+  return kConvolutionAlgorithmBruteForce;
+}
+
+ConvolutionHandle convolve_initialize_algorithm(
+    size_t xLength, size_t hLength, ConvolutionAlgorithm algorithm) {
+  ConvolutionHandle handle;
+  handle.algorithm = algorithm;
+  handle.x_length = xLength;
+  handle.h_length = hLength;
+  handle.kernel = NULL;
+  switch (algorithm) {
+    case kConvolutionAlgorithmFFT:
+      handle.handle.fft = convolve_fft_initialize(xLength, hLength);
+      break;
+    case kConvolutionAlgorithmOverlapSave:
       handle.handle.os = convolve_overlap_save_initialize(xLength, hLength);
-    } else {
-      handle.algorithm = kConvolutionAlgorithmBruteForce;
+      break;
+    case kConvolutionAlgorithmPartitioned:
+      handle.handle.partitioned = convolve_partitioned_create(
+          hLength, convolve_partitioned_block_length(hLength), NULL);
+      break;
+    case kConvolutionAlgorithmBruteForce:
+      break;
+  }
+  return handle;
+}
+
+void convolve_plan_cache_prepare(size_t xLength, size_t hLength,
+                                 ConvolutionAlgorithm algorithm, int count) {
+  assert(xLength > 0);
+  assert(hLength > 0);
+  assert(count >= 0);
+  int length;
+  switch (algorithm) {
+    case kConvolutionAlgorithmFFT:
+      length = convolve_fft_length(xLength, hLength);
+      break;
+    case kConvolutionAlgorithmOverlapSave:
+      length = convolve_overlap_save_length(hLength);
+      break;
+    case kConvolutionAlgorithmPartitioned:
+      length = convolve_fft_good_length(
+          2 * convolve_partitioned_block_length(hLength));
+      break;
+    case kConvolutionAlgorithmBruteForce:
+    default:
+      return;
+  }
+  FFTPlans *acquired = NULL;
+  for (int i = 0; i < count; i++) {
+    FFTPlans *plans = fft_plans_acquire(length);
+    plans->next = acquired;
+    acquired = plans;
+  }
+  while (acquired != NULL) {
+    FFTPlans *next = acquired->next;
+    fft_plans_release(acquired);
+    acquired = next;
+  }
+}
+
+static int autotuning_enabled;
+static pthread_mutex_t autotuning_lock = PTHREAD_MUTEX_INITIALIZER;
+
+typedef struct {
+  size_t x_length;
+  size_t h_length;
+  ConvolutionAlgorithm algorithm;
+} AutotuningEntry;
+
+/* Protected by autotuning_lock */
+static AutotuningEntry *autotuning_table;
+static size_t autotuning_table_size;
+static size_t autotuning_table_capacity;
+
+/* The first line of the autotuning table file */
+#define CONVOLUTION_AUTOTUNING_HEADER "# veles.simd convolution autotuning 1"
+
+static const char *algorithm_names[] = {
+  "brute_force", "fft", "overlap_save", "partitioned"
+};
+
+/// @pre autotuning_lock is held.
+static AutotuningEntry *autotuning_find(size_t xLength, size_t hLength) {
+  for (size_t i = 0; i < autotuning_table_size; i++) {
+    if (autotuning_table[i].x_length == xLength &&
+        autotuning_table[i].h_length == hLength) {
+      return autotuning_table + i;
     }
+  }
+  return NULL;
+}
+
+/// @pre autotuning_lock is held.
+static void autotuning_insert(size_t xLength, size_t hLength,
+                              ConvolutionAlgorithm algorithm) {
+  AutotuningEntry *entry = autotuning_find(xLength, hLength);
+  if (entry == NULL) {
+    if (autotuning_table_size == autotuning_table_capacity) {
+      size_t capacity = autotuning_table_capacity * 2 + 16;
+      AutotuningEntry *table = realloc(autotuning_table,
+                                       capacity * sizeof(AutotuningEntry));
+      if (table == NULL) {
+        return;
+      }
+      autotuning_table = table;
+      autotuning_table_capacity = capacity;
+    }
+    entry = autotuning_table + autotuning_table_size++;
+    entry->x_length = xLength;
+    entry->h_length = hLength;
+  }
+  entry->algorithm = algorithm;
+}
+
+static double monotonic_time(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* The time spent on measuring a single algorithm, in seconds */
+#define AUTOTUNING_BUDGET 0.002
+#define AUTOTUNING_MAX_RUNS 100
+
+/// @brief Returns the best time of several convolve() calls.
+static double autotuning_measure(ConvolutionAlgorithm algorithm,
+                                 const float *x, size_t xLength,
+                                 const float *h, size_t hLength,
+                                 float *result) {
+  ConvolutionHandle handle = convolve_initialize_algorithm(
+      xLength, hLength, algorithm);
+  // The first call warms up the caches and the plans
+  convolve(handle, x, h, result);
+  double best = -1;
+  double total = 0;
+  for (int i = 0; i < AUTOTUNING_MAX_RUNS &&
+       (i < 3 || total < AUTOTUNING_BUDGET); i++) {
+    double start = monotonic_time();
+    convolve(handle, x, h, result);
+    double time = monotonic_time() - start;
+    total += time;
+    if (best < 0 || time < best) {
+      best = time;
+    }
+  }
+  convolve_finalize(handle);
+  return best;
+}
+
+static ConvolutionAlgorithm autotuning_benchmark(size_t xLength,
+                                                 size_t hLength) {
+  float *x = mallocf(xLength);
+  float *h = mallocf(hLength);
+  float *result = mallocf(xLength + hLength - 1);
+  assert(x && h && result);
+  for (size_t i = 0; i < xLength; i++) {
+    x[i] = (float)((i * 7919) % 2003) / 1001.f - 1.f;
+  }
+  for (size_t i = 0; i < hLength; i++) {
+    h[i] = (float)((i * 104729) % 1009) / 504.f - 1.f;
+  }
+  ConvolutionAlgorithm best = kConvolutionAlgorithmBruteForce;
+  double bestTime = autotuning_measure(best, x, xLength, h, hLength, result);
+  double time = autotuning_measure(kConvolutionAlgorithmFFT,
+                                   x, xLength, h, hLength, result);
+  if (time < bestTime) {
+    best = kConvolutionAlgorithmFFT;
+    bestTime = time;
+  }
+  // See the precondition of convolve_overlap_save_initialize()
+  if (hLength < xLength / 2) {
+    time = autotuning_measure(kConvolutionAlgorithmOverlapSave,
+                              x, xLength, h, hLength, result);
+    if (time < bestTime) {
+      best = kConvolutionAlgorithmOverlapSave;
+      bestTime = time;
+    }
+  }
+  time = autotuning_measure(kConvolutionAlgorithmPartitioned,
+                            x, xLength, h, hLength, result);
+  if (time < bestTime) {
+    best = kConvolutionAlgorithmPartitioned;
+  }
+  free_aligned(x);
+  free_aligned(h);
+  free_aligned(result);
+  return best;
+}
+
+void convolve_set_autotuning(int enabled) {
+  autotuning_enabled = enabled;
+}
+
+int convolve_autotuning(void) {
+  return autotuning_enabled;
+}
+
+static ConvolutionAlgorithm convolve_choose_algorithm(size_t xLength,
+                                                      size_t hLength) {
+  if (!autotuning_enabled) {
+    return convolve_heuristic_algorithm(xLength, hLength);
+  }
+  pthread_mutex_lock(&autotuning_lock);
+  AutotuningEntry *entry = autotuning_find(xLength, hLength);
+  ConvolutionAlgorithm algorithm;
+  if (entry != NULL) {
+    algorithm = entry->algorithm;
   } else {
-    if (xLength > 350) {
-      handle.algorithm = kConvolutionAlgorithmFFT;
-      handle.handle.fft = convolve_fft_initialize(xLength, hLength);
-    } else {
-      handle.algorithm = kConvolutionAlgorithmBruteForce;
+    algorithm = autotuning_benchmark(xLength, hLength);
+    autotuning_insert(xLength, hLength, algorithm);
+  }
+  pthread_mutex_unlock(&autotuning_lock);
+  return algorithm;
+}
+
+ConvolutionAlgorithm convolve_select_algorithm(size_t xLength,
+                                               size_t hLength) {
+  assert(xLength > 0);
+  assert(hLength > 0);
+  if (__builtin_expect(!(profile_active & PROFILE_TRACE), 1)) {
+    return convolve_choose_algorithm(xLength, hLength);
+  }
+  ProfileSample sample;
+  profile_begin(&sample);
+  SimdTraceEvent event;
+  event.entry = kSimdTraceSelectAlgorithm;
+  event.algorithm = convolve_choose_algorithm(xLength, hLength);
+  event.x_length = xLength;
+  event.h_length = hLength;
+  event.fft_length = 0;
+  event.nanoseconds = profile_elapsed(&sample);
+  profile_trace(&event);
+  return event.algorithm;
+}
+
+void convolve_autotuning_clear(void) {
+  pthread_mutex_lock(&autotuning_lock);
+  free(autotuning_table);
+  autotuning_table = NULL;
+  autotuning_table_size = 0;
+  autotuning_table_capacity = 0;
+  pthread_mutex_unlock(&autotuning_lock);
+}
+
+int convolve_autotuning_save(const char *path) {
+  assert(path != NULL);
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    return -1;
+  }
+  pthread_mutex_lock(&autotuning_lock);
+  int ok = fprintf(file, "%s\n", CONVOLUTION_AUTOTUNING_HEADER) > 0;
+  for (size_t i = 0; ok && i < autotuning_table_size; i++) {
+    ok = fprintf(file, "%zu %zu %s\n", autotuning_table[i].x_length,
+                 autotuning_table[i].h_length,
+                 algorithm_names[autotuning_table[i].algorithm]) > 0;
+  }
+  pthread_mutex_unlock(&autotuning_lock);
+  if (fclose(file) != 0) {
+    ok = 0;
+  }
+  return ok? 0 : -1;
+}
+
+int convolve_autotuning_load(const char *path) {
+  assert(path != NULL);
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    return -1;
+  }
+  char line[256];
+  if (fgets(line, sizeof(line), file) == NULL ||
+      strncmp(line, CONVOLUTION_AUTOTUNING_HEADER,
+              strlen(CONVOLUTION_AUTOTUNING_HEADER)) != 0) {
+    fclose(file);
+    return -1;
+  }
+  int count = 0;
+  pthread_mutex_lock(&autotuning_lock);
+  while (fgets(line, sizeof(line), file) != NULL) {
+    size_t xLength, hLength;
+    char name[32];
+    if (sscanf(line, "%zu %zu %31s", &xLength, &hLength, name) != 3 ||
+        xLength == 0 || hLength == 0) {
+      continue;
+    }
+    for (int i = 0; i < (int)(sizeof(algorithm_names) /
+                              sizeof(algorithm_names[0])); i++) {
+      if (!strcmp(name, algorithm_names[i])) {
+        ConvolutionAlgorithm algorithm = (ConvolutionAlgorithm)i;
+        if (algorithm == kConvolutionAlgorithmOverlapSave &&
+            !(hLength < xLength / 2)) {
+          break;
+        }
+        autotuning_insert(xLength, hLength, algorithm);
+        count++;
+        break;
+      }
     }
   }
-#endif
-  return handle;
+  pthread_mutex_unlock(&autotuning_lock);
+  fclose(file);
+  return count;
+}
+
+ConvolutionHandle convolve_initialize(size_t xLength, size_t hLength) {
+  return convolve_initialize_algorithm(
+      xLength, hLength, convolve_select_algorithm(xLength, hLength));
 }
 
 void convolve_finalize(ConvolutionHandle handle) {
+  free_aligned(handle.kernel);
   switch (handle.algorithm) {
     case kConvolutionAlgorithmFFT:
       convolve_fft_finalize(handle.handle.fft);
@@ -373,14 +1183,75 @@ void convolve_finalize(ConvolutionHandle handle) {
     case kConvolutionAlgorithmOverlapSave:
       convolve_overlap_save_finalize(handle.handle.os);
       break;
+    case kConvolutionAlgorithmPartitioned:
+      convolve_partitioned_finalize(handle.handle.partitioned);
+      break;
     case kConvolutionAlgorithmBruteForce:
       break;
   }
 }
 
-void convolve(ConvolutionHandle handle,
-              const float *__restrict x, const float *__restrict h,
-              float *__restrict result) {
+/// @brief Estimates the floating point operations of the real FFT of the
+/// specified length as 2.5 N log2(N).
+static uint64_t convolve_fft_flops(uint64_t length) {
+  int log = 0;
+  while ((1ull << (log + 1)) <= length) {
+    log++;
+  }
+  return 5 * length * log / 2;
+}
+
+/// @brief Estimates the floating point operations of convolve(): the
+/// transforms and the complex multiplications (3 flops per float) or the
+/// multiply-accumulates (4 flops per float) of the spectra.
+static uint64_t convolve_flops(ConvolutionHandle handle) {
+  uint64_t x = handle.x_length, h = handle.h_length;
+  switch (handle.algorithm) {
+    case kConvolutionAlgorithmFFT: {
+      uint64_t M = *handle.handle.fft.M;
+      return 3 * convolve_fft_flops(M) + 3 * (M + 2);
+    }
+    case kConvolutionAlgorithmOverlapSave: {
+      uint64_t L = *handle.handle.os.L;
+      uint64_t step = L - h + 1;
+      uint64_t blocks = (x + h - 1 + step - 1) / step;
+      return convolve_fft_flops(L) +
+          blocks * (2 * convolve_fft_flops(L) + 3 * (L + 2) + step);
+    }
+    case kConvolutionAlgorithmPartitioned: {
+      const struct ConvolutionPartitionedHandle *p =
+          &handle.handle.partitioned;
+      uint64_t N = *p->N, B = p->block_length;
+      uint64_t blocks = (x + h - 1 + B - 1) / B;
+      return p->partitions * convolve_fft_flops(N) +
+          blocks * (2 * convolve_fft_flops(N) + 4 * p->partitions * (N + 2));
+    }
+    case kConvolutionAlgorithmBruteForce:
+      break;
+  }
+  return 2 * x * h;
+}
+
+/// @brief Returns nonzero if the handle was created by
+/// cross_correlate_initialize_algorithm().
+static int convolve_reverse(ConvolutionHandle handle) {
+  switch (handle.algorithm) {
+    case kConvolutionAlgorithmFFT:
+      return handle.handle.fft.reverse;
+    case kConvolutionAlgorithmOverlapSave:
+      return handle.handle.os.reverse;
+    case kConvolutionAlgorithmPartitioned:
+      return handle.handle.partitioned.reverse;
+    case kConvolutionAlgorithmBruteForce:
+      break;
+  }
+  return 0;
+}
+
+static void convolve_dispatch(ConvolutionHandle handle,
+                              const float *__restrict x,
+                              const float *__restrict h,
+                              float *__restrict result) {
   switch (handle.algorithm) {
     case kConvolutionAlgorithmFFT:
       convolve_fft(handle.handle.fft, x, h, result);
@@ -388,10 +1259,201 @@ void convolve(ConvolutionHandle handle,
     case kConvolutionAlgorithmOverlapSave:
       convolve_overlap_save(handle.handle.os, x, h, result);
       break;
+    case kConvolutionAlgorithmPartitioned:
+      convolve_partitioned_transform_kernel(handle.handle.partitioned, h);
+      convolve_partitioned_signal(handle.handle.partitioned, x,
+                                  handle.x_length, result);
+      break;
     case kConvolutionAlgorithmBruteForce:
       convolve_simd(1, x, handle.x_length, h, handle.h_length, result);
       break;
   }
 }
 
-#endif  // #ifndef NO_FFTF
+void convolve(ConvolutionHandle handle,
+              const float *__restrict x, const float *__restrict h,
+              float *__restrict result) {
+  if (__builtin_expect(!profile_active, 1)) {
+    convolve_dispatch(handle, x, h, result);
+    return;
+  }
+  ProfileSample sample;
+  profile_begin(&sample);
+  convolve_dispatch(handle, x, h, result);
+  uint64_t elapsed = profile_end(
+      &sample, kSimdProfileConvolve, convolve_flops(handle),
+      (2ull * (handle.x_length + handle.h_length) - 1) * sizeof(float));
+  profile_trace_convolution(
+      &handle, convolve_reverse(handle)? kSimdTraceCrossCorrelate
+                                       : kSimdTraceConvolve, elapsed);
+}
+
+ConvolutionHandle convolve_initialize_with_kernel(
+    size_t xLength, const float *h, size_t hLength) {
+  return convolve_initialize_algorithm_with_kernel(
+      xLength, h, hLength, convolve_select_algorithm(xLength, hLength));
+}
+
+ConvolutionHandle convolve_initialize_algorithm_with_kernel(
+    size_t xLength, const float *h, size_t hLength,
+    ConvolutionAlgorithm algorithm) {
+  assert(h != NULL);
+  ConvolutionHandle handle = convolve_initialize_algorithm(
+      xLength, hLength, algorithm);
+  switch (handle.algorithm) {
+    case kConvolutionAlgorithmFFT:
+      // The forward plan must transform X only
+      convolve_fft_finalize(handle.handle.fft);
+      handle.handle.fft = convolve_fft_initialize_with_kernel(
+          xLength, h, hLength);
+      break;
+    case kConvolutionAlgorithmOverlapSave:
+      convolve_overlap_save_transform_kernel(handle.handle.os, h);
+      break;
+    case kConvolutionAlgorithmPartitioned:
+      convolve_partitioned_transform_kernel(handle.handle.partitioned, h);
+      break;
+    case kConvolutionAlgorithmBruteForce:
+      handle.kernel = mallocf(hLength);
+      assert(handle.kernel);
+      memcpy(handle.kernel, h, hLength * sizeof(h[0]));
+      break;
+  }
+  return handle;
+}
+
+static void convolve_with_kernel_dispatch(ConvolutionHandle handle,
+                                          const float *__restrict x,
+                                          float *__restrict result) {
+  switch (handle.algorithm) {
+    case kConvolutionAlgorithmFFT:
+      convolve_fft_with_kernel(handle.handle.fft, x, result);
+      break;
+    case kConvolutionAlgorithmOverlapSave:
+      convolve_overlap_save_blocks(handle.handle.os, x, result);
+      break;
+    case kConvolutionAlgorithmPartitioned:
+      convolve_partitioned_signal(handle.handle.partitioned, x,
+                                  handle.x_length, result);
+      break;
+    case kConvolutionAlgorithmBruteForce:
+      convolve_simd(1, x, handle.x_length, handle.kernel, handle.h_length,
+                    result);
+      break;
+  }
+}
+
+void convolve_with_kernel(ConvolutionHandle handle,
+                          const float *__restrict x,
+                          float *__restrict result) {
+  assert(x != NULL);
+  assert(result != NULL);
+  if (__builtin_expect(!(profile_active & PROFILE_TRACE), 1)) {
+    convolve_with_kernel_dispatch(handle, x, result);
+    return;
+  }
+  ProfileSample sample;
+  profile_begin(&sample);
+  convolve_with_kernel_dispatch(handle, x, result);
+  profile_trace_convolution(&handle, kSimdTraceConvolveWithKernel,
+                            profile_elapsed(&sample));
+}
+
+/// @brief Takes X and the plans of the FFT method from the cache,
+/// the spectrum of the filter is shared.
+static ConvolutionFFTHandle convolve_fft_clone(ConvolutionFFTHandle shared) {
+  ConvolutionFFTHandle handle = shared;
+  handle.workspace = malloc_aligned(2 * sizeof(float *));
+  assert(handle.workspace);
+  handle.inputs = handle.workspace;
+  handle.inputs[1] = shared.inputs[1];
+  convolve_fft_acquire_plans(&handle, *shared.M);
+  return handle;
+}
+
+/// @brief Takes the buffer and the plans of the overlap-save method from
+/// the cache, the spectrum of the filter is shared.
+static ConvolutionOverlapSaveHandle convolve_overlap_save_clone(
+    ConvolutionOverlapSaveHandle shared) {
+  ConvolutionOverlapSaveHandle handle = shared;
+  handle.workspace = NULL;
+  convolve_overlap_save_acquire_plans(&handle, *shared.L);
+  return handle;
+}
+
+ConvolutionScratch convolve_scratch_initialize(ConvolutionHandle handle) {
+  ConvolutionScratch scratch;
+  scratch.algorithm = handle.algorithm;
+  switch (handle.algorithm) {
+    case kConvolutionAlgorithmFFT:
+      scratch.handle.fft = convolve_fft_clone(handle.handle.fft);
+      break;
+    case kConvolutionAlgorithmOverlapSave:
+      scratch.handle.os = convolve_overlap_save_clone(handle.handle.os);
+      break;
+    case kConvolutionAlgorithmPartitioned:
+      scratch.handle.partitioned = convolve_partitioned_create(
+          handle.h_length, handle.handle.partitioned.block_length,
+          handle.handle.partitioned.H);
+      break;
+    case kConvolutionAlgorithmBruteForce:
+      break;
+  }
+  return scratch;
+}
+
+void convolve_scratch_finalize(ConvolutionScratch scratch) {
+  switch (scratch.algorithm) {
+    case kConvolutionAlgorithmFFT:
+      convolve_fft_finalize(scratch.handle.fft);
+      break;
+    case kConvolutionAlgorithmOverlapSave:
+      convolve_overlap_save_finalize(scratch.handle.os);
+      break;
+    case kConvolutionAlgorithmPartitioned:
+      convolve_partitioned_destroy_state(scratch.handle.partitioned);
+      break;
+    case kConvolutionAlgorithmBruteForce:
+      break;
+  }
+}
+
+static void convolve_with_kernel_scratch_dispatch(
+    ConvolutionHandle handle, ConvolutionScratch scratch,
+    const float *__restrict x, float *__restrict result) {
+  // handle is only read, all the writes go to scratch
+  switch (handle.algorithm) {
+    case kConvolutionAlgorithmFFT:
+      convolve_fft_with_kernel(scratch.handle.fft, x, result);
+      break;
+    case kConvolutionAlgorithmOverlapSave:
+      convolve_overlap_save_blocks(scratch.handle.os, x, result);
+      break;
+    case kConvolutionAlgorithmPartitioned:
+      convolve_partitioned_signal(scratch.handle.partitioned, x,
+                                  handle.x_length, result);
+      break;
+    case kConvolutionAlgorithmBruteForce:
+      convolve_simd(1, x, handle.x_length, handle.kernel, handle.h_length,
+                    result);
+      break;
+  }
+}
+
+void convolve_with_kernel_scratch(ConvolutionHandle handle,
+                                  ConvolutionScratch scratch,
+                                  const float *__restrict x,
+                                  float *__restrict result) {
+  assert(x != NULL);
+  assert(result != NULL);
+  assert(scratch.algorithm == handle.algorithm);
+  if (__builtin_expect(!(profile_active & PROFILE_TRACE), 1)) {
+    convolve_with_kernel_scratch_dispatch(handle, scratch, x, result);
+    return;
+  }
+  ProfileSample sample;
+  profile_begin(&sample);
+  convolve_with_kernel_scratch_dispatch(handle, scratch, x, result);
+  profile_trace_convolution(&handle, kSimdTraceConvolveWithKernel,
+                            profile_elapsed(&sample));
+}
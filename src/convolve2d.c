@@ -0,0 +1,275 @@
+/*! @file convolve2d.c
+ *  @brief 2D convolution and cross-correlation of images.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#define LIBSIMD_IMPLEMENTATION
+#include "inc/simd/convolve2d.h"
+#include <assert.h>
+#include <string.h>
+#include "inc/simd/convolve.h"
+#include "inc/simd/correlate.h"
+#include "inc/simd/memory.h"
+
+/// @brief Returns the width of the full 2D convolution, every flattened
+/// row is padded to it.
+static size_t convolve2D_width(size_t xWidth, size_t hWidth) {
+  return xWidth + hWidth - 1;
+}
+
+/// @brief Returns the length of the flattened image.
+static size_t convolve2D_flat_x_length(size_t xWidth, size_t xHeight,
+                                       size_t hWidth) {
+  return xHeight * convolve2D_width(xWidth, hWidth);
+}
+
+/// @brief Returns the length of the flattened kernel, the padding of its
+/// last row does not matter.
+static size_t convolve2D_flat_h_length(size_t xWidth, size_t hWidth,
+                                       size_t hHeight) {
+  return (hHeight - 1) * convolve2D_width(xWidth, hWidth) + hWidth;
+}
+
+ConvolutionAlgorithm convolve2D_select_algorithm(size_t xWidth,
+                                                 size_t xHeight,
+                                                 size_t hWidth,
+                                                 size_t hHeight) {
+  assert(xWidth > 0 && xHeight > 0);
+  assert(hWidth > 0 && hHeight > 0);
+  if (hWidth * hHeight <= CONVOLUTION_2D_DIRECT_THRESHOLD) {
+    return kConvolutionAlgorithmBruteForce;
+  }
+  // The brute force 1D convolution of the flattened images would multiply
+  // the padding, so it is replaced with the direct 2D one
+  return convolve_select_algorithm(
+      convolve2D_flat_x_length(xWidth, xHeight, hWidth),
+      convolve2D_flat_h_length(xWidth, hWidth, hHeight));
+}
+
+Convolution2DHandle convolve2D_initialize_algorithm(
+    size_t xWidth, size_t xHeight, size_t hWidth, size_t hHeight,
+    ConvolutionAlgorithm algorithm) {
+  assert(xWidth > 0 && xHeight > 0);
+  assert(hWidth > 0 && hHeight > 0);
+  Convolution2DHandle handle;
+  handle.algorithm = algorithm;
+  handle.x_width = xWidth;
+  handle.x_height = xHeight;
+  handle.h_width = hWidth;
+  handle.h_height = hHeight;
+  handle.reverse = 0;
+  handle.kernel = NULL;
+  handle.x_flat = NULL;
+  handle.h_flat = NULL;
+  handle.result_flat = NULL;
+  handle.workspace = NULL;
+  if (algorithm == kConvolutionAlgorithmBruteForce) {
+    return handle;
+  }
+  size_t xLength = convolve2D_flat_x_length(xWidth, xHeight, hWidth);
+  size_t hLength = convolve2D_flat_h_length(xWidth, hWidth, hHeight);
+  handle.line = convolve_initialize_algorithm(xLength, hLength, algorithm);
+  handle.workspace = malloc_aligned_ex(
+      (2 * (xLength + hLength) - 1) * sizeof(float), kMemoryFlagHugePages);
+  assert(handle.workspace);
+  handle.x_flat = handle.workspace;
+  handle.h_flat = handle.x_flat + xLength;
+  handle.result_flat = handle.h_flat + hLength;
+  // Only the rows are copied in convolve2D(), the padding stays zero
+  memsetf(handle.x_flat, 0.f, xLength + hLength);
+  return handle;
+}
+
+Convolution2DHandle convolve2D_initialize(size_t xWidth, size_t xHeight,
+                                          size_t hWidth, size_t hHeight) {
+  return convolve2D_initialize_algorithm(
+      xWidth, xHeight, hWidth, hHeight,
+      convolve2D_select_algorithm(xWidth, xHeight, hWidth, hHeight));
+}
+
+void convolve2D(Convolution2DHandle handle,
+                const float *__restrict x, size_t xStride,
+                const float *__restrict h,
+                float *__restrict result, size_t resultStride) {
+  assert(x != NULL);
+  assert(h != NULL);
+  assert(result != NULL);
+  size_t width = convolve2D_width(handle.x_width, handle.h_width);
+  assert(xStride >= handle.x_width);
+  assert(resultStride >= width);
+  if (handle.reverse) {
+    rmemcpyf(handle.kernel, h, handle.h_width * handle.h_height);
+    h = handle.kernel;
+  }
+  if (handle.algorithm == kConvolutionAlgorithmBruteForce) {
+    convolve2D_simd(1, x, xStride, handle.x_width, handle.x_height,
+                    h, handle.h_width, handle.h_height,
+                    result, resultStride);
+    return;
+  }
+  for (size_t r = 0; r < handle.x_height; r++) {
+    memcpy(handle.x_flat + r * width, x + r * xStride,
+           handle.x_width * sizeof(float));
+  }
+  for (size_t r = 0; r < handle.h_height; r++) {
+    memcpy(handle.h_flat + r * width, h + r * handle.h_width,
+           handle.h_width * sizeof(float));
+  }
+  convolve(handle.line, handle.x_flat, handle.h_flat, handle.result_flat);
+  for (size_t r = 0; r < handle.x_height + handle.h_height - 1; r++) {
+    memcpyf(result + r * resultStride, handle.result_flat + r * width,
+            width);
+  }
+}
+
+void convolve2D_finalize(Convolution2DHandle handle) {
+  if (handle.algorithm != kConvolutionAlgorithmBruteForce) {
+    convolve_finalize(handle.line);
+  }
+  free_aligned(handle.workspace);
+  free_aligned(handle.kernel);
+}
+
+/// @brief Prepares the separable convolution, the rows are convolved
+/// with the specified 1D handle.
+static Convolution2DSeparableHandle convolve2D_separable_create(
+    size_t xWidth, size_t xHeight, size_t hRowLength, size_t hColumnLength,
+    struct ConvolutionHandle rows, int reverse) {
+  Convolution2DSeparableHandle handle;
+  handle.x_width = xWidth;
+  handle.x_height = xHeight;
+  handle.h_row_length = hRowLength;
+  handle.h_column_length = hColumnLength;
+  handle.reverse = reverse;
+  handle.rows = rows;
+  handle.buffer = mallocf_ex(
+      xHeight * convolve2D_width(xWidth, hRowLength), kMemoryFlagHugePages);
+  assert(handle.buffer);
+  handle.column = NULL;
+  if (reverse) {
+    handle.column = mallocf(hColumnLength);
+    assert(handle.column);
+  }
+  return handle;
+}
+
+Convolution2DSeparableHandle convolve2D_separable_initialize(
+    size_t xWidth, size_t xHeight, size_t hRowLength, size_t hColumnLength) {
+  assert(xWidth > 0 && xHeight > 0);
+  assert(hRowLength > 0 && hColumnLength > 0);
+  return convolve2D_separable_create(
+      xWidth, xHeight, hRowLength, hColumnLength,
+      convolve_initialize(xWidth, hRowLength), 0);
+}
+
+void convolve2D_separable(Convolution2DSeparableHandle handle,
+                          const float *__restrict x, size_t xStride,
+                          const float *__restrict hRow,
+                          const float *__restrict hColumn,
+                          float *__restrict result, size_t resultStride) {
+  assert(x != NULL);
+  assert(hRow != NULL);
+  assert(hColumn != NULL);
+  assert(result != NULL);
+  assert(xStride >= handle.x_width);
+  size_t width = convolve2D_width(handle.x_width, handle.h_row_length);
+  for (size_t r = 0; r < handle.x_height; r++) {
+    if (handle.reverse) {
+      cross_correlate(handle.rows, x + r * xStride, hRow,
+                      handle.buffer + r * width);
+    } else {
+      convolve(handle.rows, x + r * xStride, hRow,
+               handle.buffer + r * width);
+    }
+  }
+  if (handle.reverse) {
+    rmemcpyf(handle.column, hColumn, handle.h_column_length);
+    hColumn = handle.column;
+  }
+  // The columns are convolved with the kernel of width 1
+  convolve2D_simd(1, handle.buffer, width, width, handle.x_height,
+                  hColumn, 1, handle.h_column_length, result, resultStride);
+}
+
+void convolve2D_separable_finalize(Convolution2DSeparableHandle handle) {
+  convolve_finalize(handle.rows);
+  free_aligned(handle.buffer);
+  free_aligned(handle.column);
+}
+
+Convolution2DHandle cross_correlate2D_initialize(size_t xWidth,
+                                                 size_t xHeight,
+                                                 size_t hWidth,
+                                                 size_t hHeight) {
+  Convolution2DHandle handle = convolve2D_initialize(
+      xWidth, xHeight, hWidth, hHeight);
+  // Cross-correlation is the convolution with the kernel reversed along
+  // both axes, which is the reversed flat array
+  handle.reverse = 1;
+  handle.kernel = mallocf(hWidth * hHeight);
+  assert(handle.kernel);
+  return handle;
+}
+
+void cross_correlate2D(Convolution2DHandle handle,
+                       const float *__restrict x, size_t xStride,
+                       const float *__restrict h,
+                       float *__restrict result, size_t resultStride) {
+  assert(handle.reverse);
+  convolve2D(handle, x, xStride, h, result, resultStride);
+}
+
+void cross_correlate2D_finalize(Convolution2DHandle handle) {
+  convolve2D_finalize(handle);
+}
+
+Convolution2DSeparableHandle cross_correlate2D_separable_initialize(
+    size_t xWidth, size_t xHeight, size_t hRowLength, size_t hColumnLength) {
+  assert(xWidth > 0 && xHeight > 0);
+  assert(hRowLength > 0 && hColumnLength > 0);
+  return convolve2D_separable_create(
+      xWidth, xHeight, hRowLength, hColumnLength,
+      cross_correlate_initialize(xWidth, hRowLength), 1);
+}
+
+void cross_correlate2D_separable(Convolution2DSeparableHandle handle,
+                                 const float *__restrict x, size_t xStride,
+                                 const float *__restrict hRow,
+                                 const float *__restrict hColumn,
+                                 float *__restrict result,
+                                 size_t resultStride) {
+  assert(handle.reverse);
+  convolve2D_separable(handle, x, xStride, hRow, hColumn, result,
+                       resultStride);
+}
+
+void cross_correlate2D_separable_finalize(
+    Convolution2DSeparableHandle handle) {
+  convolve2D_separable_finalize(handle);
+}
@@ -0,0 +1,487 @@
+/*! @file convolve_simd.c
+ *  @brief Brute force linear convolution, built per instruction set.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#define LIBSIMD_IMPLEMENTATION
+#include "src/dispatch.h"
+#define convolve_simd KERNEL(convolve_simd)
+#define convolve_simd_double KERNEL(convolve_simd_double)
+#define convolve2D_simd KERNEL(convolve2D_simd)
+#include "inc/simd/convolve.h"
+#include "inc/simd/convolve2d.h"
+#include <assert.h>
+#include <simd/instruction_set.h>
+#include "src/convolve_simd.h"
+#include "src/dot_product.h"
+#if defined(__AVX__) || defined(__ARM_NEON__)
+
+/* The register blocked kernel keeps CONVOLVE_NV vectors of consecutive
+ * outputs in registers and updates all of them with each broadcast h[m],
+ * so there is no horizontal reduction per output. h is walked with hStep,
+ * which is -1 for the reversed h of the cross-correlation. */
+#if defined(__AVX512F__)
+
+#define CONVOLVE_NV 2
+#define CONVOLVE_VL 16
+typedef __m512 convolve_vec;
+#define convolve_loadu(ptr) _mm512_loadu_ps(ptr)
+#define convolve_storeu(ptr, vec) _mm512_storeu_ps(ptr, vec)
+#define convolve_set1(ptr) _mm512_set1_ps(*(ptr))
+#define convolve_zero() _mm512_setzero_ps()
+#define convolve_madd(a, b, c) _mm512_fmadd_ps(a, b, c)
+
+#elif defined(__AVX__)
+
+#ifdef SIMD_AVX_EMULATION
+/* Every emulated register is a pair of SSE ones, only 16 are available */
+#define CONVOLVE_NV 2
+#else
+#define CONVOLVE_NV 4
+#endif
+#define CONVOLVE_VL 8
+typedef __m256 convolve_vec;
+#define convolve_loadu(ptr) _mm256_loadu_ps(ptr)
+#define convolve_storeu(ptr, vec) _mm256_storeu_ps(ptr, vec)
+#define convolve_set1(ptr) _mm256_broadcast_ss(ptr)
+#define convolve_zero() _mm256_setzero_ps()
+#define convolve_madd(a, b, c) madd256(a, b, c)
+
+#else  // __ARM_NEON__
+
+#ifdef __aarch64__
+/* 32 quad registers hold 8 accumulators together with their x vectors */
+#define CONVOLVE_NV 8
+#else
+#define CONVOLVE_NV 4
+#endif
+#define CONVOLVE_VL 4
+typedef float32x4_t convolve_vec;
+#define convolve_loadu(ptr) vld1q_f32(ptr)
+#define convolve_storeu(ptr, vec) vst1q_f32(ptr, vec)
+#define convolve_set1(ptr) vld1q_dup_f32(ptr)
+#define convolve_zero() vdupq_n_f32(0.f)
+#define convolve_madd(a, b, c) madd128(a, b, c)
+
+#endif
+
+#define CONVOLVE_BLOCK (CONVOLVE_NV * CONVOLVE_VL)
+
+#if CONVOLVE_NV == 2
+#define CONVOLVE_VECTORS(X) X(0) X(1)
+#elif CONVOLVE_NV == 4
+#define CONVOLVE_VECTORS(X) X(0) X(1) X(2) X(3)
+#else
+#define CONVOLVE_VECTORS(X) X(0) X(1) X(2) X(3) X(4) X(5) X(6) X(7)
+#endif
+
+#define CONVOLVE_DECLARE(i) convolve_vec accum##i = convolve_zero();
+#define CONVOLVE_UPDATE(i) accum##i = convolve_madd( \
+    hvec, convolve_loadu(x - m + i * CONVOLVE_VL), accum##i);
+#define CONVOLVE_STORE(i) \
+    convolve_storeu(result + i * CONVOLVE_VL, accum##i);
+
+/// @brief Calculates CONVOLVE_BLOCK consecutive outputs
+/// result[i] = sum(h[m * hStep] * x[i - m]), m = 0..hLength-1.
+/// @details x[-hLength + 1] ... x[CONVOLVE_BLOCK - 1] must be readable.
+static void convolve_block(const float *__restrict x,
+                           const float *__restrict h, int hStep, int hLength,
+                           float *__restrict result) {
+  CONVOLVE_VECTORS(CONVOLVE_DECLARE)
+  for (int m = 0; m < hLength; m++) {
+    convolve_vec hvec = convolve_set1(h + m * hStep);
+    CONVOLVE_VECTORS(CONVOLVE_UPDATE)
+  }
+  CONVOLVE_VECTORS(CONVOLVE_STORE)
+}
+
+/// @brief The same as convolve_block() for CONVOLVE_VL outputs.
+static void convolve_vector(const float *__restrict x,
+                            const float *__restrict h, int hStep,
+                            int hLength, float *__restrict result) {
+  CONVOLVE_DECLARE(0)
+  for (int m = 0; m < hLength; m++) {
+    convolve_vec hvec = convolve_set1(h + m * hStep);
+    CONVOLVE_UPDATE(0)
+  }
+  CONVOLVE_STORE(0)
+}
+
+#endif  // defined(__AVX__) || defined(__ARM_NEON__)
+
+/// @brief Calculates the outputs begin..end-1 one by one.
+static void convolve_outputs(int simd,
+                             const float *__restrict x, int xLength,
+                             const float *__restrict h, int hLength,
+                             int begin, int end, float *__restrict result) {
+  for (int n = begin; n < end; n++) {
+    float sum = 0.f;
+    int beg = n < xLength? 0 : n - xLength + 1;
+    int last = n + 1;
+    if (last > hLength) {
+      last = hLength;
+    }
+    if (simd) {
+#ifdef __AVX__
+      sum = dot_product_reversed256(h + beg, x + n - beg, last - beg);
+    } else {
+#elif defined(__ARM_NEON__)
+      int simdEnd = beg + ((last - beg) & ~3);
+      float32x4_t accum = vdupq_n_f32(0.f);
+      for (int m = beg; m < simdEnd; m += 4) {
+        float32x4_t xvec = vld1q_f32(x + n - m - 3);
+        float32x4_t hvec = vld1q_f32(h + m);
+        xvec = vrev64q_f32(xvec);
+        xvec = vcombine_f32(vget_high_f32(xvec), vget_low_f32(xvec));
+        accum = madd128(xvec, hvec, accum);
+      }
+      sum = hsum128(accum);
+      for (int m = simdEnd; m < last; m++) {
+        sum += h[m] * x[n - m];
+      }
+    } else {
+#else
+    } {
+#endif
+      for (int m = beg; m < last; m++) {
+        sum += h[m] * x[n - m];
+      }
+    }
+    result[n] = sum;
+  }
+}
+
+/// @brief The same as convolve_outputs() with the reversed h, that is,
+/// result[n] = sum(h[j] * x[n - hLength + 1 + j]).
+static void convolve_reversed_outputs(int simd,
+                                      const float *__restrict x, int xLength,
+                                      const float *__restrict h, int hLength,
+                                      int begin, int end,
+                                      float *__restrict result) {
+  for (int n = begin; n < end; n++) {
+    // x[i] meets h[i + shift]
+    int shift = hLength - 1 - n;
+    int beg = shift < 0? -shift : 0;
+    int last = hLength - shift;
+    if (last > xLength) {
+      last = xLength;
+    }
+    float sum = 0.f;
+    if (simd) {
+#ifdef __AVX__
+      sum = dot_product256(x + beg, h + shift + beg, last - beg);
+    } else {
+#elif defined(__ARM_NEON__)
+      int simdEnd = beg + ((last - beg) & ~3);
+      float32x4_t accum = vdupq_n_f32(0.f);
+      for (int m = beg; m < simdEnd; m += 4) {
+        float32x4_t xvec = vld1q_f32(x + m);
+        float32x4_t hvec = vld1q_f32(h + shift + m);
+        accum = madd128(xvec, hvec, accum);
+      }
+      sum = hsum128(accum);
+      for (int m = simdEnd; m < last; m++) {
+        sum += x[m] * h[shift + m];
+      }
+    } else {
+#else
+    } {
+#endif
+      for (int m = beg; m < last; m++) {
+        sum += x[m] * h[shift + m];
+      }
+    }
+    result[n] = sum;
+  }
+}
+
+/// @brief Calculates the convolution of x with h or with the reversed h.
+static void convolve_blocked(int simd, int reversed,
+                             const float *__restrict x, size_t xLength,
+                             const float *__restrict h, size_t hLength,
+                             float *__restrict result) {
+  assert(x);
+  assert(h);
+  assert(result);
+  assert(xLength > 0);
+  assert(hLength > 0);
+  // Only the outputs blockBeg..blockEnd-1 overlap the whole h
+  int blockBeg = hLength - 1, blockEnd = blockBeg;
+#if defined(__AVX__) || defined(__ARM_NEON__)
+  if (simd) {
+    const float *hFirst = reversed? h + hLength - 1 : h;
+    int hStep = reversed? -1 : 1;
+    for (; blockEnd + CONVOLVE_BLOCK <= (int)xLength;
+         blockEnd += CONVOLVE_BLOCK) {
+      convolve_block(x + blockEnd, hFirst, hStep, hLength,
+                     result + blockEnd);
+    }
+    for (; blockEnd + CONVOLVE_VL <= (int)xLength; blockEnd += CONVOLVE_VL) {
+      convolve_vector(x + blockEnd, hFirst, hStep, hLength,
+                      result + blockEnd);
+    }
+  }
+#endif
+  if (reversed) {
+    convolve_reversed_outputs(simd, x, xLength, h, hLength, 0, blockBeg,
+                              result);
+    convolve_reversed_outputs(simd, x, xLength, h, hLength, blockEnd,
+                              xLength + hLength - 1, result);
+  } else {
+    convolve_outputs(simd, x, xLength, h, hLength, 0, blockBeg, result);
+    convolve_outputs(simd, x, xLength, h, hLength, blockEnd,
+                     xLength + hLength - 1, result);
+  }
+}
+
+void convolve_simd(int simd,
+                   const float *__restrict x, size_t xLength,
+                   const float *__restrict h, size_t hLength,
+                   float *__restrict result) {
+  convolve_blocked(simd, 0, x, xLength, h, hLength, result);
+}
+
+void convolve_reversed_simd(int simd,
+                            const float *__restrict x, size_t xLength,
+                            const float *__restrict h, size_t hLength,
+                            float *__restrict result) {
+  convolve_blocked(simd, 1, x, xLength, h, hLength, result);
+}
+
+#if defined(__AVX__) || defined(__ARM_NEON__)
+
+#define CONVOLVE2D_UPDATE(i) accum##i = convolve_madd( \
+    hvec, convolve_loadu(row - m + i * CONVOLVE_VL), accum##i);
+
+/// @brief Calculates CONVOLVE_BLOCK consecutive outputs of one row
+/// result[c] = sum(h[i][m] * x[-i][c - m]), i = 0..rows-1,
+/// m = 0..hWidth-1.
+/// @details x points at the row of the first kernel row, the others are
+/// above it.
+static void convolve2D_block(const float *__restrict x, size_t xStride,
+                             const float *__restrict h, int hWidth,
+                             int rows, float *__restrict result) {
+  CONVOLVE_VECTORS(CONVOLVE_DECLARE)
+  for (int i = 0; i < rows; i++) {
+    const float *row = x - i * xStride;
+    const float *hrow = h + i * hWidth;
+    for (int m = 0; m < hWidth; m++) {
+      convolve_vec hvec = convolve_set1(hrow + m);
+      CONVOLVE_VECTORS(CONVOLVE2D_UPDATE)
+    }
+  }
+  CONVOLVE_VECTORS(CONVOLVE_STORE)
+}
+
+/// @brief The same as convolve2D_block() for CONVOLVE_VL outputs.
+static void convolve2D_vector(const float *__restrict x, size_t xStride,
+                              const float *__restrict h, int hWidth,
+                              int rows, float *__restrict result) {
+  CONVOLVE_DECLARE(0)
+  for (int i = 0; i < rows; i++) {
+    const float *row = x - i * xStride;
+    const float *hrow = h + i * hWidth;
+    for (int m = 0; m < hWidth; m++) {
+      convolve_vec hvec = convolve_set1(hrow + m);
+      CONVOLVE2D_UPDATE(0)
+    }
+  }
+  CONVOLVE_STORE(0)
+}
+
+#endif  // defined(__AVX__) || defined(__ARM_NEON__)
+
+/// @brief Calculates the outputs begin..end-1 of one row one by one,
+/// see convolve2D_block().
+static void convolve2D_outputs(const float *__restrict x, size_t xStride,
+                               int xWidth, const float *__restrict h,
+                               int hWidth, int rows, int begin, int end,
+                               float *__restrict result) {
+  for (int c = begin; c < end; c++) {
+    int beg = c < xWidth? 0 : c - xWidth + 1;
+    int last = c + 1 < hWidth? c + 1 : hWidth;
+    float sum = 0.f;
+    for (int i = 0; i < rows; i++) {
+      const float *row = x - i * xStride;
+      const float *hrow = h + i * hWidth;
+      for (int m = beg; m < last; m++) {
+        sum += hrow[m] * row[c - m];
+      }
+    }
+    result[c] = sum;
+  }
+}
+
+void convolve2D_simd(int simd, const float *__restrict x, size_t xStride,
+                     size_t xWidth, size_t xHeight,
+                     const float *__restrict h, size_t hWidth,
+                     size_t hHeight, float *__restrict result,
+                     size_t resultStride) {
+  assert(x);
+  assert(h);
+  assert(result);
+  assert(xWidth > 0 && xHeight > 0);
+  assert(hWidth > 0 && hHeight > 0);
+  assert(xStride >= xWidth);
+  assert(resultStride >= xWidth + hWidth - 1);
+  int width = xWidth + hWidth - 1, height = xHeight + hHeight - 1;
+  for (int r = 0; r < height; r++) {
+    // The kernel rows beg..last-1 overlap the image
+    int beg = r < (int)xHeight? 0 : r - (int)xHeight + 1;
+    int last = r + 1 < (int)hHeight? r + 1 : (int)hHeight;
+    const float *row = x + (r - beg) * xStride;
+    const float *hrow = h + beg * hWidth;
+    float *out = result + r * resultStride;
+    // Only the outputs blockBeg..blockEnd-1 overlap the whole kernel row
+    int blockBeg = hWidth - 1, blockEnd = blockBeg;
+#if defined(__AVX__) || defined(__ARM_NEON__)
+    if (simd) {
+      for (; blockEnd + CONVOLVE_BLOCK <= (int)xWidth;
+           blockEnd += CONVOLVE_BLOCK) {
+        convolve2D_block(row + blockEnd, xStride, hrow, hWidth, last - beg,
+                         out + blockEnd);
+      }
+      for (; blockEnd + CONVOLVE_VL <= (int)xWidth;
+           blockEnd += CONVOLVE_VL) {
+        convolve2D_vector(row + blockEnd, xStride, hrow, hWidth, last - beg,
+                          out + blockEnd);
+      }
+    }
+#endif
+    convolve2D_outputs(row, xStride, xWidth, hrow, hWidth, last - beg,
+                       0, blockBeg, out);
+    convolve2D_outputs(row, xStride, xWidth, hrow, hWidth, last - beg,
+                       blockEnd, width, out);
+  }
+}
+
+/* The double precision variant of the register blocked kernel. */
+#if defined(__AVX512F__)
+
+#define CONVOLVED_VL 8
+typedef __m512d convolved_vec;
+#define convolved_loadu(ptr) _mm512_loadu_pd(ptr)
+#define convolved_storeu(ptr, vec) _mm512_storeu_pd(ptr, vec)
+#define convolved_set1(ptr) _mm512_set1_pd(*(ptr))
+#define convolved_zero() _mm512_setzero_pd()
+#define convolved_madd(a, b, c) _mm512_fmadd_pd(a, b, c)
+
+#elif defined(__AVX__)
+
+#define CONVOLVED_VL 4
+typedef __m256d convolved_vec;
+#define convolved_loadu(ptr) _mm256_loadu_pd(ptr)
+#define convolved_storeu(ptr, vec) _mm256_storeu_pd(ptr, vec)
+#define convolved_set1(ptr) _mm256_set1_pd(*(ptr))
+#define convolved_zero() _mm256_setzero_pd()
+#define convolved_madd(a, b, c) madd256d(a, b, c)
+
+#elif defined(__aarch64__)
+
+#define CONVOLVED_VL 2
+typedef float64x2_t convolved_vec;
+#define convolved_loadu(ptr) vld1q_f64(ptr)
+#define convolved_storeu(ptr, vec) vst1q_f64(ptr, vec)
+#define convolved_set1(ptr) vld1q_dup_f64(ptr)
+#define convolved_zero() vdupq_n_f64(0)
+#define convolved_madd(a, b, c) vfmaq_f64(c, a, b)
+
+#endif
+
+#ifdef CONVOLVED_VL
+
+#if defined(__AVX512F__) || defined(SIMD_AVX_EMULATION)
+#define CONVOLVED_VECTORS(X) X(0) X(1)
+#define CONVOLVED_NV 2
+#elif defined(__aarch64__)
+#define CONVOLVED_VECTORS(X) X(0) X(1) X(2) X(3) X(4) X(5) X(6) X(7)
+#define CONVOLVED_NV 8
+#else
+#define CONVOLVED_VECTORS(X) X(0) X(1) X(2) X(3)
+#define CONVOLVED_NV 4
+#endif
+#define CONVOLVED_BLOCK (CONVOLVED_NV * CONVOLVED_VL)
+
+#define CONVOLVED_DECLARE(i) convolved_vec accum##i = convolved_zero();
+#define CONVOLVED_UPDATE(i) accum##i = convolved_madd( \
+    hvec, convolved_loadu(x - m + i * CONVOLVED_VL), accum##i);
+#define CONVOLVED_STORE(i) \
+    convolved_storeu(result + i * CONVOLVED_VL, accum##i);
+
+/// @brief The same as convolve_block() in double precision.
+static void convolve_block_double(const double *__restrict x,
+                                  const double *__restrict h, int hLength,
+                                  double *__restrict result) {
+  CONVOLVED_VECTORS(CONVOLVED_DECLARE)
+  for (int m = 0; m < hLength; m++) {
+    convolved_vec hvec = convolved_set1(h + m);
+    CONVOLVED_VECTORS(CONVOLVED_UPDATE)
+  }
+  CONVOLVED_VECTORS(CONVOLVED_STORE)
+}
+
+#endif  // CONVOLVED_VL
+
+void convolve_simd_double(int simd,
+                          const double *__restrict x, size_t xLength,
+                          const double *__restrict h, size_t hLength,
+                          double *__restrict result) {
+  assert(x);
+  assert(h);
+  assert(result);
+  assert(xLength > 0);
+  assert(hLength > 0);
+  int ixLength = (int)xLength, ihLength = (int)hLength;
+  int blockBeg = ihLength - 1, blockEnd = blockBeg;
+#ifdef CONVOLVED_VL
+  if (simd) {
+    for (; blockEnd + CONVOLVED_BLOCK <= ixLength;
+         blockEnd += CONVOLVED_BLOCK) {
+      convolve_block_double(x + blockEnd, h, ihLength, result + blockEnd);
+    }
+  }
+#else
+  (void)simd;
+#endif
+  // The outputs which overlap the ends of x one by one
+  for (int n = 0; n < ixLength + ihLength - 1; n++) {
+    if (n == blockBeg) {
+      n = blockEnd;
+      if (n >= ixLength + ihLength - 1) {
+        break;
+      }
+    }
+    double sum = 0;
+    int beg = n < ixLength? 0 : n - ixLength + 1;
+    int last = n + 1 < ihLength? n + 1 : ihLength;
+    for (int m = beg; m < last; m++) {
+      sum += h[m] * x[n - m];
+    }
+    result[n] = sum;
+  }
+}
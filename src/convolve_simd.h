@@ -0,0 +1,56 @@
+/*! @file convolve_simd.h
+ *  @brief Internal brute force convolution with the reversed filter.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_CONVOLVE_SIMD_H_
+#define SRC_CONVOLVE_SIMD_H_
+
+#include <stddef.h>
+#include <simd/attributes.h>
+#include "src/dispatch.h"
+
+#define convolve_reversed_simd KERNEL(convolve_reversed_simd)
+
+/// @brief Calculates the linear convolution of x with the reversed h,
+/// which is the cross-correlation of x and h, see cross_correlate_simd().
+/// @param simd Value indicating whether to use SIMD acceleration or not.
+/// @param x The first signal (long one).
+/// @param xLength The length of the first array in float-s.
+/// @param h The second signal (short one).
+/// @param hLength The length of the second array in float-s.
+/// @param result The resulting signal of length xLength + hLength - 1.
+/// @details The register blocked kernel of convolve_simd() is shared, it
+/// broadcasts h[hLength - 1 - m] instead of h[m], so h is not copied.
+void convolve_reversed_simd(int simd,
+                            const float *__restrict x, size_t xLength,
+                            const float *__restrict h, size_t hLength,
+                            float *__restrict result) NOTNULL(2, 4, 6);
+
+#endif  // SRC_CONVOLVE_SIMD_H_
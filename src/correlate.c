@@ -28,11 +28,18 @@
  *  under the License.
  */
 
-#ifndef NO_FFTF
 #define LIBSIMD_IMPLEMENTATION
 #include "inc/simd/correlate.h"
 #include "inc/simd/convolve.h"
 #include "inc/simd/arithmetic.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <simd/fft.h>
+#include "inc/simd/memory.h"
+#include "src/fft_plan_cache.h"
+#include "src/profile_counters.h"
 
 CrossCorrelationFFTHandle cross_correlate_fft_initialize(size_t xLength,
                                                          size_t hLength) {
@@ -41,6 +48,14 @@ CrossCorrelationFFTHandle cross_correlate_fft_initialize(size_t xLength,
   return handle;
 }
 
+CrossCorrelationFFTHandle cross_correlate_fft_initialize_in_place(
+    size_t xLength, size_t hLength, void *workspace) {
+  CrossCorrelationFFTHandle handle = convolve_fft_initialize_in_place(
+      xLength, hLength, workspace);
+  handle.reverse = 1;
+  return handle;
+}
+
 void cross_correlate_fft(CrossCorrelationFFTHandle handle,
                          const float *x, const float *h,
                          float *result) {
@@ -59,6 +74,15 @@ CrossCorrelationOverlapSaveHandle cross_correlate_overlap_save_initialize(
   return handle;
 }
 
+CrossCorrelationOverlapSaveHandle
+cross_correlate_overlap_save_initialize_in_place(
+    size_t xLength, size_t hLength, void *workspace) {
+  CrossCorrelationOverlapSaveHandle handle =
+      convolve_overlap_save_initialize_in_place(xLength, hLength, workspace);
+  handle.reverse = 1;
+  return handle;
+}
+
 void cross_correlate_overlap_save(CrossCorrelationOverlapSaveHandle handle,
                             const float *__restrict x,
                             const float *__restrict h,
@@ -71,63 +95,60 @@ void cross_correlate_overlap_save_finalize(
   convolve_overlap_save_finalize(handle);
 }
 
-void cross_correlate_simd(int simd,
-                          const float *__restrict x, size_t xLength,
-                          const float *__restrict h, size_t hLength,
-                          float *__restrict result) {
-  for (int n = hLength - 1; n > -(int)xLength; n--) {
-    float sum = 0.f;
-    int beg = n <= 0? -n : 0;
-    int end = -n + hLength;
-    if (end > (int)xLength) {
-      end = (int)xLength;
-    }
-    if (simd) {
-#ifdef __AVX__
-      int simdEnd = beg + ((end - beg) & ~7);
-      __m256 accum = _mm256_setzero_ps();
-      for (int m = beg; m < simdEnd; m += 8) {
-        __m256 xvec = _mm256_loadu_ps(x + m);
-        __m256 hvec = _mm256_loadu_ps(h + n + m);
-        __m256 mulres = _mm256_mul_ps(xvec, hvec);
-        accum = _mm256_add_ps(accum, mulres);
-      }
-      accum = _mm256_hadd_ps(accum, accum);
-      accum = _mm256_hadd_ps(accum, accum);
-      sum = _mm256_get_ps(accum, 0) + _mm256_get_ps(accum, 4);
-      for (int m = simdEnd; m < end; m++) {
-        sum += x[m] * h[n + m];
-      }
-    } else {
-#elif defined(__ARM_NEON__)
-      int simdEnd = beg + ((end - beg) & ~3);
-      float32x4_t accum = vdupq_n_f32(0.f);
-      for (int m = beg; m < simdEnd; m += 4) {
-        float32x4_t xvec = vld1q_f32(x + m);
-        float32x4_t hvec = vld1q_f32(h + n + m);
-        accum = vmlaq_f32(accum, xvec, hvec);
-      }
-      float32x2_t accum2 = vpadd_f32(vget_high_f32(accum),
-                                     vget_low_f32(accum));
-      sum = vget_lane_f32(accum2, 0) + vget_lane_f32(accum2, 1);
-      for (int m = simdEnd; m < end; m++) {
-        sum += x[m] * h[n + m];
-      }
-    } else {
-#else
-    } {
-#endif
-      for (int m = beg; m < end; m++) {
-        sum += x[m] * h[n + m];
-      }
-    }
-    result[-n + hLength - 1] = sum;
+CrossCorrelationBatchHandle cross_correlate_batch_initialize(
+    size_t xLength, const float *h, size_t hLength, int channels) {
+  assert(h != NULL);
+  float *reversed = mallocf(hLength);
+  assert(reversed);
+  rmemcpyf(reversed, h, hLength);
+  CrossCorrelationBatchHandle handle = convolve_batch_initialize(
+      xLength, reversed, hLength, channels);
+  free_aligned(reversed);
+  return handle;
+}
+
+void cross_correlate_batch(CrossCorrelationBatchHandle handle,
+                           const float *const *x, float *const *result) {
+  convolve_batch(handle, x, result);
+}
+
+void cross_correlate_batch_strided(CrossCorrelationBatchHandle handle,
+                                   const float *x, size_t xStride,
+                                   float *result, size_t resultStride) {
+  convolve_batch_strided(handle, x, xStride, result, resultStride);
+}
+
+void cross_correlate_batch_finalize(CrossCorrelationBatchHandle handle) {
+  convolve_batch_finalize(handle);
+}
+
+CrossCorrelationOverlapSaveParallelHandle
+cross_correlate_overlap_save_parallel_initialize(
+    size_t xLength, size_t hLength, ThreadPool *pool, int threads) {
+  CrossCorrelationOverlapSaveParallelHandle handle =
+      convolve_overlap_save_parallel_initialize(xLength, hLength, pool,
+                                                threads);
+  for (int i = 0; i < handle.threads; i++) {
+    handle.workers[i].reverse = 1;
   }
+  return handle;
 }
 
-CrossCorrelationHandle cross_correlate_initialize(size_t xLength,
-                                                size_t hLength) {
-  CrossCorrelationHandle handle = convolve_initialize(xLength, hLength);
+void cross_correlate_overlap_save_parallel(
+    CrossCorrelationOverlapSaveParallelHandle handle,
+    const float *x, const float *h, float *result) {
+  convolve_overlap_save_parallel(handle, x, h, result);
+}
+
+void cross_correlate_overlap_save_parallel_finalize(
+    CrossCorrelationOverlapSaveParallelHandle handle) {
+  convolve_overlap_save_parallel_finalize(handle);
+}
+
+CrossCorrelationHandle cross_correlate_initialize_algorithm(
+    size_t xLength, size_t hLength, ConvolutionAlgorithm algorithm) {
+  CrossCorrelationHandle handle = convolve_initialize_algorithm(
+      xLength, hLength, algorithm);
   switch (handle.algorithm) {
     case kConvolutionAlgorithmFFT:
       handle.handle.fft.reverse = 1;
@@ -135,27 +156,320 @@ CrossCorrelationHandle cross_correlate_initialize(size_t xLength,
     case kConvolutionAlgorithmOverlapSave:
       handle.handle.os.reverse = 1;
       break;
+    case kConvolutionAlgorithmPartitioned:
+      handle.handle.partitioned.reverse = 1;
+      break;
     case kConvolutionAlgorithmBruteForce:
       break;
   }
   return handle;
 }
 
+CrossCorrelationHandle cross_correlate_initialize(size_t xLength,
+                                                size_t hLength) {
+  return cross_correlate_initialize_algorithm(
+      xLength, hLength, convolve_select_algorithm(xLength, hLength));
+}
+
 void cross_correlate(CrossCorrelationHandle handle,
                      const float *__restrict x, const float *__restrict h,
                      float *__restrict result) {
   switch (handle.algorithm) {
     case kConvolutionAlgorithmFFT:
     case kConvolutionAlgorithmOverlapSave:
+    case kConvolutionAlgorithmPartitioned:
       convolve(handle, x, h, result);
       break;
-    case kConvolutionAlgorithmBruteForce:
+    case kConvolutionAlgorithmBruteForce: {
+      // The FFT based methods are traced by convolve()
+      if (__builtin_expect(!(profile_active & PROFILE_TRACE), 1)) {
+        cross_correlate_simd(1, x, handle.x_length, h, handle.h_length,
+                             result);
+        break;
+      }
+      ProfileSample sample;
+      profile_begin(&sample);
       cross_correlate_simd(1, x, handle.x_length, h, handle.h_length, result);
+      profile_trace_convolution(&handle, kSimdTraceCrossCorrelate,
+                                profile_elapsed(&sample));
       break;
+    }
   }
 }
 
 void cross_correlate_finalize(CrossCorrelationHandle handle) {
   convolve_finalize(handle);
 }
-#endif
+
+CrossCorrelationHandle cross_correlate_initialize_with_kernel(
+    size_t xLength, const float *h, size_t hLength) {
+  assert(h != NULL);
+  // Cross-correlation is the convolution with the reversed template
+  float *reversed = mallocf(hLength);
+  assert(reversed);
+  rmemcpyf(reversed, h, hLength);
+  CrossCorrelationHandle handle = convolve_initialize_with_kernel(
+      xLength, reversed, hLength);
+  free_aligned(reversed);
+  return handle;
+}
+
+void cross_correlate_with_kernel(CrossCorrelationHandle handle,
+                                 const float *__restrict x,
+                                 float *__restrict result) {
+  convolve_with_kernel(handle, x, result);
+}
+
+void cross_correlate_with_kernel_scratch(CrossCorrelationHandle handle,
+                                         struct ConvolutionScratch scratch,
+                                         const float *__restrict x,
+                                         float *__restrict result) {
+  convolve_with_kernel_scratch(handle, scratch, x, result);
+}
+CrossCorrelationLagsHandle cross_correlate_lags_initialize(
+    size_t xLength, size_t hLength, int minLag, int maxLag) {
+  assert(xLength > 0);
+  assert(hLength > 0);
+  assert(minLag <= maxLag);
+  assert(minLag > -(int)hLength);
+  assert(maxLag < (int)xLength);
+  CrossCorrelationLagsHandle handle;
+  handle.x_length = xLength;
+  handle.h_length = hLength;
+  handle.min_lag = minLag;
+  handle.max_lag = maxLag;
+  // c[l] reads x[l..l + hLength), the rest of x does not matter
+  handle.x_offset = minLag > 0? minLag : 0;
+  size_t end = (size_t)maxLag + hLength < xLength?
+      (size_t)maxLag + hLength : xLength;
+  handle.x_segment = end - handle.x_offset;
+  // The circular cross-correlation of length N equals the linear one at
+  // the lags if neither the negative ones wrap into the segment, nor
+  // the positive ones read past N
+  int lo = minLag - (int)handle.x_offset, hi = maxLag - (int)handle.x_offset;
+  int N = (hi > 0? hi : 0) + (int)hLength;
+  if (lo < 0 && (int)handle.x_segment - lo > N) {
+    N = (int)handle.x_segment - lo;
+  }
+  N = convolve_fft_good_length(N);
+  handle.workspace = malloc_aligned_ex((N + 2) * sizeof(float),
+                                       kMemoryFlagHugePages);
+  assert(handle.workspace);
+  handle.H = handle.workspace;
+  handle.plans = fft_plans_acquire(N);
+  handle.N = &handle.plans->length;
+  return handle;
+}
+
+CrossCorrelationLagsHandle cross_correlate_mode_initialize(
+    size_t xLength, size_t hLength, CrossCorrelationMode mode) {
+  int minLag = 0, maxLag = 0;
+  switch (mode) {
+    case kCrossCorrelationFull:
+      minLag = 1 - (int)hLength;
+      maxLag = xLength - 1;
+      break;
+    case kCrossCorrelationValid:
+      assert(hLength <= xLength);
+      maxLag = xLength - hLength;
+      break;
+    case kCrossCorrelationSame:
+      minLag = -(int)(hLength / 2);
+      maxLag = minLag + xLength - 1;
+      break;
+  }
+  return cross_correlate_lags_initialize(xLength, hLength, minLag, maxLag);
+}
+
+void cross_correlate_lags(CrossCorrelationLagsHandle handle,
+                          const float *x, const float *h,
+                          float *result) {
+  assert(x != NULL);
+  assert(h != NULL);
+  assert(result != NULL);
+  float *X = handle.plans->buffer;
+  int N = *handle.N;
+  // FFT(h) goes first, X is the only transform buffer
+  memcpy(X, h, handle.h_length * sizeof(h[0]));
+  memsetf(X + handle.h_length, 0.f, N + 2 - handle.h_length);
+  fft_execute(handle.plans->forward);
+  memcpy(handle.H, X, (N + 2) * sizeof(float));
+
+  memcpy(X, x + handle.x_offset, handle.x_segment * sizeof(x[0]));
+  memsetf(X + handle.x_segment, 0.f, N + 2 - handle.x_segment);
+  fft_execute(handle.plans->forward);
+  complex_multiply_conjugate_array(X, handle.H, N + 2, X);
+  fft_execute(handle.plans->backward);
+
+  // The negative lags are at the end of the circular result
+  int lo = handle.min_lag - (int)handle.x_offset;
+  int hi = handle.max_lag - (int)handle.x_offset;
+  if (lo < 0) {
+    int negative = (hi < 0? hi + 1 : 0) - lo;
+    real_multiply_scalar(X + N + lo, negative, 1.0f / N, result);
+    result += negative;
+    lo = 0;
+  }
+  if (hi >= lo) {
+    real_multiply_scalar(X + lo, hi - lo + 1, 1.0f / N, result);
+  }
+}
+
+void cross_correlate_lags_finalize(CrossCorrelationLagsHandle handle) {
+  fft_plans_release(handle.plans);
+  free_aligned(handle.workspace);
+}
+
+NormalizedCrossCorrelationHandle normalized_cross_correlate_initialize(
+    size_t xLength, const float *h, size_t hLength) {
+  assert(h != NULL);
+  assert(hLength > 0);
+  assert(hLength <= xLength);
+  double mean = 0;
+  for (size_t i = 0; i < hLength; i++) {
+    mean += h[i];
+  }
+  mean /= hLength;
+  float *centered = mallocf(hLength);
+  assert(centered);
+  double norm = 0;
+  for (size_t i = 0; i < hLength; i++) {
+    centered[i] = h[i] - mean;
+    norm += (double)centered[i] * centered[i];
+  }
+  NormalizedCrossCorrelationHandle handle;
+  handle.correlation = cross_correlate_initialize_with_kernel(
+      xLength, centered, hLength);
+  free_aligned(centered);
+  handle.buffer = mallocf(xLength + hLength - 1);
+  assert(handle.buffer);
+  handle.x_length = xLength;
+  handle.h_length = hLength;
+  handle.h_norm = sqrt(norm);
+  return handle;
+}
+
+void normalized_cross_correlate(NormalizedCrossCorrelationHandle handle,
+                                const float *__restrict x,
+                                float *__restrict result) {
+  assert(x != NULL);
+  assert(result != NULL);
+  cross_correlate_with_kernel(handle.correlation, x, handle.buffer);
+  cross_correlate_normalize(x, handle.h_length, handle.h_norm,
+                            handle.buffer + handle.h_length - 1,
+                            handle.x_length - handle.h_length + 1, result);
+}
+
+void normalized_cross_correlate_finalize(
+    NormalizedCrossCorrelationHandle handle) {
+  cross_correlate_finalize(handle.correlation);
+  free_aligned(handle.buffer);
+}
+
+CrossCorrelationBankHandle cross_correlate_bank_initialize(
+    size_t xLength, const float *const *h, const size_t *hLengths,
+    int templates) {
+  assert(h != NULL);
+  assert(hLengths != NULL);
+  assert(xLength > 0);
+  assert(templates > 0);
+  CrossCorrelationBankHandle handle;
+  handle.x_length = xLength;
+  handle.templates = templates;
+  handle.h_lengths = malloc(templates * sizeof(hLengths[0]));
+  assert(handle.h_lengths);
+  memcpy(handle.h_lengths, hLengths, templates * sizeof(hLengths[0]));
+  size_t maxLength = 0;
+  for (int i = 0; i < templates; i++) {
+    assert(h[i] != NULL);
+    assert(hLengths[i] > 0);
+    if (hLengths[i] > maxLength) {
+      maxLength = hLengths[i];
+    }
+  }
+  int N = convolve_fft_good_length(xLength + maxLength - 1);
+  handle.plans = fft_plans_acquire(N);
+  handle.N = &handle.plans->length;
+  size_t spectrum = N + 2;
+  handle.workspace = malloc_aligned_ex(
+      ((templates + 1) * spectrum + xLength + maxLength - 1) * sizeof(float),
+      kMemoryFlagHugePages);
+  assert(handle.workspace);
+  handle.H = handle.workspace;
+  handle.X = handle.H + templates * spectrum;
+  handle.buffer = handle.X + spectrum;
+  // The normalization of the inverse transforms is folded into the spectra
+  float *buffer = handle.plans->buffer;
+  for (int i = 0; i < templates; i++) {
+    memcpy(buffer, h[i], hLengths[i] * sizeof(float));
+    memsetf(buffer + hLengths[i], 0.f, spectrum - hLengths[i]);
+    fft_execute(handle.plans->forward);
+    real_multiply_scalar(buffer, spectrum, 1.0f / N, handle.H + i * spectrum);
+  }
+  return handle;
+}
+
+/// @brief Calculates the cross-correlation with the template of the bank,
+/// the spectrum of the signal must be already in handle.X.
+static void cross_correlate_bank_template(CrossCorrelationBankHandle handle,
+                                          int index, float *result) {
+  float *buffer = handle.plans->buffer;
+  int N = *handle.N;
+  size_t hLength = handle.h_lengths[index];
+  complex_multiply_conjugate_array(handle.X, handle.H + index * (N + 2),
+                                   N + 2, buffer);
+  fft_execute(handle.plans->backward);
+  // The negative lags are at the end of the circular result
+  memcpy(result, buffer + N - (hLength - 1), (hLength - 1) * sizeof(float));
+  memcpyf(result + hLength - 1, buffer, handle.x_length);
+}
+
+/// @brief Transforms the signal into handle.X.
+static void cross_correlate_bank_transform(CrossCorrelationBankHandle handle,
+                                           const float *x) {
+  float *buffer = handle.plans->buffer;
+  int N = *handle.N;
+  memcpy(buffer, x, handle.x_length * sizeof(float));
+  memsetf(buffer + handle.x_length, 0.f, N + 2 - handle.x_length);
+  fft_execute(handle.plans->forward);
+  memcpy(handle.X, buffer, (N + 2) * sizeof(float));
+}
+
+void cross_correlate_bank(CrossCorrelationBankHandle handle,
+                          const float *x, float *const *result) {
+  assert(x != NULL);
+  assert(result != NULL);
+  cross_correlate_bank_transform(handle, x);
+  for (int i = 0; i < handle.templates; i++) {
+    assert(result[i] != NULL);
+    cross_correlate_bank_template(handle, i, result[i]);
+  }
+}
+
+void cross_correlate_bank_peaks(CrossCorrelationBankHandle handle,
+                                const float *x, ExtremumType type,
+                                const DetectPeaksFilters *filters,
+                                ExtremumPoint **results,
+                                size_t *resultsLengths) {
+  assert(x != NULL);
+  assert(results != NULL);
+  assert(resultsLengths != NULL);
+  DetectPeaksFilters none;
+  if (filters == NULL) {
+    detect_peaks_filters_initialize(&none);
+    filters = &none;
+  }
+  cross_correlate_bank_transform(handle, x);
+  for (int i = 0; i < handle.templates; i++) {
+    cross_correlate_bank_template(handle, i, handle.buffer);
+    detect_peaks_filtered(1, handle.buffer,
+                          handle.x_length + handle.h_lengths[i] - 1,
+                          type, filters, results + i, resultsLengths + i);
+  }
+}
+
+void cross_correlate_bank_finalize(CrossCorrelationBankHandle handle) {
+  fft_plans_release(handle.plans);
+  free_aligned(handle.workspace);
+  free(handle.h_lengths);
+}
@@ -0,0 +1,141 @@
+/*! @file correlate_simd.c
+ *  @brief Brute force cross-correlation, built per instruction set.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#define LIBSIMD_IMPLEMENTATION
+#include "src/dispatch.h"
+#define cross_correlate_simd KERNEL(cross_correlate_simd)
+#define cross_correlate_normalize KERNEL(cross_correlate_normalize)
+#include "inc/simd/correlate.h"
+#include <simd/instruction_set.h>
+#include <assert.h>
+#include <math.h>
+#include "src/convolve_simd.h"
+
+void cross_correlate_simd(int simd,
+                          const float *__restrict x, size_t xLength,
+                          const float *__restrict h, size_t hLength,
+                          float *__restrict result) {
+  // The cross-correlation is the convolution with the reversed h
+  convolve_reversed_simd(simd, x, xLength, h, hLength, result);
+}
+
+/// @brief The windows with the variance below this share of the sum of
+/// squares are considered constant.
+#define NORMALIZE_VARIANCE_EPSILON 1e-12
+
+/// @brief Calculates the normalized value from the window sums.
+static inline float normalize_window(float correlation, double sum,
+                                     double sum2, double invh, double norm) {
+  double variance = sum2 - sum * sum * invh;
+  if (variance <= sum2 * NORMALIZE_VARIANCE_EPSILON || norm == 0) {
+    return 0;
+  }
+  return correlation / (sqrt(variance) * norm);
+}
+
+#ifdef __AVX__
+/// @brief Returns the inclusive prefix sums of the 4 doubles.
+static inline __m256d prefix_sum256_pd(__m256d v) {
+  // [0, 0, v0, v1]
+  __m256d low = _mm256_permute2f128_pd(v, v, 0x08);
+  // + [0, v0, v1, v2]
+  v = _mm256_add_pd(v, _mm256_shuffle_pd(low, v, 5));
+  // + [0, 0, s0, s1]
+  return _mm256_add_pd(v, _mm256_permute2f128_pd(v, v, 0x08));
+}
+
+/// @brief Broadcasts the last of the 4 doubles.
+static inline __m256d broadcast_last256_pd(__m256d v) {
+  return _mm256_permute_pd(_mm256_permute2f128_pd(v, v, 0x11), 0xF);
+}
+#endif
+
+void cross_correlate_normalize(const float *x, size_t hLength, float hNorm,
+                               const float *correlation, size_t length,
+                               float *result) {
+  assert(x != NULL);
+  assert(correlation != NULL);
+  assert(result != NULL);
+  assert(hLength > 0);
+  double sum = 0, sum2 = 0;
+  for (size_t i = 0; i < hLength; i++) {
+    sum += x[i];
+    sum2 += (double)x[i] * x[i];
+  }
+  const double invh = 1.0 / hLength;
+  size_t l = 0;
+#ifdef __AVX__
+  // The window sums are the running sums of d[i] = x[i + hLength] - x[i],
+  // each block of 4 is the prefix sum plus the carry of the previous ones.
+  // The last block is left to the scalar loop, since it would read
+  // x[xLength].
+  __m256d sumVec = _mm256_set1_pd(sum), sum2Vec = _mm256_set1_pd(sum2);
+  const __m256d invhVec = _mm256_set1_pd(invh);
+  const __m256d normVec = _mm256_set1_pd(hNorm);
+  const __m256d epsVec = _mm256_set1_pd(NORMALIZE_VARIANCE_EPSILON);
+  const __m256d zeroVec = _mm256_setzero_pd();
+  for (; l + 4 < length; l += 4) {
+    __m256d head = _mm256_cvtps_pd(_mm_loadu_ps(x + l + hLength));
+    __m256d tail = _mm256_cvtps_pd(_mm_loadu_ps(x + l));
+    __m256d diff = _mm256_sub_pd(head, tail);
+    __m256d diff2 = _mm256_sub_pd(_mm256_mul_pd(head, head),
+                                  _mm256_mul_pd(tail, tail));
+    __m256d inclusive = _mm256_add_pd(sumVec, prefix_sum256_pd(diff));
+    __m256d inclusive2 = _mm256_add_pd(sum2Vec, prefix_sum256_pd(diff2));
+    __m256d s = _mm256_sub_pd(inclusive, diff);
+    __m256d s2 = _mm256_sub_pd(inclusive2, diff2);
+    sumVec = broadcast_last256_pd(inclusive);
+    sum2Vec = broadcast_last256_pd(inclusive2);
+    __m256d variance = _mm256_sub_pd(
+        s2, _mm256_mul_pd(_mm256_mul_pd(s, s), invhVec));
+    __m256d valid = _mm256_and_pd(
+        _mm256_cmp_pd(_mm256_mul_pd(s2, epsVec), variance, _CMP_LT_OS),
+        _mm256_cmp_pd(normVec, zeroVec, _CMP_NEQ_UQ));
+    __m256d denominator = _mm256_mul_pd(
+        _mm256_sqrt_pd(_mm256_max_pd(variance, zeroVec)), normVec);
+    __m256d value = _mm256_div_pd(
+        _mm256_cvtps_pd(_mm_loadu_ps(correlation + l)),
+        _mm256_blendv_pd(_mm256_set1_pd(1), denominator, valid));
+    _mm_storeu_ps(result + l,
+                  _mm256_cvtpd_ps(_mm256_and_pd(value, valid)));
+  }
+  sum = _mm_cvtsd_f64(_mm256_castpd256_pd128(sumVec));
+  sum2 = _mm_cvtsd_f64(_mm256_castpd256_pd128(sum2Vec));
+#endif
+  for (; l < length; l++) {
+    float value = normalize_window(correlation[l], sum, sum2, invh, hNorm);
+    if (l + 1 < length) {
+      float head = x[l + hLength], tail = x[l];
+      sum += head - tail;
+      sum2 += (double)head * head - (double)tail * tail;
+    }
+    result[l] = value;
+  }
+}
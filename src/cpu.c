@@ -0,0 +1,139 @@
+/*! @file cpu.c
+ *  @brief Detection of the instruction sets supported by the host.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#define LIBSIMD_IMPLEMENTATION
+#include "inc/simd/cpu.h"
+#include <stddef.h>
+#include <simd/instruction_set.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+
+/* Old <cpuid.h> lack the leaf 7 feature bits */
+#ifndef bit_AVX2
+#define bit_AVX2 (1 << 5)
+#endif
+#ifndef bit_AVX512F
+#define bit_AVX512F (1 << 16)
+#endif
+#ifndef bit_AVX512DQ
+#define bit_AVX512DQ (1 << 17)
+#endif
+#ifndef bit_AVX512CD
+#define bit_AVX512CD (1 << 28)
+#endif
+#ifndef bit_AVX512BW
+#define bit_AVX512BW (1 << 30)
+#endif
+#ifndef bit_AVX512VL
+#define bit_AVX512VL (1u << 31)
+#endif
+
+/* XCR0 bits: SSE and AVX register state */
+#define XCR0_YMM 0x06
+/* XCR0 bits: SSE, AVX, opmask and both halves of ZMM register state */
+#define XCR0_ZMM 0xE6
+
+static InstructionSet detect_instruction_set(void) {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return kInstructionSetNone;
+  }
+  if ((ecx & bit_SSE4_2) == 0 || (ecx & bit_POPCNT) == 0) {
+    return kInstructionSetNone;
+  }
+  // The OS must save the YMM registers on context switch, checked by XGETBV
+  if ((ecx & bit_OSXSAVE) == 0 || (ecx & bit_AVX) == 0) {
+    return kInstructionSetSSE4;
+  }
+  unsigned long long xcr0 = __xgetbv();
+  if ((xcr0 & XCR0_YMM) != XCR0_YMM) {
+    return kInstructionSetSSE4;
+  }
+  int fma_f16c = (ecx & bit_FMA) != 0 && (ecx & bit_F16C) != 0;
+  if (__get_cpuid_max(0, NULL) < 7) {
+    return kInstructionSetAVX;
+  }
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  if ((ebx & bit_AVX2) == 0 || !fma_f16c) {
+    return kInstructionSetAVX;
+  }
+  const unsigned int avx512 = bit_AVX512F | bit_AVX512CD | bit_AVX512BW |
+      bit_AVX512DQ | bit_AVX512VL;
+  if ((ebx & avx512) != avx512 || (xcr0 & XCR0_ZMM) != XCR0_ZMM) {
+    return kInstructionSetAVX2;
+  }
+  return kInstructionSetAVX512;
+}
+
+#else
+
+static InstructionSet detect_instruction_set(void) {
+#ifdef __aarch64__
+  return kInstructionSetAArch64;
+#elif defined(__ARM_NEON__)
+  return kInstructionSetNEON;
+#else
+  return kInstructionSetNone;
+#endif
+}
+
+#endif  // defined(__i386__) || defined(__x86_64__)
+
+InstructionSet simd_cpu_instruction_set(void) {
+  static int detected = 0;
+  static InstructionSet isa = kInstructionSetNone;
+  if (!detected) {
+    isa = detect_instruction_set();
+    detected = 1;
+  }
+  return isa;
+}
+
+const char *simd_instruction_set_name(InstructionSet isa) {
+  switch (isa) {
+    case kInstructionSetNone:
+      return "none";
+    case kInstructionSetSSE4:
+      return "sse4";
+    case kInstructionSetAVX:
+      return "avx";
+    case kInstructionSetAVX2:
+      return "avx2";
+    case kInstructionSetAVX512:
+      return "avx512";
+    case kInstructionSetNEON:
+      return "neon";
+    case kInstructionSetAArch64:
+      return "aarch64";
+  }
+  return "unknown";
+}
@@ -10,11 +10,39 @@
  *  Copyright © 2013 Samsung R&D Institute Russia
  */
 
+#include "src/dispatch.h"
+#define detect_peaks KERNEL(detect_peaks)
+#define detect_peaks_filters_initialize KERNEL(detect_peaks_filters_initialize)
+#define detect_peaks_filtered KERNEL(detect_peaks_filtered)
+#define detect_peaks_stream_initialize KERNEL(detect_peaks_stream_initialize)
+#define detect_peaks_stream_push KERNEL(detect_peaks_stream_push)
+#define detect_peaks_stream_pop KERNEL(detect_peaks_stream_pop)
+#define detect_peaks_stream_flush KERNEL(detect_peaks_stream_flush)
+#define argminmax1D KERNEL(argminmax1D)
+#define topk1D KERNEL(topk1D)
 #include "inc/simd/detect_peaks.h"
 #include <assert.h>
 #include <limits.h>
+#include <math.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <simd/instruction_set.h>
+#include <simd/memory.h>
+
+/// @brief The number of the samples which detect_peaks_filtered() scans
+/// at once.
+#define DETECT_PEAKS_CHUNK 4096
+
+/// @brief Where the found extrema go: either the growing array of
+/// detect_peaks() or the ring buffer of the stream.
+typedef struct {
+  ExtremumPoint *points;
+  size_t length;
+  size_t allocated;
+  DetectPeaksStream *stream;
+  /// Added to the positions of the points which go to the stream.
+  size_t offset;
+} PeakSink;
 
 INLINE void append_peak(int position, float value, int index,
                         ExtremumPoint **results, size_t *allocatedSize) {
@@ -38,19 +66,389 @@ INLINE void append_peak(int position, float value, int index,
                                           .value = value };
 }
 
-INLINE void check_peak(const float *data, int index, ExtremumType type,
-                       ExtremumPoint **results, size_t *resultsLength,
-                       size_t *allocatedSize) {
+/// @brief Writes the point to the ring buffer, overwriting the oldest one
+/// if it is full.
+INLINE void append_peak_stream(DetectPeaksStream *stream, size_t position,
+                               float value) {
+  if (stream->capacity == 0) {
+    stream->lost++;
+    return;
+  }
+  size_t index = stream->first + stream->count;
+  if (index >= stream->capacity) {
+    index -= stream->capacity;
+  }
+  if (stream->count < stream->capacity) {
+    stream->count++;
+  } else {
+    stream->lost++;
+    if (++stream->first == stream->capacity) {
+      stream->first = 0;
+    }
+  }
+  stream->points[index] = (ExtremumPoint) { .position = (int)position,
+                                            .value = value };
+}
+
+INLINE void emit_peak(PeakSink *sink, int position, float value) {
+  if (sink->stream != NULL) {
+    append_peak_stream(sink->stream, sink->offset + position, value);
+    return;
+  }
+  append_peak(position, value, sink->length, &sink->points, &sink->allocated);
+  sink->length++;
+}
+
+/// @brief Which extrema are searched for.
+typedef struct {
+  ExtremumType type;
+  /// The maxima less than it are skipped.
+  float maximumThreshold;
+  /// The minima greater than it are skipped.
+  float minimumThreshold;
+} PeakSelection;
+
+INLINE PeakSelection peak_selection(ExtremumType type) {
+  return (PeakSelection) { .type = type, .maximumThreshold = -INFINITY,
+                           .minimumThreshold = INFINITY };
+}
+
+INLINE void check_peak(const float *data, int index,
+                       const PeakSelection *selection, PeakSink *sink) {
   float prev = data[index - 1];
   float curr = data[index];
   float next = data[index + 1];
-  float delta1 = curr - prev;
-  float delta2 = curr - next;
-  if (delta1 * delta2 > 0) {
-    if ((delta1 > 0 && (type & kExtremumTypeMaximum) != 0) ||
-        (delta1 < 0 && (type & kExtremumTypeMinimum) != 0)) {
-      append_peak(index, curr, *resultsLength, results, allocatedSize);
-      (*resultsLength)++;
+  // The same comparisons as in peaks_mask(), so that both always agree
+  if (((selection->type & kExtremumTypeMaximum) != 0 &&
+       curr > prev && curr > next && curr >= selection->maximumThreshold) ||
+      ((selection->type & kExtremumTypeMinimum) != 0 &&
+       curr < prev && curr < next && curr <= selection->minimumThreshold)) {
+    emit_peak(sink, index, curr);
+  }
+}
+
+/// @brief Makes room for at least count points in the growing array.
+INLINE void reserve_peaks(PeakSink *sink, size_t count) {
+  if (sink->allocated >= count) {
+    return;
+  }
+  size_t size = sink->allocated > 0? sink->allocated : 2;
+  while (size < count) {
+    size <<= 1;
+  }
+  sink->allocated = size;
+  sink->points = realloc(sink->points, size * sizeof(sink->points[0]));
+}
+
+/// @brief Returns where the compacted points of the next block go: right
+/// to the end of the growing array, or to block if they are for the ring
+/// buffer of the stream.
+INLINE ExtremumPoint *peaks_destination(PeakSink *sink, ExtremumPoint *block,
+                                        int blockLength) {
+  if (sink->stream != NULL) {
+    return block;
+  }
+  reserve_peaks(sink, sink->length + blockLength);
+  return sink->points + sink->length;
+}
+
+/// @brief Accepts the first count compacted points of the block.
+INLINE void peaks_commit(PeakSink *sink, const ExtremumPoint *block,
+                         int count) {
+  if (sink->stream == NULL) {
+    sink->length += count;
+    return;
+  }
+  for (int k = 0; k < count; k++) {
+    append_peak_stream(sink->stream, sink->offset + block[k].position,
+                       block[k].value);
+  }
+}
+
+/*
+ * peaks_mask(data, maxsel, minsel, maxThreshold, minThreshold) returns the
+ * bit mask of the extrema among data[1] ... data[PEAKS_VL] which pass the
+ * thresholds. compact_peaks(dest, position, values,
+ * mask) writes PEAKS_VL points to dest so that the selected ones go first,
+ * in order; the rest of dest is garbage. Neither branches on the data.
+ */
+
+#ifdef __AVX512F__
+
+#define PEAKS_VL 16
+
+INLINE unsigned peaks_mask(const float *data, unsigned maxsel,
+                           unsigned minsel, float maxThreshold,
+                           float minThreshold) {
+  __m512 prev = _mm512_loadu_ps(data);
+  __m512 curr = _mm512_loadu_ps(data + 1);
+  __m512 next = _mm512_loadu_ps(data + 2);
+  __mmask16 maxima = _mm512_mask_cmp_ps_mask(
+      _mm512_cmp_ps_mask(curr, prev, _CMP_GT_OQ), curr, next, _CMP_GT_OQ);
+  maxima = _mm512_mask_cmp_ps_mask(maxima, curr, _mm512_set1_ps(maxThreshold),
+                                   _CMP_GE_OQ);
+  __mmask16 minima = _mm512_mask_cmp_ps_mask(
+      _mm512_cmp_ps_mask(curr, prev, _CMP_LT_OQ), curr, next, _CMP_LT_OQ);
+  minima = _mm512_mask_cmp_ps_mask(minima, curr, _mm512_set1_ps(minThreshold),
+                                   _CMP_LE_OQ);
+  return (maxima & maxsel) | (minima & minsel);
+}
+
+INLINE void compact_peaks(ExtremumPoint *dest, int position,
+                          const float *values, unsigned mask) {
+  __m512i positions = _mm512_add_epi32(
+      _mm512_set1_epi32(position),
+      _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                        8, 9, 10, 11, 12, 13, 14, 15));
+  __m512 pos = _mm512_castsi512_ps(
+      _mm512_maskz_compress_epi32(mask, positions));
+  __m512 val = _mm512_maskz_compress_ps(mask, _mm512_loadu_ps(values));
+  // Interleave into {position, value} pairs
+  __m512i lo = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19,
+                                 4, 20, 5, 21, 6, 22, 7, 23);
+  __m512i hi = _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27,
+                                 12, 28, 13, 29, 14, 30, 15, 31);
+  _mm512_storeu_ps(dest, _mm512_permutex2var_ps(pos, lo, val));
+  _mm512_storeu_ps(dest + 8, _mm512_permutex2var_ps(pos, hi, val));
+}
+
+#elif defined(__AVX__)
+
+#define PEAKS_VL 8
+
+INLINE unsigned peaks_mask(const float *data, unsigned maxsel,
+                           unsigned minsel, float maxThreshold,
+                           float minThreshold) {
+#ifndef SIMD_AVX_EMULATION
+  __m256 prev = _mm256_loadu_ps(data);
+  __m256 curr = _mm256_loadu_ps(data + 1);
+  __m256 next = _mm256_loadu_ps(data + 2);
+  __m256 maxima = _mm256_and_ps(_mm256_cmp_ps(curr, prev, _CMP_GT_OQ),
+                                _mm256_cmp_ps(curr, next, _CMP_GT_OQ));
+  maxima = _mm256_and_ps(maxima, _mm256_cmp_ps(
+      curr, _mm256_set1_ps(maxThreshold), _CMP_GE_OQ));
+  __m256 minima = _mm256_and_ps(_mm256_cmp_ps(curr, prev, _CMP_LT_OQ),
+                                _mm256_cmp_ps(curr, next, _CMP_LT_OQ));
+  minima = _mm256_and_ps(minima, _mm256_cmp_ps(
+      curr, _mm256_set1_ps(minThreshold), _CMP_LE_OQ));
+  return (_mm256_movemask_ps(maxima) & maxsel) |
+      (_mm256_movemask_ps(minima) & minsel);
+#else
+  // The emulated _mm256_cmp_ps() lets the unaligned loads be folded
+  // into CMPPS, which faults, so use the SSE halves directly
+  __m128 maxThresholds = _mm_set1_ps(maxThreshold);
+  __m128 minThresholds = _mm_set1_ps(minThreshold);
+  unsigned maxima = 0, minima = 0;
+  for (int k = 0; k < 8; k += 4) {
+    __m128 prev = _mm_loadu_ps(data + k);
+    __m128 curr = _mm_loadu_ps(data + k + 1);
+    __m128 next = _mm_loadu_ps(data + k + 2);
+    __m128 max = _mm_and_ps(_mm_cmpgt_ps(curr, prev),
+                            _mm_cmpgt_ps(curr, next));
+    max = _mm_and_ps(max, _mm_cmpge_ps(curr, maxThresholds));
+    __m128 min = _mm_and_ps(_mm_cmplt_ps(curr, prev),
+                            _mm_cmplt_ps(curr, next));
+    min = _mm_and_ps(min, _mm_cmple_ps(curr, minThresholds));
+    maxima |= _mm_movemask_ps(max) << k;
+    minima |= _mm_movemask_ps(min) << k;
+  }
+  return (maxima & maxsel) | (minima & minsel);
+#endif
+}
+
+#ifdef __AVX2__
+
+/// @brief The lane indices of the set bits of every 8-bit mask,
+/// packed into nibbles.
+static const uint32_t kPeaksCompressIndices[256] = {
+  0x00000000, 0x00000000, 0x00000001, 0x00000010, 0x00000002, 0x00000020,
+  0x00000021, 0x00000210, 0x00000003, 0x00000030, 0x00000031, 0x00000310,
+  0x00000032, 0x00000320, 0x00000321, 0x00003210, 0x00000004, 0x00000040,
+  0x00000041, 0x00000410, 0x00000042, 0x00000420, 0x00000421, 0x00004210,
+  0x00000043, 0x00000430, 0x00000431, 0x00004310, 0x00000432, 0x00004320,
+  0x00004321, 0x00043210, 0x00000005, 0x00000050, 0x00000051, 0x00000510,
+  0x00000052, 0x00000520, 0x00000521, 0x00005210, 0x00000053, 0x00000530,
+  0x00000531, 0x00005310, 0x00000532, 0x00005320, 0x00005321, 0x00053210,
+  0x00000054, 0x00000540, 0x00000541, 0x00005410, 0x00000542, 0x00005420,
+  0x00005421, 0x00054210, 0x00000543, 0x00005430, 0x00005431, 0x00054310,
+  0x00005432, 0x00054320, 0x00054321, 0x00543210, 0x00000006, 0x00000060,
+  0x00000061, 0x00000610, 0x00000062, 0x00000620, 0x00000621, 0x00006210,
+  0x00000063, 0x00000630, 0x00000631, 0x00006310, 0x00000632, 0x00006320,
+  0x00006321, 0x00063210, 0x00000064, 0x00000640, 0x00000641, 0x00006410,
+  0x00000642, 0x00006420, 0x00006421, 0x00064210, 0x00000643, 0x00006430,
+  0x00006431, 0x00064310, 0x00006432, 0x00064320, 0x00064321, 0x00643210,
+  0x00000065, 0x00000650, 0x00000651, 0x00006510, 0x00000652, 0x00006520,
+  0x00006521, 0x00065210, 0x00000653, 0x00006530, 0x00006531, 0x00065310,
+  0x00006532, 0x00065320, 0x00065321, 0x00653210, 0x00000654, 0x00006540,
+  0x00006541, 0x00065410, 0x00006542, 0x00065420, 0x00065421, 0x00654210,
+  0x00006543, 0x00065430, 0x00065431, 0x00654310, 0x00065432, 0x00654320,
+  0x00654321, 0x06543210, 0x00000007, 0x00000070, 0x00000071, 0x00000710,
+  0x00000072, 0x00000720, 0x00000721, 0x00007210, 0x00000073, 0x00000730,
+  0x00000731, 0x00007310, 0x00000732, 0x00007320, 0x00007321, 0x00073210,
+  0x00000074, 0x00000740, 0x00000741, 0x00007410, 0x00000742, 0x00007420,
+  0x00007421, 0x00074210, 0x00000743, 0x00007430, 0x00007431, 0x00074310,
+  0x00007432, 0x00074320, 0x00074321, 0x00743210, 0x00000075, 0x00000750,
+  0x00000751, 0x00007510, 0x00000752, 0x00007520, 0x00007521, 0x00075210,
+  0x00000753, 0x00007530, 0x00007531, 0x00075310, 0x00007532, 0x00075320,
+  0x00075321, 0x00753210, 0x00000754, 0x00007540, 0x00007541, 0x00075410,
+  0x00007542, 0x00075420, 0x00075421, 0x00754210, 0x00007543, 0x00075430,
+  0x00075431, 0x00754310, 0x00075432, 0x00754320, 0x00754321, 0x07543210,
+  0x00000076, 0x00000760, 0x00000761, 0x00007610, 0x00000762, 0x00007620,
+  0x00007621, 0x00076210, 0x00000763, 0x00007630, 0x00007631, 0x00076310,
+  0x00007632, 0x00076320, 0x00076321, 0x00763210, 0x00000764, 0x00007640,
+  0x00007641, 0x00076410, 0x00007642, 0x00076420, 0x00076421, 0x00764210,
+  0x00007643, 0x00076430, 0x00076431, 0x00764310, 0x00076432, 0x00764320,
+  0x00764321, 0x07643210, 0x00000765, 0x00007650, 0x00007651, 0x00076510,
+  0x00007652, 0x00076520, 0x00076521, 0x00765210, 0x00007653, 0x00076530,
+  0x00076531, 0x00765310, 0x00076532, 0x00765320, 0x00765321, 0x07653210,
+  0x00007654, 0x00076540, 0x00076541, 0x00765410, 0x00076542, 0x00765420,
+  0x00765421, 0x07654210, 0x00076543, 0x00765430, 0x00765431, 0x07654310,
+  0x00765432, 0x07654320, 0x07654321, 0x76543210,
+};
+
+INLINE void compact_peaks(ExtremumPoint *dest, int position,
+                          const float *values, unsigned mask) {
+  __m256i indices = _mm256_srlv_epi32(
+      _mm256_set1_epi32(kPeaksCompressIndices[mask]),
+      _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28));
+  indices = _mm256_and_si256(indices, _mm256_set1_epi32(7));
+  __m256i positions = _mm256_add_epi32(
+      _mm256_set1_epi32(position), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  __m256 pos = _mm256_castsi256_ps(
+      _mm256_permutevar8x32_epi32(positions, indices));
+  __m256 val = _mm256_permutevar8x32_ps(_mm256_loadu_ps(values), indices);
+  // Interleave into {position, value} pairs
+  __m256 lo = _mm256_unpacklo_ps(pos, val);
+  __m256 hi = _mm256_unpackhi_ps(pos, val);
+  _mm256_storeu_ps((float *)dest, _mm256_permute2f128_ps(lo, hi, 0x20));
+  _mm256_storeu_ps((float *)(dest + 4), _mm256_permute2f128_ps(lo, hi, 0x31));
+}
+
+#else
+
+/// @brief The byte shuffles which move the lanes of the set bits of every
+/// 4-bit mask to the front.
+static const uint8_t kPeaksCompressShuffles[16][16] = {
+  { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x00, 0x01, 0x02, 0x03, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x04, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x08, 0x09, 0x0A, 0x0B, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x00, 0x01, 0x02, 0x03, 0x08, 0x09, 0x0A, 0x0B,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0A, 0x0B, 0x80, 0x80, 0x80, 0x80 },
+  { 0x0C, 0x0D, 0x0E, 0x0F, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x00, 0x01, 0x02, 0x03, 0x0C, 0x0D, 0x0E, 0x0F,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x04, 0x05, 0x06, 0x07, 0x0C, 0x0D, 0x0E, 0x0F,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x0C, 0x0D, 0x0E, 0x0F, 0x80, 0x80, 0x80, 0x80 },
+  { 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+  { 0x00, 0x01, 0x02, 0x03, 0x08, 0x09, 0x0A, 0x0B,
+    0x0C, 0x0D, 0x0E, 0x0F, 0x80, 0x80, 0x80, 0x80 },
+  { 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B,
+    0x0C, 0x0D, 0x0E, 0x0F, 0x80, 0x80, 0x80, 0x80 },
+  { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F },
+};
+
+INLINE void compact_peaks4(ExtremumPoint *dest, int position,
+                           const float *values, unsigned mask) {
+  __m128i shuffle = _mm_loadu_si128(
+      (const __m128i *)kPeaksCompressShuffles[mask]);
+  __m128i positions = _mm_add_epi32(_mm_set1_epi32(position),
+                                    _mm_setr_epi32(0, 1, 2, 3));
+  __m128 pos = _mm_castsi128_ps(_mm_shuffle_epi8(positions, shuffle));
+  __m128 val = _mm_castsi128_ps(_mm_shuffle_epi8(
+      _mm_castps_si128(_mm_loadu_ps(values)), shuffle));
+  // Interleave into {position, value} pairs
+  _mm_storeu_ps((float *)dest, _mm_unpacklo_ps(pos, val));
+  _mm_storeu_ps((float *)(dest + 2), _mm_unpackhi_ps(pos, val));
+}
+
+INLINE void compact_peaks(ExtremumPoint *dest, int position,
+                          const float *values, unsigned mask) {
+  compact_peaks4(dest, position, values, mask & 0xF);
+  compact_peaks4(dest + __builtin_popcount(mask & 0xF), position + 4,
+                 values + 4, mask >> 4);
+}
+
+#endif  // __AVX2__
+
+#elif defined(__ARM_NEON__)
+
+#define PEAKS_VL 4
+
+INLINE unsigned peaks_mask(const float *data, unsigned maxsel,
+                           unsigned minsel, float maxThreshold,
+                           float minThreshold) {
+  float32x4_t prev = vld1q_f32(data);
+  float32x4_t curr = vld1q_f32(data + 1);
+  float32x4_t next = vld1q_f32(data + 2);
+  uint32x4_t maxima = vandq_u32(vcgtq_f32(curr, prev), vcgtq_f32(curr, next));
+  maxima = vandq_u32(maxima, vcgeq_f32(curr, vdupq_n_f32(maxThreshold)));
+  uint32x4_t minima = vandq_u32(vcltq_f32(curr, prev), vcltq_f32(curr, next));
+  minima = vandq_u32(minima, vcleq_f32(curr, vdupq_n_f32(minThreshold)));
+  uint32x4_t selected = vorrq_u32(vandq_u32(maxima, vdupq_n_u32(maxsel)),
+                                  vandq_u32(minima, vdupq_n_u32(minsel)));
+  const uint32_t weights[4] = { 1, 2, 4, 8 };
+  uint32x4_t bits = vandq_u32(selected, vld1q_u32(weights));
+  uint32x2_t sum = vpadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+  sum = vpadd_u32(sum, sum);
+  return vget_lane_u32(sum, 0);
+}
+
+INLINE void compact_peaks(ExtremumPoint *dest, int position,
+                          const float *values, unsigned mask) {
+  // Every point is written, but only the selected ones advance
+  int count = 0;
+  for (int k = 0; k < 4; k++) {
+    dest[count] = (ExtremumPoint) { .position = position + k,
+                                    .value = values[k] };
+    count += (mask >> k) & 1;
+  }
+}
+
+#endif
+
+/// @brief Finds the extrema of data[1] ... data[size - 2].
+static void scan_peaks(int simd, const float *data, int isize,
+                       const PeakSelection *selection, PeakSink *sink) {
+  if (simd) {
+#ifdef PEAKS_VL
+    unsigned maxsel = (selection->type & kExtremumTypeMaximum) != 0? ~0u : 0;
+    unsigned minsel = (selection->type & kExtremumTypeMinimum) != 0? ~0u : 0;
+    float maxThreshold = selection->maximumThreshold;
+    float minThreshold = selection->minimumThreshold;
+    ExtremumPoint block[PEAKS_VL];
+    int i = 0;
+    for (; i + PEAKS_VL + 2 <= isize; i += PEAKS_VL) {
+      unsigned mask = peaks_mask(data + i, maxsel, minsel, maxThreshold,
+                                 minThreshold);
+      ExtremumPoint *dest = peaks_destination(sink, block, PEAKS_VL);
+      compact_peaks(dest, i + 1, data + i + 1, mask);
+      peaks_commit(sink, dest, __builtin_popcount(mask));
+    }
+    for (i++; i < isize - 1; i++) {
+      check_peak(data, i, selection, sink);
+    }
+  } else {
+#else
+  } {
+#endif
+    for (int i = 1; i < isize - 1; i++) {
+      check_peak(data, i, selection, sink);
     }
   }
 }
@@ -61,67 +459,599 @@ void detect_peaks(int simd, const float *data, size_t size, ExtremumType type,
   assert(results);
   assert(resultsLength);
   assert(size > 2);
-  *resultsLength = 0;
-  *results = NULL;
-  size_t allocated_size = 0;
+  PeakSink sink = { .points = NULL, .length = 0, .allocated = 0,
+                    .stream = NULL, .offset = 0 };
+  PeakSelection selection = peak_selection(type);
+  scan_peaks(simd, data, (int)size, &selection, &sink);
+  if (sink.length == 0) {
+    // The vectorized scan reserves the place in advance
+    free(sink.points);
+    sink.points = NULL;
+  }
+  *results = sink.points;
+  *resultsLength = sink.length;
+}
+
+/// @brief An extremum of one kind in detect_peaks_filtered().
+typedef struct {
+  int position;
+  float value;
+  /// The value multiplied by the sign of the kind, so that the minima are
+  /// handled as the maxima.
+  float height;
+  float leftBase;
+  float rightBase;
+  /// The index of the later candidate of the same height which has the
+  /// same right base, or -1. Such candidates do not bound each other.
+  int tie;
+  int kept;
+} PeakCandidate;
+
+/// @brief The candidates of one kind (maxima or minima) and the stack of
+/// those which have not found a higher one to the right yet.
+typedef struct {
+  float sign;
+  PeakCandidate *candidates;
+  size_t length;
+  size_t allocated;
+  /// The indices of the candidates with non-increasing heights.
+  int *stack;
+  /// The lowest height after each stacked candidate, see peak_kind_push().
+  float *runs;
+  size_t stackLength;
+  /// The lowest height since the beginning of the signal, if stack is empty.
+  float bottom;
+  /// The position of the last candidate.
+  int last;
+} PeakKind;
+
+/// @brief The element of the array which is sorted by key descending and
+/// by position ascending.
+typedef struct {
+  float key;
+  int position;
+  const PeakCandidate *candidate;
+} PeakOrder;
+
+static int peak_order_compare(const void *a, const void *b) {
+  const PeakOrder *pa = a, *pb = b;
+  if (pa->key != pb->key) {
+    return pa->key > pb->key? -1 : 1;
+  }
+  return pa->position - pb->position;
+}
+
+static int extremum_point_compare(const void *a, const void *b) {
+  return ((const ExtremumPoint *)a)->position -
+      ((const ExtremumPoint *)b)->position;
+}
+
+/// @brief The lowest of the heights of data[begin] ... data[end - 1].
+static float peak_gap(const float *data, int begin, int end, float sign) {
+  float gap = INFINITY;
+  for (int i = begin; i < end; i++) {
+    float height = sign * data[i];
+    if (height < gap) {
+      gap = height;
+    }
+  }
+  return gap;
+}
+
+/// @brief Merges the lowest height of the popped stack entry into the
+/// entry below it.
+INLINE void peak_kind_merge(PeakKind *kind, float run) {
+  float *below = kind->stackLength > 0?
+      &kind->runs[kind->stackLength - 1] : &kind->bottom;
+  if (run < *below) {
+    *below = run;
+  }
+}
+
+/// @brief Adds the next candidate of the kind. If prominence is set, the
+/// left bases are found with the stack, which is O(1) amortized, and the
+/// right ones of the candidates it pops.
+static void peak_kind_push(PeakKind *kind, const float *data, int position,
+                           float value, int prominence) {
+  if (kind->length == kind->allocated) {
+    kind->allocated = kind->allocated > 0? kind->allocated * 2 : 64;
+    kind->candidates = realloc(kind->candidates,
+                               kind->allocated * sizeof(kind->candidates[0]));
+    if (prominence) {
+      kind->stack = realloc(kind->stack,
+                            kind->allocated * sizeof(kind->stack[0]));
+      kind->runs = realloc(kind->runs,
+                           kind->allocated * sizeof(kind->runs[0]));
+    }
+  }
+  int index = kind->length++;
+  PeakCandidate *cand = &kind->candidates[index];
+  *cand = (PeakCandidate) { .position = position, .value = value,
+                            .height = kind->sign * value, .tie = -1,
+                            .kept = 1 };
+  if (!prominence) {
+    kind->last = position;
+    return;
+  }
+  // The samples between this candidate and the previous one are still
+  // in the cache
+  peak_kind_merge(kind, peak_gap(data, kind->last + 1, position, kind->sign));
+  while (kind->stackLength > 0) {
+    int top = kind->stack[kind->stackLength - 1];
+    PeakCandidate *other = &kind->candidates[top];
+    if (other->height > cand->height) {
+      break;
+    }
+    float run = kind->runs[--kind->stackLength];
+    other->rightBase = run;
+    if (other->height == cand->height) {
+      other->tie = index;
+    }
+    peak_kind_merge(kind, run);
+  }
+  cand->leftBase = kind->stackLength > 0?
+      kind->runs[kind->stackLength - 1] : kind->bottom;
+  kind->stack[kind->stackLength] = index;
+  kind->runs[kind->stackLength] = INFINITY;
+  kind->stackLength++;
+  kind->last = position;
+}
+
+/// @brief Resolves the right bases of the candidates left in the stack.
+static void peak_kind_finish(PeakKind *kind, const float *data, int size) {
+  peak_kind_merge(kind, peak_gap(data, kind->last + 1, size, kind->sign));
+  while (kind->stackLength > 0) {
+    int top = kind->stack[kind->stackLength - 1];
+    float run = kind->runs[--kind->stackLength];
+    kind->candidates[top].rightBase = run;
+    peak_kind_merge(kind, run);
+  }
+  for (int i = (int)kind->length - 1; i >= 0; i--) {
+    PeakCandidate *cand = &kind->candidates[i];
+    if (cand->tie >= 0 &&
+        kind->candidates[cand->tie].rightBase < cand->rightBase) {
+      cand->rightBase = kind->candidates[cand->tie].rightBase;
+    }
+  }
+}
+
+INLINE float peak_prominence(const PeakCandidate *cand) {
+  return cand->height - (cand->leftBase > cand->rightBase?
+                         cand->leftBase : cand->rightBase);
+}
+
+/// @brief Drops the candidates which are closer than distance to a more
+/// extreme one, starting from the most extreme.
+static void peak_kind_apply_distance(PeakKind *kind, int distance) {
+  if (distance < 2 || kind->length < 2) {
+    return;
+  }
+  PeakOrder *order = malloc_aligned(kind->length * sizeof(order[0]));
+  for (size_t i = 0; i < kind->length; i++) {
+    order[i] = (PeakOrder) { .key = kind->candidates[i].height,
+                             .position = kind->candidates[i].position,
+                             .candidate = &kind->candidates[i] };
+  }
+  qsort(order, kind->length, sizeof(order[0]), peak_order_compare);
+  for (size_t i = 0; i < kind->length; i++) {
+    int index = (int)(order[i].candidate - kind->candidates);
+    PeakCandidate *cand = &kind->candidates[index];
+    if (!cand->kept) {
+      continue;
+    }
+    for (int j = index - 1; j >= 0 &&
+         cand->position - kind->candidates[j].position < distance; j--) {
+      kind->candidates[j].kept = 0;
+    }
+    for (int j = index + 1; j < (int)kind->length &&
+         kind->candidates[j].position - cand->position < distance; j++) {
+      kind->candidates[j].kept = 0;
+    }
+  }
+  free_aligned(order);
+}
+
+void detect_peaks_filters_initialize(DetectPeaksFilters *filters) {
+  assert(filters);
+  filters->maximumThreshold = -INFINITY;
+  filters->minimumThreshold = INFINITY;
+  filters->distance = 0;
+  filters->prominence = 0;
+  filters->topK = 0;
+}
+
+void detect_peaks_filtered(int simd, const float *data, size_t size,
+                           ExtremumType type,
+                           const DetectPeaksFilters *filters,
+                           ExtremumPoint **results, size_t *resultsLength) {
+  assert(data);
+  assert(filters);
+  assert(results);
+  assert(resultsLength);
+  assert(size > 2);
+  assert(size <= INT_MAX);
   int isize = (int)size;
+  int prominence = filters->prominence > 0 || filters->topK > 0;
+  PeakSelection selection = {
+      .type = type, .maximumThreshold = filters->maximumThreshold,
+      .minimumThreshold = filters->minimumThreshold };
+  PeakKind kinds[2];
+  for (int k = 0; k < 2; k++) {
+    kinds[k] = (PeakKind) { .sign = k == 0? 1 : -1, .candidates = NULL,
+                            .length = 0, .allocated = 0, .stack = NULL,
+                            .runs = NULL, .stackLength = 0,
+                            .bottom = INFINITY, .last = -1 };
+  }
+  PeakSink sink = { .points = NULL, .length = 0, .allocated = 0,
+                    .stream = NULL, .offset = 0 };
+  // The signal is scanned chunk by chunk, so that the prominence stage
+  // reads the same samples while they are in the cache
+  for (int begin = 1; begin < isize - 1; begin += DETECT_PEAKS_CHUNK) {
+    int end = begin + DETECT_PEAKS_CHUNK;
+    if (end > isize - 1) {
+      end = isize - 1;
+    }
+    sink.length = 0;
+    scan_peaks(simd, data + begin - 1, end - begin + 2, &selection, &sink);
+    for (size_t i = 0; i < sink.length; i++) {
+      int position = sink.points[i].position + begin - 1;
+      float value = sink.points[i].value;
+      PeakKind *kind = &kinds[value > data[position - 1]? 0 : 1];
+      peak_kind_push(kind, data, position, value, prominence);
+    }
+  }
+  free(sink.points);
 
-  if (simd) {
-#ifdef __ARM_NEON__
-    for (int i = 0; i < isize - 4; i += 4) {
-      float32x4_t vec1 = vld1q_f32(data + i);
-      float32x4_t vec2 = vld1q_f32(data + i + 1);
-      float32x4_t max = vmaxq_f32(vec1, vec2);
-      uint32x4_t cmpvec1 = vceqq_f32(max, vec1);
-      uint32x4_t cmpvec2 = vceqq_f32(max, vec2);
-      uint64x2_t cmpvec1_64 = vpaddlq_u32(cmpvec1);
-      uint64x2_t cmpvec2_64 = vpaddlq_u32(cmpvec2);
-      if (vgetq_lane_u64(cmpvec1_64, 0) == 0x1FFFFFFFE &&
-          vgetq_lane_u64(cmpvec1_64, 1) == 0x1FFFFFFFE) {
-        continue;
-      }
-      if (vgetq_lane_u64(cmpvec2_64, 0) == 0x1FFFFFFFE &&
-          vgetq_lane_u64(cmpvec2_64, 1) == 0x1FFFFFFFE) {
-        check_peak(data, i + 4, type, results, resultsLength, &allocated_size);
-        continue;
+  size_t count = 0;
+  for (int k = 0; k < 2; k++) {
+    PeakKind *kind = &kinds[k];
+    if (prominence) {
+      peak_kind_finish(kind, data, isize);
+    }
+    peak_kind_apply_distance(kind, filters->distance);
+    for (size_t i = 0; i < kind->length; i++) {
+      PeakCandidate *cand = &kind->candidates[i];
+      if (cand->kept && filters->prominence > 0 &&
+          peak_prominence(cand) < filters->prominence) {
+        cand->kept = 0;
       }
-      for (int j = i + 1; j < i + 5; j++) {
-        check_peak(data, j, type, results, resultsLength, &allocated_size);
+      count += cand->kept;
+    }
+  }
+
+  PeakOrder *order = NULL;
+  if (count > 0) {
+    order = malloc_aligned(count * sizeof(order[0]));
+    count = 0;
+    for (int k = 0; k < 2; k++) {
+      for (size_t i = 0; i < kinds[k].length; i++) {
+        PeakCandidate *cand = &kinds[k].candidates[i];
+        if (cand->kept) {
+          order[count++] = (PeakOrder) {
+              .key = prominence? peak_prominence(cand) : 0,
+              .position = cand->position, .candidate = cand };
+        }
       }
     }
-    for (int i = (isize - 1) & ~0x3; i < isize - 1; i++) {
-      check_peak(data, i, type, results, resultsLength, &allocated_size);
+    if (filters->topK > 0 && count > filters->topK) {
+      qsort(order, count, sizeof(order[0]), peak_order_compare);
+      count = filters->topK;
     }
+  }
+  ExtremumPoint *points = NULL;
+  if (count > 0) {
+    points = malloc(count * sizeof(points[0]));
+    for (size_t i = 0; i < count; i++) {
+      const PeakCandidate *cand = order[i].candidate;
+      points[i] = (ExtremumPoint) { .position = cand->position,
+                                    .value = cand->value };
+    }
+    qsort(points, count, sizeof(points[0]), extremum_point_compare);
+  }
+  free_aligned(order);
+  for (int k = 0; k < 2; k++) {
+    free(kinds[k].candidates);
+    free(kinds[k].stack);
+    free(kinds[k].runs);
+  }
+  *results = points;
+  *resultsLength = count;
+}
+
+void detect_peaks_stream_initialize(DetectPeaksStream *stream,
+                                    ExtremumType type, ExtremumPoint *buffer,
+                                    size_t capacity) {
+  assert(stream);
+  assert(buffer || capacity == 0);
+  stream->type = type;
+  stream->points = buffer;
+  stream->capacity = capacity;
+  stream->first = 0;
+  stream->count = 0;
+  stream->lost = 0;
+  detect_peaks_stream_flush(stream);
+}
+
+void detect_peaks_stream_push(int simd, DetectPeaksStream *stream,
+                              const float *data, size_t length) {
+  assert(stream);
+  assert(data);
+  if (length == 0) {
+    return;
+  }
+  PeakSink sink = { .points = NULL, .length = 0, .allocated = 0,
+                    .stream = stream, .offset = 0 };
+  PeakSelection selection = peak_selection(stream->type);
+  // The samples at the border need the previous block
+  float border[4];
+  int known = stream->known;
+  for (int i = 0; i < known; i++) {
+    border[i] = stream->history[2 - known + i];
+  }
+  int borderSize = known;
+  for (size_t i = 0; i < length && borderSize < 4; i++) {
+    border[borderSize++] = data[i];
+  }
+  // Check the last sample of the previous block and the first one
+  // of this block, those which have both neighbours
+  sink.offset = stream->position - known;
+  for (int i = 1; i <= known && i < borderSize - 1; i++) {
+    check_peak(border, i, &selection, &sink);
+  }
+  if (length > 2) {
+    sink.offset = stream->position;
+    scan_peaks(simd, data, (int)length, &selection, &sink);
+  }
+  // Remember the last two samples
+  if (length >= 2) {
+    stream->history[0] = data[length - 2];
+    stream->history[1] = data[length - 1];
+    stream->known = 2;
   } else {
-#elif defined(__AVX__)
-    for (int i = 0; i < isize - 8; i += 8) {
-      __m256 vec1 = _mm256_loadu_ps(data + i);
-      __m256 vec2 = _mm256_loadu_ps(data + i + 1);
-      __m256 max = _mm256_max_ps(vec1, vec2);
-      __m256 cmpvec = _mm256_cmp_ps(max, vec1, _CMP_EQ_UQ);
-      int cmpres = _mm256_movemask_ps(cmpvec);
-      if (cmpres == 0xFF) {
-        continue;
-      }
-      cmpvec = _mm256_cmp_ps(max, vec2, _CMP_EQ_UQ);
-      cmpres = _mm256_movemask_ps(cmpvec);
-      if (cmpres == 0xFF) {
-        check_peak(data, i + 8, type, results, resultsLength, &allocated_size);
-        continue;
-      }
-      for (int j = i + 1; j < i + 9; j++) {
-        check_peak(data, j, type, results, resultsLength, &allocated_size);
-      }
+    stream->history[0] = stream->history[1];
+    stream->history[1] = data[0];
+    if (stream->known < 2) {
+      stream->known++;
     }
-    for (int i = (isize - 1) & ~0x7; i < isize - 1; i++) {
-      check_peak(data, i, type, results, resultsLength, &allocated_size);
+  }
+  stream->position += length;
+}
+
+size_t detect_peaks_stream_pop(DetectPeaksStream *stream, ExtremumPoint *dest,
+                               size_t maxCount) {
+  assert(stream);
+  assert(dest || maxCount == 0);
+  size_t count = stream->count < maxCount? stream->count : maxCount;
+  for (size_t i = 0; i < count; i++) {
+    dest[i] = stream->points[stream->first];
+    if (++stream->first == stream->capacity) {
+      stream->first = 0;
     }
+  }
+  stream->count -= count;
+  return count;
+}
+
+void detect_peaks_stream_flush(DetectPeaksStream *stream) {
+  assert(stream);
+  // The last sample has no right neighbour, so it is never an extremum
+  stream->known = 0;
+  stream->position = 0;
+}
+
+/// @brief Finds the minimum and the maximum of data[0] ... data[length - 1].
+static void block_minmax(int simd, const float *data, int length,
+                         float *min_ptr, float *max_ptr) {
+  float min = data[0], max = data[0];
+  int i = 0;
+  if (simd) {
+#ifdef __AVX512F__
+    __m512 min_vec = _mm512_set1_ps(min), max_vec = min_vec;
+    for (; i + 16 <= length; i += 16) {
+      __m512 vec = _mm512_loadu_ps(data + i);
+      min_vec = _mm512_min_ps(vec, min_vec);
+      max_vec = _mm512_max_ps(vec, max_vec);
+    }
+    min = _mm512_reduce_min_ps(min_vec);
+    max = _mm512_reduce_max_ps(max_vec);
+#elif defined(__SSE2__)
+    __m128 min1 = _mm_set1_ps(min), max1 = min1, min2 = min1, max2 = min1;
+    for (; i + 8 <= length; i += 8) {
+      __m128 vec1 = _mm_loadu_ps(data + i);
+      __m128 vec2 = _mm_loadu_ps(data + i + 4);
+      min1 = _mm_min_ps(vec1, min1);
+      max1 = _mm_max_ps(vec1, max1);
+      min2 = _mm_min_ps(vec2, min2);
+      max2 = _mm_max_ps(vec2, max2);
+    }
+    float min_arr[4], max_arr[4];
+    _mm_storeu_ps(min_arr, _mm_min_ps(min1, min2));
+    _mm_storeu_ps(max_arr, _mm_max_ps(max1, max2));
+    for (int k = 0; k < 4; k++) {
+      min = min_arr[k] < min? min_arr[k] : min;
+      max = max_arr[k] > max? max_arr[k] : max;
+    }
+#elif defined(__ARM_NEON__)
+    float32x4_t min_vec = vdupq_n_f32(min), max_vec = min_vec;
+    for (; i + 4 <= length; i += 4) {
+      float32x4_t vec = vld1q_f32(data + i);
+      min_vec = vminq_f32(vec, min_vec);
+      max_vec = vmaxq_f32(vec, max_vec);
+    }
+    float32x2_t min_half = vpmin_f32(vget_low_f32(min_vec),
+                                     vget_high_f32(min_vec));
+    float32x2_t max_half = vpmax_f32(vget_low_f32(max_vec),
+                                     vget_high_f32(max_vec));
+    min = vget_lane_f32(vpmin_f32(min_half, min_half), 0);
+    max = vget_lane_f32(vpmax_f32(max_half, max_half), 0);
+#endif
+  }
+  for (; i < length; i++) {
+    min = data[i] < min? data[i] : min;
+    max = data[i] > max? data[i] : max;
+  }
+  *min_ptr = min;
+  *max_ptr = max;
+}
+
+INLINE int first_equal(const float *data, int length, float value) {
+  int i = 0;
+  while (i < length - 1 && data[i] != value) {
+    i++;
+  }
+  return i;
+}
+
+void argminmax1D(int simd, const float *data, size_t size,
+                 ExtremumPoint *min, ExtremumPoint *max) {
+  assert(data);
+  assert(size > 0 && size <= INT_MAX);
+  ExtremumPoint best_min = { 0, data[0] }, best_max = { 0, data[0] };
+  // The chunk is scanned again only when it improves the extremum, and it
+  // is still in L1 then, so the memory is read once
+  for (size_t i = 0; i < size; i += DETECT_PEAKS_CHUNK) {
+    int length = size - i < DETECT_PEAKS_CHUNK? size - i : DETECT_PEAKS_CHUNK;
+    float chunk_min, chunk_max;
+    block_minmax(simd, data + i, length, &chunk_min, &chunk_max);
+    if (chunk_min < best_min.value) {
+      best_min.position = i + first_equal(data + i, length, chunk_min);
+      best_min.value = chunk_min;
+    }
+    if (chunk_max > best_max.value) {
+      best_max.position = i + first_equal(data + i, length, chunk_max);
+      best_max.value = chunk_max;
+    }
+  }
+  if (min) {
+    *min = best_min;
+  }
+  if (max) {
+    *max = best_max;
+  }
+}
+
+/// @brief The ordering of the top-K heap: a is worse than b if it is less
+/// extreme, or equally extreme and later.
+INLINE int topk_worse(const ExtremumPoint *a, const ExtremumPoint *b,
+                      float sign) {
+  float va = sign * a->value, vb = sign * b->value;
+  return va < vb || (va == vb && a->position > b->position);
+}
+
+/// @brief Restores the heap property of heap[k], the worst point is on top.
+static void topk_sift_down(ExtremumPoint *heap, size_t count, size_t k,
+                           float sign) {
+  for (;;) {
+    size_t worst = k, left = 2 * k + 1, right = left + 1;
+    if (left < count && topk_worse(heap + left, heap + worst, sign)) {
+      worst = left;
+    }
+    if (right < count && topk_worse(heap + right, heap + worst, sign)) {
+      worst = right;
+    }
+    if (worst == k) {
+      return;
+    }
+    ExtremumPoint tmp = heap[k];
+    heap[k] = heap[worst];
+    heap[worst] = tmp;
+    k = worst;
+  }
+}
+
+/// @brief Returns the bit mask of data[0] ... data[TOPK_VL - 1] which are
+/// more extreme than threshold.
+#ifdef __AVX512F__
+#define TOPK_VL 16
+INLINE unsigned topk_mask(const float *data, float threshold, int maximum) {
+  __m512 vec = _mm512_loadu_ps(data);
+  __m512 thr = _mm512_set1_ps(threshold);
+  return maximum? _mm512_cmp_ps_mask(vec, thr, _CMP_GT_OQ) :
+      _mm512_cmp_ps_mask(vec, thr, _CMP_LT_OQ);
+}
+#elif defined(__SSE2__)
+#define TOPK_VL 8
+INLINE unsigned topk_mask(const float *data, float threshold, int maximum) {
+  __m128 thr = _mm_set1_ps(threshold);
+  __m128 lo = _mm_loadu_ps(data), hi = _mm_loadu_ps(data + 4);
+  if (maximum) {
+    lo = _mm_cmpgt_ps(lo, thr);
+    hi = _mm_cmpgt_ps(hi, thr);
   } else {
-#else
-  } {
+    lo = _mm_cmplt_ps(lo, thr);
+    hi = _mm_cmplt_ps(hi, thr);
+  }
+  return _mm_movemask_ps(lo) | (_mm_movemask_ps(hi) << 4);
+}
+#elif defined(__ARM_NEON__)
+#define TOPK_VL 4
+INLINE unsigned topk_mask(const float *data, float threshold, int maximum) {
+  float32x4_t vec = vld1q_f32(data);
+  float32x4_t thr = vdupq_n_f32(threshold);
+  uint32x4_t cmp = maximum? vcgtq_f32(vec, thr) : vcltq_f32(vec, thr);
+  const uint32_t bits[4] = { 1, 2, 4, 8 };
+  uint32x4_t masked = vandq_u32(cmp, vld1q_u32(bits));
+  uint32x2_t sum = vpadd_u32(vget_low_u32(masked), vget_high_u32(masked));
+  return vget_lane_u32(vpadd_u32(sum, sum), 0);
+}
 #endif
-    for (int i = 1; i < isize - 1; i++) {
-      check_peak(data, i, type, results, resultsLength, &allocated_size);
+
+static int topk_compare_maximum(const void *a, const void *b) {
+  return topk_worse(a, b, 1) - topk_worse(b, a, 1);
+}
+
+static int topk_compare_minimum(const void *a, const void *b) {
+  return topk_worse(a, b, -1) - topk_worse(b, a, -1);
+}
+
+INLINE void topk_push(ExtremumPoint *heap, size_t k, int position,
+                      float value, float sign) {
+  ExtremumPoint point = { position, value };
+  if (topk_worse(heap, &point, sign)) {
+    heap[0] = point;
+    topk_sift_down(heap, k, 0, sign);
+  }
+}
+
+size_t topk1D(int simd, const float *data, size_t size, ExtremumType type,
+              size_t k, ExtremumPoint *results) {
+  assert(data);
+  assert(results);
+  assert(size <= INT_MAX);
+  assert(type == kExtremumTypeMaximum || type == kExtremumTypeMinimum);
+  int maximum = type == kExtremumTypeMaximum;
+  float sign = maximum? 1 : -1;
+  if (k > size) {
+    k = size;
+  }
+  if (k == 0) {
+    return 0;
+  }
+  for (size_t i = 0; i < k; i++) {
+    results[i] = (ExtremumPoint) { .position = i, .value = data[i] };
+  }
+  for (size_t i = k / 2; i-- > 0;) {
+    topk_sift_down(results, k, i, sign);
+  }
+  size_t i = k;
+  if (simd) {
+#ifdef TOPK_VL
+    // Only the values beyond the current K-th one leave the vector loop,
+    // which is rare after the first few blocks
+    for (; i + TOPK_VL <= size; i += TOPK_VL) {
+      unsigned mask = topk_mask(data + i, results[0].value, maximum);
+      while (mask) {
+        int lane = __builtin_ctz(mask);
+        topk_push(results, k, i + lane, data[i + lane], sign);
+        mask &= mask - 1;
+      }
     }
+#endif
+  }
+  for (; i < size; i++) {
+    topk_push(results, k, i, data[i], sign);
   }
+  qsort(results, k, sizeof(results[0]),
+        maximum? topk_compare_maximum : topk_compare_minimum);
+  return k;
 }
@@ -0,0 +1,217 @@
+/*! @file dispatch.c
+ *  @brief Runtime selection of the kernels built for several instruction sets.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#define LIBSIMD_IMPLEMENTATION
+#ifdef HAVE_CONFIG_H
+#include "src/config.h"
+#endif
+#include "inc/simd/cpu.h"
+#include <stdlib.h>
+#include <strings.h>
+#include <simd/biquad.h>
+#include <simd/convolve.h>
+#include <simd/convolve2d.h>
+#include <simd/correlate.h>
+#include <simd/detect_peaks.h>
+#include <simd/fft.h>
+#include <simd/fused.h>
+#include <simd/instruction_set.h>
+#include <simd/matrix.h>
+#include <simd/memory.h>
+#include <simd/normalize.h>
+#include <simd/resample.h>
+#include <simd/sliding.h>
+#include <simd/stft.h>
+#include <simd/wavelet.h>
+#include "src/dispatch.h"
+#include "src/fft_builtin.h"
+#include "src/profile_counters.h"
+
+typedef struct {
+#define SIMD_KERNEL(ret, name, params, args) ret (*name) params;
+#define SIMD_KERNEL_VOID(name, params, args) void (*name) params;
+#include "src/kernels.inc"
+#undef SIMD_KERNEL
+#undef SIMD_KERNEL_VOID
+} KernelTable;
+
+#ifdef SIMD_RUNTIME_DISPATCH
+
+#define KERNEL_TABLE_TIER generic
+#define KERNEL_TABLE kKernelsGeneric
+#include "src/kernel_table.inc"
+#define KERNEL_TABLE_TIER sse4
+#define KERNEL_TABLE kKernelsSSE4
+#include "src/kernel_table.inc"
+#ifdef HAVE_SIMD_TIER_AVX
+#define KERNEL_TABLE_TIER avx
+#define KERNEL_TABLE kKernelsAVX
+#include "src/kernel_table.inc"
+#endif
+#ifdef HAVE_SIMD_TIER_AVX2
+#define KERNEL_TABLE_TIER avx2
+#define KERNEL_TABLE kKernelsAVX2
+#include "src/kernel_table.inc"
+#endif
+#ifdef HAVE_SIMD_TIER_AVX512
+#define KERNEL_TABLE_TIER avx512
+#define KERNEL_TABLE kKernelsAVX512
+#include "src/kernel_table.inc"
+#endif
+
+#define LOWEST_INSTRUCTION_SET kInstructionSetNone
+#define LOWEST_KERNELS kKernelsGeneric
+
+/// @brief Returns the kernels of the specified tier or NULL if it was not
+/// built.
+static const KernelTable *kernel_table(InstructionSet isa) {
+  switch (isa) {
+#ifdef HAVE_SIMD_TIER_AVX512
+    case kInstructionSetAVX512:
+      return &kKernelsAVX512;
+#endif
+#ifdef HAVE_SIMD_TIER_AVX2
+    case kInstructionSetAVX2:
+      return &kKernelsAVX2;
+#endif
+#ifdef HAVE_SIMD_TIER_AVX
+    case kInstructionSetAVX:
+      return &kKernelsAVX;
+#endif
+    case kInstructionSetSSE4:
+      return &kKernelsSSE4;
+    case kInstructionSetNone:
+      return &kKernelsGeneric;
+    default:
+      return NULL;
+  }
+}
+
+#else
+
+#define KERNEL_TABLE_TIER native
+#define KERNEL_TABLE kKernelsNative
+#include "src/kernel_table.inc"
+
+/* The only tier is built with the global compiler flags */
+#if defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512VL__)
+#define LOWEST_INSTRUCTION_SET kInstructionSetAVX512
+#elif defined(__AVX2__)
+#define LOWEST_INSTRUCTION_SET kInstructionSetAVX2
+#elif defined(__AVX__) && !defined(SIMD_AVX_EMULATION)
+#define LOWEST_INSTRUCTION_SET kInstructionSetAVX
+#elif defined(__SSE4_1__)
+#define LOWEST_INSTRUCTION_SET kInstructionSetSSE4
+#elif defined(__aarch64__)
+#define LOWEST_INSTRUCTION_SET kInstructionSetAArch64
+#elif defined(__ARM_NEON__)
+#define LOWEST_INSTRUCTION_SET kInstructionSetNEON
+#else
+#define LOWEST_INSTRUCTION_SET kInstructionSetNone
+#endif
+#define LOWEST_KERNELS kKernelsNative
+
+static const KernelTable *kernel_table(InstructionSet isa) {
+  return isa == LOWEST_INSTRUCTION_SET? &kKernelsNative : NULL;
+}
+
+#endif  // SIMD_RUNTIME_DISPATCH
+
+/* The lowest tier is active until dispatch_initialize() runs, so the calls
+ * from the other constructors are safe. */
+static const KernelTable *active_kernels = &LOWEST_KERNELS;
+static InstructionSet active_instruction_set = LOWEST_INSTRUCTION_SET;
+
+InstructionSet simd_instruction_set(void) {
+  return active_instruction_set;
+}
+
+InstructionSet simd_set_instruction_set(InstructionSet isa) {
+  InstructionSet cpu = simd_cpu_instruction_set();
+  if (isa > cpu) {
+    isa = cpu;
+  }
+  const KernelTable *table = NULL;
+  for (; isa > LOWEST_INSTRUCTION_SET; isa--) {
+    table = kernel_table(isa);
+    if (table) {
+      break;
+    }
+  }
+  if (!table) {
+    isa = LOWEST_INSTRUCTION_SET;
+    table = &LOWEST_KERNELS;
+  }
+  active_kernels = table;
+  active_instruction_set = isa;
+  return isa;
+}
+
+static void __attribute__((constructor)) dispatch_initialize(void) {
+  InstructionSet isa = simd_cpu_instruction_set();
+  const char *limit = getenv(SIMD_INSTRUCTION_SET_ENV);
+  if (limit) {
+    for (InstructionSet i = kInstructionSetNone; i <= kInstructionSetAArch64;
+         i++) {
+      if (!strcasecmp(limit, simd_instruction_set_name(i))) {
+        if (i < isa) {
+          isa = i;
+        }
+        break;
+      }
+    }
+  }
+  simd_set_instruction_set(isa);
+}
+
+#define SIMD_KERNEL(ret, name, params, args) \
+    ret name params { \
+      return active_kernels->name args; \
+    }
+#define SIMD_KERNEL_VOID(name, params, args) \
+    void name params { \
+      active_kernels->name args; \
+    }
+#define SIMD_KERNEL_PROFILED(name, params, args, kernel, flops, bytes) \
+    void name params { \
+      if (__builtin_expect(!(profile_active & PROFILE_COUNTERS), 1)) { \
+        active_kernels->name args; \
+        return; \
+      } \
+      ProfileSample sample; \
+      profile_begin(&sample); \
+      active_kernels->name args; \
+      profile_end(&sample, kernel, flops, bytes); \
+    }
+#include "src/kernels.inc"
+#undef SIMD_KERNEL
+#undef SIMD_KERNEL_VOID
+#undef SIMD_KERNEL_PROFILED
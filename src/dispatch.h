@@ -0,0 +1,57 @@
+/*! @file dispatch.h
+ *  @brief Internal helpers for building the kernels once per instruction set.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#ifndef SRC_DISPATCH_H_
+#define SRC_DISPATCH_H_
+
+/* The sources listed in KERNEL_SOURCES (see Sources.make) are compiled
+ * once per instruction set tier with -DSIMD_TIER=<tier> and the matching
+ * -m flags, so the usual #ifdef __AVX__ / __AVX2__ / ... branches select
+ * the code for that tier. Each kernel source renames the public functions
+ * it defines before including the public header:
+ *
+ *   #define memsetf KERNEL(memsetf)
+ *
+ * so that every tier provides its own kernel_<tier>_memsetf() and the calls
+ * inside the tier stay direct. dispatch.c defines the public memsetf()
+ * which jumps to the tier chosen at load time. The list of the dispatched
+ * functions is src/kernels.inc.
+ */
+
+#ifndef SIMD_TIER
+/* Single tier build: the kernels are compiled with the global flags */
+#define SIMD_TIER native
+#endif
+
+#define KERNEL_NAME(tier, name) kernel_##tier##_##name
+#define KERNEL_EXPAND(tier, name) KERNEL_NAME(tier, name)
+#define KERNEL(name) KERNEL_EXPAND(SIMD_TIER, name)
+
+#endif  // SRC_DISPATCH_H_
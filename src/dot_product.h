@@ -0,0 +1,159 @@
+/*! @file dot_product.h
+ *  @brief Dot product building blocks shared by the kernels.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_DOT_PRODUCT_H_
+#define SRC_DOT_PRODUCT_H_
+
+#include <simd/attributes.h>
+#include <simd/instruction_set.h>
+
+#ifdef __AVX__
+
+/* Multiply-accumulate: a single FMA on AVX2 tier, mul + add otherwise */
+#ifdef __FMA__
+#define madd256(a, b, c) _mm256_fmadd_ps(a, b, c)
+#else
+#define madd256(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+#endif
+#ifdef __FMA__
+#define madd256d(a, b, c) _mm256_fmadd_pd(a, b, c)
+#else
+#define madd256d(a, b, c) _mm256_add_pd(_mm256_mul_pd(a, b), c)
+#endif
+
+/// @brief Sums all the elements of the vector.
+INLINE float hsum256(__m256 vec) {
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(vec),
+                          _mm256_extractf128_ps(vec, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return _mm_cvtss_f32(sum);
+}
+
+/// @brief Reverses the order of the elements of the vector.
+INLINE __m256 reverse256(__m256 vec) {
+#ifdef __AVX2__
+  return _mm256_permutevar8x32_ps(vec, _mm256_set_epi32(0, 1, 2, 3,
+                                                        4, 5, 6, 7));
+#else
+  vec = _mm256_permute2f128_ps(vec, vec, 1);
+  return _mm256_permute_ps(vec, 27);
+#endif
+}
+
+/// @brief Calculates sum(a[i] * b[i]), i = 0..length-1.
+/// @details Four independent accumulators hide the latency of the
+/// multiply-add chain.
+INLINE NOTNULL(1, 2) float dot_product256(const float *a, const float *b,
+                                          int length) {
+  __m256 accum1 = _mm256_setzero_ps(), accum2 = _mm256_setzero_ps();
+  __m256 accum3 = _mm256_setzero_ps(), accum4 = _mm256_setzero_ps();
+  int i = 0;
+#ifndef SIMD_AVX_EMULATION
+  // Emulated 256-bit registers are pairs, so unrolling only causes spills
+  for (; i < length - 31; i += 32) {
+    accum1 = madd256(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), accum1);
+    accum2 = madd256(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8),
+                     accum2);
+    accum3 = madd256(_mm256_loadu_ps(a + i + 16),
+                     _mm256_loadu_ps(b + i + 16), accum3);
+    accum4 = madd256(_mm256_loadu_ps(a + i + 24),
+                     _mm256_loadu_ps(b + i + 24), accum4);
+  }
+#endif
+  for (; i < length - 7; i += 8) {
+    accum1 = madd256(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), accum1);
+  }
+  accum1 = _mm256_add_ps(accum1, accum2);
+  accum3 = _mm256_add_ps(accum3, accum4);
+  float sum = hsum256(_mm256_add_ps(accum1, accum3));
+  for (; i < length; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+/// @brief Calculates sum(a[i] * b[-i]), i = 0..length-1.
+/// @details This is the inner loop of the linear convolution.
+INLINE NOTNULL(1, 2) float dot_product_reversed256(const float *a,
+                                                   const float *b,
+                                                   int length) {
+  __m256 accum1 = _mm256_setzero_ps(), accum2 = _mm256_setzero_ps();
+  __m256 accum3 = _mm256_setzero_ps(), accum4 = _mm256_setzero_ps();
+  int i = 0;
+#ifndef SIMD_AVX_EMULATION
+  for (; i < length - 31; i += 32) {
+    accum1 = madd256(_mm256_loadu_ps(a + i),
+                     reverse256(_mm256_loadu_ps(b - i - 7)), accum1);
+    accum2 = madd256(_mm256_loadu_ps(a + i + 8),
+                     reverse256(_mm256_loadu_ps(b - i - 15)), accum2);
+    accum3 = madd256(_mm256_loadu_ps(a + i + 16),
+                     reverse256(_mm256_loadu_ps(b - i - 23)), accum3);
+    accum4 = madd256(_mm256_loadu_ps(a + i + 24),
+                     reverse256(_mm256_loadu_ps(b - i - 31)), accum4);
+  }
+#endif
+  for (; i < length - 7; i += 8) {
+    accum1 = madd256(_mm256_loadu_ps(a + i),
+                     reverse256(_mm256_loadu_ps(b - i - 7)), accum1);
+  }
+  accum1 = _mm256_add_ps(accum1, accum2);
+  accum3 = _mm256_add_ps(accum3, accum4);
+  float sum = hsum256(_mm256_add_ps(accum1, accum3));
+  for (; i < length; i++) {
+    sum += a[i] * b[-i];
+  }
+  return sum;
+}
+
+#elif defined(__ARM_NEON__)
+
+/* Multiply-accumulate: a single FMA on AArch64, where vmlaq_f32 becomes
+ * a separate multiply and add */
+#ifdef __aarch64__
+#define madd128(a, b, c) vfmaq_f32(c, a, b)
+#else
+#define madd128(a, b, c) vmlaq_f32(c, a, b)
+#endif
+
+/// @brief Sums all the elements of the vector.
+INLINE float hsum128(float32x4_t vec) {
+#ifdef __aarch64__
+  return vaddvq_f32(vec);
+#else
+  float32x2_t sum = vadd_f32(vget_high_f32(vec), vget_low_f32(vec));
+  return vget_lane_f32(vpadd_f32(sum, sum), 0);
+#endif
+}
+
+#endif  // __AVX__
+
+#endif  // SRC_DOT_PRODUCT_H_
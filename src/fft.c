@@ -0,0 +1,238 @@
+/*! @file fft.c
+ *  @brief Planned real and complex FFT on top of FFTF or the built-in
+ *  implementation.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+/* posix_memalign() is not in C99 */
+#define _POSIX_C_SOURCE 200112L
+#define LIBSIMD_IMPLEMENTATION
+#include "inc/simd/fft.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#ifndef NO_FFTF
+#include <fftf/api.h>
+#endif
+#include "src/fft_builtin.h"
+
+#define FFT_PI 3.14159265358979323846
+
+struct FFTPlan {
+  FFTType type;
+  FFTDirection direction;
+  /// FFTF keeps the pointer to it.
+  int length;
+  int batch;
+  const float **inputs;
+  float **outputs;
+  /// The FFTF plan or NULL if the built-in one is used.
+  void *fftf;
+  FFTBuiltin builtin;
+};
+
+/// @brief The plans are cached by the convolution beyond the scope of any
+/// allocator installed with simd_set_allocator(), so they bypass it.
+static float *fft_allocate(size_t length) {
+  void *ptr;
+  if (posix_memalign(&ptr, 64, (length > 0? length : 1) * sizeof(float))
+      != 0) {
+    return NULL;
+  }
+  return ptr;
+}
+
+int fft_builtin_initialize(FFTBuiltin *builtin, int real, int sign,
+                           int length) {
+  assert(length > 0);
+  assert(sign == 1 || sign == -1);
+  if (real) {
+    if (length & 1) {
+      return 0;
+    }
+    length /= 2;
+  }
+  // Radix 4 goes first, so that the stride of the other passes allows
+  // vectorization
+  int stages = 0, n = length;
+  while (n % 4 == 0) {
+    builtin->radices[stages++] = 4;
+    n /= 4;
+  }
+  if (n % 2 == 0) {
+    builtin->radices[stages++] = 2;
+    n /= 2;
+  }
+  while (n % 3 == 0) {
+    builtin->radices[stages++] = 3;
+    n /= 3;
+  }
+  while (n % 5 == 0) {
+    builtin->radices[stages++] = 5;
+    n /= 5;
+  }
+  if (n != 1) {
+    return 0;
+  }
+  builtin->length = length;
+  builtin->real = real;
+  builtin->sign = sign;
+  builtin->stages = stages;
+
+  size_t twiddles = 0;
+  for (int i = 0, l = length; i < stages; l /= builtin->radices[i++]) {
+    twiddles += (builtin->radices[i] - 1) * (l / builtin->radices[i]);
+  }
+  builtin->twiddles = fft_allocate(2 * twiddles);
+  assert(builtin->twiddles);
+  float *w = builtin->twiddles;
+  for (int i = 0, l = length; i < stages; l /= builtin->radices[i++]) {
+    int radix = builtin->radices[i], m = l / radix;
+    for (int j = 1; j < radix; j++) {
+      for (int p = 0; p < m; p++) {
+        double angle = sign * 2 * FFT_PI * j * p / l;
+        *w++ = cos(angle);
+        *w++ = sin(angle);
+      }
+    }
+  }
+
+  builtin->real_twiddles = NULL;
+  if (real) {
+    builtin->real_twiddles = fft_allocate(2 * (length / 2 + 1));
+    assert(builtin->real_twiddles);
+    for (int k = 0; k <= length / 2; k++) {
+      double angle = sign * FFT_PI * k / length;
+      builtin->real_twiddles[2 * k] = cos(angle);
+      builtin->real_twiddles[2 * k + 1] = sin(angle);
+    }
+  }
+  builtin->scratch = fft_allocate(2 * length);
+  assert(builtin->scratch);
+  return 1;
+}
+
+void fft_builtin_finalize(FFTBuiltin *builtin) {
+  free(builtin->twiddles);
+  free(builtin->real_twiddles);
+  free(builtin->scratch);
+}
+
+FFTPlan *fft_initialize(FFTType type, FFTDirection direction, int length,
+                        const float *input, float *output, int flags) {
+  return fft_initialize_batch(type, direction, length, 1, &input, &output,
+                              flags);
+}
+
+FFTPlan *fft_initialize_batch(FFTType type, FFTDirection direction,
+                              int length, int batch,
+                              const float *const *inputs,
+                              float *const *outputs, int flags) {
+  assert(length > 0);
+  assert(batch > 0);
+  FFTPlan *plan = malloc(sizeof(FFTPlan));
+  assert(plan);
+  plan->type = type;
+  plan->direction = direction;
+  plan->length = length;
+  plan->batch = batch;
+  plan->inputs = malloc(batch * sizeof(plan->inputs[0]));
+  plan->outputs = malloc(batch * sizeof(plan->outputs[0]));
+  assert(plan->inputs && plan->outputs);
+  for (int i = 0; i < batch; i++) {
+    assert(inputs[i]);
+    assert(outputs[i]);
+    plan->inputs[i] = inputs[i];
+    plan->outputs[i] = outputs[i];
+  }
+  plan->fftf = NULL;
+#ifndef NO_FFTF
+  if (!(flags & kFFTFlagBuiltin)) {
+    FFTFType fftfType = type == kFFTTypeReal?
+        FFTF_TYPE_REAL : FFTF_TYPE_COMPLEX;
+    FFTFDirection fftfDirection = direction == kFFTDirectionForward?
+        FFTF_DIRECTION_FORWARD : FFTF_DIRECTION_BACKWARD;
+    if (batch == 1) {
+      plan->fftf = fftf_init(fftfType, fftfDirection, FFTF_DIMENSION_1D,
+                             &plan->length, FFTF_NO_OPTIONS,
+                             plan->inputs[0], plan->outputs[0]);
+    } else {
+      plan->fftf = fftf_init_batch(fftfType, fftfDirection,
+                                   FFTF_DIMENSION_1D, &plan->length,
+                                   FFTF_NO_OPTIONS, batch,
+                                   plan->inputs, plan->outputs);
+    }
+  }
+#else
+  (void)flags;
+#endif
+  if (plan->fftf == NULL &&
+      !fft_builtin_initialize(
+          &plan->builtin, type == kFFTTypeReal,
+          direction == kFFTDirectionForward? -1 : 1, length)) {
+    free(plan->inputs);
+    free(plan->outputs);
+    free(plan);
+    return NULL;
+  }
+  return plan;
+}
+
+void fft_execute(const FFTPlan *plan) {
+#ifndef NO_FFTF
+  if (plan->fftf) {
+    fftf_calc(plan->fftf);
+    return;
+  }
+#endif
+  for (int i = 0; i < plan->batch; i++) {
+    fft_builtin_execute(&plan->builtin, plan->inputs[i], plan->outputs[i]);
+  }
+}
+
+int fft_is_builtin(const FFTPlan *plan) {
+  return plan->fftf == NULL;
+}
+
+void fft_finalize(FFTPlan *plan) {
+  if (plan == NULL) {
+    return;
+  }
+#ifndef NO_FFTF
+  if (plan->fftf) {
+    fftf_destroy(plan->fftf);
+  } else
+#endif
+  {
+    fft_builtin_finalize(&plan->builtin);
+  }
+  free(plan->inputs);
+  free(plan->outputs);
+  free(plan);
+}
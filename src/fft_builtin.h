@@ -0,0 +1,87 @@
+/*! @file fft_builtin.h
+ *  @brief Internal mixed radix FFT which is used without FFTF.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_FFT_BUILTIN_H_
+#define SRC_FFT_BUILTIN_H_
+
+#include <simd/common.h>
+#include <simd/attributes.h>
+
+SIMD_API_BEGIN
+
+/// @brief The maximal number of the radix passes, 4^15 exceeds int.
+#define FFT_BUILTIN_MAX_STAGES 32
+
+/// @brief The precomputed tables of the Stockham autosort transform.
+/// @details The complex transform of length n is done in passes of radix
+/// 4, 2, 3 and 5. The pass with the current length l and stride s maps
+/// y[q + s * (r * p + j)] = w^(p j) sum_k x[q + s * (p + k * l / r)] ω^(j k),
+/// so the q loop is contiguous and is vectorized. The real transform of
+/// length 2 n packs the signal into n complex numbers and untangles
+/// the spectrum afterwards.
+typedef struct {
+  /// The length of the complex transform.
+  int length;
+  /// Nonzero for the real transform of 2 * length samples.
+  int real;
+  /// -1 for the forward transform and 1 for the backward one.
+  int sign;
+  int stages;
+  int radices[FFT_BUILTIN_MAX_STAGES];
+  /// The twiddles of each pass one after another, (r - 1) * l / r complex
+  /// numbers per pass, j-major.
+  float *twiddles;
+  /// exp(sign * pi * i * k / length), k <= length / 2, of the real
+  /// transform.
+  float *real_twiddles;
+  /// 2 * length float-s for the ping-pong passes.
+  float *scratch;
+} FFTBuiltin;
+
+/// @brief Fills the tables of the transform.
+/// @param real Nonzero for the real transform.
+/// @param sign -1 for the forward transform and 1 for the backward one.
+/// @param length The number of the samples, it must be even if real is set.
+/// @return Zero if the length is not supported, in which case nothing is
+/// allocated.
+int fft_builtin_initialize(FFTBuiltin *builtin, int real, int sign,
+                           int length) NOTNULL(1);
+
+void fft_builtin_finalize(FFTBuiltin *builtin) NOTNULL(1);
+
+/// @brief Transforms input to output, the layouts are those of FFTF.
+/// @details input may be the same as output.
+void fft_builtin_execute(const FFTBuiltin *builtin, const float *input,
+                         float *output) NOTNULL(1, 2, 3);
+
+SIMD_API_END
+
+#endif  // SRC_FFT_BUILTIN_H_
@@ -0,0 +1,155 @@
+/*! @file fft_plan_cache.c
+ *  @brief Process wide cache of the in-place real FFT plans of the
+ *  convolution.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+/* posix_memalign() is not in C99 */
+#define _POSIX_C_SOURCE 200112L
+#define LIBSIMD_IMPLEMENTATION
+#include "src/fft_plan_cache.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include "inc/simd/convolve.h"
+#include "inc/simd/memory.h"
+
+/// @brief The maximal number of the idle plans to keep, the released ones
+/// beyond it are destroyed.
+#define FFT_PLAN_CACHE_CAPACITY 64
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+/// The idle plans, the most recently released first.
+static FFTPlans *cache_head;
+static int cache_size;
+
+/// @brief The cached plans outlive any request scope, so their buffers
+/// bypass the allocator installed with simd_set_allocator().
+static float *fft_plans_allocate_buffer(int length) {
+  void *ptr;
+  if (posix_memalign(&ptr, 64, length * sizeof(float)) != 0) {
+    return NULL;
+  }
+  return ptr;
+}
+
+static FFTPlans *fft_plans_create(int length) {
+  FFTPlans *plans = malloc(sizeof(FFTPlans));
+  assert(plans);
+  plans->length = length;
+  plans->buffer = fft_plans_allocate_buffer(length + 2);
+  assert(plans->buffer);
+  plans->forward = fft_initialize(kFFTTypeReal, kFFTDirectionForward,
+                                  length, plans->buffer, plans->buffer, 0);
+  assert(plans->forward);
+  plans->backward = fft_initialize(kFFTTypeReal, kFFTDirectionBackward,
+                                   length, plans->buffer, plans->buffer, 0);
+  assert(plans->backward);
+  plans->next = NULL;
+  return plans;
+}
+
+static void fft_plans_destroy(FFTPlans *plans) {
+  fft_finalize(plans->forward);
+  fft_finalize(plans->backward);
+  free(plans->buffer);
+  free(plans);
+}
+
+/// @brief Tells whether the real transform of the length is supported by
+/// the built-in FFT, see fft_builtin_initialize().
+static inline int fft_plans_length_supported(int length) {
+  if (length < 2 || length % 2 != 0) {
+    return 0;
+  }
+  length /= 2;
+  static const int radices[] = { 2, 3, 5 };
+  for (int i = 0; i < 3; i++) {
+    while (length % radices[i] == 0) {
+      length /= radices[i];
+    }
+  }
+  return length == 1;
+}
+
+FFTPlans *fft_plans_acquire(int length) {
+  assert(fft_plans_length_supported(length));
+  pthread_mutex_lock(&cache_lock);
+  for (FFTPlans **link = &cache_head; *link != NULL;
+       link = &(*link)->next) {
+    FFTPlans *plans = *link;
+    if (plans->length == length) {
+      *link = plans->next;
+      cache_size--;
+      pthread_mutex_unlock(&cache_lock);
+      plans->next = NULL;
+      return plans;
+    }
+  }
+  pthread_mutex_unlock(&cache_lock);
+  // Planning may be slow, so it is done outside of the lock
+  return fft_plans_create(length);
+}
+
+void fft_plans_release(FFTPlans *plans) {
+  if (plans == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&cache_lock);
+  if (cache_size < FFT_PLAN_CACHE_CAPACITY) {
+    plans->next = cache_head;
+    cache_head = plans;
+    cache_size++;
+    plans = NULL;
+  }
+  pthread_mutex_unlock(&cache_lock);
+  if (plans != NULL) {
+    fft_plans_destroy(plans);
+  }
+}
+
+void convolve_plan_cache_clear(void) {
+  pthread_mutex_lock(&cache_lock);
+  FFTPlans *head = cache_head;
+  cache_head = NULL;
+  cache_size = 0;
+  pthread_mutex_unlock(&cache_lock);
+  while (head != NULL) {
+    FFTPlans *next = head->next;
+    fft_plans_destroy(head);
+    head = next;
+  }
+}
+
+int convolve_plan_cache_size(void) {
+  pthread_mutex_lock(&cache_lock);
+  int size = cache_size;
+  pthread_mutex_unlock(&cache_lock);
+  return size;
+}
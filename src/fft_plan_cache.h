@@ -0,0 +1,70 @@
+/*! @file fft_plan_cache.h
+ *  @brief Internal cache of the in-place real FFT plans of the convolution.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_FFT_PLAN_CACHE_H_
+#define SRC_FFT_PLAN_CACHE_H_
+
+#include <simd/common.h>
+#include <simd/fft.h>
+
+SIMD_API_BEGIN
+
+/// @brief The forward and the backward real FFT plans of the same length,
+/// both working in place on the buffer.
+/// @details The plans are bound to their buffer, so the buffer is cached
+/// together with them and the plans are used by one owner at a time.
+typedef struct FFTPlans {
+  /// The transform length, the handles keep the pointer to it.
+  int length;
+  /// length + 2 float-s, the spectrum takes them all.
+  float *buffer;
+  FFTPlan *forward;
+  FFTPlan *backward;
+  struct FFTPlans *next;
+} FFTPlans;
+
+/// @brief Takes the idle plans of the specified length from the cache,
+/// creating new ones if there are none.
+/// @param length The transform length. The built-in FFT cannot plan every
+/// length, so it must come from convolve_fft_good_length() or be a power of
+/// 2 greater than 1; the other ones fail the assertion here rather than
+/// only in the builds without FFTF.
+/// @details This function is thread safe.
+FFTPlans *fft_plans_acquire(int length);
+
+/// @brief Returns the plans obtained from fft_plans_acquire() to the cache,
+/// so that the next fft_plans_acquire() of the same length does not plan.
+/// @details This function is thread safe.
+void fft_plans_release(FFTPlans *plans);
+
+SIMD_API_END
+
+#endif  // SRC_FFT_PLAN_CACHE_H_
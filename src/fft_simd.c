@@ -0,0 +1,459 @@
+/*! @file fft_simd.c
+ *  @brief The passes of the built-in FFT and the power spectrum.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#define LIBSIMD_IMPLEMENTATION
+#include "src/dispatch.h"
+#define fft_power_spectrum KERNEL(fft_power_spectrum)
+#define fft_builtin_execute KERNEL(fft_builtin_execute)
+#include "inc/simd/fft.h"
+#include "src/fft_builtin.h"
+#include <string.h>
+#include <simd/instruction_set.h>
+
+/* cos(2 pi / 5), cos(4 pi / 5), sin(2 pi / 5), sin(4 pi / 5), sin(pi / 3) */
+#define FFT_C1 0.309016994374947424f
+#define FFT_C2 -0.809016994374947424f
+#define FFT_S1 0.951056516295153572f
+#define FFT_S2 0.587785252292473129f
+#define FFT_S3 0.866025403784438647f
+
+#define FFT_MAX_RADIX 5
+
+/* The butterflies are shared by the scalar and the vector passes: T is
+ * the type, op is the prefix of its operations, rotation is what op_rotate()
+ * needs to multiply by sign * i. */
+
+#define FFT_BUTTERFLY2(T, op, a, rotation) do { \
+  T d = op##_sub(a[0], a[1]); \
+  a[0] = op##_add(a[0], a[1]); \
+  a[1] = d; \
+} while (0)
+
+#define FFT_BUTTERFLY3(T, op, a, rotation) do { \
+  T s = op##_add(a[1], a[2]); \
+  T m = op##_sub(a[0], op##_scale(s, 0.5f)); \
+  T n = op##_rotate(op##_scale(op##_sub(a[1], a[2]), FFT_S3), rotation); \
+  a[0] = op##_add(a[0], s); \
+  a[1] = op##_add(m, n); \
+  a[2] = op##_sub(m, n); \
+} while (0)
+
+#define FFT_BUTTERFLY4(T, op, a, rotation) do { \
+  T s02 = op##_add(a[0], a[2]); \
+  T d02 = op##_sub(a[0], a[2]); \
+  T s13 = op##_add(a[1], a[3]); \
+  T d13 = op##_rotate(op##_sub(a[1], a[3]), rotation); \
+  a[0] = op##_add(s02, s13); \
+  a[1] = op##_add(d02, d13); \
+  a[2] = op##_sub(s02, s13); \
+  a[3] = op##_sub(d02, d13); \
+} while (0)
+
+#define FFT_BUTTERFLY5(T, op, a, rotation) do { \
+  T s14 = op##_add(a[1], a[4]); \
+  T s23 = op##_add(a[2], a[3]); \
+  T d14 = op##_sub(a[1], a[4]); \
+  T d23 = op##_sub(a[2], a[3]); \
+  T m1 = op##_add(a[0], op##_add(op##_scale(s14, FFT_C1), \
+                                 op##_scale(s23, FFT_C2))); \
+  T m2 = op##_add(a[0], op##_add(op##_scale(s14, FFT_C2), \
+                                 op##_scale(s23, FFT_C1))); \
+  T n1 = op##_rotate(op##_add(op##_scale(d14, FFT_S1), \
+                              op##_scale(d23, FFT_S2)), rotation); \
+  T n2 = op##_rotate(op##_sub(op##_scale(d14, FFT_S2), \
+                              op##_scale(d23, FFT_S1)), rotation); \
+  a[0] = op##_add(a[0], op##_add(s14, s23)); \
+  a[1] = op##_add(m1, n1); \
+  a[4] = op##_sub(m1, n1); \
+  a[2] = op##_add(m2, n2); \
+  a[3] = op##_sub(m2, n2); \
+} while (0)
+
+/// @brief Expands to the butterfly of the radix, which is a constant after
+/// inlining.
+#define FFT_BUTTERFLY(radix, T, op, a, rotation) do { \
+  switch (radix) { \
+    case 2: FFT_BUTTERFLY2(T, op, a, rotation); break; \
+    case 3: FFT_BUTTERFLY3(T, op, a, rotation); break; \
+    case 4: FFT_BUTTERFLY4(T, op, a, rotation); break; \
+    case 5: FFT_BUTTERFLY5(T, op, a, rotation); break; \
+  } \
+} while (0)
+
+typedef struct {
+  float re;
+  float im;
+} FFTComplex;
+
+INLINE FFTComplex cpx_load(const float *ptr) {
+  FFTComplex c = { ptr[0], ptr[1] };
+  return c;
+}
+
+INLINE void cpx_store(float *ptr, FFTComplex c) {
+  ptr[0] = c.re;
+  ptr[1] = c.im;
+}
+
+INLINE FFTComplex cpx_add(FFTComplex a, FFTComplex b) {
+  FFTComplex c = { a.re + b.re, a.im + b.im };
+  return c;
+}
+
+INLINE FFTComplex cpx_sub(FFTComplex a, FFTComplex b) {
+  FFTComplex c = { a.re - b.re, a.im - b.im };
+  return c;
+}
+
+INLINE FFTComplex cpx_scale(FFTComplex a, float value) {
+  FFTComplex c = { a.re * value, a.im * value };
+  return c;
+}
+
+/// @brief Multiplies by sign * i.
+INLINE FFTComplex cpx_rotate(FFTComplex a, float sign) {
+  FFTComplex c = { -sign * a.im, sign * a.re };
+  return c;
+}
+
+/// @brief Multiplies by the complex number at w.
+INLINE FFTComplex cpx_twiddle(FFTComplex a, const float *w) {
+  FFTComplex c = { a.re * w[0] - a.im * w[1], a.re * w[1] + a.im * w[0] };
+  return c;
+}
+
+#ifdef __AVX__
+
+/// The number of the complex numbers in FFTVector.
+#define FFT_VECTOR 4
+typedef __m256 FFTVector;
+
+#define vec_load _mm256_loadu_ps
+#define vec_store _mm256_storeu_ps
+#define vec_add _mm256_add_ps
+#define vec_sub _mm256_sub_ps
+
+INLINE FFTVector vec_scale(FFTVector a, float value) {
+  return _mm256_mul_ps(a, _mm256_set1_ps(value));
+}
+
+/// @brief Returns the multiplier of vec_rotate() by sign * i.
+INLINE FFTVector vec_rotation(float sign) {
+  return _mm256_setr_ps(-sign, sign, -sign, sign, -sign, sign, -sign, sign);
+}
+
+INLINE FFTVector vec_rotate(FFTVector a, FFTVector rotation) {
+  return _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0xB1), rotation);
+}
+
+/// @brief Multiplies all the numbers by the complex number at w.
+INLINE FFTVector vec_twiddle(FFTVector a, const float *w) {
+  FFTVector im = _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0xB1),
+                               _mm256_set1_ps(w[1]));
+#ifdef __FMA__
+  return _mm256_fmaddsub_ps(a, _mm256_set1_ps(w[0]), im);
+#else
+  return _mm256_addsub_ps(_mm256_mul_ps(a, _mm256_set1_ps(w[0])), im);
+#endif
+}
+
+/// @brief Multiplies the numbers lane by lane.
+INLINE FFTVector vec_multiply(FFTVector a, FFTVector w) {
+  FFTVector im = _mm256_mul_ps(_mm256_movehdup_ps(a),
+                               _mm256_shuffle_ps(w, w, 0xB1));
+#ifdef __FMA__
+  return _mm256_fmaddsub_ps(_mm256_moveldup_ps(a), w, im);
+#else
+  return _mm256_addsub_ps(_mm256_mul_ps(_mm256_moveldup_ps(a), w), im);
+#endif
+}
+
+#elif defined(__ARM_NEON__)
+
+#define FFT_VECTOR 2
+typedef float32x4_t FFTVector;
+
+#define vec_load vld1q_f32
+#define vec_store vst1q_f32
+#define vec_add vaddq_f32
+#define vec_sub vsubq_f32
+#define vec_scale vmulq_n_f32
+
+INLINE FFTVector vec_rotation(float sign) {
+  FFTVector rotation = { -sign, sign, -sign, sign };
+  return rotation;
+}
+
+INLINE FFTVector vec_rotate(FFTVector a, FFTVector rotation) {
+  return vmulq_f32(vrev64q_f32(a), rotation);
+}
+
+INLINE FFTVector vec_twiddle(FFTVector a, const float *w) {
+  FFTVector im = { -w[1], w[1], -w[1], w[1] };
+  return vmlaq_n_f32(vmulq_f32(vrev64q_f32(a), im), a, w[0]);
+}
+
+#endif
+
+/// @brief The pass of the Stockham autosort transform, starting from p.
+/// @param l The current length.
+/// @param s The stride, the product of the previous radices.
+/// @param w The twiddles of the pass.
+INLINE void fft_pass(int radix, int l, int s, int p, float sign,
+                            const float *w, const float *x, float *y) {
+  int m = l / radix;
+#ifdef FFT_VECTOR
+  FFTVector rotation = vec_rotation(sign);
+#endif
+  for (; p < m; p++) {
+    int q = 0;
+#ifdef FFT_VECTOR
+    for (; q + FFT_VECTOR <= s; q += FFT_VECTOR) {
+      FFTVector a[FFT_MAX_RADIX];
+      for (int k = 0; k < radix; k++) {
+        a[k] = vec_load(x + 2 * (q + s * (p + k * m)));
+      }
+      FFT_BUTTERFLY(radix, FFTVector, vec, a, rotation);
+      vec_store(y + 2 * (q + s * radix * p), a[0]);
+      for (int j = 1; j < radix; j++) {
+        if (p > 0) {
+          a[j] = vec_twiddle(a[j], w + 2 * ((j - 1) * m + p));
+        }
+        vec_store(y + 2 * (q + s * (radix * p + j)), a[j]);
+      }
+    }
+#endif
+    for (; q < s; q++) {
+      FFTComplex a[FFT_MAX_RADIX];
+      for (int k = 0; k < radix; k++) {
+        a[k] = cpx_load(x + 2 * (q + s * (p + k * m)));
+      }
+      FFT_BUTTERFLY(radix, FFTComplex, cpx, a, sign);
+      cpx_store(y + 2 * (q + s * radix * p), a[0]);
+      for (int j = 1; j < radix; j++) {
+        if (p > 0) {
+          a[j] = cpx_twiddle(a[j], w + 2 * ((j - 1) * m + p));
+        }
+        cpx_store(y + 2 * (q + s * (radix * p + j)), a[j]);
+      }
+    }
+  }
+}
+
+#ifdef __AVX__
+
+/// @brief The first radix 4 pass has the stride of 1, so 4 consecutive p
+/// are vectorized instead of q and the results are transposed.
+/// @return The number of p done.
+static int fft_pass4_transposed(int l, float sign, const float *w,
+                                const float *x, float *y) {
+  int m = l / 4;
+  FFTVector rotation = vec_rotation(sign);
+  int p = 0;
+  for (; p + FFT_VECTOR <= m; p += FFT_VECTOR) {
+    FFTVector a[4];
+    for (int k = 0; k < 4; k++) {
+      a[k] = vec_load(x + 2 * (p + k * m));
+    }
+    FFT_BUTTERFLY4(FFTVector, vec, a, rotation);
+    for (int j = 1; j < 4; j++) {
+      a[j] = vec_multiply(a[j], vec_load(w + 2 * ((j - 1) * m + p)));
+    }
+    __m256d t0 = _mm256_unpacklo_pd(_mm256_castps_pd(a[0]),
+                                    _mm256_castps_pd(a[1]));
+    __m256d t1 = _mm256_unpackhi_pd(_mm256_castps_pd(a[0]),
+                                    _mm256_castps_pd(a[1]));
+    __m256d t2 = _mm256_unpacklo_pd(_mm256_castps_pd(a[2]),
+                                    _mm256_castps_pd(a[3]));
+    __m256d t3 = _mm256_unpackhi_pd(_mm256_castps_pd(a[2]),
+                                    _mm256_castps_pd(a[3]));
+    float *out = y + 8 * p;
+    vec_store(out, _mm256_castpd_ps(_mm256_permute2f128_pd(t0, t2, 0x20)));
+    vec_store(out + 8,
+              _mm256_castpd_ps(_mm256_permute2f128_pd(t1, t3, 0x20)));
+    vec_store(out + 16,
+              _mm256_castpd_ps(_mm256_permute2f128_pd(t0, t2, 0x31)));
+    vec_store(out + 24,
+              _mm256_castpd_ps(_mm256_permute2f128_pd(t1, t3, 0x31)));
+  }
+  return p;
+}
+
+#endif
+
+static void fft_builtin_pass(int radix, int l, int s, float sign,
+                             const float *w, const float *x, float *y) {
+  int p = 0;
+#ifdef __AVX__
+  if (radix == 4 && s == 1) {
+    p = fft_pass4_transposed(l, sign, w, x, y);
+  }
+#endif
+  switch (radix) {
+    case 2:
+      fft_pass(2, l, s, p, sign, w, x, y);
+      break;
+    case 3:
+      fft_pass(3, l, s, p, sign, w, x, y);
+      break;
+    case 4:
+      fft_pass(4, l, s, p, sign, w, x, y);
+      break;
+    case 5:
+      fft_pass(5, l, s, p, sign, w, x, y);
+      break;
+  }
+}
+
+/// @brief The complex transform of builtin->length numbers.
+static void fft_builtin_complex(const FFTBuiltin *builtin,
+                                const float *input, float *output) {
+  int stages = builtin->stages;
+  size_t size = 2 * builtin->length * sizeof(float);
+  if (stages == 0) {
+    if (input != output) {
+      memcpy(output, input, size);
+    }
+    return;
+  }
+  // The passes alternate between the scratch and the output, so that
+  // the last one writes the output
+  const float *x = input;
+  if (input == output && (stages & 1)) {
+    memcpy(builtin->scratch, input, size);
+    x = builtin->scratch;
+  }
+  const float *w = builtin->twiddles;
+  for (int i = 0, l = builtin->length, s = 1; i < stages; i++) {
+    int radix = builtin->radices[i];
+    float *y = ((stages - 1 - i) & 1)? builtin->scratch : output;
+    fft_builtin_pass(radix, l, s, builtin->sign, w, x, y);
+    w += 2 * (radix - 1) * (l / radix);
+    x = y;
+    l /= radix;
+    s *= radix;
+  }
+}
+
+/// @brief Untangles the spectrum of the even and the odd samples packed
+/// into the complex transform: X[k] = E[k] + W^k O[k], where
+/// E[k] = (Z[k] + Z*[n - k]) / 2 and O[k] = (Z[k] - Z*[n - k]) / 2i.
+static void fft_builtin_real_forward(const FFTBuiltin *builtin,
+                                     float *spectrum) {
+  int n = builtin->length;
+  const float *t = builtin->real_twiddles;
+  float zr = spectrum[0], zi = spectrum[1];
+  spectrum[0] = zr + zi;
+  spectrum[1] = 0;
+  spectrum[2 * n] = zr - zi;
+  spectrum[2 * n + 1] = 0;
+  for (int k = 1; k <= n / 2; k++) {
+    float *a = spectrum + 2 * k, *b = spectrum + 2 * (n - k);
+    float ere = 0.5f * (a[0] + b[0]), eim = 0.5f * (a[1] - b[1]);
+    float ore = 0.5f * (a[1] + b[1]), oim = -0.5f * (a[0] - b[0]);
+    float yr = ore * t[2 * k] - oim * t[2 * k + 1];
+    float yi = ore * t[2 * k + 1] + oim * t[2 * k];
+    // X[n - k] = (E[k] - W^k O[k])*
+    b[0] = ere - yr;
+    b[1] = yi - eim;
+    a[0] = ere + yr;
+    a[1] = eim + yi;
+  }
+}
+
+/// @brief Packs the spectrum of the real signal into the one of the even
+/// and the odd samples: Z[k] = E[k] + i O[k], the inverse of
+/// fft_builtin_real_forward() multiplied by 2.
+static void fft_builtin_real_backward(const FFTBuiltin *builtin,
+                                      const float *spectrum, float *packed) {
+  int n = builtin->length;
+  const float *t = builtin->real_twiddles;
+  float x0 = spectrum[0], xn = spectrum[2 * n];
+  for (int k = 1; k <= n / 2; k++) {
+    const float *a = spectrum + 2 * k, *b = spectrum + 2 * (n - k);
+    float ere = a[0] + b[0], eim = a[1] - b[1];
+    float dr = a[0] - b[0], di = a[1] + b[1];
+    float ore = dr * t[2 * k] - di * t[2 * k + 1];
+    float oim = dr * t[2 * k + 1] + di * t[2 * k];
+    float zr = ere - oim, zi = eim + ore;
+    // Z[n - k] = E*[k] + i O*[k]
+    packed[2 * (n - k)] = ere + oim;
+    packed[2 * (n - k) + 1] = ore - eim;
+    packed[2 * k] = zr;
+    packed[2 * k + 1] = zi;
+  }
+  packed[0] = x0 + xn;
+  packed[1] = x0 - xn;
+}
+
+void fft_builtin_execute(const FFTBuiltin *builtin, const float *input,
+                         float *output) {
+  if (!builtin->real) {
+    fft_builtin_complex(builtin, input, output);
+  } else if (builtin->sign < 0) {
+    fft_builtin_complex(builtin, input, output);
+    fft_builtin_real_forward(builtin, output);
+  } else {
+    fft_builtin_real_backward(builtin, input, output);
+    fft_builtin_complex(builtin, output, output);
+  }
+}
+
+void fft_power_spectrum(int simd, const float *spectrum, size_t length,
+                        float *result) {
+  size_t i = 0;
+  if (simd) {
+#ifdef __AVX__
+    for (; i + 8 <= length; i += 8) {
+      __m256 a = _mm256_loadu_ps(spectrum + 2 * i);
+      __m256 b = _mm256_loadu_ps(spectrum + 2 * i + 8);
+      // p0 p1 p4 p5 | p2 p3 p6 p7
+      __m256 sums = _mm256_hadd_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b));
+      __m128 lo = _mm256_castps256_ps128(sums);
+      __m128 hi = _mm256_extractf128_ps(sums, 1);
+      _mm_storeu_ps(result + i,
+                    _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(1, 0, 1, 0)));
+      _mm_storeu_ps(result + i + 4,
+                    _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 2, 3, 2)));
+    }
+#elif defined(__ARM_NEON__)
+    for (; i + 4 <= length; i += 4) {
+      float32x4x2_t c = vld2q_f32(spectrum + 2 * i);
+      vst1q_f32(result + i, vmlaq_f32(vmulq_f32(c.val[0], c.val[0]),
+                                      c.val[1], c.val[1]));
+    }
+#endif
+  }
+  for (; i < length; i++) {
+    float re = spectrum[2 * i], im = spectrum[2 * i + 1];
+    result[i] = re * re + im * im;
+  }
+}
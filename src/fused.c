@@ -0,0 +1,189 @@
+/*! @file fused.c
+ *  @brief Fused element-wise evaluation of the chains of array operations.
+ *  @author Vadim Markovtsev <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#define LIBSIMD_IMPLEMENTATION
+#include "src/dispatch.h"
+#define fused_apply KERNEL(fused_apply)
+#include "inc/simd/fused.h"
+#include <assert.h>
+#include <string.h>
+#include <simd/arithmetic.h>
+#include <simd/instruction_set.h>
+#include <simd/mathfun.h>
+
+#if defined(__AVX512F__)
+#define FUSED_STEP 16
+#define fused_vec __m512
+#define fused_load _mm512_loadu_ps
+#define fused_store _mm512_storeu_ps
+#define fused_set1 _mm512_set1_ps
+#define fused_add _mm512_add_ps
+#define fused_mul _mm512_mul_ps
+#define fused_min _mm512_min_ps
+#define fused_max _mm512_max_ps
+#elif defined(__AVX__)
+#define FUSED_STEP 8
+#define fused_vec __m256
+#define fused_load _mm256_loadu_ps
+#define fused_store _mm256_storeu_ps
+#define fused_set1 _mm256_set1_ps
+#define fused_add _mm256_add_ps
+#define fused_mul _mm256_mul_ps
+#define fused_min _mm256_min_ps
+#define fused_max _mm256_max_ps
+#elif defined(__ARM_NEON__)
+#define FUSED_STEP 4
+#define fused_vec float32x4_t
+#define fused_load vld1q_f32
+#define fused_store vst1q_f32
+#define fused_set1 vdupq_n_f32
+#define fused_add vaddq_f32
+#define fused_mul vmulq_f32
+#define fused_min vminq_f32
+#define fused_max vmaxq_f32
+#endif
+
+/* out[j] = expr of x = in[j]; vexpr is the vector version of sexpr */
+#ifdef FUSED_STEP
+#define FUSED_MAP(in, length, out, vexpr, sexpr) do { \
+  size_t j = 0; \
+  for (; j + FUSED_STEP <= (length); j += FUSED_STEP) { \
+    fused_vec x = fused_load((in) + j); \
+    fused_store((out) + j, vexpr); \
+  } \
+  for (; j < (length); j++) { \
+    float x = (in)[j]; \
+    (out)[j] = sexpr; \
+  } \
+} while (0)
+#else
+#define FUSED_MAP(in, length, out, vexpr, sexpr) do { \
+  for (size_t j = 0; j < (length); j++) { \
+    float x = (in)[j]; \
+    (out)[j] = sexpr; \
+  } \
+} while (0)
+#endif
+
+/* Applies op to length elements starting from offset. */
+static void fused_apply_op(const FusedOp *op, const float *src, size_t offset,
+                           size_t length, float *res) {
+  const float scalar = op->scalar;
+  const float *array = op->array? op->array + offset : NULL;
+#ifdef FUSED_STEP
+  const fused_vec scalar_vec = fused_set1(scalar);
+#endif
+  switch (op->type) {
+    case kFusedOpAddScalar:
+      FUSED_MAP(src, length, res, fused_add(x, scalar_vec), x + scalar);
+      break;
+    case kFusedOpMultiplyScalar:
+      FUSED_MAP(src, length, res, fused_mul(x, scalar_vec), x * scalar);
+      break;
+    case kFusedOpMinScalar:
+      FUSED_MAP(src, length, res, fused_min(x, scalar_vec),
+                x < scalar? x : scalar);
+      break;
+    case kFusedOpMaxScalar:
+      FUSED_MAP(src, length, res, fused_max(x, scalar_vec),
+                x > scalar? x : scalar);
+      break;
+    case kFusedOpAddArray:
+      FUSED_MAP(src, length, res, fused_add(x, fused_load(array + j)),
+                x + array[j]);
+      break;
+    case kFusedOpMultiplyArray:
+      real_multiply_array(src, array, length, res);
+      break;
+    case kFusedOpMultiplyArrayAddScalar:
+      FUSED_MAP(src, length, res,
+                fused_add(fused_mul(x, fused_load(array + j)), scalar_vec),
+                x * array[j] + scalar);
+      break;
+    case kFusedOpComplexMultiplyArray:
+      complex_multiply_array(src, array, length, res);
+      break;
+    case kFusedOpExp:
+      exp_psv(1, src, length, res);
+      break;
+    case kFusedOpLog:
+      log_psv(1, src, length, res);
+      break;
+    case kFusedOpSin:
+      sin_psv(1, src, length, res);
+      break;
+    case kFusedOpCos:
+      cos_psv(1, src, length, res);
+      break;
+    case kFusedOpTanh:
+      tanh_psv(1, src, length, res);
+      break;
+    case kFusedOpSigmoid:
+      sigmoid_psv(1, src, length, res);
+      break;
+    case kFusedOpPow:
+      pow_psv(1, src, length, scalar, res);
+      break;
+    default:
+      assert(0 && "Unknown FusedOpType");
+      break;
+  }
+}
+
+void fused_apply(const float *src, size_t length, const FusedOp *ops,
+                 int ops_count, float *res) {
+  assert(ops_count >= 0);
+  assert(ops_count == 0 || ops);
+  if (ops_count == 0) {
+    if (res != src) {
+      memcpy(res, src, length * sizeof(float));
+    }
+    return;
+  }
+  for (int k = 0; k < ops_count; k++) {
+    assert(ops[k].array || (ops[k].type != kFusedOpAddArray &&
+                            ops[k].type != kFusedOpMultiplyArray &&
+                            ops[k].type != kFusedOpMultiplyArrayAddScalar &&
+                            ops[k].type != kFusedOpComplexMultiplyArray));
+    assert(length % 2 == 0 || ops[k].type != kFusedOpComplexMultiplyArray);
+  }
+  for (size_t i = 0; i < length; i += FUSED_BLOCK_LENGTH) {
+    size_t block = length - i < FUSED_BLOCK_LENGTH?
+        length - i : FUSED_BLOCK_LENGTH;
+    /* the first operation reads src, the rest work in place in L1 */
+    fused_apply_op(&ops[0], src + i, i, block, res + i);
+    for (int k = 1; k < ops_count; k++) {
+      fused_apply_op(&ops[k], res + i, i, block, res + i);
+    }
+  }
+}
@@ -0,0 +1,446 @@
+/*! @file gemm.c
+ *  @brief Blocked single precision matrix multiplication.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#define LIBSIMD_IMPLEMENTATION
+#include "src/gemm.h"
+#include <stdlib.h>
+#include <simd/instruction_set.h>
+#include <simd/mathfun.h>
+#include "inc/simd/memory.h"
+#include "src/dot_product.h"
+#include "src/transpose.h"
+
+#if defined(__AVX__) || defined(__ARM_NEON__)
+
+/* The micro kernel keeps a GEMM_MR x GEMM_NR block of C in registers:
+ * GEMM_MR rows of GEMM_NV vectors each. */
+#if defined(__AVX512F__)
+
+#define GEMM_MR 6
+#define GEMM_NV 2
+#define GEMM_VL 16
+typedef __m512 gemm_vec;
+#define gemm_load(ptr) _mm512_load_ps(ptr)
+#define gemm_loadu(ptr) _mm512_loadu_ps(ptr)
+#define gemm_storeu(ptr, vec) _mm512_storeu_ps(ptr, vec)
+#define gemm_set1(value) _mm512_set1_ps(value)
+#define gemm_zero() _mm512_setzero_ps()
+#define gemm_madd(a, b, c) _mm512_fmadd_ps(a, b, c)
+#define gemm_add(a, b) _mm512_add_ps(a, b)
+#define gemm_max(a, b) _mm512_max_ps(a, b)
+#define gemm_sigmoid(x) sigmoid512_ps(x)
+#define gemm_tanh(x) tanh512_ps(x)
+#define gemm_sigmoid_fast(x) sigmoid512_fast_ps(x)
+#define gemm_tanh_fast(x) tanh512_fast_ps(x)
+
+#elif defined(__AVX__)
+
+#ifdef SIMD_AVX_EMULATION
+/* Every emulated register is a pair of SSE ones, only 16 are available */
+#define GEMM_MR 4
+#define GEMM_NV 1
+#else
+#define GEMM_MR 6
+#define GEMM_NV 2
+#endif
+#define GEMM_VL 8
+typedef __m256 gemm_vec;
+#define gemm_load(ptr) _mm256_load_ps(ptr)
+#define gemm_loadu(ptr) _mm256_loadu_ps(ptr)
+#define gemm_storeu(ptr, vec) _mm256_storeu_ps(ptr, vec)
+#define gemm_set1(value) _mm256_set1_ps(value)
+#define gemm_zero() _mm256_setzero_ps()
+#ifdef __FMA__
+#define gemm_madd(a, b, c) _mm256_fmadd_ps(a, b, c)
+#else
+#define gemm_madd(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+#endif
+#define gemm_add(a, b) _mm256_add_ps(a, b)
+#define gemm_max(a, b) _mm256_max_ps(a, b)
+#define gemm_sigmoid(x) sigmoid256_ps(x)
+#define gemm_tanh(x) tanh256_ps(x)
+#define gemm_sigmoid_fast(x) sigmoid256_fast_ps(x)
+#define gemm_tanh_fast(x) tanh256_fast_ps(x)
+
+#else  // __ARM_NEON__
+
+#ifdef __aarch64__
+#define GEMM_MR 8
+#else
+/* ARMv7 has 16 quad registers, 8 of them hold C */
+#define GEMM_MR 4
+#endif
+#define GEMM_NV 2
+#define GEMM_VL 4
+typedef float32x4_t gemm_vec;
+#define gemm_load(ptr) vld1q_f32(ptr)
+#define gemm_loadu(ptr) vld1q_f32(ptr)
+#define gemm_storeu(ptr, vec) vst1q_f32(ptr, vec)
+#define gemm_set1(value) vdupq_n_f32(value)
+#define gemm_zero() vdupq_n_f32(0.f)
+#define gemm_madd(a, b, c) madd128(a, b, c)
+#define gemm_add(a, b) vaddq_f32(a, b)
+#define gemm_max(a, b) vmaxq_f32(a, b)
+#define gemm_sigmoid(x) sigmoid_ps(x)
+#define gemm_tanh(x) tanh_ps(x)
+#define gemm_sigmoid_fast(x) sigmoid_fast_ps(x)
+#define gemm_tanh_fast(x) tanh_fast_ps(x)
+
+#endif
+
+#define GEMM_NR (GEMM_NV * GEMM_VL)
+
+/* Cache blocking: a GEMM_KC x GEMM_NR panel of B stays in L1, a GEMM_MC x
+ * GEMM_KC block of A stays in L2 and a GEMM_KC x GEMM_NC block of B
+ * stays in L3. */
+#define GEMM_KC 256
+#define GEMM_MC (GEMM_MR * 24)
+#define GEMM_NC 4096
+
+#if GEMM_MR == 4
+#define GEMM_ROWS(X) X(0) X(1) X(2) X(3)
+#elif GEMM_MR == 6
+#define GEMM_ROWS(X) X(0) X(1) X(2) X(3) X(4) X(5)
+#else
+#define GEMM_ROWS(X) X(0) X(1) X(2) X(3) X(4) X(5) X(6) X(7)
+#endif
+
+#if GEMM_NV == 1
+#define GEMM_DECLARE(i) gemm_vec c##i##0 = gemm_zero();
+#define GEMM_UPDATE(i) { \
+  gemm_vec av = gemm_set1(a[i]); \
+  c##i##0 = gemm_madd(av, b0, c##i##0); \
+}
+#define GEMM_STORE(i) gemm_storeu(c + i * ldc, c##i##0);
+#define GEMM_ACCUMULATE(i) \
+  c##i##0 = gemm_madd(bv, gemm_loadu(c + i * ldc), c##i##0);
+#define GEMM_ADD_BIAS(i) c##i##0 = gemm_add(c##i##0, bias0);
+#define GEMM_ACTIVATE(i) c##i##0 = gemm_activate(c##i##0, activation);
+#else
+#define GEMM_DECLARE(i) gemm_vec c##i##0 = gemm_zero(), c##i##1 = gemm_zero();
+#define GEMM_UPDATE(i) { \
+  gemm_vec av = gemm_set1(a[i]); \
+  c##i##0 = gemm_madd(av, b0, c##i##0); \
+  c##i##1 = gemm_madd(av, b1, c##i##1); \
+}
+#define GEMM_STORE(i) \
+  gemm_storeu(c + i * ldc, c##i##0); \
+  gemm_storeu(c + i * ldc + GEMM_VL, c##i##1);
+#define GEMM_ACCUMULATE(i) \
+  c##i##0 = gemm_madd(bv, gemm_loadu(c + i * ldc), c##i##0); \
+  c##i##1 = gemm_madd(bv, gemm_loadu(c + i * ldc + GEMM_VL), c##i##1);
+#define GEMM_ADD_BIAS(i) \
+  c##i##0 = gemm_add(c##i##0, bias0); \
+  c##i##1 = gemm_add(c##i##1, bias1);
+#define GEMM_ACTIVATE(i) \
+  c##i##0 = gemm_activate(c##i##0, activation); \
+  c##i##1 = gemm_activate(c##i##1, activation);
+#endif
+
+/* The activation codes of the epilogue: MatrixActivation values, optionally
+ * combined with GEMM_ACTIVATION_FAST. GEMM_NO_EPILOGUE skips it. */
+#define GEMM_ACTIVATION_FAST 0x10
+#define GEMM_NO_EPILOGUE -1
+
+INLINE gemm_vec gemm_activate(gemm_vec x, int activation) {
+  switch (activation) {
+    case kMatrixActivationReLU:
+      return gemm_max(x, gemm_zero());
+    case kMatrixActivationSigmoid:
+      return gemm_sigmoid(x);
+    case kMatrixActivationTanh:
+      return gemm_tanh(x);
+    case kMatrixActivationSigmoid | GEMM_ACTIVATION_FAST:
+      return gemm_sigmoid_fast(x);
+    case kMatrixActivationTanh | GEMM_ACTIVATION_FAST:
+      return gemm_tanh_fast(x);
+    default:
+      return x;
+  }
+}
+
+/// @brief c = a * b + beta * c for a packed GEMM_MR x kc panel a and
+/// a packed kc x GEMM_NR panel b, followed by the epilogue
+/// c = activation(c + bias) unless activation is GEMM_NO_EPILOGUE.
+INLINE void gemm_kernel_body(int kc, const float *__restrict a,
+                             const float *__restrict b, float beta,
+                             float *__restrict c, int ldc,
+                             const float *bias, int activation) {
+  GEMM_ROWS(GEMM_DECLARE)
+  for (int k = 0; k < kc; k++) {
+    gemm_vec b0 = gemm_load(b);
+#if GEMM_NV > 1
+    gemm_vec b1 = gemm_load(b + GEMM_VL);
+#endif
+    GEMM_ROWS(GEMM_UPDATE)
+    a += GEMM_MR;
+    b += GEMM_NR;
+  }
+  if (beta != 0) {
+    gemm_vec bv = gemm_set1(beta);
+    GEMM_ROWS(GEMM_ACCUMULATE)
+  }
+  if (activation != GEMM_NO_EPILOGUE) {
+    if (bias) {
+      gemm_vec bias0 = gemm_loadu(bias);
+#if GEMM_NV > 1
+      gemm_vec bias1 = gemm_loadu(bias + GEMM_VL);
+#endif
+      GEMM_ROWS(GEMM_ADD_BIAS)
+    }
+    if (activation != kMatrixActivationNone) {
+      GEMM_ROWS(GEMM_ACTIVATE)
+    }
+  }
+  GEMM_ROWS(GEMM_STORE)
+}
+
+/// @brief The micro kernel without the epilogue.
+static void gemm_kernel(int kc, const float *__restrict a,
+                        const float *__restrict b, float beta,
+                        float *__restrict c, int ldc) {
+  gemm_kernel_body(kc, a, b, beta, c, ldc, NULL, GEMM_NO_EPILOGUE);
+}
+
+/// @brief The micro kernel which applies the epilogue to the block of C
+/// while it is still in registers.
+static void gemm_kernel_epilogue(int kc, const float *__restrict a,
+                                 const float *__restrict b, float beta,
+                                 float *__restrict c, int ldc,
+                                 const float *bias, int activation) {
+  gemm_kernel_body(kc, a, b, beta, c, ldc, bias, activation);
+}
+
+/// @brief Packs mc x kc block of A, multiplied by alpha, into GEMM_MR row
+/// panels, each is stored column by column. The last one is zero padded.
+static void gemm_pack_a(int mc, int kc, const float *A, int lda, float alpha,
+                        float *__restrict dst) {
+  for (int ir = 0; ir < mc; ir += GEMM_MR) {
+    int mr = mc - ir < GEMM_MR? mc - ir : GEMM_MR;
+    for (int i = 0; i < mr; i++) {
+      const float *row = A + (ir + i) * lda;
+      for (int k = 0; k < kc; k++) {
+        dst[k * GEMM_MR + i] = alpha * row[k];
+      }
+    }
+    for (int i = mr; i < GEMM_MR; i++) {
+      for (int k = 0; k < kc; k++) {
+        dst[k * GEMM_MR + i] = 0;
+      }
+    }
+    dst += GEMM_MR * kc;
+  }
+}
+
+/// @brief Packs kc x nc block of B into GEMM_NR column panels, each is
+/// stored row by row. The last one is zero padded.
+static void gemm_pack_b(int transposedB, int kc, int nc, const float *B,
+                        int ldb, float *__restrict dst) {
+  for (int jr = 0; jr < nc; jr += GEMM_NR) {
+    int nr = nc - jr < GEMM_NR? nc - jr : GEMM_NR;
+    if (transposedB) {
+      int kt = 0;
+      if (nr == GEMM_NR) {
+        // Full panels are transposed block by block
+        kt = kc / TRANSPOSE_BLOCK * TRANSPOSE_BLOCK;
+        for (int k = 0; k < kt; k += TRANSPOSE_BLOCK) {
+          for (int j = 0; j < GEMM_NR; j += TRANSPOSE_BLOCK) {
+            transpose_block(B + (jr + j) * ldb + k, ldb,
+                            dst + k * GEMM_NR + j, GEMM_NR);
+          }
+        }
+      }
+      for (int j = 0; j < nr; j++) {
+        const float *col = B + (jr + j) * ldb;
+        for (int k = kt; k < kc; k++) {
+          dst[k * GEMM_NR + j] = col[k];
+        }
+      }
+    } else {
+      for (int k = 0; k < kc; k++) {
+        const float *row = B + k * ldb + jr;
+        for (int j = 0; j < nr; j++) {
+          dst[k * GEMM_NR + j] = row[j];
+        }
+      }
+    }
+    for (int k = 0; k < kc && nr < GEMM_NR; k++) {
+      for (int j = nr; j < GEMM_NR; j++) {
+        dst[k * GEMM_NR + j] = 0;
+      }
+    }
+    dst += GEMM_NR * kc;
+  }
+}
+
+/// @brief Multiplies the packed blocks, C = A * B + beta * C, and applies
+/// the epilogue unless activation is GEMM_NO_EPILOGUE.
+static void gemm_macro_kernel(int mc, int nc, int kc,
+                              const float *pa, const float *pb,
+                              float beta, float *C, int ldc,
+                              const float *bias, int activation) {
+  float tmp[GEMM_MR * GEMM_NR] __attribute__((aligned(64)));
+  float tmpBias[GEMM_NR] __attribute__((aligned(64)));
+  for (int jr = 0; jr < nc; jr += GEMM_NR) {
+    int nr = nc - jr < GEMM_NR? nc - jr : GEMM_NR;
+    const float *b = pb + jr * kc;
+    const float *blockBias = bias? bias + jr : NULL;
+    if (bias && nr < GEMM_NR) {
+      // The kernel reads GEMM_NR bias values
+      for (int j = 0; j < GEMM_NR; j++) {
+        tmpBias[j] = j < nr? blockBias[j] : 0;
+      }
+      blockBias = tmpBias;
+    }
+    for (int ir = 0; ir < mc; ir += GEMM_MR) {
+      int mr = mc - ir < GEMM_MR? mc - ir : GEMM_MR;
+      const float *a = pa + ir * kc;
+      float *c = C + ir * ldc + jr;
+      if (mr == GEMM_MR && nr == GEMM_NR) {
+        if (activation == GEMM_NO_EPILOGUE) {
+          gemm_kernel(kc, a, b, beta, c, ldc);
+        } else {
+          gemm_kernel_epilogue(kc, a, b, beta, c, ldc, blockBias, activation);
+        }
+        continue;
+      }
+      // Partial block on the border goes through the temporary one
+      if (beta != 0) {
+        for (int i = 0; i < mr; i++) {
+          for (int j = 0; j < nr; j++) {
+            tmp[i * GEMM_NR + j] = c[i * ldc + j];
+          }
+        }
+      }
+      if (activation == GEMM_NO_EPILOGUE) {
+        gemm_kernel(kc, a, b, beta, tmp, GEMM_NR);
+      } else {
+        gemm_kernel_epilogue(kc, a, b, beta, tmp, GEMM_NR, blockBias,
+                             activation);
+      }
+      for (int i = 0; i < mr; i++) {
+        for (int j = 0; j < nr; j++) {
+          c[i * ldc + j] = tmp[i * GEMM_NR + j];
+        }
+      }
+    }
+  }
+}
+
+static float gemm_activate_scalar(float x, int activation) {
+  switch (activation & ~GEMM_ACTIVATION_FAST) {
+    case kMatrixActivationReLU:
+      return x > 0? x : 0;
+    case kMatrixActivationSigmoid:
+      return sigmoidf_na(x);
+    case kMatrixActivationTanh:
+      return tanhf(x);
+    default:
+      return x;
+  }
+}
+
+static void sgemm_blocked(int transposedB, int M, int N, int K,
+                          float alpha, const float *A, int lda,
+                          const float *B, int ldb,
+                          float beta, float *C, int ldc,
+                          const float *bias, int activation) {
+  if (M <= 0 || N <= 0) {
+    return;
+  }
+  if (K <= 0 || alpha == 0) {
+    for (int i = 0; i < M; i++) {
+      for (int j = 0; j < N; j++) {
+        float value = beta == 0? 0 : beta * C[i * ldc + j];
+        if (activation != GEMM_NO_EPILOGUE) {
+          value = gemm_activate_scalar(bias? value + bias[j] : value,
+                                       activation);
+        }
+        C[i * ldc + j] = value;
+      }
+    }
+    return;
+  }
+
+  int kcmax = K < GEMM_KC? K : GEMM_KC;
+  int mcmax = M < GEMM_MC? M : GEMM_MC;
+  int ncmax = N < GEMM_NC? N : GEMM_NC;
+  mcmax = (mcmax + GEMM_MR - 1) / GEMM_MR * GEMM_MR;
+  ncmax = (ncmax + GEMM_NR - 1) / GEMM_NR * GEMM_NR;
+  float *pa = mallocf(mcmax * kcmax);
+  float *pb = mallocf(kcmax * ncmax);
+
+  for (int jc = 0; jc < N; jc += GEMM_NC) {
+    int nc = N - jc < GEMM_NC? N - jc : GEMM_NC;
+    for (int pc = 0; pc < K; pc += GEMM_KC) {
+      int kc = K - pc < GEMM_KC? K - pc : GEMM_KC;
+      gemm_pack_b(transposedB, kc, nc,
+                  transposedB? B + jc * ldb + pc : B + pc * ldb + jc,
+                  ldb, pb);
+      // The first pass applies beta, the rest accumulate
+      float pbeta = pc == 0? beta : 1;
+      // The last one applies the epilogue
+      int pactivation = pc + kc == K? activation : GEMM_NO_EPILOGUE;
+      for (int ic = 0; ic < M; ic += GEMM_MC) {
+        int mc = M - ic < GEMM_MC? M - ic : GEMM_MC;
+        gemm_pack_a(mc, kc, A + ic * lda + pc, lda, alpha, pa);
+        gemm_macro_kernel(mc, nc, kc, pa, pb, pbeta, C + ic * ldc + jc, ldc,
+                          bias? bias + jc : NULL, pactivation);
+      }
+    }
+  }
+
+  free_aligned(pa);
+  free_aligned(pb);
+}
+
+void sgemm(int transposedB, int M, int N, int K,
+           float alpha, const float *A, int lda,
+           const float *B, int ldb,
+           float beta, float *C, int ldc) {
+  sgemm_blocked(transposedB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc,
+                NULL, GEMM_NO_EPILOGUE);
+}
+
+void sgemm_epilogue(int transposedB, int M, int N, int K,
+                    const float *A, int lda, const float *B, int ldb,
+                    const MatrixEpilogue *epilogue, float *C, int ldc) {
+  int activation = epilogue->activation;
+  if ((activation == kMatrixActivationSigmoid ||
+       activation == kMatrixActivationTanh) &&
+      mathfun_accuracy() == kMathAccuracyFast) {
+    activation |= GEMM_ACTIVATION_FAST;
+  }
+  sgemm_blocked(transposedB, M, N, K, epilogue->scale, A, lda, B, ldb, 0,
+                C, ldc, epilogue->bias, activation);
+}
+
+#endif  // defined(__AVX__) || defined(__ARM_NEON__)
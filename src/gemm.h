@@ -0,0 +1,87 @@
+/*! @file gemm.h
+ *  @brief Internal blocked single precision matrix multiplication.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_GEMM_H_
+#define SRC_GEMM_H_
+
+#include <simd/common.h>
+#include <simd/attributes.h>
+#include <simd/matrix.h>
+#include "src/dispatch.h"
+
+#define sgemm KERNEL(sgemm)
+#define sgemm_epilogue KERNEL(sgemm_epilogue)
+
+/// @brief Calculates C = alpha * A * B + beta * C, where A is M x K and
+/// B is K x N, all row-major.
+/// @param transposedB If nonzero, B is stored transposed (N x K, row-major).
+/// @param M The number of rows in A and C.
+/// @param N The number of columns in B and C.
+/// @param K The number of columns in A and rows in B.
+/// @param alpha The multiplier of A * B.
+/// @param A The first matrix.
+/// @param lda The distance between the rows of A (in float-s).
+/// @param B The second matrix.
+/// @param ldb The distance between the rows of B (in float-s).
+/// @param beta The multiplier of C. If it is 0, C is not read.
+/// @param C The resulting matrix.
+/// @param ldc The distance between the rows of C (in float-s).
+/// @details The operands are repacked into the cache sized blocks and the
+/// result is computed by the register blocked micro kernel of the current
+/// instruction set (6x16 on AVX/AVX2, 6x32 on AVX-512, 4x8 or 8x8 on NEON).
+/// Only SIMD builds define it.
+void sgemm(int transposedB, int M, int N, int K,
+           float alpha, const float *A, int lda,
+           const float *B, int ldb,
+           float beta, float *C, int ldc) NOTNULL(6, 8, 11);
+
+/// @brief Calculates C = activation(scale * A * B + bias), see
+/// matrix_multiply_fused().
+/// @param transposedB If nonzero, B is stored transposed (N x K, row-major).
+/// @param M The number of rows in A and C.
+/// @param N The number of columns in B and C.
+/// @param K The number of columns in A and rows in B.
+/// @param A The first matrix.
+/// @param lda The distance between the rows of A (in float-s).
+/// @param B The second matrix.
+/// @param ldb The distance between the rows of B (in float-s).
+/// @param epilogue The scale, the bias and the activation.
+/// @param C The resulting matrix.
+/// @param ldc The distance between the rows of C (in float-s).
+/// @details The epilogue is applied by the micro kernel during the last
+/// pass over K, before the block of C leaves the registers. Only SIMD
+/// builds define it.
+void sgemm_epilogue(int transposedB, int M, int N, int K,
+                    const float *A, int lda, const float *B, int ldb,
+                    const MatrixEpilogue *epilogue, float *C,
+                    int ldc) NOTNULL(5, 7, 9, 10);
+
+#endif  // SRC_GEMM_H_
@@ -0,0 +1,289 @@
+/*! @file mapped.c
+ *  @brief Out-of-core processing of the memory mapped signals.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+/* madvise(), MADV_DONTNEED and ftruncate() are not in C99 */
+#define _GNU_SOURCE
+#define LIBSIMD_IMPLEMENTATION
+#include "inc/simd/mapped.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "inc/simd/convolve.h"
+#include "inc/simd/memory.h"
+#include "inc/simd/wavelet.h"
+
+static int mapped_signal_map(int fd, size_t length, int writable,
+                             MappedSignal *signal) {
+  signal->data = NULL;
+  signal->length = length;
+  signal->fd = fd;
+  signal->writable = writable;
+  if (length == 0) {
+    return 0;
+  }
+  void *data = mmap(NULL, length * sizeof(float),
+                    writable? PROT_READ | PROT_WRITE : PROT_READ,
+                    MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    close(fd);
+    return -1;
+  }
+  // The chunks are processed from the beginning to the end
+  madvise(data, length * sizeof(float), MADV_SEQUENTIAL);
+  signal->data = data;
+  return 0;
+}
+
+int mapped_signal_open(const char *path, int writable, MappedSignal *signal) {
+  assert(path);
+  assert(signal);
+  int fd = open(path, writable? O_RDWR : O_RDONLY);
+  if (fd < 0) {
+    return -1;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    return -1;
+  }
+  return mapped_signal_map(fd, info.st_size / sizeof(float), writable,
+                           signal);
+}
+
+int mapped_signal_create(const char *path, size_t length,
+                         MappedSignal *signal) {
+  assert(path);
+  assert(signal);
+  int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return -1;
+  }
+  if (ftruncate(fd, length * sizeof(float)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return mapped_signal_map(fd, length, 1, signal);
+}
+
+void mapped_signal_close(MappedSignal *signal) {
+  assert(signal);
+  if (signal->data != NULL) {
+    munmap(signal->data, signal->length * sizeof(float));
+    signal->data = NULL;
+  }
+  if (signal->fd >= 0) {
+    close(signal->fd);
+    signal->fd = -1;
+  }
+}
+
+void mapped_signal_release(const MappedSignal *signal, size_t offset,
+                           size_t length) {
+  assert(signal);
+  assert(offset + length <= signal->length);
+  if (signal->data == NULL) {
+    return;
+  }
+  // Only the whole pages inside the range, the mapping starts at a page
+  uintptr_t page = sysconf(_SC_PAGESIZE);
+  uintptr_t begin = (uintptr_t)(signal->data + offset);
+  uintptr_t end = (uintptr_t)(signal->data + offset + length);
+  begin = (begin + page - 1) & ~(page - 1);
+  end &= ~(page - 1);
+  if (begin < end) {
+    // The dirty pages of a shared mapping stay in the page cache
+    madvise((void *)begin, end - begin, MADV_DONTNEED);
+  }
+}
+
+void convolve_mapped(const MappedSignal *x, const float *h, size_t hLength,
+                     const MappedSignal *result, size_t chunkLength) {
+  assert(x);
+  assert(h);
+  assert(result);
+  assert(hLength > 0);
+  assert(x->length > 0);
+  assert(result->writable);
+  assert(result->length == x->length + hLength - 1);
+  if (chunkLength == 0) {
+    chunkLength = MAPPED_DEFAULT_CHUNK;
+  }
+  ConvolutionStreamHandle handle = convolve_stream_initialize(
+      h, hLength, chunkLength);
+  for (size_t offset = 0; offset < x->length; offset += chunkLength) {
+    size_t length = x->length - offset;
+    if (length > chunkLength) {
+      length = chunkLength;
+    }
+    convolve_stream_process(handle, x->data + offset, length,
+                            result->data + offset);
+    mapped_signal_release(x, offset, length);
+    mapped_signal_release(result, offset, length);
+  }
+  // The tail is the response to the zeros after the signal
+  size_t tail = hLength - 1;
+  float *zeros = mallocf(tail < chunkLength? tail + 1 : chunkLength);
+  assert(zeros);
+  memsetf(zeros, 0.f, tail < chunkLength? tail + 1 : chunkLength);
+  for (size_t offset = x->length; offset < result->length;
+       offset += chunkLength) {
+    size_t length = result->length - offset;
+    if (length > chunkLength) {
+      length = chunkLength;
+    }
+    convolve_stream_process(handle, zeros, length, result->data + offset);
+    mapped_signal_release(result, offset, length);
+  }
+  free_aligned(zeros);
+  convolve_stream_finalize(handle);
+}
+
+void wavelet_apply_mapped(WaveletType type, int order, ExtensionType ext,
+                          const MappedSignal *src,
+                          const MappedSignal *desthi,
+                          const MappedSignal *destlo, size_t chunkLength) {
+  assert(src);
+  assert(desthi);
+  assert(destlo);
+  assert(src->length > 0 && src->length % 2 == 0);
+  assert(desthi->writable && destlo->writable);
+  assert(desthi->length == src->length / 2);
+  assert(destlo->length == src->length / 2);
+  if (chunkLength == 0) {
+    chunkLength = MAPPED_DEFAULT_CHUNK;
+  }
+  // Every chunk transforms an even number of samples
+  chunkLength = (chunkLength + 1) & ~(size_t)1;
+  size_t length = src->length;
+  // The windows never reach the extension of the handle, see below
+  WaveletHandle handle = wavelet_handle_initialize(
+      type, order, 0, EXTENSION_TYPE_ZERO);
+  size_t windowCapacity = chunkLength + order;
+  float *window = mallocf(windowCapacity);
+  float *hi = mallocf(windowCapacity / 2);
+  float *lo = mallocf(windowCapacity / 2);
+  assert(window && hi && lo);
+  size_t offset = 0;
+  // The inner chunks together with the next order - 2 samples
+  for (; offset + chunkLength + order - 2 <= length; offset += chunkLength) {
+    wavelet_handle_apply(handle, src->data + offset, chunkLength + order - 2,
+                         hi, lo);
+    memcpy(desthi->data + offset / 2, hi, chunkLength / 2 * sizeof(float));
+    memcpy(destlo->data + offset / 2, lo, chunkLength / 2 * sizeof(float));
+    mapped_signal_release(src, offset, chunkLength);
+    mapped_signal_release(desthi, offset / 2, chunkLength / 2);
+    mapped_signal_release(destlo, offset / 2, chunkLength / 2);
+  }
+  // The rest is followed by the extension of the whole signal, the same as
+  // initialize_extension() of wavelet_apply_na() makes
+  for (; offset < length; offset += chunkLength) {
+    size_t rest = length - offset;
+    if (rest > chunkLength) {
+      rest = chunkLength;
+    }
+    size_t have = length - offset;
+    if (have > rest + order) {
+      have = rest + order;
+    }
+    memcpy(window, src->data + offset, have * sizeof(float));
+    for (size_t i = have; i < rest + order; i++) {
+      size_t e = offset + i - length;
+      switch (ext) {
+        case EXTENSION_TYPE_PERIODIC:
+          window[i] = src->data[e % length];
+          break;
+        case EXTENSION_TYPE_MIRROR:
+          window[i] = src->data[length - 1 - (e % length)];
+          break;
+        case EXTENSION_TYPE_CONSTANT:
+          window[i] = src->data[length - 1];
+          break;
+        case EXTENSION_TYPE_ZERO:
+          window[i] = 0;
+          break;
+      }
+    }
+    wavelet_handle_apply(handle, window, rest + order, hi, lo);
+    memcpy(desthi->data + offset / 2, hi, rest / 2 * sizeof(float));
+    memcpy(destlo->data + offset / 2, lo, rest / 2 * sizeof(float));
+  }
+  free_aligned(lo);
+  free_aligned(hi);
+  free_aligned(window);
+  wavelet_handle_finalize(handle);
+}
+
+void detect_peaks_mapped(int simd, const MappedSignal *data,
+                         ExtremumType type, size_t chunkLength,
+                         ExtremumPoint **results, size_t *resultsLength) {
+  assert(data);
+  assert(results);
+  assert(resultsLength);
+  assert(data->length <= INT_MAX);
+  if (chunkLength == 0) {
+    chunkLength = MAPPED_DEFAULT_CHUNK;
+  }
+  *results = NULL;
+  *resultsLength = 0;
+  // Every sample of a chunk and the two kept ones may be an extremum
+  size_t capacity = chunkLength + 2;
+  ExtremumPoint *buffer = malloc(capacity * sizeof(ExtremumPoint));
+  assert(buffer);
+  DetectPeaksStream stream;
+  detect_peaks_stream_initialize(&stream, type, buffer, capacity);
+  size_t allocated = 0;
+  for (size_t offset = 0; offset < data->length; offset += chunkLength) {
+    size_t length = data->length - offset;
+    if (length > chunkLength) {
+      length = chunkLength;
+    }
+    detect_peaks_stream_push(simd, &stream, data->data + offset, length);
+    mapped_signal_release(data, offset, length);
+    if (stream.count == 0) {
+      continue;
+    }
+    if (*resultsLength + stream.count > allocated) {
+      allocated = (*resultsLength + stream.count) * 2;
+      *results = realloc(*results, allocated * sizeof(ExtremumPoint));
+      assert(*results);
+    }
+    *resultsLength += detect_peaks_stream_pop(
+        &stream, *results + *resultsLength, stream.count);
+  }
+  assert(stream.lost == 0);
+  free(buffer);
+}
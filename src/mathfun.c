@@ -0,0 +1,54 @@
+/*! @file mathfun.c
+ *  @brief The process wide accuracy tier of the vectorized math functions.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#define LIBSIMD_IMPLEMENTATION
+#include "inc/simd/mathfun.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <strings.h>
+
+static MathAccuracy math_accuracy = kMathAccuracyFull;
+
+MathAccuracy mathfun_accuracy(void) {
+  return math_accuracy;
+}
+
+void mathfun_set_accuracy(MathAccuracy accuracy) {
+  assert(accuracy == kMathAccuracyFull || accuracy == kMathAccuracyFast);
+  math_accuracy = accuracy;
+}
+
+static void __attribute__((constructor)) mathfun_initialize(void) {
+  const char *accuracy = getenv(SIMD_MATH_ACCURACY_ENV);
+  if (accuracy && !strcasecmp(accuracy, "fast")) {
+    math_accuracy = kMathAccuracyFast;
+  }
+}
@@ -29,10 +29,35 @@
  */
 
 #define LIBSIMD_IMPLEMENTATION
+#include "src/dispatch.h"
+#define matrix_add KERNEL(matrix_add)
+#define matrix_sub KERNEL(matrix_sub)
+#define matrix_multiply KERNEL(matrix_multiply)
+#define matrix_multiply_transposed KERNEL(matrix_multiply_transposed)
+#define matrix_multiply_accumulate KERNEL(matrix_multiply_accumulate)
+#define matrix_multiply_transposed_accumulate \
+    KERNEL(matrix_multiply_transposed_accumulate)
+#define matrix_multiply_fused KERNEL(matrix_multiply_fused)
+#define matrix_multiply_transposed_fused \
+    KERNEL(matrix_multiply_transposed_fused)
+#define matrix_multiply_batch KERNEL(matrix_multiply_batch)
+#define matrix_vector_multiply KERNEL(matrix_vector_multiply)
+#define matrix_vector_multiply_transposed \
+    KERNEL(matrix_vector_multiply_transposed)
+#define matrix_transpose KERNEL(matrix_transpose)
+#define matrix_transpose_inplace KERNEL(matrix_transpose_inplace)
+#define matrix_multiply_parallel KERNEL(matrix_multiply_parallel)
+#define matrix_multiply_transposed_parallel \
+    KERNEL(matrix_multiply_transposed_parallel)
 #include "inc/simd/matrix.h"
 #include <assert.h>
-#include "inc/simd/memory.h"
+#include <string.h>
 #include <simd/instruction_set.h>
+#include <simd/mathfun.h>
+#include "inc/simd/memory.h"
+#include "src/dot_product.h"
+#include "src/gemm.h"
+#include "src/transpose.h"
 
 static void matrix_add_novec(const float *m1, const float *m2,
                       size_t w, size_t h, float *res) {
@@ -52,14 +77,16 @@ static void matrix_sub_novec(const float *m1, const float *m2,
 
 static void matrix_multiply_novec(const float *m1, const float *m2,
                                   size_t w1, size_t h1, size_t w2,
-                                  size_t h2 UNUSED, float *res) {
+                                  size_t h2 UNUSED, float alpha, float beta,
+                                  float *res) {
   for (int i = 0; i < (int)w2; i++) {
     for (int j = 0; j < (int)h1; j++) {
       float sum = 0;
       for (int k = 0; k < (int)w1; k++) {
         sum += m1[j * w1 + k] * m2[k * w2 + i];
       }
-      res[j * w2 + i] = sum;
+      float *dst = res + j * w2 + i;
+      *dst = beta == 0? alpha * sum : alpha * sum + beta * *dst;
     }
   }
 }
@@ -67,6 +94,7 @@ static void matrix_multiply_novec(const float *m1, const float *m2,
 static void matrix_multiply_transposed_novec(const float *m1, const float *m2,
                                              size_t w1, size_t h1,
                                              size_t w2 UNUSED, size_t h2,
+                                             float alpha, float beta,
                                              float *res) {
   for (int j = 0; j < (int)h1; j++) {
     for (int i = 0; i < (int)h2; i++) {
@@ -74,7 +102,80 @@ static void matrix_multiply_transposed_novec(const float *m1, const float *m2,
       for (int k = 0; k < (int)w1; k++) {
         sum += m1[j * w1 + k] * m2[i * w1 + k];
       }
-      res[j * h2 + i] = sum;
+      float *dst = res + j * h2 + i;
+      *dst = beta == 0? alpha * sum : alpha * sum + beta * *dst;
+    }
+  }
+}
+
+static void matrix_epilogue_novec(const MatrixEpilogue *epilogue,
+                                  size_t w, size_t h, float *res) {
+  for (int i = 0; i < (int)h; i++) {
+    for (int j = 0; j < (int)w; j++) {
+      float x = res[i * w + j];
+      if (epilogue->bias) {
+        x += epilogue->bias[j];
+      }
+      switch (epilogue->activation) {
+        case kMatrixActivationReLU:
+          x = x > 0? x : 0;
+          break;
+        case kMatrixActivationSigmoid:
+          x = sigmoidf_na(x);
+          break;
+        case kMatrixActivationTanh:
+          x = tanhf(x);
+          break;
+        default:
+          break;
+      }
+      res[i * w + j] = x;
+    }
+  }
+}
+
+static void matrix_vector_multiply_novec(const float *m, const float *v,
+                                         size_t w, size_t h,
+                                         float alpha, float beta,
+                                         float *res) {
+  for (int i = 0; i < (int)h; i++) {
+    float sum = 0;
+    for (int j = 0; j < (int)w; j++) {
+      sum += m[i * w + j] * v[j];
+    }
+    res[i] = beta == 0? alpha * sum : alpha * sum + beta * res[i];
+  }
+}
+
+static void matrix_vector_multiply_transposed_novec(const float *m,
+                                                    const float *v,
+                                                    size_t w, size_t h,
+                                                    float alpha, float beta,
+                                                    float *res) {
+  for (int j = 0; j < (int)w; j++) {
+    float sum = 0;
+    for (int i = 0; i < (int)h; i++) {
+      sum += m[i * w + j] * v[i];
+    }
+    res[j] = beta == 0? alpha * sum : alpha * sum + beta * res[j];
+  }
+}
+
+static void matrix_transpose_novec(const float *m, size_t w, size_t h,
+                                   float *res) {
+  for (int i = 0; i < (int)h; i++) {
+    for (int j = 0; j < (int)w; j++) {
+      res[j * h + i] = m[i * w + j];
+    }
+  }
+}
+
+static void matrix_transpose_square_novec(float *m, size_t n) {
+  for (int i = 0; i < (int)n; i++) {
+    for (int j = i + 1; j < (int)n; j++) {
+      float tmp = m[i * n + j];
+      m[i * n + j] = m[j * n + i];
+      m[j * n + i] = tmp;
     }
   }
 }
@@ -110,58 +211,107 @@ static void matrix_sub_neon(const float *m1, const float *m2,
   }
 }
 
-static void matrix_multiply_neon(const float *m1, const float *m2,
-                                 size_t w1, size_t h1, size_t w2,
-                                 size_t h2 UNUSED, float *res) {
-  float col2[w1] __attribute__((aligned(64)));
-  for (int i = 0; i < (int)w2; i++) {
-    for (int k = 0; k < (int)w1; k++) {
-      col2[k] = m2[k * w2 + i];
+static void matrix_vector_multiply_neon(const float *m, const float *v,
+                                        size_t w, size_t h,
+                                        float alpha, float beta,
+                                        float *res) {
+  int width = w, height = h;
+  int i = 0;
+  // Four rows at a time share the loads of v
+  for (; i < height - 3; i += 4) {
+    const float *r0 = m + (size_t)i * width, *r1 = r0 + width;
+    const float *r2 = r1 + width, *r3 = r2 + width;
+    float32x4_t s0 = vdupq_n_f32(0.f), s1 = vdupq_n_f32(0.f);
+    float32x4_t s2 = vdupq_n_f32(0.f), s3 = vdupq_n_f32(0.f);
+    int j = 0;
+    for (; j < width - 3; j += 4) {
+      float32x4_t x = vld1q_f32(v + j);
+      s0 = madd128(vld1q_f32(r0 + j), x, s0);
+      s1 = madd128(vld1q_f32(r1 + j), x, s1);
+      s2 = madd128(vld1q_f32(r2 + j), x, s2);
+      s3 = madd128(vld1q_f32(r3 + j), x, s3);
     }
-    for (int j = 0; j < (int)h1; j++) {
-      float32x4_t sum = vdupq_n_f32(0.f);
-      for (int k = 0; k < (int)w1 - 7; k += 8) {
-        float32x4_t v1 = vld1q_f32(m1 + j * w1 + k);
-        float32x4_t v2 = vld1q_f32(col2 + k);
-        sum = vmlaq_f32(sum, v1, v2);
-        v1 = vld1q_f32(m1 + j * w1 + k + 4);
-        v2 = vld1q_f32(col2 + k + 4);
-        sum = vmlaq_f32(sum, v1, v2);
-      }
-      float32x2_t sum2 = vpadd_f32(vget_high_f32(sum),
-                                   vget_low_f32(sum));
-      float rsum = vget_lane_f32(sum2, 0) + vget_lane_f32(sum2, 1);
-      for (int k = (w1 & ~0x7); k < (int)w1; k++) {
-        rsum += m1[j * w1 + k] * col2[k];
-      }
-      res[j * w2 + i] = rsum;
+    float sums[4];
+#ifdef __aarch64__
+    // Two pairwise additions reduce the four rows at once
+    vst1q_f32(sums, vpaddq_f32(vpaddq_f32(s0, s1), vpaddq_f32(s2, s3)));
+#else
+    float32x2_t s01 = vpadd_f32(vadd_f32(vget_low_f32(s0), vget_high_f32(s0)),
+                                vadd_f32(vget_low_f32(s1), vget_high_f32(s1)));
+    float32x2_t s23 = vpadd_f32(vadd_f32(vget_low_f32(s2), vget_high_f32(s2)),
+                                vadd_f32(vget_low_f32(s3), vget_high_f32(s3)));
+    vst1q_f32(sums, vcombine_f32(s01, s23));
+#endif
+    for (; j < width; j++) {
+      sums[0] += r0[j] * v[j];
+      sums[1] += r1[j] * v[j];
+      sums[2] += r2[j] * v[j];
+      sums[3] += r3[j] * v[j];
     }
+    for (int k = 0; k < 4; k++) {
+      res[i + k] = beta == 0? alpha * sums[k] :
+          alpha * sums[k] + beta * res[i + k];
+    }
+  }
+  if (i < height) {
+    matrix_vector_multiply_novec(m + (size_t)i * width, v, w, height - i,
+                                 alpha, beta, res + i);
   }
 }
 
-static void matrix_multiply_transposed_neon(const float *m1, const float *m2,
-                                            size_t w1, size_t h1,
-                                            size_t w2 UNUSED,  size_t h2,
-                                            float *res) {
-  for (int j = 0; j < (int)h1; j++) {
-    for (int i = 0; i < (int)h2; i++) {
-      float32x4_t sum = vdupq_n_f32(0.f);
-      for (int k = 0; k < (int)w1 - 7; k += 8) {
-        float32x4_t v1 = vld1q_f32(m1 + j * w1 + k);
-        float32x4_t v2 = vld1q_f32(m2 + i * w1 + k);
-        sum = vmlaq_f32(sum, v1, v2);
-        v1 = vld1q_f32(m1 + j * w1 + k + 4);
-        v2 = vld1q_f32(m2 + i * w1 + k + 4);
-        sum = vmlaq_f32(sum, v1, v2);
-      }
-      float32x2_t sum2 = vpadd_f32(vget_high_f32(sum),
-                                   vget_low_f32(sum));
-      float rsum = vget_lane_f32(sum2, 0) + vget_lane_f32(sum2, 1);
-      for (int k = (w1 & ~0x7); k < (int)w1; k++) {
-        rsum += m1[j * w1 + k] * m2[i * w1 + k];
-      }
-      res[j * h2 + i] = rsum;
+static void matrix_vector_multiply_transposed_neon(const float *m,
+                                                   const float *v,
+                                                   size_t w, size_t h,
+                                                   float alpha, float beta,
+                                                   float *res) {
+  int width = w, height = h;
+  float32x4_t va = vdupq_n_f32(alpha), vb = vdupq_n_f32(beta);
+  int j = 0;
+  // The columns are accumulated in registers, 16 at a time
+  for (; j < width - 15; j += 16) {
+    float32x4_t s0 = vdupq_n_f32(0.f), s1 = vdupq_n_f32(0.f);
+    float32x4_t s2 = vdupq_n_f32(0.f), s3 = vdupq_n_f32(0.f);
+    const float *col = m + j;
+    for (int i = 0; i < height; i++, col += width) {
+      float32x4_t x = vdupq_n_f32(v[i]);
+      s0 = madd128(vld1q_f32(col), x, s0);
+      s1 = madd128(vld1q_f32(col + 4), x, s1);
+      s2 = madd128(vld1q_f32(col + 8), x, s2);
+      s3 = madd128(vld1q_f32(col + 12), x, s3);
+    }
+    s0 = vmulq_f32(s0, va);
+    s1 = vmulq_f32(s1, va);
+    s2 = vmulq_f32(s2, va);
+    s3 = vmulq_f32(s3, va);
+    if (beta != 0) {
+      s0 = madd128(vld1q_f32(res + j), vb, s0);
+      s1 = madd128(vld1q_f32(res + j + 4), vb, s1);
+      s2 = madd128(vld1q_f32(res + j + 8), vb, s2);
+      s3 = madd128(vld1q_f32(res + j + 12), vb, s3);
     }
+    vst1q_f32(res + j, s0);
+    vst1q_f32(res + j + 4, s1);
+    vst1q_f32(res + j + 8, s2);
+    vst1q_f32(res + j + 12, s3);
+  }
+  for (; j < width - 3; j += 4) {
+    float32x4_t s = vdupq_n_f32(0.f);
+    const float *col = m + j;
+    for (int i = 0; i < height; i++, col += width) {
+      s = madd128(vld1q_f32(col), vdupq_n_f32(v[i]), s);
+    }
+    s = vmulq_f32(s, va);
+    if (beta != 0) {
+      s = madd128(vld1q_f32(res + j), vb, s);
+    }
+    vst1q_f32(res + j, s);
+  }
+  for (; j < width; j++) {
+    float sum = 0;
+    for (int i = 0; i < height; i++) {
+      sum += m[(size_t)i * width + j] * v[i];
+    }
+    res[j] = beta == 0? alpha * sum : alpha * sum + beta * res[j];
   }
 }
 #endif
@@ -197,60 +347,332 @@ static void matrix_sub_avx(const float *m1, const float *m2,
   }
 }
 
-static void matrix_multiply_avx(const float *m1, const float *m2,
-                                size_t w1, size_t h1, size_t w2,
-                                size_t h2 UNUSED, float *res) {
-  assert(align_complement_f32(m1) == 0);
-  float col2[w1] __attribute__((aligned(64)));
-  for (int i = 0; i < (int)w2; i++) {
-    for (int k = 0; k < (int)w1; k++) {
-      col2[k] = m2[k * w2 + i];
+static void matrix_vector_multiply_avx(const float *m, const float *v,
+                                       size_t w, size_t h,
+                                       float alpha, float beta,
+                                       float *res) {
+  int width = w, height = h;
+  int i = 0;
+  // Four rows at a time share the loads of v
+  for (; i < height - 3; i += 4) {
+    const float *r0 = m + (size_t)i * width, *r1 = r0 + width;
+    const float *r2 = r1 + width, *r3 = r2 + width;
+    __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+    __m256 s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+    int j = 0;
+    for (; j < width - 7; j += 8) {
+      __m256 x = _mm256_loadu_ps(v + j);
+      s0 = madd256(_mm256_loadu_ps(r0 + j), x, s0);
+      s1 = madd256(_mm256_loadu_ps(r1 + j), x, s1);
+      s2 = madd256(_mm256_loadu_ps(r2 + j), x, s2);
+      s3 = madd256(_mm256_loadu_ps(r3 + j), x, s3);
     }
-    for (int j = 0; j < (int)h1; j++) {
-      __m256 sum = _mm256_setzero_ps();
-      for (int k = 0; k < (int)w1 - 7; k += 8) {
-        __m256 v1 = _mm256_loadu_ps(m1 + j * w1 + k);
-        __m256 v2 = _mm256_load_ps(col2 + k);
-        __m256 dp = _mm256_mul_ps(v1, v2);
-        sum = _mm256_add_ps(sum, dp);
-      }
-      sum = _mm256_hadd_ps(sum, sum);
-      sum = _mm256_hadd_ps(sum, sum);
-      float rsum = _mm256_get_ps(sum, 0) + _mm256_get_ps(sum, 4);
-      for (int k = (w1 & ~0x7); k < (int)w1; k++) {
-        rsum += m1[j * w1 + k] * col2[k];
+    // Lane k of every 128-bit half of s holds the partial sum of row k
+    __m256 s = _mm256_hadd_ps(_mm256_hadd_ps(s0, s1), _mm256_hadd_ps(s2, s3));
+    float sums[4] __attribute__((aligned(16)));
+    _mm_store_ps(sums, _mm_add_ps(_mm256_castps256_ps128(s),
+                                  _mm256_extractf128_ps(s, 1)));
+    for (; j < width; j++) {
+      sums[0] += r0[j] * v[j];
+      sums[1] += r1[j] * v[j];
+      sums[2] += r2[j] * v[j];
+      sums[3] += r3[j] * v[j];
+    }
+    for (int k = 0; k < 4; k++) {
+      res[i + k] = beta == 0? alpha * sums[k] :
+          alpha * sums[k] + beta * res[i + k];
+    }
+  }
+  for (; i < height; i++) {
+    const float *row = m + (size_t)i * width;
+    __m256 s = _mm256_setzero_ps();
+    int j = 0;
+    for (; j < width - 7; j += 8) {
+      s = madd256(_mm256_loadu_ps(row + j), _mm256_loadu_ps(v + j), s);
+    }
+    float sum = hsum256(s);
+    for (; j < width; j++) {
+      sum += row[j] * v[j];
+    }
+    res[i] = beta == 0? alpha * sum : alpha * sum + beta * res[i];
+  }
+}
+
+static void matrix_vector_multiply_transposed_avx(const float *m,
+                                                  const float *v,
+                                                  size_t w, size_t h,
+                                                  float alpha, float beta,
+                                                  float *res) {
+  int width = w, height = h;
+  __m256 va = _mm256_set1_ps(alpha), vb = _mm256_set1_ps(beta);
+  int j = 0;
+  // The columns are accumulated in registers, 32 at a time
+  for (; j < width - 31; j += 32) {
+    __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+    __m256 s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+    const float *col = m + j;
+    for (int i = 0; i < height; i++, col += width) {
+      __m256 x = _mm256_set1_ps(v[i]);
+      s0 = madd256(_mm256_loadu_ps(col), x, s0);
+      s1 = madd256(_mm256_loadu_ps(col + 8), x, s1);
+      s2 = madd256(_mm256_loadu_ps(col + 16), x, s2);
+      s3 = madd256(_mm256_loadu_ps(col + 24), x, s3);
+    }
+    s0 = _mm256_mul_ps(s0, va);
+    s1 = _mm256_mul_ps(s1, va);
+    s2 = _mm256_mul_ps(s2, va);
+    s3 = _mm256_mul_ps(s3, va);
+    if (beta != 0) {
+      s0 = madd256(_mm256_loadu_ps(res + j), vb, s0);
+      s1 = madd256(_mm256_loadu_ps(res + j + 8), vb, s1);
+      s2 = madd256(_mm256_loadu_ps(res + j + 16), vb, s2);
+      s3 = madd256(_mm256_loadu_ps(res + j + 24), vb, s3);
+    }
+    _mm256_storeu_ps(res + j, s0);
+    _mm256_storeu_ps(res + j + 8, s1);
+    _mm256_storeu_ps(res + j + 16, s2);
+    _mm256_storeu_ps(res + j + 24, s3);
+  }
+  for (; j < width - 7; j += 8) {
+    __m256 s = _mm256_setzero_ps();
+    const float *col = m + j;
+    for (int i = 0; i < height; i++, col += width) {
+      s = madd256(_mm256_loadu_ps(col), _mm256_set1_ps(v[i]), s);
+    }
+    s = _mm256_mul_ps(s, va);
+    if (beta != 0) {
+      s = madd256(_mm256_loadu_ps(res + j), vb, s);
+    }
+    _mm256_storeu_ps(res + j, s);
+  }
+  for (; j < width; j++) {
+    float sum = 0;
+    for (int i = 0; i < height; i++) {
+      sum += m[(size_t)i * width + j] * v[i];
+    }
+    res[j] = beta == 0? alpha * sum : alpha * sum + beta * res[j];
+  }
+}
+#endif
+
+#if defined(__ARM_NEON__) || defined(__AVX__)
+
+/* Small products are calculated directly, without packing the operands
+ * like sgemm() does: SMALL_ROWS x NV vectors of the result are kept in
+ * registers while the whole common dimension is run through. The vector
+ * operations are macros, so that the same kernel template is instantiated
+ * for 128-bit vectors as well. */
+#ifdef __AVX__
+#define small_vec __m256
+#define small_loadu(ptr) _mm256_loadu_ps(ptr)
+#define small_storeu(ptr, vec) _mm256_storeu_ps(ptr, vec)
+#define small_set1(value) _mm256_set1_ps(value)
+#define small_zero() _mm256_setzero_ps()
+#define small_madd(a, b, c) madd256(a, b, c)
+#define SMALL_VL 8
+#ifdef SIMD_AVX_EMULATION
+/* Every emulated register is a pair of SSE ones, only 16 are available */
+#define SMALL_MAX_NV 2
+#else
+#define SMALL_MAX_NV 4
+#endif
+#else
+#define small_vec float32x4_t
+#define small_loadu(ptr) vld1q_f32(ptr)
+#define small_storeu(ptr, vec) vst1q_f32(ptr, vec)
+#define small_set1(value) vdupq_n_f32(value)
+#define small_zero() vdupq_n_f32(0.f)
+#define small_madd(a, b, c) madd128(a, b, c)
+#define SMALL_VL 4
+#ifdef __aarch64__
+#define SMALL_MAX_NV 4
+#else
+#define SMALL_MAX_NV 2
+#endif
+#endif
+
+/* Larger right operands do not fit into L1 and are multiplied by sgemm() */
+#define SMALL_MAX_VOLUME 4096
+
+#define SMALL_COLUMNS_1(X, i) X(i, 0)
+#define SMALL_COLUMNS_2(X, i) X(i, 0) X(i, 1)
+#define SMALL_COLUMNS_3(X, i) X(i, 0) X(i, 1) X(i, 2)
+#define SMALL_COLUMNS_4(X, i) X(i, 0) X(i, 1) X(i, 2) X(i, 3)
+#define SMALL_ROWS_1(X, nv) X(0, nv)
+#define SMALL_ROWS_2(X, nv) X(0, nv) X(1, nv)
+#define SMALL_ROWS_4(X, nv) X(0, nv) X(1, nv) X(2, nv) X(3, nv)
+
+#define SMALL_DECLARE(i, j) small_vec c##i##j = small_zero();
+#define SMALL_LOAD(i, j) \
+  small_vec b##j = small_loadu(b + k * ldb + j * SMALL_VL);
+#define SMALL_UPDATE(i, j) c##i##j = small_madd(a##i, b##j, c##i##j);
+#define SMALL_STORE(i, j) small_storeu(c + i * ldc + j * SMALL_VL, c##i##j);
+#define SMALL_DECLARE_ROW(i, nv) SMALL_COLUMNS_##nv(SMALL_DECLARE, i)
+#define SMALL_BROADCAST_ROW(i, nv) \
+  small_vec a##i = small_set1(a[i * lda + k]);
+#define SMALL_UPDATE_ROW(i, nv) SMALL_COLUMNS_##nv(SMALL_UPDATE, i)
+#define SMALL_STORE_ROW(i, nv) SMALL_COLUMNS_##nv(SMALL_STORE, i)
+
+#define SMALL_BLOCK(rows, nv) { \
+  SMALL_ROWS_##rows(SMALL_DECLARE_ROW, nv) \
+  for (int k = 0; k < K; k++) { \
+    SMALL_COLUMNS_##nv(SMALL_LOAD, 0) \
+    SMALL_ROWS_##rows(SMALL_BROADCAST_ROW, nv) \
+    SMALL_ROWS_##rows(SMALL_UPDATE_ROW, nv) \
+  } \
+  SMALL_ROWS_##rows(SMALL_STORE_ROW, nv) \
+}
+
+/// @brief Defines c = a * b for M x K a and K x (nv * SMALL_VL) b, rows
+/// rows of c at a time.
+#define SMALL_KERNEL(name, nv, rows) \
+static void name(int M, int K, const float *__restrict a, int lda, \
+                 const float *__restrict b, int ldb, \
+                 float *__restrict c, int ldc) { \
+  int i = 0; \
+  for (; i <= M - rows; i += rows, a += rows * lda, c += rows * ldc) \
+    SMALL_BLOCK(rows, nv) \
+  for (; i < M; i++, a += lda, c += ldc) \
+    SMALL_BLOCK(1, nv) \
+}
+
+SMALL_KERNEL(small_kernel1, 1, 4)
+#if SMALL_MAX_NV > 2
+SMALL_KERNEL(small_kernel2, 2, 4)
+SMALL_KERNEL(small_kernel3, 3, 2)
+SMALL_KERNEL(small_kernel4, 4, 2)
+#else
+SMALL_KERNEL(small_kernel2, 2, 2)
+#endif
+
+#ifdef __AVX__
+/* The remaining 4 columns are calculated with SSE */
+#undef small_vec
+#undef small_loadu
+#undef small_storeu
+#undef small_set1
+#undef small_zero
+#undef small_madd
+#define small_vec __m128
+#define small_loadu(ptr) _mm_loadu_ps(ptr)
+#define small_storeu(ptr, vec) _mm_storeu_ps(ptr, vec)
+#define small_set1(value) _mm_set1_ps(value)
+#define small_zero() _mm_setzero_ps()
+#ifdef __FMA__
+#define small_madd(a, b, c) _mm_fmadd_ps(a, b, c)
+#else
+#define small_madd(a, b, c) _mm_add_ps(_mm_mul_ps(a, b), c)
+#endif
+SMALL_KERNEL(small_kernel_half, 1, 4)
+#endif
+
+/// @brief res = m1 * m2 for M x K m1 and K x N m2, all of them contiguous.
+static void small_gemm(int M, int N, int K, const float *m1, const float *m2,
+                       float *res) {
+  int j = 0;
+  for (; j <= N - SMALL_MAX_NV * SMALL_VL; j += SMALL_MAX_NV * SMALL_VL) {
+#if SMALL_MAX_NV > 2
+    small_kernel4(M, K, m1, K, m2 + j, N, res + j, N);
+#else
+    small_kernel2(M, K, m1, K, m2 + j, N, res + j, N);
+#endif
+  }
+  switch ((N - j) / SMALL_VL) {
+#if SMALL_MAX_NV > 2
+    case 3:
+      small_kernel3(M, K, m1, K, m2 + j, N, res + j, N);
+      break;
+    case 2:
+      small_kernel2(M, K, m1, K, m2 + j, N, res + j, N);
+      break;
+#endif
+    case 1:
+      small_kernel1(M, K, m1, K, m2 + j, N, res + j, N);
+      break;
+    default:
+      break;
+  }
+  j += (N - j) / SMALL_VL * SMALL_VL;
+#ifdef __AVX__
+  if (j <= N - 4) {
+    small_kernel_half(M, K, m1, K, m2 + j, N, res + j, N);
+    j += 4;
+  }
+#endif
+  for (; j < N; j++) {
+    for (int i = 0; i < M; i++) {
+      float sum = 0;
+      for (int k = 0; k < K; k++) {
+        sum += m1[i * K + k] * m2[k * N + j];
       }
-      res[j * w2 + i] = rsum;
+      res[i * N + j] = sum;
     }
   }
 }
 
-static void matrix_multiply_transposed_avx(const float *m1, const float *m2,
-                                           size_t w1, size_t h1,
-                                           size_t w2 UNUSED,  size_t h2,
-                                           float *res) {
-  assert(align_complement_f32(m1) == 0);
-  assert(align_complement_f32(m2) == 0);
-  for (int j = 0; j < (int)h1; j++) {
-    for (int i = 0; i < (int)h2; i++) {
-      __m256 sum = _mm256_setzero_ps();
-      for (int k = 0; k < (int)w1 - 7; k += 8) {
-        __m256 v1 = _mm256_loadu_ps(m1 + j * w1 + k);
-        __m256 v2 = _mm256_loadu_ps(m2 + i * w1 + k);
-        __m256 dp = _mm256_mul_ps(v1, v2);
-        sum = _mm256_add_ps(sum, dp);
+/* TRANSPOSE_TILE x TRANSPOSE_TILE tiles of the source and of the
+ * destination stay in L1 while they are transposed block by block */
+#define TRANSPOSE_TILE 32
+
+static void matrix_transpose_blocked(const float *m, size_t w, size_t h,
+                                     float *res) {
+  int width = w, height = h;
+  int bw = width / TRANSPOSE_BLOCK * TRANSPOSE_BLOCK;
+  int bh = height / TRANSPOSE_BLOCK * TRANSPOSE_BLOCK;
+  for (int it = 0; it < bh; it += TRANSPOSE_TILE) {
+    int ie = it + TRANSPOSE_TILE < bh? it + TRANSPOSE_TILE : bh;
+    for (int jt = 0; jt < bw; jt += TRANSPOSE_TILE) {
+      int je = jt + TRANSPOSE_TILE < bw? jt + TRANSPOSE_TILE : bw;
+      for (int i = it; i < ie; i += TRANSPOSE_BLOCK) {
+        for (int j = jt; j < je; j += TRANSPOSE_BLOCK) {
+          transpose_block(m + (size_t)i * width + j, width,
+                          res + (size_t)j * height + i, height);
+        }
       }
-      sum = _mm256_hadd_ps(sum, sum);
-      sum = _mm256_hadd_ps(sum, sum);
-      float rsum = _mm256_get_ps(sum, 0) + _mm256_get_ps(sum, 4);
-      for (int k = (w1 & ~0x7); k < (int)w1; k++) {
-        rsum += m1[j * w1 + k] * m2[i * w1 + k];
+    }
+  }
+  // The borders which do not fill a whole block
+  for (int i = 0; i < bh; i++) {
+    for (int j = bw; j < width; j++) {
+      res[(size_t)j * height + i] = m[(size_t)i * width + j];
+    }
+  }
+  for (int i = bh; i < height; i++) {
+    for (int j = 0; j < width; j++) {
+      res[(size_t)j * height + i] = m[(size_t)i * width + j];
+    }
+  }
+}
+
+static void matrix_transpose_square_blocked(float *m, size_t n) {
+  int size = n;
+  int bn = size / TRANSPOSE_BLOCK * TRANSPOSE_BLOCK;
+  float tmp[TRANSPOSE_BLOCK * TRANSPOSE_BLOCK];
+  for (int i = 0; i < bn; i += TRANSPOSE_BLOCK) {
+    float *diagonal = m + (size_t)i * size + i;
+    transpose_block(diagonal, size, diagonal, size);
+    // The symmetric blocks are swapped through the temporary one
+    for (int j = i + TRANSPOSE_BLOCK; j < bn; j += TRANSPOSE_BLOCK) {
+      float *upper = m + (size_t)i * size + j;
+      float *lower = m + (size_t)j * size + i;
+      transpose_block(lower, size, tmp, TRANSPOSE_BLOCK);
+      transpose_block(upper, size, lower, size);
+      for (int k = 0; k < TRANSPOSE_BLOCK; k++) {
+        memcpy(upper + (size_t)k * size, tmp + k * TRANSPOSE_BLOCK,
+               TRANSPOSE_BLOCK * sizeof(float));
       }
-      res[j * h2 + i] = rsum;
+    }
+  }
+  for (int i = 0; i < size; i++) {
+    for (int j = i < bn? bn : i + 1; j < size; j++) {
+      float value = m[(size_t)i * size + j];
+      m[(size_t)i * size + j] = m[(size_t)j * size + i];
+      m[(size_t)j * size + i] = value;
     }
   }
 }
-#endif
+
+#endif  // defined(__ARM_NEON__) || defined(__AVX__)
 
 void matrix_add(int simd, const float *m1, const float *m2,
                 size_t w, size_t h, float *res) {
@@ -297,6 +719,19 @@ void matrix_sub(int simd, const float *m1, const float *m2,
 void matrix_multiply(int simd, const float *m1, const float *m2,
                      size_t w1, size_t h1, size_t w2, size_t h2,
                      float *res) {
+  matrix_multiply_accumulate(simd, m1, m2, w1, h1, w2, h2, 1, 0, res);
+}
+
+void matrix_multiply_transposed(int simd, const float *m1, const float *m2,
+                                size_t w1, size_t h1, size_t w2, size_t h2,
+                                float *res) {
+  matrix_multiply_transposed_accumulate(simd, m1, m2, w1, h1, w2, h2, 1, 0,
+                                        res);
+}
+
+void matrix_multiply_accumulate(int simd, const float *m1, const float *m2,
+                                size_t w1, size_t h1, size_t w2, size_t h2,
+                                float alpha, float beta, float *res) {
   assert(w1 == h2);
   assert(m1);
   assert(m2);
@@ -305,40 +740,356 @@ void matrix_multiply(int simd, const float *m1, const float *m2,
   assert(h1 > 0);
   assert(w2 > 0);
   if (simd) {
-#ifdef __ARM_NEON__
-    matrix_multiply_neon(m1, m2, w1, h1, w2, h2, res);
+#if defined(__ARM_NEON__) || defined(__AVX__)
+    if (alpha == 1 && beta == 0 && w1 * w2 <= SMALL_MAX_VOLUME) {
+      small_gemm(h1, w2, w1, m1, m2, res);
+      return;
+    }
+    sgemm(0, h1, w2, w1, alpha, m1, w1, m2, w2, beta, res, w2);
   } else {
-#elif defined(__AVX__)
-    matrix_multiply_avx(m1, m2, w1, h1, w2, h2, res);
+#else
+  } {
+#endif
+    matrix_multiply_novec(m1, m2, w1, h1, w2, h2, alpha, beta, res);
+  }
+}
+
+void matrix_multiply_transposed_accumulate(int simd, const float *m1,
+                                           const float *m2,
+                                           size_t w1, size_t h1,
+                                           size_t w2, size_t h2,
+                                           float alpha, float beta,
+                                           float *res) {
+  assert(w1 == w2);
+  assert(m1);
+  assert(m2);
+  assert(res);
+  assert(w1 > 0);
+  assert(h1 > 0);
+  assert(h2 > 0);
+  if (simd) {
+#if defined(__ARM_NEON__) || defined(__AVX__)
+    sgemm(1, h1, h2, w1, alpha, m1, w1, m2, w2, beta, res, h2);
   } else {
 #else
   } {
-#endif    
-    matrix_multiply_novec(m1, m2, w1, h1, w2, h2, res);
+#endif
+    matrix_multiply_transposed_novec(m1, m2, w1, h1, w2, h2, alpha, beta,
+                                     res);
   }
 }
 
-void matrix_multiply_transposed(int simd, const float *m1, const float *m2,
-                                size_t w1, size_t h1, size_t w2, size_t h2,
-                                float *res) {
+void matrix_multiply_fused(int simd, const float *m1, const float *m2,
+                           size_t w1, size_t h1, size_t w2, size_t h2,
+                           const MatrixEpilogue *epilogue, float *res) {
+  assert(w1 == h2);
+  assert(m1);
+  assert(m2);
+  assert(epilogue);
+  assert(res);
+  assert(w1 > 0);
+  assert(h1 > 0);
+  assert(w2 > 0);
+  if (simd) {
+#if defined(__ARM_NEON__) || defined(__AVX__)
+    sgemm_epilogue(0, h1, w2, w1, m1, w1, m2, w2, epilogue, res, w2);
+  } else {
+#else
+  } {
+#endif
+    matrix_multiply_novec(m1, m2, w1, h1, w2, h2, epilogue->scale, 0, res);
+    matrix_epilogue_novec(epilogue, w2, h1, res);
+  }
+}
+
+void matrix_multiply_transposed_fused(int simd, const float *m1,
+                                      const float *m2,
+                                      size_t w1, size_t h1,
+                                      size_t w2, size_t h2,
+                                      const MatrixEpilogue *epilogue,
+                                      float *res) {
   assert(w1 == w2);
   assert(m1);
   assert(m2);
+  assert(epilogue);
   assert(res);
   assert(w1 > 0);
   assert(h1 > 0);
   assert(h2 > 0);
   if (simd) {
+#if defined(__ARM_NEON__) || defined(__AVX__)
+    sgemm_epilogue(1, h1, h2, w1, m1, w1, m2, w2, epilogue, res, h2);
+  } else {
+#else
+  } {
+#endif
+    matrix_multiply_transposed_novec(m1, m2, w1, h1, w2, h2,
+                                     epilogue->scale, 0, res);
+    matrix_epilogue_novec(epilogue, h2, h1, res);
+  }
+}
+
+void matrix_multiply_batch(int simd, const float *m1, const float *m2,
+                           size_t w1, size_t h1, size_t w2, size_t h2,
+                           size_t count, float *res) {
+  assert(w1 == h2);
+  assert(m1);
+  assert(m2);
+  assert(res);
+  assert(w1 > 0);
+  assert(h1 > 0);
+  assert(w2 > 0);
+  size_t size1 = w1 * h1, size2 = w2 * h2, sizeRes = w2 * h1;
+  if (simd) {
+#if defined(__ARM_NEON__) || defined(__AVX__)
+    // The shape is checked once for the whole batch
+    if (w1 * w2 <= SMALL_MAX_VOLUME) {
+      for (size_t i = 0; i < count; i++) {
+        small_gemm(h1, w2, w1, m1 + i * size1, m2 + i * size2,
+                   res + i * sizeRes);
+      }
+    } else {
+      for (size_t i = 0; i < count; i++) {
+        sgemm(0, h1, w2, w1, 1, m1 + i * size1, w1, m2 + i * size2, w2,
+              0, res + i * sizeRes, w2);
+      }
+    }
+  } else {
+#else
+  } {
+#endif
+    for (size_t i = 0; i < count; i++) {
+      matrix_multiply_novec(m1 + i * size1, m2 + i * size2, w1, h1, w2, h2,
+                            1, 0, res + i * sizeRes);
+    }
+  }
+}
+
+void matrix_vector_multiply(int simd, const float *m, const float *v,
+                            size_t w, size_t h, float alpha, float beta,
+                            float *res) {
+  assert(m);
+  assert(v);
+  assert(res);
+  assert(w > 0);
+  assert(h > 0);
+  if (simd) {
 #ifdef __ARM_NEON__
-    matrix_multiply_transposed_neon(m1, m2, w1, h1, w2, h2, res);
+    matrix_vector_multiply_neon(m, v, w, h, alpha, beta, res);
   } else {
 #elif defined(__AVX__)
-    matrix_multiply_transposed_avx(m1, m2, w1, h1, w2, h2, res);
+    matrix_vector_multiply_avx(m, v, w, h, alpha, beta, res);
   } else {
 #else
   } {
 #endif
-    matrix_multiply_transposed_novec(m1, m2, w1, h1, w2, h2, res);
+    matrix_vector_multiply_novec(m, v, w, h, alpha, beta, res);
   }
 }
 
+void matrix_vector_multiply_transposed(int simd, const float *m,
+                                       const float *v, size_t w, size_t h,
+                                       float alpha, float beta, float *res) {
+  assert(m);
+  assert(v);
+  assert(res);
+  assert(w > 0);
+  assert(h > 0);
+  if (simd) {
+#ifdef __ARM_NEON__
+    matrix_vector_multiply_transposed_neon(m, v, w, h, alpha, beta, res);
+  } else {
+#elif defined(__AVX__)
+    matrix_vector_multiply_transposed_avx(m, v, w, h, alpha, beta, res);
+  } else {
+#else
+  } {
+#endif
+    matrix_vector_multiply_transposed_novec(m, v, w, h, alpha, beta, res);
+  }
+}
+
+void matrix_transpose(int simd, const float *m, size_t w, size_t h,
+                      float *res) {
+  assert(m);
+  assert(res);
+  assert(m != res);
+  assert(w > 0);
+  assert(h > 0);
+  if (simd) {
+#if defined(__ARM_NEON__) || defined(__AVX__)
+    matrix_transpose_blocked(m, w, h, res);
+  } else {
+#else
+  } {
+#endif
+    matrix_transpose_novec(m, w, h, res);
+  }
+}
+
+void matrix_transpose_inplace(int simd, float *m, size_t w, size_t h) {
+  assert(m);
+  assert(w > 0);
+  assert(h > 0);
+  if (w != h) {
+    float *tmp = mallocf(w * h);
+    matrix_transpose(simd, m, w, h, tmp);
+    memcpy(m, tmp, w * h * sizeof(float));
+    free_aligned(tmp);
+    return;
+  }
+  if (simd) {
+#if defined(__ARM_NEON__) || defined(__AVX__)
+    matrix_transpose_square_blocked(m, w);
+  } else {
+#else
+  } {
+#endif
+    matrix_transpose_square_novec(m, w);
+  }
+}
+
+#if defined(__ARM_NEON__) || defined(__AVX__)
+
+/* The tile sides are multiples of every micro kernel size, see gemm.c */
+#define TILE_ROWS_QUANTUM 24
+#define TILE_COLUMNS_QUANTUM 32
+/* Smaller products do not pay off waking up the threads */
+#define PARALLEL_MIN_VOLUME (64 * 64 * 64)
+
+typedef struct {
+  int transposedB;
+  int M, N, K;
+  float alpha, beta;
+  const float *A, *B;
+  int lda, ldb;
+  float *C;
+  int ldc;
+  int tileRows, tileColumns, tilesInRow;
+} ParallelGemm;
+
+static int round_up(int value, int quantum) {
+  return (value + quantum - 1) / quantum * quantum;
+}
+
+/// @brief Chooses the tiles so that the slowest thread has the least work,
+/// preferring the squarer ones which repack less.
+static void choose_tiles(ParallelGemm *gemm, int threads) {
+  long long bestCost = -1;
+  int bestPerimeter = 0;
+  for (int rowTiles = 1; rowTiles <= threads; rowTiles++) {
+    int rows = round_up((gemm->M + rowTiles - 1) / rowTiles,
+                        TILE_ROWS_QUANTUM);
+    int columnTiles = (threads + rowTiles - 1) / rowTiles;
+    int columns = round_up((gemm->N + columnTiles - 1) / columnTiles,
+                           TILE_COLUMNS_QUANTUM);
+    int tiles = ((gemm->M + rows - 1) / rows) *
+        ((gemm->N + columns - 1) / columns);
+    long long cost = (long long)((tiles + threads - 1) / threads) *
+        rows * columns;
+    if (bestCost < 0 || cost < bestCost ||
+        (cost == bestCost && rows + columns < bestPerimeter)) {
+      bestCost = cost;
+      bestPerimeter = rows + columns;
+      gemm->tileRows = rows;
+      gemm->tileColumns = columns;
+    }
+  }
+  gemm->tilesInRow = (gemm->N + gemm->tileColumns - 1) / gemm->tileColumns;
+}
+
+static void matrix_multiply_tile(void *arg, int index) {
+  const ParallelGemm *gemm = arg;
+  int i = (index / gemm->tilesInRow) * gemm->tileRows;
+  int j = (index % gemm->tilesInRow) * gemm->tileColumns;
+  int rows = gemm->M - i < gemm->tileRows? gemm->M - i : gemm->tileRows;
+  int columns = gemm->N - j < gemm->tileColumns?
+      gemm->N - j : gemm->tileColumns;
+  const float *B = gemm->transposedB?
+      gemm->B + (size_t)j * gemm->ldb : gemm->B + j;
+  sgemm(gemm->transposedB, rows, columns, gemm->K, gemm->alpha,
+        gemm->A + (size_t)i * gemm->lda, gemm->lda, B, gemm->ldb,
+        gemm->beta, gemm->C + (size_t)i * gemm->ldc + j, gemm->ldc);
+}
+
+static void sgemm_parallel(ThreadPool *pool, int threads, ParallelGemm *gemm) {
+  if (pool == NULL) {
+    pool = thread_pool_default();
+  }
+  if (threads == 0 || threads > thread_pool_size(pool)) {
+    threads = thread_pool_size(pool);
+  }
+  if (threads <= 1 ||
+      (long long)gemm->M * gemm->N * gemm->K < PARALLEL_MIN_VOLUME) {
+    sgemm(gemm->transposedB, gemm->M, gemm->N, gemm->K, gemm->alpha,
+          gemm->A, gemm->lda, gemm->B, gemm->ldb, gemm->beta,
+          gemm->C, gemm->ldc);
+    return;
+  }
+  choose_tiles(gemm, threads);
+  int tiles = ((gemm->M + gemm->tileRows - 1) / gemm->tileRows) *
+      gemm->tilesInRow;
+  thread_pool_run(pool, tiles, threads, matrix_multiply_tile, gemm);
+}
+
+#endif
+
+void matrix_multiply_parallel(int simd, ThreadPool *pool, int threads,
+                              const float *m1, const float *m2,
+                              size_t w1, size_t h1, size_t w2, size_t h2,
+                              float alpha, float beta, float *res) {
+  assert(threads >= 0);
+  if (simd) {
+#if defined(__ARM_NEON__) || defined(__AVX__)
+    assert(w1 == h2);
+    assert(m1);
+    assert(m2);
+    assert(res);
+    assert(w1 > 0);
+    assert(h1 > 0);
+    assert(w2 > 0);
+    ParallelGemm gemm = {
+      .transposedB = 0, .M = h1, .N = w2, .K = w1,
+      .alpha = alpha, .beta = beta,
+      .A = m1, .B = m2, .lda = w1, .ldb = w2, .C = res, .ldc = w2
+    };
+    sgemm_parallel(pool, threads, &gemm);
+  } else {
+#else
+  } {
+#endif
+    matrix_multiply_accumulate(0, m1, m2, w1, h1, w2, h2, alpha, beta, res);
+  }
+}
+
+void matrix_multiply_transposed_parallel(int simd, ThreadPool *pool,
+                                         int threads,
+                                         const float *m1, const float *m2,
+                                         size_t w1, size_t h1,
+                                         size_t w2, size_t h2,
+                                         float alpha, float beta,
+                                         float *res) {
+  assert(threads >= 0);
+  if (simd) {
+#if defined(__ARM_NEON__) || defined(__AVX__)
+    assert(w1 == w2);
+    assert(m1);
+    assert(m2);
+    assert(res);
+    assert(w1 > 0);
+    assert(h1 > 0);
+    assert(h2 > 0);
+    ParallelGemm gemm = {
+      .transposedB = 1, .M = h1, .N = h2, .K = w1,
+      .alpha = alpha, .beta = beta,
+      .A = m1, .B = m2, .lda = w1, .ldb = w2, .C = res, .ldc = h2
+    };
+    sgemm_parallel(pool, threads, &gemm);
+  } else {
+#else
+  } {
+#endif
+    matrix_multiply_transposed_accumulate(0, m1, m2, w1, h1, w2, h2,
+                                          alpha, beta, res);
+  }
+}
@@ -0,0 +1,381 @@
+/*! @file matrix_int.c
+ *  @brief Integer matrix multiplication and requantization.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#define LIBSIMD_IMPLEMENTATION
+#include "src/dispatch.h"
+#define matrix_multiply_int16 KERNEL(matrix_multiply_int16)
+#define matrix_multiply_int8 KERNEL(matrix_multiply_int8)
+#define matrix_requantize_float KERNEL(matrix_requantize_float)
+#define matrix_requantize_int8 KERNEL(matrix_requantize_int8)
+#include "inc/simd/matrix.h"
+#include <assert.h>
+#include <math.h>
+#include <simd/instruction_set.h>
+#include "inc/simd/memory.h"
+
+/// @brief Reads the element of either int8_t or int16_t matrix.
+static int16_t matrix_element(const void *m, size_t index, int int8) {
+  return int8? ((const int8_t *)m)[index] : ((const int16_t *)m)[index];
+}
+
+static void matrix_multiply_int_novec(const void *m1, const void *m2, int int8,
+                                      size_t w1, size_t h1, size_t w2,
+                                      int32_t *res) {
+  for (int i = 0; i < (int)h1; i++) {
+    for (int j = 0; j < (int)w2; j++) {
+      int32_t sum = 0;
+      for (int k = 0; k < (int)w1; k++) {
+        sum += (int32_t)matrix_element(m1, i * w1 + k, int8) *
+            matrix_element(m2, k * w2 + j, int8);
+      }
+      res[i * w2 + j] = sum;
+    }
+  }
+}
+
+#if defined(__SSE4_1__) || defined(__ARM_NEON__)
+
+/* Both operands are repacked into int16 pairs of the adjacent elements in
+ * K, each pair being stored as a single int32. A pair of A is broadcast
+ * and multiplied by the pairs of IGEMM_NR columns of B, the products of
+ * each pair are summed (vpmaddwd on x86), so the micro kernel keeps
+ * IGEMM_MR x IGEMM_NR block of int32 sums in registers. */
+#define IGEMM_MR 4
+
+#if defined(__AVX512F__)
+#define IGEMM_VL 16
+typedef __m512i igemm_vec;
+#define igemm_loadu(ptr) _mm512_loadu_si512(ptr)
+#define igemm_storeu(ptr, vec) _mm512_storeu_si512(ptr, vec)
+#define igemm_set1(value) _mm512_set1_epi32(value)
+#define igemm_zero() _mm512_setzero_si512()
+#define igemm_madd(a, b) _mm512_madd_epi16(a, b)
+#define igemm_add(a, b) _mm512_add_epi32(a, b)
+#elif defined(__AVX2__)
+#define IGEMM_VL 8
+typedef __m256i igemm_vec;
+#define igemm_loadu(ptr) _mm256_loadu_si256((const __m256i *)(ptr))
+#define igemm_storeu(ptr, vec) _mm256_storeu_si256((__m256i *)(ptr), vec)
+#define igemm_set1(value) _mm256_set1_epi32(value)
+#define igemm_zero() _mm256_setzero_si256()
+#define igemm_madd(a, b) _mm256_madd_epi16(a, b)
+#define igemm_add(a, b) _mm256_add_epi32(a, b)
+#elif defined(__SSE4_1__)
+/* AVX has no 256-bit integer arithmetic */
+#define IGEMM_VL 4
+typedef __m128i igemm_vec;
+#define igemm_loadu(ptr) _mm_loadu_si128((const __m128i *)(ptr))
+#define igemm_storeu(ptr, vec) _mm_storeu_si128((__m128i *)(ptr), vec)
+#define igemm_set1(value) _mm_set1_epi32(value)
+#define igemm_zero() _mm_setzero_si128()
+#define igemm_madd(a, b) _mm_madd_epi16(a, b)
+#define igemm_add(a, b) _mm_add_epi32(a, b)
+#endif
+
+#ifdef __ARM_NEON__
+#define IGEMM_NR 4
+#else
+#define IGEMM_NR (2 * IGEMM_VL)
+#endif
+
+/// @brief Packs two int16 values into int32, the first one goes to the
+/// lower half.
+static int32_t igemm_pair(int16_t first, int16_t second) {
+  return (int32_t)(((uint32_t)(uint16_t)second << 16) | (uint16_t)first);
+}
+
+/// @brief Packs M x K matrix A into mp x kp int32 pairs, zero padded.
+static void igemm_pack_a(const void *A, int int8, int M, int K, int mp,
+                         int kp, int32_t *__restrict dst) {
+  for (int i = 0; i < mp; i++) {
+    for (int p = 0; p < kp; p++) {
+      int k = 2 * p;
+      int16_t first = i < M? matrix_element(A, (size_t)i * K + k, int8) : 0;
+      int16_t second = i < M && k + 1 < K?
+          matrix_element(A, (size_t)i * K + k + 1, int8) : 0;
+      dst[i * kp + p] = igemm_pair(first, second);
+    }
+  }
+}
+
+/// @brief Packs K x N matrix B into IGEMM_NR column panels of kp int32
+/// pairs, zero padded. Each panel is stored pair row by pair row.
+static void igemm_pack_b(const void *B, int int8, int K, int N, int np,
+                         int kp, int32_t *__restrict dst) {
+  for (int jr = 0; jr < np; jr += IGEMM_NR) {
+    for (int p = 0; p < kp; p++) {
+      int k = 2 * p;
+      for (int j = 0; j < IGEMM_NR; j++) {
+        int col = jr + j;
+        int16_t first = col < N?
+            matrix_element(B, (size_t)k * N + col, int8) : 0;
+        int16_t second = col < N && k + 1 < K?
+            matrix_element(B, (size_t)(k + 1) * N + col, int8) : 0;
+        *dst++ = igemm_pair(first, second);
+      }
+    }
+  }
+}
+
+#ifdef __ARM_NEON__
+
+/* The products of each pair are accumulated separately and summed in the
+ * end, lo holds the columns 0 and 1, hi holds 2 and 3. */
+#define IGEMM_DECLARE(i) \
+  int32x4_t lo##i = vdupq_n_s32(0), hi##i = vdupq_n_s32(0);
+#define IGEMM_UPDATE(i) { \
+  int16x8_t av = vreinterpretq_s16_s32(vdupq_n_s32(a[i * kp + p])); \
+  lo##i = vmlal_s16(lo##i, vget_low_s16(bv), vget_low_s16(av)); \
+  hi##i = vmlal_s16(hi##i, vget_high_s16(bv), vget_high_s16(av)); \
+}
+#ifdef __aarch64__
+#define IGEMM_STORE(i) vst1q_s32(c + i * ldc, vpaddq_s32(lo##i, hi##i));
+#else
+#define IGEMM_STORE(i) \
+  vst1q_s32(c + i * ldc, \
+            vcombine_s32(vpadd_s32(vget_low_s32(lo##i), vget_high_s32(lo##i)), \
+                         vpadd_s32(vget_low_s32(hi##i), vget_high_s32(hi##i))));
+#endif
+
+/// @brief c = a * b for IGEMM_MR x kp pairs of a and kp x IGEMM_NR pairs
+/// of the packed panel b.
+static void igemm_kernel(int kp, const int32_t *__restrict a,
+                         const int32_t *__restrict b,
+                         int32_t *__restrict c, int ldc) {
+  IGEMM_DECLARE(0) IGEMM_DECLARE(1) IGEMM_DECLARE(2) IGEMM_DECLARE(3)
+  for (int p = 0; p < kp; p++, b += IGEMM_NR) {
+    int16x8_t bv = vreinterpretq_s16_s32(vld1q_s32(b));
+    IGEMM_UPDATE(0) IGEMM_UPDATE(1) IGEMM_UPDATE(2) IGEMM_UPDATE(3)
+  }
+  IGEMM_STORE(0) IGEMM_STORE(1) IGEMM_STORE(2) IGEMM_STORE(3)
+}
+
+#else
+
+#define IGEMM_DECLARE(i) igemm_vec c##i##0 = igemm_zero(), c##i##1 = c##i##0;
+#define IGEMM_UPDATE(i) { \
+  igemm_vec av = igemm_set1(a[i * kp + p]); \
+  c##i##0 = igemm_add(c##i##0, igemm_madd(av, b0)); \
+  c##i##1 = igemm_add(c##i##1, igemm_madd(av, b1)); \
+}
+#define IGEMM_STORE(i) \
+  igemm_storeu(c + i * ldc, c##i##0); \
+  igemm_storeu(c + i * ldc + IGEMM_VL, c##i##1);
+
+/// @brief c = a * b for IGEMM_MR x kp pairs of a and kp x IGEMM_NR pairs
+/// of the packed panel b.
+static void igemm_kernel(int kp, const int32_t *__restrict a,
+                         const int32_t *__restrict b,
+                         int32_t *__restrict c, int ldc) {
+  IGEMM_DECLARE(0) IGEMM_DECLARE(1) IGEMM_DECLARE(2) IGEMM_DECLARE(3)
+  for (int p = 0; p < kp; p++, b += IGEMM_NR) {
+    igemm_vec b0 = igemm_loadu(b);
+    igemm_vec b1 = igemm_loadu(b + IGEMM_VL);
+    IGEMM_UPDATE(0) IGEMM_UPDATE(1) IGEMM_UPDATE(2) IGEMM_UPDATE(3)
+  }
+  IGEMM_STORE(0) IGEMM_STORE(1) IGEMM_STORE(2) IGEMM_STORE(3)
+}
+
+#endif
+
+/// @brief res = m1 * m2 for M x K m1 and K x N m2 of either int8_t or
+/// int16_t elements.
+static void igemm(const void *m1, const void *m2, int int8, int M, int N,
+                  int K, int32_t *res) {
+  int kp = (K + 1) / 2;
+  int mp = (M + IGEMM_MR - 1) / IGEMM_MR * IGEMM_MR;
+  int np = (N + IGEMM_NR - 1) / IGEMM_NR * IGEMM_NR;
+  int32_t *pa = malloc_aligned((size_t)mp * kp * sizeof(int32_t));
+  int32_t *pb = malloc_aligned((size_t)np * kp * sizeof(int32_t));
+  igemm_pack_a(m1, int8, M, K, mp, kp, pa);
+  igemm_pack_b(m2, int8, K, N, np, kp, pb);
+  int32_t tmp[IGEMM_MR * IGEMM_NR] __attribute__((aligned(64)));
+  for (int jr = 0; jr < N; jr += IGEMM_NR) {
+    int nr = N - jr < IGEMM_NR? N - jr : IGEMM_NR;
+    const int32_t *b = pb + (size_t)jr * kp;
+    for (int ir = 0; ir < M; ir += IGEMM_MR) {
+      int mr = M - ir < IGEMM_MR? M - ir : IGEMM_MR;
+      int32_t *c = res + (size_t)ir * N + jr;
+      if (mr == IGEMM_MR && nr == IGEMM_NR) {
+        igemm_kernel(kp, pa + (size_t)ir * kp, b, c, N);
+        continue;
+      }
+      // Partial block on the border
+      igemm_kernel(kp, pa + (size_t)ir * kp, b, tmp, IGEMM_NR);
+      for (int i = 0; i < mr; i++) {
+        for (int j = 0; j < nr; j++) {
+          c[i * N + j] = tmp[i * IGEMM_NR + j];
+        }
+      }
+    }
+  }
+  free_aligned(pa);
+  free_aligned(pb);
+}
+
+#endif  // defined(__SSE4_1__) || defined(__ARM_NEON__)
+
+static void matrix_multiply_int(int simd, const void *m1, const void *m2,
+                                int int8, size_t w1, size_t h1, size_t w2,
+                                size_t h2, int32_t *res) {
+  assert(w1 == h2);
+  assert(m1);
+  assert(m2);
+  assert(res);
+  assert(w1 > 0);
+  assert(h1 > 0);
+  assert(w2 > 0);
+  if (simd) {
+#if defined(__SSE4_1__) || defined(__ARM_NEON__)
+    igemm(m1, m2, int8, h1, w2, w1, res);
+  } else {
+#else
+  } {
+#endif
+    matrix_multiply_int_novec(m1, m2, int8, w1, h1, w2, res);
+  }
+}
+
+void matrix_multiply_int16(int simd, const int16_t *m1, const int16_t *m2,
+                           size_t w1, size_t h1, size_t w2, size_t h2,
+                           int32_t *res) {
+  matrix_multiply_int(simd, m1, m2, 0, w1, h1, w2, h2, res);
+}
+
+void matrix_multiply_int8(int simd, const int8_t *m1, const int8_t *m2,
+                          size_t w1, size_t h1, size_t w2, size_t h2,
+                          int32_t *res) {
+  matrix_multiply_int(simd, m1, m2, 1, w1, h1, w2, h2, res);
+}
+
+static float requantize_na(int32_t value, float scale, const float *bias,
+                           int j) {
+  float x = value * scale;
+  return bias? x + bias[j] : x;
+}
+
+static int8_t requantize_int8_na(int32_t value, float scale,
+                                 const float *bias, int j) {
+  float x = requantize_na(value, scale, bias, j);
+  x = x < -128? -128 : x > 127? 127 : x;
+  return (int8_t)lrintf(x);
+}
+
+void matrix_requantize_float(int simd, const int32_t *src, size_t w,
+                             size_t h, float scale, const float *bias,
+                             float *res) {
+  assert(src);
+  assert(res);
+  int width = w;
+  for (int i = 0; i < (int)h; i++) {
+    const int32_t *row = src + (size_t)i * width;
+    float *out = res + (size_t)i * width;
+    int j = 0;
+    if (simd) {
+#ifdef __AVX__
+      __m256 vs = _mm256_set1_ps(scale);
+      for (; j < width - 7; j += 8) {
+        __m256 x = _mm256_cvtepi32_ps(
+            _mm256_loadu_si256((const __m256i *)(row + j)));
+        x = _mm256_mul_ps(x, vs);
+        if (bias) {
+          x = _mm256_add_ps(x, _mm256_loadu_ps(bias + j));
+        }
+        _mm256_storeu_ps(out + j, x);
+      }
+#elif defined(__ARM_NEON__)
+      float32x4_t vs = vdupq_n_f32(scale);
+      for (; j < width - 3; j += 4) {
+        float32x4_t x = vmulq_f32(vcvtq_f32_s32(vld1q_s32(row + j)), vs);
+        if (bias) {
+          x = vaddq_f32(x, vld1q_f32(bias + j));
+        }
+        vst1q_f32(out + j, x);
+      }
+#endif
+    }
+    for (; j < width; j++) {
+      out[j] = requantize_na(row[j], scale, bias, j);
+    }
+  }
+}
+
+void matrix_requantize_int8(int simd, const int32_t *src, size_t w, size_t h,
+                            float scale, const float *bias, int8_t *res) {
+  assert(src);
+  assert(res);
+  int width = w;
+  for (int i = 0; i < (int)h; i++) {
+    const int32_t *row = src + (size_t)i * width;
+    int8_t *out = res + (size_t)i * width;
+    int j = 0;
+    if (simd) {
+#ifdef __AVX__
+      __m256 vs = _mm256_set1_ps(scale);
+      __m256 low = _mm256_set1_ps(-128), high = _mm256_set1_ps(127);
+      for (; j < width - 7; j += 8) {
+        __m256 x = _mm256_cvtepi32_ps(
+            _mm256_loadu_si256((const __m256i *)(row + j)));
+        x = _mm256_mul_ps(x, vs);
+        if (bias) {
+          x = _mm256_add_ps(x, _mm256_loadu_ps(bias + j));
+        }
+        // Clamping before the conversion keeps the huge values saturated
+        x = _mm256_min_ps(_mm256_max_ps(x, low), high);
+        __m256i q = _mm256_cvtps_epi32(x);
+        __m128i q16 = _mm_packs_epi32(_mm256_castsi256_si128(q),
+                                      _mm256_extractf128_si256(q, 1));
+        _mm_storel_epi64((__m128i *)(out + j), _mm_packs_epi16(q16, q16));
+      }
+#elif defined(__aarch64__)
+      float32x4_t vs = vdupq_n_f32(scale);
+      float32x4_t low = vdupq_n_f32(-128), high = vdupq_n_f32(127);
+      for (; j < width - 7; j += 8) {
+        float32x4_t x0 = vmulq_f32(vcvtq_f32_s32(vld1q_s32(row + j)), vs);
+        float32x4_t x1 = vmulq_f32(vcvtq_f32_s32(vld1q_s32(row + j + 4)),
+                                   vs);
+        if (bias) {
+          x0 = vaddq_f32(x0, vld1q_f32(bias + j));
+          x1 = vaddq_f32(x1, vld1q_f32(bias + j + 4));
+        }
+        x0 = vminq_f32(vmaxq_f32(x0, low), high);
+        x1 = vminq_f32(vmaxq_f32(x1, low), high);
+        int16x8_t q16 = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(x0)),
+                                     vqmovn_s32(vcvtnq_s32_f32(x1)));
+        vst1_s8(out + j, vqmovn_s16(q16));
+      }
+#endif
+    }
+    for (; j < width; j++) {
+      out[j] = requantize_int8_na(row[j], scale, bias, j);
+    }
+  }
+}
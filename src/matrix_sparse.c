@@ -0,0 +1,262 @@
+/*! @file matrix_sparse.c
+ *  @brief Sparse (CSR) and banded matrix multiplication.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#define LIBSIMD_IMPLEMENTATION
+#include "src/dispatch.h"
+#define matrix_count_nonzero KERNEL(matrix_count_nonzero)
+#define matrix_to_csr KERNEL(matrix_to_csr)
+#define matrix_csr_vector_multiply KERNEL(matrix_csr_vector_multiply)
+#define matrix_csr_multiply KERNEL(matrix_csr_multiply)
+#define matrix_banded_vector_multiply KERNEL(matrix_banded_vector_multiply)
+#define matrix_banded_multiply KERNEL(matrix_banded_multiply)
+#include "inc/simd/matrix.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <simd/instruction_set.h>
+#include "src/dot_product.h"
+
+#if defined(__AVX__)
+#define SPARSE_VL 8
+#define sparse_vec __m256
+#define sparse_loadu(ptr) _mm256_loadu_ps(ptr)
+#define sparse_storeu(ptr, vec) _mm256_storeu_ps(ptr, vec)
+#define sparse_set1(value) _mm256_set1_ps(value)
+#define sparse_zero() _mm256_setzero_ps()
+#define sparse_madd(a, b, c) madd256(a, b, c)
+#elif defined(__ARM_NEON__)
+#define SPARSE_VL 4
+#define sparse_vec float32x4_t
+#define sparse_loadu(ptr) vld1q_f32(ptr)
+#define sparse_storeu(ptr, vec) vst1q_f32(ptr, vec)
+#define sparse_set1(value) vdupq_n_f32(value)
+#define sparse_zero() vdupq_n_f32(0.f)
+#define sparse_madd(a, b, c) vmlaq_f32(c, a, b)
+#endif
+
+/* The rows of the banded matrix are processed in strips, so that the strip
+ * of the result stays in L1 while all the diagonals are added to it */
+#define BANDED_STRIP 1024
+
+size_t matrix_count_nonzero(const float *m, size_t w, size_t h) {
+  assert(m);
+  size_t count = 0;
+  for (size_t i = 0; i < w * h; i++) {
+    count += m[i] != 0;
+  }
+  return count;
+}
+
+void matrix_to_csr(const float *m, size_t w, size_t h, int *row_starts,
+                   int *columns, float *values) {
+  assert(m);
+  assert(row_starts);
+  int count = 0;
+  for (int i = 0; i < (int)h; i++) {
+    row_starts[i] = count;
+    for (int j = 0; j < (int)w; j++) {
+      float value = m[(size_t)i * w + j];
+      if (value != 0) {
+        columns[count] = j;
+        values[count] = value;
+        count++;
+      }
+    }
+  }
+  row_starts[h] = count;
+}
+
+/// @brief Calculates the dot product of the sparse row and v.
+static float csr_row_dot_product(int simd, const int *columns,
+                                 const float *values, int length,
+                                 const float *v) {
+  float sum = 0;
+  int k = 0;
+  if (simd) {
+#ifdef __AVX2__
+    __m256 s = _mm256_setzero_ps();
+    for (; k < length - 7; k += 8) {
+      __m256i indices = _mm256_loadu_si256((const __m256i *)(columns + k));
+      s = madd256(_mm256_loadu_ps(values + k),
+                  _mm256_i32gather_ps(v, indices, 4), s);
+    }
+    sum = hsum256(s);
+#else
+    // Without gathers, independent sums hide the latency of the adds
+    float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (; k < length - 3; k += 4) {
+      s0 += values[k] * v[columns[k]];
+      s1 += values[k + 1] * v[columns[k + 1]];
+      s2 += values[k + 2] * v[columns[k + 2]];
+      s3 += values[k + 3] * v[columns[k + 3]];
+    }
+    sum = (s0 + s1) + (s2 + s3);
+#endif
+  }
+  for (; k < length; k++) {
+    sum += values[k] * v[columns[k]];
+  }
+  return sum;
+}
+
+void matrix_csr_vector_multiply(int simd, const CSRMatrix *m, const float *v,
+                                float *res) {
+  assert(m);
+  assert(v);
+  assert(res);
+  for (int i = 0; i < (int)m->height; i++) {
+    int start = m->row_starts[i];
+    res[i] = csr_row_dot_product(simd, m->columns + start, m->values + start,
+                                 m->row_starts[i + 1] - start, v);
+  }
+}
+
+/// @brief res = sum(values[k] * rows[columns[k]]) for SPARSE_VL * nv
+/// columns of the dense rows, which are accumulated in registers.
+#define SPARSE_AXPY_COLUMNS(nv) do { \
+  sparse_vec s0 = sparse_zero(), s1 = s0, s2 = s0, s3 = s0; \
+  for (int k = 0; k < length; k++) { \
+    sparse_vec a = sparse_set1(values[k]); \
+    const float *row = m2 + (size_t)columns[k] * w2 + j; \
+    s0 = sparse_madd(a, sparse_loadu(row), s0); \
+    if (nv > 1) { \
+      s1 = sparse_madd(a, sparse_loadu(row + SPARSE_VL), s1); \
+      s2 = sparse_madd(a, sparse_loadu(row + 2 * SPARSE_VL), s2); \
+      s3 = sparse_madd(a, sparse_loadu(row + 3 * SPARSE_VL), s3); \
+    } \
+  } \
+  sparse_storeu(res + j, s0); \
+  if (nv > 1) { \
+    sparse_storeu(res + j + SPARSE_VL, s1); \
+    sparse_storeu(res + j + 2 * SPARSE_VL, s2); \
+    sparse_storeu(res + j + 3 * SPARSE_VL, s3); \
+  } \
+} while (0)
+
+/// @brief res = sum(values[k] * m2[columns[k]]), the linear combination
+/// of length rows of w2 x ? matrix m2.
+static void sparse_combine_rows(int simd, const int *columns,
+                                const float *values, int length,
+                                const float *m2, int w2, float *res) {
+  int j = 0;
+  if (simd) {
+#ifdef SPARSE_VL
+    for (; j <= w2 - 4 * SPARSE_VL; j += 4 * SPARSE_VL) {
+      SPARSE_AXPY_COLUMNS(4);
+    }
+    for (; j <= w2 - SPARSE_VL; j += SPARSE_VL) {
+      SPARSE_AXPY_COLUMNS(1);
+    }
+#endif
+  }
+  for (; j < w2; j++) {
+    float sum = 0;
+    for (int k = 0; k < length; k++) {
+      sum += values[k] * m2[(size_t)columns[k] * w2 + j];
+    }
+    res[j] = sum;
+  }
+}
+
+void matrix_csr_multiply(int simd, const CSRMatrix *m1, const float *m2,
+                         size_t w2, float *res) {
+  assert(m1);
+  assert(m2);
+  assert(res);
+  assert(w2 > 0);
+  for (int i = 0; i < (int)m1->height; i++) {
+    int start = m1->row_starts[i];
+    sparse_combine_rows(simd, m1->columns + start, m1->values + start,
+                        m1->row_starts[i + 1] - start, m2, w2,
+                        res + (size_t)i * w2);
+  }
+}
+
+void matrix_banded_vector_multiply(int simd, const float *diagonals,
+                                   size_t n, int lower, int upper,
+                                   const float *v, float *res) {
+  assert(diagonals);
+  assert(v);
+  assert(res);
+  assert(lower >= 0 && upper >= 0);
+  int size = n;
+  for (int strip = 0; strip < size; strip += BANDED_STRIP) {
+    int end = strip + BANDED_STRIP < size? strip + BANDED_STRIP : size;
+    memset(res + strip, 0, (end - strip) * sizeof(float));
+    for (int d = -lower; d <= upper; d++) {
+      // Row i of the diagonal d holds m[i][i + d]
+      const float *diagonal = diagonals + (size_t)(d + lower) * size;
+      int first = strip > -d? strip : -d;
+      int last = end < size - d? end : size - d;
+      int i = first;
+      if (simd) {
+#ifdef SPARSE_VL
+        for (; i <= last - SPARSE_VL; i += SPARSE_VL) {
+          sparse_storeu(res + i, sparse_madd(sparse_loadu(diagonal + i),
+                                             sparse_loadu(v + i + d),
+                                             sparse_loadu(res + i)));
+        }
+#endif
+      }
+      for (; i < last; i++) {
+        res[i] += diagonal[i] * v[i + d];
+      }
+    }
+  }
+}
+
+void matrix_banded_multiply(int simd, const float *diagonals, size_t n,
+                            int lower, int upper, const float *m2,
+                            size_t w2, float *res) {
+  assert(diagonals);
+  assert(m2);
+  assert(res);
+  assert(lower >= 0 && upper >= 0);
+  assert(w2 > 0);
+  int size = n;
+  int *columns = malloc((upper + lower + 1) * sizeof(int));
+  float *values = malloc((upper + lower + 1) * sizeof(float));
+  for (int i = 0; i < size; i++) {
+    // The row of the band is a sparse row with consecutive columns
+    int length = 0;
+    int first = i - lower > 0? i - lower : 0;
+    int last = i + upper < size - 1? i + upper : size - 1;
+    for (int j = first; j <= last; j++) {
+      columns[length] = j;
+      values[length] = diagonals[(size_t)(j - i + lower) * size + i];
+      length++;
+    }
+    sparse_combine_rows(simd, columns, values, length, m2, w2,
+                        res + (size_t)i * w2);
+  }
+  free(values);
+  free(columns);
+}
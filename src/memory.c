@@ -29,6 +29,9 @@
  */
 
 #define LIBSIMD_IMPLEMENTATION
+#ifdef HAVE_CONFIG_H
+#include "src/config.h"
+#endif
 #include "inc/simd/memory.h"
 #include <assert.h>
 #include <simd/instruction_set.h>
@@ -37,8 +40,13 @@
 #endif
 #include <stdlib.h>
 #include <stdint.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#include "inc/simd/thread_pool.h"
 
-#ifdef __AVX__
 static int align_offset_internal(const void *ptr) {
   uintptr_t addr = (uintptr_t)ptr;
   if ((addr & 31) != 0) {
@@ -66,7 +74,6 @@ int align_complement_i32(const int32_t *ptr) {
 int align_complement_u32(const uint32_t *ptr) {
   return align_offset_internal(ptr) / 4;
 }
-#endif
 
 void *malloc_aligned_offset(size_t size, int offset) {
   assert(offset >= 0 && offset < 32);
@@ -74,110 +81,349 @@ void *malloc_aligned_offset(size_t size, int offset) {
   return (char *)ptr + offset;
 }
 
-void *malloc_aligned(size_t size) {
+static void *system_allocate(size_t size, size_t alignment,
+                             void *context UNUSED) {
   void *ptr;
 #ifndef __ANDROID__
-  if (posix_memalign(&ptr, 64, size) != 0) {
+  if (posix_memalign(&ptr, alignment, size) != 0) {
     return NULL;
   }
 #else
-  ptr = memalign(64, size);
+  ptr = memalign(alignment, size);
 #endif
   return ptr;
 }
 
-float *mallocf(size_t length) {
-  return malloc_aligned(length * sizeof(float));
+static void system_release(void *ptr, void *context UNUSED) {
+  free(ptr);
 }
 
-void memsetf(float *ptr, float value, size_t length) {
-#ifdef __AVX__
-  const __m256 fillvec = _mm256_set1_ps(value);
-  size_t startIndex = align_complement_f32(ptr);
+static const SimdAllocator kSystemAllocator = {
+  system_allocate, system_release, NULL
+};
 
-  for (size_t i = 0; i < startIndex; i++) {
-    ptr[i] = value;
+static SimdAllocator global_allocator = {
+  system_allocate, system_release, NULL
+};
+static __thread SimdAllocator thread_allocator;
+static __thread int thread_allocator_set;
+
+void simd_set_allocator(const SimdAllocator *allocator) {
+  if (allocator == NULL) {
+    allocator = &kSystemAllocator;
   }
+  assert(allocator->allocate != NULL && allocator->release != NULL);
+  global_allocator = *allocator;
+}
+
+void simd_set_thread_allocator(const SimdAllocator *allocator) {
+  if (allocator == NULL) {
+    thread_allocator_set = 0;
+    return;
+  }
+  assert(allocator->allocate != NULL && allocator->release != NULL);
+  thread_allocator = *allocator;
+  thread_allocator_set = 1;
+}
+
+const SimdAllocator *simd_allocator(void) {
+  return thread_allocator_set? &thread_allocator : &global_allocator;
+}
+
+void *malloc_aligned(size_t size) {
+  const SimdAllocator *allocator = simd_allocator();
+  return allocator->allocate(size, 64, allocator->context);
+}
+
+/// mbind() policy, see numaif.h which is not always installed.
+#define SIMD_MPOL_BIND 2
+/// The maximal number of NUMA nodes, the same as in the Linux kernel.
+#define SIMD_MAX_NUMA_NODES 1024
+/// The granularity of NUMA binding.
+#define SIMD_SMALL_PAGE_SIZE 4096
+/// The minimal part of the block to zero in a single first touch task.
+#define FIRST_TOUCH_MIN_LENGTH (1 << 20)
+
+static void memory_bind_node(void *ptr, size_t size, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+  assert(node < SIMD_MAX_NUMA_NODES);
+  unsigned long mask[SIMD_MAX_NUMA_NODES / (8 * sizeof(unsigned long))];
+  memset(mask, 0, sizeof(mask));
+  mask[node / (8 * sizeof(unsigned long))] =
+      1ul << (node % (8 * sizeof(unsigned long)));
+  // Fails with ENOSYS or EINVAL on non-NUMA systems, which is fine
+  syscall(SYS_mbind, ptr, size, SIMD_MPOL_BIND, mask,
+          sizeof(mask) * 8 + 1, 0);
+#else
+  (void)ptr;
+  (void)size;
+  (void)node;
+#endif
+}
+
+typedef struct {
+  char *ptr;
+  size_t size;
+  size_t step;
+} FirstTouchJob;
 
-  for (int i = (int)startIndex; i < (int)length - 7; i += 8) {
-    _mm256_store_ps(ptr + i, fillvec);
+static void memory_first_touch_task(void *arg, int index) {
+  const FirstTouchJob *job = arg;
+  size_t begin = index * job->step;
+  size_t end = begin + job->step;
+  if (end > job->size) {
+    end = job->size;
   }
+  memset(job->ptr + begin, 0, end - begin);
+}
 
-  for (size_t i = startIndex + ((length - startIndex) & ~0x7);
-      i < length; i++) {
-    ptr[i] = value;
+void *malloc_aligned_ex(size_t size, int flags) {
+  int node = (flags >> 8) - 1;
+  int huge = (flags & kMemoryFlagHugePages) && size >= SIMD_HUGE_PAGE_SIZE;
+  const SimdAllocator *allocator = simd_allocator();
+  if (allocator->allocate != system_allocate) {
+    // Custom allocators manage the placement themselves
+    huge = 0;
+    node = -1;
   }
-#elif defined(__ARM_NEON__)
-  const float32x4_t fillvec = vdupq_n_f32(value);
-  for (int i = 0; i < (int)length - 3; i += 4) {
-    vst1q_f32(ptr + i, fillvec);
+  size_t alignment = 64;
+  if (huge) {
+    alignment = SIMD_HUGE_PAGE_SIZE;
+  } else if (node >= 0) {
+    alignment = SIMD_SMALL_PAGE_SIZE;
   }
-  for (size_t i = (length & ~0x3); i < length; i++) {
-    ptr[i] = value;
+  // Round up to whole pages, so that the advice does not touch the neighbours
+  size_t extent = (size + alignment - 1) & ~(alignment - 1);
+  char *ptr = allocator->allocate(alignment > 64? extent : size, alignment,
+                                  allocator->context);
+  if (ptr == NULL) {
+    return NULL;
   }
-#else
-  for (size_t i = 0; i < length; i++) {
-    ptr[i] = value;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (huge) {
+    madvise(ptr, extent, MADV_HUGEPAGE);
   }
 #endif
+  if (node >= 0) {
+    memory_bind_node(ptr, extent, node);
+  }
+  if (flags & kMemoryFlagFirstTouch) {
+    ThreadPool *pool = thread_pool_default();
+    int tasks = thread_pool_size(pool);
+    size_t step = (size + tasks - 1) / tasks;
+    if (step < FIRST_TOUCH_MIN_LENGTH) {
+      step = FIRST_TOUCH_MIN_LENGTH;
+    }
+    // Every task starts at a page boundary
+    step = (step + SIMD_SMALL_PAGE_SIZE - 1) &
+        ~(size_t)(SIMD_SMALL_PAGE_SIZE - 1);
+    FirstTouchJob job = { ptr, size, step };
+    thread_pool_run(pool, (int)((size + step - 1) / step), 0,
+                    memory_first_touch_task, &job);
+  }
+  return ptr;
 }
 
-float *zeropadding(const float *ptr, size_t length, size_t *newLength) {
-  return zeropaddingex(ptr, length, newLength, 0);
+void free_aligned(void *ptr) {
+  if (ptr == NULL) {
+    return;
+  }
+  const SimdAllocator *allocator = simd_allocator();
+  allocator->release(ptr, allocator->context);
 }
 
-float *zeropaddingex(const float *ptr, size_t length, size_t *newLength,
-                     size_t additionalLength) {
-  size_t nl = length;
-  int log = 2;
-  while (nl >>= 1) {
-    log++;
+typedef struct ArenaChunk {
+  struct ArenaChunk *next;
+  size_t size;
+  size_t used;
+} ArenaChunk;
+
+/// The chunk header is padded so that the payload starts 64-aligned.
+#define ARENA_HEADER_SIZE 64
+#define ARENA_MIN_CHUNK_SIZE 4096
+
+struct SimdArena {
+  /// The chunk the blocks are taken from, the older ones follow it.
+  ArenaChunk *head;
+  /// The sum of the sizes of all the chunks.
+  size_t capacity;
+  /// The offset of the last block in head, to release it on free.
+  size_t last;
+  /// The used size of head before the last block was taken.
+  size_t last_used;
+  SimdAllocator allocator;
+};
+
+static ArenaChunk *arena_chunk_new(size_t size) {
+  ArenaChunk *chunk = system_allocate(ARENA_HEADER_SIZE + size, 64, NULL);
+  if (chunk == NULL) {
+    return NULL;
   }
-  nl = (1 << log);
-  *newLength = nl;
-  float *ret = mallocf(nl + additionalLength);
-  memcpy(ret, ptr, length * sizeof(float));
-  memsetf(ret + length, 0.f, nl - length);
-  return ret;
+  chunk->next = NULL;
+  chunk->size = size;
+  chunk->used = 0;
+  return chunk;
+}
+
+static void arena_free_chunks(ArenaChunk *chunk) {
+  while (chunk != NULL) {
+    ArenaChunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+}
+
+static void *arena_allocate(size_t size, size_t alignment, void *context) {
+  SimdArena *arena = context;
+  assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+  ArenaChunk *chunk = arena->head;
+  uintptr_t payload = (uintptr_t)chunk + ARENA_HEADER_SIZE;
+  size_t offset = ((payload + chunk->used + alignment - 1) & ~(alignment - 1))
+      - payload;
+  if (offset + size > chunk->size) {
+    size_t chunk_size = chunk->size * 2;
+    size_t padding = alignment > ARENA_HEADER_SIZE? alignment : 0;
+    while (chunk_size < size + padding) {
+      chunk_size *= 2;
+    }
+    chunk = arena_chunk_new(chunk_size);
+    if (chunk == NULL) {
+      return NULL;
+    }
+    chunk->next = arena->head;
+    arena->head = chunk;
+    arena->capacity += chunk_size;
+    payload = (uintptr_t)chunk + ARENA_HEADER_SIZE;
+    offset = ((payload + alignment - 1) & ~(alignment - 1)) - payload;
+  }
+  arena->last_used = chunk->used;
+  chunk->used = offset + size;
+  arena->last = offset;
+  return (char *)chunk + ARENA_HEADER_SIZE + offset;
 }
 
-float *rmemcpyf(float *__restrict dest,
-                const float *__restrict src, size_t length) {
-#ifdef __AVX__
-  for (int i = 0; i < (int)length - 7; i += 8) {
-    __m256 vec = _mm256_loadu_ps(src + i);
-    vec = _mm256_permute2f128_ps(vec, vec, 1);
-    vec = _mm256_permute_ps(vec, 0x1B);
-    _mm256_storeu_ps(dest + length - i - 8, vec);
+static void arena_release(void *ptr, void *context) {
+  SimdArena *arena = context;
+  ArenaChunk *chunk = arena->head;
+  if ((char *)ptr == (char *)chunk + ARENA_HEADER_SIZE + arena->last) {
+    chunk->used = arena->last_used;
   }
+}
 
-  for (size_t i = (length & ~0x7); i < length; i++) {
-    dest[length - i - 1] = src[i];
+SimdArena *simd_arena_create(size_t capacity) {
+  if (capacity < ARENA_MIN_CHUNK_SIZE) {
+    capacity = ARENA_MIN_CHUNK_SIZE;
   }
-#elif defined(__ARM_NEON__)
-  for (int i = 0; i < (int)length - 3; i += 4) {
-    float32x4_t vec = vld1q_f32(src + i);
-    vec = vrev64q_f32(vec);
-    vec = vcombine_f32(vget_high_f32(vec), vget_low_f32(vec));
-    vst1q_f32(dest + length - i - 4, vec);
+  SimdArena *arena = malloc(sizeof(SimdArena));
+  if (arena == NULL) {
+    return NULL;
   }
+  arena->head = arena_chunk_new(capacity);
+  if (arena->head == NULL) {
+    free(arena);
+    return NULL;
+  }
+  arena->capacity = capacity;
+  arena->last = 0;
+  arena->last_used = 0;
+  arena->allocator.allocate = arena_allocate;
+  arena->allocator.release = arena_release;
+  arena->allocator.context = arena;
+  return arena;
+}
 
-  for (size_t i = (length & ~0x3); i < length; i++) {
-    dest[length - i - 1] = src[i];
+void simd_arena_reset(SimdArena *arena) {
+  if (arena->head->next != NULL) {
+    ArenaChunk *merged = arena_chunk_new(arena->capacity);
+    if (merged != NULL) {
+      arena_free_chunks(arena->head);
+      arena->head = merged;
+    } else {
+      // Keep the chunks, only the newest one is reused
+      arena_free_chunks(arena->head->next);
+      arena->head->next = NULL;
+      arena->capacity = arena->head->size;
+    }
   }
-#else
-  for (size_t i = 0; i < length; i++) {
-    dest[i] = src[length - i - 1];
+  arena->head->used = 0;
+  arena->last = 0;
+  arena->last_used = 0;
+}
+
+void simd_arena_destroy(SimdArena *arena) {
+  if (arena == NULL) {
+    return;
+  }
+  arena_free_chunks(arena->head);
+  free(arena);
+}
+
+size_t simd_arena_used(const SimdArena *arena) {
+  size_t used = arena->head->used;
+  for (const ArenaChunk *chunk = arena->head->next; chunk != NULL;
+       chunk = chunk->next) {
+    used += chunk->used;
+  }
+  return used;
+}
+
+const SimdAllocator *simd_arena_allocator(SimdArena *arena) {
+  return &arena->allocator;
+}
+
+float *mallocf(size_t length) {
+  return malloc_aligned(length * sizeof(float));
+}
+
+float *mallocf_ex(size_t length, int flags) {
+  return malloc_aligned_ex(length * sizeof(float), flags);
+}
+
+/// The default streaming threshold if the cache size is unknown.
+#define DEFAULT_STREAMING_THRESHOLD (8 * 1024 * 1024)
+
+/// Both are set once by memory_initialize() before main(), so memsetf() and
+/// memcpyf() read them without any synchronization. Nothing is streamed
+/// until then.
+static size_t default_threshold = SIZE_MAX;
+static size_t streaming_threshold = SIZE_MAX;
+
+static void __attribute__((constructor)) memory_initialize(void) {
+  long size = -1;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+  size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+#ifdef _SC_LEVEL2_CACHE_SIZE
+  if (size <= 0) {
+    size = sysconf(_SC_LEVEL2_CACHE_SIZE);
   }
 #endif
-  return dest;
+  default_threshold = size > 0? (size_t)size : DEFAULT_STREAMING_THRESHOLD;
+  streaming_threshold = default_threshold;
+}
+
+size_t memory_streaming_threshold(void) {
+  return streaming_threshold;
+}
+
+void memory_set_streaming_threshold(size_t bytes) {
+  streaming_threshold = bytes == 0? default_threshold : bytes;
 }
 
-float *crmemcpyf(float *__restrict dest,
-                 const float *__restrict src, size_t length) {
-  for (size_t i = 0; i < length; i += 2) {
-    dest[i] = src[length - i - 2];
-    dest[i + 1] = src[length - i - 1];
+float *zeropadding(const float *ptr, size_t length, size_t *newLength) {
+  return zeropaddingex(ptr, length, newLength, 0);
+}
+
+float *zeropaddingex(const float *ptr, size_t length, size_t *newLength,
+                     size_t additionalLength) {
+  // The linear convolution of two such arrays fits without aliasing
+  size_t nl = 1;
+  while (nl + 1 < 2 * length) {
+    nl <<= 1;
   }
-  return dest;
+  *newLength = nl;
+  float *ret = mallocf(nl + additionalLength);
+  memcpy(ret, ptr, length * sizeof(float));
+  memsetf(ret + length, 0.f, nl - length);
+  return ret;
 }
@@ -0,0 +1,709 @@
+/*! @file memory_simd.c
+ *  @brief Memory routines with SIMD optimization, built per instruction set.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+#define LIBSIMD_IMPLEMENTATION
+#include "src/dispatch.h"
+#define memsetf KERNEL(memsetf)
+#define memsetf_stream KERNEL(memsetf_stream)
+#define memcpyf KERNEL(memcpyf)
+#define memcpyf_stream KERNEL(memcpyf_stream)
+#define rmemcpyf KERNEL(rmemcpyf)
+#define crmemcpyf KERNEL(crmemcpyf)
+#define reversef KERNEL(reversef)
+#define creversef KERNEL(creversef)
+#define deinterleavef KERNEL(deinterleavef)
+#define interleavef KERNEL(interleavef)
+#define deinterleave_i16 KERNEL(deinterleave_i16)
+#define interleave_i16 KERNEL(interleave_i16)
+#define deinterleave_i16_to_float KERNEL(deinterleave_i16_to_float)
+#include "inc/simd/memory.h"
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <simd/instruction_set.h>
+
+#ifdef __AVX512F__
+#define STREAM_ALIGNMENT 64
+#else
+#define STREAM_ALIGNMENT 32
+#endif
+
+/// @brief Returns the number of float-s before ptr becomes aligned for the
+/// non-temporal stores, or SIZE_MAX if it never does.
+static size_t stream_head_length(const float *ptr) {
+  uintptr_t addr = (uintptr_t)ptr;
+  if ((addr & (sizeof(float) - 1)) != 0) {
+    return SIZE_MAX;
+  }
+  return ((STREAM_ALIGNMENT - addr % STREAM_ALIGNMENT) % STREAM_ALIGNMENT) /
+      sizeof(float);
+}
+
+void memsetf(float *ptr, float value, size_t length) {
+#ifdef __AVX__
+  if (length * sizeof(float) >= memory_streaming_threshold()) {
+    memsetf_stream(ptr, value, length);
+    return;
+  }
+  const __m256 fillvec = _mm256_set1_ps(value);
+  size_t startIndex = align_complement_f32(ptr);
+  if (startIndex > length) {
+    startIndex = length;
+  }
+
+  for (size_t i = 0; i < startIndex; i++) {
+    ptr[i] = value;
+  }
+
+  for (int i = (int)startIndex; i < (int)length - 7; i += 8) {
+    _mm256_store_ps(ptr + i, fillvec);
+  }
+
+  for (size_t i = startIndex + ((length - startIndex) & ~0x7);
+      i < length; i++) {
+    ptr[i] = value;
+  }
+#elif defined(__ARM_NEON__)
+  const float32x4_t fillvec = vdupq_n_f32(value);
+  for (int i = 0; i < (int)length - 3; i += 4) {
+    vst1q_f32(ptr + i, fillvec);
+  }
+  for (size_t i = (length & ~0x3); i < length; i++) {
+    ptr[i] = value;
+  }
+#else
+  for (size_t i = 0; i < length; i++) {
+    ptr[i] = value;
+  }
+#endif
+}
+
+void memsetf_stream(float *ptr, float value, size_t length) {
+#ifdef __AVX__
+  size_t i = stream_head_length(ptr);
+  if (i > length) {
+    i = length;
+  }
+  for (size_t j = 0; j < i; j++) {
+    ptr[j] = value;
+  }
+#ifdef __AVX512F__
+  const __m512 fillvec = _mm512_set1_ps(value);
+  for (; i + 16 <= length; i += 16) {
+    _mm512_stream_ps(ptr + i, fillvec);
+  }
+#else
+  const __m256 fillvec = _mm256_set1_ps(value);
+  for (; i + 8 <= length; i += 8) {
+    _mm256_stream_ps(ptr + i, fillvec);
+  }
+#endif
+  // The streaming stores are weakly ordered
+  _mm_sfence();
+  for (; i < length; i++) {
+    ptr[i] = value;
+  }
+#else
+  memsetf(ptr, value, length);
+#endif
+}
+
+float *memcpyf(float *__restrict dest,
+               const float *__restrict src, size_t length) {
+#ifdef __AVX__
+  if (length * sizeof(float) >= memory_streaming_threshold()) {
+    return memcpyf_stream(dest, src, length);
+  }
+#endif
+  return memcpy(dest, src, length * sizeof(float));
+}
+
+float *memcpyf_stream(float *__restrict dest,
+                      const float *__restrict src, size_t length) {
+#ifdef __AVX__
+  size_t i = stream_head_length(dest);
+  if (i > length) {
+    i = length;
+  }
+  memcpy(dest, src, i * sizeof(float));
+#ifdef __AVX512F__
+  for (; i + 16 <= length; i += 16) {
+    _mm512_stream_ps(dest + i, _mm512_loadu_ps(src + i));
+  }
+#else
+  for (; i + 8 <= length; i += 8) {
+    _mm256_stream_ps(dest + i, _mm256_loadu_ps(src + i));
+  }
+#endif
+  _mm_sfence();
+  memcpy(dest + i, src + i, (length - i) * sizeof(float));
+  return dest;
+#else
+  return memcpy(dest, src, length * sizeof(float));
+#endif
+}
+
+#ifdef __AVX__
+/// @brief Reverses the order of 8 float-s.
+static __m256 reverse_ps(__m256 vec) {
+  vec = _mm256_permute2f128_ps(vec, vec, 1);
+  return _mm256_permute_ps(vec, 0x1B);
+}
+
+/// @brief Reverses the order of 4 complex numbers.
+static __m256 creverse_ps(__m256 vec) {
+  vec = _mm256_permute2f128_ps(vec, vec, 1);
+  return _mm256_permute_ps(vec, 0x4E);
+}
+#elif defined(__ARM_NEON__)
+/// @brief Reverses the order of 4 float-s.
+static float32x4_t reverse_ps(float32x4_t vec) {
+  vec = vrev64q_f32(vec);
+  return vcombine_f32(vget_high_f32(vec), vget_low_f32(vec));
+}
+
+/// @brief Reverses the order of 2 complex numbers.
+static float32x4_t creverse_ps(float32x4_t vec) {
+  return vcombine_f32(vget_high_f32(vec), vget_low_f32(vec));
+}
+#endif
+
+float *rmemcpyf(float *__restrict dest,
+                const float *__restrict src, size_t length) {
+#ifdef __AVX__
+  for (int i = 0; i < (int)length - 7; i += 8) {
+    __m256 vec = _mm256_loadu_ps(src + i);
+    _mm256_storeu_ps(dest + length - i - 8, reverse_ps(vec));
+  }
+
+  for (size_t i = (length & ~0x7); i < length; i++) {
+    dest[length - i - 1] = src[i];
+  }
+#elif defined(__ARM_NEON__)
+  for (int i = 0; i < (int)length - 3; i += 4) {
+    float32x4_t vec = vld1q_f32(src + i);
+    vst1q_f32(dest + length - i - 4, reverse_ps(vec));
+  }
+
+  for (size_t i = (length & ~0x3); i < length; i++) {
+    dest[length - i - 1] = src[i];
+  }
+#else
+  for (size_t i = 0; i < length; i++) {
+    dest[i] = src[length - i - 1];
+  }
+#endif
+  return dest;
+}
+
+float *crmemcpyf(float *__restrict dest,
+                 const float *__restrict src, size_t length) {
+  assert(length % 2 == 0);
+  size_t i = 0;
+#ifdef __AVX__
+  for (; i + 8 <= length; i += 8) {
+    __m256 vec = _mm256_loadu_ps(src + i);
+    _mm256_storeu_ps(dest + length - i - 8, creverse_ps(vec));
+  }
+#elif defined(__ARM_NEON__)
+  for (; i + 4 <= length; i += 4) {
+    float32x4_t vec = vld1q_f32(src + i);
+    vst1q_f32(dest + length - i - 4, creverse_ps(vec));
+  }
+#endif
+  for (; i < length; i += 2) {
+    dest[length - i - 2] = src[i];
+    dest[length - i - 1] = src[i + 1];
+  }
+  return dest;
+}
+
+void reversef(float *ptr, size_t length) {
+  size_t i = 0;
+  // Swap the blocks from both ends until they meet
+#ifdef __AVX__
+  for (; 2 * i + 16 <= length; i += 8) {
+    __m256 head = _mm256_loadu_ps(ptr + i);
+    __m256 tail = _mm256_loadu_ps(ptr + length - i - 8);
+    _mm256_storeu_ps(ptr + i, reverse_ps(tail));
+    _mm256_storeu_ps(ptr + length - i - 8, reverse_ps(head));
+  }
+#elif defined(__ARM_NEON__)
+  for (; 2 * i + 8 <= length; i += 4) {
+    float32x4_t head = vld1q_f32(ptr + i);
+    float32x4_t tail = vld1q_f32(ptr + length - i - 4);
+    vst1q_f32(ptr + i, reverse_ps(tail));
+    vst1q_f32(ptr + length - i - 4, reverse_ps(head));
+  }
+#endif
+  for (; 2 * i + 1 < length; i++) {
+    float tmp = ptr[i];
+    ptr[i] = ptr[length - i - 1];
+    ptr[length - i - 1] = tmp;
+  }
+}
+
+void creversef(float *ptr, size_t length) {
+  assert(length % 2 == 0);
+  size_t i = 0;
+#ifdef __AVX__
+  for (; 2 * i + 16 <= length; i += 8) {
+    __m256 head = _mm256_loadu_ps(ptr + i);
+    __m256 tail = _mm256_loadu_ps(ptr + length - i - 8);
+    _mm256_storeu_ps(ptr + i, creverse_ps(tail));
+    _mm256_storeu_ps(ptr + length - i - 8, creverse_ps(head));
+  }
+#elif defined(__ARM_NEON__)
+  for (; 2 * i + 8 <= length; i += 4) {
+    float32x4_t head = vld1q_f32(ptr + i);
+    float32x4_t tail = vld1q_f32(ptr + length - i - 4);
+    vst1q_f32(ptr + i, creverse_ps(tail));
+    vst1q_f32(ptr + length - i - 4, creverse_ps(head));
+  }
+#endif
+  for (; 2 * i + 2 < length; i += 2) {
+    float re = ptr[i], im = ptr[i + 1];
+    ptr[i] = ptr[length - i - 2];
+    ptr[i + 1] = ptr[length - i - 1];
+    ptr[length - i - 2] = re;
+    ptr[length - i - 1] = im;
+  }
+}
+
+/*
+ * The (de)interleaving below works on blocks of frames: every 4 channels
+ * of a block are transposed as a 4x4 matrix, the remaining pair of
+ * channels is split with a single shuffle and the odd last channel, if any,
+ * is copied element by element.
+ */
+
+#ifdef __SSE4_1__
+
+#define DEINTERLEAVE_FRAMES_F32 4
+#define DEINTERLEAVE_FRAMES_I16 8
+
+static __m128i load_i32(const int16_t *ptr) {
+  int32_t value;
+  memcpy(&value, ptr, sizeof(value));
+  return _mm_cvtsi32_si128(value);
+}
+
+static void store_i32(int16_t *ptr, __m128i vec) {
+  int32_t value = _mm_cvtsi128_si32(vec);
+  memcpy(ptr, &value, sizeof(value));
+}
+
+/// @brief Stores four pairs of short integers stride elements apart.
+static void store_pairs_i16(int16_t *ptr, int stride, __m128i vec) {
+  store_i32(ptr, vec);
+  store_i32(ptr + stride, _mm_srli_si128(vec, 4));
+  store_i32(ptr + 2 * stride, _mm_srli_si128(vec, 8));
+  store_i32(ptr + 3 * stride, _mm_srli_si128(vec, 12));
+}
+
+/// @brief Transposes the matrix of 4x4 32-bit elements.
+static void transpose_epi32(__m128i *rows) {
+  __m128 r0 = _mm_castsi128_ps(rows[0]), r1 = _mm_castsi128_ps(rows[1]);
+  __m128 r2 = _mm_castsi128_ps(rows[2]), r3 = _mm_castsi128_ps(rows[3]);
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+  rows[0] = _mm_castps_si128(r0);
+  rows[1] = _mm_castps_si128(r1);
+  rows[2] = _mm_castps_si128(r2);
+  rows[3] = _mm_castps_si128(r3);
+}
+
+/// @brief Writes 8 samples of a planar channel, either the short integers
+/// as is or converted to floating point numbers if f32 is not NULL.
+static void store_row_i16(__m128i row, int16_t *i16, float *f32,
+                          size_t offset) {
+  if (f32 == NULL) {
+    _mm_storeu_si128((__m128i *)(i16 + offset), row);
+    return;
+  }
+  _mm_storeu_ps(f32 + offset, _mm_cvtepi32_ps(_mm_cvtepi16_epi32(row)));
+  _mm_storeu_ps(f32 + offset + 4, _mm_cvtepi32_ps(
+      _mm_cvtepi16_epi32(_mm_srli_si128(row, 8))));
+}
+
+#elif defined(__ARM_NEON__)
+
+#define DEINTERLEAVE_FRAMES_F32 4
+#define DEINTERLEAVE_FRAMES_I16 4
+
+/// @brief Transposes the matrix of 4x4 floating point numbers.
+static void transpose_f32(float32x4_t *rows) {
+  float32x4x2_t t0 = vtrnq_f32(rows[0], rows[1]);
+  float32x4x2_t t1 = vtrnq_f32(rows[2], rows[3]);
+  rows[0] = vcombine_f32(vget_low_f32(t0.val[0]), vget_low_f32(t1.val[0]));
+  rows[1] = vcombine_f32(vget_low_f32(t0.val[1]), vget_low_f32(t1.val[1]));
+  rows[2] = vcombine_f32(vget_high_f32(t0.val[0]), vget_high_f32(t1.val[0]));
+  rows[3] = vcombine_f32(vget_high_f32(t0.val[1]), vget_high_f32(t1.val[1]));
+}
+
+/// @brief Transposes the matrix of 4x4 short integers.
+static void transpose_s16(int16x4_t *rows) {
+  int16x4x2_t t0 = vtrn_s16(rows[0], rows[1]);
+  int16x4x2_t t1 = vtrn_s16(rows[2], rows[3]);
+  int32x2x2_t u0 = vtrn_s32(vreinterpret_s32_s16(t0.val[0]),
+                            vreinterpret_s32_s16(t1.val[0]));
+  int32x2x2_t u1 = vtrn_s32(vreinterpret_s32_s16(t0.val[1]),
+                            vreinterpret_s32_s16(t1.val[1]));
+  rows[0] = vreinterpret_s16_s32(u0.val[0]);
+  rows[1] = vreinterpret_s16_s32(u1.val[0]);
+  rows[2] = vreinterpret_s16_s32(u0.val[1]);
+  rows[3] = vreinterpret_s16_s32(u1.val[1]);
+}
+
+/// @brief Loads two pairs of short integers which are stride elements apart.
+static int16x4_t load_pairs_s16(const int16_t *ptr, int stride) {
+  int32_t lo, hi;
+  memcpy(&lo, ptr, sizeof(lo));
+  memcpy(&hi, ptr + stride, sizeof(hi));
+  return vreinterpret_s16_s32(vset_lane_s32(hi, vdup_n_s32(lo), 1));
+}
+
+/// @brief Stores two pairs of short integers stride elements apart.
+static void store_pairs_s16(int16_t *ptr, int stride, int16x4_t vec) {
+  int32_t lo = vget_lane_s32(vreinterpret_s32_s16(vec), 0);
+  int32_t hi = vget_lane_s32(vreinterpret_s32_s16(vec), 1);
+  memcpy(ptr, &lo, sizeof(lo));
+  memcpy(ptr + stride, &hi, sizeof(hi));
+}
+
+/// @brief Writes 4 samples of a planar channel, see the SSE version.
+static void store_row_i16(int16x4_t row, int16_t *i16, float *f32,
+                          size_t offset) {
+  if (f32 == NULL) {
+    vst1_s16(i16 + offset, row);
+    return;
+  }
+  vst1q_f32(f32 + offset, vcvtq_f32_s32(vmovl_s16(row)));
+}
+
+#endif
+
+void deinterleavef(const float *__restrict src, size_t frames, int channels,
+                   float *__restrict dest) {
+  assert(channels > 0);
+  size_t i = 0;
+#if defined(__SSE4_1__) || defined(__ARM_NEON__)
+  for (; i + DEINTERLEAVE_FRAMES_F32 <= frames;
+       i += DEINTERLEAVE_FRAMES_F32) {
+    const float *block = src + i * channels;
+    int c = 0;
+    for (; c + 4 <= channels; c += 4) {
+#ifdef __SSE4_1__
+      __m128 r0 = _mm_loadu_ps(block + c);
+      __m128 r1 = _mm_loadu_ps(block + channels + c);
+      __m128 r2 = _mm_loadu_ps(block + 2 * channels + c);
+      __m128 r3 = _mm_loadu_ps(block + 3 * channels + c);
+      _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+      _mm_storeu_ps(dest + c * frames + i, r0);
+      _mm_storeu_ps(dest + (c + 1) * frames + i, r1);
+      _mm_storeu_ps(dest + (c + 2) * frames + i, r2);
+      _mm_storeu_ps(dest + (c + 3) * frames + i, r3);
+#else
+      float32x4_t rows[4];
+      for (int k = 0; k < 4; k++) {
+        rows[k] = vld1q_f32(block + k * channels + c);
+      }
+      transpose_f32(rows);
+      for (int k = 0; k < 4; k++) {
+        vst1q_f32(dest + (c + k) * frames + i, rows[k]);
+      }
+#endif
+    }
+    if (c + 2 <= channels) {
+#ifdef __SSE4_1__
+      __m128 p0 = _mm_loadh_pi(
+          _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)(block + c)),
+          (const __m64 *)(block + channels + c));
+      __m128 p1 = _mm_loadh_pi(
+          _mm_loadl_pi(_mm_setzero_ps(),
+                       (const __m64 *)(block + 2 * channels + c)),
+          (const __m64 *)(block + 3 * channels + c));
+      _mm_storeu_ps(dest + c * frames + i, _mm_shuffle_ps(p0, p1, 0x88));
+      _mm_storeu_ps(dest + (c + 1) * frames + i,
+                    _mm_shuffle_ps(p0, p1, 0xDD));
+#else
+      float32x4_t p0 = vcombine_f32(vld1_f32(block + c),
+                                    vld1_f32(block + channels + c));
+      float32x4_t p1 = vcombine_f32(vld1_f32(block + 2 * channels + c),
+                                    vld1_f32(block + 3 * channels + c));
+      float32x4x2_t split = vuzpq_f32(p0, p1);
+      vst1q_f32(dest + c * frames + i, split.val[0]);
+      vst1q_f32(dest + (c + 1) * frames + i, split.val[1]);
+#endif
+      c += 2;
+    }
+    if (c < channels) {
+      for (int k = 0; k < DEINTERLEAVE_FRAMES_F32; k++) {
+        dest[c * frames + i + k] = block[k * channels + c];
+      }
+    }
+  }
+#endif
+  for (; i < frames; i++) {
+    for (int c = 0; c < channels; c++) {
+      dest[c * frames + i] = src[i * channels + c];
+    }
+  }
+}
+
+void interleavef(const float *__restrict src, size_t frames, int channels,
+                 float *__restrict dest) {
+  assert(channels > 0);
+  size_t i = 0;
+#if defined(__SSE4_1__) || defined(__ARM_NEON__)
+  for (; i + DEINTERLEAVE_FRAMES_F32 <= frames;
+       i += DEINTERLEAVE_FRAMES_F32) {
+    float *block = dest + i * channels;
+    int c = 0;
+    for (; c + 4 <= channels; c += 4) {
+#ifdef __SSE4_1__
+      __m128 r0 = _mm_loadu_ps(src + c * frames + i);
+      __m128 r1 = _mm_loadu_ps(src + (c + 1) * frames + i);
+      __m128 r2 = _mm_loadu_ps(src + (c + 2) * frames + i);
+      __m128 r3 = _mm_loadu_ps(src + (c + 3) * frames + i);
+      _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+      _mm_storeu_ps(block + c, r0);
+      _mm_storeu_ps(block + channels + c, r1);
+      _mm_storeu_ps(block + 2 * channels + c, r2);
+      _mm_storeu_ps(block + 3 * channels + c, r3);
+#else
+      float32x4_t rows[4];
+      for (int k = 0; k < 4; k++) {
+        rows[k] = vld1q_f32(src + (c + k) * frames + i);
+      }
+      transpose_f32(rows);
+      for (int k = 0; k < 4; k++) {
+        vst1q_f32(block + k * channels + c, rows[k]);
+      }
+#endif
+    }
+    if (c + 2 <= channels) {
+#ifdef __SSE4_1__
+      __m128 a = _mm_loadu_ps(src + c * frames + i);
+      __m128 b = _mm_loadu_ps(src + (c + 1) * frames + i);
+      __m128 lo = _mm_unpacklo_ps(a, b), hi = _mm_unpackhi_ps(a, b);
+      _mm_storel_pi((__m64 *)(block + c), lo);
+      _mm_storeh_pi((__m64 *)(block + channels + c), lo);
+      _mm_storel_pi((__m64 *)(block + 2 * channels + c), hi);
+      _mm_storeh_pi((__m64 *)(block + 3 * channels + c), hi);
+#else
+      float32x4x2_t merged = vzipq_f32(vld1q_f32(src + c * frames + i),
+                                       vld1q_f32(src + (c + 1) * frames + i));
+      vst1_f32(block + c, vget_low_f32(merged.val[0]));
+      vst1_f32(block + channels + c, vget_high_f32(merged.val[0]));
+      vst1_f32(block + 2 * channels + c, vget_low_f32(merged.val[1]));
+      vst1_f32(block + 3 * channels + c, vget_high_f32(merged.val[1]));
+#endif
+      c += 2;
+    }
+    if (c < channels) {
+      for (int k = 0; k < DEINTERLEAVE_FRAMES_F32; k++) {
+        block[k * channels + c] = src[c * frames + i + k];
+      }
+    }
+  }
+#endif
+  for (; i < frames; i++) {
+    for (int c = 0; c < channels; c++) {
+      dest[i * channels + c] = src[c * frames + i];
+    }
+  }
+}
+
+/// @brief Splits the interleaved short integers into planar channels which
+/// are written to i16 or, if it is NULL, converted and written to f32.
+static void deinterleave_i16_rows(const int16_t *__restrict src,
+                                  size_t frames, int channels,
+                                  int16_t *__restrict i16,
+                                  float *__restrict f32) {
+  assert(channels > 0);
+  size_t i = 0;
+#ifdef __SSE4_1__
+  const __m128i split = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13,
+                                      2, 3, 6, 7, 10, 11, 14, 15);
+#endif
+#if defined(__SSE4_1__) || defined(__ARM_NEON__)
+  for (; i + DEINTERLEAVE_FRAMES_I16 <= frames;
+       i += DEINTERLEAVE_FRAMES_I16) {
+    const int16_t *block = src + i * channels;
+    int c = 0;
+    for (; c + 4 <= channels; c += 4) {
+#ifdef __SSE4_1__
+      // Each row holds 2 frames, the samples of every channel become
+      // adjacent 32-bit elements and the 4x4 transposition finishes the job
+      __m128i rows[4];
+      for (int k = 0; k < 4; k++) {
+        __m128i two = _mm_unpacklo_epi64(
+            _mm_loadl_epi64((const __m128i *)(block + 2 * k * channels + c)),
+            _mm_loadl_epi64(
+                (const __m128i *)(block + (2 * k + 1) * channels + c)));
+        rows[k] = _mm_unpacklo_epi16(two, _mm_srli_si128(two, 8));
+      }
+      transpose_epi32(rows);
+#else
+      int16x4_t rows[4];
+      for (int k = 0; k < 4; k++) {
+        rows[k] = vld1_s16(block + k * channels + c);
+      }
+      transpose_s16(rows);
+#endif
+      for (int k = 0; k < 4; k++) {
+        store_row_i16(rows[k], i16, f32, (c + k) * frames + i);
+      }
+    }
+    if (c + 2 <= channels) {
+#ifdef __SSE4_1__
+      __m128i p[2];
+      for (int k = 0; k < 2; k++) {
+        const int16_t *ptr = block + 4 * k * channels + c;
+        __m128i lo = _mm_unpacklo_epi32(load_i32(ptr),
+                                        load_i32(ptr + channels));
+        __m128i hi = _mm_unpacklo_epi32(load_i32(ptr + 2 * channels),
+                                        load_i32(ptr + 3 * channels));
+        p[k] = _mm_shuffle_epi8(_mm_unpacklo_epi64(lo, hi), split);
+      }
+      store_row_i16(_mm_unpacklo_epi64(p[0], p[1]), i16, f32,
+                    c * frames + i);
+      store_row_i16(_mm_unpackhi_epi64(p[0], p[1]), i16, f32,
+                    (c + 1) * frames + i);
+#else
+      int16x4x2_t pairs = vuzp_s16(
+          load_pairs_s16(block + c, channels),
+          load_pairs_s16(block + 2 * channels + c, channels));
+      store_row_i16(pairs.val[0], i16, f32, c * frames + i);
+      store_row_i16(pairs.val[1], i16, f32, (c + 1) * frames + i);
+#endif
+      c += 2;
+    }
+    if (c < channels) {
+      for (int k = 0; k < DEINTERLEAVE_FRAMES_I16; k++) {
+        int16_t value = block[k * channels + c];
+        if (f32 == NULL) {
+          i16[c * frames + i + k] = value;
+        } else {
+          f32[c * frames + i + k] = value;
+        }
+      }
+    }
+  }
+#endif
+  for (; i < frames; i++) {
+    for (int c = 0; c < channels; c++) {
+      int16_t value = src[i * channels + c];
+      if (f32 == NULL) {
+        i16[c * frames + i] = value;
+      } else {
+        f32[c * frames + i] = value;
+      }
+    }
+  }
+}
+
+void deinterleave_i16(const int16_t *__restrict src, size_t frames,
+                      int channels, int16_t *__restrict dest) {
+  deinterleave_i16_rows(src, frames, channels, dest, NULL);
+}
+
+void deinterleave_i16_to_float(const int16_t *__restrict src, size_t frames,
+                               int channels, float *__restrict dest) {
+  deinterleave_i16_rows(src, frames, channels, NULL, dest);
+}
+
+void interleave_i16(const int16_t *__restrict src, size_t frames,
+                    int channels, int16_t *__restrict dest) {
+  assert(channels > 0);
+  size_t i = 0;
+#ifdef __SSE4_1__
+  const __m128i merge = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13,
+                                      2, 3, 6, 7, 10, 11, 14, 15);
+#endif
+#if defined(__SSE4_1__) || defined(__ARM_NEON__)
+  for (; i + DEINTERLEAVE_FRAMES_I16 <= frames;
+       i += DEINTERLEAVE_FRAMES_I16) {
+    int16_t *block = dest + i * channels;
+    int c = 0;
+    for (; c + 4 <= channels; c += 4) {
+#ifdef __SSE4_1__
+      __m128i rows[4];
+      for (int k = 0; k < 4; k++) {
+        rows[k] = _mm_loadu_si128(
+            (const __m128i *)(src + (c + k) * frames + i));
+      }
+      transpose_epi32(rows);
+      for (int k = 0; k < 4; k++) {
+        __m128i two = _mm_shuffle_epi8(rows[k], merge);
+        _mm_storel_epi64((__m128i *)(block + 2 * k * channels + c), two);
+        _mm_storel_epi64((__m128i *)(block + (2 * k + 1) * channels + c),
+                         _mm_srli_si128(two, 8));
+      }
+#else
+      int16x4_t rows[4];
+      for (int k = 0; k < 4; k++) {
+        rows[k] = vld1_s16(src + (c + k) * frames + i);
+      }
+      transpose_s16(rows);
+      for (int k = 0; k < 4; k++) {
+        vst1_s16(block + k * channels + c, rows[k]);
+      }
+#endif
+    }
+    if (c + 2 <= channels) {
+#ifdef __SSE4_1__
+      __m128i a = _mm_loadu_si128((const __m128i *)(src + c * frames + i));
+      __m128i b = _mm_loadu_si128(
+          (const __m128i *)(src + (c + 1) * frames + i));
+      store_pairs_i16(block + c, channels, _mm_unpacklo_epi16(a, b));
+      store_pairs_i16(block + 4 * channels + c, channels,
+                      _mm_unpackhi_epi16(a, b));
+#else
+      int16x4x2_t merged = vzip_s16(vld1_s16(src + c * frames + i),
+                                    vld1_s16(src + (c + 1) * frames + i));
+      store_pairs_s16(block + c, channels, merged.val[0]);
+      store_pairs_s16(block + 2 * channels + c, channels, merged.val[1]);
+#endif
+      c += 2;
+    }
+    if (c < channels) {
+      for (int k = 0; k < DEINTERLEAVE_FRAMES_I16; k++) {
+        block[k * channels + c] = src[c * frames + i + k];
+      }
+    }
+  }
+#endif
+  for (; i < frames; i++) {
+    for (int c = 0; c < channels; c++) {
+      dest[i * channels + c] = src[c * frames + i];
+    }
+  }
+}
@@ -29,11 +29,36 @@
  */
 
 #define IMPLEMENTATION
+#include "src/dispatch.h"
+#define normalize2D KERNEL(normalize2D)
+#define minmax2D KERNEL(minmax2D)
+#define normalize2D_minmax KERNEL(normalize2D_minmax)
+#define minmax1D KERNEL(minmax1D)
+#define normalize2D_stream KERNEL(normalize2D_stream)
+#define normalize2D_parallel KERNEL(normalize2D_parallel)
+#define minmax2D_uint16 KERNEL(minmax2D_uint16)
+#define minmax2D_float KERNEL(minmax2D_float)
+#define normalize2D_uint8 KERNEL(normalize2D_uint8)
+#define normalize2D_uint16 KERNEL(normalize2D_uint16)
+#define normalize2D_uint16_minmax KERNEL(normalize2D_uint16_minmax)
+#define normalize2D_float KERNEL(normalize2D_float)
+#define normalize2D_float_minmax KERNEL(normalize2D_float_minmax)
+#define meanstd1D KERNEL(meanstd1D)
+#define meanstd2D KERNEL(meanstd2D)
+#define normalize1D_zscore KERNEL(normalize1D_zscore)
+#define normalize2D_zscore KERNEL(normalize2D_zscore)
+#define meanstd_channels KERNEL(meanstd_channels)
+#define normalize_zscore_channels KERNEL(normalize_zscore_channels)
 #include "inc/simd/normalize.h"
 #include <assert.h>
 #include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <simd/arithmetic.h>
 #include <simd/instruction_set.h>
 #include <simd/memory.h>
+#include "src/dot_product.h"
 
 #ifdef __ARM_NEON__
 
@@ -42,7 +67,9 @@ static void normalize2D_minmax_neon(uint8_t min, uint8_t max,
                                     int width, int height,
                                     float* dst, int dst_stride) {
   if (max == min) {
-    memsetf(dst, 0, width * height);
+    for (int y = 0; y < height; y++) {
+      memsetf(dst + y * dst_stride, 0, width);
+    }
     return;
   }
   const uint8x16_t min_vec = vdupq_n_u8(min);
@@ -52,7 +79,7 @@ static void normalize2D_minmax_neon(uint8_t min, uint8_t max,
   for (int y = 0; y < height; y++) {
     for (int x = 0; x < width - 15; x += 16) {
       uint8x16_t vec = vld1q_u8(src + y * src_stride + x);
-      vec = vsubq_u8(vec, min_vec);
+      vec = vqsubq_u8(vec, min_vec);
       uint8x8_t vec8lo = vget_low_u8(vec);
       uint8x8_t vec8hi = vget_high_u8(vec);
       uint16x8_t vec16lo = vmovl_u8(vec8lo);
@@ -125,6 +152,15 @@ static void minmax2D_neon(const uint8_t* src, int src_stride,
     }
   }
   // Gather the results
+#ifdef __aarch64__
+  uint8_t vmin = vminvq_u8(min_vec), vmax = vmaxvq_u8(max_vec);
+  if (vmin < min) {
+    min = vmin;
+  }
+  if (vmax > max) {
+    max = vmax;
+  }
+#else
   uint8_t min_arr[16] __attribute__((aligned(64))),
       max_arr[16] __attribute__((aligned(64)));
   if (min_ptr) {
@@ -143,6 +179,7 @@ static void minmax2D_neon(const uint8_t* src, int src_stride,
       max = val;
     }
   }
+#endif
 
   if (min_ptr) {
     *min_ptr = min;
@@ -176,6 +213,15 @@ static void minmax1D_neon(const float* src, int length,
   }
 
   // Gather the results
+#ifdef __aarch64__
+  float vmin = vminvq_f32(min_vec), vmax = vmaxvq_f32(max_vec);
+  if (vmin < min) {
+    min = vmin;
+  }
+  if (vmax > max) {
+    max = vmax;
+  }
+#else
   float min_arr[4] __attribute__((aligned(64))),
       max_arr[4] __attribute__((aligned(64)));
   if (min_ptr) {
@@ -194,6 +240,7 @@ static void minmax1D_neon(const float* src, int length,
       max = val;
     }
   }
+#endif
 
   if (min_ptr) {
     *min_ptr = min;
@@ -208,12 +255,15 @@ static void minmax1D_neon(const float* src, int length,
 
 #ifdef __SSE2__
 
+#if !defined(__AVX512BW__) && !defined(__AVX2__)
 static void normalize2D_minmax_sse(uint8_t min, uint8_t max,
                                    const uint8_t* src, int src_stride,
                                    int width, int height,
                                    float* dst, int dst_stride) {
   if (max == min) {
-    memsetf(dst, 0, width * height);
+    for (int y = 0; y < height; y++) {
+      memsetf(dst + y * dst_stride, 0, width);
+    }
     return;
   }
   const __m128i min_vec = _mm_set1_epi8(min);
@@ -318,8 +368,9 @@ static void minmax2D_sse(const uint8_t* src, int src_stride,
     *max_ptr = max;
   }
 }
+#endif  // !__AVX512BW__ && !__AVX2__
 
-#ifdef __AVX__
+#if defined(__AVX__) && !defined(__AVX512F__)
 static void minmax1D_avx(const float* src, int length,
                          float* min_ptr, float* max_ptr) {
   assert(length > 0);
@@ -375,7 +426,251 @@ static void minmax1D_avx(const float* src, int length,
     *max_ptr = max;
   }
 }
-#endif  // __AVX__
+#endif  // __AVX__ && !__AVX512F__
+
+#ifdef __AVX2__
+
+/// @brief Reduces the accumulated vectors of bytes to the scalars.
+INLINE void normalize_reduce_epu8(__m128i min_vec, __m128i max_vec,
+                                  uint8_t *min, uint8_t *max) {
+  uint8_t min_arr[16] __attribute__((aligned(16))),
+      max_arr[16] __attribute__((aligned(16)));
+  _mm_store_si128((__m128i*)min_arr, min_vec);
+  _mm_store_si128((__m128i*)max_arr, max_vec);
+  for (int i = 0; i < 16; i++) {
+    if (min_arr[i] < *min) {
+      *min = min_arr[i];
+    }
+    if (max_arr[i] > *max) {
+      *max = max_arr[i];
+    }
+  }
+}
+
+#ifndef __AVX512BW__
+static void normalize2D_minmax_avx2(uint8_t min, uint8_t max,
+                                    const uint8_t* src, int src_stride,
+                                    int width, int height,
+                                    float* dst, int dst_stride) {
+  if (max == min) {
+    for (int y = 0; y < height; y++) {
+      memsetf(dst + y * dst_stride, 0, width);
+    }
+    return;
+  }
+  const __m128i min_vec = _mm_set1_epi8(min);
+  float diff = (max - min) / 2.f;
+  const __m256 diff_vec = _mm256_set1_ps(1.f / diff);
+  const __m256 sub_vec = _mm256_set1_ps(1.f);
+  for (int y = 0; y < height; y++) {
+    const uint8_t *src_row = src + y * src_stride;
+    float *dst_row = dst + y * dst_stride;
+    int x = 0;
+    for (; x < width - 15; x += 16) {
+      __m128i vec = _mm_loadu_si128((const __m128i*)(src_row + x));
+      vec = _mm_subs_epu8(vec, min_vec);
+      __m256 flo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(vec));
+      __m256 fhi = _mm256_cvtepi32_ps(
+          _mm256_cvtepu8_epi32(_mm_srli_si128(vec, 8)));
+      _mm256_storeu_ps(dst_row + x, _mm256_fmsub_ps(flo, diff_vec, sub_vec));
+      _mm256_storeu_ps(dst_row + x + 8,
+                       _mm256_fmsub_ps(fhi, diff_vec, sub_vec));
+    }
+    for (; x < width; x++) {
+      dst_row[x] = (src_row[x] - min) / diff - 1.0f;
+    }
+  }
+}
+
+static void minmax2D_avx2(const uint8_t* src, int src_stride,
+                          int width, int height,
+                          uint8_t* min_ptr, uint8_t* max_ptr) {
+  uint8_t min = src[0], max = src[0];
+  // Two pairs of accumulators hide the latency of vpminub/vpmaxub
+  __m256i min1 = _mm256_set1_epi8(min), max1 = _mm256_set1_epi8(max);
+  __m256i min2 = min1, max2 = max1;
+  for (int y = 0; y < height; y++) {
+    const uint8_t *row = src + y * src_stride;
+    int x = 0;
+    for (; x < width - 63; x += 64) {
+      __m256i vec1 = _mm256_loadu_si256((const __m256i*)(row + x));
+      __m256i vec2 = _mm256_loadu_si256((const __m256i*)(row + x + 32));
+      min1 = _mm256_min_epu8(vec1, min1);
+      max1 = _mm256_max_epu8(vec1, max1);
+      min2 = _mm256_min_epu8(vec2, min2);
+      max2 = _mm256_max_epu8(vec2, max2);
+    }
+    for (; x < width - 31; x += 32) {
+      __m256i vec = _mm256_loadu_si256((const __m256i*)(row + x));
+      min1 = _mm256_min_epu8(vec, min1);
+      max1 = _mm256_max_epu8(vec, max1);
+    }
+    for (; x < width; x++) {
+      if (row[x] < min) {
+        min = row[x];
+      }
+      if (row[x] > max) {
+        max = row[x];
+      }
+    }
+  }
+  min1 = _mm256_min_epu8(min1, min2);
+  max1 = _mm256_max_epu8(max1, max2);
+  normalize_reduce_epu8(
+      _mm_min_epu8(_mm256_castsi256_si128(min1),
+                   _mm256_extracti128_si256(min1, 1)),
+      _mm_max_epu8(_mm256_castsi256_si128(max1),
+                   _mm256_extracti128_si256(max1, 1)),
+      &min, &max);
+  if (min_ptr) {
+    *min_ptr = min;
+  }
+  if (max_ptr) {
+    *max_ptr = max;
+  }
+}
+#endif  // !__AVX512BW__
+
+#endif  // __AVX2__
+
+#ifdef __AVX512BW__
+
+static void normalize2D_minmax_avx512(uint8_t min, uint8_t max,
+                                      const uint8_t* src, int src_stride,
+                                      int width, int height,
+                                      float* dst, int dst_stride) {
+  if (max == min) {
+    for (int y = 0; y < height; y++) {
+      memsetf(dst + y * dst_stride, 0, width);
+    }
+    return;
+  }
+  const __m512i min_vec = _mm512_set1_epi8(min);
+  float diff = (max - min) / 2.f;
+  const __m512 diff_vec = _mm512_set1_ps(1.f / diff);
+  const __m512 sub_vec = _mm512_set1_ps(1.f);
+  for (int y = 0; y < height; y++) {
+    const uint8_t *src_row = src + y * src_stride;
+    float *dst_row = dst + y * dst_stride;
+    int x = 0;
+    for (; x < width - 63; x += 64) {
+      __m512i vec = _mm512_subs_epu8(_mm512_loadu_si512(src_row + x),
+                                     min_vec);
+      __m512 f0 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(
+          _mm512_castsi512_si128(vec)));
+      __m512 f1 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(
+          _mm512_extracti32x4_epi32(vec, 1)));
+      __m512 f2 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(
+          _mm512_extracti32x4_epi32(vec, 2)));
+      __m512 f3 = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(
+          _mm512_extracti32x4_epi32(vec, 3)));
+      _mm512_storeu_ps(dst_row + x, _mm512_fmsub_ps(f0, diff_vec, sub_vec));
+      _mm512_storeu_ps(dst_row + x + 16,
+                       _mm512_fmsub_ps(f1, diff_vec, sub_vec));
+      _mm512_storeu_ps(dst_row + x + 32,
+                       _mm512_fmsub_ps(f2, diff_vec, sub_vec));
+      _mm512_storeu_ps(dst_row + x + 48,
+                       _mm512_fmsub_ps(f3, diff_vec, sub_vec));
+    }
+    for (; x < width - 15; x += 16) {
+      __m128i vec = _mm_subs_epu8(
+          _mm_loadu_si128((const __m128i*)(src_row + x)),
+          _mm512_castsi512_si128(min_vec));
+      __m512 f = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(vec));
+      _mm512_storeu_ps(dst_row + x, _mm512_fmsub_ps(f, diff_vec, sub_vec));
+    }
+    for (; x < width; x++) {
+      dst_row[x] = (src_row[x] - min) / diff - 1.0f;
+    }
+  }
+}
+
+static void minmax2D_avx512(const uint8_t* src, int src_stride,
+                            int width, int height,
+                            uint8_t* min_ptr, uint8_t* max_ptr) {
+  uint8_t min = src[0], max = src[0];
+  __m512i min1 = _mm512_set1_epi8(min), max1 = _mm512_set1_epi8(max);
+  __m512i min2 = min1, max2 = max1;
+  for (int y = 0; y < height; y++) {
+    const uint8_t *row = src + y * src_stride;
+    int x = 0;
+    for (; x < width - 127; x += 128) {
+      __m512i vec1 = _mm512_loadu_si512(row + x);
+      __m512i vec2 = _mm512_loadu_si512(row + x + 64);
+      min1 = _mm512_min_epu8(vec1, min1);
+      max1 = _mm512_max_epu8(vec1, max1);
+      min2 = _mm512_min_epu8(vec2, min2);
+      max2 = _mm512_max_epu8(vec2, max2);
+    }
+    for (; x < width - 63; x += 64) {
+      __m512i vec = _mm512_loadu_si512(row + x);
+      min1 = _mm512_min_epu8(vec, min1);
+      max1 = _mm512_max_epu8(vec, max1);
+    }
+    if (x < width) {
+      // The masked load does not touch the bytes past the row
+      __mmask64 mask = ~0ULL >> (64 - (width - x));
+      __m512i vec = _mm512_maskz_loadu_epi8(mask, row + x);
+      min1 = _mm512_mask_min_epu8(min1, mask, vec, min1);
+      max1 = _mm512_mask_max_epu8(max1, mask, vec, max1);
+    }
+  }
+  min1 = _mm512_min_epu8(min1, min2);
+  max1 = _mm512_max_epu8(max1, max2);
+  __m256i min256 = _mm256_min_epu8(_mm512_castsi512_si256(min1),
+                                   _mm512_extracti64x4_epi64(min1, 1));
+  __m256i max256 = _mm256_max_epu8(_mm512_castsi512_si256(max1),
+                                   _mm512_extracti64x4_epi64(max1, 1));
+  normalize_reduce_epu8(
+      _mm_min_epu8(_mm256_castsi256_si128(min256),
+                   _mm256_extracti128_si256(min256, 1)),
+      _mm_max_epu8(_mm256_castsi256_si128(max256),
+                   _mm256_extracti128_si256(max256, 1)),
+      &min, &max);
+  if (min_ptr) {
+    *min_ptr = min;
+  }
+  if (max_ptr) {
+    *max_ptr = max;
+  }
+}
+
+#endif  // __AVX512BW__
+
+#ifdef __AVX512F__
+static void minmax1D_avx512(const float* src, int length,
+                            float* min_ptr, float* max_ptr) {
+  __m512 min1 = _mm512_set1_ps(src[0]), max1 = min1;
+  __m512 min2 = min1, max2 = max1;
+  int i = 0;
+  for (; i < length - 31; i += 32) {
+    __m512 vec1 = _mm512_loadu_ps(src + i);
+    __m512 vec2 = _mm512_loadu_ps(src + i + 16);
+    min1 = _mm512_min_ps(vec1, min1);
+    max1 = _mm512_max_ps(vec1, max1);
+    min2 = _mm512_min_ps(vec2, min2);
+    max2 = _mm512_max_ps(vec2, max2);
+  }
+  if (i < length - 15) {
+    __m512 vec = _mm512_loadu_ps(src + i);
+    min1 = _mm512_min_ps(vec, min1);
+    max1 = _mm512_max_ps(vec, max1);
+    i += 16;
+  }
+  if (i < length) {
+    __mmask16 mask = 0xFFFF >> (16 - (length - i));
+    __m512 vec = _mm512_maskz_loadu_ps(mask, src + i);
+    min1 = _mm512_mask_min_ps(min1, mask, vec, min1);
+    max1 = _mm512_mask_max_ps(max1, mask, vec, max1);
+  }
+  if (min_ptr) {
+    *min_ptr = _mm512_reduce_min_ps(_mm512_min_ps(min1, min2));
+  }
+  if (max_ptr) {
+    *max_ptr = _mm512_reduce_max_ps(_mm512_max_ps(max1, max2));
+  }
+}
+#endif  // __AVX512F__
 
 #endif  // __SSE2__
 
@@ -463,6 +758,12 @@ void minmax2D(int simd, const uint8_t* src, int src_stride,
 #ifdef __ARM_NEON__
     minmax2D_neon(src, src_stride, width, height, min, max);
   } else {
+#elif defined(__AVX512BW__)
+    minmax2D_avx512(src, src_stride, width, height, min, max);
+  } else {
+#elif defined(__AVX2__)
+    minmax2D_avx2(src, src_stride, width, height, min, max);
+  } else {
 #elif defined(__SSE2__)
     minmax2D_sse(src, src_stride, width, height, min, max);
   } else {
@@ -488,6 +789,14 @@ void normalize2D_minmax(int simd, uint8_t min, uint8_t max,
     normalize2D_minmax_neon(min, max, src, src_stride, width, height,
                             dst, dst_stride);
   } else {
+#elif defined(__AVX512BW__)
+    normalize2D_minmax_avx512(min, max, src, src_stride, width, height,
+                              dst, dst_stride);
+  } else {
+#elif defined(__AVX2__)
+    normalize2D_minmax_avx2(min, max, src, src_stride, width, height,
+                            dst, dst_stride);
+  } else {
 #elif defined(__SSE2__)
     normalize2D_minmax_sse(min, max, src, src_stride, width, height,
                            dst, dst_stride);
@@ -510,7 +819,10 @@ void minmax1D(int simd, const float *src, int length, float *min, float *max) {
 #ifdef __ARM_NEON__
     minmax1D_neon(src, length, min, max);
   } else {
-#elif defined(__SSE2__)
+#elif defined(__AVX512F__)
+    minmax1D_avx512(src, length, min, max);
+  } else {
+#elif defined(__AVX__)
     minmax1D_avx(src, length, min, max);
   } else {
 #else
@@ -519,3 +831,751 @@ void minmax1D(int simd, const float *src, int length, float *min, float *max) {
     minmax1D_novec(src, length, min, max);
   }
 }
+
+/// @brief The number of source bytes in one band of rows, so that the band
+/// is still in cache when it is read the second time.
+#define NORMALIZE_BAND_BYTES (16 * 1024)
+/// @brief The images which are smaller than this are not split between
+/// threads.
+#define NORMALIZE_PARALLEL_MIN_PIXELS (1024 * 1024)
+/// @brief The number of float-s in one block of the mean and the variance
+/// reduction, the block is read twice while it is in L1.
+#define NORMALIZE_ZSCORE_BLOCK 1024
+
+INLINE int normalize_band_rows(int width) {
+  int rows = NORMALIZE_BAND_BYTES / width;
+  return rows > 0? rows : 1;
+}
+
+/// @brief Clamps the normalized values to [-1, 1].
+static void normalize2D_clamp(int simd, float *dst, int dst_stride,
+                              int width, int height) {
+  for (int y = 0; y < height; y++) {
+    float *row = dst + (size_t)y * dst_stride;
+    int x = 0;
+    if (simd) {
+#ifdef __ARM_NEON__
+      const float32x4_t one = vdupq_n_f32(1.f), minus = vdupq_n_f32(-1.f);
+      for (; x < width - 3; x += 4) {
+        float32x4_t vec = vld1q_f32(row + x);
+        vst1q_f32(row + x, vmaxq_f32(vminq_f32(vec, one), minus));
+      }
+#elif defined(__SSE2__)
+      const __m128 one = _mm_set1_ps(1.f), minus = _mm_set1_ps(-1.f);
+      for (; x < width - 3; x += 4) {
+        __m128 vec = _mm_loadu_ps(row + x);
+        _mm_storeu_ps(row + x, _mm_max_ps(_mm_min_ps(vec, one), minus));
+      }
+#endif
+    }
+    for (; x < width; x++) {
+      float val = row[x];
+      row[x] = val > 1.f? 1.f : val < -1.f? -1.f : val;
+    }
+  }
+}
+
+void normalize2D_stream(int simd, uint8_t min, uint8_t max,
+                        const uint8_t *src, int src_stride,
+                        int width, int height, float *dst, int dst_stride,
+                        uint8_t *frameMin, uint8_t *frameMax) {
+  assert(src);
+  assert(dst);
+  assert(width > 0);
+  assert(height > 0);
+  assert(min <= max);
+  uint8_t resMin = src[0], resMax = src[0];
+  int bandRows = normalize_band_rows(width);
+  for (int y = 0; y < height; y += bandRows) {
+    int rows = height - y < bandRows? height - y : bandRows;
+    const uint8_t *band = src + (size_t)y * src_stride;
+    float *dstBand = dst + (size_t)y * dst_stride;
+    // The band is read from memory once, the second time it is in cache
+    uint8_t bandMin, bandMax;
+    minmax2D(simd, band, src_stride, width, rows, &bandMin, &bandMax);
+    if (bandMin < resMin) {
+      resMin = bandMin;
+    }
+    if (bandMax > resMax) {
+      resMax = bandMax;
+    }
+    normalize2D_minmax(simd, min, max, band, src_stride, width, rows,
+                       dstBand, dst_stride);
+    if (bandMin < min || bandMax > max) {
+      normalize2D_clamp(simd, dstBand, dst_stride, width, rows);
+    }
+  }
+  if (frameMin) {
+    *frameMin = resMin;
+  }
+  if (frameMax) {
+    *frameMax = resMax;
+  }
+}
+
+typedef struct {
+  int simd;
+  const uint8_t *src;
+  int src_stride;
+  int width;
+  int height;
+  int bandRows;
+  float *dst;
+  int dst_stride;
+  uint8_t min;
+  uint8_t max;
+  uint8_t *mins;
+  uint8_t *maxs;
+} ParallelNormalize;
+
+static void normalize2D_parallel_minmax(void *arg, int index) {
+  const ParallelNormalize *job = arg;
+  int y = index * job->bandRows;
+  int rows = job->height - y < job->bandRows? job->height - y : job->bandRows;
+  minmax2D(job->simd, job->src + (size_t)y * job->src_stride,
+           job->src_stride, job->width, rows, job->mins + index,
+           job->maxs + index);
+}
+
+static void normalize2D_parallel_band(void *arg, int index) {
+  const ParallelNormalize *job = arg;
+  int y = index * job->bandRows;
+  int rows = job->height - y < job->bandRows? job->height - y : job->bandRows;
+  normalize2D_minmax(job->simd, job->min, job->max,
+                     job->src + (size_t)y * job->src_stride, job->src_stride,
+                     job->width, rows, job->dst + (size_t)y * job->dst_stride,
+                     job->dst_stride);
+}
+
+void normalize2D_parallel(int simd, ThreadPool *pool, int threads,
+                          const uint8_t *src, int src_stride,
+                          int width, int height, float *dst, int dst_stride) {
+  assert(src);
+  assert(dst);
+  assert(width > 0);
+  assert(height > 0);
+  assert(threads >= 0);
+  if (pool == NULL) {
+    pool = thread_pool_default();
+  }
+  if (threads == 0 || threads > thread_pool_size(pool)) {
+    threads = thread_pool_size(pool);
+  }
+  if (threads <= 1 ||
+      (long long)width * height < NORMALIZE_PARALLEL_MIN_PIXELS) {
+    normalize2D(simd, src, src_stride, width, height, dst, dst_stride);
+    return;
+  }
+  ParallelNormalize job = {
+    simd, src, src_stride, width, height, normalize_band_rows(width), dst,
+    dst_stride, 0, 0, NULL, NULL
+  };
+  int bands = (height + job.bandRows - 1) / job.bandRows;
+  job.mins = malloc_aligned(bands * 2);
+  assert(job.mins);
+  job.maxs = job.mins + bands;
+  thread_pool_run(pool, bands, threads, normalize2D_parallel_minmax, &job);
+  job.min = job.mins[0];
+  job.max = job.maxs[0];
+  for (int i = 1; i < bands; i++) {
+    if (job.mins[i] < job.min) {
+      job.min = job.mins[i];
+    }
+    if (job.maxs[i] > job.max) {
+      job.max = job.maxs[i];
+    }
+  }
+  free_aligned(job.mins);
+  thread_pool_run(pool, bands, threads, normalize2D_parallel_band, &job);
+}
+
+/// @brief Normalizes a row of uint16_t to float: (src - min) * scale - 1.
+static void normalize_row_uint16(int simd, const uint16_t *src, int width,
+                                 float min, float scale, float *dst) {
+  int x = 0;
+  if (simd) {
+#ifdef __ARM_NEON__
+    const float32x4_t min_vec = vdupq_n_f32(min);
+    const float32x4_t scale_vec = vdupq_n_f32(scale);
+    const float32x4_t one = vdupq_n_f32(1.f);
+    for (; x < width - 7; x += 8) {
+      uint16x8_t vec = vld1q_u16(src + x);
+      float32x4_t lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(vec)));
+      float32x4_t hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(vec)));
+      lo = vsubq_f32(vmulq_f32(vsubq_f32(lo, min_vec), scale_vec), one);
+      hi = vsubq_f32(vmulq_f32(vsubq_f32(hi, min_vec), scale_vec), one);
+      vst1q_f32(dst + x, lo);
+      vst1q_f32(dst + x + 4, hi);
+    }
+#elif defined(__SSE2__)
+    const __m128 min_vec = _mm_set1_ps(min);
+    const __m128 scale_vec = _mm_set1_ps(scale);
+    const __m128 one = _mm_set1_ps(1.f);
+    for (; x < width - 7; x += 8) {
+      __m128i vec = _mm_loadu_si128((const __m128i*)(src + x));
+      __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(vec, _mm_setzero_si128()));
+      __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(vec, _mm_setzero_si128()));
+      lo = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(lo, min_vec), scale_vec), one);
+      hi = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(hi, min_vec), scale_vec), one);
+      _mm_storeu_ps(dst + x, lo);
+      _mm_storeu_ps(dst + x + 4, hi);
+    }
+#endif
+  }
+  for (; x < width; x++) {
+    dst[x] = (src[x] - min) * scale - 1.f;
+  }
+}
+
+/// @brief Normalizes a row of float-s: (src - min) * scale - 1.
+static void normalize_row_float(int simd, const float *src, int width,
+                                float min, float scale, float *dst) {
+  int x = 0;
+  if (simd) {
+#ifdef __ARM_NEON__
+    const float32x4_t min_vec = vdupq_n_f32(min);
+    const float32x4_t scale_vec = vdupq_n_f32(scale);
+    const float32x4_t one = vdupq_n_f32(1.f);
+    for (; x < width - 3; x += 4) {
+      float32x4_t vec = vld1q_f32(src + x);
+      vec = vsubq_f32(vmulq_f32(vsubq_f32(vec, min_vec), scale_vec), one);
+      vst1q_f32(dst + x, vec);
+    }
+#elif defined(__SSE2__)
+    const __m128 min_vec = _mm_set1_ps(min);
+    const __m128 scale_vec = _mm_set1_ps(scale);
+    const __m128 one = _mm_set1_ps(1.f);
+    for (; x < width - 3; x += 4) {
+      __m128 vec = _mm_loadu_ps(src + x);
+      vec = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(vec, min_vec), scale_vec), one);
+      _mm_storeu_ps(dst + x, vec);
+    }
+#endif
+  }
+  for (; x < width; x++) {
+    dst[x] = (src[x] - min) * scale - 1.f;
+  }
+}
+
+/// @brief Stores the normalized row in the requested format, float rows
+/// are already in place.
+static void normalize_row_store(int simd, const float *src, int width,
+                                NormalizeOutput format, void *dst) {
+  int x = 0;
+  if (format == NORMALIZE_OUTPUT_FP16) {
+    if (simd) {
+      float_to_float16(src, width, dst);
+    } else {
+      float_to_float16_na(src, width, dst);
+    }
+  } else if (format == NORMALIZE_OUTPUT_INT8) {
+    int8_t *out = dst;
+    if (simd) {
+#ifdef __ARM_NEON__
+      const float32x4_t factor = vdupq_n_f32(127.f);
+      const float32x4_t half = vdupq_n_f32(0.5f);
+      for (; x < width - 7; x += 8) {
+        // Round half away from zero, vcvtq truncates
+        float32x4_t lo = vmulq_f32(vld1q_f32(src + x), factor);
+        float32x4_t hi = vmulq_f32(vld1q_f32(src + x + 4), factor);
+        lo = vbslq_f32(vcltq_f32(lo, vdupq_n_f32(0.f)), vsubq_f32(lo, half),
+                       vaddq_f32(lo, half));
+        hi = vbslq_f32(vcltq_f32(hi, vdupq_n_f32(0.f)), vsubq_f32(hi, half),
+                       vaddq_f32(hi, half));
+        int16x8_t words = vcombine_s16(vqmovn_s32(vcvtq_s32_f32(lo)),
+                                       vqmovn_s32(vcvtq_s32_f32(hi)));
+        vst1_s8(out + x, vqmovn_s16(words));
+      }
+#elif defined(__SSE2__)
+      const __m128 factor = _mm_set1_ps(127.f);
+      for (; x < width - 15; x += 16) {
+        __m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + x), factor));
+        __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + x + 4),
+                                               factor));
+        __m128i c = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + x + 8),
+                                               factor));
+        __m128i d = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + x + 12),
+                                               factor));
+        __m128i bytes = _mm_packs_epi16(_mm_packs_epi32(a, b),
+                                        _mm_packs_epi32(c, d));
+        _mm_storeu_si128((__m128i*)(out + x), bytes);
+      }
+#endif
+    }
+    for (; x < width; x++) {
+      float value = src[x] * 127.f;
+      out[x] = (int8_t)(value < 0? value - 0.5f : value + 0.5f);
+    }
+  }
+}
+
+INLINE size_t normalize_output_size(NormalizeOutput format) {
+  switch (format) {
+    case NORMALIZE_OUTPUT_FP16:
+      return sizeof(uint16_t);
+    case NORMALIZE_OUTPUT_INT8:
+      return sizeof(int8_t);
+    default:
+      return sizeof(float);
+  }
+}
+
+/// @brief The source of normalize2D_format(), exactly one of the pointers
+/// is not NULL.
+typedef struct {
+  const uint8_t *u8;
+  const uint16_t *u16;
+  const float *f32;
+} NormalizeSource;
+
+static void normalize2D_format(int simd, NormalizeSource src, int src_stride,
+                               int width, int height, float min, float max,
+                               NormalizeOutput format, void *dst,
+                               int dst_stride) {
+  assert(dst);
+  assert(width > 0);
+  assert(height > 0);
+  assert(src_stride >= width);
+  assert(dst_stride >= width);
+  assert(min <= max);
+  size_t elementSize = normalize_output_size(format);
+  // The float rows are written in place, the others go through the row
+  // buffer which stays in L1
+  float *buffer = format == NORMALIZE_OUTPUT_FLOAT? NULL : mallocf(width);
+  float scale = max > min? 2.f / (max - min) : 0.f;
+  for (int y = 0; y < height; y++) {
+    void *out = (char *)dst + (size_t)y * dst_stride * elementSize;
+    float *row = buffer? buffer : out;
+    if (src.u8) {
+      normalize2D_minmax(simd, (uint8_t)min, (uint8_t)max,
+                         src.u8 + (size_t)y * src_stride, src_stride,
+                         width, 1, row, width);
+    } else if (max == min) {
+      memsetf(row, 0.f, width);
+    } else if (src.u16) {
+      normalize_row_uint16(simd, src.u16 + (size_t)y * src_stride, width,
+                           min, scale, row);
+    } else {
+      normalize_row_float(simd, src.f32 + (size_t)y * src_stride, width,
+                          min, scale, row);
+    }
+    if (buffer) {
+      normalize_row_store(simd, row, width, format, out);
+    }
+  }
+  free_aligned(buffer);
+}
+
+void minmax2D_uint16(int simd, const uint16_t *src, int src_stride,
+                     int width, int height, uint16_t *min_ptr,
+                     uint16_t *max_ptr) {
+  assert(src);
+  assert(width > 0);
+  assert(height > 0);
+  assert(src_stride >= width);
+  uint16_t min = src[0], max = src[0];
+  for (int y = 0; y < height; y++) {
+    const uint16_t *row = src + (size_t)y * src_stride;
+    int x = 0;
+    if (simd) {
+#ifdef __ARM_NEON__
+      uint16x8_t min_vec = vdupq_n_u16(min), max_vec = vdupq_n_u16(max);
+      for (; x < width - 7; x += 8) {
+        uint16x8_t vec = vld1q_u16(row + x);
+        min_vec = vminq_u16(vec, min_vec);
+        max_vec = vmaxq_u16(vec, max_vec);
+      }
+      uint16_t min_arr[8], max_arr[8];
+      vst1q_u16(min_arr, min_vec);
+      vst1q_u16(max_arr, max_vec);
+#elif defined(__SSE4_1__)
+      __m128i min_vec = _mm_set1_epi16(min), max_vec = _mm_set1_epi16(max);
+      for (; x < width - 7; x += 8) {
+        __m128i vec = _mm_loadu_si128((const __m128i*)(row + x));
+        min_vec = _mm_min_epu16(vec, min_vec);
+        max_vec = _mm_max_epu16(vec, max_vec);
+      }
+      uint16_t min_arr[8], max_arr[8];
+      _mm_storeu_si128((__m128i*)min_arr, min_vec);
+      _mm_storeu_si128((__m128i*)max_arr, max_vec);
+#endif
+#if defined(__ARM_NEON__) || defined(__SSE4_1__)
+      for (int i = 0; i < 8; i++) {
+        if (min_arr[i] < min) {
+          min = min_arr[i];
+        }
+        if (max_arr[i] > max) {
+          max = max_arr[i];
+        }
+      }
+#endif
+    }
+    for (; x < width; x++) {
+      if (row[x] < min) {
+        min = row[x];
+      }
+      if (row[x] > max) {
+        max = row[x];
+      }
+    }
+  }
+  if (min_ptr) {
+    *min_ptr = min;
+  }
+  if (max_ptr) {
+    *max_ptr = max;
+  }
+}
+
+void minmax2D_float(int simd, const float *src, int src_stride,
+                    int width, int height, float *min_ptr, float *max_ptr) {
+  assert(src);
+  assert(width > 0);
+  assert(height > 0);
+  assert(src_stride >= width);
+  float min = src[0], max = src[0];
+  for (int y = 0; y < height; y++) {
+    float rowMin, rowMax;
+    minmax1D(simd, src + (size_t)y * src_stride, width, &rowMin, &rowMax);
+    if (rowMin < min) {
+      min = rowMin;
+    }
+    if (rowMax > max) {
+      max = rowMax;
+    }
+  }
+  if (min_ptr) {
+    *min_ptr = min;
+  }
+  if (max_ptr) {
+    *max_ptr = max;
+  }
+}
+
+void normalize2D_uint8(int simd, const uint8_t *src, int src_stride,
+                       int width, int height, NormalizeOutput format,
+                       void *dst, int dst_stride) {
+  uint8_t min, max;
+  minmax2D(simd, src, src_stride, width, height, &min, &max);
+  NormalizeSource source = { src, NULL, NULL };
+  normalize2D_format(simd, source, src_stride, width, height, min, max,
+                     format, dst, dst_stride);
+}
+
+void normalize2D_uint16(int simd, const uint16_t *src, int src_stride,
+                        int width, int height, NormalizeOutput format,
+                        void *dst, int dst_stride) {
+  uint16_t min, max;
+  minmax2D_uint16(simd, src, src_stride, width, height, &min, &max);
+  normalize2D_uint16_minmax(simd, min, max, src, src_stride, width, height,
+                            format, dst, dst_stride);
+}
+
+void normalize2D_uint16_minmax(int simd, uint16_t min, uint16_t max,
+                               const uint16_t *src, int src_stride,
+                               int width, int height, NormalizeOutput format,
+                               void *dst, int dst_stride) {
+  assert(src);
+  NormalizeSource source = { NULL, src, NULL };
+  normalize2D_format(simd, source, src_stride, width, height, min, max,
+                     format, dst, dst_stride);
+}
+
+void normalize2D_float(int simd, const float *src, int src_stride,
+                       int width, int height, NormalizeOutput format,
+                       void *dst, int dst_stride) {
+  float min, max;
+  minmax2D_float(simd, src, src_stride, width, height, &min, &max);
+  normalize2D_float_minmax(simd, min, max, src, src_stride, width, height,
+                           format, dst, dst_stride);
+}
+
+void normalize2D_float_minmax(int simd, float min, float max,
+                              const float *src, int src_stride,
+                              int width, int height, NormalizeOutput format,
+                              void *dst, int dst_stride) {
+  assert(src);
+  NormalizeSource source = { NULL, NULL, src };
+  normalize2D_format(simd, source, src_stride, width, height, min, max,
+                     format, dst, dst_stride);
+}
+
+/// @brief The count, the mean and the sum of squared deviations from the
+/// mean of a part of the data.
+typedef struct {
+  double count;
+  double mean;
+  double m2;
+} NormalizeMoments;
+
+/// @brief Merges the moments of two disjoint parts (Chan et al.).
+INLINE void normalize_moments_merge(NormalizeMoments *res, double count,
+                                    double mean, double m2) {
+  double total = res->count + count;
+  double delta = mean - res->mean;
+  res->mean += delta * count / total;
+  res->m2 += m2 + delta * delta * res->count * count / total;
+  res->count = total;
+}
+
+/// @brief Calculates the sum and the sum of squares of the deviations of
+/// the array from shift.
+static void normalize_block_sums(int simd, const float *src, int length,
+                                 float shift, float *sum_ptr,
+                                 float *sumsq_ptr) {
+  int i = 0;
+  float sum = 0, sumsq = 0;
+  if (simd) {
+#ifdef __ARM_NEON__
+    float32x4_t acc1 = vdupq_n_f32(0.f), acc2 = vdupq_n_f32(0.f);
+    float32x4_t sq1 = vdupq_n_f32(0.f), sq2 = vdupq_n_f32(0.f);
+    const float32x4_t shift_vec = vdupq_n_f32(shift);
+    for (; i < length - 7; i += 8) {
+      float32x4_t v1 = vsubq_f32(vld1q_f32(src + i), shift_vec);
+      float32x4_t v2 = vsubq_f32(vld1q_f32(src + i + 4), shift_vec);
+      acc1 = vaddq_f32(acc1, v1);
+      acc2 = vaddq_f32(acc2, v2);
+      sq1 = madd128(v1, v1, sq1);
+      sq2 = madd128(v2, v2, sq2);
+    }
+    sum = hsum128(vaddq_f32(acc1, acc2));
+    sumsq = hsum128(vaddq_f32(sq1, sq2));
+#elif defined(__AVX__)
+    __m256 acc1 = _mm256_setzero_ps(), acc2 = _mm256_setzero_ps();
+    __m256 sq1 = _mm256_setzero_ps(), sq2 = _mm256_setzero_ps();
+    const __m256 shift_vec = _mm256_set1_ps(shift);
+    for (; i < length - 15; i += 16) {
+      __m256 v1 = _mm256_sub_ps(_mm256_loadu_ps(src + i), shift_vec);
+      __m256 v2 = _mm256_sub_ps(_mm256_loadu_ps(src + i + 8), shift_vec);
+      acc1 = _mm256_add_ps(acc1, v1);
+      acc2 = _mm256_add_ps(acc2, v2);
+      sq1 = _mm256_add_ps(sq1, _mm256_mul_ps(v1, v1));
+      sq2 = _mm256_add_ps(sq2, _mm256_mul_ps(v2, v2));
+    }
+    float lanes[8], sqlanes[8];
+    _mm256_storeu_ps(lanes, _mm256_add_ps(acc1, acc2));
+    _mm256_storeu_ps(sqlanes, _mm256_add_ps(sq1, sq2));
+    sum = ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) +
+          ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+    sumsq = ((sqlanes[0] + sqlanes[4]) + (sqlanes[1] + sqlanes[5])) +
+            ((sqlanes[2] + sqlanes[6]) + (sqlanes[3] + sqlanes[7]));
+#endif
+  }
+  for (; i < length; i++) {
+    float value = src[i] - shift;
+    sum += value;
+    sumsq += value * value;
+  }
+  *sum_ptr = sum;
+  *sumsq_ptr = sumsq;
+}
+
+/// @brief Adds the moments of the contiguous array to res.
+/// @details The data is split into the blocks of NORMALIZE_ZSCORE_BLOCK
+/// elements. The sums of each block are taken relative to its first
+/// element, which is close to the block mean in practice, so they do not
+/// suffer from the catastrophic cancellation of the plain sum of squares.
+/// The blocks are merged in double precision, thus the memory is read only
+/// once.
+static void normalize_moments(int simd, const float *src, int length,
+                              NormalizeMoments *res) {
+  for (int i = 0; i < length; i += NORMALIZE_ZSCORE_BLOCK) {
+    int size = length - i < NORMALIZE_ZSCORE_BLOCK?
+        length - i : NORMALIZE_ZSCORE_BLOCK;
+    float sum, sumsq;
+    normalize_block_sums(simd, src + i, size, src[i], &sum, &sumsq);
+    double m2 = sumsq - (double)sum * sum / size;
+    normalize_moments_merge(res, size, src[i] + (double)sum / size,
+                            m2 > 0? m2 : 0);
+  }
+}
+
+INLINE void normalize_moments_result(const NormalizeMoments *moments,
+                                     float *mean, float *stddev) {
+  if (mean) {
+    *mean = moments->mean;
+  }
+  if (stddev) {
+    *stddev = sqrt(moments->m2 / moments->count);
+  }
+}
+
+/// @brief dst = (src - mean) * scale, where mean and scale are either
+/// scalars (step 0) or the arrays of length elements (step 1).
+static void normalize_zscore_row(int simd, const float *src, int length,
+                                 const float *mean, const float *scale,
+                                 int step, float *dst) {
+  int i = 0;
+  if (simd) {
+#ifdef __ARM_NEON__
+    float32x4_t mean_vec = vdupq_n_f32(*mean);
+    float32x4_t scale_vec = vdupq_n_f32(*scale);
+    for (; i < length - 3; i += 4) {
+      if (step) {
+        mean_vec = vld1q_f32(mean + i);
+        scale_vec = vld1q_f32(scale + i);
+      }
+      float32x4_t vec = vsubq_f32(vld1q_f32(src + i), mean_vec);
+      vst1q_f32(dst + i, vmulq_f32(vec, scale_vec));
+    }
+#elif defined(__AVX__)
+    __m256 mean_vec = _mm256_set1_ps(*mean);
+    __m256 scale_vec = _mm256_set1_ps(*scale);
+    for (; i < length - 7; i += 8) {
+      if (step) {
+        mean_vec = _mm256_loadu_ps(mean + i);
+        scale_vec = _mm256_loadu_ps(scale + i);
+      }
+      __m256 vec = _mm256_sub_ps(_mm256_loadu_ps(src + i), mean_vec);
+      _mm256_storeu_ps(dst + i, _mm256_mul_ps(vec, scale_vec));
+    }
+#endif
+  }
+  for (; i < length; i++) {
+    dst[i] = (src[i] - mean[i * step]) * scale[i * step];
+  }
+}
+
+/// @brief acc += row or, if mean is not NULL, acc += (row - mean)^2,
+/// elementwise.
+static void normalize_accumulate_row(int simd, const float *row, int length,
+                                     const float *mean, float *acc) {
+  int i = 0;
+  if (simd) {
+#ifdef __ARM_NEON__
+    for (; i < length - 3; i += 4) {
+      float32x4_t vec = vld1q_f32(row + i);
+      float32x4_t sum = vld1q_f32(acc + i);
+      if (mean) {
+        vec = vsubq_f32(vec, vld1q_f32(mean + i));
+        sum = madd128(vec, vec, sum);
+      } else {
+        sum = vaddq_f32(sum, vec);
+      }
+      vst1q_f32(acc + i, sum);
+    }
+#elif defined(__AVX__)
+    for (; i < length - 7; i += 8) {
+      __m256 vec = _mm256_loadu_ps(row + i);
+      if (mean) {
+        vec = _mm256_sub_ps(vec, _mm256_loadu_ps(mean + i));
+        vec = _mm256_mul_ps(vec, vec);
+      }
+      _mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), vec));
+    }
+#endif
+  }
+  for (; i < length; i++) {
+    float value = mean? row[i] - mean[i] : row[i];
+    acc[i] += mean? value * value : value;
+  }
+}
+
+INLINE float normalize_zscore_scale(float stddev) {
+  return stddev > 0? 1.f / stddev : 0.f;
+}
+
+void meanstd1D(int simd, const float *src, int length,
+               float *mean, float *stddev) {
+  assert(src);
+  assert(length > 0);
+  NormalizeMoments moments = { 0, 0, 0 };
+  normalize_moments(simd, src, length, &moments);
+  normalize_moments_result(&moments, mean, stddev);
+}
+
+void meanstd2D(int simd, const float *src, int src_stride,
+               int width, int height, float *mean, float *stddev) {
+  assert(src);
+  assert(width > 0);
+  assert(height > 0);
+  assert(src_stride >= width);
+  NormalizeMoments moments = { 0, 0, 0 };
+  for (int y = 0; y < height; y++) {
+    normalize_moments(simd, src + (size_t)y * src_stride, width, &moments);
+  }
+  normalize_moments_result(&moments, mean, stddev);
+}
+
+void normalize1D_zscore(int simd, const float *src, int length, float *dst) {
+  assert(dst);
+  float mean, stddev;
+  meanstd1D(simd, src, length, &mean, &stddev);
+  float scale = normalize_zscore_scale(stddev);
+  normalize_zscore_row(simd, src, length, &mean, &scale, 0, dst);
+}
+
+void normalize2D_zscore(int simd, const float *src, int src_stride,
+                        int width, int height, float *dst, int dst_stride) {
+  assert(dst);
+  assert(dst_stride >= width);
+  float mean, stddev;
+  meanstd2D(simd, src, src_stride, width, height, &mean, &stddev);
+  float scale = normalize_zscore_scale(stddev);
+  for (int y = 0; y < height; y++) {
+    normalize_zscore_row(simd, src + (size_t)y * src_stride, width,
+                         &mean, &scale, 0, dst + (size_t)y * dst_stride);
+  }
+}
+
+void meanstd_channels(int simd, const float *src, int frames, int channels,
+                      float *mean, float *stddev) {
+  assert(src);
+  assert(frames > 0);
+  assert(channels > 0);
+  if (channels == 1) {
+    meanstd1D(simd, src, frames, mean, stddev);
+    return;
+  }
+  // The frames are processed in blocks of about NORMALIZE_ZSCORE_BLOCK values, the
+  // channel sums of a block are accumulated row by row
+  int block = NORMALIZE_ZSCORE_BLOCK / channels > 0? NORMALIZE_ZSCORE_BLOCK / channels : 1;
+  float *acc = mallocf(channels);
+  float *center = mallocf(channels);
+  NormalizeMoments *moments =
+      malloc_aligned(channels * sizeof(NormalizeMoments));
+  memset(moments, 0, channels * sizeof(NormalizeMoments));
+  for (int f = 0; f < frames; f += block) {
+    int size = frames - f < block? frames - f : block;
+    const float *ptr = src + (size_t)f * channels;
+    memsetf(acc, 0.f, channels);
+    for (int i = 0; i < size; i++) {
+      normalize_accumulate_row(simd, ptr + i * channels, channels, NULL, acc);
+    }
+    for (int c = 0; c < channels; c++) {
+      center[c] = acc[c] / size;
+    }
+    memsetf(acc, 0.f, channels);
+    for (int i = 0; i < size; i++) {
+      normalize_accumulate_row(simd, ptr + i * channels, channels, center,
+                               acc);
+    }
+    for (int c = 0; c < channels; c++) {
+      normalize_moments_merge(moments + c, size, center[c], acc[c]);
+    }
+  }
+  for (int c = 0; c < channels; c++) {
+    normalize_moments_result(moments + c, mean? mean + c : NULL,
+                             stddev? stddev + c : NULL);
+  }
+  free_aligned(moments);
+  free_aligned(center);
+  free_aligned(acc);
+}
+
+void normalize_zscore_channels(int simd, const float *src, int frames,
+                               int channels, float *dst) {
+  assert(dst);
+  float *mean = mallocf(channels);
+  float *scale = mallocf(channels);
+  meanstd_channels(simd, src, frames, channels, mean, scale);
+  for (int c = 0; c < channels; c++) {
+    scale[c] = normalize_zscore_scale(scale[c]);
+  }
+  for (int f = 0; f < frames; f++) {
+    normalize_zscore_row(simd, src + (size_t)f * channels, channels,
+                         mean, scale, 1, dst + (size_t)f * channels);
+  }
+  free_aligned(scale);
+  free_aligned(mean);
+}
@@ -0,0 +1,282 @@
+/*! @file profile.c
+ *  @brief Hardware counters and roofline accounting of the kernels.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+/* syscall() and clock_gettime() are not in C99 */
+#define _GNU_SOURCE
+#define LIBSIMD_IMPLEMENTATION
+#include "src/profile_counters.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+int profile_active = 0;
+
+static SimdProfileCounters profile_totals[kSimdProfileCount];
+
+static SimdTraceCallback profile_trace_callback = NULL;
+static void *profile_trace_user_data = NULL;
+
+#ifdef __linux__
+
+/* The group leader counts the cycles, the members follow in this order */
+static const uint64_t kProfileEvents[] = {
+  PERF_COUNT_HW_CPU_CYCLES,
+  PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_CACHE_MISSES
+};
+
+#define PROFILE_EVENTS (sizeof(kProfileEvents) / sizeof(kProfileEvents[0]))
+
+/* -1 means not opened yet, -2 means perf_event_open() failed */
+static __thread int profile_group = -1;
+static pthread_key_t profile_key;
+static pthread_once_t profile_key_once = PTHREAD_ONCE_INIT;
+
+static void profile_close_group(void *group) {
+  close((int)(intptr_t)group - 1);
+}
+
+static void profile_create_key(void) {
+  pthread_key_create(&profile_key, profile_close_group);
+}
+
+static int profile_open_group(void) {
+  int group = -1;
+  int fds[PROFILE_EVENTS];
+  for (size_t i = 0; i < PROFILE_EVENTS; i++) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = kProfileEvents[i];
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fds[i] = syscall(__NR_perf_event_open, &attr, 0, -1, group, 0);
+    if (fds[i] < 0) {
+      while (i > 0) {
+        close(fds[--i]);
+      }
+      return -2;
+    }
+    if (group < 0) {
+      group = fds[i];
+    }
+  }
+  // Closing the leader is enough to release the whole group
+  pthread_once(&profile_key_once, profile_create_key);
+  pthread_setspecific(profile_key, (void *)(intptr_t)(group + 1));
+  return group;
+}
+
+static int profile_read(uint64_t *counters) {
+  if (profile_group == -1) {
+    profile_group = profile_open_group();
+  }
+  if (profile_group < 0) {
+    return 0;
+  }
+  uint64_t data[1 + PROFILE_EVENTS];
+  if (read(profile_group, data, sizeof(data)) != sizeof(data)) {
+    return 0;
+  }
+  memcpy(counters, data + 1, PROFILE_EVENTS * sizeof(uint64_t));
+  return 1;
+}
+
+#else
+
+static int profile_read(uint64_t *counters) {
+  memset(counters, 0, 3 * sizeof(uint64_t));
+  return 0;
+}
+
+#endif  // __linux__
+
+static uint64_t profile_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void profile_begin(ProfileSample *sample) {
+  if (!(profile_active & PROFILE_COUNTERS) ||
+      !profile_read(sample->counters)) {
+    memset(sample->counters, 0, sizeof(sample->counters));
+  }
+  sample->nanoseconds = profile_now();
+}
+
+uint64_t profile_elapsed(const ProfileSample *sample) {
+  return profile_now() - sample->nanoseconds;
+}
+
+uint64_t profile_end(const ProfileSample *sample, SimdProfileKernel kernel,
+                     uint64_t flops, uint64_t bytes) {
+  uint64_t elapsed = profile_elapsed(sample);
+  if (!(profile_active & PROFILE_COUNTERS)) {
+    return elapsed;
+  }
+  uint64_t counters[3];
+  if (!profile_read(counters)) {
+    memcpy(counters, sample->counters, sizeof(counters));
+  }
+  SimdProfileCounters *totals = &profile_totals[kernel];
+  __atomic_fetch_add(&totals->calls, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&totals->nanoseconds, elapsed, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&totals->cycles, counters[0] - sample->counters[0],
+                     __ATOMIC_RELAXED);
+  __atomic_fetch_add(&totals->instructions,
+                     counters[1] - sample->counters[1], __ATOMIC_RELAXED);
+  __atomic_fetch_add(&totals->llc_misses, counters[2] - sample->counters[2],
+                     __ATOMIC_RELAXED);
+  __atomic_fetch_add(&totals->flops, flops, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&totals->bytes, bytes, __ATOMIC_RELAXED);
+  return elapsed;
+}
+
+void profile_trace(const SimdTraceEvent *event) {
+  SimdTraceCallback callback = profile_trace_callback;
+  if ((profile_active & PROFILE_TRACE) && callback != NULL) {
+    callback(event, profile_trace_user_data);
+  }
+}
+
+void profile_trace_convolution(const struct ConvolutionHandle *handle,
+                               SimdTraceEntry entry, uint64_t nanoseconds) {
+  SimdTraceEvent event;
+  event.entry = entry;
+  event.algorithm = handle->algorithm;
+  event.x_length = handle->x_length;
+  event.h_length = handle->h_length;
+  event.fft_length = 0;
+  switch (handle->algorithm) {
+    case kConvolutionAlgorithmFFT:
+      event.fft_length = *handle->handle.fft.M;
+      break;
+    case kConvolutionAlgorithmOverlapSave:
+      event.fft_length = *handle->handle.os.L;
+      break;
+    case kConvolutionAlgorithmPartitioned:
+      event.fft_length = *handle->handle.partitioned.N;
+      break;
+    case kConvolutionAlgorithmBruteForce:
+      break;
+  }
+  event.nanoseconds = nanoseconds;
+  profile_trace(&event);
+}
+
+void simd_profile_set_enabled(int enabled) {
+  if (enabled) {
+    __atomic_or_fetch(&profile_active, PROFILE_COUNTERS, __ATOMIC_RELAXED);
+  } else {
+    __atomic_and_fetch(&profile_active, ~PROFILE_COUNTERS, __ATOMIC_RELAXED);
+  }
+}
+
+int simd_profile_enabled(void) {
+  return (profile_active & PROFILE_COUNTERS) != 0;
+}
+
+void simd_profile_set_trace(SimdTraceCallback callback, void *user_data) {
+  profile_trace_user_data = user_data;
+  profile_trace_callback = callback;
+  if (callback != NULL) {
+    __atomic_or_fetch(&profile_active, PROFILE_TRACE, __ATOMIC_RELAXED);
+  } else {
+    __atomic_and_fetch(&profile_active, ~PROFILE_TRACE, __ATOMIC_RELAXED);
+  }
+}
+
+int simd_profile_hardware_counters(void) {
+  uint64_t counters[3];
+  return profile_read(counters);
+}
+
+void simd_profile_get(SimdProfileKernel kernel,
+                      SimdProfileCounters *counters) {
+  assert(kernel >= 0 && kernel < kSimdProfileCount);
+  assert(counters);
+  const SimdProfileCounters *totals = &profile_totals[kernel];
+  counters->calls = __atomic_load_n(&totals->calls, __ATOMIC_RELAXED);
+  counters->nanoseconds = __atomic_load_n(&totals->nanoseconds,
+                                          __ATOMIC_RELAXED);
+  counters->cycles = __atomic_load_n(&totals->cycles, __ATOMIC_RELAXED);
+  counters->instructions = __atomic_load_n(&totals->instructions,
+                                           __ATOMIC_RELAXED);
+  counters->llc_misses = __atomic_load_n(&totals->llc_misses,
+                                         __ATOMIC_RELAXED);
+  counters->flops = __atomic_load_n(&totals->flops, __ATOMIC_RELAXED);
+  counters->bytes = __atomic_load_n(&totals->bytes, __ATOMIC_RELAXED);
+}
+
+void simd_profile_reset(void) {
+  for (int i = 0; i < kSimdProfileCount; i++) {
+    SimdProfileCounters *totals = &profile_totals[i];
+    __atomic_store_n(&totals->calls, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&totals->nanoseconds, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&totals->cycles, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&totals->instructions, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&totals->llc_misses, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&totals->flops, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&totals->bytes, 0, __ATOMIC_RELAXED);
+  }
+}
+
+const char *simd_profile_kernel_name(SimdProfileKernel kernel) {
+  switch (kernel) {
+    case kSimdProfileConvolve:
+      return "convolve";
+    case kSimdProfileWaveletApply:
+      return "wavelet_apply";
+    case kSimdProfileMatrixMultiply:
+      return "matrix_multiply";
+    case kSimdProfileNormalize2D:
+      return "normalize2D";
+    default:
+      return "unknown";
+  }
+}
+
+static void __attribute__((constructor)) profile_initialize(void) {
+  const char *enabled = getenv(SIMD_PROFILE_ENV);
+  if (enabled && atoi(enabled)) {
+    profile_active = PROFILE_COUNTERS;
+  }
+}
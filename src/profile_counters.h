@@ -0,0 +1,77 @@
+/*! @file profile_counters.h
+ *  @brief The instrumentation of the entry points, see simd/profile.h.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_PROFILE_COUNTERS_H_
+#define SRC_PROFILE_COUNTERS_H_
+
+#include <stdint.h>
+#include <simd/common.h>
+#include <simd/profile.h>
+
+SIMD_API_BEGIN
+
+/// @brief The counters are accumulated, see simd_profile_set_enabled().
+#define PROFILE_COUNTERS 1
+/// @brief The trace callback is set, see simd_profile_set_trace().
+#define PROFILE_TRACE 2
+
+/// @brief The combination of PROFILE_COUNTERS and PROFILE_TRACE.
+/// The instrumented calls test it before doing anything else.
+extern int profile_active;
+
+/// @brief The state of the counters at the beginning of a profiled call.
+typedef struct {
+  uint64_t nanoseconds;
+  uint64_t counters[3];
+} ProfileSample;
+
+/// @brief Records the start of a profiled call.
+void profile_begin(ProfileSample *sample);
+
+/// @brief Returns the wall clock time since profile_begin().
+uint64_t profile_elapsed(const ProfileSample *sample);
+
+/// @brief Adds the call which started with profile_begin() to the totals
+/// if PROFILE_COUNTERS is on.
+/// @return The wall clock time of the call.
+uint64_t profile_end(const ProfileSample *sample, SimdProfileKernel kernel,
+                     uint64_t flops, uint64_t bytes);
+
+/// @brief Passes the event to the trace callback if PROFILE_TRACE is on.
+void profile_trace(const SimdTraceEvent *event);
+
+/// @brief Traces the call of the specified convolution handle.
+void profile_trace_convolution(const struct ConvolutionHandle *handle,
+                               SimdTraceEntry entry, uint64_t nanoseconds);
+
+SIMD_API_END
+
+#endif  // SRC_PROFILE_COUNTERS_H_
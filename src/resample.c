@@ -0,0 +1,216 @@
+/*! @file resample.c
+ *  @brief Polyphase FIR resampling, decimation and interpolation.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#define LIBSIMD_IMPLEMENTATION
+#include "src/dispatch.h"
+#define resample_initialize KERNEL(resample_initialize)
+#define resample_decimate_initialize KERNEL(resample_decimate_initialize)
+#define resample_interpolate_initialize \
+    KERNEL(resample_interpolate_initialize)
+#define resample_design_filter KERNEL(resample_design_filter)
+#define resample_output_length KERNEL(resample_output_length)
+#define resample_process KERNEL(resample_process)
+#define resample_reset KERNEL(resample_reset)
+#define resample_finalize KERNEL(resample_finalize)
+#include "inc/simd/resample.h"
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <simd/instruction_set.h>
+#include <simd/memory.h>
+#include "src/dot_product.h"
+
+#define RESAMPLE_PI 3.14159265358979323846
+
+ResampleHandle resample_initialize(int up, int down, const float *h,
+                                   size_t hLength) {
+  assert(up > 0);
+  assert(down > 0);
+  assert(h);
+  assert(hLength > 0);
+  ResampleHandle handle;
+  handle.up = up;
+  handle.down = down;
+  handle.taps = (hLength + up - 1) / up;
+  // Phase p convolves with h[p], h[p + up], h[p + 2 * up], ..., which are
+  // stored reversed, so that each output is a plain dot product with
+  // the consecutive input samples
+  handle.phases = mallocf((size_t)up * handle.taps);
+  assert(handle.phases);
+  for (int p = 0; p < up; p++) {
+    float *phase = handle.phases + (size_t)p * handle.taps;
+    for (int m = 0; m < handle.taps; m++) {
+      size_t k = p + (size_t)m * up;
+      phase[handle.taps - 1 - m] = k < hLength? h[k] : 0.f;
+    }
+  }
+  handle.history = mallocf(2 * (handle.taps - 1) + 1);
+  assert(handle.history);
+  resample_reset(&handle);
+  return handle;
+}
+
+ResampleHandle resample_decimate_initialize(int factor, const float *h,
+                                            size_t hLength) {
+  return resample_initialize(1, factor, h, hLength);
+}
+
+ResampleHandle resample_interpolate_initialize(int factor, const float *h,
+                                               size_t hLength) {
+  return resample_initialize(factor, 1, h, hLength);
+}
+
+void resample_design_filter(int up, int down, int tapsPerPhase, float *h) {
+  assert(up > 0);
+  assert(down > 0);
+  assert(tapsPerPhase > 0);
+  assert(h);
+  int length = up * tapsPerPhase;
+  // The cutoff in cycles per sample at the upsampled rate
+  double cutoff = 0.5 / (up > down? up : down);
+  double center = (length - 1) / 2.0;
+  double sum = 0;
+  for (int k = 0; k < length; k++) {
+    double t = 2 * cutoff * (k - center);
+    double sinc = t == 0? 1 : sin(RESAMPLE_PI * t) / (RESAMPLE_PI * t);
+    double window = 1;
+    if (length > 1) {
+      double a = 2 * RESAMPLE_PI * k / (length - 1);
+      window = 0.42 - 0.5 * cos(a) + 0.08 * cos(2 * a);
+    }
+    h[k] = sinc * window;
+    sum += h[k];
+  }
+  // The zeros between the input samples take (up - 1) / up of the energy
+  float gain = up / sum;
+  for (int k = 0; k < length; k++) {
+    h[k] *= gain;
+  }
+}
+
+size_t resample_output_length(const ResampleHandle *handle, size_t length) {
+  assert(handle);
+  // The outputs at the upsampled times t = start + n * down, t < end
+  unsigned long long start = handle->index * (unsigned long long)handle->up +
+      handle->phase;
+  unsigned long long end = length * (unsigned long long)handle->up;
+  if (start >= end) {
+    return 0;
+  }
+  return (end - start + handle->down - 1) / handle->down;
+}
+
+/// @brief Calculates sum(a[i] * b[i]), i = 0..length-1.
+static float resample_dot(int simd, const float *a, const float *b,
+                          int length) {
+#ifdef __AVX__
+  if (simd) {
+    return dot_product256(a, b, length);
+  }
+#elif defined(__ARM_NEON__)
+  if (simd) {
+    float32x4_t accum = vdupq_n_f32(0.f);
+    int i = 0;
+    for (; i < length - 3; i += 4) {
+      accum = vmlaq_f32(accum, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    float32x2_t accum2 = vpadd_f32(vget_high_f32(accum),
+                                   vget_low_f32(accum));
+    float sum = vget_lane_f32(accum2, 0) + vget_lane_f32(accum2, 1);
+    for (; i < length; i++) {
+      sum += a[i] * b[i];
+    }
+    return sum;
+  }
+#else
+  (void)simd;
+#endif
+  float sum = 0.f;
+  for (int i = 0; i < length; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+size_t resample_process(int simd, ResampleHandle *handle,
+                        const float *__restrict x, size_t length,
+                        float *__restrict result) {
+  assert(handle);
+  assert(x);
+  assert(result);
+  const int taps = handle->taps, up = handle->up;
+  const size_t keep = taps - 1;
+  const size_t step = handle->down / up;
+  const int phaseStep = handle->down % up;
+  // The windows of the first outputs straddle the blocks, so they read
+  // the history followed by the beginning of x, the rest read x directly
+  float *history = handle->history;
+  size_t head = length < keep? length : keep;
+  memcpy(history + keep, x, head * sizeof(float));
+  size_t index = handle->index;
+  int phase = handle->phase;
+  size_t count = 0;
+  for (; index < length; count++) {
+    const float *window = index < keep?
+        history + index : x + index - keep;
+    result[count] = resample_dot(
+        simd, handle->phases + (size_t)phase * taps, window, taps);
+    index += step;
+    phase += phaseStep;
+    if (phase >= up) {
+      phase -= up;
+      index++;
+    }
+  }
+  handle->index = index - length;
+  handle->phase = phase;
+  if (length >= keep) {
+    memcpy(history, x + length - keep, keep * sizeof(float));
+  } else {
+    memmove(history, history + length, keep * sizeof(float));
+  }
+  return count;
+}
+
+void resample_reset(ResampleHandle *handle) {
+  assert(handle);
+  memsetf(handle->history, 0.f, 2 * (handle->taps - 1) + 1);
+  handle->phase = 0;
+  handle->index = 0;
+}
+
+void resample_finalize(ResampleHandle *handle) {
+  assert(handle);
+  free_aligned(handle->phases);
+  free_aligned(handle->history);
+  handle->phases = NULL;
+  handle->history = NULL;
+}
@@ -0,0 +1,406 @@
+/*! @file sliding.c
+ *  @brief Incremental statistics over the sliding window of a signal.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#define LIBSIMD_IMPLEMENTATION
+#include "src/dispatch.h"
+#define sliding_stats_initialize KERNEL(sliding_stats_initialize)
+#define sliding_stats_process KERNEL(sliding_stats_process)
+#define sliding_stats_detect_peaks KERNEL(sliding_stats_detect_peaks)
+#define sliding_stats_reset KERNEL(sliding_stats_reset)
+#define sliding_stats_finalize KERNEL(sliding_stats_finalize)
+#include "inc/simd/sliding.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <simd/instruction_set.h>
+#include <simd/memory.h>
+
+/* The moments are accumulated in double: SLIDING_VL float-s are widened
+ * at once, the products of two of them are exact. */
+#if defined(__AVX512F__)
+
+#define SLIDING_VL 8
+typedef __m512d sliding_vec;
+#define sliding_load_ps(ptr) _mm512_cvtps_pd(_mm256_loadu_ps(ptr))
+#define sliding_store_ps(ptr, vec) \
+    _mm256_storeu_ps(ptr, _mm512_cvtpd_ps(vec))
+#define sliding_loadu(ptr) _mm512_loadu_pd(ptr)
+#define sliding_storeu(ptr, vec) _mm512_storeu_pd(ptr, vec)
+#define sliding_set1(value) _mm512_set1_pd(value)
+#define sliding_add(a, b) _mm512_add_pd(a, b)
+#define sliding_sub(a, b) _mm512_sub_pd(a, b)
+#define sliding_mul(a, b) _mm512_mul_pd(a, b)
+#define sliding_max(a, b) _mm512_max_pd(a, b)
+
+#elif defined(__AVX__) && !defined(SIMD_AVX_EMULATION)
+
+#define SLIDING_VL 4
+typedef __m256d sliding_vec;
+#define sliding_load_ps(ptr) _mm256_cvtps_pd(_mm_loadu_ps(ptr))
+#define sliding_store_ps(ptr, vec) _mm_storeu_ps(ptr, _mm256_cvtpd_ps(vec))
+#define sliding_loadu(ptr) _mm256_loadu_pd(ptr)
+#define sliding_storeu(ptr, vec) _mm256_storeu_pd(ptr, vec)
+#define sliding_set1(value) _mm256_set1_pd(value)
+#define sliding_add(a, b) _mm256_add_pd(a, b)
+#define sliding_sub(a, b) _mm256_sub_pd(a, b)
+#define sliding_mul(a, b) _mm256_mul_pd(a, b)
+#define sliding_max(a, b) _mm256_max_pd(a, b)
+
+#elif defined(__SSE2__)
+
+#define SLIDING_VL 2
+typedef __m128d sliding_vec;
+#define sliding_load_ps(ptr) _mm_cvtps_pd(_mm_castsi128_ps( \
+    _mm_loadl_epi64((const __m128i *)(ptr))))
+#define sliding_store_ps(ptr, vec) _mm_storel_epi64( \
+    (__m128i *)(ptr), _mm_castps_si128(_mm_cvtpd_ps(vec)))
+#define sliding_loadu(ptr) _mm_loadu_pd(ptr)
+#define sliding_storeu(ptr, vec) _mm_storeu_pd(ptr, vec)
+#define sliding_set1(value) _mm_set1_pd(value)
+#define sliding_add(a, b) _mm_add_pd(a, b)
+#define sliding_sub(a, b) _mm_sub_pd(a, b)
+#define sliding_mul(a, b) _mm_mul_pd(a, b)
+#define sliding_max(a, b) _mm_max_pd(a, b)
+
+#elif defined(__aarch64__)
+
+#define SLIDING_VL 2
+typedef float64x2_t sliding_vec;
+#define sliding_load_ps(ptr) vcvt_f64_f32(vld1_f32(ptr))
+#define sliding_store_ps(ptr, vec) vst1_f32(ptr, vcvt_f32_f64(vec))
+#define sliding_loadu(ptr) vld1q_f64(ptr)
+#define sliding_storeu(ptr, vec) vst1q_f64(ptr, vec)
+#define sliding_set1(value) vdupq_n_f64(value)
+#define sliding_add(a, b) vaddq_f64(a, b)
+#define sliding_sub(a, b) vsubq_f64(a, b)
+#define sliding_mul(a, b) vmulq_f64(a, b)
+#define sliding_max(a, b) vmaxq_f64(a, b)
+
+#endif
+
+SlidingStats sliding_stats_initialize(int window) {
+  assert(window > 0);
+  SlidingStats stats;
+  stats.window = window;
+  stats.history = mallocf(window);
+  stats.minimums.points = malloc(window * sizeof(SlidingPoint));
+  stats.maximums.points = malloc(window * sizeof(SlidingPoint));
+  assert(stats.history && stats.minimums.points && stats.maximums.points);
+  sliding_stats_reset(&stats);
+  return stats;
+}
+
+void sliding_stats_reset(SlidingStats *stats) {
+  assert(stats);
+  stats->position = 0;
+  stats->shift = 0;
+  stats->sum = 0;
+  stats->sumSquares = 0;
+  stats->minimums.first = 0;
+  stats->minimums.count = 0;
+  stats->maximums.first = 0;
+  stats->maximums.count = 0;
+}
+
+void sliding_stats_finalize(SlidingStats *stats) {
+  assert(stats);
+  free_aligned(stats->history);
+  free(stats->minimums.points);
+  free(stats->maximums.points);
+  stats->history = NULL;
+  stats->minimums.points = NULL;
+  stats->maximums.points = NULL;
+}
+
+/// @brief Adds the sample to the deque of the minimums or the maximums of
+/// the window.
+/// @return The extremum of the window which ends at the sample.
+/// @details The front which left the window is dropped first, so at most
+/// window points are ever kept.
+INLINE float sliding_deque_push(SlidingDeque *deque, int window,
+                                size_t position, float value, int maximum) {
+  if (deque->count > 0 &&
+      deque->points[deque->first].position + window <= position) {
+    if (++deque->first == window) {
+      deque->first = 0;
+    }
+    deque->count--;
+  }
+  // The older candidates which are not better never become the extremum
+  while (deque->count > 0) {
+    int last = deque->first + deque->count - 1;
+    if (last >= window) {
+      last -= window;
+    }
+    float back = deque->points[last].value;
+    if (maximum? back > value : back < value) {
+      break;
+    }
+    deque->count--;
+  }
+  int index = deque->first + deque->count;
+  if (index >= window) {
+    index -= window;
+  }
+  deque->points[index] = (SlidingPoint) { .position = position,
+                                          .value = value };
+  deque->count++;
+  return deque->points[deque->first].value;
+}
+
+/// @brief d1[k] = e - l and d2[k] = e^2 - l^2 in double, where
+/// e = entering[k] - shift and l = leaving[k] - shift.
+static void sliding_deltas(int simd, const float *entering,
+                           const float *leaving, int length, float shift,
+                           double *d1, double *d2) {
+  int k = 0;
+#ifdef SLIDING_VL
+  if (simd) {
+    const sliding_vec shiftvec = sliding_set1(shift);
+    for (; k + SLIDING_VL <= length; k += SLIDING_VL) {
+      sliding_vec e = sliding_sub(sliding_load_ps(entering + k), shiftvec);
+      sliding_vec l = sliding_sub(sliding_load_ps(leaving + k), shiftvec);
+      sliding_vec diff = sliding_sub(e, l);
+      sliding_storeu(d1 + k, diff);
+      sliding_storeu(d2 + k, sliding_mul(diff, sliding_add(e, l)));
+    }
+  }
+#else
+  (void)simd;
+#endif
+  for (; k < length; k++) {
+    double e = (double)entering[k] - shift, l = (double)leaving[k] - shift;
+    d1[k] = e - l;
+    d2[k] = (e - l) * (e + l);
+  }
+}
+
+/// @brief Converts the running sums of the full windows to the means and
+/// the variances, either may be NULL.
+static void sliding_moments(int simd, const double *sums,
+                            const double *squares, int length, int window,
+                            float shift, float *mean, float *variance) {
+  const double inverse = 1.0 / window;
+  int k = 0;
+#ifdef SLIDING_VL
+  if (simd) {
+    const sliding_vec invvec = sliding_set1(inverse);
+    const sliding_vec shiftvec = sliding_set1(shift);
+    const sliding_vec zero = sliding_set1(0);
+    for (; k + SLIDING_VL <= length; k += SLIDING_VL) {
+      sliding_vec m = sliding_mul(sliding_loadu(sums + k), invvec);
+      if (mean) {
+        sliding_store_ps(mean + k, sliding_add(m, shiftvec));
+      }
+      if (variance) {
+        sliding_vec q = sliding_mul(sliding_loadu(squares + k), invvec);
+        sliding_store_ps(variance + k,
+                         sliding_max(sliding_sub(q, sliding_mul(m, m)),
+                                     zero));
+      }
+    }
+  }
+#else
+  (void)simd;
+#endif
+  for (; k < length; k++) {
+    double m = sums[k] * inverse;
+    if (mean) {
+      mean[k] = m + shift;
+    }
+    if (variance) {
+      double v = squares[k] * inverse - m * m;
+      variance[k] = v > 0? v : 0;
+    }
+  }
+}
+
+/// @brief Adds one sample while the window is not full yet, nothing leaves
+/// it.
+static void sliding_stats_grow(SlidingStats *stats, float value,
+                               float *min, float *max, float *mean,
+                               float *variance) {
+  const int window = stats->window;
+  size_t position = stats->position;
+  if (position == 0) {
+    stats->shift = value;
+  }
+  double e = (double)value - stats->shift;
+  stats->sum += e;
+  stats->sumSquares += e * e;
+  float minimum = sliding_deque_push(&stats->minimums, window, position,
+                                     value, 0);
+  float maximum = sliding_deque_push(&stats->maximums, window, position,
+                                     value, 1);
+  if (min) {
+    *min = minimum;
+  }
+  if (max) {
+    *max = maximum;
+  }
+  double m = stats->sum / (position + 1);
+  if (mean) {
+    *mean = m + stats->shift;
+  }
+  if (variance) {
+    double v = stats->sumSquares / (position + 1) - m * m;
+    *variance = v > 0? v : 0;
+  }
+  stats->position++;
+}
+
+void sliding_stats_process(int simd, SlidingStats *stats, const float *x,
+                           size_t length, float *min, float *max,
+                           float *mean, float *variance) {
+  assert(stats);
+  assert(x);
+  const size_t window = stats->window;
+  const size_t start = stats->position;
+  double d1[SLIDING_CHUNK] __attribute__((aligned(64)));
+  double d2[SLIDING_CHUNK] __attribute__((aligned(64)));
+  size_t i = 0;
+  for (; i < length && stats->position < window; i++) {
+    sliding_stats_grow(stats, x[i], min? min + i : NULL, max? max + i : NULL,
+                       mean? mean + i : NULL,
+                       variance? variance + i : NULL);
+  }
+  while (i < length) {
+    int chunk = length - i < SLIDING_CHUNK? length - i : SLIDING_CHUNK;
+    size_t position = stats->position;
+    // The leaving samples are either earlier in x or in the history of
+    // the previous blocks, which is not overwritten until the end
+    for (int k = 0; k < chunk;) {
+      size_t j = i + k;
+      const float *leaving;
+      int run = chunk - k;
+      if (j >= window) {
+        leaving = x + j - window;
+      } else {
+        size_t slot = (position + k) % window;
+        leaving = stats->history + slot;
+        if ((size_t)run > window - slot) {
+          run = window - slot;
+        }
+        if ((size_t)run > window - j) {
+          run = window - j;
+        }
+      }
+      sliding_deltas(simd, x + j, leaving, run, stats->shift, d1 + k,
+                     d2 + k);
+      k += run;
+    }
+    // The running sums are a dependency chain, kept in place of the deltas
+    double sum = stats->sum, squares = stats->sumSquares;
+    for (int k = 0; k < chunk; k++) {
+      sum += d1[k];
+      squares += d2[k];
+      d1[k] = sum;
+      d2[k] = squares;
+    }
+    stats->sum = sum;
+    stats->sumSquares = squares;
+    for (int k = 0; k < chunk; k++) {
+      float minimum = sliding_deque_push(&stats->minimums, window,
+                                         position + k, x[i + k], 0);
+      float maximum = sliding_deque_push(&stats->maximums, window,
+                                         position + k, x[i + k], 1);
+      if (min) {
+        min[i + k] = minimum;
+      }
+      if (max) {
+        max[i + k] = maximum;
+      }
+    }
+    if (mean || variance) {
+      sliding_moments(simd, d1, d2, chunk, window, stats->shift,
+                      mean? mean + i : NULL, variance? variance + i : NULL);
+    }
+    stats->position += chunk;
+    i += chunk;
+  }
+  // Keep the last window samples for the next blocks
+  size_t keep = length < window? length : window;
+  if (keep > 0) {
+    size_t slot = (start + length - keep) % window;
+    size_t head = keep < window - slot? keep : window - slot;
+    memcpy(stats->history + slot, x + length - keep, head * sizeof(float));
+    memcpy(stats->history, x + length - keep + head,
+           (keep - head) * sizeof(float));
+  }
+}
+
+void sliding_stats_detect_peaks(int simd, SlidingStats *stats,
+                                float deviations, DetectPeaksStream *stream,
+                                const float *x, size_t length) {
+  assert(stats);
+  assert(stream);
+  assert(x);
+  assert(stats->position == stream->position);
+  // Item 0 is of the window of the previous sample: the last sample of
+  // the previous block is checked when this one arrives
+  float mean[SLIDING_CHUNK + 1], variance[SLIDING_CHUNK + 1];
+  for (size_t i = 0; i < length; i += SLIDING_CHUNK) {
+    size_t chunk = length - i < SLIDING_CHUNK? length - i : SLIDING_CHUNK;
+    size_t base = stats->position;
+    mean[0] = variance[0] = 0;
+    if (base > 0) {
+      size_t n = base < (size_t)stats->window? base : (size_t)stats->window;
+      double m = stats->sum / n, v = stats->sumSquares / n - m * m;
+      mean[0] = m + stats->shift;
+      variance[0] = v > 0? v : 0;
+    }
+    size_t count = stream->count, lost = stream->lost;
+    detect_peaks_stream_push(simd, stream, x + i, chunk);
+    sliding_stats_process(simd, stats, x + i, chunk, NULL, NULL, mean + 1,
+                          variance + 1);
+    size_t added = stream->count - count + stream->lost - lost;
+    if (added > stream->count) {
+      added = stream->count;
+    }
+    size_t kept = stream->count - added;
+    for (size_t k = stream->count - added; k < stream->count; k++) {
+      ExtremumPoint point =
+          stream->points[(stream->first + k) % stream->capacity];
+      // The extremum is followed by at least one sample of this chunk
+      size_t offset = (size_t)point.position + 1 - base;
+      float sigma = deviations * sqrtf(variance[offset]);
+      int pass = point.value > x[i + offset]?
+          point.value >= mean[offset] + sigma :
+          point.value <= mean[offset] - sigma;
+      if (pass) {
+        stream->points[(stream->first + kept) % stream->capacity] = point;
+        kept++;
+      }
+    }
+    stream->count = kept;
+  }
+}
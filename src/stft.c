@@ -0,0 +1,368 @@
+/*! @file stft.c
+ *  @brief Short-time Fourier transform and spectrograms.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#define LIBSIMD_IMPLEMENTATION
+#include "src/dispatch.h"
+#define stft_initialize KERNEL(stft_initialize)
+#define stft_initialize_log_mel KERNEL(stft_initialize_log_mel)
+#define stft_frame_size KERNEL(stft_frame_size)
+#define stft_frames KERNEL(stft_frames)
+#define stft_process KERNEL(stft_process)
+#define stft_stream_frames KERNEL(stft_stream_frames)
+#define stft_stream KERNEL(stft_stream)
+#define stft_reset KERNEL(stft_reset)
+#define stft_finalize KERNEL(stft_finalize)
+#include "inc/simd/stft.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <simd/arithmetic.h>
+#include <simd/fft.h>
+#include <simd/instruction_set.h>
+#include <simd/mathfun.h>
+#include <simd/memory.h>
+
+#define STFT_PI 3.14159265358979323846
+
+/// @brief The number of the complex numbers in the spectrum of a frame.
+static int stft_bins(const STFTHandle *handle) {
+  return handle->fft_size / 2 + 1;
+}
+
+/// @brief Rounds up to 16 float-s, so that the next array is aligned.
+static size_t stft_align(size_t length) {
+  return (length + 15) & ~15;
+}
+
+STFTHandle stft_initialize(const float *window, int windowLength, int hop,
+                           int fftSize, STFTOutput output) {
+  assert(windowLength > 0);
+  assert(hop > 0);
+  assert(fftSize >= windowLength);
+  STFTHandle handle;
+  handle.output = output;
+  handle.window_length = windowLength;
+  handle.hop = hop;
+  handle.fft_size = fftSize;
+  handle.window = mallocf(windowLength);
+  assert(handle.window);
+  if (window) {
+    memcpy(handle.window, window, windowLength * sizeof(window[0]));
+  } else {
+    for (int i = 0; i < windowLength; i++) {
+      handle.window[i] = 0.5 - 0.5 * cos(2 * STFT_PI * i / windowLength);
+    }
+  }
+
+  handle.slot_stride = stft_align(fftSize + 2);
+  handle.slots = mallocf(handle.slot_stride * STFT_BATCH_FRAMES);
+  assert(handle.slots);
+  float *slots[STFT_BATCH_FRAMES];
+  for (int i = 0; i < STFT_BATCH_FRAMES; i++) {
+    slots[i] = handle.slots + i * handle.slot_stride;
+  }
+  handle.batch_plan = fft_initialize_batch(
+      kFFTTypeReal, kFFTDirectionForward, fftSize, STFT_BATCH_FRAMES,
+      (const float *const *)slots, slots, 0);
+  assert(handle.batch_plan);
+  handle.plan = fft_initialize(kFFTTypeReal, kFFTDirectionForward, fftSize,
+                               handle.slots, handle.slots, 0);
+  assert(handle.plan);
+
+  handle.spectrum = mallocf(stft_align(stft_bins(&handle)));
+  assert(handle.spectrum);
+  handle.mel_bands = 0;
+  handle.mel_bins = NULL;
+  handle.mel_weights = NULL;
+  handle.history = mallocf(windowLength);
+  assert(handle.history);
+  handle.buffered = 0;
+  handle.skip = 0;
+  return handle;
+}
+
+static double stft_mel(double frequency) {
+  return 2595 * log10(1 + frequency / 700);
+}
+
+static double stft_mel_frequency(double mel) {
+  return 700 * (pow(10, mel / 2595) - 1);
+}
+
+STFTHandle stft_initialize_log_mel(const float *window, int windowLength,
+                                   int hop, int fftSize, int bands,
+                                   float sampleRate, float minFrequency,
+                                   float maxFrequency) {
+  assert(bands > 0);
+  assert(sampleRate > 0);
+  assert(minFrequency >= 0 && minFrequency < maxFrequency);
+  assert(maxFrequency <= sampleRate / 2);
+  STFTHandle handle = stft_initialize(window, windowLength, hop, fftSize,
+                                      kSTFTOutputLogMel);
+  int bins = stft_bins(&handle);
+  // The mel bands follow the power spectrum
+  free_aligned(handle.spectrum);
+  handle.spectrum = mallocf(stft_align(bins) + bands);
+  assert(handle.spectrum);
+  handle.mel_bands = bands;
+  handle.mel_bins = malloc(2 * bands * sizeof(int));
+  assert(handle.mel_bins);
+
+  // bands + 2 edges, each band spans three adjacent ones
+  double *edges = malloc((bands + 2) * sizeof(double));
+  assert(edges);
+  double melMin = stft_mel(minFrequency), melMax = stft_mel(maxFrequency);
+  for (int i = 0; i < bands + 2; i++) {
+    edges[i] = stft_mel_frequency(
+        melMin + (melMax - melMin) * i / (bands + 1));
+  }
+  double binWidth = (double)sampleRate / fftSize;
+  int weights = 0;
+  for (int b = 0; b < bands; b++) {
+    int first = (int)ceil(edges[b] / binWidth);
+    int last = (int)floor(edges[b + 2] / binWidth);
+    if (last > bins - 1) {
+      last = bins - 1;
+    }
+    handle.mel_bins[2 * b] = first;
+    handle.mel_bins[2 * b + 1] = last >= first? last - first + 1 : 0;
+    weights += handle.mel_bins[2 * b + 1];
+  }
+  handle.mel_weights = mallocf(weights > 0? weights : 1);
+  assert(handle.mel_weights);
+  float *weight = handle.mel_weights;
+  for (int b = 0; b < bands; b++) {
+    for (int i = 0; i < handle.mel_bins[2 * b + 1]; i++) {
+      double frequency = (handle.mel_bins[2 * b] + i) * binWidth;
+      double value;
+      if (frequency <= edges[b + 1]) {
+        value = (frequency - edges[b]) / (edges[b + 1] - edges[b]);
+      } else {
+        value = (edges[b + 2] - frequency) / (edges[b + 2] - edges[b + 1]);
+      }
+      *weight++ = value > 0? value : 0;
+    }
+  }
+  free(edges);
+  return handle;
+}
+
+size_t stft_frame_size(const STFTHandle *handle) {
+  switch (handle->output) {
+    case kSTFTOutputComplex:
+      return 2 * stft_bins(handle);
+    case kSTFTOutputLogMel:
+      return handle->mel_bands;
+    default:
+      return stft_bins(handle);
+  }
+}
+
+size_t stft_frames(const STFTHandle *handle, size_t length) {
+  if (length < (size_t)handle->window_length) {
+    return 0;
+  }
+  return (length - handle->window_length) / handle->hop + 1;
+}
+
+/// @brief Windows the frame which starts at start in the concatenation of
+/// head and x and pads it with zeros up to the FFT size.
+static void stft_load(int simd, const STFTHandle *handle, const float *head,
+                      size_t headLength, const float *x, size_t start,
+                      float *slot) {
+  size_t length = handle->window_length, fromHead = 0;
+  if (start < headLength) {
+    fromHead = headLength - start < length? headLength - start : length;
+    if (simd) {
+      real_multiply_array(head + start, handle->window, fromHead, slot);
+    } else {
+      real_multiply_array_na(head + start, handle->window, fromHead, slot);
+    }
+  }
+  if (fromHead < length) {
+    const float *src = x + (start + fromHead - headLength);
+    if (simd) {
+      real_multiply_array(src, handle->window + fromHead, length - fromHead,
+                          slot + fromHead);
+    } else {
+      real_multiply_array_na(src, handle->window + fromHead,
+                             length - fromHead, slot + fromHead);
+    }
+  }
+  if ((int)length < handle->fft_size) {
+    memsetf(slot + length, 0.f, handle->fft_size - length);
+  }
+}
+
+static void stft_sqrt(int simd, float *array, size_t length) {
+  size_t i = 0;
+  if (simd) {
+#ifdef __AVX__
+    for (; i + 8 <= length; i += 8) {
+      _mm256_storeu_ps(array + i, _mm256_sqrt_ps(_mm256_loadu_ps(array + i)));
+    }
+#endif
+  }
+  for (; i < length; i++) {
+    array[i] = sqrtf(array[i]);
+  }
+}
+
+/// @brief Turns the transformed slot into the row of the result.
+static void stft_emit(int simd, const STFTHandle *handle, const float *slot,
+                      float *row) {
+  int bins = stft_bins(handle);
+  float *logInput = handle->spectrum;
+  size_t logLength = bins;
+  switch (handle->output) {
+    case kSTFTOutputComplex:
+      memcpy(row, slot, 2 * bins * sizeof(float));
+      return;
+    case kSTFTOutputMagnitude:
+      fft_power_spectrum(simd, slot, bins, row);
+      stft_sqrt(simd, row, bins);
+      return;
+    case kSTFTOutputPower:
+      fft_power_spectrum(simd, slot, bins, row);
+      return;
+    case kSTFTOutputLogPower:
+      fft_power_spectrum(simd, slot, bins, handle->spectrum);
+      break;
+    case kSTFTOutputLogMel: {
+      fft_power_spectrum(simd, slot, bins, handle->spectrum);
+      float *mel = handle->spectrum + stft_align(bins);
+      const float *weights = handle->mel_weights;
+      for (int b = 0; b < handle->mel_bands; b++) {
+        const float *power = handle->spectrum + handle->mel_bins[2 * b];
+        int count = handle->mel_bins[2 * b + 1];
+        mel[b] = simd? dot_product(weights, power, count)
+                     : dot_product_na(weights, power, count);
+        weights += count;
+      }
+      logInput = mel;
+      logLength = handle->mel_bands;
+      break;
+    }
+  }
+  if (simd) {
+    add_to_all(logInput, logLength, STFT_LOG_FLOOR, logInput);
+  } else {
+    add_to_all_na(logInput, logLength, STFT_LOG_FLOOR, logInput);
+  }
+  log_psv(simd, logInput, logLength, row);
+}
+
+/// @brief Calculates the frames which start at i * hop, i < frames, in
+/// the concatenation of head and x, STFT_BATCH_FRAMES at a time.
+static void stft_run(int simd, STFTHandle *handle, const float *head,
+                     size_t headLength, const float *x, size_t frames,
+                     float *result) {
+  size_t rowSize = stft_frame_size(handle);
+  size_t frame = 0;
+  for (; frame + STFT_BATCH_FRAMES <= frames; frame += STFT_BATCH_FRAMES) {
+    for (int i = 0; i < STFT_BATCH_FRAMES; i++) {
+      stft_load(simd, handle, head, headLength, x,
+                (frame + i) * handle->hop,
+                handle->slots + i * handle->slot_stride);
+    }
+    fft_execute(handle->batch_plan);
+    for (int i = 0; i < STFT_BATCH_FRAMES; i++) {
+      stft_emit(simd, handle, handle->slots + i * handle->slot_stride,
+                result + (frame + i) * rowSize);
+    }
+  }
+  for (; frame < frames; frame++) {
+    stft_load(simd, handle, head, headLength, x, frame * handle->hop,
+              handle->slots);
+    fft_execute(handle->plan);
+    stft_emit(simd, handle, handle->slots, result + frame * rowSize);
+  }
+}
+
+size_t stft_process(int simd, STFTHandle *handle, const float *x,
+                    size_t length, float *result) {
+  size_t frames = stft_frames(handle, length);
+  stft_run(simd, handle, NULL, 0, x, frames, result);
+  return frames;
+}
+
+size_t stft_stream_frames(const STFTHandle *handle, size_t length) {
+  if (length <= handle->skip) {
+    return 0;
+  }
+  return stft_frames(handle, handle->buffered + length - handle->skip);
+}
+
+size_t stft_stream(int simd, STFTHandle *handle, const float *x,
+                   size_t length, float *result) {
+  size_t skip = handle->skip < length? handle->skip : length;
+  x += skip;
+  length -= skip;
+  handle->skip -= skip;
+  size_t buffered = handle->buffered, total = buffered + length;
+  size_t frames = stft_frames(handle, total);
+  stft_run(simd, handle, handle->history, buffered, x, frames, result);
+
+  // Keep the beginning of the next frame
+  size_t next = frames * handle->hop;
+  if (next >= total) {
+    handle->skip = next - total;
+    handle->buffered = 0;
+    return frames;
+  }
+  if (next < buffered) {
+    memmove(handle->history, handle->history + next,
+            (buffered - next) * sizeof(float));
+    memcpy(handle->history + buffered - next, x, length * sizeof(float));
+  } else {
+    memcpy(handle->history, x + (next - buffered),
+           (total - next) * sizeof(float));
+  }
+  handle->buffered = total - next;
+  return frames;
+}
+
+void stft_reset(STFTHandle *handle) {
+  handle->buffered = 0;
+  handle->skip = 0;
+}
+
+void stft_finalize(STFTHandle *handle) {
+  fft_finalize(handle->batch_plan);
+  fft_finalize(handle->plan);
+  free_aligned(handle->window);
+  free_aligned(handle->slots);
+  free_aligned(handle->spectrum);
+  free(handle->mel_bins);
+  free_aligned(handle->mel_weights);
+  free_aligned(handle->history);
+}
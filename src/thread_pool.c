@@ -0,0 +1,439 @@
+/*! @file thread_pool.c
+ *  @brief The library owned work-stealing thread pool based on POSIX threads.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#define LIBSIMD_IMPLEMENTATION
+#include "inc/simd/thread_pool.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/// @brief A submitted job, see thread_pool_submit().
+typedef struct {
+  ThreadPoolJob job;
+  ThreadPoolJob done;
+  void *arg;
+  ThreadPoolWaitGroup *group;
+} ThreadPoolEntry;
+
+/// @brief The jobs of one thread. The owner pushes and pops at the tail,
+/// the others steal from the head.
+typedef struct {
+  pthread_mutex_t lock;
+  ThreadPoolEntry *entries;
+  unsigned int capacity;
+  unsigned int head;
+  unsigned int tail;
+} ThreadPoolDeque;
+
+struct ThreadPoolWaitGroup {
+  /* Changed under the lock of the pool the jobs are submitted to */
+  int pending;
+};
+
+struct ThreadPool {
+  int size;
+  ThreadPoolExecutor executor;
+  void *context;
+
+  /* The rest belongs to the library owned pools */
+  pthread_t *workers;
+  int workersCount;
+  /* deques[0] takes the jobs submitted by the threads which are not the
+   * workers, worker i owns deques[i] */
+  ThreadPoolDeque *deques;
+  pthread_mutex_t lock;
+  /* Signalled when a job is queued, broadcast when a wait group is done */
+  pthread_cond_t wake;
+  int queued;
+  int shutdown;
+};
+
+typedef struct {
+  ThreadPool *pool;
+  int id;
+} WorkerArgs;
+
+/* The pool and the deque index of the calling worker thread */
+static __thread ThreadPool *current_pool;
+static __thread int current_worker;
+
+static int thread_pool_deque_push(ThreadPoolDeque *deque,
+                                  const ThreadPoolEntry *entry) {
+  pthread_mutex_lock(&deque->lock);
+  if (deque->tail - deque->head == deque->capacity) {
+    unsigned int capacity = deque->capacity? deque->capacity * 2 : 64;
+    ThreadPoolEntry *entries = malloc(capacity * sizeof(ThreadPoolEntry));
+    if (entries == NULL) {
+      pthread_mutex_unlock(&deque->lock);
+      return 0;
+    }
+    for (unsigned int i = deque->head; i != deque->tail; i++) {
+      entries[i & (capacity - 1)] = deque->entries[i & (deque->capacity - 1)];
+    }
+    free(deque->entries);
+    deque->entries = entries;
+    deque->capacity = capacity;
+  }
+  deque->entries[deque->tail++ & (deque->capacity - 1)] = *entry;
+  pthread_mutex_unlock(&deque->lock);
+  return 1;
+}
+
+static int thread_pool_deque_pop(ThreadPoolDeque *deque,
+                                 ThreadPoolEntry *entry) {
+  int found = 0;
+  pthread_mutex_lock(&deque->lock);
+  if (deque->tail != deque->head) {
+    *entry = deque->entries[--deque->tail & (deque->capacity - 1)];
+    found = 1;
+  }
+  pthread_mutex_unlock(&deque->lock);
+  return found;
+}
+
+static int thread_pool_deque_steal(ThreadPoolDeque *deque,
+                                   ThreadPoolEntry *entry) {
+  int found = 0;
+  pthread_mutex_lock(&deque->lock);
+  if (deque->tail != deque->head) {
+    *entry = deque->entries[deque->head++ & (deque->capacity - 1)];
+    found = 1;
+  }
+  pthread_mutex_unlock(&deque->lock);
+  return found;
+}
+
+/// @brief Takes the newest job of the own deque or steals the oldest of
+/// the others.
+static int thread_pool_take(ThreadPool *pool, int self,
+                            ThreadPoolEntry *entry) {
+  if (__atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) == 0) {
+    return 0;
+  }
+  int found = thread_pool_deque_pop(&pool->deques[self], entry);
+  for (int i = 1; !found && i < pool->size; i++) {
+    found = thread_pool_deque_steal(
+        &pool->deques[(self + i) % pool->size], entry);
+  }
+  if (found) {
+    __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_RELAXED);
+  }
+  return found;
+}
+
+static void thread_pool_group_finish(ThreadPool *pool,
+                                     ThreadPoolWaitGroup *group) {
+  // The waiter frees the group as soon as it sees 0, so it is not touched
+  // after the lock is released
+  pthread_mutex_lock(&pool->lock);
+  if (__atomic_sub_fetch(&group->pending, 1, __ATOMIC_RELEASE) == 0) {
+    pthread_cond_broadcast(&pool->wake);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
+
+static void thread_pool_execute(ThreadPool *pool,
+                                const ThreadPoolEntry *entry) {
+  entry->job(entry->arg);
+  if (entry->done != NULL) {
+    entry->done(entry->arg);
+  }
+  if (entry->group != NULL) {
+    thread_pool_group_finish(pool, entry->group);
+  }
+}
+
+static void *thread_pool_worker(void *ptr) {
+  WorkerArgs args = *(WorkerArgs *)ptr;
+  free(ptr);
+  ThreadPool *pool = args.pool;
+  current_pool = pool;
+  current_worker = args.id;
+  for (;;) {
+    ThreadPoolEntry entry;
+    if (thread_pool_take(pool, args.id, &entry)) {
+      thread_pool_execute(pool, &entry);
+      continue;
+    }
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->shutdown &&
+           __atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) == 0) {
+      pthread_cond_wait(&pool->wake, &pool->lock);
+    }
+    int shutdown = pool->shutdown;
+    pthread_mutex_unlock(&pool->lock);
+    if (shutdown) {
+      break;
+    }
+  }
+  return NULL;
+}
+
+static int online_processors(void) {
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0? (int)count : 1;
+}
+
+static void thread_pool_stop(ThreadPool *pool) {
+  pthread_mutex_lock(&pool->lock);
+  pool->shutdown = 1;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+  for (int i = 0; i < pool->workersCount; i++) {
+    pthread_join(pool->workers[i], NULL);
+  }
+  for (int i = 0; i < pool->size; i++) {
+    assert(pool->deques[i].head == pool->deques[i].tail);
+    pthread_mutex_destroy(&pool->deques[i].lock);
+    free(pool->deques[i].entries);
+  }
+  pthread_cond_destroy(&pool->wake);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool->deques);
+  free(pool->workers);
+}
+
+ThreadPool *thread_pool_create(int threads) {
+  assert(threads >= 0);
+  if (threads == 0) {
+    threads = online_processors();
+  }
+  ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+  if (pool == NULL) {
+    return NULL;
+  }
+  pool->size = threads;
+  pool->workers = malloc((threads - 1) * sizeof(pthread_t) + 1);
+  pool->deques = calloc(threads, sizeof(ThreadPoolDeque));
+  if (pool->workers == NULL || pool->deques == NULL) {
+    free(pool->workers);
+    free(pool->deques);
+    free(pool);
+    return NULL;
+  }
+  for (int i = 0; i < threads; i++) {
+    pthread_mutex_init(&pool->deques[i].lock, NULL);
+  }
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+  for (int i = 1; i < threads; i++) {
+    WorkerArgs *args = malloc(sizeof(WorkerArgs));
+    if (args == NULL) {
+      break;
+    }
+    args->pool = pool;
+    args->id = i;
+    if (pthread_create(&pool->workers[i - 1], NULL, thread_pool_worker,
+                       args) != 0) {
+      free(args);
+      break;
+    }
+    pool->workersCount++;
+  }
+  if (pool->workersCount != threads - 1) {
+    thread_pool_stop(pool);
+    free(pool);
+    return NULL;
+  }
+  return pool;
+}
+
+ThreadPool *thread_pool_create_external(
+    int threads, ThreadPoolExecutor executor, void *context) {
+  assert(threads > 0);
+  assert(executor);
+  ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+  if (pool == NULL) {
+    return NULL;
+  }
+  pool->size = threads;
+  pool->executor = executor;
+  pool->context = context;
+  return pool;
+}
+
+void thread_pool_destroy(ThreadPool *pool) {
+  assert(pool);
+  if (pool->executor == NULL) {
+    thread_pool_stop(pool);
+  }
+  free(pool);
+}
+
+static pthread_once_t default_pool_once = PTHREAD_ONCE_INIT;
+static ThreadPool *default_pool;
+
+static void default_pool_create(void) {
+  int threads = 0;
+  const char *env = getenv(SIMD_NUM_THREADS_ENV);
+  if (env != NULL) {
+    threads = atoi(env);
+    if (threads < 0) {
+      threads = 0;
+    }
+  }
+  default_pool = thread_pool_create(threads);
+  if (default_pool == NULL) {
+    // Fall back to running everything on the calling thread
+    default_pool = thread_pool_create(1);
+  }
+}
+
+ThreadPool *thread_pool_default(void) {
+  pthread_once(&default_pool_once, default_pool_create);
+  return default_pool;
+}
+
+int thread_pool_size(const ThreadPool *pool) {
+  assert(pool);
+  return pool->size;
+}
+
+ThreadPoolWaitGroup *thread_pool_wait_group_create(void) {
+  return calloc(1, sizeof(ThreadPoolWaitGroup));
+}
+
+void thread_pool_wait_group_destroy(ThreadPoolWaitGroup *group) {
+  assert(group);
+  assert(group->pending == 0);
+  free(group);
+}
+
+int thread_pool_wait_group_pending(const ThreadPoolWaitGroup *group) {
+  assert(group);
+  return __atomic_load_n(&group->pending, __ATOMIC_ACQUIRE);
+}
+
+void thread_pool_submit(ThreadPool *pool, ThreadPoolWaitGroup *group,
+                        ThreadPoolJob job, ThreadPoolJob done, void *arg) {
+  assert(pool);
+  assert(job);
+  ThreadPoolEntry entry = { job, done, arg, group };
+  if (pool->executor != NULL || pool->workersCount == 0) {
+    // There is no thread to run the job later
+    job(arg);
+    if (done != NULL) {
+      done(arg);
+    }
+    return;
+  }
+  if (group != NULL) {
+    pthread_mutex_lock(&pool->lock);
+    __atomic_add_fetch(&group->pending, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&pool->lock);
+  }
+  int self = current_pool == pool? current_worker : 0;
+  if (!thread_pool_deque_push(&pool->deques[self], &entry)) {
+    thread_pool_execute(pool, &entry);
+    return;
+  }
+  __atomic_add_fetch(&pool->queued, 1, __ATOMIC_RELEASE);
+  pthread_mutex_lock(&pool->lock);
+  pthread_cond_signal(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void thread_pool_wait(ThreadPool *pool, ThreadPoolWaitGroup *group) {
+  assert(pool);
+  assert(group);
+  if (pool->executor != NULL || pool->workersCount == 0) {
+    return;
+  }
+  int self = current_pool == pool? current_worker : 0;
+  while (__atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) > 0) {
+    // Help with any queued job instead of blocking, so that the jobs
+    // which wait themselves do not starve the pool
+    ThreadPoolEntry entry;
+    if (thread_pool_take(pool, self, &entry)) {
+      thread_pool_execute(pool, &entry);
+      continue;
+    }
+    pthread_mutex_lock(&pool->lock);
+    while (group->pending > 0 &&
+           __atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) == 0) {
+      pthread_cond_wait(&pool->wake, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+  }
+}
+
+/// @brief The job of thread_pool_run() which is submitted once per thread.
+typedef struct {
+  ThreadPoolTask task;
+  void *arg;
+  int count;
+  int next;
+} ThreadPoolRun;
+
+static void thread_pool_run_job(void *ptr) {
+  ThreadPoolRun *run = ptr;
+  int index;
+  while ((index = __atomic_fetch_add(&run->next, 1, __ATOMIC_RELAXED)) <
+         run->count) {
+    run->task(run->arg, index);
+  }
+}
+
+void thread_pool_run(ThreadPool *pool, int count, int threads,
+                     ThreadPoolTask task, void *arg) {
+  assert(pool);
+  assert(task);
+  assert(count >= 0);
+  assert(threads >= 0);
+  if (threads == 0 || threads > pool->size) {
+    threads = pool->size;
+  }
+  if (threads > count) {
+    threads = count;
+  }
+  if (pool->executor != NULL) {
+    if (count > 0) {
+      pool->executor(pool->context, count, threads, task, arg);
+    }
+    return;
+  }
+  if (threads <= 1) {
+    for (int i = 0; i < count; i++) {
+      task(arg, i);
+    }
+    return;
+  }
+  // The calling thread takes its share, so the job is taken by at most
+  // threads - 1 others
+  ThreadPoolRun run = { task, arg, count, 0 };
+  ThreadPoolWaitGroup group = { 0 };
+  for (int i = 1; i < threads; i++) {
+    thread_pool_submit(pool, &group, thread_pool_run_job, NULL, &run);
+  }
+  thread_pool_run_job(&run);
+  thread_pool_wait(pool, &group);
+}
@@ -0,0 +1,106 @@
+/*! @file transpose.h
+ *  @brief Register blocked matrix transposition shared by the kernels.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#ifndef SRC_TRANSPOSE_H_
+#define SRC_TRANSPOSE_H_
+
+#include <simd/attributes.h>
+#include <simd/instruction_set.h>
+
+#ifdef __AVX__
+
+/// @brief The side of the block which transpose_block() processes.
+#define TRANSPOSE_BLOCK 8
+
+/// @brief Transposes 8x8 block, dst[j * ldd + i] = src[i * lds + j].
+/// @details All the rows are loaded before the first store, so src and dst
+/// may be the same block.
+INLINE NOTNULL(1, 3) void transpose_block(const float *src, int lds,
+                                          float *dst, int ldd) {
+  __m256 r0 = _mm256_loadu_ps(src);
+  __m256 r1 = _mm256_loadu_ps(src + lds);
+  __m256 r2 = _mm256_loadu_ps(src + 2 * lds);
+  __m256 r3 = _mm256_loadu_ps(src + 3 * lds);
+  __m256 r4 = _mm256_loadu_ps(src + 4 * lds);
+  __m256 r5 = _mm256_loadu_ps(src + 5 * lds);
+  __m256 r6 = _mm256_loadu_ps(src + 6 * lds);
+  __m256 r7 = _mm256_loadu_ps(src + 7 * lds);
+  // a0 b0 a1 b1 | a4 b4 a5 b5 and a2 b2 a3 b3 | a6 b6 a7 b7
+  __m256 t0 = _mm256_unpacklo_ps(r0, r1), t1 = _mm256_unpackhi_ps(r0, r1);
+  __m256 t2 = _mm256_unpacklo_ps(r2, r3), t3 = _mm256_unpackhi_ps(r2, r3);
+  __m256 t4 = _mm256_unpacklo_ps(r4, r5), t5 = _mm256_unpackhi_ps(r4, r5);
+  __m256 t6 = _mm256_unpacklo_ps(r6, r7), t7 = _mm256_unpackhi_ps(r6, r7);
+  // a0 b0 c0 d0 | a4 b4 c4 d4, a1 b1 c1 d1 | a5 b5 c5 d5, etc.
+  __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+  _mm256_storeu_ps(dst, _mm256_permute2f128_ps(s0, s4, 0x20));
+  _mm256_storeu_ps(dst + ldd, _mm256_permute2f128_ps(s1, s5, 0x20));
+  _mm256_storeu_ps(dst + 2 * ldd, _mm256_permute2f128_ps(s2, s6, 0x20));
+  _mm256_storeu_ps(dst + 3 * ldd, _mm256_permute2f128_ps(s3, s7, 0x20));
+  _mm256_storeu_ps(dst + 4 * ldd, _mm256_permute2f128_ps(s0, s4, 0x31));
+  _mm256_storeu_ps(dst + 5 * ldd, _mm256_permute2f128_ps(s1, s5, 0x31));
+  _mm256_storeu_ps(dst + 6 * ldd, _mm256_permute2f128_ps(s2, s6, 0x31));
+  _mm256_storeu_ps(dst + 7 * ldd, _mm256_permute2f128_ps(s3, s7, 0x31));
+}
+
+#elif defined(__ARM_NEON__)
+
+/// @brief The side of the block which transpose_block() processes.
+#define TRANSPOSE_BLOCK 4
+
+/// @brief Transposes 4x4 block, dst[j * ldd + i] = src[i * lds + j].
+/// @details All the rows are loaded before the first store, so src and dst
+/// may be the same block.
+INLINE NOTNULL(1, 3) void transpose_block(const float *src, int lds,
+                                          float *dst, int ldd) {
+  // a0 b0 a2 b2 and a1 b1 a3 b3
+  float32x4x2_t t01 = vtrnq_f32(vld1q_f32(src), vld1q_f32(src + lds));
+  float32x4x2_t t23 = vtrnq_f32(vld1q_f32(src + 2 * lds),
+                                vld1q_f32(src + 3 * lds));
+  vst1q_f32(dst, vcombine_f32(vget_low_f32(t01.val[0]),
+                              vget_low_f32(t23.val[0])));
+  vst1q_f32(dst + ldd, vcombine_f32(vget_low_f32(t01.val[1]),
+                                    vget_low_f32(t23.val[1])));
+  vst1q_f32(dst + 2 * ldd, vcombine_f32(vget_high_f32(t01.val[0]),
+                                        vget_high_f32(t23.val[0])));
+  vst1q_f32(dst + 3 * ldd, vcombine_f32(vget_high_f32(t01.val[1]),
+                                        vget_high_f32(t23.val[1])));
+}
+
+#endif
+
+#endif  // SRC_TRANSPOSE_H_
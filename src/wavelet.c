@@ -29,8 +29,47 @@
  */
 
 #define LIBSIMD_IMPLEMENTATION
+#include "src/dispatch.h"
+#define wavelet_validate_order KERNEL(wavelet_validate_order)
+#define wavelet_prepare_array KERNEL(wavelet_prepare_array)
+#define wavelet_allocate_destination KERNEL(wavelet_allocate_destination)
+#define wavelet_recycle_source KERNEL(wavelet_recycle_source)
+#define wavelet_apply KERNEL(wavelet_apply)
+#define wavelet_apply_na KERNEL(wavelet_apply_na)
+#define wavelet_apply_plain KERNEL(wavelet_apply_plain)
+#define stationary_wavelet_apply KERNEL(stationary_wavelet_apply)
+#define stationary_wavelet_apply_na KERNEL(stationary_wavelet_apply_na)
+#define wavelet_decompose KERNEL(wavelet_decompose)
+#define stationary_wavelet_decompose KERNEL(stationary_wavelet_decompose)
+#define inverse_wavelet_apply KERNEL(inverse_wavelet_apply)
+#define inverse_wavelet_apply_na KERNEL(inverse_wavelet_apply_na)
+#define inverse_stationary_wavelet_apply \
+    KERNEL(inverse_stationary_wavelet_apply)
+#define inverse_stationary_wavelet_apply_na \
+    KERNEL(inverse_stationary_wavelet_apply_na)
+#define wavelet_recompose KERNEL(wavelet_recompose)
+#define stationary_wavelet_recompose KERNEL(stationary_wavelet_recompose)
+#define wavelet_shrink KERNEL(wavelet_shrink)
+#define wavelet_universal_threshold KERNEL(wavelet_universal_threshold)
+#define wavelet_denoise KERNEL(wavelet_denoise)
+#define stationary_wavelet_denoise KERNEL(stationary_wavelet_denoise)
+#define wavelet_apply2D KERNEL(wavelet_apply2D)
+#define wavelet_apply2D_uint8 KERNEL(wavelet_apply2D_uint8)
+#define stationary_wavelet_apply2D KERNEL(stationary_wavelet_apply2D)
+#define stationary_wavelet_apply2D_uint8 \
+    KERNEL(stationary_wavelet_apply2D_uint8)
+#define wavelet_apply_batch KERNEL(wavelet_apply_batch)
+#define wavelet_handle_initialize KERNEL(wavelet_handle_initialize)
+#define wavelet_handle_apply KERNEL(wavelet_handle_apply)
+#define wavelet_handle_finalize KERNEL(wavelet_handle_finalize)
+#define wavelet_apply_double KERNEL(wavelet_apply_double)
+#define stationary_wavelet_apply_double KERNEL(stationary_wavelet_apply_double)
+#define wavelet_lifting_validate_order KERNEL(wavelet_lifting_validate_order)
+#define wavelet_lifting_apply KERNEL(wavelet_lifting_apply)
 #include "inc/simd/wavelet.h"
 #include <assert.h>
+#include <math.h>
+#include <pthread.h>
 #include <string.h>
 #include "inc/simd/arithmetic.h"
 #define WAVELET_INTERNAL_USE
@@ -38,6 +77,7 @@
 #include "src/daubechies.h"
 #include "src/symlets.h"
 #include "inc/simd/memory.h"
+#include "src/dot_product.h"
 
 #define max(a,b) \
    ({ \
@@ -65,17 +105,19 @@ INLINE NOTNULL(2, 4) void wavelet_prepare_array_memcpy(
     int order, const float *src, size_t length, float *res) {
   check_length(length);
 
+  // memcpyf() bypasses the cache for the arrays which do not fit into it
   if (res != src) {
-    memcpy(res, src, length * sizeof(float));
+    memcpyf(res, src, length);
   }
 
   if (length > 8) {
     size_t alength = aligned_length(length);
-    int copySize = (alength - 8) * sizeof(float);
-    memcpy(res + alength,          src + 2, copySize);
+    size_t copyLength = alength - 8;
+    // The copies are taken from res which is alength long, src may be not
+    memcpyf(res + alength,          res + 2, copyLength);
     if (order > 4) {
-      memcpy(res + alength * 2 -  8, src + 4, copySize);
-      memcpy(res + alength * 3 - 16, src + 6, copySize);
+      memcpyf(res + alength * 2 -  8, res + 4, copyLength);
+      memcpyf(res + alength * 3 - 16, res + 6, copyLength);
     }
   }
 }
@@ -108,11 +150,11 @@ float *wavelet_prepare_array(int order
 ) {
   check_length(length);
 #ifndef __AVX__
-  float *res = mallocf(length);
+  float *res = mallocf_ex(length, kMemoryFlagHugePages);
   memcpy(res, src, length * sizeof(src[0]));
 #else
   size_t alength = aligned_length(length);
-  float *res = mallocf(alength * (order > 4? 4 : 2));
+  float *res = mallocf_ex(alength * (order > 4? 4 : 2), kMemoryFlagHugePages);
   wavelet_prepare_array_memcpy(order, src, length, res);
 #endif
   return res;
@@ -127,10 +169,10 @@ float *wavelet_allocate_destination(int order
   assert(sourceLength % 4 == 0);
 
 #ifndef __AVX__
-  float *res = mallocf(sourceLength / 2);
+  float *res = mallocf_ex(sourceLength / 2, kMemoryFlagHugePages);
 #else
   size_t alength = aligned_length(sourceLength);
-  float *res = mallocf(alength * (order > 4? 2 : 1));
+  float *res = mallocf_ex(alength * (order > 4? 2 : 1), kMemoryFlagHugePages);
 #endif
   return res;
 }
@@ -164,6 +206,18 @@ void wavelet_recycle_source(int order
   *destlolo = src + lq * 3;
 }
 
+/// @brief The longest filter in the tables. The taps and the extensions of
+/// the decimated transforms are fixed size arrays of it on the stack, which
+/// never overflow the threads with the small stacks.
+#define WAVELET_MAX_ORDER \
+    ((int)(sizeof(kDaubechiesF[0]) / sizeof(kDaubechiesF[0][0])))
+
+/// @brief The extensions of the stationary transforms up to this number of
+/// samples stay on the stack, the longer ones of the high levels
+/// ((order - 1) * 2^(level - 1) + 1 samples) are taken from mallocf(), that
+/// is, from the SimdAllocator in effect, e.g. an arena which reuses them.
+#define WAVELET_STACK_EXTENSION 512
+
 INLINE void check_wavelet_order(WaveletType type, size_t order) {
   switch (type) {
     case WAVELET_TYPE_DAUBECHIES:
@@ -275,9 +329,9 @@ void wavelet_apply_na(WaveletType type, int order, ExtensionType ext,
   assert(src && desthi && destlo);
 
   int ilength = (int)length;
-  float highpassC[order], lowpassC[order];
+  float highpassC[WAVELET_MAX_ORDER], lowpassC[WAVELET_MAX_ORDER];
   initialize_highpass_lowpass(type, order, highpassC, lowpassC);
-  float src_ext[order];
+  float src_ext[WAVELET_MAX_ORDER];
   initialize_extension(ext, order, src, length, src_ext);
 
   if (ilength != order) {
@@ -330,54 +384,33 @@ void stationary_wavelet_apply_na(WaveletType type, int order, int level,
   assert(length > 0);
   assert(src && desthi && destlo);
 
-  int size = order * (1 << (level - 1));
+  // The dilated filter has stride - 1 zeros between the taps of the plain
+  // one, see stationary_initialize_highpass_lowpass(), so only the latter
+  // are stored
+  int stride = 1 << (level - 1);
+  int span = (order - 1) * stride;
   int ilength = (int)length;
-  float highpassC[size], lowpassC[size];
-  stationary_initialize_highpass_lowpass(type, size, level, highpassC,
-                                         lowpassC);
-  float src_ext[size];
-  initialize_extension(ext, size, src, length, src_ext);
+  float highpassC[WAVELET_MAX_ORDER], lowpassC[WAVELET_MAX_ORDER];
+  initialize_highpass_lowpass(type, order, highpassC, lowpassC);
+  float stack_ext[WAVELET_STACK_EXTENSION];
+  float *src_ext = span + 1 <= WAVELET_STACK_EXTENSION?
+      stack_ext : mallocf(span + 1);
+  assert(src_ext);
+  initialize_extension(ext, span + 1, src, length, src_ext);
 
-  int stride = 1 << (level - 1);
-  if (ilength != size) {
-    for (int i = 0; i < ilength; i++) {
-      float reshi = 0.f, reslo = 0.f;
-      for (int j = 0; j < size; j += stride) {
-        int index = i + j;
-        float srcval = index < ilength? src[index] : src_ext[index - ilength];
-        reshi += highpassC[j] * srcval;
-        reslo += lowpassC[j] * srcval;
-      }
-      desthi[i] = reshi;
-      destlo[i] = reslo;
-    }
-  } else {
-    if (size == 8) {
-      // Give a chance to the compiler to optimize these two loops
-      for (int i = 0; i < 8; i++) {
-        float reshi = 0.f, reslo = 0.f;
-        for (int j = 0; j < 8; j += stride) {
-          int index = i + j;
-          float srcval = index < 8? src[index] : src_ext[index - 8];
-          reshi += highpassC[j] * srcval;
-          reslo += lowpassC[j] * srcval;
-        }
-        desthi[i] = reshi;
-        destlo[i] = reslo;
-      }
-    } else {
-      for (int i = 0; i < size; i++) {
-        float reshi = 0.f, reslo = 0.f;
-        for (int j = 0; j < size; j += stride) {
-          int index = i + j;
-          float srcval = index < size? src[index] : src_ext[index - size];
-          reshi += highpassC[j] * srcval;
-          reslo += lowpassC[j] * srcval;
-        }
-        desthi[i] = reshi;
-        destlo[i] = reslo;
-      }
+  for (int i = 0; i < ilength; i++) {
+    float reshi = 0.f, reslo = 0.f;
+    for (int j = 0; j < order; j++) {
+      int index = i + j * stride;
+      float srcval = index < ilength? src[index] : src_ext[index - ilength];
+      reshi += highpassC[j] * srcval;
+      reslo += lowpassC[j] * srcval;
     }
+    desthi[i] = reshi;
+    destlo[i] = reslo;
+  }
+  if (src_ext != stack_ext) {
+    free_aligned(src_ext);
   }
 }
 
@@ -1084,8 +1117,8 @@ static void wavelet_apply8(WaveletType type, ExtensionType ext,
 
     float32x4_t vechiadd = vmulq_f32(srcvec1, hivec1);
     float32x4_t vecloadd = vmulq_f32(srcvec1, lovec1);
-    vechiadd = vmlaq_f32(vechiadd, srcvec2, hivec2);
-    vecloadd = vmlaq_f32(vecloadd, srcvec2, lovec2);
+    vechiadd = madd128(srcvec2, hivec2, vechiadd);
+    vecloadd = madd128(srcvec2, lovec2, vecloadd);
 
     float32x2_t vechipair = vadd_f32(vget_high_f32(vechiadd),
                                      vget_low_f32(vechiadd));
@@ -1179,8 +1212,8 @@ static void stationary_wavelet_apply8(WaveletType type, int level,
 
     float32x4_t vechiadd = vmulq_f32(srcvec1, hivec1);
     float32x4_t vecloadd = vmulq_f32(srcvec1, lovec1);
-    vechiadd = vmlaq_f32(vechiadd, srcvec2, hivec2);
-    vecloadd = vmlaq_f32(vecloadd, srcvec2, lovec2);
+    vechiadd = madd128(srcvec2, hivec2, vechiadd);
+    vecloadd = madd128(srcvec2, lovec2, vecloadd);
 
     float32x2_t vechipair = vadd_f32(vget_high_f32(vechiadd),
                                      vget_low_f32(vechiadd));
@@ -1284,10 +1317,10 @@ static void wavelet_apply12(WaveletType type, ExtensionType ext,
 
     float32x4_t vechiadd = vmulq_f32(srcvec1, hivec1);
     float32x4_t vecloadd = vmulq_f32(srcvec1, lovec1);
-    vechiadd = vmlaq_f32(vechiadd, srcvec2, hivec2);
-    vecloadd = vmlaq_f32(vecloadd, srcvec2, lovec2);
-    vechiadd = vmlaq_f32(vechiadd, srcvec3, hivec3);
-    vecloadd = vmlaq_f32(vecloadd, srcvec3, lovec3);
+    vechiadd = madd128(srcvec2, hivec2, vechiadd);
+    vecloadd = madd128(srcvec2, lovec2, vecloadd);
+    vechiadd = madd128(srcvec3, hivec3, vechiadd);
+    vecloadd = madd128(srcvec3, lovec3, vecloadd);
 
     float32x2_t vechipair = vadd_f32(vget_high_f32(vechiadd),
                                      vget_low_f32(vechiadd));
@@ -1413,10 +1446,10 @@ static void stationary_wavelet_apply12(WaveletType type, int level,
 
     float32x4_t vechiadd = vmulq_f32(srcvec1, hivec1);
     float32x4_t vecloadd = vmulq_f32(srcvec1, lovec1);
-    vechiadd = vmlaq_f32(vechiadd, srcvec2, hivec2);
-    vecloadd = vmlaq_f32(vecloadd, srcvec2, lovec2);
-    vechiadd = vmlaq_f32(vechiadd, srcvec3, hivec3);
-    vecloadd = vmlaq_f32(vecloadd, srcvec3, lovec3);
+    vechiadd = madd128(srcvec2, hivec2, vechiadd);
+    vecloadd = madd128(srcvec2, lovec2, vecloadd);
+    vechiadd = madd128(srcvec3, hivec3, vechiadd);
+    vecloadd = madd128(srcvec3, lovec3, vecloadd);
 
     float32x2_t vechipair = vadd_f32(vget_high_f32(vechiadd),
                                      vget_low_f32(vechiadd));
@@ -1507,12 +1540,12 @@ static void wavelet_apply16(WaveletType type, ExtensionType ext,
 
     float32x4_t vechiadd = vmulq_f32(srcvec1, hivec1);
     float32x4_t vecloadd = vmulq_f32(srcvec1, lovec1);
-    vechiadd = vmlaq_f32(vechiadd, srcvec2, hivec2);
-    vecloadd = vmlaq_f32(vecloadd, srcvec2, lovec2);
-    vechiadd = vmlaq_f32(vechiadd, srcvec3, hivec3);
-    vecloadd = vmlaq_f32(vecloadd, srcvec3, lovec3);
-    vechiadd = vmlaq_f32(vechiadd, srcvec4, hivec4);
-    vecloadd = vmlaq_f32(vecloadd, srcvec4, lovec4);
+    vechiadd = madd128(srcvec2, hivec2, vechiadd);
+    vecloadd = madd128(srcvec2, lovec2, vecloadd);
+    vechiadd = madd128(srcvec3, hivec3, vechiadd);
+    vecloadd = madd128(srcvec3, lovec3, vecloadd);
+    vechiadd = madd128(srcvec4, hivec4, vechiadd);
+    vecloadd = madd128(srcvec4, lovec4, vecloadd);
 
     float32x2_t vechipair = vadd_f32(vget_high_f32(vechiadd),
                                      vget_low_f32(vechiadd));
@@ -1629,12 +1662,12 @@ static void stationary_wavelet_apply16(WaveletType type, int level,
 
     float32x4_t vechiadd = vmulq_f32(srcvec1, hivec1);
     float32x4_t vecloadd = vmulq_f32(srcvec1, lovec1);
-    vechiadd = vmlaq_f32(vechiadd, srcvec2, hivec2);
-    vecloadd = vmlaq_f32(vecloadd, srcvec2, lovec2);
-    vechiadd = vmlaq_f32(vechiadd, srcvec3, hivec3);
-    vecloadd = vmlaq_f32(vecloadd, srcvec3, lovec3);
-    vechiadd = vmlaq_f32(vechiadd, srcvec4, hivec4);
-    vecloadd = vmlaq_f32(vecloadd, srcvec4, lovec4);
+    vechiadd = madd128(srcvec2, hivec2, vechiadd);
+    vecloadd = madd128(srcvec2, lovec2, vecloadd);
+    vechiadd = madd128(srcvec3, hivec3, vechiadd);
+    vecloadd = madd128(srcvec3, lovec3, vecloadd);
+    vechiadd = madd128(srcvec4, hivec4, vechiadd);
+    vecloadd = madd128(srcvec4, lovec4, vecloadd);
 
     float32x2_t vechipair = vadd_f32(vget_high_f32(vechiadd),
                                      vget_low_f32(vechiadd));
@@ -1680,7 +1713,9 @@ static void stationary_wavelet_applyN_core(const float* highpassC,
 #ifdef __AVX__
   assert(size % 16 == 0);
   for (int i = 0; i < (int)length - size + 1; i++) {
-    __m256 rvechi = _mm256_set1_ps(0), rveclo = _mm256_set1_ps(0);
+    // Independent accumulators for each half, see src/dot_product.h
+    __m256 rvechi1 = _mm256_setzero_ps(), rveclo1 = _mm256_setzero_ps();
+    __m256 rvechi2 = _mm256_setzero_ps(), rveclo2 = _mm256_setzero_ps();
     for (int j = 0; j < size; j += 16) {
       __m256 srcvec1 = _mm256_loadu_ps(src + i + j);
       __m256 srcvec2 = _mm256_loadu_ps(src + i + j + 8);
@@ -1688,26 +1723,13 @@ static void stationary_wavelet_applyN_core(const float* highpassC,
       __m256 lovec1 = _mm256_loadu_ps(lowpassC + j);
       __m256 hivec2 = _mm256_loadu_ps(highpassC + j + 8);
       __m256 lovec2 = _mm256_loadu_ps(lowpassC + j + 8);
-      __m256 mulvechi1 = _mm256_mul_ps(srcvec1, hivec1);
-      __m256 mulveclo1 = _mm256_mul_ps(srcvec1, lovec1);
-      __m256 mulvechi2 = _mm256_mul_ps(srcvec2, hivec2);
-      __m256 mulveclo2 = _mm256_mul_ps(srcvec2, lovec2);
-
-      rvechi = _mm256_add_ps(rvechi, mulvechi1);
-      rvechi = _mm256_add_ps(rvechi, mulvechi2);
-      rveclo = _mm256_add_ps(rveclo, mulveclo1);
-      rveclo = _mm256_add_ps(rveclo, mulveclo2);
+      rvechi1 = madd256(srcvec1, hivec1, rvechi1);
+      rveclo1 = madd256(srcvec1, lovec1, rveclo1);
+      rvechi2 = madd256(srcvec2, hivec2, rvechi2);
+      rveclo2 = madd256(srcvec2, lovec2, rveclo2);
     }
-    rvechi = _mm256_hadd_ps(rvechi, rvechi);
-    rvechi = _mm256_hadd_ps(rvechi, rvechi);
-    rveclo = _mm256_hadd_ps(rveclo, rveclo);
-    rveclo = _mm256_hadd_ps(rveclo, rveclo);
-
-    float reshi = _mm256_get_ps(rvechi, 0) + _mm256_get_ps(rvechi, 4);
-    float reslo = _mm256_get_ps(rveclo, 0) + _mm256_get_ps(rveclo, 4);
-
-    desthi[i] = reshi;
-    destlo[i] = reslo;
+    desthi[i] = hsum256(_mm256_add_ps(rvechi1, rvechi2));
+    destlo[i] = hsum256(_mm256_add_ps(rveclo1, rveclo2));
   }
 #elif defined(__ARM_NEON__)
   assert(size % 8 == 0);
@@ -1720,10 +1742,10 @@ static void stationary_wavelet_applyN_core(const float* highpassC,
       float32x4_t lovec1 = vld1q_f32(lowpassC + j);
       float32x4_t hivec2 = vld1q_f32(highpassC + j + 4);
       float32x4_t lovec2 = vld1q_f32(lowpassC + j + 4);
-      rvechi = vmlaq_f32(rvechi, srcvec1, hivec1);
-      rveclo = vmlaq_f32(rveclo, srcvec1, lovec1);
-      rvechi = vmlaq_f32(rvechi, srcvec2, hivec2);
-      rveclo = vmlaq_f32(rveclo, srcvec2, lovec2);
+      rvechi = madd128(srcvec1, hivec1, rvechi);
+      rveclo = madd128(srcvec1, lovec1, rveclo);
+      rvechi = madd128(srcvec2, hivec2, rvechi);
+      rveclo = madd128(srcvec2, lovec2, rveclo);
     }
 
     float32x2_t vechipair = vadd_f32(vget_high_f32(rvechi),
@@ -1849,10 +1871,12 @@ static void stationary_wavelet_applyN(WaveletType type, int size, int level,
   }
 
   int ilength = (int)length;
-  DECLARE_PASSC(size);
+  // The dilated filter is at most twice as long as the plain one here
+  assert(size <= 2 * WAVELET_MAX_ORDER);
+  DECLARE_PASSC(2 * WAVELET_MAX_ORDER);
   stationary_initialize_highpass_lowpass(type, size, level,
                                          highpassC, lowpassC);
-  float src_ext[size];
+  float src_ext[2 * WAVELET_MAX_ORDER];
   initialize_extension(ext, size, src, length, src_ext);
 
   stationary_wavelet_applyN_core(highpassC, lowpassC, size, src, length,
@@ -1875,6 +1899,260 @@ static void stationary_wavelet_applyN(WaveletType type, int size, int level,
 #endif
 }
 
+#if defined(__AVX__) || defined(__ARM_NEON__)
+
+/* The universal decimated kernel works on the even and the odd samples
+ * separately: src[2 * di + j] is even[di + j / 2] or odd[di + j / 2], which
+ * are contiguous in di. So WAVELET_NV vectors of consecutive outputs are
+ * updated with each broadcast tap and there is no horizontal reduction.
+ * The even and the odd samples of each block are split in registers from
+ * the unaligned source, see wavelet_deinterleave(). */
+#if defined(__AVX512F__)
+
+#define WAVELET_NV 2
+#define WAVELET_VL 16
+typedef __m512 wavelet_vec;
+#define wavelet_loadu(ptr) _mm512_loadu_ps(ptr)
+#define wavelet_storeu(ptr, vec) _mm512_storeu_ps(ptr, vec)
+#define wavelet_set1(value) _mm512_set1_ps(value)
+#define wavelet_zero() _mm512_setzero_ps()
+#define wavelet_madd(a, b, c) _mm512_fmadd_ps(a, b, c)
+
+#elif defined(__AVX__)
+
+#ifdef SIMD_AVX_EMULATION
+/* Every emulated register is a pair of SSE ones, only 16 are available */
+#define WAVELET_NV 1
+#else
+#define WAVELET_NV 2
+#endif
+#define WAVELET_VL 8
+typedef __m256 wavelet_vec;
+#define wavelet_loadu(ptr) _mm256_loadu_ps(ptr)
+#define wavelet_storeu(ptr, vec) _mm256_storeu_ps(ptr, vec)
+#define wavelet_set1(value) _mm256_set1_ps(value)
+#define wavelet_zero() _mm256_setzero_ps()
+#define wavelet_madd(a, b, c) madd256(a, b, c)
+
+#else  // __ARM_NEON__
+
+#ifdef __aarch64__
+/* 32 quad registers: 8 accumulators, 4 broadcast taps and the sources */
+#define WAVELET_NV 4
+#else
+#define WAVELET_NV 2
+#endif
+#define WAVELET_VL 4
+typedef float32x4_t wavelet_vec;
+#define wavelet_loadu(ptr) vld1q_f32(ptr)
+#define wavelet_storeu(ptr, vec) vst1q_f32(ptr, vec)
+#define wavelet_set1(value) vdupq_n_f32(value)
+#define wavelet_zero() vdupq_n_f32(0.f)
+#define wavelet_madd(a, b, c) madd128(a, b, c)
+
+#endif
+
+#define WAVELET_BLOCK (WAVELET_NV * WAVELET_VL)
+
+#if WAVELET_NV == 1
+#define WAVELET_VECTORS(X) X(0)
+#elif WAVELET_NV == 2
+#define WAVELET_VECTORS(X) X(0) X(1)
+#else
+#define WAVELET_VECTORS(X) X(0) X(1) X(2) X(3)
+#endif
+
+#define WAVELET_DECLARE(i) \
+    wavelet_vec hi##i = wavelet_zero(), lo##i = wavelet_zero();
+#define WAVELET_UPDATE(i) { \
+    wavelet_vec evenvec = wavelet_loadu(even + m + i * WAVELET_VL); \
+    wavelet_vec oddvec = wavelet_loadu(odd + m + i * WAVELET_VL); \
+    hi##i = wavelet_madd(evenvec, hpeven, hi##i); \
+    lo##i = wavelet_madd(evenvec, lpeven, lo##i); \
+    hi##i = wavelet_madd(oddvec, hpodd, hi##i); \
+    lo##i = wavelet_madd(oddvec, lpodd, lo##i); \
+}
+#define WAVELET_ATROUS_UPDATE(i) { \
+    wavelet_vec srcvec = wavelet_loadu( \
+        src + di + j * stride + i * WAVELET_VL); \
+    hi##i = wavelet_madd(srcvec, hpvec, hi##i); \
+    lo##i = wavelet_madd(srcvec, lpvec, lo##i); \
+}
+#define WAVELET_STORE(i) \
+    wavelet_storeu(desthi + di + i * WAVELET_VL, hi##i); \
+    wavelet_storeu(destlo + di + i * WAVELET_VL, lo##i);
+
+/// @brief Splits 2 * WAVELET_VL consecutive samples into the even and the
+/// odd ones.
+#if defined(__AVX512F__)
+INLINE void wavelet_deinterleave(const float *src, float *even, float *odd) {
+  const __m512i evenidx = _mm512_set_epi32(30, 28, 26, 24, 22, 20, 18, 16,
+                                           14, 12, 10, 8, 6, 4, 2, 0);
+  const __m512i oddidx = _mm512_set_epi32(31, 29, 27, 25, 23, 21, 19, 17,
+                                          15, 13, 11, 9, 7, 5, 3, 1);
+  __m512 a = _mm512_loadu_ps(src), b = _mm512_loadu_ps(src + 16);
+  _mm512_storeu_ps(even, _mm512_permutex2var_ps(a, evenidx, b));
+  _mm512_storeu_ps(odd, _mm512_permutex2var_ps(a, oddidx, b));
+}
+#elif defined(__AVX__)
+INLINE void wavelet_deinterleave(const float *src, float *even, float *odd) {
+  __m256 a = _mm256_loadu_ps(src), b = _mm256_loadu_ps(src + 8);
+  // Each 128-bit lane gets four consecutive samples of each half
+  __m256 first = _mm256_permute2f128_ps(a, b, 0x20);
+  __m256 second = _mm256_permute2f128_ps(a, b, 0x31);
+  _mm256_storeu_ps(even, _mm256_shuffle_ps(first, second, 0x88));
+  _mm256_storeu_ps(odd, _mm256_shuffle_ps(first, second, 0xDD));
+}
+#else
+INLINE void wavelet_deinterleave(const float *src, float *even, float *odd) {
+  float32x4x2_t pair = vld2q_f32(src);
+  vst1q_f32(even, pair.val[0]);
+  vst1q_f32(odd, pair.val[1]);
+}
+#endif
+
+#endif  // defined(__AVX__) || defined(__ARM_NEON__)
+
+/// @brief The decimated transform of any supported order with the filters
+/// which are already initialized.
+/// @details The source is read only in the plain format, so it may or may
+/// not be prepared with wavelet_prepare_array().
+static void wavelet_applyN_taps(const float *highpassC,
+                                const float *lowpassC, int order,
+                                ExtensionType ext,
+                                const float *__restrict src, size_t length,
+                                float *__restrict desthi,
+                                float *__restrict destlo) {
+  check_length(length);
+  assert(src && desthi && destlo);
+
+  float src_ext[WAVELET_MAX_ORDER];
+  initialize_extension(ext, order, src, length, src_ext);
+  int di = 0;
+#ifdef WAVELET_BLOCK
+  int half = (int)length / 2;
+  int taps = order / 2;
+  int window = WAVELET_BLOCK + taps - 1;
+  if (half >= window) {
+    // The windows of the block are split right from src, so that neither
+    // wavelet_prepare_array() nor a full size copy is needed
+    float even[WAVELET_BLOCK + WAVELET_MAX_ORDER / 2 + WAVELET_VL]
+        __attribute__((aligned(64)));
+    float odd[WAVELET_BLOCK + WAVELET_MAX_ORDER / 2 + WAVELET_VL]
+        __attribute__((aligned(64)));
+    for (; di + window <= half; di += WAVELET_BLOCK) {
+      const float *block = src + di * 2;
+      int k = 0;
+      for (; k < window && di + k + WAVELET_VL <= half; k += WAVELET_VL) {
+        wavelet_deinterleave(block + k * 2, even + k, odd + k);
+      }
+      for (; k < window; k++) {
+        even[k] = block[k * 2];
+        odd[k] = block[k * 2 + 1];
+      }
+      WAVELET_VECTORS(WAVELET_DECLARE)
+      for (int m = 0; m < taps; m++) {
+        wavelet_vec hpeven = wavelet_set1(highpassC[m * 2]);
+        wavelet_vec hpodd = wavelet_set1(highpassC[m * 2 + 1]);
+        wavelet_vec lpeven = wavelet_set1(lowpassC[m * 2]);
+        wavelet_vec lpodd = wavelet_set1(lowpassC[m * 2 + 1]);
+        WAVELET_VECTORS(WAVELET_UPDATE)
+      }
+      WAVELET_VECTORS(WAVELET_STORE)
+    }
+  }
+#endif
+  // Finish with the extended end
+  int ilength = (int)length;
+  for (int i = di * 2; i < ilength; i += 2, di++) {
+    float reshi = 0.f, reslo = 0.f;
+    for (int j = 0; j < order; j++) {
+      int index = i + j;
+      float srcval = index < ilength? src[index] : src_ext[index - ilength];
+      reshi += highpassC[j] * srcval;
+      reslo += lowpassC[j] * srcval;
+    }
+    desthi[di] = reshi;
+    destlo[di] = reslo;
+  }
+}
+
+/// @brief The decimated transform of any supported order.
+static void wavelet_applyN(WaveletType type, int order, ExtensionType ext,
+                           const float *__restrict src, size_t length,
+                           float *__restrict desthi,
+                           float *__restrict destlo) {
+  float highpassC[WAVELET_MAX_ORDER], lowpassC[WAVELET_MAX_ORDER];
+  initialize_highpass_lowpass(type, order, highpassC, lowpassC);
+  wavelet_applyN_taps(highpassC, lowpassC, order, ext, src, length,
+                      desthi, destlo);
+}
+
+/// @brief The stationary transform with the filters which are already
+/// initialized, the taps are stride samples apart.
+/// @details Implements the "a trous" algorithm: the filter is dilated with
+/// stride - 1 zeros between the taps, so only the real order taps are
+/// multiplied by the source samples which are stride apart. Consecutive
+/// outputs read consecutive samples, so the cost does not depend on level.
+static void stationary_wavelet_apply_atrous_taps(
+    const float *highpassC, const float *lowpassC, int order, int stride,
+    ExtensionType ext, const float *__restrict src, size_t length,
+    float *__restrict desthi, float *__restrict destlo) {
+  assert(length > 0);
+  assert(src && desthi && destlo);
+
+  int span = (order - 1) * stride;
+  int ilength = (int)length;
+  float stack_ext[WAVELET_STACK_EXTENSION];
+  float *src_ext = span + 1 <= WAVELET_STACK_EXTENSION?
+      stack_ext : mallocf(span + 1);
+  assert(src_ext);
+  initialize_extension(ext, span + 1, src, length, src_ext);
+
+  int di = 0;
+#ifdef WAVELET_BLOCK
+  for (; di + WAVELET_BLOCK + span <= ilength; di += WAVELET_BLOCK) {
+    WAVELET_VECTORS(WAVELET_DECLARE)
+    for (int j = 0; j < order; j++) {
+      wavelet_vec hpvec = wavelet_set1(highpassC[j]);
+      wavelet_vec lpvec = wavelet_set1(lowpassC[j]);
+      WAVELET_VECTORS(WAVELET_ATROUS_UPDATE)
+    }
+    WAVELET_VECTORS(WAVELET_STORE)
+  }
+#endif
+  // Finish with the extended end
+  for (; di < ilength; di++) {
+    float reshi = 0.f, reslo = 0.f;
+    for (int j = 0; j < order; j++) {
+      int index = di + j * stride;
+      float srcval = index < ilength? src[index] : src_ext[index - ilength];
+      reshi += highpassC[j] * srcval;
+      reslo += lowpassC[j] * srcval;
+    }
+    desthi[di] = reshi;
+    destlo[di] = reslo;
+  }
+  if (src_ext != stack_ext) {
+    free_aligned(src_ext);
+  }
+}
+
+/// @brief The stationary transform of the levels above the first one.
+static void stationary_wavelet_apply_atrous(WaveletType type, int order,
+                                            int level, ExtensionType ext,
+                                            const float *__restrict src,
+                                            size_t length,
+                                            float *__restrict desthi,
+                                            float *__restrict destlo) {
+  // The dilated filter has the same taps as the plain one
+  float highpassC[WAVELET_MAX_ORDER], lowpassC[WAVELET_MAX_ORDER];
+  initialize_highpass_lowpass(type, order, highpassC, lowpassC);
+  stationary_wavelet_apply_atrous_taps(highpassC, lowpassC, order,
+                                       1 << (level - 1), ext, src, length,
+                                       desthi, destlo);
+}
+
 void wavelet_apply(WaveletType type, int order, ExtensionType ext,
                    const float *__restrict src, size_t length,
                    float *__restrict desthi, float *__restrict destlo) {
@@ -1898,17 +2176,27 @@ void wavelet_apply(WaveletType type, int order, ExtensionType ext,
       wavelet_apply16(type, ext, src, length, desthi, destlo);
       break;
     default:
-      // TODO(v.markovtsev): implement universal SIMD version
-      wavelet_apply_na(type, order, ext, src, length, desthi, destlo);
+      wavelet_applyN(type, order, ext, src, length, desthi, destlo);
       break;
   }
 }
 
+void wavelet_apply_plain(WaveletType type, int order, ExtensionType ext,
+                         const float *__restrict src, size_t length,
+                         float *__restrict desthi, float *__restrict destlo) {
+  wavelet_applyN(type, order, ext, src, length, desthi, destlo);
+}
+
 void stationary_wavelet_apply(WaveletType type, int order, int level,
                               ExtensionType ext,
                               const float *__restrict src, size_t length,
                               float *__restrict desthi,
                               float *__restrict destlo) {
+  if (level > 1) {
+    stationary_wavelet_apply_atrous(type, order, level, ext, src, length,
+                                    desthi, destlo);
+    return;
+  }
   int size = order * (1 << (level - 1));
   switch (size) {
     case 2:
@@ -1933,8 +2221,1497 @@ void stationary_wavelet_apply(WaveletType type, int order, int level,
       stationary_wavelet_apply24(type, level, ext, src, length, desthi, destlo);
       break;
     default:
-      stationary_wavelet_applyN(type, size, level, ext, src, length,
-                                desthi, destlo);
+      // The generic core steps over the filter by 16 taps
+      if (size % 16 == 0) {
+        stationary_wavelet_applyN(type, size, level, ext, src, length,
+                                  desthi, destlo);
+      } else {
+        stationary_wavelet_apply_atrous(type, order, level, ext, src, length,
+                                        desthi, destlo);
+      }
       break;
   }
 }
+
+INLINE float shrink_value(ShrinkageType shrinkage, float threshold,
+                          float value) {
+  float absval = fabsf(value);
+  switch (shrinkage) {
+    case SHRINKAGE_TYPE_SOFT:
+      return absval > threshold? copysignf(absval - threshold, value) : 0.f;
+    case SHRINKAGE_TYPE_HARD:
+      return absval > threshold? value : 0.f;
+    case SHRINKAGE_TYPE_GARROTE:
+      return absval > threshold? value - threshold * threshold / value : 0.f;
+  }
+  return value;
+}
+
+void wavelet_shrink(ShrinkageType shrinkage, float threshold,
+                    const float *src, size_t length, float *dest) {
+  assert(threshold >= 0);
+  size_t i = 0;
+#ifdef WAVELET_BLOCK
+#if defined(__AVX512F__)
+  const __m512 thrvec = _mm512_set1_ps(threshold);
+  const __m512 thr2vec = _mm512_set1_ps(threshold * threshold);
+  const __m512 zero = _mm512_setzero_ps();
+  for (; i + 16 <= length; i += 16) {
+    __m512 vec = _mm512_loadu_ps(src + i);
+    __m512 res;
+    switch (shrinkage) {
+      case SHRINKAGE_TYPE_SOFT:
+        res = _mm512_add_ps(
+            _mm512_max_ps(_mm512_sub_ps(vec, thrvec), zero),
+            _mm512_min_ps(_mm512_add_ps(vec, thrvec), zero));
+        break;
+      case SHRINKAGE_TYPE_HARD: {
+        __mmask16 mask = _mm512_cmp_ps_mask(thrvec, _mm512_abs_ps(vec),
+                                            _CMP_LT_OS);
+        res = _mm512_maskz_mov_ps(mask, vec);
+        break;
+      }
+      default: {
+        __mmask16 mask = _mm512_cmp_ps_mask(thrvec, _mm512_abs_ps(vec),
+                                            _CMP_LT_OS);
+        res = _mm512_maskz_sub_ps(mask, vec, _mm512_maskz_div_ps(
+            mask, thr2vec, vec));
+        break;
+      }
+    }
+    _mm512_storeu_ps(dest + i, res);
+  }
+#elif defined(__AVX__)
+  const __m256 thrvec = _mm256_set1_ps(threshold);
+  const __m256 thr2vec = _mm256_set1_ps(threshold * threshold);
+  const __m256 signmask = _mm256_set1_ps(-0.f);
+  const __m256 zero = _mm256_setzero_ps();
+  for (; i + 8 <= length; i += 8) {
+    __m256 vec = _mm256_loadu_ps(src + i);
+    __m256 res;
+    switch (shrinkage) {
+      case SHRINKAGE_TYPE_SOFT:
+        res = _mm256_add_ps(
+            _mm256_max_ps(_mm256_sub_ps(vec, thrvec), zero),
+            _mm256_min_ps(_mm256_add_ps(vec, thrvec), zero));
+        break;
+      case SHRINKAGE_TYPE_HARD: {
+        __m256 mask = _mm256_cmp_ps(thrvec, _mm256_andnot_ps(signmask, vec),
+                                    _CMP_LT_OS);
+        res = _mm256_and_ps(mask, vec);
+        break;
+      }
+      default: {
+        __m256 mask = _mm256_cmp_ps(thrvec, _mm256_andnot_ps(signmask, vec),
+                                    _CMP_LT_OS);
+        // The masked out lanes may be infinite or NaN, the mask zeroes them
+        res = _mm256_and_ps(mask, _mm256_sub_ps(
+            vec, _mm256_div_ps(thr2vec, vec)));
+        break;
+      }
+    }
+    _mm256_storeu_ps(dest + i, res);
+  }
+#else  // __ARM_NEON__
+  const float32x4_t thrvec = vdupq_n_f32(threshold);
+  const float32x4_t thr2vec = vdupq_n_f32(threshold * threshold);
+  const float32x4_t zero = vdupq_n_f32(0.f);
+  for (; i + 4 <= length; i += 4) {
+    float32x4_t vec = vld1q_f32(src + i);
+    float32x4_t res;
+    switch (shrinkage) {
+      case SHRINKAGE_TYPE_SOFT:
+        res = vaddq_f32(vmaxq_f32(vsubq_f32(vec, thrvec), zero),
+                        vminq_f32(vaddq_f32(vec, thrvec), zero));
+        break;
+      case SHRINKAGE_TYPE_HARD: {
+        uint32x4_t mask = vcltq_f32(thrvec, vabsq_f32(vec));
+        res = vreinterpretq_f32_u32(vandq_u32(
+            mask, vreinterpretq_u32_f32(vec)));
+        break;
+      }
+      default: {
+        uint32x4_t mask = vcltq_f32(thrvec, vabsq_f32(vec));
+        // 1 / vec with two Newton-Raphson refinements
+        float32x4_t inv = vrecpeq_f32(vec);
+        inv = vmulq_f32(vrecpsq_f32(vec, inv), inv);
+        inv = vmulq_f32(vrecpsq_f32(vec, inv), inv);
+        res = vsubq_f32(vec, vmulq_f32(thr2vec, inv));
+        res = vreinterpretq_f32_u32(vandq_u32(
+            mask, vreinterpretq_u32_f32(res)));
+        break;
+      }
+    }
+    vst1q_f32(dest + i, res);
+  }
+#endif
+#endif  // WAVELET_BLOCK
+  for (; i < length; i++) {
+    dest[i] = shrink_value(shrinkage, threshold, src[i]);
+  }
+}
+
+/// @brief Returns the k-th smallest element of data, which is reordered.
+static float quickselect(float *data, int length, int k) {
+  int left = 0, right = length - 1;
+  while (left < right) {
+    float pivot = data[(left + right) / 2];
+    int i = left, j = right;
+    while (i <= j) {
+      while (data[i] < pivot) i++;
+      while (data[j] > pivot) j--;
+      if (i <= j) {
+        float tmp = data[i];
+        data[i++] = data[j];
+        data[j--] = tmp;
+      }
+    }
+    if (k <= j) {
+      right = j;
+    } else if (k >= i) {
+      left = i;
+    } else {
+      break;
+    }
+  }
+  return data[k];
+}
+
+float wavelet_universal_threshold(const float *detail, size_t length,
+                                  size_t signalLength) {
+  assert(detail);
+  assert(length > 0);
+  float *absdetail = mallocf(length);
+  for (size_t i = 0; i < length; i++) {
+    absdetail[i] = fabsf(detail[i]);
+  }
+  // Median absolute deviation of the finest details estimates the noise
+  float sigma = quickselect(absdetail, (int)length, (int)length / 2) /
+      0.6745f;
+  free_aligned(absdetail);
+  return sigma * sqrtf(2 * logf(signalLength));
+}
+
+/// @brief The thresholds of the detail coefficients, applied right after
+/// the level is decomposed while the coefficients are still in cache.
+typedef struct {
+  ShrinkageType type;
+  /// Per level, or NULL to estimate the universal threshold on level 1.
+  const float *thresholds;
+  float universal;
+} WaveletShrinkage;
+
+INLINE float wavelet_shrinkage_threshold(WaveletShrinkage *shrinkage,
+                                         int level, const float *detail,
+                                         size_t length, size_t signalLength) {
+  if (shrinkage->thresholds) {
+    return shrinkage->thresholds[level - 1];
+  }
+  if (level == 1) {
+    shrinkage->universal = wavelet_universal_threshold(detail, length,
+                                                       signalLength);
+  }
+  return shrinkage->universal;
+}
+
+static void wavelet_decompose_shrink(WaveletType type, int order,
+                                     ExtensionType ext, int levels,
+                                     const float *__restrict src,
+                                     size_t length, float *__restrict coeffs,
+                                     WaveletShrinkage *shrinkage) {
+  assert(src && coeffs);
+  assert(levels >= 1);
+  check_length(length);
+  assert(length % ((size_t)1 << levels) == 0 &&
+         "length must be divisible by 2^levels");
+  // The plain kernel reads the unprepared input, so the lowpass parts
+  // take turns in two buffers and the details are written in place
+  float *workspace = mallocf_ex(length / 2 + length / 4, kMemoryFlagHugePages);
+  float *buffers[2] = { workspace + length / 2, workspace };
+  const float *input = src;
+  for (int level = 1; level <= levels; level++) {
+    size_t inputLength = length >> (level - 1);
+    float *lowpass = buffers[level & 1];
+    float *detail = coeffs + (length >> level);
+    wavelet_apply_plain(type, order, ext, input, inputLength, detail,
+                        lowpass);
+    if (shrinkage) {
+      float threshold = wavelet_shrinkage_threshold(
+          shrinkage, level, detail, inputLength / 2, length);
+      wavelet_shrink(shrinkage->type, threshold, detail, inputLength / 2,
+                     detail);
+    }
+    input = lowpass;
+  }
+  memcpy(coeffs, input, (length >> levels) * sizeof(float));
+  free_aligned(workspace);
+}
+
+void wavelet_decompose(WaveletType type, int order, ExtensionType ext,
+                       int levels, const float *__restrict src, size_t length,
+                       float *__restrict coeffs) {
+  wavelet_decompose_shrink(type, order, ext, levels, src, length, coeffs,
+                           NULL);
+}
+
+static void stationary_wavelet_decompose_shrink(
+    WaveletType type, int order, ExtensionType ext, int levels,
+    const float *__restrict src, size_t length, float *__restrict coeffs,
+    WaveletShrinkage *shrinkage) {
+  assert(src && coeffs);
+  assert(levels >= 1);
+  assert(length > 0);
+  // The lowpass parts take turns in coeffs[0 .. length) and in the
+  // scratch buffer, so that the last one lands in its place
+  float *scratch = levels > 1? mallocf_ex(length, kMemoryFlagHugePages) : NULL;
+  const float *input = src;
+  for (int level = 1; level <= levels; level++) {
+    float *lowpass = (levels - level) % 2 == 0? coeffs : scratch;
+    float *detail = coeffs + (levels - level + 1) * length;
+    stationary_wavelet_apply(type, order, level, ext, input, length,
+                             detail, lowpass);
+    if (shrinkage) {
+      float threshold = wavelet_shrinkage_threshold(
+          shrinkage, level, detail, length, length);
+      wavelet_shrink(shrinkage->type, threshold, detail, length, detail);
+    }
+    input = lowpass;
+  }
+  free_aligned(scratch);
+}
+
+void stationary_wavelet_decompose(WaveletType type, int order,
+                                  ExtensionType ext, int levels,
+                                  const float *__restrict src, size_t length,
+                                  float *__restrict coeffs) {
+  stationary_wavelet_decompose_shrink(type, order, ext, levels, src, length,
+                                      coeffs, NULL);
+}
+
+/// @brief Initializes the synthesis filters which invert the analysis ones.
+/// @param redundancy 1 for the decimated and 2 for the stationary transform.
+/// @details The circular analysis matrix A is orthogonal up to the scale,
+/// A^T A = redundancy * sum(lowpass^2) * I (symlets sum to 1, not to
+/// sqrt(2)), so the synthesis is its scaled transpose.
+INLINE NOTNULL(4, 5) void initialize_synthesis_highpass_lowpass(
+    WaveletType type, int order, float redundancy, float *restrict highpass,
+    float *restrict lowpass) {
+  initialize_highpass_lowpass(type, order, highpass, lowpass);
+  float norm = 0.f;
+  for (int i = 0; i < order; i++) {
+    norm += lowpass[i] * lowpass[i];
+  }
+  float scale = 1.f / (norm * redundancy);
+  for (int i = 0; i < order; i++) {
+    highpass[i] *= scale;
+    lowpass[i] *= scale;
+  }
+}
+
+void inverse_wavelet_apply_na(WaveletType type, int order,
+                              const float *__restrict srchi,
+                              const float *__restrict srclo, size_t length,
+                              float *__restrict dest) {
+  check_length(length);
+
+  int half = (int)length / 2;
+  float highpassC[WAVELET_MAX_ORDER], lowpassC[WAVELET_MAX_ORDER];
+  initialize_synthesis_highpass_lowpass(type, order, 1, highpassC,
+                                        lowpassC);
+  for (int m = 0; m < half; m++) {
+    float reseven = 0.f, resodd = 0.f;
+    for (int k = 0; k < order / 2; k++) {
+      int n = (m - k) % half;
+      n = n < 0? n + half : n;
+      reseven += lowpassC[k * 2] * srclo[n] + highpassC[k * 2] * srchi[n];
+      resodd += lowpassC[k * 2 + 1] * srclo[n] +
+          highpassC[k * 2 + 1] * srchi[n];
+    }
+    dest[m * 2] = reseven;
+    dest[m * 2 + 1] = resodd;
+  }
+}
+
+#ifdef WAVELET_BLOCK
+
+#if defined(__AVX512F__)
+
+INLINE void wavelet_store_interleaved(float *ptr, __m512 even, __m512 odd) {
+  const __m512i lowidx = _mm512_setr_epi32(
+      0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+  const __m512i highidx = _mm512_setr_epi32(
+      8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+  _mm512_storeu_ps(ptr, _mm512_permutex2var_ps(even, lowidx, odd));
+  _mm512_storeu_ps(ptr + 16, _mm512_permutex2var_ps(even, highidx, odd));
+}
+
+#elif defined(__AVX__)
+
+INLINE void wavelet_store_interleaved(float *ptr, __m256 even, __m256 odd) {
+  __m256 low = _mm256_unpacklo_ps(even, odd);
+  __m256 high = _mm256_unpackhi_ps(even, odd);
+  _mm256_storeu_ps(ptr, _mm256_permute2f128_ps(low, high, 0x20));
+  _mm256_storeu_ps(ptr + 8, _mm256_permute2f128_ps(low, high, 0x31));
+}
+
+#else  // __ARM_NEON__
+
+INLINE void wavelet_store_interleaved(float *ptr, float32x4_t even,
+                                      float32x4_t odd) {
+  float32x4x2_t pair = { { even, odd } };
+  vst2q_f32(ptr, pair);
+}
+
+#endif
+
+#define WAVELET_INVERSE_DECLARE(i) \
+    wavelet_vec even##i = wavelet_zero(), odd##i = wavelet_zero();
+#define WAVELET_INVERSE_UPDATE(i) { \
+    wavelet_vec lovec = wavelet_loadu(srclo + m - k + i * WAVELET_VL); \
+    wavelet_vec hivec = wavelet_loadu(srchi + m - k + i * WAVELET_VL); \
+    even##i = wavelet_madd(lovec, lpeven, even##i); \
+    even##i = wavelet_madd(hivec, hpeven, even##i); \
+    odd##i = wavelet_madd(lovec, lpodd, odd##i); \
+    odd##i = wavelet_madd(hivec, hpodd, odd##i); \
+}
+#define WAVELET_INVERSE_STORE(i) \
+    wavelet_store_interleaved(dest + (m + i * WAVELET_VL) * 2, \
+                              even##i, odd##i);
+
+#define WAVELET_STATIONARY_INVERSE_DECLARE(i) \
+    wavelet_vec res##i = wavelet_zero();
+#define WAVELET_STATIONARY_INVERSE_UPDATE(i) { \
+    wavelet_vec lovec = wavelet_loadu( \
+        srclo + di - j * stride + i * WAVELET_VL); \
+    wavelet_vec hivec = wavelet_loadu( \
+        srchi + di - j * stride + i * WAVELET_VL); \
+    res##i = wavelet_madd(lovec, lpvec, res##i); \
+    res##i = wavelet_madd(hivec, hpvec, res##i); \
+}
+#define WAVELET_STATIONARY_INVERSE_STORE(i) \
+    wavelet_storeu(dest + di + i * WAVELET_VL, res##i);
+
+#endif  // WAVELET_BLOCK
+
+void inverse_wavelet_apply(WaveletType type, int order,
+                           const float *__restrict srchi,
+                           const float *__restrict srclo, size_t length,
+                           float *__restrict dest) {
+#ifdef WAVELET_BLOCK
+  check_length(length);
+
+  int half = (int)length / 2;
+  int taps = order / 2;
+  if (half < WAVELET_BLOCK + taps - 1) {
+    inverse_wavelet_apply_na(type, order, srchi, srclo, length, dest);
+    return;
+  }
+
+  float highpassC[WAVELET_MAX_ORDER], lowpassC[WAVELET_MAX_ORDER];
+  initialize_synthesis_highpass_lowpass(type, order, 1, highpassC,
+                                        lowpassC);
+  // dest[2m + p] = sum(lowpass[2k + p] * srclo[m - k] +
+  //                    highpass[2k + p] * srchi[m - k])
+  int m = 0;
+  for (; m < taps - 1; m++) {
+    float reseven = 0.f, resodd = 0.f;
+    for (int k = 0; k < taps; k++) {
+      int n = m - k < 0? m - k + half : m - k;
+      reseven += lowpassC[k * 2] * srclo[n] + highpassC[k * 2] * srchi[n];
+      resodd += lowpassC[k * 2 + 1] * srclo[n] +
+          highpassC[k * 2 + 1] * srchi[n];
+    }
+    dest[m * 2] = reseven;
+    dest[m * 2 + 1] = resodd;
+  }
+  for (; m + WAVELET_BLOCK <= half; m += WAVELET_BLOCK) {
+    WAVELET_VECTORS(WAVELET_INVERSE_DECLARE)
+    for (int k = 0; k < taps; k++) {
+      wavelet_vec lpeven = wavelet_set1(lowpassC[k * 2]);
+      wavelet_vec lpodd = wavelet_set1(lowpassC[k * 2 + 1]);
+      wavelet_vec hpeven = wavelet_set1(highpassC[k * 2]);
+      wavelet_vec hpodd = wavelet_set1(highpassC[k * 2 + 1]);
+      WAVELET_VECTORS(WAVELET_INVERSE_UPDATE)
+    }
+    WAVELET_VECTORS(WAVELET_INVERSE_STORE)
+  }
+  for (; m < half; m++) {
+    float reseven = 0.f, resodd = 0.f;
+    for (int k = 0; k < taps; k++) {
+      reseven += lowpassC[k * 2] * srclo[m - k] +
+          highpassC[k * 2] * srchi[m - k];
+      resodd += lowpassC[k * 2 + 1] * srclo[m - k] +
+          highpassC[k * 2 + 1] * srchi[m - k];
+    }
+    dest[m * 2] = reseven;
+    dest[m * 2 + 1] = resodd;
+  }
+#else
+  inverse_wavelet_apply_na(type, order, srchi, srclo, length, dest);
+#endif
+}
+
+void inverse_stationary_wavelet_apply_na(WaveletType type, int order,
+                                         int level,
+                                         const float *__restrict srchi,
+                                         const float *__restrict srclo,
+                                         size_t length,
+                                         float *__restrict dest) {
+  assert(length > 0);
+  assert(level >= 1);
+
+  int ilength = (int)length;
+  int stride = 1 << (level - 1);
+  float highpassC[WAVELET_MAX_ORDER], lowpassC[WAVELET_MAX_ORDER];
+  initialize_synthesis_highpass_lowpass(type, order, 2, highpassC,
+                                        lowpassC);
+  for (int i = 0; i < ilength; i++) {
+    float reslo = 0.f, reshi = 0.f;
+    for (int j = 0; j < order; j++) {
+      int index = (i - j * stride) % ilength;
+      index = index < 0? index + ilength : index;
+      reslo += lowpassC[j] * srclo[index];
+      reshi += highpassC[j] * srchi[index];
+    }
+    dest[i] = reslo + reshi;
+  }
+}
+
+void inverse_stationary_wavelet_apply(WaveletType type, int order, int level,
+                                      const float *__restrict srchi,
+                                      const float *__restrict srclo,
+                                      size_t length,
+                                      float *__restrict dest) {
+#ifdef WAVELET_BLOCK
+  assert(length > 0);
+  assert(level >= 1);
+
+  int ilength = (int)length;
+  int stride = 1 << (level - 1);
+  int span = (order - 1) * stride;
+  if (ilength < WAVELET_BLOCK + span) {
+    inverse_stationary_wavelet_apply_na(type, order, level, srchi, srclo,
+                                        length, dest);
+    return;
+  }
+
+  float highpassC[WAVELET_MAX_ORDER], lowpassC[WAVELET_MAX_ORDER];
+  initialize_synthesis_highpass_lowpass(type, order, 2, highpassC,
+                                        lowpassC);
+  // The first outputs wrap around the beginning
+  int di = 0;
+  for (; di < span; di++) {
+    float reslo = 0.f, reshi = 0.f;
+    for (int j = 0; j < order; j++) {
+      int index = di - j * stride;
+      index = index < 0? index + ilength : index;
+      reslo += lowpassC[j] * srclo[index];
+      reshi += highpassC[j] * srchi[index];
+    }
+    dest[di] = reslo + reshi;
+  }
+  for (; di + WAVELET_BLOCK <= ilength; di += WAVELET_BLOCK) {
+    WAVELET_VECTORS(WAVELET_STATIONARY_INVERSE_DECLARE)
+    for (int j = 0; j < order; j++) {
+      wavelet_vec hpvec = wavelet_set1(highpassC[j]);
+      wavelet_vec lpvec = wavelet_set1(lowpassC[j]);
+      WAVELET_VECTORS(WAVELET_STATIONARY_INVERSE_UPDATE)
+    }
+    WAVELET_VECTORS(WAVELET_STATIONARY_INVERSE_STORE)
+  }
+  for (; di < ilength; di++) {
+    float reslo = 0.f, reshi = 0.f;
+    for (int j = 0; j < order; j++) {
+      reslo += lowpassC[j] * srclo[di - j * stride];
+      reshi += highpassC[j] * srchi[di - j * stride];
+    }
+    dest[di] = reslo + reshi;
+  }
+#else
+  inverse_stationary_wavelet_apply_na(type, order, level, srchi, srclo,
+                                      length, dest);
+#endif
+}
+
+void wavelet_recompose(WaveletType type, int order, int levels,
+                       const float *__restrict coeffs,
+                       size_t length, float *__restrict dest) {
+  assert(levels >= 1);
+  assert(length % (1 << levels) == 0);
+  // The approximations take turns in dest and in the scratch buffer,
+  // so that the last one lands in its place
+  float *scratch = levels > 1?
+      mallocf_ex(length / 2, kMemoryFlagHugePages) : NULL;
+  const float *approximation = coeffs;
+  for (int level = levels; level >= 1; level--) {
+    float *output = (level - 1) % 2 == 0? dest : scratch;
+    inverse_wavelet_apply(type, order, coeffs + (length >> level),
+                          approximation, length >> (level - 1), output);
+    approximation = output;
+  }
+  free_aligned(scratch);
+}
+
+void stationary_wavelet_recompose(WaveletType type, int order, int levels,
+                                  const float *__restrict coeffs,
+                                  size_t length, float *__restrict dest) {
+  assert(levels >= 1);
+  assert(length > 0);
+  float *scratch = levels > 1? mallocf_ex(length, kMemoryFlagHugePages) : NULL;
+  const float *approximation = coeffs;
+  for (int level = levels; level >= 1; level--) {
+    float *output = (level - 1) % 2 == 0? dest : scratch;
+    inverse_stationary_wavelet_apply(type, order, level,
+                                     coeffs + (levels - level + 1) * length,
+                                     approximation, length, output);
+    approximation = output;
+  }
+  free_aligned(scratch);
+}
+
+void wavelet_denoise(WaveletType type, int order, int levels,
+                     ShrinkageType shrinkage, const float *thresholds,
+                     const float *__restrict src, size_t length,
+                     float *__restrict dest) {
+  WaveletShrinkage shr = { shrinkage, thresholds, 0 };
+  float *coeffs = mallocf_ex(length, kMemoryFlagHugePages);
+  wavelet_decompose_shrink(type, order, EXTENSION_TYPE_PERIODIC, levels,
+                           src, length, coeffs, &shr);
+  wavelet_recompose(type, order, levels, coeffs, length, dest);
+  free_aligned(coeffs);
+}
+
+void stationary_wavelet_denoise(WaveletType type, int order, int levels,
+                                ShrinkageType shrinkage,
+                                const float *thresholds,
+                                const float *__restrict src, size_t length,
+                                float *__restrict dest) {
+  WaveletShrinkage shr = { shrinkage, thresholds, 0 };
+  float *coeffs = mallocf_ex((levels + 1) * length, kMemoryFlagHugePages);
+  stationary_wavelet_decompose_shrink(type, order, EXTENSION_TYPE_PERIODIC,
+                                      levels, src, length, coeffs, &shr);
+  stationary_wavelet_recompose(type, order, levels, coeffs, length, dest);
+  free_aligned(coeffs);
+}
+
+/// @brief The number of columns filtered together by the column pass.
+/// @details order rows of such a strip stay in L1 while the outputs of the
+/// strip are accumulated.
+#define WAVELET_COLUMNS_STRIP 256
+
+/// @brief Returns the row of the image which is at the place y after the
+/// image is extended down with ext, or NULL if the row consists of zeros.
+INLINE const float *wavelet_extended_row(ExtensionType ext,
+                                         const float *rows, int stride,
+                                         int height, int y) {
+  if (y < height) {
+    return rows + (size_t)y * stride;
+  }
+  int i = y - height;
+  switch (ext) {
+    case EXTENSION_TYPE_PERIODIC:
+      return rows + (size_t)(i % height) * stride;
+    case EXTENSION_TYPE_MIRROR:
+      return rows + (size_t)(height - 1 - (i % height)) * stride;
+    case EXTENSION_TYPE_CONSTANT:
+      return rows + (size_t)(height - 1) * stride;
+    case EXTENSION_TYPE_ZERO:
+      break;
+  }
+  return NULL;
+}
+
+#ifdef WAVELET_BLOCK
+#define WAVELET_COLUMNS_DECLARE(i) \
+    wavelet_vec hi##i = wavelet_zero(), lo##i = wavelet_zero();
+#define WAVELET_COLUMNS_UPDATE(i) { \
+    wavelet_vec srcvec = wavelet_loadu(row + x + i * WAVELET_VL); \
+    hi##i = wavelet_madd(srcvec, hpvec, hi##i); \
+    lo##i = wavelet_madd(srcvec, lpvec, lo##i); \
+}
+#define WAVELET_COLUMNS_STORE(i) \
+    wavelet_storeu(rowhi + x + i * WAVELET_VL, hi##i); \
+    wavelet_storeu(rowlo + x + i * WAVELET_VL, lo##i);
+#endif
+
+/// @brief Applies the filters to the columns of the image without
+/// transposing it.
+/// @details Output row di is the sum of the input rows di * step + j * dilation
+/// multiplied by the taps, so each vector of the consecutive columns is
+/// computed independently with the broadcast taps. The columns are walked
+/// in strips of WAVELET_COLUMNS_STRIP, so that the rows which are read by
+/// several outputs are taken from cache.
+static void wavelet_apply_columns(const float *highpassC,
+                                  const float *lowpassC, int order,
+                                  int step, int dilation, ExtensionType ext,
+                                  const float *src, int src_stride,
+                                  int width, int height,
+                                  int outHeight, float *desthi,
+                                  float *destlo, int dst_stride) {
+  assert(order <= WAVELET_MAX_ORDER);
+  const float *rows[WAVELET_MAX_ORDER];
+  for (int x0 = 0; x0 < width; x0 += WAVELET_COLUMNS_STRIP) {
+    int xend = x0 + WAVELET_COLUMNS_STRIP < width?
+        x0 + WAVELET_COLUMNS_STRIP : width;
+    for (int di = 0; di < outHeight; di++) {
+      for (int j = 0; j < order; j++) {
+        rows[j] = wavelet_extended_row(ext, src, src_stride, height,
+                                       di * step + j * dilation);
+      }
+      float *rowhi = desthi + (size_t)di * dst_stride;
+      float *rowlo = destlo + (size_t)di * dst_stride;
+      int x = x0;
+#ifdef WAVELET_BLOCK
+      for (; x + WAVELET_BLOCK <= xend; x += WAVELET_BLOCK) {
+        WAVELET_VECTORS(WAVELET_COLUMNS_DECLARE)
+        for (int j = 0; j < order; j++) {
+          const float *row = rows[j];
+          if (row == NULL) {
+            continue;
+          }
+          wavelet_vec hpvec = wavelet_set1(highpassC[j]);
+          wavelet_vec lpvec = wavelet_set1(lowpassC[j]);
+          WAVELET_VECTORS(WAVELET_COLUMNS_UPDATE)
+        }
+        WAVELET_VECTORS(WAVELET_COLUMNS_STORE)
+      }
+#endif
+      for (; x < xend; x++) {
+        float reshi = 0.f, reslo = 0.f;
+        for (int j = 0; j < order; j++) {
+          if (rows[j] != NULL) {
+            reshi += highpassC[j] * rows[j][x];
+            reslo += lowpassC[j] * rows[j][x];
+          }
+        }
+        rowhi[x] = reshi;
+        rowlo[x] = reslo;
+      }
+    }
+  }
+}
+
+/// @brief Converts the row of the image to floats, either src8 or srcf is
+/// NULL.
+INLINE const float *wavelet_image_row(const float *srcf, const uint8_t *src8,
+                                      int src_stride, int width, int y,
+                                      float *buffer) {
+  if (srcf != NULL) {
+    return srcf + (size_t)y * src_stride;
+  }
+  const uint8_t *row = src8 + (size_t)y * src_stride;
+  for (int x = 0; x < width; x++) {
+    buffer[x] = row[x];
+  }
+  return buffer;
+}
+
+/// @brief The 2D transform of either the float or the uint8_t image.
+/// @param level 0 means the decimated transform, otherwise the level of
+/// the stationary one.
+static void wavelet_apply2D_image(WaveletType type, int order, int level,
+                                  ExtensionType ext, const float *srcf,
+                                  const uint8_t *src8, int src_stride,
+                                  int width, int height,
+                                  float *ll, float *lh, float *hl, float *hh,
+                                  int dst_stride) {
+  assert(ll && lh && hl && hh);
+  assert(width > 0 && height > 0);
+  assert(src_stride >= width);
+  int decimated = level == 0;
+  if (decimated) {
+    check_length(width);
+    check_length(height);
+  }
+  int outWidth = decimated? width / 2 : width;
+  int outHeight = decimated? height / 2 : height;
+  assert(dst_stride >= outWidth);
+
+  // The row pass writes the planes of the horizontal lowpass and highpass,
+  // they are the sources of the column pass. The rows are aligned, since
+  // the stationary kernels store aligned
+  int pitch = (outWidth + 15) & ~15;
+  size_t planeSize = (size_t)pitch * height;
+  float *low = mallocf_ex(planeSize * 2, kMemoryFlagHugePages);
+  float *high = low + planeSize;
+  float *scratch = mallocf(width);
+  for (int y = 0; y < height; y++) {
+    const float *row = wavelet_image_row(srcf, src8, src_stride, width, y,
+                                         scratch);
+    float *rowlo = low + (size_t)y * pitch;
+    float *rowhi = high + (size_t)y * pitch;
+    if (decimated) {
+      wavelet_apply_plain(type, order, ext, row, width, rowhi, rowlo);
+    } else {
+      stationary_wavelet_apply(type, order, level, ext, row, width,
+                               rowhi, rowlo);
+    }
+  }
+  free_aligned(scratch);
+
+  float highpassC[WAVELET_MAX_ORDER], lowpassC[WAVELET_MAX_ORDER];
+  initialize_highpass_lowpass(type, order, highpassC, lowpassC);
+  int step = decimated? 2 : 1;
+  int dilation = decimated? 1 : 1 << (level - 1);
+  wavelet_apply_columns(highpassC, lowpassC, order, step, dilation, ext,
+                        low, pitch, outWidth, height, outHeight, lh, ll,
+                        dst_stride);
+  wavelet_apply_columns(highpassC, lowpassC, order, step, dilation, ext,
+                        high, pitch, outWidth, height, outHeight, hh, hl,
+                        dst_stride);
+  free_aligned(low);
+}
+
+void wavelet_apply2D(WaveletType type, int order, ExtensionType ext,
+                     const float *src, int src_stride, int width, int height,
+                     float *ll, float *lh, float *hl, float *hh,
+                     int dst_stride) {
+  assert(src);
+  wavelet_apply2D_image(type, order, 0, ext, src, NULL, src_stride,
+                        width, height, ll, lh, hl, hh, dst_stride);
+}
+
+void wavelet_apply2D_uint8(WaveletType type, int order, ExtensionType ext,
+                           const uint8_t *src, int src_stride,
+                           int width, int height,
+                           float *ll, float *lh, float *hl, float *hh,
+                           int dst_stride) {
+  assert(src);
+  wavelet_apply2D_image(type, order, 0, ext, NULL, src, src_stride,
+                        width, height, ll, lh, hl, hh, dst_stride);
+}
+
+void stationary_wavelet_apply2D(WaveletType type, int order, int level,
+                                ExtensionType ext, const float *src,
+                                int src_stride, int width, int height,
+                                float *ll, float *lh, float *hl, float *hh,
+                                int dst_stride) {
+  assert(src);
+  assert(level >= 1);
+  wavelet_apply2D_image(type, order, level, ext, src, NULL, src_stride,
+                        width, height, ll, lh, hl, hh, dst_stride);
+}
+
+void stationary_wavelet_apply2D_uint8(WaveletType type, int order, int level,
+                                      ExtensionType ext, const uint8_t *src,
+                                      int src_stride, int width, int height,
+                                      float *ll, float *lh, float *hl,
+                                      float *hh, int dst_stride) {
+  assert(src);
+  assert(level >= 1);
+  wavelet_apply2D_image(type, order, level, ext, NULL, src, src_stride,
+                        width, height, ll, lh, hl, hh, dst_stride);
+}
+
+/// @brief The number of the row major signals which are transposed
+/// together by wavelet_apply_batch().
+#define WAVELET_BATCH_BLOCK 32
+
+void wavelet_apply_batch(WaveletType type, int order, ExtensionType ext,
+                         WaveletBatchLayout layout,
+                         const float *__restrict src, size_t length,
+                         size_t count, float *__restrict desthi,
+                         float *__restrict destlo) {
+  check_length(length);
+  assert(count > 0);
+  float highpassC[WAVELET_MAX_ORDER], lowpassC[WAVELET_MAX_ORDER];
+  initialize_highpass_lowpass(type, order, highpassC, lowpassC);
+  int ilength = (int)length, half = ilength / 2;
+  if (layout == WAVELET_BATCH_LAYOUT_INTERLEAVED) {
+    // Each sample of all the signals is a row, the signals are the columns
+    wavelet_apply_columns(highpassC, lowpassC, order, 2, 1, ext, src,
+                          (int)count, (int)count, ilength, half,
+                          desthi, destlo, (int)count);
+    return;
+  }
+  assert(layout == WAVELET_BATCH_LAYOUT_ROWS);
+  // Every block of signals is interleaved in the scratch and the lanes
+  // are filled with different signals
+  float *interleaved =
+      mallocf_ex((size_t)ilength * WAVELET_BATCH_BLOCK * 2,
+                 kMemoryFlagHugePages);
+  float *outhi = interleaved + (size_t)ilength * WAVELET_BATCH_BLOCK;
+  float *outlo = outhi + (size_t)half * WAVELET_BATCH_BLOCK;
+  for (size_t s0 = 0; s0 < count; s0 += WAVELET_BATCH_BLOCK) {
+    int block = count - s0 < WAVELET_BATCH_BLOCK?
+        (int)(count - s0) : WAVELET_BATCH_BLOCK;
+    const float *signals = src + s0 * length;
+    for (int s = 0; s < block; s++) {
+      for (int i = 0; i < ilength; i++) {
+        interleaved[i * block + s] = signals[s * length + i];
+      }
+    }
+    wavelet_apply_columns(highpassC, lowpassC, order, 2, 1, ext,
+                          interleaved, block, block, ilength, half,
+                          outhi, outlo, block);
+    float *hi = desthi + s0 * half, *lo = destlo + s0 * half;
+    for (int s = 0; s < block; s++) {
+      for (int i = 0; i < half; i++) {
+        hi[s * half + i] = outhi[i * block + s];
+        lo[s * half + i] = outlo[i * block + s];
+      }
+    }
+  }
+  free_aligned(interleaved);
+}
+
+WaveletHandle wavelet_handle_initialize(WaveletType type, int order,
+                                        int level, ExtensionType ext) {
+  assert(wavelet_validate_order(type, order));
+  assert(level >= 0);
+  WaveletHandle handle;
+  handle.type = type;
+  handle.order = order;
+  handle.level = level;
+  handle.ext = ext;
+  handle.stride = level > 1? 1 << (level - 1) : 1;
+  // The dilated filters keep only the real taps, the zeros between them
+  // are skipped by the kernel
+  size_t alignedOrder = (order + 15) & ~15;
+  handle.taps = mallocf(alignedOrder * 2);
+  initialize_highpass_lowpass(type, order, handle.taps,
+                              handle.taps + alignedOrder);
+  return handle;
+}
+
+void wavelet_handle_apply(WaveletHandle handle, const float *__restrict src,
+                          size_t length, float *__restrict desthi,
+                          float *__restrict destlo) {
+  assert(handle.taps);
+  const float *highpassC = handle.taps;
+  const float *lowpassC = handle.taps + ((handle.order + 15) & ~15);
+  if (handle.level == 0) {
+    wavelet_applyN_taps(highpassC, lowpassC, handle.order, handle.ext,
+                        src, length, desthi, destlo);
+  } else {
+    stationary_wavelet_apply_atrous_taps(highpassC, lowpassC, handle.order,
+                                         handle.stride, handle.ext,
+                                         src, length, desthi, destlo);
+  }
+}
+
+void wavelet_handle_finalize(WaveletHandle handle) {
+  free_aligned(handle.taps);
+}
+
+INLINE NOTNULL(3, 4) void initialize_highpass_lowpass_double(
+    WaveletType type, int order, double *restrict highpass,
+    double *restrict lowpass) {
+  assert(order >= 2);
+  check_wavelet_order(type, order);
+  for (int i = 0; i < order; i++) {
+    double val = 0;
+    switch (type) {
+      case WAVELET_TYPE_DAUBECHIES:
+        val = kDaubechiesD[order / 2 - 1][i];
+        break;
+      case WAVELET_TYPE_COIFLET:
+        assert(order >= 6);
+        val = kCoifletsD[order / 6 - 1][i];
+        break;
+      case WAVELET_TYPE_SYMLET:
+        val = kSymletsD[order / 2 - 1][i];
+        break;
+    }
+    lowpass[i] = val;
+    highpass[order - i - 1] = (i & 1) ? val : -val;
+  }
+}
+
+INLINE NOTNULL(3, 5) void initialize_extension_double(
+    ExtensionType ext, size_t extLength, const double *restrict src,
+    size_t length, double *restrict result) {
+  for (int i = 0; i < (int)extLength; i++) {
+    switch (ext) {
+      case EXTENSION_TYPE_PERIODIC:
+        result[i] = src[i % length];
+        break;
+      case EXTENSION_TYPE_MIRROR:
+        result[i] = src[length - 1 - (i % length)];
+        break;
+      case EXTENSION_TYPE_CONSTANT:
+        result[i] = src[length - 1];
+        break;
+      case EXTENSION_TYPE_ZERO:
+        result[i] = 0;
+        break;
+    }
+  }
+}
+
+/* The double precision kernels repeat the structure of wavelet_applyN_taps()
+ * and stationary_wavelet_apply_atrous_taps() with half as many lanes. */
+#if defined(__AVX512F__)
+
+#define WAVELETD_VL 8
+typedef __m512d waveletd_vec;
+#define waveletd_loadu(ptr) _mm512_loadu_pd(ptr)
+#define waveletd_storeu(ptr, vec) _mm512_storeu_pd(ptr, vec)
+#define waveletd_set1(value) _mm512_set1_pd(value)
+#define waveletd_zero() _mm512_setzero_pd()
+#define waveletd_madd(a, b, c) _mm512_fmadd_pd(a, b, c)
+
+INLINE void waveletd_deinterleave(const double *src, double *even,
+                                  double *odd) {
+  const __m512i evenidx = _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0);
+  const __m512i oddidx = _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1);
+  __m512d a = _mm512_loadu_pd(src), b = _mm512_loadu_pd(src + 8);
+  _mm512_storeu_pd(even, _mm512_permutex2var_pd(a, evenidx, b));
+  _mm512_storeu_pd(odd, _mm512_permutex2var_pd(a, oddidx, b));
+}
+
+#elif defined(__AVX__)
+
+#define WAVELETD_VL 4
+typedef __m256d waveletd_vec;
+#define waveletd_loadu(ptr) _mm256_loadu_pd(ptr)
+#define waveletd_storeu(ptr, vec) _mm256_storeu_pd(ptr, vec)
+#define waveletd_set1(value) _mm256_set1_pd(value)
+#define waveletd_zero() _mm256_setzero_pd()
+#define waveletd_madd(a, b, c) madd256d(a, b, c)
+
+INLINE void waveletd_deinterleave(const double *src, double *even,
+                                  double *odd) {
+  __m256d a = _mm256_loadu_pd(src), b = _mm256_loadu_pd(src + 4);
+  // Each 128-bit lane gets two consecutive samples of each half
+  __m256d first = _mm256_permute2f128_pd(a, b, 0x20);
+  __m256d second = _mm256_permute2f128_pd(a, b, 0x31);
+  _mm256_storeu_pd(even, _mm256_unpacklo_pd(first, second));
+  _mm256_storeu_pd(odd, _mm256_unpackhi_pd(first, second));
+}
+
+#elif defined(__aarch64__)
+
+#define WAVELETD_VL 2
+typedef float64x2_t waveletd_vec;
+#define waveletd_loadu(ptr) vld1q_f64(ptr)
+#define waveletd_storeu(ptr, vec) vst1q_f64(ptr, vec)
+#define waveletd_set1(value) vdupq_n_f64(value)
+#define waveletd_zero() vdupq_n_f64(0)
+#define waveletd_madd(a, b, c) vfmaq_f64(c, a, b)
+
+INLINE void waveletd_deinterleave(const double *src, double *even,
+                                  double *odd) {
+  float64x2x2_t pair = vld2q_f64(src);
+  vst1q_f64(even, pair.val[0]);
+  vst1q_f64(odd, pair.val[1]);
+}
+
+#endif
+
+#ifdef WAVELETD_VL
+#if WAVELET_NV == 1
+#define WAVELETD_NV 1
+#define WAVELETD_VECTORS(X) X(0)
+#else
+#define WAVELETD_NV 2
+#define WAVELETD_VECTORS(X) X(0) X(1)
+#endif
+#define WAVELETD_BLOCK (WAVELETD_NV * WAVELETD_VL)
+
+#define WAVELETD_DECLARE(i) \
+    waveletd_vec hi##i = waveletd_zero(), lo##i = waveletd_zero();
+#define WAVELETD_UPDATE(i) { \
+    waveletd_vec evenvec = waveletd_loadu(even + m + i * WAVELETD_VL); \
+    waveletd_vec oddvec = waveletd_loadu(odd + m + i * WAVELETD_VL); \
+    hi##i = waveletd_madd(evenvec, hpeven, hi##i); \
+    lo##i = waveletd_madd(evenvec, lpeven, lo##i); \
+    hi##i = waveletd_madd(oddvec, hpodd, hi##i); \
+    lo##i = waveletd_madd(oddvec, lpodd, lo##i); \
+}
+#define WAVELETD_ATROUS_UPDATE(i) { \
+    waveletd_vec srcvec = waveletd_loadu( \
+        src + di + j * stride + i * WAVELETD_VL); \
+    hi##i = waveletd_madd(srcvec, hpvec, hi##i); \
+    lo##i = waveletd_madd(srcvec, lpvec, lo##i); \
+}
+#define WAVELETD_STORE(i) \
+    waveletd_storeu(desthi + di + i * WAVELETD_VL, hi##i); \
+    waveletd_storeu(destlo + di + i * WAVELETD_VL, lo##i);
+#endif  // WAVELETD_VL
+
+void wavelet_apply_double(WaveletType type, int order, ExtensionType ext,
+                          const double *__restrict src, size_t length,
+                          double *__restrict desthi,
+                          double *__restrict destlo) {
+  check_length(length);
+
+  double highpassC[WAVELET_MAX_ORDER], lowpassC[WAVELET_MAX_ORDER];
+  initialize_highpass_lowpass_double(type, order, highpassC, lowpassC);
+  double src_ext[WAVELET_MAX_ORDER];
+  initialize_extension_double(ext, order, src, length, src_ext);
+  int di = 0;
+#ifdef WAVELETD_BLOCK
+  int half = (int)length / 2;
+  int taps = order / 2;
+  int window = WAVELETD_BLOCK + taps - 1;
+  if (half >= window) {
+    double even[WAVELETD_BLOCK + WAVELET_MAX_ORDER / 2 + WAVELETD_VL]
+        __attribute__((aligned(64)));
+    double odd[WAVELETD_BLOCK + WAVELET_MAX_ORDER / 2 + WAVELETD_VL]
+        __attribute__((aligned(64)));
+    for (; di + window <= half; di += WAVELETD_BLOCK) {
+      const double *block = src + di * 2;
+      int k = 0;
+      for (; k < window && di + k + WAVELETD_VL <= half; k += WAVELETD_VL) {
+        waveletd_deinterleave(block + k * 2, even + k, odd + k);
+      }
+      for (; k < window; k++) {
+        even[k] = block[k * 2];
+        odd[k] = block[k * 2 + 1];
+      }
+      WAVELETD_VECTORS(WAVELETD_DECLARE)
+      for (int m = 0; m < taps; m++) {
+        waveletd_vec hpeven = waveletd_set1(highpassC[m * 2]);
+        waveletd_vec hpodd = waveletd_set1(highpassC[m * 2 + 1]);
+        waveletd_vec lpeven = waveletd_set1(lowpassC[m * 2]);
+        waveletd_vec lpodd = waveletd_set1(lowpassC[m * 2 + 1]);
+        WAVELETD_VECTORS(WAVELETD_UPDATE)
+      }
+      WAVELETD_VECTORS(WAVELETD_STORE)
+    }
+  }
+#endif
+  // Finish with the extended end
+  int ilength = (int)length;
+  for (int i = di * 2; i < ilength; i += 2, di++) {
+    double reshi = 0, reslo = 0;
+    for (int j = 0; j < order; j++) {
+      int index = i + j;
+      double srcval = index < ilength? src[index] : src_ext[index - ilength];
+      reshi += highpassC[j] * srcval;
+      reslo += lowpassC[j] * srcval;
+    }
+    desthi[di] = reshi;
+    destlo[di] = reslo;
+  }
+}
+
+void stationary_wavelet_apply_double(WaveletType type, int order, int level,
+                                     ExtensionType ext,
+                                     const double *__restrict src,
+                                     size_t length,
+                                     double *__restrict desthi,
+                                     double *__restrict destlo) {
+  assert(length > 0);
+  assert(level >= 1);
+
+  // The dilated filter has the same taps as the plain one, see
+  // stationary_wavelet_apply_atrous_taps()
+  double highpassC[WAVELET_MAX_ORDER], lowpassC[WAVELET_MAX_ORDER];
+  initialize_highpass_lowpass_double(type, order, highpassC, lowpassC);
+  int stride = 1 << (level - 1);
+  int span = (order - 1) * stride;
+  int ilength = (int)length;
+  double stack_ext[WAVELET_STACK_EXTENSION];
+  double *src_ext = span + 1 <= WAVELET_STACK_EXTENSION?
+      stack_ext : malloc_aligned((span + 1) * sizeof(double));
+  assert(src_ext);
+  initialize_extension_double(ext, span + 1, src, length, src_ext);
+
+  int di = 0;
+#ifdef WAVELETD_BLOCK
+  for (; di + WAVELETD_BLOCK + span <= ilength; di += WAVELETD_BLOCK) {
+    WAVELETD_VECTORS(WAVELETD_DECLARE)
+    for (int j = 0; j < order; j++) {
+      waveletd_vec hpvec = waveletd_set1(highpassC[j]);
+      waveletd_vec lpvec = waveletd_set1(lowpassC[j]);
+      WAVELETD_VECTORS(WAVELETD_ATROUS_UPDATE)
+    }
+    WAVELETD_VECTORS(WAVELETD_STORE)
+  }
+#endif
+  // Finish with the extended end
+  for (; di < ilength; di++) {
+    double reshi = 0, reslo = 0;
+    for (int j = 0; j < order; j++) {
+      int index = di + j * stride;
+      double srcval = index < ilength? src[index] : src_ext[index - ilength];
+      reshi += highpassC[j] * srcval;
+      reslo += lowpassC[j] * srcval;
+    }
+    desthi[di] = reshi;
+    destlo[di] = reslo;
+  }
+  if (src_ext != stack_ext) {
+    free_aligned(src_ext);
+  }
+}
+
+/// @brief The maximal wavelet order which has the lifting factorization.
+#define LIFTING_MAX_ORDER 16
+#define LIFTING_MAX_STEPS (LIFTING_MAX_ORDER / 2 + 1)
+#define LAURENT_CAPACITY (LIFTING_MAX_ORDER * 2)
+/// @brief The factorizations which amplify the rounding errors more than
+/// this are rejected.
+#define LIFTING_MAX_AMPLIFICATION 1e4
+
+/// @brief Laurent polynomial sum(c[i] * z^(low + i)), z means the advance
+/// by one sample of the polyphase component.
+typedef struct {
+  int low;
+  int length;
+  double c[LAURENT_CAPACITY];
+} Laurent;
+
+/// @brief A single lifting step: plane[n] += sum(c[i] * other[n + low + i]),
+/// where plane is either the even (0) or the odd (1) samples.
+typedef struct {
+  int plane;
+  int low;
+  int length;
+  float c[LAURENT_CAPACITY];
+} LiftingStep;
+
+typedef struct {
+  int stepsCount;
+  LiftingStep steps[LIFTING_MAX_STEPS];
+  /// The plane which holds the lowpass part after the steps.
+  int lowpassPlane;
+  /// lowpass[n] = scale[0] * plane[n + shift[0]], the same for highpass.
+  float scale[2];
+  int shift[2];
+} LiftingScheme;
+
+/// @brief Laurent polynomial division a = q * b + r, where q eliminates
+/// either the highest (fromTop) or the lowest coefficients of a.
+static void laurent_divide(const Laurent *a, const Laurent *b, int fromTop,
+                           Laurent *q, Laurent *r) {
+  assert(a->length >= b->length && b->length > 0);
+  *r = *a;
+  q->low = a->low - b->low;
+  q->length = a->length - b->length + 1;
+  if (fromTop) {
+    double top = b->c[b->length - 1];
+    for (int k = q->length - 1; k >= 0; k--) {
+      double coeff = r->c[k + b->length - 1] / top;
+      q->c[k] = coeff;
+      for (int i = 0; i < b->length; i++) {
+        r->c[k + i] -= coeff * b->c[i];
+      }
+    }
+  } else {
+    double bottom = b->c[0];
+    for (int k = 0; k < q->length; k++) {
+      double coeff = r->c[k] / bottom;
+      q->c[k] = coeff;
+      for (int i = 0; i < b->length; i++) {
+        r->c[k + i] -= coeff * b->c[i];
+      }
+    }
+    memmove(r->c, r->c + q->length, (b->length - 1) * sizeof(r->c[0]));
+    r->low += q->length;
+  }
+  r->length = b->length - 1;
+}
+
+/// @brief x -= q * y.
+static void laurent_multiply_subtract(Laurent *x, const Laurent *q,
+                                      const Laurent *y) {
+  int plow = q->low + y->low;
+  int plength = q->length + y->length - 1;
+  int low = x->length > 0 && x->low < plow? x->low : plow;
+  int end = x->low + x->length > plow + plength?
+      x->low + x->length : plow + plength;
+  if (x->length == 0) {
+    end = plow + plength;
+  }
+  assert(end - low <= LAURENT_CAPACITY);
+  double res[LAURENT_CAPACITY] = { 0 };
+  for (int i = 0; i < x->length; i++) {
+    res[x->low + i - low] = x->c[i];
+  }
+  for (int i = 0; i < q->length; i++) {
+    for (int j = 0; j < y->length; j++) {
+      res[plow + i + j - low] -= q->c[i] * y->c[j];
+    }
+  }
+  x->low = low;
+  x->length = end - low;
+  memcpy(x->c, res, x->length * sizeof(res[0]));
+}
+
+/// @brief Returns the index of the only significant coefficient of p,
+/// or -1 if p is not a monomial.
+static int laurent_monomial(const Laurent *p) {
+  int index = -1;
+  double absmax = 0;
+  for (int i = 0; i < p->length; i++) {
+    if (fabs(p->c[i]) > absmax) {
+      absmax = fabs(p->c[i]);
+      index = i;
+    }
+  }
+  for (int i = 0; i < p->length; i++) {
+    if (i != index && fabs(p->c[i]) > absmax * 1e-9) {
+      return -1;
+    }
+  }
+  return index;
+}
+
+static void lifting_add_step(LiftingScheme *scheme, int plane,
+                             const Laurent *q) {
+  assert(scheme->stepsCount < LIFTING_MAX_STEPS);
+  LiftingStep *step = &scheme->steps[scheme->stepsCount++];
+  step->plane = plane;
+  step->low = q->low;
+  step->length = q->length;
+  for (int i = 0; i < q->length; i++) {
+    step->c[i] = q->c[i];
+  }
+}
+
+/// @brief Factorizes the polyphase matrix of the wavelet into lifting steps
+/// with the Euclidean algorithm (Daubechies & Sweldens, 1998).
+/// @param choices The bit i selects the division from the top at step i.
+/// @return The bound of the rounding error amplification on success,
+/// otherwise 0.
+static double lifting_factorize_choices(
+    const double *highpassC, const double *lowpassC, int order,
+    unsigned choices, LiftingScheme *scheme) {
+  // a is the lowpass row, b is the highpass row of the polyphase matrix:
+  // lowpass = a[0] * even + a[1] * odd, highpass = b[0] * even + b[1] * odd
+  Laurent a[2], b[2];
+  for (int p = 0; p < 2; p++) {
+    a[p].low = b[p].low = 0;
+    a[p].length = b[p].length = order / 2;
+    for (int k = 0; k < order / 2; k++) {
+      a[p].c[k] = lowpassC[k * 2 + p];
+      b[p].c[k] = highpassC[k * 2 + p];
+    }
+  }
+  scheme->stepsCount = 0;
+  while (a[0].length > 0 && a[1].length > 0) {
+    // a[t] = q * a[1 - t] + r turns into plane[1 - t] += q * plane[t]
+    int t = a[0].length >= a[1].length? 0 : 1;
+    if (scheme->stepsCount == LIFTING_MAX_STEPS - 1) {
+      return 0;
+    }
+    Laurent q, r;
+    laurent_divide(&a[t], &a[1 - t], (choices >> scheme->stepsCount) & 1,
+                   &q, &r);
+    a[t] = r;
+    laurent_multiply_subtract(&b[t], &q, &b[1 - t]);
+    lifting_add_step(scheme, 1 - t, &q);
+  }
+  int k = a[0].length > 0? 0 : 1;
+  if (a[k].length != 1) {
+    return 0;
+  }
+  // The determinant is a monomial, so is b[1 - k]
+  int m = laurent_monomial(&b[1 - k]);
+  if (m < 0) {
+    return 0;
+  }
+  double scale = b[1 - k].c[m];
+  Laurent q = b[k];
+  q.low -= b[1 - k].low + m;
+  for (int i = 0; i < q.length; i++) {
+    q.c[i] /= scale;
+  }
+  lifting_add_step(scheme, 1 - k, &q);
+  scheme->lowpassPlane = k;
+  scheme->scale[0] = a[k].c[0];
+  scheme->shift[0] = a[k].low;
+  scheme->scale[1] = scale;
+  scheme->shift[1] = b[1 - k].low + m;
+  double amplification = 1;
+  for (int i = 0; i < scheme->stepsCount; i++) {
+    double norm = 1;
+    for (int j = 0; j < scheme->steps[i].length; j++) {
+      norm += fabs(scheme->steps[i].c[j]);
+    }
+    amplification *= norm;
+  }
+  return amplification;
+}
+
+/// @brief Finds the best conditioned lifting factorization of the wavelet.
+/// @return 1 on success, otherwise 0.
+static int lifting_factorize(WaveletType type, int order,
+                             LiftingScheme *scheme) {
+  // The float coefficients are not orthogonal enough for the factorization
+  double highpassC[LIFTING_MAX_ORDER], lowpassC[LIFTING_MAX_ORDER];
+  for (int i = 0; i < order; i++) {
+    double val = 0;
+    switch (type) {
+      case WAVELET_TYPE_DAUBECHIES:
+        val = kDaubechiesD[order / 2 - 1][i];
+        break;
+      case WAVELET_TYPE_COIFLET:
+        val = kCoifletsD[order / 6 - 1][i];
+        break;
+      case WAVELET_TYPE_SYMLET:
+        val = kSymletsD[order / 2 - 1][i];
+        break;
+    }
+    lowpassC[i] = val;
+    highpassC[order - i - 1] = (i & 1) ? val : -val;
+  }
+  double best = 0;
+  for (unsigned choices = 0; choices < (1u << (order / 2)); choices++) {
+    LiftingScheme candidate;
+    double amplification = lifting_factorize_choices(
+        highpassC, lowpassC, order, choices, &candidate);
+    if (amplification > 0 && (best == 0 || amplification < best)) {
+      best = amplification;
+      *scheme = candidate;
+    }
+  }
+  return best > 0 && best < LIFTING_MAX_AMPLIFICATION;
+}
+
+static pthread_mutex_t lifting_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static LiftingScheme lifting_cache[3][LIFTING_MAX_ORDER / 2];
+/// 0 means not factorized yet, 1 means success and -1 means failure.
+static int lifting_cache_state[3][LIFTING_MAX_ORDER / 2];
+
+/// @brief Returns the cached lifting factorization, the search for it is
+/// too expensive to repeat in each transform.
+static int lifting_scheme(WaveletType type, int order,
+                          LiftingScheme *scheme) {
+  assert(type >= 0 && type < 3);
+  assert(order >= 2 && order <= LIFTING_MAX_ORDER && order % 2 == 0);
+  int index = order / 2 - 1;
+  pthread_mutex_lock(&lifting_cache_lock);
+  if (lifting_cache_state[type][index] == 0) {
+    lifting_cache_state[type][index] =
+        lifting_factorize(type, order, &lifting_cache[type][index])? 1 : -1;
+  }
+  int res = lifting_cache_state[type][index] > 0;
+  if (res) {
+    *scheme = lifting_cache[type][index];
+  }
+  pthread_mutex_unlock(&lifting_cache_lock);
+  return res;
+}
+
+int wavelet_lifting_validate_order(WaveletType type, int order) {
+  if (order < 2 || order > LIFTING_MAX_ORDER || !wavelet_validate_order(type, order)) {
+    return 0;
+  }
+  LiftingScheme scheme;
+  return lifting_scheme(type, order, &scheme);
+}
+
+INLINE int lifting_wrap(int index, int count) {
+  index %= count;
+  return index < 0? index + count : index;
+}
+
+static void lifting_step_apply(const LiftingStep *step, float *data,
+                               int count) {
+  float *plane = data + step->plane;
+  const float *other = data + 1 - step->plane;
+  int begin = -step->low, end = count - step->low - step->length + 1;
+  if (begin < 0) {
+    begin = 0;
+  }
+  if (end > count) {
+    end = count;
+  }
+  if (begin > end) {
+    begin = end = 0;
+  }
+  for (int n = 0; n < begin; n++) {
+    float sum = 0.f;
+    for (int i = 0; i < step->length; i++) {
+      sum += step->c[i] * other[lifting_wrap(n + step->low + i, count) * 2];
+    }
+    plane[n * 2] += sum;
+  }
+  for (int n = begin; n < end; n++) {
+    float sum = 0.f;
+    for (int i = 0; i < step->length; i++) {
+      sum += step->c[i] * other[(n + step->low + i) * 2];
+    }
+    plane[n * 2] += sum;
+  }
+  for (int n = end > begin? end : begin; n < count; n++) {
+    float sum = 0.f;
+    for (int i = 0; i < step->length; i++) {
+      sum += step->c[i] * other[lifting_wrap(n + step->low + i, count) * 2];
+    }
+    plane[n * 2] += sum;
+  }
+}
+
+INLINE void lifting_reverse(float *plane, int begin, int end) {
+  for (end--; begin < end; begin++, end--) {
+    float tmp = plane[begin * 2];
+    plane[begin * 2] = plane[end * 2];
+    plane[end * 2] = tmp;
+  }
+}
+
+/// @brief plane[n] = scale * plane[n + shift], circularly and in place.
+static void lifting_finalize_plane(float *plane, int count, float scale,
+                                   int shift) {
+  shift = lifting_wrap(shift, count);
+  if (shift != 0) {
+    lifting_reverse(plane, 0, shift);
+    lifting_reverse(plane, shift, count);
+    lifting_reverse(plane, 0, count);
+  }
+  for (int n = 0; n < count; n++) {
+    plane[n * 2] *= scale;
+  }
+}
+
+void wavelet_lifting_apply(WaveletType type, int order, ExtensionType ext,
+                           float *data, size_t length) {
+  check_length(length);
+  assert(data);
+  assert(length >= (size_t)order);
+  assert(wavelet_validate_order(type, order));
+  LiftingScheme scheme;
+  int factorized = lifting_scheme(type, order, &scheme);
+  assert(factorized && "use wavelet_lifting_validate_order()");
+  if (!factorized) {
+    return;
+  }
+  int ilength = (int)length;
+  int count = ilength / 2;
+  // The lifting steps are circular, so the outputs which reach past the end
+  // are recomputed for the other extensions from the saved samples
+  int fixed = ext != EXTENSION_TYPE_PERIODIC? order / 2 - 1 : 0;
+  float tail[LIFTING_MAX_ORDER], src_ext[LIFTING_MAX_ORDER];
+  if (fixed > 0) {
+    initialize_extension(ext, order, data, length, src_ext);
+    memcpy(tail, data + ilength - order, order * sizeof(float));
+  }
+
+  for (int i = 0; i < scheme.stepsCount; i++) {
+    lifting_step_apply(&scheme.steps[i], data, count);
+  }
+  int lp = scheme.lowpassPlane;
+  lifting_finalize_plane(data + lp, count, scheme.scale[0], scheme.shift[0]);
+  lifting_finalize_plane(data + 1 - lp, count, scheme.scale[1],
+                         scheme.shift[1]);
+  if (lp != 0) {
+    for (int n = 0; n < count; n++) {
+      float tmp = data[n * 2];
+      data[n * 2] = data[n * 2 + 1];
+      data[n * 2 + 1] = tmp;
+    }
+  }
+
+  if (fixed > 0) {
+    float highpassC[LIFTING_MAX_ORDER], lowpassC[LIFTING_MAX_ORDER];
+    initialize_highpass_lowpass(type, order, highpassC, lowpassC);
+    int offset = ilength - order;
+    for (int di = count - fixed; di < count; di++) {
+      float reshi = 0.f, reslo = 0.f;
+      for (int j = 0; j < order; j++) {
+        int index = di * 2 + j;
+        float srcval = index < ilength?
+            tail[index - offset] : src_ext[index - ilength];
+        reshi += highpassC[j] * srcval;
+        reslo += lowpassC[j] * srcval;
+      }
+      data[di * 2] = reslo;
+      data[di * 2 + 1] = reshi;
+    }
+  }
+}
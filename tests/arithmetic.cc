@@ -28,7 +28,11 @@
  *  under the License.
  */
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
 #include <gtest/gtest.h>
 #include <simd/arithmetic.h>
 
@@ -332,6 +336,175 @@ TEST(Arithmetic, float_to_int16) {
 #endif
 }
 
+template <class S, class D>
+void TestConversion(void (*func)(const S *, size_t, D *),
+                    void (*func_na)(const S *, size_t, D *),
+                    int srcOffset, int dstOffset) {
+  const int N = 77;
+  S src[N + 16] __attribute__ ((aligned (64)));  // NOLINT(whitespace/parens)
+  D res[N + 16] __attribute__ ((aligned (64)));  // NOLINT(whitespace/parens)
+  D verif[N];
+  for (int i = 0; i < N + 16; i++) {
+    src[i] = static_cast<S>((i % 2 == 0? -1 : 1) * (i * 373 % 20000));
+  }
+  for (int length = 0; length <= N; length++) {
+    memset(res, 0, sizeof(res));
+    func(src + srcOffset, length, res + dstOffset);
+    func_na(src + srcOffset, length, verif);
+    ASSERT_EQ(0, memcmp(res + dstOffset, verif, length * sizeof(res[0])))
+        << "length = " << length;
+    for (int i = dstOffset + length; i < N + 16; i++) {
+      ASSERT_EQ(0, res[i]) << "length = " << length << ", i = " << i;
+    }
+  }
+}
+
+TEST(Arithmetic, conversions) {
+  for (int offset = 0; offset < 8; offset++) {
+    TestConversion(int16_to_float, int16_to_float_na, offset, offset);
+    TestConversion(int16_to_int32, int16_to_int32_na, offset, offset);
+    TestConversion(int32_to_float, int32_to_float_na, offset, offset);
+    TestConversion(float_to_int32, float_to_int32_na, offset, offset);
+    TestConversion(float_to_int16, float_to_int16_na, offset, offset);
+    TestConversion(int32_to_int16, int32_to_int16_na, offset, offset);
+  }
+}
+
+TEST(Arithmetic, complex_multiply_array) {
+  const int N = 70;
+  float a[N + 1], b[N + 1], res[N + 1], verif[N];
+  for (int i = 0; i < N + 1; i++) {
+    a[i] = i * 0.5f - 3;
+    b[i] = 7 - i * 0.25f;
+  }
+  for (int offset = 0; offset < 2; offset++) {
+    for (int length = 0; length <= N; length += 2) {
+      memsetf(res, 0.f, N + 1);
+      complex_multiply_array(a + offset, b + offset, length, res + offset);
+      complex_multiply_array_na(a + offset, b + offset, length, verif);
+      ASSERT_EQ(0, memcmp(res + offset, verif, length * sizeof(res[0])))
+          << "length = " << length;
+      for (int i = offset + length; i < N + 1; i++) {
+        ASSERT_EQ(0.f, res[i]) << "length = " << length;
+      }
+      complex_multiply_conjugate_array(a + offset, b + offset, length,
+                                       res + offset);
+      complex_multiply_conjugate_array_na(a + offset, b + offset, length,
+                                          verif);
+      ASSERT_EQ(0, memcmp(res + offset, verif, length * sizeof(res[0])))
+          << "length = " << length;
+    }
+  }
+  // in-place
+  memcpy(res, a, sizeof(a));
+  complex_multiply_array(res, b, N, res);
+  complex_multiply_array_na(a, b, N, verif);
+  ASSERT_EQ(0, memcmp(res, verif, N * sizeof(res[0])));
+}
+
+TEST(Arithmetic, complex_multiply_add_array) {
+  const int N = 70;
+  float a[N + 1], b[N + 1], res[N + 1], verif[N + 1];
+  for (int i = 0; i < N + 1; i++) {
+    a[i] = i * 0.5f - 3;
+    b[i] = 7 - i * 0.25f;
+  }
+  for (int offset = 0; offset < 2; offset++) {
+    for (int length = 0; length <= N; length += 2) {
+      for (int i = 0; i < N + 1; i++) {
+        res[i] = verif[i] = i;
+      }
+      complex_multiply_add_array(a + offset, b + offset, length, res + offset);
+      complex_multiply_add_array_na(a + offset, b + offset, length,
+                                    verif + offset);
+      for (int i = 0; i < N + 1; i++) {
+        // FMA may round differently
+        ASSERT_NEAR(verif[i], res[i], 1e-4f) << "length = " << length;
+      }
+    }
+  }
+}
+
+TEST(Arithmetic, complex_conjugate) {
+  const int N = 38;
+  float ar[N], res[N], verif[N];
+  for (int i = 0; i < N; i++) {
+    ar[i] = i - 10.5f;
+  }
+  for (int length = 0; length <= N; length += 2) {
+    complex_conjugate(ar, length, res);
+    complex_conjugate_na(ar, length, verif);
+    ASSERT_EQ(0, memcmp(res, verif, length * sizeof(res[0])))
+        << "length = " << length;
+  }
+}
+
+TEST(Arithmetic, complex_split) {
+  const int N = 37;
+  float a[2 * N], b[2 * N], res[2 * N], verif[2 * N];
+  float are[N], aim[N], bre[N], bim[N], resre[N], resim[N];
+  for (int i = 0; i < 2 * N; i++) {
+    a[i] = i * 0.5f - 3;
+    b[i] = 7 - i * 0.25f;
+  }
+  for (int length = 0; length <= N; length++) {
+    complex_split(a, length, are, aim);
+    complex_split(b, length, bre, bim);
+    for (int i = 0; i < length; i++) {
+      ASSERT_EQ(a[2 * i], are[i]) << "length = " << length;
+      ASSERT_EQ(a[2 * i + 1], aim[i]) << "length = " << length;
+    }
+    memsetf(res, 0.f, 2 * N);
+    complex_interleave(are, aim, length, res);
+    ASSERT_EQ(0, memcmp(a, res, 2 * length * sizeof(res[0])))
+        << "length = " << length;
+    for (int i = 2 * length; i < 2 * N; i++) {
+      ASSERT_EQ(0.f, res[i]) << "length = " << length;
+    }
+
+    // FMA may round differently
+    complex_multiply_split(are, aim, bre, bim, length, resre, resim);
+    complex_interleave(resre, resim, length, res);
+    complex_multiply_array_na(a, b, 2 * length, verif);
+    for (int i = 0; i < 2 * length; i++) {
+      ASSERT_NEAR(verif[i], res[i], 1e-3f) << "length = " << length;
+    }
+    complex_multiply_conjugate_split(are, aim, bre, bim, length,
+                                     resre, resim);
+    complex_interleave(resre, resim, length, res);
+    complex_multiply_conjugate_array_na(a, b, 2 * length, verif);
+    for (int i = 0; i < 2 * length; i++) {
+      ASSERT_NEAR(verif[i], res[i], 1e-3f) << "length = " << length;
+    }
+    for (int i = 0; i < length; i++) {
+      resre[i] = i;
+      resim[i] = -i;
+      verif[2 * i] = i;
+      verif[2 * i + 1] = -i;
+    }
+    complex_multiply_add_split(are, aim, bre, bim, length, resre, resim);
+    complex_interleave(resre, resim, length, res);
+    complex_multiply_add_array_na(a, b, 2 * length, verif);
+    for (int i = 0; i < 2 * length; i++) {
+      ASSERT_NEAR(verif[i], res[i], 1e-3f) << "length = " << length;
+    }
+    complex_conjugate_split(are, aim, length, resre, resim);
+    complex_interleave(resre, resim, length, res);
+    complex_conjugate_na(a, 2 * length, verif);
+    ASSERT_EQ(0, memcmp(res, verif, 2 * length * sizeof(res[0])))
+        << "length = " << length;
+  }
+  // in-place
+  complex_split(a, N, are, aim);
+  complex_split(b, N, bre, bim);
+  complex_multiply_split(are, aim, bre, bim, N, are, aim);
+  complex_interleave(are, aim, N, res);
+  complex_multiply_array_na(a, b, 2 * N, verif);
+  for (int i = 0; i < 2 * N; i++) {
+    ASSERT_NEAR(verif[i], res[i], 1e-3f);
+  }
+}
+
 TEST(Arithmetic, float16_to_float_na) {
   uint16_t data[] = { 12288, 16777, 18103, 49820, 17421, 18573, 18420, 49771,
                       24528, 2, 32785, 168 };
@@ -359,6 +532,7 @@ TEST(Arithmetic, float16_to_float_na) {
   ASSERT_NE(peak[4], peak[4]);
 }
 
+#ifdef SIMD
 TEST(Arithmetic, float16_to_float) {
   uint16_t data[]
 #ifndef __arm__
@@ -413,5 +587,251 @@ TEST(Arithmetic, float16_to_float) {
     ASSERT_NEAR(reference_subnormals[i], peak[i], 0.2e-7) << "i = " << i;
   }
 }
+#endif
+
+static uint32_t float_bits(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+TEST(Arithmetic, float_to_float16) {
+  // Every half converts exactly and comes back
+  const int N = 65536;
+  std::vector<uint16_t> halves(N), back(N), verif_halves(N);
+  std::vector<float> floats(N), verif(N);
+  for (int i = 0; i < N; i++) {
+    halves[i] = i;
+  }
+  float16_to_float(halves.data(), N, floats.data());
+  float16_to_float_na(halves.data(), N, verif.data());
+  float_to_float16(floats.data(), N, back.data());
+  for (int i = 0; i < N; i++) {
+    bool nan = (i & 0x7c00) == 0x7c00 && (i & 0x3ff) != 0;
+    if (nan) {
+      ASSERT_NE(floats[i], floats[i]) << "i = " << i;
+      ASSERT_EQ(0x7c00, back[i] & 0x7c00) << "i = " << i;
+      ASSERT_NE(0, back[i] & 0x3ff) << "i = " << i;
+    } else {
+      ASSERT_EQ(float_bits(verif[i]), float_bits(floats[i])) << "i = " << i;
+      ASSERT_EQ(i, back[i]) << "i = " << i;
+    }
+  }
+  // The midpoints round to even, including the subnormals and the overflow
+  std::vector<float> mids;
+  std::vector<uint16_t> expected;
+  for (int i = 0; i < 0x7bff; i += 7) {
+    mids.push_back((verif[i] + verif[i + 1]) / 2);
+    expected.push_back(i & 1? i + 1 : i);
+    mids.push_back(-std::nextafter(mids.back(), 1e10f));
+    expected.push_back(0x8000 | (i + 1));
+  }
+  mids.push_back(65520.f);
+  expected.push_back(0x7c00);
+  mids.push_back(65519.f);
+  expected.push_back(0x7bff);
+  mids.push_back(1e-10f);
+  expected.push_back(0);
+  int M = mids.size();
+  float_to_float16(mids.data(), M, back.data());
+  float_to_float16_na(mids.data(), M, verif_halves.data());
+  for (int i = 0; i < M; i++) {
+    ASSERT_EQ(expected[i], verif_halves[i]) << mids[i];
+    ASSERT_EQ(expected[i], back[i]) << mids[i];
+  }
+}
+
+TEST(Arithmetic, bfloat16) {
+  const int N = 1003;
+  std::vector<float> data(N), back(N), verif(N);
+  std::vector<uint16_t> res(N), res_na(N);
+  for (int i = 0; i < N; i++) {
+    data[i] = (i - 500) * 1.37e-3f * (i % 7 + 1);
+  }
+  // Exactly halfway between two bfloat16-s: rounds to the even one
+  data[0] = 1.00390625f;
+  data[1] = 1.01171875f;
+  data[2] = NAN;
+  data[3] = -std::numeric_limits<float>::infinity();
+  float_to_bfloat16(data.data(), N, res.data());
+  float_to_bfloat16_na(data.data(), N, res_na.data());
+  for (int i = 0; i < N; i++) {
+    ASSERT_EQ(res_na[i], res[i]) << "i = " << i;
+  }
+  EXPECT_EQ(0x3f80, res[0]);
+  EXPECT_EQ(0x3f82, res[1]);
+  EXPECT_EQ(0x7fc0, res[2]);
+  EXPECT_EQ(0xff80, res[3]);
+  bfloat16_to_float(res.data(), N, back.data());
+  bfloat16_to_float_na(res.data(), N, verif.data());
+  for (int i = 4; i < N; i++) {
+    ASSERT_EQ(verif[i], back[i]) << "i = " << i;
+    ASSERT_NEAR(data[i], back[i], fabs(data[i]) / 256) << "i = " << i;
+  }
+}
+
+TEST(Arithmetic, quantize_int8) {
+  const int N = 1007;
+  std::vector<float> data(N), back(N), verif(N);
+  std::vector<int8_t> res(N), res_na(N);
+  for (int i = 0; i < N; i++) {
+    data[i] = (i - 400) * 0.013f;
+  }
+  data[5] = 1e9f;
+  data[6] = -1e9f;
+  data[7] = 0.25f;  // 2.5 steps rounds to 2
+  const float scale = 0.1f;
+  const int zero = -3;
+  quantize_int8(data.data(), N, scale, zero, res.data());
+  quantize_int8_na(data.data(), N, scale, zero, res_na.data());
+  for (int i = 0; i < N; i++) {
+    ASSERT_EQ(res_na[i], res[i]) << "i = " << i;
+    float expected = roundf(data[i] / scale) + zero;
+    expected = std::min(127.f, std::max(-128.f, expected));
+    ASSERT_NEAR(expected, res[i], 1) << "i = " << i;
+  }
+  EXPECT_EQ(127, res[5]);
+  EXPECT_EQ(-128, res[6]);
+  EXPECT_EQ(-1, res[7]);
+  dequantize_int8(res.data(), N, scale, zero, back.data());
+  dequantize_int8_na(res.data(), N, scale, zero, verif.data());
+  for (int i = 0; i < N; i++) {
+    ASSERT_FLOAT_EQ(verif[i], back[i]) << "i = " << i;
+    if (res[i] > -128 && res[i] < 127) {
+      ASSERT_NEAR(data[i], back[i], scale / 2 + 1e-6) << "i = " << i;
+    }
+  }
+  // Per channel: the second channel has the ten times larger range
+  const float scales[] = { 0.01f, 0.1f };
+  const int zeros[] = { 0, 5 };
+  std::vector<int8_t> channels(2 * 500);
+  std::vector<float> channelsBack(2 * 500);
+  quantize_int8_per_channel(data.data(), 2, 500, scales, zeros,
+                            channels.data());
+  dequantize_int8_per_channel(channels.data(), 2, 500, scales, zeros,
+                              channelsBack.data());
+  for (int c = 0; c < 2; c++) {
+    quantize_int8_na(data.data() + c * 500, 500, scales[c], zeros[c],
+                     res_na.data());
+    for (int i = 0; i < 500; i++) {
+      ASSERT_EQ(res_na[i], channels[c * 500 + i]) << c << " " << i;
+      ASSERT_FLOAT_EQ((res_na[i] - zeros[c]) * scales[c],
+                      channelsBack[c * 500 + i]) << c << " " << i;
+    }
+  }
+}
+
+TEST(Arithmetic, pcm) {
+  const int N = 1007;
+  std::vector<float> data(N), back(N), verif(N);
+  for (int i = 0; i < N; i++) {
+    data[i] = (i - 500) * 0.00197f;
+  }
+  data[5] = 1.5f;
+  data[6] = -1.5f;
+  data[7] = 1.f;
+  data[8] = -1.f;
+  data[9] = 2.5f / 32768;  // rounds to 2
+  data[10] = 1e20f;
+
+  std::vector<int16_t> pcm16(N), pcm16_na(N);
+  float_to_pcm16(data.data(), N, pcm16.data());
+  float_to_pcm16_na(data.data(), N, pcm16_na.data());
+  for (int i = 0; i < N; i++) {
+    ASSERT_EQ(pcm16_na[i], pcm16[i]) << "i = " << i;
+  }
+  EXPECT_EQ(32767, pcm16[5]);
+  EXPECT_EQ(-32768, pcm16[6]);
+  EXPECT_EQ(32767, pcm16[7]);
+  EXPECT_EQ(-32768, pcm16[8]);
+  EXPECT_EQ(2, pcm16[9]);
+  EXPECT_EQ(32767, pcm16[10]);
+  pcm16_to_float(pcm16.data(), N, back.data());
+  pcm16_to_float_na(pcm16.data(), N, verif.data());
+  for (int i = 11; i < N; i++) {
+    ASSERT_FLOAT_EQ(verif[i], back[i]) << "i = " << i;
+    ASSERT_NEAR(data[i], back[i], 0.5f / 32768) << "i = " << i;
+  }
+
+  std::vector<uint8_t> pcm24(3 * N), pcm24_na(3 * N);
+  float_to_pcm24(data.data(), N, pcm24.data());
+  float_to_pcm24_na(data.data(), N, pcm24_na.data());
+  for (int i = 0; i < 3 * N; i++) {
+    ASSERT_EQ(pcm24_na[i], pcm24[i]) << "i = " << i;
+  }
+  EXPECT_EQ(0xFF, pcm24[3 * 5]);
+  EXPECT_EQ(0xFF, pcm24[3 * 5 + 1]);
+  EXPECT_EQ(0x7F, pcm24[3 * 5 + 2]);
+  EXPECT_EQ(0, pcm24[3 * 6]);
+  EXPECT_EQ(0, pcm24[3 * 6 + 1]);
+  EXPECT_EQ(0x80, pcm24[3 * 6 + 2]);
+  pcm24_to_float(pcm24.data(), N, back.data());
+  pcm24_to_float_na(pcm24.data(), N, verif.data());
+  EXPECT_FLOAT_EQ(-1.f, back[6]);
+  for (int i = 11; i < N; i++) {
+    ASSERT_FLOAT_EQ(verif[i], back[i]) << "i = " << i;
+    ASSERT_NEAR(data[i], back[i], 0.5f / 8388608) << "i = " << i;
+  }
+  // Odd lengths exercise the overlapping stores near the end
+  for (int length = 1; length < 20; length++) {
+    std::vector<uint8_t> part(3 * length + 1, 0xAA);
+    float_to_pcm24(data.data(), length, part.data());
+    ASSERT_EQ(0xAA, part[3 * length]) << "length = " << length;
+    ASSERT_EQ(0, memcmp(pcm24_na.data(), part.data(), 3 * length));
+    pcm24_to_float(part.data(), length, back.data());
+    for (int i = 0; i < length; i++) {
+      ASSERT_FLOAT_EQ(verif[i], back[i]) << length << " " << i;
+    }
+  }
+
+  std::vector<int32_t> pcm32(N), pcm32_na(N);
+  float_to_pcm32(data.data(), N, pcm32.data());
+  float_to_pcm32_na(data.data(), N, pcm32_na.data());
+  for (int i = 0; i < N; i++) {
+    ASSERT_EQ(pcm32_na[i], pcm32[i]) << "i = " << i;
+  }
+  EXPECT_EQ(INT32_MAX, pcm32[5]);
+  EXPECT_EQ(INT32_MIN, pcm32[6]);
+  EXPECT_EQ(INT32_MAX, pcm32[7]);
+  EXPECT_EQ(INT32_MIN, pcm32[8]);
+  EXPECT_EQ(INT32_MAX, pcm32[10]);
+  pcm32_to_float(pcm32.data(), N, back.data());
+  pcm32_to_float_na(pcm32.data(), N, verif.data());
+  for (int i = 11; i < N; i++) {
+    ASSERT_FLOAT_EQ(verif[i], back[i]) << "i = " << i;
+    ASSERT_FLOAT_EQ(data[i], back[i]) << "i = " << i;
+  }
+}
+
+TEST(Arithmetic, sum_elements) {
+  const size_t N = 10000019;
+  std::vector<float> a(N), b(N);
+  for (size_t i = 0; i < N; i++) {
+    a[i] = 0.1f + (i % 7) * 0.01f;
+    b[i] = (i % 2? 1.f : -0.5f) * (1 + (i % 13) * 0.1f);
+  }
+  double sum = 0, dot = 0, absdot = 0, sumsq = 0;
+  for (size_t i = 0; i < N; i++) {
+    sum += a[i];
+    dot += static_cast<double>(a[i]) * b[i];
+    absdot += std::fabs(static_cast<double>(a[i]) * b[i]);
+    sumsq += static_cast<double>(a[i]) * a[i];
+  }
+  EXPECT_NEAR(sum, sum_elements(a.data(), N), sum * 5e-6);
+  EXPECT_NEAR(dot, dot_product(a.data(), b.data(), N), absdot * 5e-6);
+  EXPECT_NEAR(sumsq, sum_squares(a.data(), N), sumsq * 5e-6);
+  for (size_t length : { 0, 1, 7, 33, 1023, 1025, 4099 }) {
+    for (size_t offset = 0; offset < 3; offset++) {
+      const float *pa = a.data() + offset, *pb = b.data() + offset;
+      EXPECT_NEAR(sum_elements_na(pa, length), sum_elements(pa, length),
+                  1e-5 * (length + 1)) << length;
+      EXPECT_NEAR(dot_product_na(pa, pb, length),
+                  dot_product(pa, pb, length), 1e-5 * (length + 1))
+          << length;
+      EXPECT_NEAR(sum_squares_na(pa, length), sum_squares(pa, length),
+                  1e-5 * (length + 1)) << length;
+    }
+  }
+}
 
 #include "tests/google/src/gtest_main.cc"
@@ -0,0 +1,759 @@
+/*! @file benchmark.cc
+ *  @brief Standalone benchmark of the public kernels.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section Usage
+ *  benchmark [--filter=SUBSTRING] [--format=table|json|csv] [--output=FILE]
+ *            [--samples=N] [--min-time=MS] [--repeats=N] [--baseline]
+ *            [--list] [--compare=FILE|DIR] [--tolerance=PERCENT]
+ *            [--floor=NS] [--absolute]
+ *
+ *  Every case is warmed up, then timed in samples of the calibrated number
+ *  of iterations, each sample lasting at least --min-time milliseconds.
+ *  The minimum, median, 90th percentile and mean time per iteration are
+ *  reported, together with GFLOP/s and GB/s derived from the median.
+ *  --repeats measures every case that many times, in passes over all the
+ *  cases with the stack shifted across a page, and reports the run with the
+ *  lowest median, so that neither a disturbed run nor an unlucky layout
+ *  counts.
+ *  --baseline also times the version without SIMD acceleration where it
+ *  exists and reports the speedup.
+ *
+ *  --compare reads the results of a previous run with --format=csv, from
+ *  DIR/<instruction set>.csv if a directory is given, and exits with 2 if
+ *  the median of any case is more than --tolerance percent (30 by default)
+ *  and more than --floor nanoseconds (50 by default, for the sub-microsecond
+ *  cases) slower. The ratios to the baseline are divided by their median, so
+ *  that a faster or a slower host of the same instruction set is not
+ *  reported, unless --absolute is passed. The regressed cases are measured
+ *  in two more rounds and fail only if the regression repeats in both.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <alloca.h>
+#include <sys/stat.h>
+#include <simd/arithmetic.h>
+#include <simd/convolve.h>
+#include <simd/correlate.h>
+#include <simd/cpu.h>
+#include <simd/detect_peaks.h>
+#include <simd/matrix.h>
+#include <simd/memory.h>
+#include <simd/normalize.h>
+#include <simd/wavelet.h>
+
+namespace {
+
+/// @brief The single benchmarked operation of the fixed size.
+struct Case {
+  std::string group;
+  std::string name;
+  /// The characteristic size which is swept, e.g. the signal length.
+  size_t size;
+  /// The number of floating point operations per call, 0 if meaningless.
+  double flops;
+  /// The number of bytes read and written per call.
+  double bytes;
+  std::function<void()> simd;
+  /// The version without SIMD acceleration, may be empty.
+  std::function<void()> baseline;
+};
+
+/// @brief The timing of one body of Case, in nanoseconds per call.
+struct Timing {
+  size_t iterations;
+  double min;
+  double median;
+  double p90;
+  double mean;
+};
+
+struct Options {
+  std::string filter;
+  std::string format = "table";
+  std::string output;
+  int samples = 11;
+  double min_time = 2;
+  int repeats = 1;
+  bool baseline = false;
+  bool list = false;
+  std::string compare;
+  double tolerance = 30;
+  double floor = 50;
+  bool absolute = false;
+};
+
+/// @brief Prevents the compiler from dropping the results of inlined
+/// kernels.
+inline void clobber() {
+  asm volatile("" : : : "memory");
+}
+
+template <class T>
+std::shared_ptr<T> allocate(size_t length) {
+  T *ptr = reinterpret_cast<T *>(malloc_aligned(length * sizeof(T) + 64));
+  memset(ptr, 0, length * sizeof(T) + 64);
+  return std::shared_ptr<T>(ptr, std::free);
+}
+
+std::shared_ptr<float> signal(size_t length) {
+  auto ptr = allocate<float>(length);
+  for (size_t i = 0; i < length; i++) {
+    ptr.get()[i] = sinf(i * 0.1f) * 10 + (i % 7) * 0.5f;
+  }
+  return ptr;
+}
+
+double seconds_since(std::chrono::high_resolution_clock::time_point start) {
+  return std::chrono::duration<double>(
+      std::chrono::high_resolution_clock::now() - start).count();
+}
+
+Timing measure(const std::function<void()> &body, const Options &opts) {
+  // Warm up the caches and the branch predictors, at least for 3 calls
+  auto start = std::chrono::high_resolution_clock::now();
+  size_t calls = 0;
+  do {
+    body();
+    clobber();
+    calls++;
+  } while (calls < 3 || seconds_since(start) < opts.min_time * 1e-3 * 2);
+  double per_call = seconds_since(start) / calls;
+  size_t iterations = std::max<size_t>(
+      1, static_cast<size_t>(opts.min_time * 1e-3 / per_call));
+  std::vector<double> samples(opts.samples);
+  for (auto &sample : samples) {
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+      body();
+      clobber();
+    }
+    sample = seconds_since(start) * 1e9 / iterations;
+  }
+  std::sort(samples.begin(), samples.end());
+  Timing timing;
+  timing.iterations = iterations;
+  timing.min = samples.front();
+  timing.median = samples[samples.size() / 2];
+  timing.p90 = samples[std::min(samples.size() - 1,
+                                samples.size() * 9 / 10)];
+  timing.mean = 0;
+  for (double sample : samples) {
+    timing.mean += sample;
+  }
+  timing.mean /= samples.size();
+  return timing;
+}
+
+/// @brief Calls measure() with the stack moved down by shift bytes.
+__attribute__((noinline)) Timing measure_shifted(
+    const std::function<void()> &body, const Options &opts, size_t shift) {
+  volatile char *pad = reinterpret_cast<char *>(alloca(shift + 1));
+  pad[0] = 0;
+  return measure(body, opts);
+}
+
+/// @brief Calls measure() for every body --repeats times, in passes over
+/// all of them, so that a slow period of the host spoils only one run of
+/// each body. Every pass moves the stack by a fraction of the page: some
+/// kernels are up to 1.5x slower when their stack aliases the heap buffers
+/// (4K aliasing), which is random for a process with ASLR.
+/// @return The runs with the lowest median, in the order of bodies.
+std::vector<Timing> measure_passes(
+    const std::vector<const std::function<void()> *> &bodies,
+    const Options &opts) {
+  std::vector<Timing> timings(bodies.size());
+  for (int pass = 0; pass < opts.repeats; pass++) {
+    size_t shift = pass * 4096 / opts.repeats;
+    for (size_t i = 0; i < bodies.size(); i++) {
+      Timing timing = measure_shifted(*bodies[i], opts, shift);
+      if (pass == 0 || timing.median < timings[i].median) {
+        timings[i] = timing;
+      }
+    }
+  }
+  return timings;
+}
+
+void add_convolution_cases(std::vector<Case> *cases) {
+  const struct {
+    ConvolutionAlgorithm algorithm;
+    const char *name;
+  } algorithms[] = {
+    { kConvolutionAlgorithmBruteForce, "brute_force" },
+    { kConvolutionAlgorithmFFT, "fft" },
+    { kConvolutionAlgorithmOverlapSave, "overlap_save" },
+    { kConvolutionAlgorithmPartitioned, "partitioned" }
+  };
+  for (size_t x_length : { 1024, 16384, 131072 }) {
+    for (size_t h_length : { 16, 256, 2048 }) {
+      if (h_length >= x_length / 2) {
+        continue;
+      }
+      auto x = signal(x_length), h = signal(h_length);
+      auto result = allocate<float>(x_length + h_length - 1);
+      double flops = 2.0 * x_length * h_length;
+      double bytes = (2.0 * (x_length + h_length) - 1) * sizeof(float);
+      for (auto &algorithm : algorithms) {
+        auto alg = algorithm.algorithm;
+        std::string suffix = "/h" + std::to_string(h_length);
+        std::shared_ptr<ConvolutionHandle> conv(
+            new ConvolutionHandle(convolve_initialize_algorithm(
+                x_length, h_length, alg)),
+            [](ConvolutionHandle *handle) {
+              convolve_finalize(*handle);
+              delete handle;
+            });
+        std::shared_ptr<CrossCorrelationHandle> corr(
+            new CrossCorrelationHandle(cross_correlate_initialize_algorithm(
+                x_length, h_length, alg)),
+            [](CrossCorrelationHandle *handle) {
+              cross_correlate_finalize(*handle);
+              delete handle;
+            });
+        std::function<void()> conv_baseline, corr_baseline;
+        if (alg == kConvolutionAlgorithmBruteForce) {
+          conv_baseline = [=]() {
+            convolve_simd(false, x.get(), x_length, h.get(), h_length,
+                          result.get());
+          };
+          corr_baseline = [=]() {
+            cross_correlate_simd(false, x.get(), x_length, h.get(),
+                                 h_length, result.get());
+          };
+        }
+        cases->push_back({
+          "convolve", algorithm.name + suffix, x_length, flops, bytes,
+          [=]() { convolve(*conv, x.get(), h.get(), result.get()); },
+          conv_baseline });
+        cases->push_back({
+          "correlate", algorithm.name + suffix, x_length, flops, bytes,
+          [=]() { cross_correlate(*corr, x.get(), h.get(), result.get()); },
+          corr_baseline });
+      }
+    }
+  }
+}
+
+void add_wavelet_cases(std::vector<Case> *cases) {
+  const struct {
+    WaveletType type;
+    const char *name;
+  } types[] = {
+    { WAVELET_TYPE_DAUBECHIES, "daubechies" },
+    { WAVELET_TYPE_COIFLET, "coiflet" },
+    { WAVELET_TYPE_SYMLET, "symlet" }
+  };
+  for (size_t length : { 512, 8192, 131072 }) {
+    auto src = signal(length);
+    auto coeffs = allocate<float>(length);
+    auto hi = allocate<float>(length), lo = allocate<float>(length);
+    for (auto &type : types) {
+      for (int order : { 2, 4, 6, 8, 12, 16 }) {
+        if (!wavelet_validate_order(type.type, order)) {
+          continue;
+        }
+        auto t = type.type;
+        std::string name = type.name + std::to_string(order);
+        std::shared_ptr<float> prepared(
+            wavelet_prepare_array(order, src.get(), length), std::free);
+        std::shared_ptr<float> desthi(
+            wavelet_allocate_destination(order, length), std::free);
+        std::shared_ptr<float> destlo(
+            wavelet_allocate_destination(order, length), std::free);
+        // Both halves are filtered with order taps
+        double flops = 2.0 * order * length;
+        double bytes = 2.0 * length * sizeof(float);
+        cases->push_back({
+          "wavelet", name, length, flops, bytes,
+          [=]() {
+            wavelet_apply(t, order, EXTENSION_TYPE_PERIODIC,
+                          prepared.get(), length, desthi.get(),
+                          destlo.get());
+          },
+          [=]() {
+            wavelet_apply_na(t, order, EXTENSION_TYPE_PERIODIC, src.get(),
+                             length, desthi.get(), destlo.get());
+          } });
+        for (int level : { 1, 2, 3 }) {
+          cases->push_back({
+            "stationary_wavelet", name + "/level" + std::to_string(level),
+            length, 4.0 * order * length, 3.0 * length * sizeof(float),
+            [=]() {
+              stationary_wavelet_apply(t, order, level,
+                                       EXTENSION_TYPE_PERIODIC, src.get(),
+                                       length, hi.get(), lo.get());
+            },
+            [=]() {
+              stationary_wavelet_apply_na(t, order, level,
+                                          EXTENSION_TYPE_PERIODIC,
+                                          src.get(), length, hi.get(),
+                                          lo.get());
+            } });
+        }
+        for (int levels : { 3, 6 }) {
+          cases->push_back({
+            "wavelet_decompose", name + "/levels" + std::to_string(levels),
+            length, 2 * flops, 2 * bytes,
+            [=]() {
+              wavelet_decompose(t, order, EXTENSION_TYPE_PERIODIC, levels,
+                                src.get(), length, coeffs.get());
+            },
+            nullptr });
+        }
+      }
+    }
+  }
+}
+
+void add_matrix_cases(std::vector<Case> *cases) {
+  for (size_t n : { 16, 64, 256, 1024 }) {
+    auto a = signal(n * n), b = signal(n * n), c = allocate<float>(n * n);
+    auto v = signal(n), y = allocate<float>(n);
+    double flops = 2.0 * n * n * n;
+    double bytes = 3.0 * n * n * sizeof(float);
+    auto multiply = [=](bool simd) {
+      return [=]() {
+        matrix_multiply(simd, a.get(), b.get(), n, n, n, n, c.get());
+      };
+    };
+    auto multiply_transposed = [=](bool simd) {
+      return [=]() {
+        matrix_multiply_transposed(simd, a.get(), b.get(), n, n, n, n,
+                                   c.get());
+      };
+    };
+    auto gemv = [=](bool simd) {
+      return [=]() {
+        matrix_vector_multiply(simd, a.get(), v.get(), n, n, 1, 0, y.get());
+      };
+    };
+    cases->push_back({ "matrix", "multiply", n, flops, bytes,
+                       multiply(true), multiply(false) });
+    cases->push_back({ "matrix", "multiply_transposed", n, flops, bytes,
+                       multiply_transposed(true), multiply_transposed(false) });
+    cases->push_back({ "matrix", "vector_multiply", n, 2.0 * n * n,
+                       (n * n + 2.0 * n) * sizeof(float), gemv(true),
+                       gemv(false) });
+  }
+}
+
+void add_conversion_cases(std::vector<Case> *cases) {
+  for (size_t length : { 512, 16384, 1048576 }) {
+    auto f = signal(length), g = signal(length);
+    auto res = allocate<float>(length * 2);
+    auto i16 = allocate<int16_t>(length);
+    auto i32 = allocate<int32_t>(length);
+    auto u16 = allocate<uint16_t>(length);
+    double n = length;
+    cases->push_back({
+      "conversion", "int16_to_float", length, 0, n * 6,
+      [=]() { int16_to_float(i16.get(), length, res.get()); },
+      [=]() { int16_to_float_na(i16.get(), length, res.get()); } });
+    cases->push_back({
+      "conversion", "float_to_int16", length, 0, n * 6,
+      [=]() { float_to_int16(f.get(), length, i16.get()); },
+      [=]() { float_to_int16_na(f.get(), length, i16.get()); } });
+    cases->push_back({
+      "conversion", "int32_to_float", length, 0, n * 8,
+      [=]() { int32_to_float(i32.get(), length, res.get()); },
+      [=]() { int32_to_float_na(i32.get(), length, res.get()); } });
+    cases->push_back({
+      "conversion", "float_to_int32", length, 0, n * 8,
+      [=]() { float_to_int32(f.get(), length, i32.get()); },
+      [=]() { float_to_int32_na(f.get(), length, i32.get()); } });
+    cases->push_back({
+      "conversion", "float16_to_float", length, 0, n * 6,
+      [=]() { float16_to_float(u16.get(), length, res.get()); },
+      [=]() { float16_to_float_na(u16.get(), length, res.get()); } });
+    cases->push_back({
+      "conversion", "float_to_float16", length, 0, n * 6,
+      [=]() { float_to_float16(f.get(), length, u16.get()); },
+      [=]() { float_to_float16_na(f.get(), length, u16.get()); } });
+    cases->push_back({
+      "arithmetic", "real_multiply_array", length, n, n * 12,
+      [=]() { real_multiply_array(f.get(), g.get(), length, res.get()); },
+      [=]() {
+        real_multiply_array_na(f.get(), g.get(), length, res.get());
+      } });
+    cases->push_back({
+      "arithmetic", "complex_multiply_array", length, n * 3, n * 12,
+      [=]() {
+        complex_multiply_array(f.get(), g.get(), length, res.get());
+      },
+      [=]() {
+        complex_multiply_array_na(f.get(), g.get(), length, res.get());
+      } });
+    cases->push_back({
+      "arithmetic", "dot_product", length, n * 2, n * 8,
+      [=]() { *res.get() = dot_product(f.get(), g.get(), length); },
+      [=]() { *res.get() = dot_product_na(f.get(), g.get(), length); } });
+  }
+}
+
+void add_normalize_cases(std::vector<Case> *cases) {
+  for (int side : { 64, 512, 2048 }) {
+    size_t size = side * side;
+    auto src8 = allocate<uint8_t>(size);
+    for (size_t i = 0; i < size; i++) {
+      src8.get()[i] = (i * 7) & 0xFF;
+    }
+    auto f = signal(size), dst = allocate<float>(size);
+    auto normalize = [=](bool simd) {
+      return [=]() {
+        normalize2D(simd, src8.get(), side, side, side, dst.get(), side);
+      };
+    };
+    auto zscore = [=](bool simd) {
+      return [=]() { normalize1D_zscore(simd, f.get(), size, dst.get()); };
+    };
+    auto minmax = [=](bool simd) {
+      return [=]() {
+        float min, max;
+        minmax1D(simd, f.get(), size, &min, &max);
+        *dst.get() = min + max;
+      };
+    };
+    cases->push_back({ "normalize", "normalize2D", size, 2.0 * size,
+                       5.0 * size, normalize(true), normalize(false) });
+    cases->push_back({ "normalize", "normalize1D_zscore", size, 4.0 * size,
+                       12.0 * size, zscore(true), zscore(false) });
+    cases->push_back({ "normalize", "minmax1D", size, 2.0 * size,
+                       4.0 * size, minmax(true), minmax(false) });
+  }
+}
+
+void add_peaks_cases(std::vector<Case> *cases) {
+  for (size_t length : { 512, 16384, 1048576 }) {
+    auto data = signal(length);
+    auto peaks = [=](bool simd) {
+      return [=]() {
+        ExtremumPoint *results;
+        size_t count;
+        detect_peaks(simd, data.get(), length, kExtremumTypeBoth, &results,
+                     &count);
+        free(results);
+      };
+    };
+    cases->push_back({ "detect_peaks", "both", length, 0,
+                       4.0 * length, peaks(true), peaks(false) });
+  }
+}
+
+std::vector<Case> all_cases() {
+  std::vector<Case> cases;
+  add_convolution_cases(&cases);
+  add_wavelet_cases(&cases);
+  add_matrix_cases(&cases);
+  add_conversion_cases(&cases);
+  add_normalize_cases(&cases);
+  add_peaks_cases(&cases);
+  return cases;
+}
+
+std::string full_name(const Case &c) {
+  return c.group + "/" + c.name + "/" + std::to_string(c.size);
+}
+
+void write_header(FILE *out, const Options &opts) {
+  const char *isa = simd_instruction_set_name(simd_instruction_set());
+  if (opts.format == "json") {
+    fprintf(out, "{\n  \"instruction_set\": \"%s\",\n  \"samples\": %d,\n"
+                 "  \"min_time_ms\": %g,\n  \"results\": [", isa,
+            opts.samples, opts.min_time);
+  } else if (opts.format == "csv") {
+    fprintf(out, "group,name,size,simd,iterations,min_ns,median_ns,p90_ns,"
+                 "mean_ns,gflops,gbps\n");
+  } else {
+    fprintf(out, "Instruction set: %s\n%-44s %12s %12s %9s %9s %8s\n", isa,
+            "case", "median, ns", "p90, ns", "GFLOP/s", "GB/s", "speedup");
+  }
+}
+
+void write_result(FILE *out, const Options &opts, const Case &c, bool simd,
+                  const Timing &t, double speedup, bool first) {
+  double gflops = c.flops / t.median, gbps = c.bytes / t.median;
+  if (opts.format == "json") {
+    fprintf(out, "%s\n    {\"group\": \"%s\", \"name\": \"%s\", "
+                 "\"size\": %zu, \"simd\": %s, \"iterations\": %zu, "
+                 "\"min_ns\": %.1f, \"median_ns\": %.1f, \"p90_ns\": %.1f, "
+                 "\"mean_ns\": %.1f, \"gflops\": %.3f, \"gbps\": %.3f}",
+            first? "" : ",", c.group.c_str(), c.name.c_str(), c.size,
+            simd? "true" : "false", t.iterations, t.min, t.median, t.p90,
+            t.mean, gflops, gbps);
+  } else if (opts.format == "csv") {
+    fprintf(out, "%s,%s,%zu,%d,%zu,%.1f,%.1f,%.1f,%.1f,%.3f,%.3f\n",
+            c.group.c_str(), c.name.c_str(), c.size, simd, t.iterations,
+            t.min, t.median, t.p90, t.mean, gflops, gbps);
+  } else {
+    std::string name = full_name(c) + (simd? "" : " (no SIMD)");
+    fprintf(out, "%-44s %12.0f %12.0f %9.2f %9.2f", name.c_str(), t.median,
+            t.p90, gflops, gbps);
+    if (speedup > 0) {
+      fprintf(out, " %7.2fx", speedup);
+    }
+    fprintf(out, "\n");
+  }
+  fflush(out);
+}
+
+void write_footer(FILE *out, const Options &opts) {
+  if (opts.format == "json") {
+    fprintf(out, "\n  ]\n}\n");
+  }
+}
+
+/// @brief Loads the median times of the SIMD cases from the CSV written
+/// with --format=csv, by full_name().
+/// @return false if the file does not exist.
+bool load_baseline(const std::string &path,
+                   std::map<std::string, double> *medians) {
+  FILE *in = fopen(path.c_str(), "r");
+  if (in == nullptr) {
+    return false;
+  }
+  char line[1024];
+  // Skip the header
+  if (fgets(line, sizeof(line), in) == nullptr) {
+    fclose(in);
+    return true;
+  }
+  while (fgets(line, sizeof(line), in) != nullptr) {
+    std::vector<std::string> fields;
+    const char *begin = line;
+    for (const char *ptr = line; ; ptr++) {
+      if (*ptr == ',' || *ptr == '\n' || *ptr == 0) {
+        fields.emplace_back(begin, ptr);
+        begin = ptr + 1;
+        if (*ptr != ',') {
+          break;
+        }
+      }
+    }
+    // group,name,size,simd,iterations,min_ns,median_ns,...
+    if (fields.size() < 7 || fields[3] != "1") {
+      continue;
+    }
+    (*medians)[fields[0] + "/" + fields[1] + "/" + fields[2]] =
+        atof(fields[6].c_str());
+  }
+  fclose(in);
+  return true;
+}
+
+/// @brief Resolves --compare to the file of the current instruction set.
+std::string baseline_path(const std::string &compare) {
+  struct stat info;
+  if (stat(compare.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+    return compare + "/" +
+        simd_instruction_set_name(simd_instruction_set()) + ".csv";
+  }
+  return compare;
+}
+
+/// @brief A measured case which is present in the baseline.
+struct Comparison {
+  const Case *c;
+  double median;
+  double baseline;
+};
+
+/// @brief Prints the cases which are slower than the baseline beyond
+/// the tolerance.
+/// @return The number of the regressed cases.
+int report_regressions(std::vector<Comparison> *comparisons,
+                       const Options &opts) {
+  if (comparisons->empty()) {
+    return 0;
+  }
+  double scale = 1;
+  if (!opts.absolute) {
+    std::vector<double> ratios;
+    for (auto &cmp : *comparisons) {
+      ratios.push_back(cmp.median / cmp.baseline);
+    }
+    std::nth_element(ratios.begin(), ratios.begin() + ratios.size() / 2,
+                     ratios.end());
+    scale = ratios[ratios.size() / 2];
+  }
+  double limit = 1 + opts.tolerance / 100;
+  auto regressed = [&](double median, double baseline) {
+    return median > baseline * scale * limit &&
+        median - baseline * scale > opts.floor;
+  };
+  // The regression must repeat in two more rounds, the best median counts
+  for (int round = 0; round < 2; round++) {
+    std::vector<Comparison *> suspects;
+    std::vector<const std::function<void()> *> bodies;
+    for (auto &cmp : *comparisons) {
+      if (regressed(cmp.median, cmp.baseline)) {
+        suspects.push_back(&cmp);
+        bodies.push_back(&cmp.c->simd);
+      }
+    }
+    if (suspects.empty()) {
+      break;
+    }
+    auto timings = measure_passes(bodies, opts);
+    for (size_t i = 0; i < suspects.size(); i++) {
+      suspects[i]->median = std::min(suspects[i]->median, timings[i].median);
+    }
+  }
+  int regressions = 0;
+  for (auto &cmp : *comparisons) {
+    double ratio = cmp.median / cmp.baseline / scale;
+    if (regressed(cmp.median, cmp.baseline)) {
+      fprintf(stderr, "REGRESSION %s: %.0f ns, baseline %.0f ns (%+.0f%%)\n",
+              full_name(*cmp.c).c_str(), cmp.median, cmp.baseline * scale,
+              (ratio - 1) * 100);
+      regressions++;
+    }
+  }
+  fprintf(stderr, "%d of %zu cases are more than %g%% and %g ns slower than "
+                  "the baseline (host speed factor %.2f)\n",
+          regressions, comparisons->size(), opts.tolerance, opts.floor,
+          scale);
+  return regressions;
+}
+
+bool parse_options(int argc, char **argv, Options *opts) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto value = [&arg](const char *prefix) -> const char * {
+      size_t length = strlen(prefix);
+      return arg.compare(0, length, prefix)? nullptr : arg.c_str() + length;
+    };
+    const char *v;
+    if ((v = value("--filter="))) {
+      opts->filter = v;
+    } else if ((v = value("--format="))) {
+      opts->format = v;
+      if (opts->format != "table" && opts->format != "json" &&
+          opts->format != "csv") {
+        fprintf(stderr, "Unknown format: %s\n", v);
+        return false;
+      }
+    } else if ((v = value("--output="))) {
+      opts->output = v;
+    } else if ((v = value("--samples="))) {
+      opts->samples = std::max(1, atoi(v));
+    } else if ((v = value("--min-time="))) {
+      opts->min_time = std::max(0.01, atof(v));
+    } else if ((v = value("--repeats="))) {
+      opts->repeats = std::max(1, atoi(v));
+    } else if (arg == "--baseline") {
+      opts->baseline = true;
+    } else if (arg == "--list") {
+      opts->list = true;
+    } else if ((v = value("--compare="))) {
+      opts->compare = v;
+    } else if ((v = value("--tolerance="))) {
+      opts->tolerance = std::max(0.0, atof(v));
+    } else if ((v = value("--floor="))) {
+      opts->floor = std::max(0.0, atof(v));
+    } else if (arg == "--absolute") {
+      opts->absolute = true;
+    } else {
+      fprintf(stderr, "Usage: %s [--filter=SUBSTRING] "
+                      "[--format=table|json|csv] [--output=FILE] "
+                      "[--samples=N] [--min-time=MS] [--repeats=N] "
+                      "[--baseline] [--list] [--compare=FILE|DIR] "
+                      "[--tolerance=PERCENT] [--floor=NS] [--absolute]\n",
+              argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options opts;
+  if (!parse_options(argc, argv, &opts)) {
+    return 1;
+  }
+  auto cases = all_cases();
+  if (opts.list) {
+    for (auto &c : cases) {
+      printf("%s\n", full_name(c).c_str());
+    }
+    return 0;
+  }
+  std::map<std::string, double> baseline;
+  if (!opts.compare.empty()) {
+    std::string path = baseline_path(opts.compare);
+    if (!load_baseline(path, &baseline)) {
+      fprintf(stderr, "No baseline %s, the comparison is skipped\n",
+              path.c_str());
+      return 0;
+    }
+  }
+  std::vector<Comparison> comparisons;
+  FILE *out = stdout;
+  if (!opts.output.empty()) {
+    out = fopen(opts.output.c_str(), "w");
+    if (out == nullptr) {
+      perror(opts.output.c_str());
+      return 1;
+    }
+  }
+  std::vector<const Case *> selected;
+  std::vector<const std::function<void()> *> bodies;
+  for (auto &c : cases) {
+    if (full_name(c).find(opts.filter) == std::string::npos) {
+      continue;
+    }
+    selected.push_back(&c);
+    bodies.push_back(&c.simd);
+    if (opts.baseline && c.baseline) {
+      bodies.push_back(&c.baseline);
+    }
+  }
+  auto timings = measure_passes(bodies, opts);
+  write_header(out, opts);
+  bool first = true;
+  auto timing = timings.begin();
+  for (auto c : selected) {
+    Timing simd = *timing++;
+    double speedup = 0;
+    if (opts.baseline && c->baseline) {
+      Timing baseline = *timing++;
+      speedup = baseline.median / simd.median;
+      write_result(out, opts, *c, false, baseline, 0, first);
+      first = false;
+    }
+    write_result(out, opts, *c, true, simd, speedup, first);
+    first = false;
+    auto it = baseline.find(full_name(*c));
+    if (it != baseline.end() && it->second > 0) {
+      comparisons.push_back({ c, simd.median, it->second });
+    }
+  }
+  write_footer(out, opts);
+  if (out != stdout) {
+    fclose(out);
+  }
+  if (!opts.compare.empty() &&
+      report_regressions(&comparisons, opts) > 0) {
+    return 2;
+  }
+  return 0;
+}
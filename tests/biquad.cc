@@ -0,0 +1,134 @@
+/*! @file biquad.cc
+ *  @brief Tests for src/biquad.c.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include <simd/biquad.h>
+
+/// @brief The lowpass section from the Audio EQ Cookbook.
+static BiquadCoefficients lowpass(double frequency, double q) {
+  double w = 2 * M_PI * frequency, alpha = sin(w) / (2 * q);
+  double a0 = 1 + alpha;
+  BiquadCoefficients k;
+  k.b0 = (1 - cos(w)) / 2 / a0;
+  k.b1 = (1 - cos(w)) / a0;
+  k.b2 = k.b0;
+  k.a1 = -2 * cos(w) / a0;
+  k.a2 = (1 - alpha) / a0;
+  return k;
+}
+
+/// @brief The direct form I cascade in double precision.
+static std::vector<float> biquad_reference(
+    const std::vector<BiquadCoefficients>& sections, int channels,
+    const std::vector<float>& x) {
+  size_t frames = x.size() / channels;
+  std::vector<double> signal(x.begin(), x.end());
+  for (auto& k : sections) {
+    for (int c = 0; c < channels; c++) {
+      double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+      for (size_t t = 0; t < frames; t++) {
+        double v = signal[t * channels + c];
+        double y = k.b0 * v + k.b1 * x1 + k.b2 * x2 - k.a1 * y1 - k.a2 * y2;
+        x2 = x1;
+        x1 = v;
+        y2 = y1;
+        y1 = y;
+        signal[t * channels + c] = y;
+      }
+    }
+  }
+  return std::vector<float>(signal.begin(), signal.end());
+}
+
+TEST(biquad, biquad_cascade_process) {
+  const int channelCounts[] = { 1, 3, 8, 11, 16 };
+  const int sectionCounts[] = { 1, 2, 4, 5, 9 };
+  const size_t frames = 2000;
+  for (int channels : channelCounts) {
+    std::vector<float> x(frames * channels);
+    for (size_t i = 0; i < x.size(); i++) {
+      x[i] = sinf(i * 0.013f) + 0.5f * sinf(i * 1.3f) + (i % 7 == 0);
+    }
+    for (int sectionCount : sectionCounts) {
+      std::vector<BiquadCoefficients> sections;
+      for (int s = 0; s < sectionCount; s++) {
+        sections.push_back(lowpass(0.02 + 0.03 * s, 0.6 + 0.2 * s));
+      }
+      auto verif = biquad_reference(sections, channels, x);
+      for (int simd = 0; simd < 2; simd++) {
+        auto cascade = biquad_cascade_initialize(sections.data(),
+                                                 sectionCount, channels);
+        std::vector<float> result(x.size());
+        biquad_cascade_process(simd, &cascade, x.data(), frames,
+                               result.data());
+        for (size_t i = 0; i < x.size(); i++) {
+          ASSERT_NEAR(verif[i], result[i], 1e-3f)
+              << channels << " " << sectionCount << " " << simd << " " << i;
+        }
+        // In place, block by block, the blocks shorter than the lanes too
+        biquad_cascade_reset(&cascade);
+        result = x;
+        size_t offset = 0;
+        for (size_t block = 1; offset < frames; block = block * 5 % 97) {
+          if (offset + block > frames) {
+            block = frames - offset;
+          }
+          float *data = result.data() + offset * channels;
+          biquad_cascade_process(simd, &cascade, data, block, data);
+          offset += block;
+        }
+        for (size_t i = 0; i < x.size(); i++) {
+          ASSERT_NEAR(verif[i], result[i], 1e-3f)
+              << channels << " " << sectionCount << " " << simd << " " << i;
+        }
+        biquad_cascade_finalize(&cascade);
+      }
+    }
+  }
+}
+
+TEST(biquad, biquad_cascade_reset) {
+  BiquadCoefficients k = lowpass(0.1, 0.707);
+  auto cascade = biquad_cascade_initialize(&k, 1, 1);
+  std::vector<float> x(100, 1.f), first(100), second(100);
+  biquad_cascade_process(1, &cascade, x.data(), x.size(), first.data());
+  biquad_cascade_reset(&cascade);
+  biquad_cascade_process(1, &cascade, x.data(), x.size(), second.data());
+  EXPECT_EQ(first, second);
+  // The lowpass keeps the constant signal
+  EXPECT_NEAR(1.f, second.back(), 1e-3f);
+  biquad_cascade_finalize(&cascade);
+}
+
+#include "tests/google/src/gtest_main.cc"
@@ -29,12 +29,12 @@
  */
 
 #include <gtest/gtest.h>
-#ifndef NO_FFTF
 #include <cmath>
+#include <cstring>
+#include <vector>
 #include <simd/convolve.h>
 #include <simd/memory.h>
 #include <simd/arithmetic.h>
-#include <fftf/api.h>
 
 void convolve_reference(const float *__restrict x, size_t xLength,
                         const float *__restrict h, size_t hLength,
@@ -103,6 +103,38 @@ TEST(convolve, convolve_fft) {
   ASSERT_EQ(-1, firstDifferenceIndex);
 }
 
+TEST(convolve, convolve_fft_smooth_length) {
+  // The result is just above a power of 2
+  const int xlen = 1000;
+  const int hlen = 26;
+
+  float x[xlen];
+  for (int i = 0; i < xlen; i++) {
+    x[i] = sinf(i) * 100;
+  }
+  float h[hlen];
+  for (int i = 0; i < hlen; i++) {
+    h[i] = i / (hlen - 1.0f);
+  }
+  float verif[xlen + hlen - 1];
+  convolve_reference(x, xlen, h, hlen, verif);
+
+  ASSERT_TRUE(convolve_smooth_fft_lengths());
+  const int lengths[] = { 1080, 2048 };
+  for (int length : lengths) {
+    convolve_set_smooth_fft_lengths(length != 2048);
+    auto handle = convolve_fft_initialize(xlen, hlen);
+    EXPECT_EQ(length, *handle.M);
+    float res[xlen + hlen - 1];
+    convolve_fft(handle, x, h, res);
+    convolve_fft_finalize(handle);
+    for (int i = 0; i < xlen + hlen - 1; i++) {
+      ASSERT_NEAR(verif[i], res[i], 1e-2f) << length << " " << i;
+    }
+  }
+  convolve_set_smooth_fft_lengths(true);
+}
+
 TEST(convolve, convolve_overlap_save) {
   const int xlen = 1021;
   const int hlen = 50;
@@ -136,6 +168,48 @@ TEST(convolve, convolve_overlap_save) {
   ASSERT_EQ(-1, firstDifferenceIndex);
 }
 
+TEST(convolve, initialize_in_place) {
+  const int xlen = 1021;
+  const int hlen = 50;
+
+  float x[xlen];
+  for (int i = 0; i < xlen; i++) {
+    x[i] = sinf(i) * 100;
+  }
+  float h[hlen];
+  for (int i = 0; i < hlen; i++) {
+    h[i] = i / (hlen- 1.0f);
+  }
+
+  float verif[xlen + hlen - 1];
+  convolve_reference(x, xlen, h, hlen, verif);
+
+  // Both handles share the single arena
+  size_t fftSize = convolve_fft_workspace_size(xlen, hlen);
+  size_t osSize = convolve_overlap_save_workspace_size(xlen, hlen);
+  fftSize = (fftSize + CONVOLUTION_WORKSPACE_ALIGNMENT - 1) &
+      ~(CONVOLUTION_WORKSPACE_ALIGNMENT - 1);
+  char *arena = reinterpret_cast<char *>(malloc_aligned(fftSize + osSize));
+  auto fftHandle = convolve_fft_initialize_in_place(xlen, hlen, arena);
+  auto osHandle = convolve_overlap_save_initialize_in_place(
+      xlen, hlen, arena + fftSize);
+
+  float res[xlen + hlen - 1];
+  for (int pass = 0; pass < 2; pass++) {
+    convolve_fft(fftHandle, x, h, res);
+    for (int i = 0; i < xlen + hlen - 1; i++) {
+      ASSERT_NEAR(verif[i], res[i], 1E-3) << "FFT " << i;
+    }
+    convolve_overlap_save(osHandle, x, h, res);
+    for (int i = 0; i < xlen + hlen - 1; i++) {
+      ASSERT_NEAR(verif[i], res[i], 1E-3) << "overlap-save " << i;
+    }
+  }
+  convolve_fft_finalize(fftHandle);
+  convolve_overlap_save_finalize(osHandle);
+  free(arena);
+}
+
 TEST(convolve, convolve_simd) {
   const int xlen = 1024;
   const int hlen = 50;
@@ -165,6 +239,474 @@ TEST(convolve, convolve_simd) {
   ASSERT_EQ(-1, firstDifferenceIndex);
 }
 
+TEST(convolve, convolve_simd_sizes) {
+  // Cover the register blocked kernel, its vector remainder and the edges
+  const int xlens[] = { 1, 3, 7, 8, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100,
+                        257 };
+  const int hlens[] = { 1, 2, 5, 8, 16, 17, 33, 64, 100 };
+  for (int xlen : xlens) {
+    for (int hlen : hlens) {
+      float x[xlen];
+      for (int i = 0; i < xlen; i++) {
+        x[i] = sinf(i + 1);
+      }
+      float h[hlen];
+      for (int i = 0; i < hlen; i++) {
+        h[i] = cosf(i) / hlen;
+      }
+      float verif[xlen + hlen - 1];
+      convolve_reference(x, xlen, h, hlen, verif);
+      float res[xlen + hlen - 1];
+      convolve_simd(true, x, xlen, h, hlen, res);
+      for (int i = 0; i < xlen + hlen - 1; i++) {
+        ASSERT_NEAR(verif[i], res[i], 1E-5) << "xLength " << xlen
+            << ", hLength " << hlen << ", index " << i;
+      }
+    }
+  }
+}
+
+TEST(convolve, convolve_simd_double) {
+  const int xlens[] = { 1, 7, 16, 33, 100, 257 };
+  const int hlens[] = { 1, 5, 17, 64 };
+  for (int xlen : xlens) {
+    for (int hlen : hlens) {
+      std::vector<double> x(xlen), h(hlen);
+      for (int i = 0; i < xlen; i++) {
+        x[i] = sin(i + 1);
+      }
+      for (int i = 0; i < hlen; i++) {
+        h[i] = cos(i) / hlen;
+      }
+      std::vector<double> na(xlen + hlen - 1), res(xlen + hlen - 1);
+      convolve_simd_double(false, x.data(), xlen, h.data(), hlen, na.data());
+      convolve_simd_double(true, x.data(), xlen, h.data(), hlen, res.data());
+      for (int n = 0; n < xlen + hlen - 1; n++) {
+        double sum = 0;
+        for (int m = 0; m < hlen; m++) {
+          if (n - m >= 0 && n - m < xlen) {
+            sum += h[m] * x[n - m];
+          }
+        }
+        ASSERT_NEAR(sum, na[n], 1E-13) << xlen << " " << hlen << " " << n;
+        ASSERT_NEAR(sum, res[n], 1E-13) << xlen << " " << hlen << " " << n;
+      }
+    }
+  }
+}
+
+TEST(convolve, convolve_stream) {
+  const int xlen = 3000;
+  const int hlen = 77;
+  const int block = 256;
+
+  float x[xlen + hlen];
+  for (int i = 0; i < xlen; i++) {
+    x[i] = sinf(i) * 100;
+  }
+  memsetf(x + xlen, 0.f, hlen);
+  float h[hlen];
+  for (int i = 0; i < hlen; i++) {
+    h[i] = i / (hlen - 1.0f);
+  }
+
+  float verif[xlen + hlen - 1];
+  convolve_reference(x, xlen, h, hlen, verif);
+
+  float res[xlen + hlen];
+  auto handle = convolve_stream_initialize(h, hlen, block);
+  for (int pass = 0; pass < 2; pass++) {
+    // Blocks of varying length, the last one flushes the tail
+    int offset = 0;
+    for (int i = 0; offset < xlen + hlen - 1; i++) {
+      int length = (i * 37) % block + 1;
+      if (length > xlen + hlen - 1 - offset) {
+        length = xlen + hlen - 1 - offset;
+      }
+      convolve_stream_process(handle, x + offset, length, res + offset);
+      offset += length;
+    }
+    for (int i = 0; i < xlen + hlen - 1; i++) {
+      ASSERT_NEAR(verif[i], res[i], 1e-2f) << pass << " " << i;
+    }
+    convolve_stream_reset(handle);
+  }
+  // In place, with the full blocks
+  memcpy(res, x, sizeof(res));
+  for (int offset = 0; offset < xlen; offset += block) {
+    int length = offset + block < xlen? block : xlen - offset;
+    convolve_stream_process(handle, res + offset, length, res + offset);
+  }
+  for (int i = 0; i < xlen; i++) {
+    ASSERT_NEAR(verif[i], res[i], 1e-2f) << i;
+  }
+  convolve_stream_finalize(handle);
+}
+
+TEST(convolve, convolve_with_kernel) {
+  // Brute force, overlap-save and FFT
+  const int sizes[][2] = { { 100, 10 }, { 1021, 50 }, { 1000, 700 } };
+  for (auto& size : sizes) {
+    const int xlen = size[0];
+    const int hlen = size[1];
+    float *x = mallocf(xlen), *h = mallocf(hlen);
+    float *verif = mallocf(xlen + hlen - 1), *res = mallocf(xlen + hlen - 1);
+    for (int i = 0; i < hlen; i++) {
+      h[i] = i / (hlen - 1.0f);
+    }
+    auto handle = convolve_initialize_with_kernel(xlen, h, hlen);
+    auto plain = convolve_initialize(xlen, hlen);
+    EXPECT_EQ(plain.algorithm, handle.algorithm);
+    // The kernel must not be read after the initialization
+    memsetf(h, -1.f, hlen);
+    for (int pass = 0; pass < 3; pass++) {
+      for (int i = 0; i < xlen; i++) {
+        x[i] = sinf(i * (pass + 1)) * 100;
+      }
+      for (int i = 0; i < hlen; i++) {
+        h[i] = i / (hlen - 1.0f);
+      }
+      convolve_reference(x, xlen, h, hlen, verif);
+      memsetf(h, -1.f, hlen);
+      convolve_with_kernel(handle, x, res);
+      for (int i = 0; i < xlen + hlen - 1; i++) {
+        ASSERT_NEAR(verif[i], res[i], 1e-2f) << xlen << " " << pass << " "
+                                             << i;
+      }
+      // The plain handle must give the same on every call too
+      for (int i = 0; i < hlen; i++) {
+        h[i] = i / (hlen - 1.0f);
+      }
+      convolve(plain, x, h, res);
+      for (int i = 0; i < xlen + hlen - 1; i++) {
+        ASSERT_NEAR(verif[i], res[i], 1e-2f) << xlen << " " << pass << " "
+                                             << i;
+      }
+      memsetf(h, -1.f, hlen);
+    }
+    convolve_finalize(plain);
+    convolve_finalize(handle);
+    free(x);
+    free(h);
+    free(verif);
+    free(res);
+  }
+}
+
+struct SharedKernelTask {
+  ConvolutionHandle handle;
+  ConvolutionScratch *scratches;
+  const float *x;
+  float *results;
+  int xlen;
+  int hlen;
+};
+
+static void RunSharedKernelTask(void *arg, int index) {
+  auto task = reinterpret_cast<SharedKernelTask *>(arg);
+  // Every task convolves its own shifted copy of the signal
+  convolve_with_kernel_scratch(task->handle, task->scratches[index],
+                               task->x + index,
+                               task->results +
+                                   index * (task->xlen + task->hlen - 1));
+}
+
+TEST(convolve, convolve_with_kernel_scratch) {
+  const int tasks = 4;
+  const int xlen = 1021;
+  const int hlen = 50;
+  const ConvolutionAlgorithm algorithms[] = {
+      kConvolutionAlgorithmBruteForce, kConvolutionAlgorithmFFT,
+      kConvolutionAlgorithmOverlapSave, kConvolutionAlgorithmPartitioned };
+  float *x = mallocf(xlen + tasks), *h = mallocf(hlen);
+  float *verif = mallocf((xlen + hlen - 1) * tasks);
+  float *res = mallocf((xlen + hlen - 1) * tasks);
+  for (int i = 0; i < xlen + tasks; i++) {
+    x[i] = sinf(i) * 100;
+  }
+  for (int i = 0; i < hlen; i++) {
+    h[i] = i / (hlen - 1.0f);
+  }
+  for (int i = 0; i < tasks; i++) {
+    convolve_reference(x + i, xlen, h, hlen, verif + i * (xlen + hlen - 1));
+  }
+  ThreadPool *pool = thread_pool_create(tasks);
+  ASSERT_NE(nullptr, pool);
+  for (auto algorithm : algorithms) {
+    SharedKernelTask task;
+    task.handle = convolve_initialize_algorithm_with_kernel(
+        xlen, h, hlen, algorithm);
+    ConvolutionScratch scratches[tasks];
+    for (int i = 0; i < tasks; i++) {
+      scratches[i] = convolve_scratch_initialize(task.handle);
+    }
+    task.scratches = scratches;
+    task.x = x;
+    task.results = res;
+    task.xlen = xlen;
+    task.hlen = hlen;
+    for (int pass = 0; pass < 2; pass++) {
+      memsetf(res, 0.f, (xlen + hlen - 1) * tasks);
+      thread_pool_run(pool, tasks, 0, RunSharedKernelTask, &task);
+      for (int i = 0; i < (xlen + hlen - 1) * tasks; i++) {
+        ASSERT_NEAR(verif[i], res[i], 1e-2f) << algorithm << " " << i;
+      }
+    }
+    for (int i = 0; i < tasks; i++) {
+      convolve_scratch_finalize(scratches[i]);
+    }
+    convolve_finalize(task.handle);
+  }
+  thread_pool_destroy(pool);
+  free(x);
+  free(h);
+  free(verif);
+  free(res);
+}
+
+TEST(convolve, plan_cache) {
+  const int xlen = 1021;
+  const int hlen = 50;
+  convolve_plan_cache_clear();
+  EXPECT_EQ(0, convolve_plan_cache_size());
+  convolve_plan_cache_prepare(xlen, hlen, kConvolutionAlgorithmOverlapSave,
+                              2);
+  convolve_plan_cache_prepare(xlen, hlen, kConvolutionAlgorithmBruteForce,
+                              2);
+  EXPECT_EQ(2, convolve_plan_cache_size());
+  auto first = convolve_overlap_save_initialize(xlen, hlen);
+  auto second = convolve_overlap_save_initialize(xlen, hlen);
+  EXPECT_EQ(0, convolve_plan_cache_size());
+  EXPECT_NE(first.plans, second.plans);
+  // The plans of a different length are created anew
+  auto fft = convolve_fft_initialize(xlen, hlen);
+  EXPECT_EQ(0, convolve_plan_cache_size());
+  auto plans = first.plans;
+  convolve_overlap_save_finalize(first);
+  convolve_fft_finalize(fft);
+  EXPECT_EQ(2, convolve_plan_cache_size());
+  auto third = convolve_overlap_save_initialize(xlen, hlen);
+  EXPECT_EQ(plans, third.plans);
+  EXPECT_EQ(1, convolve_plan_cache_size());
+
+  // The recycled plans must give the right results
+  float x[xlen];
+  for (int i = 0; i < xlen; i++) {
+    x[i] = sinf(i) * 100;
+  }
+  float h[hlen];
+  for (int i = 0; i < hlen; i++) {
+    h[i] = i / (hlen - 1.0f);
+  }
+  float verif[xlen + hlen - 1];
+  convolve_reference(x, xlen, h, hlen, verif);
+  float res[xlen + hlen - 1];
+  convolve_overlap_save(third, x, h, res);
+  for (int i = 0; i < xlen + hlen - 1; i++) {
+    ASSERT_NEAR(verif[i], res[i], 1e-2f) << i;
+  }
+  convolve_overlap_save_finalize(second);
+  convolve_overlap_save_finalize(third);
+  EXPECT_EQ(3, convolve_plan_cache_size());
+  convolve_plan_cache_clear();
+  EXPECT_EQ(0, convolve_plan_cache_size());
+}
+
+TEST(convolve, autotuning) {
+  const int sizes[][2] = { { 100, 10 }, { 1021, 50 }, { 1000, 700 } };
+  EXPECT_FALSE(convolve_autotuning());
+  convolve_set_autotuning(true);
+  ConvolutionAlgorithm chosen[3];
+  for (int s = 0; s < 3; s++) {
+    const int xlen = sizes[s][0];
+    const int hlen = sizes[s][1];
+    chosen[s] = convolve_select_algorithm(xlen, hlen);
+    // The decision is cached
+    EXPECT_EQ(chosen[s], convolve_select_algorithm(xlen, hlen));
+    float *x = mallocf(xlen), *h = mallocf(hlen);
+    float *verif = mallocf(xlen + hlen - 1), *res = mallocf(xlen + hlen - 1);
+    for (int i = 0; i < xlen; i++) {
+      x[i] = sinf(i) * 100;
+    }
+    for (int i = 0; i < hlen; i++) {
+      h[i] = i / (hlen - 1.0f);
+    }
+    convolve_reference(x, xlen, h, hlen, verif);
+    auto handle = convolve_initialize(xlen, hlen);
+    EXPECT_EQ(chosen[s], handle.algorithm);
+    convolve(handle, x, h, res);
+    convolve_finalize(handle);
+    for (int i = 0; i < xlen + hlen - 1; i++) {
+      ASSERT_NEAR(verif[i], res[i], 1e-2f) << xlen << " " << i;
+    }
+    free(x);
+    free(h);
+    free(verif);
+    free(res);
+  }
+  const char *path = "convolve_autotuning.txt";
+  ASSERT_EQ(0, convolve_autotuning_save(path));
+  convolve_autotuning_clear();
+  ASSERT_EQ(3, convolve_autotuning_load(path));
+  for (int s = 0; s < 3; s++) {
+    EXPECT_EQ(chosen[s], convolve_select_algorithm(sizes[s][0], sizes[s][1]));
+  }
+  remove(path);
+  EXPECT_EQ(-1, convolve_autotuning_load(path));
+  convolve_autotuning_clear();
+  convolve_set_autotuning(false);
+  EXPECT_EQ(kConvolutionAlgorithmFFT, convolve_select_algorithm(1000, 700));
+}
+
+TEST(convolve, convolve_batch) {
+  const int xlen = 500;
+  const int hlen = 37;
+  const int channels = 5;
+  const int rlen = xlen + hlen - 1;
+
+  float *x = mallocf(xlen * channels), *h = mallocf(hlen);
+  float *verif = mallocf(rlen * channels), *res = mallocf(rlen * channels);
+  for (int i = 0; i < xlen * channels; i++) {
+    x[i] = sinf(i * 0.37f) * 100;
+  }
+  for (int i = 0; i < hlen; i++) {
+    h[i] = i / (hlen - 1.0f);
+  }
+  for (int c = 0; c < channels; c++) {
+    convolve_reference(x + c * xlen, xlen, h, hlen, verif + c * rlen);
+  }
+  auto handle = convolve_batch_initialize(xlen, h, hlen, channels);
+  for (int pass = 0; pass < 2; pass++) {
+    convolve_batch_strided(handle, x, xlen, res, rlen);
+    for (int i = 0; i < rlen * channels; i++) {
+      ASSERT_NEAR(verif[i], res[i], 1e-2f) << pass << " " << i;
+    }
+  }
+  const float *inputs[channels];
+  float *outputs[channels];
+  for (int c = 0; c < channels; c++) {
+    // Reverse the order of the channels
+    inputs[c] = x + (channels - 1 - c) * xlen;
+    outputs[c] = res + c * rlen;
+  }
+  convolve_batch(handle, inputs, outputs);
+  for (int c = 0; c < channels; c++) {
+    for (int i = 0; i < rlen; i++) {
+      ASSERT_NEAR(verif[(channels - 1 - c) * rlen + i], outputs[c][i], 1e-2f)
+          << c << " " << i;
+    }
+  }
+  convolve_batch_finalize(handle);
+  free(x);
+  free(h);
+  free(verif);
+  free(res);
+}
+
+TEST(convolve, convolve_overlap_save_parallel) {
+  const int xlen = 20000;
+  const int hlen = 50;
+
+  float *x = mallocf(xlen), *h = mallocf(hlen);
+  float *verif = mallocf(xlen + hlen - 1), *res = mallocf(xlen + hlen - 1);
+  for (int i = 0; i < xlen; i++) {
+    x[i] = sinf(i) * 100;
+  }
+  for (int i = 0; i < hlen; i++) {
+    h[i] = i / (hlen - 1.0f);
+  }
+  convolve_reference(x, xlen, h, hlen, verif);
+  ThreadPool *pool = thread_pool_create(4);
+  ASSERT_NE(nullptr, pool);
+  for (int threads = 0; threads <= 4; threads++) {
+    auto handle = convolve_overlap_save_parallel_initialize(
+        xlen, hlen, threads < 4? pool : nullptr, threads);
+    memsetf(res, 0.f, xlen + hlen - 1);
+    convolve_overlap_save_parallel(handle, x, h, res);
+    convolve_overlap_save_parallel_finalize(handle);
+    for (int i = 0; i < xlen + hlen - 1; i++) {
+      ASSERT_NEAR(verif[i], res[i], 1e-2f) << threads << " " << i;
+    }
+  }
+  thread_pool_destroy(pool);
+  free(x);
+  free(h);
+  free(verif);
+  free(res);
+}
+
+TEST(convolve, convolve_partitioned) {
+  const int xlen = 12000;
+  const int hlen = 3001;
+  const int block = 128;
+  // The signal is followed by the zeros which flush the tail
+  const int total = (xlen + hlen - 1 + block - 1) / block * block;
+
+  float *x = mallocf(total), *h = mallocf(hlen);
+  float *verif = mallocf(xlen + hlen - 1), *res = mallocf(total);
+  for (int i = 0; i < xlen; i++) {
+    x[i] = sinf(i) * 10;
+  }
+  memsetf(x + xlen, 0.f, total - xlen);
+  for (int i = 0; i < hlen; i++) {
+    h[i] = cosf(i * 0.01f) / hlen;
+  }
+  convolve_reference(x, xlen, h, hlen, verif);
+
+  auto handle = convolve_partitioned_initialize(h, hlen, block);
+  for (int pass = 0; pass < 2; pass++) {
+    for (int i = 0; i < total; i += block) {
+      convolve_partitioned_process(handle, x + i, res + i);
+    }
+    for (int i = 0; i < xlen + hlen - 1; i++) {
+      ASSERT_NEAR(verif[i], res[i], 1e-3f) << pass << " " << i;
+    }
+    convolve_partitioned_reset(handle);
+  }
+  convolve_partitioned_finalize(handle);
+
+  // The whole signal through ConvolutionHandle
+  auto whole = convolve_initialize_algorithm(xlen, hlen,
+                                             kConvolutionAlgorithmPartitioned);
+  convolve(whole, x, h, res);
+  convolve_finalize(whole);
+  for (int i = 0; i < xlen + hlen - 1; i++) {
+    ASSERT_NEAR(verif[i], res[i], 1e-3f) << i;
+  }
+  free(x);
+  free(h);
+  free(verif);
+  free(res);
+}
+
+TEST(convolve, convolve_partitioned_odd_block) {
+  // 2 * block is not 2^a 3^b 5^c, the frame is rounded up
+  const int xlen = 3000;
+  for (int block : { 7, 11, 13, 101 }) {
+    for (int hlen : { 1, 5, 300 }) {
+      const int total = (xlen + hlen - 1 + block - 1) / block * block;
+      std::vector<float> x(total, 0.f), h(hlen), verif(xlen + hlen - 1);
+      std::vector<float> res(total);
+      for (int i = 0; i < xlen; i++) {
+        x[i] = sinf(i) * 10;
+      }
+      for (int i = 0; i < hlen; i++) {
+        h[i] = cosf(i * 0.01f) / hlen;
+      }
+      convolve_reference(x.data(), xlen, h.data(), hlen, verif.data());
+      auto handle = convolve_partitioned_initialize(h.data(), hlen, block);
+      for (int i = 0; i < total; i += block) {
+        convolve_partitioned_process(handle, &x[i], &res[i]);
+      }
+      convolve_partitioned_finalize(handle);
+      for (int i = 0; i < xlen + hlen - 1; i++) {
+        ASSERT_NEAR(verif[i], res[i], 1e-3f) << block << " " << hlen << " "
+                                             << i;
+      }
+    }
+  }
+}
+
 float BenchmarkH[512] = { 1.f };
 float BenchmarkResult[10000];
 
@@ -399,6 +941,4 @@ ConvolutionOverlapSaveHandle osHandle;
 #define CUSTOM_CODE_POST { convolve_overlap_save_finalize(osHandle); }
 #include "tests/benchmark.inc"
 
-#endif  // #ifndef NO_FFTF
-
 #include "tests/google/src/gtest_main.cc"
@@ -0,0 +1,218 @@
+/*! @file convolve2d.cc
+ *  @brief Tests for src/convolve2d.c.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include <simd/convolve2d.h>
+#include <simd/memory.h>
+
+/// @brief The straightforward full 2D convolution in double precision.
+static std::vector<float> convolve2D_reference(
+    const float *x, int xStride, int xw, int xh, const float *h,
+    int hw, int hh, bool correlate) {
+  int w = xw + hw - 1, ht = xh + hh - 1;
+  std::vector<float> result(w * ht);
+  for (int r = 0; r < ht; r++) {
+    for (int c = 0; c < w; c++) {
+      double sum = 0;
+      for (int i = 0; i < hh; i++) {
+        for (int j = 0; j < hw; j++) {
+          int xr = r - i, xc = c - j;
+          if (xr < 0 || xr >= xh || xc < 0 || xc >= xw) {
+            continue;
+          }
+          float hv = correlate? h[(hh - 1 - i) * hw + hw - 1 - j] :
+                                h[i * hw + j];
+          sum += hv * x[xr * xStride + xc];
+        }
+      }
+      result[r * w + c] = sum;
+    }
+  }
+  return result;
+}
+
+class Convolution2DTest : public ::testing::Test {
+ protected:
+  void Fill(int xw, int xh, int stride, int hw, int hh) {
+    xw_ = xw;
+    xh_ = xh;
+    stride_ = stride;
+    hw_ = hw;
+    hh_ = hh;
+    x_.assign(stride * xh, NAN);
+    for (int r = 0; r < xh; r++) {
+      for (int c = 0; c < xw; c++) {
+        x_[r * stride + c] = sinf(r * 0.7f + c * 0.3f) * 10 + (r ^ c) % 5;
+      }
+    }
+    h_.resize(hw * hh);
+    for (int i = 0; i < hw * hh; i++) {
+      h_[i] = cosf(i * 0.37f);
+    }
+    width_ = xw + hw - 1;
+    height_ = xh + hh - 1;
+    // The gap between the result rows must not be touched
+    resultStride_ = width_ + 3;
+    result_.assign(resultStride_ * height_, -777.f);
+  }
+
+  void Check(bool correlate, float tolerance, const char *name) {
+    auto verif = convolve2D_reference(x_.data(), stride_, xw_, xh_,
+                                      h_.data(), hw_, hh_, correlate);
+    for (int r = 0; r < height_; r++) {
+      for (int c = 0; c < width_; c++) {
+        float v = verif[r * width_ + c];
+        ASSERT_NEAR(v, result_[r * resultStride_ + c],
+                    tolerance * std::max(1.f, fabsf(v)))
+            << name << " " << xw_ << "x" << xh_ << " " << hw_ << "x" << hh_
+            << " (" << r << ", " << c << ")";
+      }
+      for (int c = width_; c < resultStride_; c++) {
+        ASSERT_EQ(-777.f, result_[r * resultStride_ + c]) << name;
+      }
+    }
+  }
+
+  int xw_, xh_, stride_, hw_, hh_, width_, height_, resultStride_;
+  std::vector<float> x_, h_, result_;
+};
+
+TEST_F(Convolution2DTest, convolve2D_simd) {
+  const int sizes[][4] = {
+      { 1, 1, 1, 1 }, { 37, 23, 3, 3 }, { 64, 40, 5, 7 }, { 13, 50, 20, 4 },
+      { 3, 4, 9, 9 }, { 100, 3, 1, 6 } };
+  for (auto& size : sizes) {
+    for (int simd = 0; simd < 2; simd++) {
+      Fill(size[0], size[1], size[0] + 5, size[2], size[3]);
+      convolve2D_simd(simd, x_.data(), stride_, xw_, xh_, h_.data(), hw_,
+                      hh_, result_.data(), resultStride_);
+      Check(false, 1e-4f, simd? "simd" : "plain");
+    }
+  }
+}
+
+TEST_F(Convolution2DTest, convolve2D) {
+  const int sizes[][4] = {
+      { 37, 23, 3, 3 }, { 120, 90, 15, 11 }, { 64, 64, 64, 64 },
+      { 200, 31, 9, 9 } };
+  const ConvolutionAlgorithm algorithms[] = {
+      kConvolutionAlgorithmBruteForce, kConvolutionAlgorithmFFT,
+      kConvolutionAlgorithmOverlapSave };
+  for (auto& size : sizes) {
+    for (auto algorithm : algorithms) {
+      int xLength = size[1] * (size[0] + size[2] - 1);
+      int hLength = (size[3] - 1) * (size[0] + size[2] - 1) + size[2];
+      if (algorithm == kConvolutionAlgorithmOverlapSave &&
+          !(hLength < xLength / 2)) {
+        continue;
+      }
+      for (int correlate = 0; correlate < 2; correlate++) {
+        Fill(size[0], size[1], size[0] + 1, size[2], size[3]);
+        auto handle = convolve2D_initialize_algorithm(
+            xw_, xh_, hw_, hh_, algorithm);
+        if (correlate) {
+          // There is no cross_correlate2D_initialize_algorithm()
+          handle.reverse = 1;
+          handle.kernel = mallocf(hw_ * hh_);
+          cross_correlate2D(handle, x_.data(), stride_, h_.data(),
+                            result_.data(), resultStride_);
+          cross_correlate2D_finalize(handle);
+        } else {
+          convolve2D(handle, x_.data(), stride_, h_.data(),
+                     result_.data(), resultStride_);
+          convolve2D_finalize(handle);
+        }
+        Check(correlate, 1e-3f, correlate? "correlate" : "convolve");
+      }
+    }
+  }
+}
+
+TEST_F(Convolution2DTest, convolve2D_initialize) {
+  EXPECT_EQ(kConvolutionAlgorithmBruteForce,
+            convolve2D_select_algorithm(1000, 1000, 5, 5));
+  EXPECT_NE(kConvolutionAlgorithmBruteForce,
+            convolve2D_select_algorithm(1000, 1000, 31, 31));
+  for (int correlate = 0; correlate < 2; correlate++) {
+    Fill(300, 200, 301, 31, 31);
+    if (correlate) {
+      auto handle = cross_correlate2D_initialize(xw_, xh_, hw_, hh_);
+      cross_correlate2D(handle, x_.data(), stride_, h_.data(),
+                        result_.data(), resultStride_);
+      cross_correlate2D_finalize(handle);
+    } else {
+      auto handle = convolve2D_initialize(xw_, xh_, hw_, hh_);
+      convolve2D(handle, x_.data(), stride_, h_.data(),
+                 result_.data(), resultStride_);
+      convolve2D_finalize(handle);
+    }
+    Check(correlate, 1e-3f, "best");
+  }
+}
+
+TEST_F(Convolution2DTest, convolve2D_separable) {
+  const int sizes[][4] = {
+      { 37, 23, 3, 3 }, { 640, 48, 31, 7 }, { 20, 300, 1, 15 } };
+  for (auto& size : sizes) {
+    for (int correlate = 0; correlate < 2; correlate++) {
+      Fill(size[0], size[1], size[0] + 2, size[2], size[3]);
+      std::vector<float> row(hw_), column(hh_);
+      for (int j = 0; j < hw_; j++) {
+        row[j] = 1 + sinf(j);
+      }
+      for (int i = 0; i < hh_; i++) {
+        column[i] = cosf(i * 0.5f);
+        for (int j = 0; j < hw_; j++) {
+          h_[i * hw_ + j] = column[i] * row[j];
+        }
+      }
+      if (correlate) {
+        auto handle = cross_correlate2D_separable_initialize(
+            xw_, xh_, hw_, hh_);
+        cross_correlate2D_separable(handle, x_.data(), stride_, row.data(),
+                                    column.data(), result_.data(),
+                                    resultStride_);
+        cross_correlate2D_separable_finalize(handle);
+      } else {
+        auto handle = convolve2D_separable_initialize(xw_, xh_, hw_, hh_);
+        convolve2D_separable(handle, x_.data(), stride_, row.data(),
+                             column.data(), result_.data(), resultStride_);
+        convolve2D_separable_finalize(handle);
+      }
+      Check(correlate, 1e-3f, correlate? "correlate" : "convolve");
+    }
+  }
+}
+
+#include "tests/google/src/gtest_main.cc"
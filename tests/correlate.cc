@@ -29,12 +29,13 @@
  */
 
 #include <gtest/gtest.h>
-#ifndef NO_FFTF
+#include <algorithm>
 #include <cmath>
+#include <vector>
+#include <simd/convolve.h>
 #include <simd/correlate.h>
 #include <simd/memory.h>
 #include <simd/arithmetic.h>
-#include <fftf/api.h>
 
 void cross_correlate_reference(const float *__restrict x, size_t xLength,
                          const float *__restrict h, size_t hLength,
@@ -127,6 +128,63 @@ TEST(correlate, cross_correlate_overlap_save) {
   }
 }
 
+TEST(correlate, cross_correlate_lags) {
+  const int xlen = 1021;
+  const int hlen = 50;
+
+  float x[xlen];
+  for (int i = 0; i < xlen; i++) {
+    x[i] = sinf(i) * 100;
+  }
+  float h[hlen];
+  for (int i = 0; i < hlen; i++) {
+    h[i] = i / (hlen - 1.0f);
+  }
+  // verif[l + hlen - 1] is the lag l
+  float verif[xlen + hlen - 1];
+  cross_correlate_reference(x, xlen, h, hlen, verif);
+
+  const int windows[][2] = {
+      { 1 - hlen, xlen - 1 }, { 0, xlen - hlen }, { -10, 10 }, { -5, -1 },
+      { 1 - hlen, 1 - hlen }, { 500, 600 }, { xlen - 30, xlen - 1 },
+      { 0, 0 } };
+  float res[xlen + hlen - 1];
+  for (auto& window : windows) {
+    auto handle = cross_correlate_lags_initialize(
+        xlen, hlen, window[0], window[1]);
+    EXPECT_LE(*handle.N, convolve_fft_good_length(xlen + hlen - 1));
+    cross_correlate_lags(handle, x, h, res);
+    cross_correlate_lags_finalize(handle);
+    for (int l = window[0]; l <= window[1]; l++) {
+      ASSERT_NEAR(verif[l + hlen - 1], res[l - window[0]], 1E-3)
+          << window[0] << " " << window[1] << " " << l;
+    }
+  }
+
+  const struct {
+    CrossCorrelationMode mode;
+    int minLag, length;
+  } modes[] = {
+      { kCrossCorrelationFull, 1 - hlen, xlen + hlen - 1 },
+      { kCrossCorrelationValid, 0, xlen - hlen + 1 },
+      { kCrossCorrelationSame, -hlen / 2, xlen } };
+  for (auto& mode : modes) {
+    auto handle = cross_correlate_mode_initialize(xlen, hlen, mode.mode);
+    EXPECT_EQ(mode.minLag, handle.min_lag);
+    EXPECT_EQ(mode.length, handle.max_lag - handle.min_lag + 1);
+    cross_correlate_lags(handle, x, h, res);
+    cross_correlate_lags_finalize(handle);
+    for (int i = 0; i < mode.length; i++) {
+      ASSERT_NEAR(verif[mode.minLag + i + hlen - 1], res[i], 1E-3)
+          << mode.mode << " " << i;
+    }
+  }
+  // The narrow window does not need the whole x
+  auto handle = cross_correlate_lags_initialize(xlen, hlen, -10, 10);
+  EXPECT_LT(*handle.N, 128);
+  cross_correlate_lags_finalize(handle);
+}
+
 TEST(correlate, cross_correlate_simd) {
   const int xlen = 1024;
   const int hlen = 50;
@@ -151,6 +209,308 @@ TEST(correlate, cross_correlate_simd) {
   }
 }
 
-#endif
+TEST(correlate, cross_correlate_simd_lengths) {
+  // The blocked kernel, the tails and the edges shorter than h
+  for (int xlen : { 1, 7, 33, 257 }) {
+    for (int hlen : { 1, 5, 40, 300 }) {
+      std::vector<float> x(xlen), h(hlen);
+      for (int i = 0; i < xlen; i++) {
+        x[i] = sinf(i) * 10;
+      }
+      for (int i = 0; i < hlen; i++) {
+        h[i] = cosf(i * 0.3f);
+      }
+      std::vector<float> res(xlen + hlen - 1);
+      cross_correlate_simd(true, x.data(), xlen, h.data(), hlen, res.data());
+      for (int k = 0; k < xlen + hlen - 1; k++) {
+        float sum = 0;
+        for (int j = 0; j < hlen; j++) {
+          int i = k - hlen + 1 + j;
+          if (i >= 0 && i < xlen) {
+            sum += h[j] * x[i];
+          }
+        }
+        ASSERT_NEAR(sum, res[k], 1e-3f * hlen)
+            << xlen << " " << hlen << " " << k;
+      }
+    }
+  }
+}
+
+TEST(correlate, cross_correlate_with_kernel) {
+  // Brute force, overlap-save and FFT
+  const int sizes[][2] = { { 100, 10 }, { 1021, 50 }, { 1000, 700 } };
+  for (auto& size : sizes) {
+    const int xlen = size[0];
+    const int hlen = size[1];
+    float *x = mallocf(xlen), *h = mallocf(hlen);
+    float *verif = mallocf(xlen + hlen - 1), *res = mallocf(xlen + hlen - 1);
+    for (int i = 0; i < hlen; i++) {
+      h[i] = i / (hlen - 1.0f);
+    }
+    auto handle = cross_correlate_initialize_with_kernel(xlen, h, hlen);
+    auto plain = cross_correlate_initialize(xlen, hlen);
+    EXPECT_EQ(plain.algorithm, handle.algorithm);
+    // The kernel must not be read after the initialization
+    memsetf(h, -1.f, hlen);
+    for (int pass = 0; pass < 3; pass++) {
+      for (int i = 0; i < xlen; i++) {
+        x[i] = sinf(i * (pass + 1)) * 100;
+      }
+      for (int i = 0; i < hlen; i++) {
+        h[i] = i / (hlen - 1.0f);
+      }
+      cross_correlate_reference(x, xlen, h, hlen, verif);
+      memsetf(h, -1.f, hlen);
+      cross_correlate_with_kernel(handle, x, res);
+      for (int i = 0; i < xlen + hlen - 1; i++) {
+        ASSERT_NEAR(verif[i], res[i], 1e-2f) << xlen << " " << pass << " "
+                                             << i;
+      }
+      // The plain handle must give the same on every call too
+      for (int i = 0; i < hlen; i++) {
+        h[i] = i / (hlen - 1.0f);
+      }
+      cross_correlate(plain, x, h, res);
+      for (int i = 0; i < xlen + hlen - 1; i++) {
+        ASSERT_NEAR(verif[i], res[i], 1e-2f) << xlen << " " << pass << " "
+                                             << i;
+      }
+      memsetf(h, -1.f, hlen);
+    }
+    cross_correlate_finalize(plain);
+    cross_correlate_finalize(handle);
+    free(x);
+    free(h);
+    free(verif);
+    free(res);
+  }
+}
+
+TEST(correlate, cross_correlate_batch) {
+  const int xlen = 500;
+  const int hlen = 37;
+  const int channels = 5;
+  const int rlen = xlen + hlen - 1;
+
+  float *x = mallocf(xlen * channels), *h = mallocf(hlen);
+  float *verif = mallocf(rlen * channels), *res = mallocf(rlen * channels);
+  for (int i = 0; i < xlen * channels; i++) {
+    x[i] = sinf(i * 0.37f) * 100;
+  }
+  for (int i = 0; i < hlen; i++) {
+    h[i] = i / (hlen - 1.0f);
+  }
+  for (int c = 0; c < channels; c++) {
+    cross_correlate_reference(x + c * xlen, xlen, h, hlen, verif + c * rlen);
+  }
+  auto handle = cross_correlate_batch_initialize(xlen, h, hlen, channels);
+  for (int pass = 0; pass < 2; pass++) {
+    cross_correlate_batch_strided(handle, x, xlen, res, rlen);
+    for (int i = 0; i < rlen * channels; i++) {
+      ASSERT_NEAR(verif[i], res[i], 1e-2f) << pass << " " << i;
+    }
+  }
+  const float *inputs[channels];
+  float *outputs[channels];
+  for (int c = 0; c < channels; c++) {
+    // Reverse the order of the channels
+    inputs[c] = x + (channels - 1 - c) * xlen;
+    outputs[c] = res + c * rlen;
+  }
+  cross_correlate_batch(handle, inputs, outputs);
+  for (int c = 0; c < channels; c++) {
+    for (int i = 0; i < rlen; i++) {
+      ASSERT_NEAR(verif[(channels - 1 - c) * rlen + i], outputs[c][i], 1e-2f)
+          << c << " " << i;
+    }
+  }
+  cross_correlate_batch_finalize(handle);
+  free(x);
+  free(h);
+  free(verif);
+  free(res);
+}
+
+TEST(correlate, cross_correlate_overlap_save_parallel) {
+  const int xlen = 20000;
+  const int hlen = 50;
+
+  float *x = mallocf(xlen), *h = mallocf(hlen);
+  float *verif = mallocf(xlen + hlen - 1), *res = mallocf(xlen + hlen - 1);
+  for (int i = 0; i < xlen; i++) {
+    x[i] = sinf(i) * 100;
+  }
+  for (int i = 0; i < hlen; i++) {
+    h[i] = i / (hlen - 1.0f);
+  }
+  cross_correlate_reference(x, xlen, h, hlen, verif);
+  ThreadPool *pool = thread_pool_create(4);
+  ASSERT_NE(nullptr, pool);
+  for (int threads = 0; threads <= 4; threads++) {
+    auto handle = cross_correlate_overlap_save_parallel_initialize(
+        xlen, hlen, threads < 4? pool : nullptr, threads);
+    memsetf(res, 0.f, xlen + hlen - 1);
+    cross_correlate_overlap_save_parallel(handle, x, h, res);
+    cross_correlate_overlap_save_parallel_finalize(handle);
+    for (int i = 0; i < xlen + hlen - 1; i++) {
+      ASSERT_NEAR(verif[i], res[i], 1e-2f) << threads << " " << i;
+    }
+  }
+  thread_pool_destroy(pool);
+  free(x);
+  free(h);
+  free(verif);
+  free(res);
+}
+
+TEST(correlate, cross_correlate_partitioned) {
+  const int xlen = 3000;
+  const int hlen = 2001;
+
+  float *x = mallocf(xlen), *h = mallocf(hlen);
+  float *verif = mallocf(xlen + hlen - 1), *res = mallocf(xlen + hlen - 1);
+  for (int i = 0; i < xlen; i++) {
+    x[i] = sinf(i) * 10;
+  }
+  for (int i = 0; i < hlen; i++) {
+    h[i] = (i % 13) / 13.f;
+  }
+  cross_correlate_reference(x, xlen, h, hlen, verif);
+  auto handle = cross_correlate_initialize_algorithm(
+      xlen, hlen, kConvolutionAlgorithmPartitioned);
+  cross_correlate(handle, x, h, res);
+  cross_correlate_finalize(handle);
+  for (int i = 0; i < xlen + hlen - 1; i++) {
+    ASSERT_NEAR(verif[i], res[i], 1e-2f) << i;
+  }
+  free(x);
+  free(h);
+  free(verif);
+  free(res);
+}
+
+TEST(correlate, normalized_cross_correlate) {
+  const int sizes[][2] = { { 100, 10 }, { 1021, 50 }, { 1000, 700 } };
+  for (auto& size : sizes) {
+    const int xlen = size[0];
+    const int hlen = size[1];
+    const int rlen = xlen - hlen + 1;
+    float *x = mallocf(xlen), *h = mallocf(hlen), *res = mallocf(rlen);
+    for (int i = 0; i < xlen; i++) {
+      x[i] = sinf(i * 0.37f) * 100 + cosf(i * 0.011f) * 30 + 5;
+    }
+    // A constant part produces zero variance windows
+    for (int i = xlen / 2; i < xlen / 2 + hlen + 5 && i < xlen; i++) {
+      x[i] = 7;
+    }
+    const int offset = xlen / 5;
+    for (int i = 0; i < hlen; i++) {
+      h[i] = x[offset + i] * 0.5f + 3;
+    }
+    auto handle = normalized_cross_correlate_initialize(xlen, h, hlen);
+    normalized_cross_correlate(handle, x, res);
+    normalized_cross_correlate_finalize(handle);
+
+    double hmean = 0;
+    for (int i = 0; i < hlen; i++) {
+      hmean += h[i];
+    }
+    hmean /= hlen;
+    for (int l = 0; l < rlen; l++) {
+      double xmean = 0;
+      for (int i = 0; i < hlen; i++) {
+        xmean += x[l + i];
+      }
+      xmean /= hlen;
+      double num = 0, xvar = 0, hvar = 0;
+      for (int i = 0; i < hlen; i++) {
+        num += (x[l + i] - xmean) * (h[i] - hmean);
+        xvar += (x[l + i] - xmean) * (x[l + i] - xmean);
+        hvar += (h[i] - hmean) * (h[i] - hmean);
+      }
+      double verif = xvar < 1e-6? 0 : num / sqrt(xvar * hvar);
+      ASSERT_NEAR(verif, res[l], 2e-3) << xlen << " " << l;
+    }
+    // The template is an affine copy of this window
+    EXPECT_NEAR(1, res[offset], 1e-4) << xlen;
+    free(x);
+    free(h);
+    free(res);
+  }
+}
+
+TEST(correlate, cross_correlate_bank) {
+  const int xlen = 1021;
+  const size_t hlens[] = { 50, 1, 173, 64, 300 };
+  const int count = sizeof(hlens) / sizeof(hlens[0]);
+  float *x = mallocf(xlen);
+  for (int i = 0; i < xlen; i++) {
+    x[i] = sinf(i * 0.21f) * 10;
+  }
+  float *h[count], *res[count];
+  for (int t = 0; t < count; t++) {
+    h[t] = mallocf(hlens[t]);
+    for (size_t i = 0; i < hlens[t]; i++) {
+      h[t][i] = cosf(i * (t + 1) * 0.13f);
+    }
+    res[t] = mallocf(xlen + hlens[t] - 1);
+  }
+  // Embed the templates, so that each one has a single strongest match
+  const int offsets[count] = { 30, 500, 140, 700, 400 };
+  for (int t = 0; t < count; t++) {
+    for (size_t i = 0; i < hlens[t]; i++) {
+      x[offsets[t] + i] += h[t][i] * 20;
+    }
+  }
+  auto handle = cross_correlate_bank_initialize(xlen, h, hlens, count);
+  cross_correlate_bank(handle, x, res);
+  float *verif = mallocf(xlen + hlens[count - 1] - 1);
+  for (int t = 0; t < count; t++) {
+    cross_correlate_reference(x, xlen, h[t], hlens[t], verif);
+    for (size_t i = 0; i < xlen + hlens[t] - 1; i++) {
+      ASSERT_NEAR(verif[i], res[t][i], std::max(1e-2f, fabsf(verif[i]) * 1e-4f))
+          << t << " " << i;
+    }
+  }
+
+  DetectPeaksFilters filters;
+  detect_peaks_filters_initialize(&filters);
+  filters.topK = 3;
+  ExtremumPoint *peaks[count];
+  size_t peaksLengths[count];
+  cross_correlate_bank_peaks(handle, x, kExtremumTypeMaximum, &filters,
+                             peaks, peaksLengths);
+  for (int t = 0; t < count; t++) {
+    cross_correlate_reference(x, xlen, h[t], hlens[t], verif);
+    ExtremumPoint *expected;
+    size_t expectedLength;
+    detect_peaks_filtered(0, verif, xlen + hlens[t] - 1, kExtremumTypeMaximum,
+                          &filters, &expected, &expectedLength);
+    ASSERT_EQ(expectedLength, peaksLengths[t]) << t;
+    for (size_t i = 0; i < expectedLength; i++) {
+      EXPECT_EQ(expected[i].position, peaks[t][i].position) << t << " " << i;
+    }
+    if (hlens[t] > 1) {
+      // The highest peak is at lag offsets[t]
+      auto best = std::max_element(
+          peaks[t], peaks[t] + peaksLengths[t],
+          [](const ExtremumPoint &a, const ExtremumPoint &b) {
+            return a.value < b.value;
+      });
+      EXPECT_EQ(offsets[t] + static_cast<int>(hlens[t]) - 1, best->position)
+          << t;
+    }
+    free(expected);
+    free(peaks[t]);
+  }
+  cross_correlate_bank_finalize(handle);
+  for (int t = 0; t < count; t++) {
+    free(h[t]);
+    free(res[t]);
+  }
+  free(x);
+  free(verif);
+}
 
 #include "tests/google/src/gtest_main.cc"
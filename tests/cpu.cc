@@ -0,0 +1,146 @@
+/*! @file cpu.cc
+ *  @brief Tests for the runtime selection of the kernels.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <simd/convolve.h>
+#include <simd/cpu.h>
+#include <simd/detect_peaks.h>
+#include <simd/matrix.h>
+#include <simd/memory.h>
+#include <simd/normalize.h>
+
+TEST(CPU, names) {
+  EXPECT_STREQ("none", simd_instruction_set_name(kInstructionSetNone));
+  EXPECT_STREQ("sse4", simd_instruction_set_name(kInstructionSetSSE4));
+  EXPECT_STREQ("avx", simd_instruction_set_name(kInstructionSetAVX));
+  EXPECT_STREQ("avx2", simd_instruction_set_name(kInstructionSetAVX2));
+  EXPECT_STREQ("avx512", simd_instruction_set_name(kInstructionSetAVX512));
+  EXPECT_STREQ("neon", simd_instruction_set_name(kInstructionSetNEON));
+  EXPECT_STREQ("aarch64", simd_instruction_set_name(kInstructionSetAArch64));
+}
+
+TEST(CPU, default_instruction_set) {
+  InstructionSet cpu = simd_cpu_instruction_set();
+  InstructionSet active = simd_instruction_set();
+  if (getenv(SIMD_INSTRUCTION_SET_ENV) == nullptr) {
+    EXPECT_EQ(active, simd_set_instruction_set(cpu));
+  }
+  EXPECT_LE(active, cpu);
+}
+
+class DispatchTest : public ::testing::TestWithParam<InstructionSet> {
+ protected:
+  virtual void SetUp() {
+    previous_ = simd_instruction_set();
+    InstructionSet isa = simd_set_instruction_set(GetParam());
+    if (isa > GetParam()) {
+      // Only the lowest built tier may be above the requested one
+      EXPECT_EQ(isa, simd_set_instruction_set(kInstructionSetNone));
+      simd_set_instruction_set(GetParam());
+    }
+    EXPECT_LE(isa, simd_cpu_instruction_set());
+    EXPECT_EQ(isa, simd_instruction_set());
+  }
+
+  virtual void TearDown() {
+    simd_set_instruction_set(previous_);
+  }
+
+ private:
+  InstructionSet previous_;
+};
+
+TEST_P(DispatchTest, convolve_simd) {
+  const int xLength = 101, hLength = 13;
+  float x[xLength], h[hLength];
+  for (int i = 0; i < xLength; i++) {
+    x[i] = sinf(i * 0.1f);
+  }
+  for (int i = 0; i < hLength; i++) {
+    h[i] = 1.f / (i + 1);
+  }
+  float verif[xLength + hLength - 1], res[xLength + hLength - 1];
+  convolve_simd(false, x, xLength, h, hLength, verif);
+  convolve_simd(true, x, xLength, h, hLength, res);
+  for (int i = 0; i < xLength + hLength - 1; i++) {
+    ASSERT_NEAR(verif[i], res[i], 1e-5f) << i;
+  }
+}
+
+TEST_P(DispatchTest, matrix_multiply) {
+  const int size = 19;
+  float m1[size * size] __attribute__ ((aligned (32)));  // NOLINT(*)
+  float m2[size * size] __attribute__ ((aligned (32)));  // NOLINT(*)
+  float verif[size * size], res[size * size];
+  for (int i = 0; i < size * size; i++) {
+    m1[i] = (i % 7) - 3;
+    m2[i] = (i % 5) * 0.5f;
+  }
+  matrix_multiply(false, m1, m2, size, size, size, size, verif);
+  matrix_multiply(true, m1, m2, size, size, size, size, res);
+  for (int i = 0; i < size * size; i++) {
+    ASSERT_FLOAT_EQ(verif[i], res[i]) << i;
+  }
+}
+
+TEST_P(DispatchTest, memory) {
+  const int length = 37;
+  float src[length], dst[length];
+  memsetf(src, 3.f, length);
+  for (int i = 0; i < length; i++) {
+    ASSERT_EQ(3.f, src[i]);
+    src[i] = i;
+  }
+  rmemcpyf(dst, src, length);
+  for (int i = 0; i < length; i++) {
+    ASSERT_EQ(length - i - 1, dst[i]);
+  }
+}
+
+TEST_P(DispatchTest, minmax1D) {
+  const int length = 1001;
+  float src[length];
+  for (int i = 0; i < length; i++) {
+    src[i] = cosf(i * 0.01f) * i;
+  }
+  float min_verif, max_verif, min, max;
+  minmax1D(false, src, length, &min_verif, &max_verif);
+  minmax1D(true, src, length, &min, &max);
+  ASSERT_EQ(min_verif, min);
+  ASSERT_EQ(max_verif, max);
+}
+
+TEST_P(DispatchTest, detect_peaks) {
+  const int length = 4000;
+  float src[length];
+  for (int i = 0; i < length; i++) {
+    src[i] = sinf(i * M_PI / 100);
+  }
+  ExtremumPoint *points;
+  size_t points_count;
+  detect_peaks(true, src, length, kExtremumTypeBoth, &points, &points_count);
+  ASSERT_EQ(40U, points_count);
+  free(points);
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+INSTANTIATE_TEST_CASE_P(DispatchTests, DispatchTest,
+                        ::testing::Values(kInstructionSetNone,
+                                          kInstructionSetSSE4,
+                                          kInstructionSetAVX,
+                                          kInstructionSetAVX2,
+                                          kInstructionSetAVX512));
+#endif
+
+#include "tests/google/src/gtest_main.cc"
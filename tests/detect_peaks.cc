@@ -30,7 +30,9 @@
 
 
 #include <simd/detect_peaks.h>
+#include <algorithm>
 #include <cmath>
+#include <vector>
 #include <gtest/gtest.h>
 
 class DetectPeaksTest : public ::testing::TestWithParam<bool> {
@@ -99,6 +101,309 @@ TEST_P(DetectPeaksTest, nasty_peaks) {
   free(points);
 }
 
+TEST_P(DetectPeaksTest, lengths) {
+  // Every length must give the same as the plain C version
+  float array[50];
+  for (int i = 0; i < 50; i++) {
+    array[i] = sinf(i * 2.3f) + (i % 7 == 3? 0 : cosf(i * 0.7f));
+  }
+  for (int length = 3; length <= 50; length++) {
+    ExtremumPoint *points, *reference;
+    size_t points_count, reference_count;
+    detect_peaks(is_simd(), array, length, kExtremumTypeBoth, &points,
+                 &points_count);
+    detect_peaks(false, array, length, kExtremumTypeBoth, &reference,
+                 &reference_count);
+    ASSERT_EQ(reference_count, points_count) << length;
+    for (size_t i = 0; i < points_count; i++) {
+      ASSERT_EQ(reference[i].position, points[i].position) << length;
+    }
+    free(points);
+    free(reference);
+  }
+}
+
+TEST_P(DetectPeaksTest, noise) {
+  // Nearly every block has extrema, with plateaus in between
+  const int length = 3001;
+  float array[length];
+  srand(7);
+  for (int i = 0; i < length; i++) {
+    array[i] = (rand() % 16) * 0.25f;
+  }
+  const ExtremumType types[] = {
+    kExtremumTypeMaximum, kExtremumTypeMinimum, kExtremumTypeBoth
+  };
+  for (int t = 0; t < 3; t++) {
+    ExtremumPoint *points, *reference;
+    size_t points_count, reference_count;
+    detect_peaks(is_simd(), array, length, types[t], &points, &points_count);
+    detect_peaks(false, array, length, types[t], &reference,
+                 &reference_count);
+    ASSERT_LT(500U, reference_count) << t;
+    ASSERT_EQ(reference_count, points_count) << t;
+    for (size_t i = 0; i < points_count; i++) {
+      ASSERT_EQ(reference[i].position, points[i].position) << t << " " << i;
+      ASSERT_EQ(reference[i].value, points[i].value) << t << " " << i;
+    }
+    free(points);
+    free(reference);
+  }
+  // Without extrema nothing is allocated
+  for (int i = 0; i < length; i++) {
+    array[i] = i;
+  }
+  ExtremumPoint *points;
+  size_t points_count;
+  detect_peaks(is_simd(), array, length, kExtremumTypeBoth, &points,
+               &points_count);
+  ASSERT_EQ(0U, points_count);
+  ASSERT_EQ(nullptr, points);
+}
+
+/// The straightforward version of detect_peaks_filtered().
+static std::vector<ExtremumPoint> filter_peaks_reference(
+    const float *data, int size, ExtremumType type,
+    const DetectPeaksFilters &filters) {
+  struct Candidate {
+    ExtremumPoint point;
+    float height;
+    float prominence;
+    bool kept;
+  };
+  std::vector<Candidate> kinds[2];
+  for (int i = 1; i < size - 1; i++) {
+    for (int k = 0; k < 2; k++) {
+      float sign = k == 0? 1 : -1;
+      float height = sign * data[i];
+      if ((type & (k == 0? kExtremumTypeMaximum : kExtremumTypeMinimum)) == 0 ||
+          !(height > sign * data[i - 1] && height > sign * data[i + 1])) {
+        continue;
+      }
+      if (k == 0? data[i] < filters.maximumThreshold :
+          data[i] > filters.minimumThreshold) {
+        continue;
+      }
+      float left = INFINITY, right = INFINITY;
+      for (int j = i - 1; j >= 0 && sign * data[j] <= height; j--) {
+        left = std::min(left, sign * data[j]);
+      }
+      for (int j = i + 1; j < size && sign * data[j] <= height; j++) {
+        right = std::min(right, sign * data[j]);
+      }
+      kinds[k].push_back({ { i, data[i] }, height,
+                           height - std::max(left, right), true });
+    }
+  }
+  std::vector<Candidate> kept;
+  for (auto &kind : kinds) {
+    std::vector<size_t> order(kind.size());
+    for (size_t i = 0; i < order.size(); i++) {
+      order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return kind[a].height > kind[b].height;
+    });
+    for (size_t i : order) {
+      if (!kind[i].kept) {
+        continue;
+      }
+      for (auto &other : kind) {
+        if (&other != &kind[i] &&
+            std::abs(other.point.position - kind[i].point.position) <
+            filters.distance) {
+          other.kept = false;
+        }
+      }
+    }
+    for (auto &cand : kind) {
+      if (cand.kept && (filters.prominence <= 0 ||
+                        cand.prominence >= filters.prominence)) {
+        kept.push_back(cand);
+      }
+    }
+  }
+  if (filters.topK > 0 && kept.size() > filters.topK) {
+    std::stable_sort(kept.begin(), kept.end(),
+                     [](const Candidate &a, const Candidate &b) {
+      if (a.prominence != b.prominence) {
+        return a.prominence > b.prominence;
+      }
+      return a.point.position < b.point.position;
+    });
+    kept.resize(filters.topK);
+  }
+  std::vector<ExtremumPoint> result;
+  for (auto &cand : kept) {
+    result.push_back(cand.point);
+  }
+  std::sort(result.begin(), result.end(),
+            [](const ExtremumPoint &a, const ExtremumPoint &b) {
+    return a.position < b.position;
+  });
+  return result;
+}
+
+TEST_P(DetectPeaksTest, filtered) {
+  // Longer than a chunk, with a slow wave to give different prominences
+  const int length = 10000;
+  std::vector<float> array(length);
+  srand(11);
+  for (int i = 0; i < length; i++) {
+    array[i] = sinf(i * 0.01f) * 4 + rand() / (RAND_MAX + 1.f);
+  }
+  DetectPeaksFilters filters;
+  detect_peaks_filters_initialize(&filters);
+  ExtremumPoint *points, *all;
+  size_t points_count, all_count;
+  detect_peaks_filtered(is_simd(), array.data(), length, kExtremumTypeBoth,
+                        &filters, &points, &points_count);
+  detect_peaks(false, array.data(), length, kExtremumTypeBoth, &all,
+               &all_count);
+  ASSERT_EQ(all_count, points_count);
+  for (size_t i = 0; i < points_count; i++) {
+    ASSERT_EQ(all[i].position, points[i].position) << i;
+  }
+  free(points);
+  free(all);
+
+  struct Case {
+    ExtremumType type;
+    float maximumThreshold, minimumThreshold;
+    int distance;
+    float prominence;
+    size_t topK;
+  };
+  const Case cases[] = {
+    { kExtremumTypeBoth, 3.5f, -3.5f, 0, 0, 0 },
+    { kExtremumTypeMaximum, -INFINITY, INFINITY, 50, 0, 0 },
+    { kExtremumTypeBoth, -INFINITY, INFINITY, 0, 0.9f, 0 },
+    { kExtremumTypeMinimum, -INFINITY, INFINITY, 0, 0, 10 },
+    { kExtremumTypeBoth, 0, 0, 20, 0.5f, 15 },
+    { kExtremumTypeBoth, -INFINITY, INFINITY, 0, 5, 0 },
+  };
+  for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+    filters.maximumThreshold = cases[c].maximumThreshold;
+    filters.minimumThreshold = cases[c].minimumThreshold;
+    filters.distance = cases[c].distance;
+    filters.prominence = cases[c].prominence;
+    filters.topK = cases[c].topK;
+    auto reference = filter_peaks_reference(array.data(), length,
+                                            cases[c].type, filters);
+    detect_peaks_filtered(is_simd(), array.data(), length, cases[c].type,
+                          &filters, &points, &points_count);
+    ASSERT_GT(all_count / 4, reference.size()) << c;
+    ASSERT_LT(0U, reference.size()) << c;
+    ASSERT_EQ(reference.size(), points_count) << c;
+    for (size_t i = 0; i < points_count; i++) {
+      ASSERT_EQ(reference[i].position, points[i].position) << c << " " << i;
+      ASSERT_EQ(reference[i].value, points[i].value) << c << " " << i;
+    }
+    free(points);
+  }
+}
+
+TEST_P(DetectPeaksTest, stream) {
+  const int length = 2000;
+  float array[length];
+  for (int i = 0; i < length; i++) {
+    array[i] = sinf(i * 0.37f) + sinf(i * 1.91f) * 0.5f;
+  }
+  array[500] = array[501];  // a plateau is not an extremum
+  ExtremumPoint *points;
+  size_t points_count;
+  detect_peaks(is_simd(), array, length, kExtremumTypeBoth, &points,
+               &points_count);
+  ASSERT_LT(100U, points_count);
+
+  ExtremumPoint ring[64];
+  ExtremumPoint found[length];
+  size_t found_count = 0;
+  DetectPeaksStream stream;
+  detect_peaks_stream_initialize(&stream, kExtremumTypeBoth, ring, 64);
+  const int blocks[] = { 1, 1, 2, 3, 5, 8, 13, 100, 1, 7, 33 };
+  int pushed = 0;
+  for (int b = 0; pushed < length; b++) {
+    int size = blocks[b % (sizeof(blocks) / sizeof(blocks[0]))];
+    if (size > length - pushed) {
+      size = length - pushed;
+    }
+    detect_peaks_stream_push(is_simd(), &stream, array + pushed, size);
+    pushed += size;
+    found_count += detect_peaks_stream_pop(&stream, found + found_count,
+                                           length - found_count);
+  }
+  EXPECT_EQ(0U, stream.lost);
+  ASSERT_EQ(points_count, found_count);
+  for (size_t i = 0; i < points_count; i++) {
+    ASSERT_EQ(points[i].position, found[i].position) << i;
+    ASSERT_EQ(points[i].value, found[i].value) << i;
+  }
+
+  // Overflow keeps the newest points
+  detect_peaks_stream_flush(&stream);
+  detect_peaks_stream_initialize(&stream, kExtremumTypeBoth, ring, 8);
+  detect_peaks_stream_push(is_simd(), &stream, array, length);
+  ASSERT_EQ(points_count - 8, stream.lost);
+  ASSERT_EQ(8U, detect_peaks_stream_pop(&stream, found, length));
+  for (int i = 0; i < 8; i++) {
+    ASSERT_EQ(points[points_count - 8 + i].position, found[i].position) << i;
+  }
+  ASSERT_EQ(0U, detect_peaks_stream_pop(&stream, found, length));
+  free(points);
+}
+
+TEST_P(DetectPeaksTest, argminmax) {
+  // Spans several chunks, the extrema repeat to check the first one wins
+  const int length = 10003;
+  std::vector<float> array(length);
+  srand(3);
+  for (int i = 0; i < length; i++) {
+    array[i] = (rand() % 1000) * 0.5f;
+  }
+  array[5000] = array[9000] = 1000;
+  array[7001] = array[7002] = -5;
+  ExtremumPoint min, max;
+  argminmax1D(is_simd(), array.data(), length, &min, &max);
+  EXPECT_EQ(7001, min.position);
+  EXPECT_FLOAT_EQ(-5, min.value);
+  EXPECT_EQ(5000, max.position);
+  EXPECT_FLOAT_EQ(1000, max.value);
+  argminmax1D(is_simd(), array.data(), 5, nullptr, &max);
+  int ref = std::max_element(array.begin(), array.begin() + 5) -
+      array.begin();
+  EXPECT_EQ(ref, max.position);
+}
+
+TEST_P(DetectPeaksTest, topk) {
+  const int length = 3001;
+  std::vector<float> array(length);
+  srand(11);
+  for (int i = 0; i < length; i++) {
+    array[i] = (rand() % 500) * 0.25f;
+  }
+  for (size_t k : {1, 7, 100, 3001, 4000}) {
+    for (auto type : {kExtremumTypeMaximum, kExtremumTypeMinimum}) {
+      std::vector<ExtremumPoint> results(k), reference(length);
+      size_t count = topk1D(is_simd(), array.data(), length, type, k,
+                            results.data());
+      ASSERT_EQ(std::min<size_t>(k, length), count);
+      float sign = type == kExtremumTypeMaximum? 1 : -1;
+      for (int i = 0; i < length; i++) {
+        reference[i] = { i, array[i] };
+      }
+      std::stable_sort(reference.begin(), reference.end(),
+                       [sign](const ExtremumPoint &a, const ExtremumPoint &b) {
+        return sign * a.value > sign * b.value;
+      });
+      for (size_t i = 0; i < count; i++) {
+        ASSERT_EQ(reference[i].position, results[i].position) << k << " " << i;
+        ASSERT_EQ(reference[i].value, results[i].value) << k << " " << i;
+      }
+    }
+  }
+}
+
 INSTANTIATE_TEST_CASE_P(DetectPeaksTests, DetectPeaksTest, ::testing::Bool());
 
 #include "tests/google/src/gtest_main.cc"
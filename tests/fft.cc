@@ -0,0 +1,210 @@
+/*! @file fft.cc
+ *  @brief Tests for the planned FFT and the built-in implementation.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include <simd/fft.h>
+
+/// @brief The naive DFT of the interleaved complex numbers in double
+/// precision.
+static std::vector<double> dft_reference(const std::vector<float>& x,
+                                         int sign) {
+  size_t n = x.size() / 2;
+  std::vector<double> result(2 * n);
+  for (size_t k = 0; k < n; k++) {
+    double re = 0, im = 0;
+    for (size_t j = 0; j < n; j++) {
+      double angle = sign * 2 * M_PI * ((k * j) % n) / n;
+      re += x[2 * j] * cos(angle) - x[2 * j + 1] * sin(angle);
+      im += x[2 * j] * sin(angle) + x[2 * j + 1] * cos(angle);
+    }
+    result[2 * k] = re;
+    result[2 * k + 1] = im;
+  }
+  return result;
+}
+
+static std::vector<float> test_signal(size_t length) {
+  std::vector<float> x(length);
+  for (size_t i = 0; i < length; i++) {
+    x[i] = sinf(i * 0.37f) + 0.5f * cosf(i * 1.91f + 0.2f);
+  }
+  return x;
+}
+
+static const int kComplexLengths[] = {
+    1, 2, 3, 4, 5, 6, 8, 9, 12, 15, 16, 20, 25, 30, 32, 48, 60, 64, 75, 100,
+    120, 128, 240, 256, 1000, 1024, 1536 };
+
+TEST(fft, builtin_complex) {
+  for (int n : kComplexLengths) {
+    auto x = test_signal(2 * n);
+    for (int sign : { -1, 1 }) {
+      auto direction = sign < 0? kFFTDirectionForward : kFFTDirectionBackward;
+      auto reference = dft_reference(x, sign);
+      std::vector<float> result(2 * n);
+      auto plan = fft_initialize(kFFTTypeComplex, direction, n, x.data(),
+                                 result.data(), kFFTFlagBuiltin);
+      ASSERT_NE(nullptr, plan) << n;
+      EXPECT_TRUE(fft_is_builtin(plan));
+      fft_execute(plan);
+      fft_finalize(plan);
+      float tolerance = 1e-5f * n * logf(n + 1) + 1e-4f;
+      for (int i = 0; i < 2 * n; i++) {
+        ASSERT_NEAR(reference[i], result[i], tolerance) << n << " " << i;
+      }
+      // In place, all the passes must land in the input
+      auto inplace = x;
+      plan = fft_initialize(kFFTTypeComplex, direction, n, inplace.data(),
+                            inplace.data(), kFFTFlagBuiltin);
+      fft_execute(plan);
+      fft_finalize(plan);
+      for (int i = 0; i < 2 * n; i++) {
+        ASSERT_EQ(result[i], inplace[i]) << n << " " << i;
+      }
+    }
+  }
+}
+
+TEST(fft, builtin_real) {
+  const int lengths[] = { 2, 4, 6, 8, 10, 16, 18, 30, 50, 64, 96, 100, 240,
+                          512, 1000, 2048 };
+  for (int n : lengths) {
+    auto x = test_signal(n);
+    std::vector<float> complex(2 * n, 0.f);
+    for (int i = 0; i < n; i++) {
+      complex[2 * i] = x[i];
+    }
+    auto reference = dft_reference(complex, -1);
+    std::vector<float> spectrum(n + 2);
+    auto plan = fft_initialize(kFFTTypeReal, kFFTDirectionForward, n,
+                               x.data(), spectrum.data(), kFFTFlagBuiltin);
+    ASSERT_NE(nullptr, plan) << n;
+    fft_execute(plan);
+    fft_finalize(plan);
+    float tolerance = 1e-5f * n * logf(n + 1) + 1e-4f;
+    for (int i = 0; i < n + 2; i++) {
+      ASSERT_NEAR(reference[i], spectrum[i], tolerance) << n << " " << i;
+    }
+
+    std::vector<float> restored(n + 2);
+    plan = fft_initialize(kFFTTypeReal, kFFTDirectionBackward, n,
+                          spectrum.data(), restored.data(), kFFTFlagBuiltin);
+    ASSERT_NE(nullptr, plan) << n;
+    fft_execute(plan);
+    fft_finalize(plan);
+    for (int i = 0; i < n; i++) {
+      ASSERT_NEAR(x[i], restored[i] / n, 1e-4f) << n << " " << i;
+    }
+  }
+}
+
+TEST(fft, builtin_unsupported) {
+  float buffer[30];
+  EXPECT_EQ(nullptr, fft_initialize(kFFTTypeComplex, kFFTDirectionForward,
+                                    7, buffer, buffer, kFFTFlagBuiltin));
+  EXPECT_EQ(nullptr, fft_initialize(kFFTTypeReal, kFFTDirectionForward,
+                                    15, buffer, buffer, kFFTFlagBuiltin));
+  EXPECT_EQ(nullptr, fft_initialize(kFFTTypeReal, kFFTDirectionForward,
+                                    14, buffer, buffer, kFFTFlagBuiltin));
+}
+
+TEST(fft, default_matches_builtin) {
+  for (int n : { 64, 256, 4096 }) {
+    auto x = test_signal(n);
+    std::vector<float> builtin(n + 2), spectrum(n + 2);
+    auto plan = fft_initialize(kFFTTypeReal, kFFTDirectionForward, n,
+                               x.data(), spectrum.data(), 0);
+    ASSERT_NE(nullptr, plan);
+    fft_execute(plan);
+    fft_finalize(plan);
+    plan = fft_initialize(kFFTTypeReal, kFFTDirectionForward, n, x.data(),
+                          builtin.data(), kFFTFlagBuiltin);
+    fft_execute(plan);
+    fft_finalize(plan);
+    for (int i = 0; i < n + 2; i++) {
+      ASSERT_NEAR(spectrum[i], builtin[i], 1e-3f) << n << " " << i;
+    }
+  }
+}
+
+TEST(fft, batch) {
+  const int n = 120, batch = 5;
+  std::vector<std::vector<float>> inputs, outputs;
+  std::vector<const float *> inputPtrs;
+  std::vector<float *> outputPtrs;
+  for (int b = 0; b < batch; b++) {
+    inputs.push_back(test_signal(n + b));
+    inputs.back().erase(inputs.back().begin(), inputs.back().begin() + b);
+    outputs.emplace_back(n + 2);
+  }
+  for (int b = 0; b < batch; b++) {
+    inputPtrs.push_back(inputs[b].data());
+    outputPtrs.push_back(outputs[b].data());
+  }
+  for (int flags : { 0, kFFTFlagBuiltin }) {
+    auto plan = fft_initialize_batch(kFFTTypeReal, kFFTDirectionForward, n,
+                                     batch, inputPtrs.data(),
+                                     outputPtrs.data(), flags);
+    ASSERT_NE(nullptr, plan);
+    fft_execute(plan);
+    fft_finalize(plan);
+    for (int b = 0; b < batch; b++) {
+      std::vector<float> single(n + 2);
+      plan = fft_initialize(kFFTTypeReal, kFFTDirectionForward, n,
+                            inputs[b].data(), single.data(), kFFTFlagBuiltin);
+      fft_execute(plan);
+      fft_finalize(plan);
+      for (int i = 0; i < n + 2; i++) {
+        ASSERT_NEAR(single[i], outputs[b][i], 1e-3f) << b << " " << i;
+      }
+    }
+  }
+}
+
+TEST(fft, power_spectrum) {
+  for (size_t length : { 1, 7, 8, 9, 33, 257 }) {
+    auto spectrum = test_signal(2 * length);
+    std::vector<float> result(length);
+    fft_power_spectrum(1, spectrum.data(), length, result.data());
+    for (size_t i = 0; i < length; i++) {
+      float re = spectrum[2 * i], im = spectrum[2 * i + 1];
+      ASSERT_NEAR(re * re + im * im, result[i], 1e-5f) << i;
+    }
+    fft_power_spectrum(1, spectrum.data(), length, spectrum.data());
+    for (size_t i = 0; i < length; i++) {
+      ASSERT_EQ(result[i], spectrum[i]) << i;
+    }
+  }
+}
+
+#include "tests/google/src/gtest_main.cc"
@@ -0,0 +1,93 @@
+/*! @file fixed.cc
+ *  @brief Tests for the kernels specialized for the fixed sizes.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ */
+
+#include <cmath>
+#include <vector>
+#include <gtest/gtest.h>
+#include <simd/convolve.h>
+#include <simd/fixed.h>
+#include <simd/matrix.h>
+
+namespace {
+
+std::vector<float> Signal(size_t length) {
+  std::vector<float> signal(length);
+  for (size_t i = 0; i < length; i++) {
+    signal[i] = sinf(i * 0.3f) + (i % 5) * 0.25f;
+  }
+  return signal;
+}
+
+template <size_t XLength, size_t HLength>
+void TestConvolve() {
+  auto x = Signal(XLength), h = Signal(HLength);
+  std::vector<float> expected(XLength + HLength - 1);
+  std::vector<float> result(expected.size());
+  convolve_simd(false, x.data(), XLength, h.data(), HLength, expected.data());
+  simd::convolve<XLength, HLength>(x.data(), h.data(), result.data());
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_NEAR(expected[i], result[i], 1e-4f) << i;
+  }
+}
+
+template <WaveletType Type, int Order, ExtensionType Ext, size_t Length>
+void TestWavelet() {
+  auto src = Signal(Length);
+  std::vector<float> hi(Length / 2), lo(Length / 2);
+  std::vector<float> fixedhi(Length / 2), fixedlo(Length / 2);
+  wavelet_apply_na(Type, Order, Ext, src.data(), Length, hi.data(),
+                   lo.data());
+  simd::Wavelet<Type, Order, Ext> wavelet;
+  wavelet.template apply<Length>(src.data(), fixedhi.data(), fixedlo.data());
+  for (size_t i = 0; i < Length / 2; i++) {
+    ASSERT_NEAR(hi[i], fixedhi[i], 1e-5f) << i;
+    ASSERT_NEAR(lo[i], fixedlo[i], 1e-5f) << i;
+  }
+}
+
+}  // namespace
+
+TEST(Fixed, Convolve) {
+  TestConvolve<64, 8>();
+  TestConvolve<1000, 3>();
+  TestConvolve<16, 16>();
+  TestConvolve<5, 1>();
+}
+
+TEST(Fixed, MatrixMultiply) {
+  auto m1 = Signal(16 * 16), m2 = Signal(16 * 16);
+  std::vector<float> expected(16 * 16), result(16 * 16);
+  matrix_multiply(false, m1.data(), m2.data(), 16, 16, 16, 16,
+                  expected.data());
+  simd::matrix_multiply<16, 16, 16>(m1.data(), m2.data(), result.data());
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_NEAR(expected[i], result[i], 1e-4f) << i;
+  }
+
+  auto a = Signal(3 * 5), b = Signal(7 * 3);
+  std::vector<float> expected2(7 * 5), result2(7 * 5);
+  matrix_multiply(false, a.data(), b.data(), 3, 5, 7, 3, expected2.data());
+  simd::matrix_multiply<3, 5, 7>(a.data(), b.data(), result2.data());
+  for (size_t i = 0; i < expected2.size(); i++) {
+    ASSERT_NEAR(expected2[i], result2[i], 1e-5f) << i;
+  }
+}
+
+TEST(Fixed, Wavelet) {
+  TestWavelet<WAVELET_TYPE_DAUBECHIES, 8, EXTENSION_TYPE_PERIODIC, 64>();
+  TestWavelet<WAVELET_TYPE_DAUBECHIES, 4, EXTENSION_TYPE_MIRROR, 32>();
+  TestWavelet<WAVELET_TYPE_COIFLET, 12, EXTENSION_TYPE_CONSTANT, 64>();
+  TestWavelet<WAVELET_TYPE_SYMLET, 16, EXTENSION_TYPE_ZERO, 128>();
+  TestWavelet<WAVELET_TYPE_DAUBECHIES, 8, EXTENSION_TYPE_PERIODIC, 8>();
+}
+
+#include "tests/google/src/gtest_main.cc"
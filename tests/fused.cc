@@ -0,0 +1,96 @@
+/*! @file fused.cc
+ *  @brief Fused element-wise operations unit tests.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ */
+
+#include <cmath>
+#include <vector>
+#include <gtest/gtest.h>
+#include <simd/arithmetic.h>
+#include <simd/fused.h>
+#include <simd/mathfun.h>
+
+namespace {
+
+std::vector<float> Ramp(size_t length, float step, float offset) {
+  std::vector<float> data(length);
+  for (size_t i = 0; i < length; i++) {
+    data[i] = offset + (i % 1000) * step;
+  }
+  return data;
+}
+
+}  // namespace
+
+TEST(Fused, Affine) {
+  const size_t length = FUSED_BLOCK_LENGTH * 2 + 13;
+  auto x = Ramp(length, 0.01f, -5);
+  std::vector<float> y(length);
+  const FusedOp ops[] = {
+    { kFusedOpMultiplyScalar, 0.5f, nullptr },
+    { kFusedOpAddScalar, 3.f, nullptr }
+  };
+  fused_apply(x.data(), length, ops, 2, y.data());
+  for (size_t i = 0; i < length; i++) {
+    ASSERT_EQ(x[i] * 0.5f + 3.f, y[i]) << "i = " << i;
+  }
+}
+
+TEST(Fused, ExpScale) {
+  const size_t length = FUSED_BLOCK_LENGTH + 101;
+  auto x = Ramp(length, 0.013f, -6);
+  std::vector<float> y(length), verif(length);
+  const FusedOp ops[] = {
+    { kFusedOpExp, 0.f, nullptr },
+    { kFusedOpMultiplyScalar, 0.25f, nullptr },
+    { kFusedOpMaxScalar, 0.01f, nullptr },
+    { kFusedOpMinScalar, 10.f, nullptr }
+  };
+  fused_apply(x.data(), length, ops, 4, y.data());
+  exp_psv(true, x.data(), length, verif.data());
+  for (size_t i = 0; i < length; i++) {
+    float v = std::fmax(verif[i] * 0.25f, 0.01f);
+    ASSERT_FLOAT_EQ(std::fmin(v, 10.f), y[i]) << "i = " << i;
+  }
+}
+
+TEST(Fused, Arrays) {
+  const size_t length = FUSED_BLOCK_LENGTH * 3 + 18;
+  auto x = Ramp(length, 0.003f, -1);
+  auto a = Ramp(length, -0.002f, 0.7f);
+  auto b = Ramp(length, 0.001f, 0.1f);
+  std::vector<float> y(x), verif(length);
+  const FusedOp ops[] = {
+    { kFusedOpComplexMultiplyArray, 0.f, a.data() },
+    { kFusedOpMultiplyArrayAddScalar, -1.f, b.data() },
+    { kFusedOpAddArray, 0.f, a.data() },
+    { kFusedOpMultiplyArray, 0.f, b.data() },
+    { kFusedOpTanh, 0.f, nullptr }
+  };
+  // in place
+  fused_apply(y.data(), length, ops, 5, y.data());
+  complex_multiply_array(x.data(), a.data(), length, verif.data());
+  for (size_t i = 0; i < length; i++) {
+    verif[i] = (verif[i] * b[i] - 1.f + a[i]) * b[i];
+  }
+  tanh_psv(true, verif.data(), length, verif.data());
+  for (size_t i = 0; i < length; i++) {
+    ASSERT_NEAR(verif[i], y[i], 1e-6) << "i = " << i;
+  }
+}
+
+TEST(Fused, Copy) {
+  auto x = Ramp(77, 0.1f, 0);
+  std::vector<float> y(x.size());
+  fused_apply(x.data(), x.size(), nullptr, 0, y.data());
+  ASSERT_EQ(x, y);
+}
+
+#include "tests/google/src/gtest_main.cc"
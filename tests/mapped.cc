@@ -0,0 +1,165 @@
+/*! @file mapped.cc
+ *  @brief Tests for the out-of-core processing of the mapped signals.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include <simd/convolve.h>
+#include <simd/mapped.h>
+#include <simd/wavelet.h>
+
+namespace {
+
+class Mapped : public ::testing::Test {
+ protected:
+  virtual void TearDown() override {
+    for (auto &path : paths_) {
+      unlink(path.c_str());
+    }
+  }
+
+  std::string TemporaryPath() {
+    char path[] = "/tmp/simd_mapped_XXXXXX";
+    int fd = mkstemp(path);
+    EXPECT_GE(fd, 0);
+    close(fd);
+    paths_.push_back(path);
+    return path;
+  }
+
+  /// Writes the signal to a new file and maps it
+  MappedSignal Write(const std::vector<float> &signal) {
+    auto path = TemporaryPath();
+    FILE *file = fopen(path.c_str(), "wb");
+    EXPECT_NE(nullptr, file);
+    fwrite(signal.data(), sizeof(float), signal.size(), file);
+    fclose(file);
+    MappedSignal mapped;
+    EXPECT_EQ(0, mapped_signal_open(path.c_str(), false, &mapped));
+    EXPECT_EQ(signal.size(), mapped.length);
+    return mapped;
+  }
+
+  MappedSignal Create(size_t length) {
+    MappedSignal mapped;
+    EXPECT_EQ(0, mapped_signal_create(TemporaryPath().c_str(), length,
+                                      &mapped));
+    EXPECT_EQ(length, mapped.length);
+    EXPECT_TRUE(mapped.writable);
+    return mapped;
+  }
+
+  static std::vector<float> Signal(size_t length) {
+    std::vector<float> signal(length);
+    for (size_t i = 0; i < length; i++) {
+      signal[i] = sinf(i * 0.05f) * 10 + (i % 13) * 0.3f;
+    }
+    return signal;
+  }
+
+ private:
+  std::vector<std::string> paths_;
+};
+
+}  // namespace
+
+TEST_F(Mapped, OpenErrors) {
+  MappedSignal mapped;
+  EXPECT_EQ(-1, mapped_signal_open("/nonexistent/signal", false, &mapped));
+  auto empty = Write({});
+  EXPECT_EQ(nullptr, empty.data);
+  EXPECT_EQ(0u, empty.length);
+  mapped_signal_close(&empty);
+}
+
+TEST_F(Mapped, Convolve) {
+  const size_t xLength = 100000;
+  auto x = Signal(xLength);
+  for (size_t hLength : { 1u, 50u, 3000u }) {
+    auto h = Signal(hLength);
+    std::vector<float> expected(xLength + hLength - 1);
+    auto handle = convolve_initialize(xLength, hLength);
+    convolve(handle, x.data(), h.data(), expected.data());
+    convolve_finalize(handle);
+
+    auto mx = Write(x);
+    auto result = Create(xLength + hLength - 1);
+    convolve_mapped(&mx, h.data(), hLength, &result, 4096);
+    // The FFT rounding error is relative to the magnitude of the signal
+    float scale = 0;
+    for (float value : expected) {
+      scale = std::max(scale, fabsf(value));
+    }
+    for (size_t i = 0; i < expected.size(); i++) {
+      ASSERT_NEAR(expected[i], result.data[i], scale * 1e-5f)
+          << hLength << " " << i;
+    }
+    mapped_signal_close(&result);
+    mapped_signal_close(&mx);
+  }
+}
+
+TEST_F(Mapped, Wavelet) {
+  const size_t length = 20000;
+  auto src = Signal(length);
+  for (auto ext : { EXTENSION_TYPE_PERIODIC, EXTENSION_TYPE_MIRROR,
+                    EXTENSION_TYPE_CONSTANT, EXTENSION_TYPE_ZERO }) {
+    for (int order : { 2, 8, 16 }) {
+      std::vector<float> hi(length / 2), lo(length / 2);
+      wavelet_apply_na(WAVELET_TYPE_DAUBECHIES, order, ext, src.data(),
+                       length, hi.data(), lo.data());
+      auto msrc = Write(src);
+      auto mhi = Create(length / 2), mlo = Create(length / 2);
+      // An odd chunk length is rounded up
+      wavelet_apply_mapped(WAVELET_TYPE_DAUBECHIES, order, ext, &msrc, &mhi,
+                           &mlo, 999);
+      for (size_t i = 0; i < length / 2; i++) {
+        ASSERT_NEAR(hi[i], mhi.data[i], 1e-4f) << ext << " " << order
+                                               << " " << i;
+        ASSERT_NEAR(lo[i], mlo.data[i], 1e-4f) << ext << " " << order
+                                               << " " << i;
+      }
+      mapped_signal_close(&mlo);
+      mapped_signal_close(&mhi);
+      mapped_signal_close(&msrc);
+    }
+  }
+}
+
+TEST_F(Mapped, DetectPeaks) {
+  auto data = Signal(50000);
+  ExtremumPoint *expected;
+  size_t expectedLength;
+  detect_peaks(true, data.data(), data.size(), kExtremumTypeBoth, &expected,
+               &expectedLength);
+  auto mapped = Write(data);
+  ExtremumPoint *results;
+  size_t resultsLength;
+  // The small chunks put many extrema at the borders
+  detect_peaks_mapped(true, &mapped, kExtremumTypeBoth, 37, &results,
+                      &resultsLength);
+  ASSERT_EQ(expectedLength, resultsLength);
+  for (size_t i = 0; i < resultsLength; i++) {
+    ASSERT_EQ(expected[i].position, results[i].position) << i;
+    ASSERT_EQ(expected[i].value, results[i].value) << i;
+  }
+  free(results);
+  free(expected);
+  mapped_signal_close(&mapped);
+}
+
+#include "tests/google/src/gtest_main.cc"
@@ -30,6 +30,7 @@
 
 #define GTEST_HAS_TR1_TUPLE 1
 #include <tuple>
+#include <algorithm>
 #include <cmath>
 #include <memory>
 #include <functional>
@@ -41,6 +42,10 @@
 typedef std::function<void(int, const float *, size_t, float *)> TestedFunc;
 typedef std::function<float(float)> ReferenceFunc;
 
+static double sigmoid(double x) {
+  return 1 / (1 + std::exp(-x));
+}
+
 class MathTest : public ::testing::TestWithParam<
   std::tuple<bool, size_t, std::tuple<TestedFunc, ReferenceFunc>>> {
  protected:
@@ -78,10 +83,110 @@ INSTANTIATE_TEST_CASE_P(
         ::testing::Bool(),
         ::testing::Values(1, 3, 64, 199),
         ::testing::Values(
-            std::make_tuple(sin_psv, sin),
-            std::make_tuple(cos_psv, cos),
-            std::make_tuple(log_psv, log),
-            std::make_tuple(exp_psv, exp))));
+            std::make_tuple(sin_psv, static_cast<double(*)(double)>(sin)),
+            std::make_tuple(cos_psv, static_cast<double(*)(double)>(cos)),
+            std::make_tuple(log_psv, static_cast<double(*)(double)>(log)),
+            std::make_tuple(exp_psv, static_cast<double(*)(double)>(exp)),
+            std::make_tuple(tanh_psv, static_cast<double(*)(double)>(tanh)),
+            std::make_tuple(sigmoid_psv, sigmoid))));
+
+TEST(Math, pow_psv) {
+  const size_t length = 203;
+  std::unique_ptr<float[], void(*)(void*)> data(mallocf(length), std::free);
+  std::unique_ptr<float[], void(*)(void*)> res(mallocf(length), std::free);
+  for (size_t i = 0; i < length; ++i) {
+    data[i] = 0.01f + i * 0.1f;
+  }
+  for (float power : { 2.5f, 0.3f, -1.f }) {
+    for (int simd = 0; simd < 2; simd++) {
+      pow_psv(simd, data.get(), length, power, res.get());
+      for (size_t i = 0; i < length; ++i) {
+        float reference = std::pow(data[i], power);
+        ASSERT_NEAR(reference, res[i], std::fabs(reference) * 2e-6)
+            << "power = " << power << ", i = " << i;
+      }
+    }
+  }
+}
+
+TEST(Math, sincos_psv) {
+  const size_t length = 203;
+  std::unique_ptr<float[], void(*)(void*)> data(mallocf(length), std::free);
+  std::unique_ptr<float[], void(*)(void*)> s(mallocf(length), std::free);
+  std::unique_ptr<float[], void(*)(void*)> c(mallocf(length), std::free);
+  std::unique_ptr<float[], void(*)(void*)> verif(mallocf(length), std::free);
+  for (size_t i = 0; i < length; ++i) {
+    data[i] = (float(i) - 100) * 0.37f;
+  }
+  sincos_psv(true, data.get(), length, s.get(), c.get());
+  sin_psv(true, data.get(), length, verif.get());
+  for (size_t i = 0; i < length; ++i) {
+    ASSERT_FLOAT_EQ(verif[i], s[i]) << "i = " << i;
+    ASSERT_NEAR(std::sin(data[i]), s[i], 1e-7) << "i = " << i;
+  }
+  cos_psv(true, data.get(), length, verif.get());
+  for (size_t i = 0; i < length; ++i) {
+    ASSERT_FLOAT_EQ(verif[i], c[i]) << "i = " << i;
+    ASSERT_NEAR(std::cos(data[i]), c[i], 1e-7) << "i = " << i;
+  }
+}
+
+TEST(Math, fast_psv) {
+  const size_t length = 203;
+  std::unique_ptr<float[], void(*)(void*)> data(mallocf(length), std::free);
+  std::unique_ptr<float[], void(*)(void*)> res(mallocf(length), std::free);
+  for (size_t i = 0; i < length; ++i) {
+    data[i] = 0.013f + i * 0.061f;
+  }
+  const std::tuple<TestedFunc, ReferenceFunc> funcs[] = {
+    std::make_tuple(sin_psv_fast, static_cast<double(*)(double)>(sin)),
+    std::make_tuple(cos_psv_fast, static_cast<double(*)(double)>(cos)),
+    std::make_tuple(log_psv_fast, static_cast<double(*)(double)>(log)),
+    std::make_tuple(exp_psv_fast, static_cast<double(*)(double)>(exp)),
+    std::make_tuple(tanh_psv_fast, static_cast<double(*)(double)>(tanh)),
+    std::make_tuple(sigmoid_psv_fast, sigmoid)
+  };
+  for (auto& func : funcs) {
+    for (int simd = 0; simd < 2; simd++) {
+      std::get<0>(func)(simd, data.get(), length, res.get());
+      for (size_t i = 0; i < length; ++i) {
+        float reference = std::get<1>(func)(data[i]);
+        ASSERT_NEAR(reference, res[i],
+                    std::max(std::fabs(reference) * 2e-4f, 2e-6f))
+            << "i = " << i;
+      }
+    }
+  }
+  pow_psv_fast(true, data.get(), length, 2.5f, res.get());
+  for (size_t i = 0; i < length; ++i) {
+    float reference = std::pow(data[i], 2.5f);
+    ASSERT_NEAR(reference, res[i], std::fabs(reference) * 2e-4) << "i = " << i;
+  }
+}
+
+TEST(Math, accuracy) {
+  const size_t length = 203;
+  std::unique_ptr<float[], void(*)(void*)> data(mallocf(length), std::free);
+  std::unique_ptr<float[], void(*)(void*)> res(mallocf(length), std::free);
+  std::unique_ptr<float[], void(*)(void*)> verif(mallocf(length), std::free);
+  for (size_t i = 0; i < length; ++i) {
+    data[i] = (float(i) - 100) * 0.37f;
+  }
+  ASSERT_EQ(kMathAccuracyFull, mathfun_accuracy());
+  mathfun_set_accuracy(kMathAccuracyFast);
+  ASSERT_EQ(kMathAccuracyFast, mathfun_accuracy());
+  exp_psv(true, data.get(), length, res.get());
+  exp_psv_fast(true, data.get(), length, verif.get());
+  mathfun_set_accuracy(kMathAccuracyFull);
+  for (size_t i = 0; i < length; ++i) {
+    ASSERT_EQ(verif[i], res[i]) << "i = " << i;
+  }
+  exp_psv(true, data.get(), length, res.get());
+  exp_psv_novec(data.get(), length, verif.get());
+  for (size_t i = 0; i < length; ++i) {
+    ASSERT_FLOAT_EQ(verif[i], res[i]) << "i = " << i;
+  }
+}
 
 #include "tests/google/src/gtest_main.cc"
 
@@ -28,6 +28,8 @@
  *  under the License.
  */
 
+#include <cmath>
+#include <cstring>
 #include <simd/memory.h>
 #include <simd/matrix.h>
 #include "tests/matrix.h"
@@ -156,6 +158,516 @@ TEST(MultiplyTransposed, Validate) {
   }
 }
 
+TEST(MultiplyAccumulate, Validate) {
+  float m1[6] = { 1, 2, 3,
+                 -2, 0, 4 };
+  float m2[12] = { 0, 1, 3, -2,
+                   5, -1, 2, 4,
+                  -3, 0, -4, 2 };
+  float m2t[12] = { 0, 5, -3,
+                    1,-1,  0,
+                    3, 2, -4,
+                   -2, 4,  2 };
+  float res_valid[8] = { 1, -1, -5, 12,
+                       -12, -2,-22, 12 };
+  for (int simd = 0; simd < 2; simd++) {
+    float res[8], rest[8];
+    for (int i = 0; i < 8; i++) {
+      res[i] = rest[i] = i;
+    }
+    matrix_multiply_accumulate(simd, m1, m2, 3, 2, 4, 3, 2, -0.5f, res);
+    matrix_multiply_transposed_accumulate(simd, m1, m2t, 3, 2, 3, 4,
+                                          2, -0.5f, rest);
+    for (int i = 0; i < 8; i++) {
+      ASSERT_NEAR(res[i], 2 * res_valid[i] - 0.5f * i, 0.01) << simd;
+      ASSERT_NEAR(rest[i], 2 * res_valid[i] - 0.5f * i, 0.01) << simd;
+    }
+    // beta == 0 must not read the destination
+    for (int i = 0; i < 8; i++) {
+      res[i] = NAN;
+    }
+    matrix_multiply_accumulate(simd, m1, m2, 3, 2, 4, 3, 1, 0, res);
+    for (int i = 0; i < 8; i++) {
+      ASSERT_NEAR(res[i], res_valid[i], 0.01) << simd;
+    }
+  }
+}
+
+TEST(MultiplyAccumulate, Blocks) {
+  // Crosses the K and M cache blocks and the register block borders
+  const int w1 = 300, h1 = 151, w2 = 43;
+  float *m1 = mallocf(w1 * h1), *m2 = mallocf(w2 * w1);
+  float *res = mallocf(w2 * h1), *res_base = mallocf(w2 * h1);
+  for (int i = 0; i < w1 * h1; i++) {
+    m1[i] = (i % 7) - 3;
+  }
+  for (int i = 0; i < w1 * w2; i++) {
+    m2[i] = (i % 5) - 2;
+  }
+  for (int i = 0; i < w2 * h1; i++) {
+    res[i] = res_base[i] = i % 11;
+  }
+  matrix_multiply_accumulate(false, m1, m2, w1, h1, w2, w1, 3, 2, res_base);
+  matrix_multiply_accumulate(true, m1, m2, w1, h1, w2, w1, 3, 2, res);
+  for (int i = 0; i < w2 * h1; i++) {
+    ASSERT_NEAR(res_base[i], res[i], 0.1) << i;
+  }
+  free(m1);
+  free(m2);
+  free(res);
+  free(res_base);
+}
+
+TEST(MultiplyFused, Validate) {
+  // A single block, the border blocks and several passes over K
+  const int shapes[][3] = { { 3, 2, 4 }, { 16, 12, 32 }, { 300, 37, 43 } };
+  const MatrixActivation activations[] = {
+    kMatrixActivationNone, kMatrixActivationReLU,
+    kMatrixActivationSigmoid, kMatrixActivationTanh
+  };
+  for (auto& shape : shapes) {
+    int w1 = shape[0], h1 = shape[1], w2 = shape[2];
+    float *m1 = mallocf(w1 * h1), *m2 = mallocf(w2 * w1);
+    float *m2t = mallocf(w2 * w1), *bias = mallocf(w2);
+    float *res = mallocf(w2 * h1), *res_base = mallocf(w2 * h1);
+    for (int i = 0; i < w1 * h1; i++) {
+      m1[i] = (i % 7) - 3;
+    }
+    for (int i = 0; i < w1 * w2; i++) {
+      m2[i] = (i % 5) - 2;
+    }
+    for (int i = 0; i < w1; i++) {
+      for (int j = 0; j < w2; j++) {
+        m2t[j * w1 + i] = m2[i * w2 + j];
+      }
+    }
+    for (int j = 0; j < w2; j++) {
+      bias[j] = (j % 9) - 4;
+    }
+    for (auto activation : activations) {
+      for (int with_bias = 0; with_bias <= 1; with_bias++) {
+        MatrixEpilogue epilogue = { 0.1f, with_bias? bias : nullptr,
+                                    activation };
+        // The reference is the plain product followed by the epilogue
+        matrix_multiply_accumulate(false, m1, m2, w1, h1, w2, w1,
+                                   epilogue.scale, 0, res_base);
+        for (int i = 0; i < h1; i++) {
+          for (int j = 0; j < w2; j++) {
+            float x = res_base[i * w2 + j] + (with_bias? bias[j] : 0);
+            switch (activation) {
+              case kMatrixActivationReLU:
+                x = x > 0? x : 0;
+                break;
+              case kMatrixActivationSigmoid:
+                x = 1 / (1 + std::exp(-x));
+                break;
+              case kMatrixActivationTanh:
+                x = std::tanh(x);
+                break;
+              default:
+                break;
+            }
+            res_base[i * w2 + j] = x;
+          }
+        }
+        for (int simd = 0; simd <= 1; simd++) {
+          for (int i = 0; i < w2 * h1; i++) {
+            res[i] = NAN;
+          }
+          matrix_multiply_fused(simd, m1, m2, w1, h1, w2, w1, &epilogue, res);
+          for (int i = 0; i < w2 * h1; i++) {
+            ASSERT_NEAR(res_base[i], res[i], 1e-3f * (1 + fabs(res_base[i])))
+                << simd << " " << activation << " " << with_bias << " " << i;
+          }
+          matrix_multiply_transposed_fused(simd, m1, m2t, w1, h1, w1, w2,
+                                           &epilogue, res);
+          for (int i = 0; i < w2 * h1; i++) {
+            ASSERT_NEAR(res_base[i], res[i], 1e-3f * (1 + fabs(res_base[i])))
+                << simd << " " << activation << " " << with_bias << " " << i;
+          }
+        }
+      }
+    }
+    free(m1);
+    free(m2);
+    free(m2t);
+    free(bias);
+    free(res);
+    free(res_base);
+  }
+}
+
+TEST(MultiplyBatch, Validate) {
+  // Every column chunk width of the small kernels, odd shapes and
+  // a product which is too big for them
+  const int shapes[][3] = {
+    { 4, 4, 4 }, { 8, 8, 8 }, { 16, 16, 16 }, { 32, 32, 32 },
+    { 7, 5, 12 }, { 9, 3, 28 }, { 13, 11, 43 }, { 1, 1, 1 }, { 70, 6, 70 }
+  };
+  const int count = 5;
+  for (auto& shape : shapes) {
+    int w1 = shape[0], h1 = shape[1], w2 = shape[2];
+    float *m1 = mallocf(w1 * h1 * count), *m2 = mallocf(w2 * w1 * count);
+    float *res = mallocf(w2 * h1 * count);
+    float *res_base = mallocf(w2 * h1 * count);
+    for (int i = 0; i < w1 * h1 * count; i++) {
+      m1[i] = (i % 7) - 3;
+    }
+    for (int i = 0; i < w1 * w2 * count; i++) {
+      m2[i] = (i % 5) - 2;
+    }
+    matrix_multiply_batch(true, m1, m2, w1, h1, w2, w1, count, res);
+    for (int i = 0; i < count; i++) {
+      matrix_multiply(false, m1 + i * w1 * h1, m2 + i * w1 * w2,
+                      w1, h1, w2, w1, res_base + i * w2 * h1);
+    }
+    for (int i = 0; i < w2 * h1 * count; i++) {
+      ASSERT_NEAR(res_base[i], res[i], 0.1) << w1 << "x" << h1 << "x" << w2
+                                             << " " << i;
+    }
+    matrix_multiply_batch(false, m1, m2, w1, h1, w2, w1, count, res);
+    for (int i = 0; i < w2 * h1 * count; i++) {
+      ASSERT_NEAR(res_base[i], res[i], 0.1) << i;
+    }
+    // A single one goes through the same small kernels
+    matrix_multiply(true, m1, m2, w1, h1, w2, w1, res);
+    for (int i = 0; i < w2 * h1; i++) {
+      ASSERT_NEAR(res_base[i], res[i], 0.1) << i;
+    }
+    free(m1);
+    free(m2);
+    free(res);
+    free(res_base);
+  }
+}
+
+TEST(MatrixVector, Validate) {
+  const int shapes[][2] = {
+    { 1, 1 }, { 3, 2 }, { 8, 4 }, { 33, 7 }, { 100, 61 }, { 257, 131 }
+  };
+  for (auto& shape : shapes) {
+    int w = shape[0], h = shape[1];
+    float *m = mallocf(w * h), *v = mallocf(w > h? w : h);
+    float *res = mallocf(w > h? w : h), *res_base = mallocf(w > h? w : h);
+    for (int i = 0; i < w * h; i++) {
+      m[i] = (i % 7) - 3;
+    }
+    for (int i = 0; i < (w > h? w : h); i++) {
+      v[i] = (i % 5) - 2;
+    }
+    for (int beta = 0; beta <= 1; beta++) {
+      for (int i = 0; i < h; i++) {
+        res[i] = res_base[i] = i % 11;
+      }
+      matrix_vector_multiply(false, m, v, w, h, 3, beta * 2, res_base);
+      matrix_vector_multiply(true, m, v, w, h, 3, beta * 2, res);
+      for (int i = 0; i < h; i++) {
+        float sum = 0;
+        for (int j = 0; j < w; j++) {
+          sum += m[i * w + j] * v[j];
+        }
+        ASSERT_NEAR(3 * sum + beta * 2 * (i % 11), res_base[i], 0.1) << i;
+        ASSERT_NEAR(res_base[i], res[i], 0.1) << w << "x" << h << " " << i;
+      }
+      for (int i = 0; i < w; i++) {
+        res[i] = res_base[i] = i % 11;
+      }
+      matrix_vector_multiply_transposed(false, m, v, w, h, 3, beta * 2,
+                                        res_base);
+      matrix_vector_multiply_transposed(true, m, v, w, h, 3, beta * 2, res);
+      for (int j = 0; j < w; j++) {
+        float sum = 0;
+        for (int i = 0; i < h; i++) {
+          sum += m[i * w + j] * v[i];
+        }
+        ASSERT_NEAR(3 * sum + beta * 2 * (j % 11), res_base[j], 0.1) << j;
+        ASSERT_NEAR(res_base[j], res[j], 0.1) << w << "x" << h << " " << j;
+      }
+    }
+    free(m);
+    free(v);
+    free(res);
+    free(res_base);
+  }
+}
+
+TEST(Transpose, Validate) {
+  // Whole tiles, partial tiles, partial blocks and the square ones
+  const int shapes[][2] = {
+    { 1, 1 }, { 8, 8 }, { 13, 7 }, { 64, 40 }, { 100, 100 }, { 33, 70 },
+    { 35, 35 }
+  };
+  for (auto& shape : shapes) {
+    int w = shape[0], h = shape[1];
+    float *m = mallocf(w * h), *res = mallocf(w * h);
+    float *res_base = mallocf(w * h);
+    for (int i = 0; i < w * h; i++) {
+      m[i] = i;
+    }
+    for (int simd = 0; simd <= 1; simd++) {
+      matrix_transpose(simd, m, w, h, res);
+      memcpy(res_base, m, w * h * sizeof(float));
+      matrix_transpose_inplace(simd, res_base, w, h);
+      for (int i = 0; i < h; i++) {
+        for (int j = 0; j < w; j++) {
+          ASSERT_EQ(m[i * w + j], res[j * h + i])
+              << simd << " " << w << "x" << h << " " << i << " " << j;
+          ASSERT_EQ(m[i * w + j], res_base[j * h + i])
+              << simd << " " << w << "x" << h << " " << i << " " << j;
+        }
+      }
+    }
+    free(m);
+    free(res);
+    free(res_base);
+  }
+}
+
+TEST(MultiplyInt, Validate) {
+  // Odd K, the border blocks and the whole blocks
+  const int shapes[][3] = {
+    { 1, 1, 1 }, { 3, 2, 5 }, { 17, 9, 33 }, { 64, 37, 70 }
+  };
+  for (auto& shape : shapes) {
+    int w1 = shape[0], h1 = shape[1], w2 = shape[2];
+    int16_t *a16 = new int16_t[w1 * h1], *b16 = new int16_t[w2 * w1];
+    int8_t *a8 = new int8_t[w1 * h1], *b8 = new int8_t[w2 * w1];
+    int32_t *res = new int32_t[w2 * h1], *res_base = new int32_t[w2 * h1];
+    for (int i = 0; i < w1 * h1; i++) {
+      a16[i] = (i * 7919) % 20001 - 10000;
+      a8[i] = (i * 31) % 256 - 128;
+    }
+    for (int i = 0; i < w1 * w2; i++) {
+      b16[i] = (i * 104729) % 20001 - 10000;
+      b8[i] = (i * 17) % 256 - 128;
+    }
+    for (int simd = 0; simd <= 1; simd++) {
+      matrix_multiply_int16(simd, a16, b16, w1, h1, w2, w1, res);
+      for (int i = 0; i < h1; i++) {
+        for (int j = 0; j < w2; j++) {
+          int32_t sum = 0;
+          for (int k = 0; k < w1; k++) {
+            sum += a16[i * w1 + k] * b16[k * w2 + j];
+          }
+          ASSERT_EQ(sum, res[i * w2 + j]) << simd << " " << i << " " << j;
+        }
+      }
+      matrix_multiply_int8(simd, a8, b8, w1, h1, w2, w1, res);
+      for (int i = 0; i < h1; i++) {
+        for (int j = 0; j < w2; j++) {
+          int32_t sum = 0;
+          for (int k = 0; k < w1; k++) {
+            sum += a8[i * w1 + k] * b8[k * w2 + j];
+          }
+          ASSERT_EQ(sum, res[i * w2 + j]) << simd << " " << i << " " << j;
+        }
+      }
+    }
+    delete[] a16;
+    delete[] b16;
+    delete[] a8;
+    delete[] b8;
+    delete[] res;
+    delete[] res_base;
+  }
+}
+
+TEST(Requantize, Validate) {
+  const int w = 21, h = 3;
+  int32_t src[w * h];
+  float bias[w];
+  for (int i = 0; i < w * h; i++) {
+    src[i] = (i % 2? -1 : 1) * i * i * 100;
+  }
+  for (int j = 0; j < w; j++) {
+    bias[j] = j * 0.25f;
+  }
+  for (int simd = 0; simd <= 1; simd++) {
+    float resf[w * h];
+    int8_t res8[w * h];
+    matrix_requantize_float(simd, src, w, h, 0.001f, bias, resf);
+    matrix_requantize_int8(simd, src, w, h, 0.001f, bias, res8);
+    for (int i = 0; i < h; i++) {
+      for (int j = 0; j < w; j++) {
+        float x = src[i * w + j] * 0.001f + bias[j];
+        ASSERT_NEAR(x, resf[i * w + j], 1e-5f * (1 + fabs(x)))
+            << simd << " " << i << " " << j;
+        float q = std::max(-128.f, std::min(127.f, std::nearbyint(x)));
+        ASSERT_EQ(static_cast<int>(q), res8[i * w + j])
+            << simd << " " << i << " " << j;
+      }
+    }
+    // Without the bias, in place
+    memcpy(resf, src, sizeof(src));
+    matrix_requantize_float(simd, reinterpret_cast<int32_t *>(resf), w, h,
+                            2, nullptr, resf);
+    for (int i = 0; i < w * h; i++) {
+      ASSERT_EQ(src[i] * 2.f, resf[i]) << simd << " " << i;
+    }
+  }
+}
+
+TEST(Sparse, Validate) {
+  // Rows of all the lengths around the gather width, including empty ones
+  const int w = 61, h = 37, w2 = 45;
+  float *m = mallocf(w * h), *m2 = mallocf(w2 * w), *v = mallocf(w);
+  float *res = mallocf(w2 * h), *res_base = mallocf(w2 * h);
+  for (int i = 0; i < h; i++) {
+    for (int j = 0; j < w; j++) {
+      m[i * w + j] = (i * 13 + j * 7) % (i + 2) == 0? (j % 9) - 4.f : 0.f;
+    }
+  }
+  for (int i = 0; i < w2 * w; i++) {
+    m2[i] = (i % 11) - 5;
+  }
+  for (int i = 0; i < w; i++) {
+    v[i] = (i % 7) - 3;
+  }
+  size_t nnz = matrix_count_nonzero(m, w, h);
+  ASSERT_GT(nnz, 0u);
+  ASSERT_LT(nnz, static_cast<size_t>(w * h / 2));
+  int row_starts[h + 1];
+  int *columns = new int[nnz];
+  float *values = new float[nnz];
+  matrix_to_csr(m, w, h, row_starts, columns, values);
+  ASSERT_EQ(static_cast<int>(nnz), row_starts[h]);
+  CSRMatrix csr = { w, h, row_starts, columns, values };
+  matrix_multiply(false, m, m2, w, h, w2, w, res_base);
+  for (int simd = 0; simd <= 1; simd++) {
+    matrix_csr_vector_multiply(simd, &csr, v, res);
+    for (int i = 0; i < h; i++) {
+      float sum = 0;
+      for (int j = 0; j < w; j++) {
+        sum += m[i * w + j] * v[j];
+      }
+      ASSERT_EQ(sum, res[i]) << simd << " " << i;
+    }
+    matrix_csr_multiply(simd, &csr, m2, w2, res);
+    for (int i = 0; i < w2 * h; i++) {
+      ASSERT_EQ(res_base[i], res[i]) << simd << " " << i;
+    }
+  }
+  delete[] columns;
+  delete[] values;
+  free(m);
+  free(m2);
+  free(v);
+  free(res);
+  free(res_base);
+}
+
+TEST(Banded, Validate) {
+  const int n = 1100, w2 = 37;
+  const int bands[][2] = { { 0, 0 }, { 1, 1 }, { 3, 0 }, { 2, 12 } };
+  float *m = mallocf(n * n), *m2 = mallocf(w2 * n), *v = mallocf(n);
+  float *res = mallocf(w2 * n), *res_base = mallocf(w2 * n);
+  for (int i = 0; i < w2 * n; i++) {
+    m2[i] = (i % 11) - 5;
+  }
+  for (int i = 0; i < n; i++) {
+    v[i] = (i % 7) - 3;
+  }
+  for (auto& band : bands) {
+    int lower = band[0], upper = band[1];
+    int count = lower + upper + 1;
+    float *diagonals = mallocf(count * n);
+    memset(m, 0, n * n * sizeof(float));
+    for (int k = 0; k < count; k++) {
+      int d = k - lower;
+      for (int i = 0; i < n; i++) {
+        // The constant diagonals as of a FIR filter, garbage outside
+        diagonals[k * n + i] = k + 1;
+        if (i + d >= 0 && i + d < n) {
+          m[i * n + i + d] = k + 1;
+        } else {
+          diagonals[k * n + i] = NAN;
+        }
+      }
+    }
+    matrix_multiply(false, m, m2, n, n, w2, n, res_base);
+    for (int simd = 0; simd <= 1; simd++) {
+      matrix_banded_vector_multiply(simd, diagonals, n, lower, upper, v, res);
+      for (int i = 0; i < n; i++) {
+        float sum = 0;
+        for (int j = 0; j < n; j++) {
+          sum += m[i * n + j] * v[j];
+        }
+        ASSERT_EQ(sum, res[i]) << lower << " " << upper << " " << simd
+                               << " " << i;
+      }
+      matrix_banded_multiply(simd, diagonals, n, lower, upper, m2, w2, res);
+      for (int i = 0; i < w2 * n; i++) {
+        ASSERT_EQ(res_base[i], res[i]) << lower << " " << upper << " "
+                                       << simd << " " << i;
+      }
+    }
+    free(diagonals);
+  }
+  free(m);
+  free(m2);
+  free(v);
+  free(res);
+  free(res_base);
+}
+
+TEST(MultiplyParallel, Validate) {
+  // Big enough to be split into the tiles of different shapes
+  const int w1 = 133, h1 = 211, w2 = 157;
+  float *m1 = mallocf(w1 * h1), *m2 = mallocf(w2 * w1);
+  float *m2t = mallocf(w2 * w1);
+  float *res = mallocf(w2 * h1), *res_base = mallocf(w2 * h1);
+  for (int i = 0; i < w1 * h1; i++) {
+    m1[i] = (i % 7) - 3;
+  }
+  for (int i = 0; i < w1 * w2; i++) {
+    m2[i] = (i % 5) - 2;
+  }
+  for (int i = 0; i < w1; i++) {
+    for (int j = 0; j < w2; j++) {
+      m2t[j * w1 + i] = m2[i * w2 + j];
+    }
+  }
+  ThreadPool *pool = thread_pool_create(4);
+  ASSERT_NE(nullptr, pool);
+  EXPECT_EQ(4, thread_pool_size(pool));
+  for (int i = 0; i < w2 * h1; i++) {
+    res_base[i] = i % 11;
+  }
+  matrix_multiply_accumulate(false, m1, m2, w1, h1, w2, w1, 3, 2, res_base);
+  for (int threads = 0; threads <= 5; threads++) {
+    for (int i = 0; i < w2 * h1; i++) {
+      res[i] = i % 11;
+    }
+    matrix_multiply_parallel(true, pool, threads, m1, m2, w1, h1, w2, w1,
+                             3, 2, res);
+    for (int i = 0; i < w2 * h1; i++) {
+      ASSERT_NEAR(res_base[i], res[i], 0.1) << threads << " " << i;
+    }
+    for (int i = 0; i < w2 * h1; i++) {
+      res[i] = i % 11;
+    }
+    matrix_multiply_transposed_parallel(true, pool, threads, m1, m2t,
+                                        w1, h1, w1, w2, 3, 2, res);
+    for (int i = 0; i < w2 * h1; i++) {
+      ASSERT_NEAR(res_base[i], res[i], 0.1) << threads << " " << i;
+    }
+  }
+  // The default pool and no SIMD
+  matrix_multiply_parallel(true, nullptr, 0, m1, m2, w1, h1, w2, w1,
+                           1, 0, res);
+  matrix_multiply_parallel(false, pool, 0, m1, m2, w1, h1, w2, w1,
+                           1, 0, res_base);
+  for (int i = 0; i < w2 * h1; i++) {
+    ASSERT_NEAR(res_base[i], res[i], 0.1) << i;
+  }
+  thread_pool_destroy(pool);
+  free(m1);
+  free(m2);
+  free(m2t);
+  free(res);
+  free(res_base);
+}
+
 INSTANTIATE_TEST_CASE_P(
     Common, MatrixTest,
     ::testing::Combine(
@@ -195,7 +707,9 @@ INSTANTIATE_TEST_CASE_P(
     ::testing::Combine(
         ::testing::Values(
             std::make_tuple(128, 300, 1000, 128),
-            std::make_tuple(125, 299, 999, 125)
+            std::make_tuple(125, 299, 999, 125),
+            std::make_tuple(300, 150, 37, 300),
+            std::make_tuple(5, 7, 4113, 5)
         ),
         ::testing::Values(
             std::make_tuple(matrix_multiply, false),
@@ -32,6 +32,7 @@
 #define TESTS_SIMD_MATRIX_H_
 
 #define GTEST_HAS_TR1_TUPLE 1
+#include <functional>
 #include <tuple>
 #include <memory>
 #include <gtest/gtest.h>
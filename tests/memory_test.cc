@@ -10,7 +10,11 @@
  *  Copyright © 2013 Samsung R&D Institute Russia
  */
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
 #include <gtest/gtest.h>
+#include <simd/convolve.h>
 #include <simd/memory.h>
 
 #ifdef __AVX__
@@ -80,6 +84,178 @@ TEST(Memory, mallocf) {
   free(ptr);
 }
 
+TEST(Memory, malloc_aligned_ex) {
+  void *small = malloc_aligned_ex(100, kMemoryFlagHugePages);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(small) % 64);
+  free_aligned(small);
+
+  const size_t size = 3 * SIMD_HUGE_PAGE_SIZE + 100;
+  auto huge = static_cast<char *>(malloc_aligned_ex(
+      size, kMemoryFlagHugePages | kMemoryFlagFirstTouch));
+  ASSERT_NE(nullptr, huge);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(huge) % SIMD_HUGE_PAGE_SIZE);
+  for (size_t i = 0; i < size; i++) {
+    ASSERT_EQ(0, huge[i]) << i;
+  }
+  free_aligned(huge);
+
+  // Node 0 always exists, the binding is silently skipped without NUMA
+  auto bound = mallocf_ex(1000, MEMORY_NUMA_NODE(0) | kMemoryFlagFirstTouch);
+  ASSERT_NE(nullptr, bound);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(bound) % 4096);
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(0.f, bound[i]);
+  }
+  free_aligned(bound);
+}
+
+namespace {
+
+struct CountingAllocator {
+  int allocations;
+  int releases;
+};
+
+void *counting_allocate(size_t size, size_t alignment, void *context) {
+  static_cast<CountingAllocator *>(context)->allocations++;
+  void *ptr;
+  return posix_memalign(&ptr, alignment, size) == 0? ptr : nullptr;
+}
+
+void counting_release(void *ptr, void *context) {
+  static_cast<CountingAllocator *>(context)->releases++;
+  free(ptr);
+}
+
+/// Counts the calls and forwards them to another allocator.
+struct ProxyAllocator {
+  const SimdAllocator *inner;
+  CountingAllocator counter;
+};
+
+void *proxy_allocate(size_t size, size_t alignment, void *context) {
+  auto proxy = static_cast<ProxyAllocator *>(context);
+  proxy->counter.allocations++;
+  return proxy->inner->allocate(size, alignment, proxy->inner->context);
+}
+
+void proxy_release(void *ptr, void *context) {
+  auto proxy = static_cast<ProxyAllocator *>(context);
+  proxy->counter.releases++;
+  proxy->inner->release(ptr, proxy->inner->context);
+}
+
+}  // namespace
+
+TEST(Memory, allocator) {
+  CountingAllocator counter = { 0, 0 };
+  SimdAllocator allocator = { counting_allocate, counting_release, &counter };
+  simd_set_allocator(&allocator);
+  EXPECT_EQ(&counter, simd_allocator()->context);
+  float *ptr = mallocf(100);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(ptr) % 64);
+  free_aligned(ptr);
+  free_aligned(nullptr);
+  EXPECT_EQ(1, counter.allocations);
+  EXPECT_EQ(1, counter.releases);
+
+  // The thread allocator takes precedence
+  CountingAllocator thread_counter = { 0, 0 };
+  SimdAllocator thread_allocator = {
+      counting_allocate, counting_release, &thread_counter };
+  simd_set_thread_allocator(&thread_allocator);
+  free_aligned(malloc_aligned(10));
+  simd_set_thread_allocator(nullptr);
+  EXPECT_EQ(1, thread_counter.allocations);
+  EXPECT_EQ(1, thread_counter.releases);
+  EXPECT_EQ(1, counter.allocations);
+
+  simd_set_allocator(nullptr);
+  EXPECT_EQ(nullptr, simd_allocator()->context);
+  free_aligned(malloc_aligned(10));
+  EXPECT_EQ(1, counter.allocations);
+}
+
+TEST(Memory, arena) {
+  SimdArena *arena = simd_arena_create(1000);
+  ASSERT_NE(nullptr, arena);
+  const SimdAllocator *allocator = simd_arena_allocator(arena);
+  simd_set_thread_allocator(allocator);
+  void *first = malloc_aligned(100);
+  void *second = malloc_aligned(10);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(first) % 64);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(second) % 64);
+  EXPECT_EQ(static_cast<char *>(first) + 128, second);
+  EXPECT_EQ(138u, simd_arena_used(arena));
+  // Only the last block is reclaimed immediately
+  free_aligned(second);
+  EXPECT_EQ(100u, simd_arena_used(arena));
+  EXPECT_EQ(second, malloc_aligned(10));
+  EXPECT_EQ(138u, simd_arena_used(arena));
+  free_aligned(first);
+  EXPECT_EQ(138u, simd_arena_used(arena));
+  simd_arena_reset(arena);
+  EXPECT_EQ(0u, simd_arena_used(arena));
+
+  // Grow beyond the initial capacity, the reset merges the chunks
+  for (int i = 0; i < 10; i++) {
+    memsetf(mallocf(1000), 1.f, 1000);
+  }
+  simd_set_thread_allocator(nullptr);
+  size_t used = simd_arena_used(arena);
+  EXPECT_GT(used, 40000u);
+  simd_arena_reset(arena);
+  EXPECT_EQ(0u, simd_arena_used(arena));
+  // Now they fit into a single chunk
+  simd_set_thread_allocator(allocator);
+  float *blocks[10];
+  for (int i = 0; i < 10; i++) {
+    blocks[i] = mallocf(1000);
+    memsetf(blocks[i], 1.f, 1000);
+  }
+  simd_set_thread_allocator(nullptr);
+  EXPECT_EQ(9 * 4032, (blocks[9] - blocks[0]) * sizeof(float));
+  simd_arena_destroy(arena);
+}
+
+TEST(Memory, arena_convolve) {
+  const int xLength = 1000, hLength = 50;
+  float x[xLength], h[hLength];
+  for (int i = 0; i < xLength; i++) {
+    x[i] = sinf(i * 0.1f);
+  }
+  for (int i = 0; i < hLength; i++) {
+    h[i] = 1.f / (i + 1);
+  }
+  float expected[xLength + hLength - 1], result[xLength + hLength - 1];
+  auto handle = convolve_initialize(xLength, hLength);
+  convolve(handle, x, h, expected);
+  convolve_finalize(handle);
+
+  CountingAllocator counter = { 0, 0 };
+  SimdAllocator system = { counting_allocate, counting_release, &counter };
+  simd_set_allocator(&system);
+  SimdArena *arena = simd_arena_create(1 << 16);
+  ProxyAllocator proxy = { simd_arena_allocator(arena), { 0, 0 } };
+  SimdAllocator counted = { proxy_allocate, proxy_release, &proxy };
+  for (int round = 0; round < 3; round++) {
+    simd_set_thread_allocator(&counted);
+    handle = convolve_initialize(xLength, hLength);
+    convolve(handle, x, h, result);
+    convolve_finalize(handle);
+    simd_set_thread_allocator(nullptr);
+    simd_arena_reset(arena);
+    for (int i = 0; i < xLength + hLength - 1; i++) {
+      ASSERT_EQ(expected[i], result[i]) << i;
+    }
+  }
+  simd_arena_destroy(arena);
+  simd_set_allocator(nullptr);
+  EXPECT_EQ(0, counter.allocations);
+  EXPECT_GT(proxy.counter.allocations, 0);
+  EXPECT_EQ(proxy.counter.allocations, proxy.counter.releases);
+}
+
 TEST(Memory, memsetf) {
   float ptr[102] __attribute__ ((aligned (32)));  // NOLINT(whitespace/parens)
   memsetf(&ptr[3], 3.0f, 99);
@@ -88,6 +264,47 @@ TEST(Memory, memsetf) {
   }
 }
 
+TEST(Memory, streaming) {
+  std::vector<float> src(1000), dest(1000 + 32);
+  for (size_t i = 0; i < src.size(); i++) {
+    src[i] = i;
+  }
+  for (int offset = 0; offset < 17; offset++) {
+    for (size_t length : { 0, 1, 7, 15, 16, 17, 100, 1000 }) {
+      std::fill(dest.begin(), dest.end(), -1.f);
+      memsetf_stream(dest.data() + offset, 3.f, length);
+      for (size_t i = 0; i < dest.size(); i++) {
+        bool inside = i >= static_cast<size_t>(offset) && i < offset + length;
+        ASSERT_EQ(inside? 3.f : -1.f, dest[i]) << offset << " " << length;
+      }
+      std::fill(dest.begin(), dest.end(), -1.f);
+      EXPECT_EQ(dest.data() + offset,
+                memcpyf_stream(dest.data() + offset, src.data(), length));
+      for (size_t i = 0; i < dest.size(); i++) {
+        bool inside = i >= static_cast<size_t>(offset) && i < offset + length;
+        ASSERT_EQ(inside? src[i - offset] : -1.f, dest[i])
+            << offset << " " << length;
+      }
+    }
+  }
+
+  // Force memsetf() and memcpyf() to stream
+  size_t threshold = memory_streaming_threshold();
+  EXPECT_GT(threshold, 0u);
+  memory_set_streaming_threshold(64);
+  EXPECT_EQ(64u, memory_streaming_threshold());
+  std::fill(dest.begin(), dest.end(), -1.f);
+  memsetf(dest.data() + 1, 2.f, 999);
+  EXPECT_EQ(-1.f, dest[0]);
+  EXPECT_EQ(2.f, dest[999]);
+  EXPECT_EQ(-1.f, dest[1000]);
+  memcpyf(dest.data() + 3, src.data(), 997);
+  EXPECT_EQ(2.f, dest[2]);
+  EXPECT_EQ(996.f, dest[999]);
+  memory_set_streaming_threshold(0);
+  EXPECT_EQ(threshold, memory_streaming_threshold());
+}
+
 TEST(Memory, zeropadding) {
   float orig[100];
   memsetf(orig, 1.0f, 100);
@@ -107,6 +324,24 @@ TEST(Memory, zeropadding) {
   free(ptr);
 }
 
+TEST(Memory, zeropadding_power_of_2) {
+  float orig[1024];
+  memsetf(orig, 1.0f, 1024);
+  size_t nl;
+  auto ptr = zeropaddingex(orig, 1024, &nl, 2);
+  EXPECT_EQ(static_cast<size_t>(2048), nl);
+  for (int i = 0; i < 1024; i++) {
+    EXPECT_EQ(1.0f, ptr[i]);
+  }
+  for (int i = 1024; i < 2048; i++) {
+    EXPECT_EQ(0.0f, ptr[i]);
+  }
+  free(ptr);
+  ptr = zeropadding(orig, 1, &nl);
+  EXPECT_EQ(static_cast<size_t>(1), nl);
+  free(ptr);
+}
+
 TEST(Memory, rmemcpyf) {
   float src[25] __attribute__ ((aligned (32)));  // NOLINT(*)
   const int len = sizeof(src) / sizeof(float);  // NOLINT(*)
@@ -120,4 +355,76 @@ TEST(Memory, rmemcpyf) {
   }
 }
 
+TEST(Memory, crmemcpyf) {
+  for (size_t len = 0; len <= 40; len += 2) {
+    std::vector<float> src(len + 1), dest(len + 1, -1.f);
+    for (size_t i = 0; i < src.size(); i++) {
+      src[i] = i;
+    }
+    crmemcpyf(dest.data(), src.data() + 1, len);
+    for (size_t i = 0; i < len; i += 2) {
+      ASSERT_EQ(src[1 + len - i - 2], dest[i]) << len << " " << i;
+      ASSERT_EQ(src[1 + len - i - 1], dest[i + 1]) << len << " " << i;
+    }
+    ASSERT_EQ(-1.f, dest[len]);
+  }
+}
+
+TEST(Memory, reversef) {
+  for (size_t len = 0; len <= 41; len++) {
+    std::vector<float> src(len + 1), data(len + 1);
+    for (size_t i = 0; i < src.size(); i++) {
+      src[i] = data[i] = i;
+    }
+    reversef(data.data() + 1, len);
+    for (size_t i = 0; i < len; i++) {
+      ASSERT_EQ(src[len - i], data[1 + i]) << len << " " << i;
+    }
+    ASSERT_EQ(0.f, data[0]);
+    if (len % 2 == 0) {
+      for (size_t i = 0; i < src.size(); i++) {
+        data[i] = i;
+      }
+      creversef(data.data() + 1, len);
+      std::vector<float> expected(len);
+      crmemcpyf(expected.data(), src.data() + 1, len);
+      for (size_t i = 0; i < len; i++) {
+        ASSERT_EQ(expected[i], data[1 + i]) << len << " " << i;
+      }
+    }
+  }
+}
+
+TEST(Memory, interleave) {
+  const size_t frames = 37;
+  for (int channels = 1; channels <= 9; channels++) {
+    std::vector<float> src(frames * channels), planar(frames * channels),
+        back(frames * channels);
+    std::vector<int16_t> src16(frames * channels), planar16(frames * channels),
+        back16(frames * channels);
+    for (size_t i = 0; i < src.size(); i++) {
+      src[i] = i;
+      src16[i] = i * 877 - 16000;
+    }
+    deinterleavef(src.data(), frames, channels, planar.data());
+    deinterleave_i16(src16.data(), frames, channels, planar16.data());
+    for (int c = 0; c < channels; c++) {
+      for (size_t i = 0; i < frames; i++) {
+        ASSERT_EQ(src[i * channels + c], planar[c * frames + i])
+            << channels << " " << c << " " << i;
+        ASSERT_EQ(src16[i * channels + c], planar16[c * frames + i])
+            << channels << " " << c << " " << i;
+      }
+    }
+    deinterleave_i16_to_float(src16.data(), frames, channels, back.data());
+    for (size_t i = 0; i < back.size(); i++) {
+      ASSERT_EQ(planar16[i], back[i]) << channels << " " << i;
+    }
+    interleavef(planar.data(), frames, channels, back.data());
+    interleave_i16(planar16.data(), frames, channels, back16.data());
+    ASSERT_EQ(src, back) << channels;
+    ASSERT_EQ(src16, back16) << channels;
+  }
+}
+
 #include "tests/google/src/gtest_main.cc"
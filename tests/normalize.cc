@@ -32,6 +32,9 @@
 #include <simd/normalize.h>
 #include <simd/memory.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 class SimdTest : public ::testing::TestWithParam<bool> {
  protected:
@@ -80,6 +83,251 @@ TEST_P(SimdTest, minmax1D) {
   EXPECT_FLOAT_EQ(252, max);
 }
 
+TEST_P(SimdTest, normalize2D_stream) {
+  const int width = 300, height = 200, stride = 320;
+  std::vector<uint8_t> image(stride * height);
+  for (int i = 0; i < stride * height; i++) {
+    image[i] = 20 + (i * 7) % 200;
+  }
+  std::vector<float> res(width * height), verif(width * height);
+  uint8_t min, max;
+  // The exact range gives the same result as normalize2D()
+  normalize2D(is_simd(), image.data(), stride, width, height, verif.data(),
+              width);
+  normalize2D_stream(is_simd(), 20, 219, image.data(), stride, width, height,
+                     res.data(), width, &min, &max);
+  EXPECT_EQ(20, min);
+  EXPECT_EQ(219, max);
+  for (int i = 0; i < width * height; i++) {
+    ASSERT_NEAR(verif[i], res[i], 1e-6) << i;
+  }
+  // The values outside the range of the previous frame are clamped
+  normalize2D_stream(is_simd(), 50, 150, image.data(), stride, width, height,
+                     res.data(), width, nullptr, nullptr);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      float value = image[y * stride + x];
+      float expected = std::min(1.f, std::max(-1.f, (value - 50) / 50 - 1));
+      ASSERT_NEAR(expected, res[y * width + x], 1e-5) << x << " " << y;
+    }
+  }
+}
+
+TEST_P(SimdTest, normalize2D_parallel) {
+  const int width = 1500, height = 1000, stride = 1504;
+  std::vector<uint8_t> image(stride * height);
+  for (int i = 0; i < stride * height; i++) {
+    image[i] = 30 + (i * 13) % 97;
+  }
+  image[stride * 900 + 7] = 255;
+  image[stride * 3 + 1] = 2;
+  std::vector<float> res(width * height), verif(width * height);
+  normalize2D(is_simd(), image.data(), stride, width, height, verif.data(),
+              width);
+  normalize2D_parallel(is_simd(), nullptr, 0, image.data(), stride, width,
+                       height, res.data(), width);
+  for (int i = 0; i < width * height; i++) {
+    ASSERT_FLOAT_EQ(verif[i], res[i]) << i;
+  }
+  EXPECT_FLOAT_EQ(1.f, res[width * 900 + 7]);
+  EXPECT_FLOAT_EQ(-1.f, res[width * 3 + 1]);
+}
+
+static float half_to_float(uint16_t half) {
+  int exponent = (half >> 10) & 0x1F;
+  float mantissa = half & 0x3FF;
+  float value = exponent == 0? ldexpf(mantissa, -24) :
+      ldexpf(mantissa + 1024, exponent - 25);
+  return half & 0x8000? -value : value;
+}
+
+TEST_P(SimdTest, normalize2D_uint16) {
+  const int width = 203, height = 50, stride = 210;
+  std::vector<uint16_t> image(stride * height);
+  for (int i = 0; i < stride * height; i++) {
+    image[i] = 100 + (i * 37) % 4000;
+  }
+  uint16_t min, max;
+  minmax2D_uint16(is_simd(), image.data(), stride, width, height, &min, &max);
+  EXPECT_EQ(100, min);
+  EXPECT_EQ(4099, max);
+  std::vector<float> res(width * height);
+  std::vector<uint16_t> half(width * height);
+  std::vector<int8_t> quant(width * height);
+  normalize2D_uint16(is_simd(), image.data(), stride, width, height,
+                     NORMALIZE_OUTPUT_FLOAT, res.data(), width);
+  normalize2D_uint16(is_simd(), image.data(), stride, width, height,
+                     NORMALIZE_OUTPUT_FP16, half.data(), width);
+  normalize2D_uint16(is_simd(), image.data(), stride, width, height,
+                     NORMALIZE_OUTPUT_INT8, quant.data(), width);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      float expected = 2.f * (image[y * stride + x] - 100) / 3999 - 1;
+      int i = y * width + x;
+      ASSERT_NEAR(expected, res[i], 1e-5) << x << " " << y;
+      ASSERT_NEAR(expected, half_to_float(half[i]), 1e-3) << x << " " << y;
+      ASSERT_NEAR(expected * 127, quant[i], 0.51f) << x << " " << y;
+    }
+  }
+  EXPECT_FLOAT_EQ(-1.f, res[0]);
+  EXPECT_EQ(0xBC00, half[0]);
+  EXPECT_EQ(-127, quant[0]);
+}
+
+TEST_P(SimdTest, normalize2D_float) {
+  const int width = 77, height = 31, stride = 80;
+  std::vector<float> image(stride * height);
+  for (int i = 0; i < stride * height; i++) {
+    image[i] = -3.f + (i % 101) * 0.25f;
+  }
+  float min, max;
+  minmax2D_float(is_simd(), image.data(), stride, width, height, &min, &max);
+  EXPECT_FLOAT_EQ(-3.f, min);
+  EXPECT_FLOAT_EQ(22.f, max);
+  std::vector<float> res(width * height);
+  std::vector<uint16_t> half(width * height);
+  std::vector<int8_t> quant(width * height);
+  normalize2D_float(is_simd(), image.data(), stride, width, height,
+                    NORMALIZE_OUTPUT_FLOAT, res.data(), width);
+  normalize2D_float(is_simd(), image.data(), stride, width, height,
+                    NORMALIZE_OUTPUT_FP16, half.data(), width);
+  normalize2D_float(is_simd(), image.data(), stride, width, height,
+                    NORMALIZE_OUTPUT_INT8, quant.data(), width);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      float expected = (image[y * stride + x] + 3) / 12.5f - 1;
+      int i = y * width + x;
+      ASSERT_NEAR(expected, res[i], 1e-5) << x << " " << y;
+      ASSERT_NEAR(expected, half_to_float(half[i]), 1e-3) << x << " " << y;
+      ASSERT_NEAR(expected * 127, quant[i], 0.51f) << x << " " << y;
+    }
+  }
+  // The byte source gives the same result as normalize2D()
+  uint8_t bytes[40 * 20];
+  for (int i = 0; i < 40 * 20; i++) {
+    bytes[i] = (i * 11) % 256;
+  }
+  float verif[40 * 20];
+  normalize2D(is_simd(), bytes, 40, 40, 20, verif, 40);
+  normalize2D_uint8(is_simd(), bytes, 40, 40, 20, NORMALIZE_OUTPUT_FP16,
+                    half.data(), 40);
+  for (int i = 0; i < 40 * 20; i++) {
+    ASSERT_NEAR(verif[i], half_to_float(half[i]), 1e-3) << i;
+  }
+}
+
+TEST_P(SimdTest, zscore) {
+  // The large mean breaks the naive sum of squares in single precision
+  const int length = 10007;
+  std::vector<float> array(length), res(length);
+  double sum = 0;
+  for (int i = 0; i < length; i++) {
+    array[i] = 10000.f + (i * 7919) % 101 * 0.01f;
+    sum += array[i];
+  }
+  double mean = sum / length, m2 = 0;
+  for (int i = 0; i < length; i++) {
+    m2 += (array[i] - mean) * (array[i] - mean);
+  }
+  double stddev = sqrt(m2 / length);
+  float resMean, resStddev;
+  meanstd1D(is_simd(), array.data(), length, &resMean, &resStddev);
+  EXPECT_NEAR(mean, resMean, 1e-3);
+  EXPECT_NEAR(stddev, resStddev, stddev * 1e-3);
+  normalize1D_zscore(is_simd(), array.data(), length, res.data());
+  for (int i = 0; i < length; i++) {
+    ASSERT_NEAR((array[i] - mean) / stddev, res[i], 2e-2) << i;
+  }
+  // 2D on the plane of width 100 with stride 101 covers the same values
+  // except the last column
+  normalize2D_zscore(is_simd(), array.data(), 101, 100, 99, res.data(), 100);
+  meanstd2D(is_simd(), array.data(), 101, 100, 99, &resMean, &resStddev);
+  for (int y = 0; y < 99; y++) {
+    for (int x = 0; x < 100; x++) {
+      ASSERT_NEAR((array[y * 101 + x] - resMean) / resStddev,
+                  res[y * 100 + x], 1e-5) << x << " " << y;
+    }
+  }
+  // The constant array gives zeros
+  std::vector<float> flat(100, 3.f);
+  normalize1D_zscore(is_simd(), flat.data(), 100, flat.data());
+  for (float value : flat) {
+    ASSERT_EQ(0.f, value);
+  }
+}
+
+TEST_P(SimdTest, zscore_channels) {
+  const int frames = 3001;
+  for (int channels : {1, 3, 13}) {
+    std::vector<float> array(frames * channels), res(frames * channels);
+    for (int i = 0; i < frames * channels; i++) {
+      int c = i % channels;
+      array[i] = c * 100.f + (i * 31) % 17 * (c + 1);
+    }
+    std::vector<float> mean(channels), stddev(channels);
+    meanstd_channels(is_simd(), array.data(), frames, channels,
+                     mean.data(), stddev.data());
+    normalize_zscore_channels(is_simd(), array.data(), frames, channels,
+                              res.data());
+    for (int c = 0; c < channels; c++) {
+      double sum = 0, m2 = 0;
+      for (int f = 0; f < frames; f++) {
+        sum += array[f * channels + c];
+      }
+      double ref = sum / frames;
+      for (int f = 0; f < frames; f++) {
+        double diff = array[f * channels + c] - ref;
+        m2 += diff * diff;
+      }
+      double dev = sqrt(m2 / frames);
+      ASSERT_NEAR(ref, mean[c], 1e-3) << channels << " " << c;
+      ASSERT_NEAR(dev, stddev[c], dev * 1e-4) << channels << " " << c;
+      for (int f = 0; f < frames; f++) {
+        ASSERT_NEAR((array[f * channels + c] - ref) / dev,
+                    res[f * channels + c], 1e-3) << channels << " " << c;
+      }
+    }
+  }
+}
+
+TEST_P(SimdTest, minmax_tails) {
+  // Every width covers a different combination of the vector loops and
+  // the tail; the bytes past the width must be ignored
+  for (int width : {1, 15, 16, 33, 64, 97, 130, 255}) {
+    const int height = 3, stride = 320;
+    std::vector<uint8_t> image(stride * height, 0);
+    std::vector<float> floats(width * height);
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+        image[y * stride + x] = 100 + (x * 3 + y) % 50;
+      }
+      image[y * stride + width] = 255;
+    }
+    image[stride * 2 + width - 1] = 7;
+    image[stride + width / 2] = 201;
+    uint8_t min, max;
+    minmax2D(is_simd(), image.data(), stride, width, height, &min, &max);
+    EXPECT_EQ(7, min) << width;
+    EXPECT_EQ(201, max) << width;
+    std::vector<float> res(width * height);
+    normalize2D_minmax(is_simd(), 0, 250, image.data(), stride, width, height,
+                       res.data(), width);
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+        float value = image[y * stride + x];
+        floats[y * width + x] = value;
+        float expected = value / 125 - 1;
+        ASSERT_NEAR(expected, res[y * width + x], 1e-5)
+            << width << " " << x << " " << y;
+      }
+    }
+    float fmin, fmax;
+    minmax1D(is_simd(), floats.data(), width * height, &fmin, &fmax);
+    EXPECT_FLOAT_EQ(min, fmin) << width;
+    EXPECT_FLOAT_EQ(max, fmax) << width;
+  }
+}
+
 INSTANTIATE_TEST_CASE_P(NormalizeTests, SimdTest, ::testing::Bool());
 
 #include "tests/google/src/gtest_main.cc"
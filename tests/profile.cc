@@ -0,0 +1,194 @@
+/*! @file profile.cc
+ *  @brief Tests for the instrumentation of the kernels.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include <gtest/gtest.h>
+#include <simd/convolve.h>
+#include <simd/correlate.h>
+#include <simd/matrix.h>
+#include <simd/memory.h>
+#include <simd/normalize.h>
+#include <simd/profile.h>
+#include <simd/wavelet.h>
+
+namespace {
+
+SimdProfileCounters Get(SimdProfileKernel kernel) {
+  SimdProfileCounters counters;
+  simd_profile_get(kernel, &counters);
+  return counters;
+}
+
+void Record(const SimdTraceEvent *event, void *user_data) {
+  static_cast<std::vector<SimdTraceEvent> *>(user_data)->push_back(*event);
+}
+
+}  // namespace
+
+TEST(Profile, Disabled) {
+  simd_profile_set_enabled(false);
+  EXPECT_FALSE(simd_profile_enabled());
+  simd_profile_reset();
+  float m[16] = { 1 }, res[16];
+  matrix_multiply(true, m, m, 4, 4, 4, 4, res);
+  EXPECT_EQ(0u, Get(kSimdProfileMatrixMultiply).calls);
+}
+
+TEST(Profile, Accounting) {
+  simd_profile_set_enabled(true);
+  EXPECT_TRUE(simd_profile_enabled());
+  simd_profile_reset();
+  bool hardware = simd_profile_hardware_counters();
+
+  const int n = 64;
+  std::vector<float> a(n * n, 1), b(n * n, 2), c(n * n);
+  for (int i = 0; i < 3; i++) {
+    matrix_multiply(true, a.data(), b.data(), n, n, n, n, c.data());
+  }
+  auto mm = Get(kSimdProfileMatrixMultiply);
+  EXPECT_EQ(3u, mm.calls);
+  EXPECT_EQ(3ull * 2 * n * n * n, mm.flops);
+  EXPECT_EQ(3ull * 3 * n * n * sizeof(float), mm.bytes);
+  EXPECT_GT(mm.nanoseconds, 0u);
+  if (hardware) {
+    EXPECT_GT(mm.cycles, 0u);
+    EXPECT_GT(mm.instructions, 0u);
+  } else {
+    EXPECT_EQ(0u, mm.cycles);
+  }
+
+  const int xLength = 1000, hLength = 50;
+  std::vector<float> x(xLength, 1), h(hLength, 1);
+  std::vector<float> result(xLength + hLength - 1);
+  for (auto algorithm : { kConvolutionAlgorithmBruteForce,
+                          kConvolutionAlgorithmFFT,
+                          kConvolutionAlgorithmOverlapSave }) {
+    simd_profile_reset();
+    auto handle = convolve_initialize_algorithm(xLength, hLength, algorithm);
+    convolve(handle, x.data(), h.data(), result.data());
+    convolve_finalize(handle);
+    auto conv = Get(kSimdProfileConvolve);
+    EXPECT_EQ(1u, conv.calls);
+    EXPECT_EQ((2ull * (xLength + hLength) - 1) * sizeof(float), conv.bytes);
+    if (algorithm == kConvolutionAlgorithmBruteForce) {
+      EXPECT_EQ(2ull * xLength * hLength, conv.flops);
+    } else {
+      EXPECT_GT(conv.flops, 0u);
+      EXPECT_LT(conv.flops, 2ull * xLength * hLength);
+    }
+  }
+
+  const int length = 512;
+  float *src = mallocf(length);
+  for (int i = 0; i < length; i++) {
+    src[i] = i;
+  }
+  float *prep = wavelet_prepare_array(8, src, length);
+  float *hi = wavelet_allocate_destination(8, length);
+  float *lo = wavelet_allocate_destination(8, length);
+  wavelet_apply(WAVELET_TYPE_DAUBECHIES, 8, EXTENSION_TYPE_PERIODIC, prep,
+                length, hi, lo);
+  auto wav = Get(kSimdProfileWaveletApply);
+  EXPECT_EQ(1u, wav.calls);
+  EXPECT_EQ(2ull * 8 * length, wav.flops);
+  EXPECT_EQ(8ull * length, wav.bytes);
+  free(hi);
+  free(lo);
+  if (prep != src) {
+    free(prep);
+  }
+  free(src);
+
+  std::vector<uint8_t> image(32 * 16, 7);
+  std::vector<float> normalized(32 * 16);
+  normalize2D(true, image.data(), 32, 32, 16, normalized.data(), 32);
+  auto norm = Get(kSimdProfileNormalize2D);
+  EXPECT_EQ(1u, norm.calls);
+  EXPECT_EQ(5ull * 32 * 16, norm.bytes);
+
+  simd_profile_reset();
+  EXPECT_EQ(0u, Get(kSimdProfileNormalize2D).calls);
+  EXPECT_EQ(0u, Get(kSimdProfileMatrixMultiply).flops);
+  simd_profile_set_enabled(false);
+}
+
+TEST(Profile, Trace) {
+  std::vector<SimdTraceEvent> events;
+  simd_profile_set_trace(Record, &events);
+  EXPECT_FALSE(simd_profile_enabled());
+
+  const int xLength = 1000, hLength = 50;
+  std::vector<float> x(xLength, 1), h(hLength, 1);
+  std::vector<float> result(xLength + hLength - 1);
+  auto algorithm = convolve_select_algorithm(xLength, hLength);
+  ASSERT_EQ(1u, events.size());
+  EXPECT_EQ(kSimdTraceSelectAlgorithm, events[0].entry);
+  EXPECT_EQ(algorithm, events[0].algorithm);
+  EXPECT_EQ(static_cast<size_t>(xLength), events[0].x_length);
+  EXPECT_EQ(static_cast<size_t>(hLength), events[0].h_length);
+
+  events.clear();
+  auto handle = convolve_initialize_algorithm(xLength, hLength,
+                                              kConvolutionAlgorithmFFT);
+  convolve(handle, x.data(), h.data(), result.data());
+  ASSERT_EQ(1u, events.size());
+  EXPECT_EQ(kSimdTraceConvolve, events[0].entry);
+  EXPECT_EQ(kConvolutionAlgorithmFFT, events[0].algorithm);
+  EXPECT_EQ(static_cast<size_t>(*handle.handle.fft.M),
+            events[0].fft_length);
+  EXPECT_GT(events[0].nanoseconds, 0u);
+  convolve_finalize(handle);
+
+  for (auto algorithm : { kConvolutionAlgorithmBruteForce,
+                          kConvolutionAlgorithmOverlapSave }) {
+    events.clear();
+    auto ccHandle = cross_correlate_initialize_algorithm(
+        xLength, hLength, algorithm);
+    cross_correlate(ccHandle, x.data(), h.data(), result.data());
+    ASSERT_EQ(1u, events.size());
+    EXPECT_EQ(kSimdTraceCrossCorrelate, events[0].entry);
+    EXPECT_EQ(algorithm, events[0].algorithm);
+    if (algorithm == kConvolutionAlgorithmBruteForce) {
+      EXPECT_EQ(0u, events[0].fft_length);
+    } else {
+      EXPECT_EQ(static_cast<size_t>(*ccHandle.handle.os.L),
+                events[0].fft_length);
+    }
+    cross_correlate_finalize(ccHandle);
+  }
+
+  events.clear();
+  handle = convolve_initialize_algorithm_with_kernel(
+      xLength, h.data(), hLength, kConvolutionAlgorithmOverlapSave);
+  convolve_with_kernel(handle, x.data(), result.data());
+  ASSERT_EQ(1u, events.size());
+  EXPECT_EQ(kSimdTraceConvolveWithKernel, events[0].entry);
+  EXPECT_EQ(kConvolutionAlgorithmOverlapSave, events[0].algorithm);
+
+  simd_profile_set_trace(nullptr, nullptr);
+  events.clear();
+  convolve_with_kernel(handle, x.data(), result.data());
+  convolve_finalize(handle);
+  EXPECT_TRUE(events.empty());
+}
+
+TEST(Profile, Names) {
+  EXPECT_STREQ("convolve", simd_profile_kernel_name(kSimdProfileConvolve));
+  EXPECT_STREQ("matrix_multiply",
+               simd_profile_kernel_name(kSimdProfileMatrixMultiply));
+  EXPECT_STREQ("normalize2D",
+               simd_profile_kernel_name(kSimdProfileNormalize2D));
+}
+
+#include "tests/google/src/gtest_main.cc"
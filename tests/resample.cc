@@ -0,0 +1,172 @@
+/*! @file resample.cc
+ *  @brief Tests for src/resample.c.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include <simd/convolve.h>
+#include <simd/resample.h>
+
+/// @brief Upsamples with zeros, convolves and takes every down-th sample.
+static std::vector<float> resample_reference(int up, int down,
+                                             const std::vector<float>& h,
+                                             const std::vector<float>& x) {
+  std::vector<float> upsampled(x.size() * up, 0.f);
+  for (size_t i = 0; i < x.size(); i++) {
+    upsampled[i * up] = x[i];
+  }
+  std::vector<float> full(upsampled.size() + h.size() - 1);
+  convolve_simd(0, upsampled.data(), upsampled.size(), h.data(), h.size(),
+                full.data());
+  std::vector<float> result;
+  for (size_t t = 0; t < upsampled.size(); t += down) {
+    result.push_back(full[t]);
+  }
+  return result;
+}
+
+static std::vector<float> test_signal(size_t length) {
+  std::vector<float> x(length);
+  for (size_t i = 0; i < length; i++) {
+    x[i] = sinf(i * 0.05f) + 0.3f * cosf(i * 0.71f);
+  }
+  return x;
+}
+
+TEST(resample, resample_process) {
+  const int factors[][3] = {
+      { 1, 3, 31 }, { 4, 1, 47 }, { 2, 3, 60 }, { 3, 2, 5 }, { 160, 147, 0 },
+      { 1, 1, 9 }, { 5, 5, 1 } };
+  auto x = test_signal(3000);
+  for (auto& factor : factors) {
+    int up = factor[0], down = factor[1];
+    std::vector<float> h;
+    if (factor[2] > 0) {
+      for (int i = 0; i < factor[2]; i++) {
+        h.push_back(cosf(i * 0.2f) / (i + 1));
+      }
+    } else {
+      h.resize(up * 16);
+      resample_design_filter(up, down, 16, h.data());
+    }
+    auto verif = resample_reference(up, down, h, x);
+    for (int simd = 0; simd < 2; simd++) {
+      auto handle = resample_initialize(up, down, h.data(), h.size());
+      EXPECT_EQ(verif.size(), resample_output_length(&handle, x.size()));
+      std::vector<float> result(x.size() * up / down + 1);
+      size_t count = resample_process(simd, &handle, x.data(), x.size(),
+                                      result.data());
+      ASSERT_EQ(verif.size(), count) << up << "/" << down;
+      for (size_t i = 0; i < count; i++) {
+        ASSERT_NEAR(verif[i], result[i], 1e-4f) << up << "/" << down << " "
+                                                << i;
+      }
+      // The blocks of varying lengths, shorter ones than the filter too
+      resample_reset(&handle);
+      std::fill(result.begin(), result.end(), 0.f);
+      size_t offset = 0, total = 0;
+      for (size_t block = 1; offset < x.size(); block = block * 3 % 101) {
+        if (offset + block > x.size()) {
+          block = x.size() - offset;
+        }
+        size_t expected = resample_output_length(&handle, block);
+        size_t written = resample_process(simd, &handle, x.data() + offset,
+                                          block, result.data() + total);
+        ASSERT_EQ(expected, written);
+        offset += block;
+        total += written;
+      }
+      ASSERT_EQ(verif.size(), total) << up << "/" << down;
+      for (size_t i = 0; i < total; i++) {
+        ASSERT_NEAR(verif[i], result[i], 1e-4f) << up << "/" << down << " "
+                                                << i;
+      }
+      resample_finalize(&handle);
+    }
+  }
+}
+
+TEST(resample, resample_decimate_interpolate) {
+  auto x = test_signal(1000);
+  std::vector<float> h(24);
+  resample_design_filter(1, 4, 24, h.data());
+  auto decimate = resample_decimate_initialize(4, h.data(), h.size());
+  std::vector<float> result(x.size());
+  auto verif = resample_reference(1, 4, h, x);
+  ASSERT_EQ(verif.size(), resample_process(1, &decimate, x.data(), x.size(),
+                                           result.data()));
+  for (size_t i = 0; i < verif.size(); i++) {
+    ASSERT_NEAR(verif[i], result[i], 1e-4f) << i;
+  }
+  resample_finalize(&decimate);
+
+  h.resize(3 * 8);
+  resample_design_filter(3, 1, 8, h.data());
+  auto interpolate = resample_interpolate_initialize(3, h.data(), h.size());
+  result.resize(x.size() * 3);
+  verif = resample_reference(3, 1, h, x);
+  ASSERT_EQ(verif.size(), resample_process(1, &interpolate, x.data(),
+                                           x.size(), result.data()));
+  for (size_t i = 0; i < verif.size(); i++) {
+    ASSERT_NEAR(verif[i], result[i], 1e-4f) << i;
+  }
+  resample_finalize(&interpolate);
+}
+
+TEST(resample, resample_design_filter) {
+  // 44.1 kHz -> 48 kHz keeps a constant signal and a low tone
+  const int up = 160, down = 147, taps = 24;
+  std::vector<float> h(up * taps);
+  resample_design_filter(up, down, taps, h.data());
+  auto handle = resample_initialize(up, down, h.data(), h.size());
+  std::vector<float> x(4410, 1.f), result(4410 * up / down + 1);
+  size_t count = resample_process(1, &handle, x.data(), x.size(),
+                                  result.data());
+  EXPECT_EQ(4800u, count);
+  for (size_t i = taps * 2; i < count; i++) {
+    ASSERT_NEAR(1.f, result[i], 2e-3f) << i;
+  }
+  resample_reset(&handle);
+  for (size_t i = 0; i < x.size(); i++) {
+    x[i] = sinf(2 * M_PI * 1000 * i / 44100);
+  }
+  count = resample_process(1, &handle, x.data(), x.size(), result.data());
+  // The group delay is (up * taps - 1) / 2 at the upsampled rate
+  double delay = (up * taps - 1) / 2.0 / up;
+  for (size_t i = taps * 2; i < count; i++) {
+    double t = i * static_cast<double>(down) / up - delay;
+    ASSERT_NEAR(sin(2 * M_PI * 1000 * t / 44100), result[i], 5e-3) << i;
+  }
+  resample_finalize(&handle);
+}
+
+#include "tests/google/src/gtest_main.cc"
@@ -0,0 +1,149 @@
+/*! @file sliding.cc
+ *  @brief Tests for the statistics over the sliding window.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <gtest/gtest.h>
+#include <simd/detect_peaks.h>
+#include <simd/sliding.h>
+
+namespace {
+
+std::vector<float> Signal(size_t length) {
+  std::vector<float> signal(length);
+  for (size_t i = 0; i < length; i++) {
+    signal[i] = sinf(i * 0.05f) * 10 + (i * 7919 % 13) * 0.3f + 100;
+  }
+  return signal;
+}
+
+/// @brief Pushes x in the blocks of blockLength samples.
+void Process(bool simd, int window, const std::vector<float> &x,
+             size_t blockLength, std::vector<float> *min,
+             std::vector<float> *max, std::vector<float> *mean,
+             std::vector<float> *variance) {
+  min->resize(x.size());
+  max->resize(x.size());
+  mean->resize(x.size());
+  variance->resize(x.size());
+  auto stats = sliding_stats_initialize(window);
+  for (size_t i = 0; i < x.size(); i += blockLength) {
+    size_t length = std::min(blockLength, x.size() - i);
+    sliding_stats_process(simd, &stats, x.data() + i, length,
+                          min->data() + i, max->data() + i,
+                          mean->data() + i, variance->data() + i);
+  }
+  sliding_stats_finalize(&stats);
+}
+
+}  // namespace
+
+TEST(Sliding, Process) {
+  auto x = Signal(5000);
+  for (int window : { 1, 7, 64, 1000 }) {
+    for (size_t blockLength : { 1u, 13u, 300u, 5000u }) {
+      for (bool simd : { false, true }) {
+        std::vector<float> min, max, mean, variance;
+        Process(simd, window, x, blockLength, &min, &max, &mean, &variance);
+        for (size_t i = 0; i < x.size(); i++) {
+          size_t begin = i + 1 >= static_cast<size_t>(window)?
+              i + 1 - window : 0;
+          double sum = 0, sumSquares = 0;
+          for (size_t j = begin; j <= i; j++) {
+            sum += x[j];
+          }
+          double m = sum / (i + 1 - begin);
+          for (size_t j = begin; j <= i; j++) {
+            sumSquares += (x[j] - m) * (x[j] - m);
+          }
+          double v = sumSquares / (i + 1 - begin);
+          ASSERT_EQ(*std::min_element(&x[begin], &x[i] + 1), min[i])
+              << window << " " << blockLength << " " << i;
+          ASSERT_EQ(*std::max_element(&x[begin], &x[i] + 1), max[i])
+              << window << " " << blockLength << " " << i;
+          ASSERT_NEAR(m, mean[i], 1e-4)
+              << window << " " << blockLength << " " << i;
+          ASSERT_NEAR(v, variance[i], 1e-4 * (1 + v))
+              << window << " " << blockLength << " " << i;
+        }
+      }
+    }
+  }
+}
+
+TEST(Sliding, Blocks) {
+  // The running sums do not depend on the way the signal is split
+  auto x = Signal(3000);
+  std::vector<float> min, max, mean, variance;
+  Process(true, 100, x, x.size(), &min, &max, &mean, &variance);
+  for (size_t blockLength : { 1u, 5u, 255u, 257u }) {
+    std::vector<float> bmin, bmax, bmean, bvariance;
+    Process(true, 100, x, blockLength, &bmin, &bmax, &bmean, &bvariance);
+    EXPECT_EQ(min, bmin);
+    EXPECT_EQ(max, bmax);
+    EXPECT_EQ(mean, bmean);
+    EXPECT_EQ(variance, bvariance);
+  }
+}
+
+TEST(Sliding, Reset) {
+  auto x = Signal(500);
+  std::vector<float> min, max, mean, variance;
+  Process(false, 50, x, x.size(), &min, &max, &mean, &variance);
+  auto stats = sliding_stats_initialize(50);
+  std::vector<float> other(300, -1000.f), rmean(x.size());
+  sliding_stats_process(false, &stats, other.data(), other.size(), nullptr,
+                        nullptr, rmean.data(), nullptr);
+  sliding_stats_reset(&stats);
+  sliding_stats_process(false, &stats, x.data(), x.size(), nullptr, nullptr,
+                        rmean.data(), nullptr);
+  sliding_stats_finalize(&stats);
+  EXPECT_EQ(mean, rmean);
+}
+
+TEST(Sliding, DetectPeaks) {
+  // Only the spikes stand out of the slow wave
+  const size_t length = 20000;
+  std::vector<float> x(length);
+  for (size_t i = 0; i < length; i++) {
+    x[i] = sinf(i * 0.3f) * 0.1f;
+  }
+  std::vector<int> spikes;
+  for (int s : { 700, 1023, 1024 + 255, 4000, 9999, 10300, 19990 }) {
+    x[s] = (s % 2 == 0)? 5.f : -5.f;
+    spikes.push_back(s);
+  }
+  for (size_t blockLength : { 1u, 3u, 77u, 256u, 1000u, 20000u }) {
+    auto stats = sliding_stats_initialize(200);
+    std::vector<ExtremumPoint> buffer(4096);
+    DetectPeaksStream stream;
+    detect_peaks_stream_initialize(&stream, kExtremumTypeBoth, buffer.data(),
+                                   buffer.size());
+    for (size_t i = 0; i < length; i += blockLength) {
+      sliding_stats_detect_peaks(true, &stats, 3, &stream, x.data() + i,
+                                 std::min(blockLength, length - i));
+    }
+    std::vector<ExtremumPoint> points(stream.count);
+    ASSERT_EQ(spikes.size(), detect_peaks_stream_pop(&stream, points.data(),
+                                                     points.size()))
+        << blockLength;
+    for (size_t k = 0; k < spikes.size(); k++) {
+      EXPECT_EQ(spikes[k], points[k].position) << blockLength;
+      EXPECT_EQ(x[spikes[k]], points[k].value) << blockLength;
+    }
+    EXPECT_EQ(0u, stream.lost);
+    sliding_stats_finalize(&stats);
+  }
+}
+
+#include "tests/google/src/gtest_main.cc"
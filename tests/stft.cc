@@ -0,0 +1,182 @@
+/*! @file stft.cc
+ *  @brief Tests for the short-time Fourier transform.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ *
+ *  @section License
+ *  Licensed to the Apache Software Foundation (ASF) under one
+ *  or more contributor license agreements.  See the NOTICE file
+ *  distributed with this work for additional information
+ *  regarding copyright ownership.  The ASF licenses this file
+ *  to you under the Apache License, Version 2.0 (the
+ *  "License"); you may not use this file except in compliance
+ *  with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an
+ *  "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *  KIND, either express or implied.  See the License for the
+ *  specific language governing permissions and limitations
+ *  under the License.
+ */
+
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <simd/stft.h>
+
+static std::vector<float> test_signal(size_t length) {
+  std::vector<float> x(length);
+  for (size_t i = 0; i < length; i++) {
+    x[i] = sinf(i * 0.21f) + 0.4f * cosf(i * 1.3f + 0.5f) + 0.1f;
+  }
+  return x;
+}
+
+/// @brief The power spectrum of the Hann windowed frame, by the naive DFT.
+static std::vector<double> power_reference(const float *frame,
+                                           int windowLength, int fftSize) {
+  std::vector<double> power(fftSize / 2 + 1);
+  for (int k = 0; k <= fftSize / 2; k++) {
+    double re = 0, im = 0;
+    for (int n = 0; n < windowLength; n++) {
+      double w = 0.5 - 0.5 * cos(2 * M_PI * n / windowLength);
+      double angle = -2 * M_PI * ((k * n) % fftSize) / fftSize;
+      re += w * frame[n] * cos(angle);
+      im += w * frame[n] * sin(angle);
+    }
+    power[k] = re * re + im * im;
+  }
+  return power;
+}
+
+TEST(stft, stft_process) {
+  const int windowLength = 100, hop = 37, fftSize = 128;
+  auto x = test_signal(1500);
+  const STFTOutput outputs[] = { kSTFTOutputComplex, kSTFTOutputMagnitude,
+                                 kSTFTOutputPower, kSTFTOutputLogPower };
+  for (auto output : outputs) {
+    for (int simd : { 0, 1 }) {
+      auto handle = stft_initialize(nullptr, windowLength, hop, fftSize,
+                                    output);
+      size_t frames = stft_frames(&handle, x.size());
+      ASSERT_EQ((x.size() - windowLength) / hop + 1, frames);
+      size_t frameSize = stft_frame_size(&handle);
+      std::vector<float> result(frames * frameSize);
+      ASSERT_EQ(frames, stft_process(simd, &handle, x.data(), x.size(),
+                                     result.data()));
+      for (size_t f = 0; f < frames; f++) {
+        auto power = power_reference(x.data() + f * hop, windowLength,
+                                     fftSize);
+        const float *row = result.data() + f * frameSize;
+        for (int k = 0; k <= fftSize / 2; k++) {
+          switch (output) {
+            case kSTFTOutputComplex:
+              ASSERT_NEAR(power[k], row[2 * k] * row[2 * k] +
+                          row[2 * k + 1] * row[2 * k + 1],
+                          1e-3 * (power[k] + 1)) << f << " " << k;
+              break;
+            case kSTFTOutputMagnitude:
+              ASSERT_NEAR(sqrt(power[k]), row[k], 1e-3) << f << " " << k;
+              break;
+            case kSTFTOutputPower:
+              ASSERT_NEAR(power[k], row[k], 1e-3 * (power[k] + 1))
+                  << f << " " << k;
+              break;
+            default:
+              ASSERT_NEAR(log(power[k] + STFT_LOG_FLOOR), row[k],
+                          2e-3 / (power[k] + 1e-3) + 1e-4)
+                  << f << " " << k;
+              break;
+          }
+        }
+      }
+      stft_finalize(&handle);
+    }
+  }
+}
+
+TEST(stft, log_mel) {
+  const int windowLength = 400, hop = 160, fftSize = 512, bands = 40;
+  const float rate = 16000, fmin = 20, fmax = 8000;
+  auto x = test_signal(4000);
+  auto handle = stft_initialize_log_mel(nullptr, windowLength, hop, fftSize,
+                                        bands, rate, fmin, fmax);
+  ASSERT_EQ(static_cast<size_t>(bands), stft_frame_size(&handle));
+  size_t frames = stft_frames(&handle, x.size());
+  std::vector<float> result(frames * bands);
+  stft_process(1, &handle, x.data(), x.size(), result.data());
+  stft_finalize(&handle);
+
+  auto mel = [](double f) { return 2595 * log10(1 + f / 700); };
+  auto hz = [](double m) { return 700 * (pow(10, m / 2595) - 1); };
+  std::vector<double> edges(bands + 2);
+  for (int i = 0; i < bands + 2; i++) {
+    edges[i] = hz(mel(fmin) + (mel(fmax) - mel(fmin)) * i / (bands + 1));
+  }
+  for (size_t f = 0; f < frames; f++) {
+    auto power = power_reference(x.data() + f * hop, windowLength, fftSize);
+    for (int b = 0; b < bands; b++) {
+      double sum = 0;
+      for (int k = 0; k <= fftSize / 2; k++) {
+        double freq = k * rate / fftSize;
+        double w = std::min((freq - edges[b]) / (edges[b + 1] - edges[b]),
+                            (edges[b + 2] - freq) /
+                            (edges[b + 2] - edges[b + 1]));
+        if (w > 0) {
+          sum += w * power[k];
+        }
+      }
+      ASSERT_NEAR(log(sum + STFT_LOG_FLOOR), result[f * bands + b],
+                  1e-3 / (sum + 1e-3) + 1e-4) << f << " " << b;
+    }
+  }
+}
+
+TEST(stft, stft_stream) {
+  const int configs[][3] = { { 100, 37, 128 }, { 64, 64, 64 },
+                             { 50, 80, 64 }, { 256, 1, 256 } };
+  const size_t blocks[] = { 1, 13, 100, 7, 300, 0, 64, 5, 1000, 33 };
+  auto x = test_signal(2000);
+  for (auto& config : configs) {
+    auto handle = stft_initialize(nullptr, config[0], config[1], config[2],
+                                  kSTFTOutputPower);
+    size_t frameSize = stft_frame_size(&handle);
+    std::vector<float> reference(stft_frames(&handle, x.size()) * frameSize);
+    stft_process(1, &handle, x.data(), x.size(), reference.data());
+
+    std::vector<float> streamed;
+    size_t offset = 0;
+    for (int pass = 0; offset < x.size(); pass++) {
+      size_t length = std::min(blocks[pass % 10], x.size() - offset);
+      size_t frames = stft_stream_frames(&handle, length);
+      std::vector<float> result(frames * frameSize + 1);
+      ASSERT_EQ(frames, stft_stream(1, &handle, x.data() + offset, length,
+                                    result.data()));
+      streamed.insert(streamed.end(), result.begin(),
+                      result.begin() + frames * frameSize);
+      offset += length;
+    }
+    ASSERT_EQ(reference.size(), streamed.size()) << config[0];
+    for (size_t i = 0; i < reference.size(); i++) {
+      ASSERT_NEAR(reference[i], streamed[i], 1e-4f * (reference[i] + 1))
+          << config[0] << " " << i;
+    }
+    stft_reset(&handle);
+    ASSERT_EQ(0u, stft_stream_frames(&handle, config[0] - 1));
+    ASSERT_EQ(1u, stft_stream_frames(&handle, config[0]));
+    stft_finalize(&handle);
+  }
+}
+
+#include "tests/google/src/gtest_main.cc"
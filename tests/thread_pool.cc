@@ -0,0 +1,262 @@
+/*! @file thread_pool.cc
+ *  @brief Thread pool unit tests.
+ *  @author Markovtsev Vadim <v.markovtsev@samsung.com>
+ *  @version 1.0
+ *
+ *  @section Notes
+ *  This code partially conforms to <a href="http://google-styleguide.googlecode.com/svn/trunk/cppguide.xml">Google C++ Style Guide</a>.
+ *
+ *  @section Copyright
+ *  Copyright © 2013 Samsung R&D Institute Russia
+ */
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <simd/thread_pool.h>
+
+namespace {
+
+struct Job {
+  std::vector<std::atomic<int>> calls;
+  std::mutex lock;
+  std::set<std::thread::id> threads;
+
+  explicit Job(int count) : calls(count) {
+    for (auto& c : calls) {
+      c = 0;
+    }
+  }
+
+  static void Run(void *arg, int index) {
+    auto job = reinterpret_cast<Job *>(arg);
+    job->calls[index]++;
+    std::lock_guard<std::mutex> guard(job->lock);
+    job->threads.insert(std::this_thread::get_id());
+    // Give the other threads the chance to pick up the tasks
+    std::this_thread::yield();
+  }
+};
+
+struct ExternalPool {
+  int runs = 0;
+  int threads = 0;
+
+  static void Execute(void *context, int count, int threads,
+                      ThreadPoolTask task, void *arg) {
+    auto pool = reinterpret_cast<ExternalPool *>(context);
+    pool->runs++;
+    pool->threads = threads;
+    for (int i = 0; i < count; i++) {
+      task(arg, i);
+    }
+  }
+};
+
+struct Counters {
+  std::atomic<int> jobs;
+  std::atomic<int> done;
+  ThreadPool *pool;
+  ThreadPoolWaitGroup *group;
+
+  Counters() : jobs(0), done(0), pool(nullptr), group(nullptr) {
+  }
+
+  static void Run(void *arg) {
+    reinterpret_cast<Counters *>(arg)->jobs++;
+  }
+
+  static void Done(void *arg) {
+    reinterpret_cast<Counters *>(arg)->done++;
+  }
+
+  /// Submits two children to the same group
+  static void Spawn(void *arg) {
+    auto counters = reinterpret_cast<Counters *>(arg);
+    counters->jobs++;
+    for (int i = 0; i < 2; i++) {
+      thread_pool_submit(counters->pool, counters->group, Run, Done, arg);
+    }
+  }
+
+  /// Runs a parallel loop from inside a job
+  static void Nested(void *arg) {
+    auto counters = reinterpret_cast<Counters *>(arg);
+    Job job(16);
+    thread_pool_run(counters->pool, 16, 0, Job::Run, &job);
+    for (int i = 0; i < 16; i++) {
+      if (job.calls[i] == 1) {
+        counters->jobs++;
+      }
+    }
+  }
+};
+
+}  // namespace
+
+TEST(ThreadPool, Run) {
+  ThreadPool *pool = thread_pool_create(4);
+  ASSERT_NE(nullptr, pool);
+  EXPECT_EQ(4, thread_pool_size(pool));
+  for (int repeat = 0; repeat < 100; repeat++) {
+    Job job(37);
+    thread_pool_run(pool, 37, 0, Job::Run, &job);
+    for (int i = 0; i < 37; i++) {
+      ASSERT_EQ(1, job.calls[i]) << repeat << " " << i;
+    }
+    EXPECT_LE(job.threads.size(), 4u);
+  }
+  Job empty(1);
+  thread_pool_run(pool, 0, 0, Job::Run, &empty);
+  EXPECT_EQ(0, empty.calls[0]);
+  thread_pool_destroy(pool);
+}
+
+TEST(ThreadPool, Limit) {
+  ThreadPool *pool = thread_pool_create(4);
+  ASSERT_NE(nullptr, pool);
+  for (int threads = 1; threads <= 4; threads++) {
+    Job job(64);
+    thread_pool_run(pool, 64, threads, Job::Run, &job);
+    for (int i = 0; i < 64; i++) {
+      ASSERT_EQ(1, job.calls[i]) << threads << " " << i;
+    }
+    EXPECT_LE(job.threads.size(), static_cast<size_t>(threads));
+  }
+  Job job(8);
+  thread_pool_run(pool, 8, 1, Job::Run, &job);
+  ASSERT_EQ(1u, job.threads.size());
+  EXPECT_EQ(std::this_thread::get_id(), *job.threads.begin());
+  thread_pool_destroy(pool);
+}
+
+TEST(ThreadPool, Concurrent) {
+  ThreadPool *pool = thread_pool_create(3);
+  ASSERT_NE(nullptr, pool);
+  std::vector<std::thread> callers;
+  std::atomic<int> errors(0);
+  for (int t = 0; t < 4; t++) {
+    callers.emplace_back([pool, &errors]() {
+      for (int repeat = 0; repeat < 20; repeat++) {
+        Job job(15);
+        thread_pool_run(pool, 15, 0, Job::Run, &job);
+        for (int i = 0; i < 15; i++) {
+          if (job.calls[i] != 1) {
+            errors++;
+          }
+        }
+      }
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+  EXPECT_EQ(0, errors);
+  thread_pool_destroy(pool);
+}
+
+TEST(ThreadPool, External) {
+  ExternalPool external;
+  ThreadPool *pool = thread_pool_create_external(
+      6, ExternalPool::Execute, &external);
+  ASSERT_NE(nullptr, pool);
+  EXPECT_EQ(6, thread_pool_size(pool));
+  Job job(10);
+  thread_pool_run(pool, 10, 2, Job::Run, &job);
+  EXPECT_EQ(1, external.runs);
+  EXPECT_EQ(2, external.threads);
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(1, job.calls[i]) << i;
+  }
+  thread_pool_run(pool, 10, 0, Job::Run, &job);
+  EXPECT_EQ(6, external.threads);
+  thread_pool_destroy(pool);
+}
+
+TEST(ThreadPool, Default) {
+  ThreadPool *pool = thread_pool_default();
+  ASSERT_NE(nullptr, pool);
+  EXPECT_EQ(pool, thread_pool_default());
+  EXPECT_GE(thread_pool_size(pool), 1);
+  Job job(5);
+  thread_pool_run(pool, 5, 0, Job::Run, &job);
+  for (int i = 0; i < 5; i++) {
+    ASSERT_EQ(1, job.calls[i]) << i;
+  }
+}
+
+TEST(ThreadPool, Submit) {
+  ThreadPool *pool = thread_pool_create(4);
+  ASSERT_NE(nullptr, pool);
+  ThreadPoolWaitGroup *group = thread_pool_wait_group_create();
+  ASSERT_NE(nullptr, group);
+  EXPECT_EQ(0, thread_pool_wait_group_pending(group));
+  Counters counters;
+  for (int i = 0; i < 1000; i++) {
+    thread_pool_submit(pool, group, Counters::Run, Counters::Done,
+                       &counters);
+  }
+  thread_pool_submit(pool, nullptr, Counters::Run, nullptr, &counters);
+  thread_pool_wait(pool, group);
+  EXPECT_EQ(0, thread_pool_wait_group_pending(group));
+  EXPECT_EQ(1000, counters.done);
+  EXPECT_GE(counters.jobs, 1000);
+  // Waiting for the empty group returns at once
+  thread_pool_wait(pool, group);
+  thread_pool_wait_group_destroy(group);
+  thread_pool_destroy(pool);
+}
+
+TEST(ThreadPool, SubmitNested) {
+  ThreadPool *pool = thread_pool_create(3);
+  ASSERT_NE(nullptr, pool);
+  ThreadPoolWaitGroup *group = thread_pool_wait_group_create();
+  ASSERT_NE(nullptr, group);
+  Counters counters;
+  counters.pool = pool;
+  counters.group = group;
+  for (int i = 0; i < 50; i++) {
+    thread_pool_submit(pool, group, Counters::Spawn, nullptr, &counters);
+  }
+  thread_pool_wait(pool, group);
+  EXPECT_EQ(150, counters.jobs);
+  EXPECT_EQ(100, counters.done);
+
+  Counters nested;
+  nested.pool = pool;
+  for (int i = 0; i < 8; i++) {
+    thread_pool_submit(pool, group, Counters::Nested, nullptr, &nested);
+  }
+  thread_pool_wait(pool, group);
+  EXPECT_EQ(8 * 16, nested.jobs);
+  thread_pool_wait_group_destroy(group);
+  thread_pool_destroy(pool);
+}
+
+TEST(ThreadPool, SubmitInline) {
+  ThreadPool *single = thread_pool_create(1);
+  ASSERT_NE(nullptr, single);
+  ExternalPool external;
+  ThreadPool *wrapped = thread_pool_create_external(
+      2, ExternalPool::Execute, &external);
+  ASSERT_NE(nullptr, wrapped);
+  ThreadPoolWaitGroup *group = thread_pool_wait_group_create();
+  ASSERT_NE(nullptr, group);
+  for (auto pool : { single, wrapped }) {
+    Counters counters;
+    thread_pool_submit(pool, group, Counters::Run, Counters::Done,
+                       &counters);
+    EXPECT_EQ(1, counters.jobs);
+    EXPECT_EQ(1, counters.done);
+    EXPECT_EQ(0, thread_pool_wait_group_pending(group));
+    thread_pool_wait(pool, group);
+  }
+  thread_pool_wait_group_destroy(group);
+  thread_pool_destroy(wrapped);
+  thread_pool_destroy(single);
+}
+
+#include "tests/google/src/gtest_main.cc"
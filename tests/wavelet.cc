@@ -29,8 +29,13 @@
  */
 
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <vector>
+#include <pthread.h>
 #include <simd/arithmetic.h>
+#include <simd/cpu.h>
 #include <simd/memory.h>
 #include <simd/wavelet.h>
 #define WAVELET_INTERNAL_USE
@@ -47,29 +52,35 @@ TEST(Wavelet, wavelet_prepare_array) {
   for (int i = 0; i < length; i++) {
     array[i] = i;
   }
-  auto res = wavelet_prepare_array(8, array, length);
-
+  // The generic tier keeps the plain copy, see wavelet_prepare_array()
 #ifdef __AVX__
-  ASSERT_EQ(0, align_complement_f32(res));
-  ASSERT_EQ(0, memcmp(array, res, length * sizeof(float)));  // NOLINT(*)
-  int checkSize = (length - 8) * sizeof(float);  // NOLINT(*)
-  ASSERT_EQ(0, memcmp(array + 2, res + length, checkSize));
-  ASSERT_EQ(0, memcmp(array + 4, res + length * 2 - 8, checkSize));
-  ASSERT_EQ(0, memcmp(array + 6, res + length * 3 - 16, checkSize));
+  bool extended = simd_instruction_set() != kInstructionSetNone;
 #else
-  ASSERT_EQ(0, memcmp(res, array, sizeof(array)));
+  bool extended = false;
 #endif
+  int checkSize = (length - 8) * sizeof(float);  // NOLINT(*)
+  auto res = wavelet_prepare_array(8, array, length);
+
+  if (extended) {
+    ASSERT_EQ(0, align_complement_f32(res));
+    ASSERT_EQ(0, memcmp(array, res, length * sizeof(float)));  // NOLINT(*)
+    ASSERT_EQ(0, memcmp(array + 2, res + length, checkSize));
+    ASSERT_EQ(0, memcmp(array + 4, res + length * 2 - 8, checkSize));
+    ASSERT_EQ(0, memcmp(array + 6, res + length * 3 - 16, checkSize));
+  } else {
+    ASSERT_EQ(0, memcmp(res, array, sizeof(array)));
+  }
   free(res);
 
   res = wavelet_prepare_array(4, array, length);
 
-#ifdef __AVX__
-  ASSERT_EQ(0, align_complement_f32(res));
-  ASSERT_EQ(0, memcmp(array, res, length * sizeof(float)));  // NOLINT(*)
-  ASSERT_EQ(0, memcmp(array + 2, res + length, checkSize));
-#else
-  ASSERT_EQ(0, memcmp(res, array, sizeof(array)));
-#endif
+  if (extended) {
+    ASSERT_EQ(0, align_complement_f32(res));
+    ASSERT_EQ(0, memcmp(array, res, length * sizeof(float)));  // NOLINT(*)
+    ASSERT_EQ(0, memcmp(array + 2, res + length, checkSize));
+  } else {
+    ASSERT_EQ(0, memcmp(res, array, sizeof(array)));
+  }
   free(res);
 }
 
@@ -112,6 +123,29 @@ TEST(Wavelet, wavelet_apply_na) {
    }
 }
 
+TEST(Wavelet, wavelet_apply_plain) {
+  const int length = 202;
+  // Deliberately misaligned by one float
+  std::vector<float> buffer(length + 1), hi(length / 2 + 1), lo(length / 2 + 1);
+  float *src = buffer.data() + 1;
+  for (int i = 0; i < length; i++) {
+    src[i] = sinf(i * 0.1f) + cosf(i * 0.013f) * 3;
+  }
+  float refhi[length / 2], reflo[length / 2];
+  for (int order = 2; order <= 24; order += 2) {
+    for (auto ext : { EXTENSION_TYPE_PERIODIC, EXTENSION_TYPE_MIRROR }) {
+      wavelet_apply_na(WAVELET_TYPE_DAUBECHIES, order, ext, src, length,
+                       refhi, reflo);
+      wavelet_apply_plain(WAVELET_TYPE_DAUBECHIES, order, ext, src, length,
+                          hi.data() + 1, lo.data() + 1);
+      for (int i = 0; i < length / 2; i++) {
+        ASSERT_EQF(refhi[i], hi[i + 1]) << order << " " << ext << " " << i;
+        ASSERT_EQF(reflo[i], lo[i + 1]) << order << " " << ext << " " << i;
+      }
+    }
+  }
+}
+
 TEST(Wavelet, stationary_wavelet_apply_na) {
   int length = 32;
   float array[length], desthi1[length], desthi2[length], destlo[length];
@@ -258,11 +292,20 @@ INSTANTIATE_TEST_CASE_P(
                           EXTENSION_TYPE_CONSTANT, EXTENSION_TYPE_ZERO)
     ));
 
+INSTANTIATE_TEST_CASE_P(
+    DaubechiesAndSymletsUniversal, WaveletTest,
+    ::testing::Combine(
+        ::testing::Values(WAVELET_TYPE_DAUBECHIES, WAVELET_TYPE_SYMLET),
+        ::testing::Values(10, 14, 20, 40),
+        ::testing::Values(EXTENSION_TYPE_PERIODIC, EXTENSION_TYPE_MIRROR,
+                          EXTENSION_TYPE_CONSTANT, EXTENSION_TYPE_ZERO)
+    ));
+
 INSTANTIATE_TEST_CASE_P(
     Coiflets, WaveletTest,
     ::testing::Combine(
         ::testing::Values(WAVELET_TYPE_COIFLET),
-        ::testing::Values(6, 12),
+        ::testing::Values(6, 12, 18, 24, 30),
         ::testing::Values(EXTENSION_TYPE_PERIODIC, EXTENSION_TYPE_MIRROR,
                           EXTENSION_TYPE_CONSTANT, EXTENSION_TYPE_ZERO)
     ));
@@ -277,16 +320,559 @@ INSTANTIATE_TEST_CASE_P(
                           EXTENSION_TYPE_CONSTANT, EXTENSION_TYPE_ZERO)
     ));
 
+INSTANTIATE_TEST_CASE_P(
+    DaubechiesAndSymletsDilated, StationaryWaveletTest,
+    ::testing::Combine(
+        ::testing::Values(WAVELET_TYPE_DAUBECHIES, WAVELET_TYPE_SYMLET),
+        ::testing::Values(4, 8, 20),
+        ::testing::Values(5, 6, 7),
+        ::testing::Values(EXTENSION_TYPE_PERIODIC, EXTENSION_TYPE_MIRROR,
+                          EXTENSION_TYPE_CONSTANT, EXTENSION_TYPE_ZERO)
+    ));
+
 INSTANTIATE_TEST_CASE_P(
     Coiflets, StationaryWaveletTest,
     ::testing::Combine(
         ::testing::Values(WAVELET_TYPE_COIFLET),
         ::testing::Values(6, 12),
-        ::testing::Values(1, 2),
+        ::testing::Values(1, 2, 3),
         ::testing::Values(EXTENSION_TYPE_PERIODIC, EXTENSION_TYPE_MIRROR,
                           EXTENSION_TYPE_CONSTANT, EXTENSION_TYPE_ZERO)
     ));
 
+TEST(Wavelet, wavelet_decompose) {
+  const int length = 512, levels = 5;
+  float array[length], coeffs[length];
+  for (int i = 0; i < length; i++) {
+    array[i] = sinf(i * 0.1f) + cosf(i * 0.013f);
+  }
+  const int orders[] = { 2, 4, 8, 12, 16 };
+  for (int order : orders) {
+    wavelet_decompose(WAVELET_TYPE_DAUBECHIES, order, EXTENSION_TYPE_MIRROR,
+                      levels, array, length, coeffs);
+    // Chain the plain levels by hand
+    std::vector<float> src(array, array + length);
+    for (int level = 1; level <= levels; level++) {
+      int half = length >> level;
+      std::vector<float> hi(half), lo(half);
+      wavelet_apply_na(WAVELET_TYPE_DAUBECHIES, order, EXTENSION_TYPE_MIRROR,
+                       src.data(), half * 2, hi.data(), lo.data());
+      for (int i = 0; i < half; i++) {
+        ASSERT_EQF(hi[i], coeffs[half + i]) << order << " " << level;
+      }
+      src = lo;
+    }
+    for (int i = 0; i < (length >> levels); i++) {
+      ASSERT_NEAR(src[i], coeffs[i], 0.005f) << order << " " << i;
+    }
+  }
+}
+
+TEST(Wavelet, stationary_wavelet_decompose) {
+  const int length = 256;
+  float array[length];
+  for (int i = 0; i < length; i++) {
+    array[i] = sinf(i * 0.1f) + cosf(i * 0.013f);
+  }
+  for (int levels = 1; levels <= 4; levels++) {
+    std::vector<float> coeffs((levels + 1) * length);
+    stationary_wavelet_decompose(WAVELET_TYPE_SYMLET, 4,
+                                 EXTENSION_TYPE_PERIODIC, levels, array,
+                                 length, coeffs.data());
+    std::vector<float> src(array, array + length), hi(length), lo(length);
+    for (int level = 1; level <= levels; level++) {
+      stationary_wavelet_apply_na(WAVELET_TYPE_SYMLET, 4, level,
+                                  EXTENSION_TYPE_PERIODIC, src.data(), length,
+                                  hi.data(), lo.data());
+      const float *detail = &coeffs[(levels - level + 1) * length];
+      for (int i = 0; i < length; i++) {
+        ASSERT_EQF(hi[i], detail[i]) << levels << " " << level << " " << i;
+      }
+      src = lo;
+    }
+    for (int i = 0; i < length; i++) {
+      ASSERT_EQF(src[i], coeffs[i]) << levels << " " << i;
+    }
+  }
+}
+
+TEST(Wavelet, inverse_wavelet_apply) {
+  const int length = 256;
+  std::vector<float> src(length), hi(length / 2), lo(length / 2);
+  std::vector<float> dest(length), valid(length);
+  for (int i = 0; i < length; i++) {
+    src[i] = sinf(i * 0.1f) + cosf(i * 0.013f) * 3;
+  }
+  for (auto type : { WAVELET_TYPE_DAUBECHIES, WAVELET_TYPE_SYMLET,
+                     WAVELET_TYPE_COIFLET }) {
+    for (int order : { 2, 4, 6, 8, 12, 16, 20, 30 }) {
+      if (!wavelet_validate_order(type, order)) {
+        continue;
+      }
+      wavelet_apply_na(type, order, EXTENSION_TYPE_PERIODIC, src.data(),
+                       length, hi.data(), lo.data());
+      inverse_wavelet_apply_na(type, order, hi.data(), lo.data(), length,
+                               valid.data());
+      inverse_wavelet_apply(type, order, hi.data(), lo.data(), length,
+                            dest.data());
+      for (int i = 0; i < length; i++) {
+        ASSERT_NEAR(src[i], valid[i], 0.001f) << type << " " << order << " "
+                                              << i;
+        ASSERT_EQF(valid[i], dest[i]) << type << " " << order << " " << i;
+      }
+      // Only the ends depend on the extension
+      wavelet_apply_na(type, order, EXTENSION_TYPE_MIRROR, src.data(),
+                       length, hi.data(), lo.data());
+      inverse_wavelet_apply(type, order, hi.data(), lo.data(), length,
+                            dest.data());
+      for (int i = order - 2; i < length - order + 2; i++) {
+        ASSERT_NEAR(src[i], dest[i], 0.001f) << type << " " << order << " "
+                                             << i;
+      }
+    }
+  }
+}
+
+TEST(Wavelet, wavelet_recompose) {
+  const int length = 512, levels = 5;
+  std::vector<float> src(length), coeffs(length), dest(length);
+  for (int i = 0; i < length; i++) {
+    src[i] = sinf(i * 0.1f) + cosf(i * 0.013f);
+  }
+  for (int order : { 4, 8, 14 }) {
+    wavelet_decompose(WAVELET_TYPE_DAUBECHIES, order, EXTENSION_TYPE_PERIODIC,
+                      levels, src.data(), length, coeffs.data());
+    wavelet_recompose(WAVELET_TYPE_DAUBECHIES, order, levels, coeffs.data(),
+                      length, dest.data());
+    for (int i = 0; i < length; i++) {
+      ASSERT_NEAR(src[i], dest[i], 0.001f) << order << " " << i;
+    }
+  }
+}
+
+TEST(Wavelet, inverse_stationary_wavelet_apply) {
+  const int length = 256;
+  std::vector<float> src(length), hi(length), lo(length);
+  std::vector<float> dest(length), valid(length);
+  for (int i = 0; i < length; i++) {
+    src[i] = sinf(i * 0.1f) + cosf(i * 0.013f) * 3;
+  }
+  for (int order : { 2, 8, 12, 20 }) {
+    for (int level = 1; level <= 4; level++) {
+      stationary_wavelet_apply_na(WAVELET_TYPE_SYMLET, order, level,
+                                  EXTENSION_TYPE_PERIODIC, src.data(), length,
+                                  hi.data(), lo.data());
+      inverse_stationary_wavelet_apply_na(WAVELET_TYPE_SYMLET, order, level,
+                                          hi.data(), lo.data(), length,
+                                          valid.data());
+      inverse_stationary_wavelet_apply(WAVELET_TYPE_SYMLET, order, level,
+                                       hi.data(), lo.data(), length,
+                                       dest.data());
+      for (int i = 0; i < length; i++) {
+        ASSERT_NEAR(src[i], valid[i], 0.001f) << order << " " << level
+                                              << " " << i;
+        ASSERT_EQF(valid[i], dest[i]) << order << " " << level << " " << i;
+      }
+    }
+  }
+  std::vector<float> coeffs(5 * length);
+  stationary_wavelet_decompose(WAVELET_TYPE_DAUBECHIES, 6,
+                               EXTENSION_TYPE_PERIODIC, 4, src.data(), length,
+                               coeffs.data());
+  stationary_wavelet_recompose(WAVELET_TYPE_DAUBECHIES, 6, 4, coeffs.data(),
+                               length, dest.data());
+  for (int i = 0; i < length; i++) {
+    ASSERT_NEAR(src[i], dest[i], 0.001f) << i;
+  }
+}
+
+TEST(Wavelet, wavelet_shrink) {
+  const int length = 103;
+  std::vector<float> src(length), dest(length);
+  for (int i = 0; i < length; i++) {
+    src[i] = (i - length / 2) * 0.1f;
+  }
+  const float threshold = 2;
+  for (auto shrinkage : { SHRINKAGE_TYPE_SOFT, SHRINKAGE_TYPE_HARD,
+                          SHRINKAGE_TYPE_GARROTE }) {
+    wavelet_shrink(shrinkage, threshold, src.data(), length, dest.data());
+    for (int i = 0; i < length; i++) {
+      float x = src[i], valid = 0;
+      if (fabsf(x) > threshold) {
+        switch (shrinkage) {
+          case SHRINKAGE_TYPE_SOFT:
+            valid = x > 0? x - threshold : x + threshold;
+            break;
+          case SHRINKAGE_TYPE_HARD:
+            valid = x;
+            break;
+          case SHRINKAGE_TYPE_GARROTE:
+            valid = x - threshold * threshold / x;
+            break;
+        }
+      }
+      ASSERT_EQF(valid, dest[i]) << shrinkage << " " << i;
+    }
+  }
+}
+
+TEST(Wavelet, wavelet_denoise) {
+  const int length = 1024, levels = 4;
+  std::vector<float> clean(length), noisy(length), dest(length);
+  srand(7);
+  for (int i = 0; i < length; i++) {
+    clean[i] = sinf(i * 0.02f) * 4 + (i > length / 3? 2 : 0);
+    noisy[i] = clean[i] + (rand() / (RAND_MAX + 1.f) - 0.5f);
+  }
+  auto error = [&](const std::vector<float>& signal) {
+    double sum = 0;
+    for (int i = 0; i < length; i++) {
+      sum += (signal[i] - clean[i]) * (signal[i] - clean[i]);
+    }
+    return sum;
+  };
+  double noise = error(noisy);
+  for (auto shrinkage : { SHRINKAGE_TYPE_SOFT, SHRINKAGE_TYPE_HARD,
+                          SHRINKAGE_TYPE_GARROTE }) {
+    wavelet_denoise(WAVELET_TYPE_SYMLET, 8, levels, shrinkage, nullptr,
+                    noisy.data(), length, dest.data());
+    EXPECT_LT(error(dest), noise / 2) << shrinkage;
+    stationary_wavelet_denoise(WAVELET_TYPE_SYMLET, 8, levels, shrinkage,
+                               nullptr, noisy.data(), length, dest.data());
+    EXPECT_LT(error(dest), noise / 2) << shrinkage;
+  }
+  // Zero thresholds keep the signal intact
+  const float zeros[levels] = {};
+  wavelet_denoise(WAVELET_TYPE_DAUBECHIES, 6, levels, SHRINKAGE_TYPE_HARD,
+                  zeros, noisy.data(), length, dest.data());
+  for (int i = 0; i < length; i++) {
+    ASSERT_NEAR(noisy[i], dest[i], 0.001f) << i;
+  }
+}
+
+/// @brief Applies the 1D transforms over the rows and then over the
+/// columns, the columns are transposed explicitly.
+static void reference_apply2D(WaveletType type, int order, int level,
+                              ExtensionType ext, const float *src,
+                              int width, int height,
+                              std::vector<float> *subbands) {
+  int ow = level? width : width / 2, oh = level? height : height / 2;
+  std::vector<float> low(ow * height), high(ow * height);
+  for (int y = 0; y < height; y++) {
+    if (level) {
+      stationary_wavelet_apply_na(type, order, level, ext, src + y * width,
+                                  width, &high[y * ow], &low[y * ow]);
+    } else {
+      wavelet_apply_na(type, order, ext, src + y * width, width,
+                       &high[y * ow], &low[y * ow]);
+    }
+  }
+  std::vector<float> column(height), hi(oh), lo(oh);
+  const std::vector<float> *planes[] = { &low, &high };
+  for (int p = 0; p < 2; p++) {
+    for (int x = 0; x < ow; x++) {
+      for (int y = 0; y < height; y++) {
+        column[y] = (*planes[p])[y * ow + x];
+      }
+      if (level) {
+        stationary_wavelet_apply_na(type, order, level, ext, column.data(),
+                                    height, hi.data(), lo.data());
+      } else {
+        wavelet_apply_na(type, order, ext, column.data(), height,
+                         hi.data(), lo.data());
+      }
+      for (int y = 0; y < oh; y++) {
+        subbands[p * 2][y * ow + x] = lo[y];
+        subbands[p * 2 + 1][y * ow + x] = hi[y];
+      }
+    }
+  }
+}
+
+TEST(Wavelet, wavelet_apply2D) {
+  const int width = 300, height = 38, stride = 304;
+  std::vector<uint8_t> image8(stride * height);
+  std::vector<float> image(stride * height), plain(width * height);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      image8[y * stride + x] = (x * 7 + y * 13 + x * y) % 251;
+      image[y * stride + x] = image8[y * stride + x];
+      plain[y * width + x] = image8[y * stride + x];
+    }
+  }
+  const ExtensionType exts[] = { EXTENSION_TYPE_PERIODIC, EXTENSION_TYPE_MIRROR,
+                                 EXTENSION_TYPE_CONSTANT, EXTENSION_TYPE_ZERO };
+  const struct { WaveletType type; int order; } wavelets[] = {
+    { WAVELET_TYPE_DAUBECHIES, 2 }, { WAVELET_TYPE_DAUBECHIES, 8 },
+    { WAVELET_TYPE_SYMLET, 10 }, { WAVELET_TYPE_COIFLET, 6 }
+  };
+  for (auto wavelet : wavelets) {
+    for (auto ext : exts) {
+      for (int level = 0; level <= 2; level++) {
+        int ow = level? width : width / 2, oh = level? height : height / 2;
+        int dst_stride = ow + 3;
+        std::vector<float> reference[4], subbands[4];
+        for (int i = 0; i < 4; i++) {
+          reference[i].resize(ow * oh);
+          subbands[i].resize(dst_stride * oh);
+        }
+        reference_apply2D(wavelet.type, wavelet.order, level, ext,
+                          plain.data(), width, height, reference);
+        for (int u8 = 0; u8 < 2; u8++) {
+          if (level) {
+            if (u8) {
+              stationary_wavelet_apply2D_uint8(
+                  wavelet.type, wavelet.order, level, ext, image8.data(),
+                  stride, width, height, subbands[0].data(),
+                  subbands[1].data(), subbands[2].data(), subbands[3].data(),
+                  dst_stride);
+            } else {
+              stationary_wavelet_apply2D(
+                  wavelet.type, wavelet.order, level, ext, image.data(),
+                  stride, width, height, subbands[0].data(),
+                  subbands[1].data(), subbands[2].data(), subbands[3].data(),
+                  dst_stride);
+            }
+          } else if (u8) {
+            wavelet_apply2D_uint8(wavelet.type, wavelet.order, ext,
+                                  image8.data(), stride, width, height,
+                                  subbands[0].data(), subbands[1].data(),
+                                  subbands[2].data(), subbands[3].data(),
+                                  dst_stride);
+          } else {
+            wavelet_apply2D(wavelet.type, wavelet.order, ext, image.data(),
+                            stride, width, height, subbands[0].data(),
+                            subbands[1].data(), subbands[2].data(),
+                            subbands[3].data(), dst_stride);
+          }
+          for (int i = 0; i < 4; i++) {
+            for (int y = 0; y < oh; y++) {
+              for (int x = 0; x < ow; x++) {
+                float ref = reference[i][y * ow + x];
+                ASSERT_NEAR(ref, subbands[i][y * dst_stride + x],
+                            std::max(1.f, std::abs(ref)) * 1e-4f)
+                    << wavelet.order << " " << ext << " " << level << " "
+                    << u8 << " " << i << " " << x << " " << y;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(Wavelet, wavelet_apply_batch) {
+  const int length = 64, count = 37, half = length / 2;
+  std::vector<float> rows(length * count), interleaved(length * count);
+  for (int s = 0; s < count; s++) {
+    for (int i = 0; i < length; i++) {
+      rows[s * length + i] = sinf(i * 0.1f + s) + cosf(i * 0.013f * s) * 3;
+      interleaved[i * count + s] = rows[s * length + i];
+    }
+  }
+  const ExtensionType exts[] = { EXTENSION_TYPE_PERIODIC, EXTENSION_TYPE_MIRROR,
+                                 EXTENSION_TYPE_CONSTANT, EXTENSION_TYPE_ZERO };
+  const struct { WaveletType type; int order; } wavelets[] = {
+    { WAVELET_TYPE_DAUBECHIES, 8 }, { WAVELET_TYPE_SYMLET, 20 },
+    { WAVELET_TYPE_COIFLET, 6 }
+  };
+  for (auto wavelet : wavelets) {
+    for (auto ext : exts) {
+      std::vector<float> hi(half * count), lo(half * count);
+      std::vector<float> ihi(half * count), ilo(half * count);
+      wavelet_apply_batch(wavelet.type, wavelet.order, ext,
+                          WAVELET_BATCH_LAYOUT_ROWS, rows.data(), length,
+                          count, hi.data(), lo.data());
+      wavelet_apply_batch(wavelet.type, wavelet.order, ext,
+                          WAVELET_BATCH_LAYOUT_INTERLEAVED,
+                          interleaved.data(), length, count,
+                          ihi.data(), ilo.data());
+      float refhi[half], reflo[half];
+      for (int s = 0; s < count; s++) {
+        wavelet_apply_na(wavelet.type, wavelet.order, ext,
+                         &rows[s * length], length, refhi, reflo);
+        for (int i = 0; i < half; i++) {
+          ASSERT_EQF(refhi[i], hi[s * half + i]) << s << " " << i;
+          ASSERT_EQF(reflo[i], lo[s * half + i]) << s << " " << i;
+          ASSERT_EQF(refhi[i], ihi[i * count + s]) << s << " " << i;
+          ASSERT_EQF(reflo[i], ilo[i * count + s]) << s << " " << i;
+        }
+      }
+    }
+  }
+}
+
+TEST(Wavelet, wavelet_handle_apply) {
+  const ExtensionType exts[] = { EXTENSION_TYPE_PERIODIC, EXTENSION_TYPE_MIRROR,
+                                 EXTENSION_TYPE_CONSTANT, EXTENSION_TYPE_ZERO };
+  const struct { WaveletType type; int order; } wavelets[] = {
+    { WAVELET_TYPE_DAUBECHIES, 2 }, { WAVELET_TYPE_DAUBECHIES, 8 },
+    { WAVELET_TYPE_SYMLET, 20 }, { WAVELET_TYPE_COIFLET, 12 }
+  };
+  for (auto wavelet : wavelets) {
+    for (auto ext : exts) {
+      for (int level = 0; level <= 3; level++) {
+        WaveletHandle handle = wavelet_handle_initialize(
+            wavelet.type, wavelet.order, level, ext);
+        for (int length : { 16, 200 }) {
+          std::vector<float> src(length);
+          for (int i = 0; i < length; i++) {
+            src[i] = sinf(i * 0.1f) + cosf(i * 0.013f) * 3;
+          }
+          int outLength = level? length : length / 2;
+          std::vector<float> hi(outLength), lo(outLength);
+          std::vector<float> refhi(outLength), reflo(outLength);
+          wavelet_handle_apply(handle, src.data(), length, hi.data(),
+                               lo.data());
+          if (level) {
+            stationary_wavelet_apply_na(wavelet.type, wavelet.order, level,
+                                        ext, src.data(), length,
+                                        refhi.data(), reflo.data());
+          } else {
+            wavelet_apply_na(wavelet.type, wavelet.order, ext, src.data(),
+                             length, refhi.data(), reflo.data());
+          }
+          for (int i = 0; i < outLength; i++) {
+            ASSERT_EQF(refhi[i], hi[i]) << level << " " << length << " " << i;
+            ASSERT_EQF(reflo[i], lo[i]) << level << " " << length << " " << i;
+          }
+        }
+        wavelet_handle_finalize(handle);
+      }
+    }
+  }
+}
+
+TEST(Wavelet, wavelet_apply_double) {
+  const int length = 202;
+  std::vector<double> src(length);
+  std::vector<float> srcf(length);
+  for (int i = 0; i < length; i++) {
+    src[i] = sin(i * 0.1) + cos(i * 0.013) * 3;
+    srcf[i] = src[i];
+  }
+  for (int order : { 2, 8, 30, 76 }) {
+    for (int level = 0; level <= 3; level++) {
+      int outLength = level? length : length / 2;
+      std::vector<double> hi(outLength), lo(outLength);
+      std::vector<float> hif(outLength), lof(outLength);
+      if (level) {
+        stationary_wavelet_apply_double(WAVELET_TYPE_DAUBECHIES, order, level,
+                                        EXTENSION_TYPE_MIRROR, src.data(),
+                                        length, hi.data(), lo.data());
+        stationary_wavelet_apply_na(WAVELET_TYPE_DAUBECHIES, order, level,
+                                    EXTENSION_TYPE_MIRROR, srcf.data(), length,
+                                    hif.data(), lof.data());
+      } else {
+        wavelet_apply_double(WAVELET_TYPE_DAUBECHIES, order,
+                             EXTENSION_TYPE_MIRROR, src.data(), length,
+                             hi.data(), lo.data());
+        wavelet_apply_na(WAVELET_TYPE_DAUBECHIES, order,
+                         EXTENSION_TYPE_MIRROR, srcf.data(), length,
+                         hif.data(), lof.data());
+      }
+      int step = level? 1 : 2, stride = level? 1 << (level - 1) : 1;
+      for (int i = 0; i < outLength; i++) {
+        // The reference in double with the full precision taps
+        double reflo = 0, refhi = 0;
+        for (int j = 0; j < order; j++) {
+          int index = i * step + j * stride;
+          double value = index < length? src[index] :
+              src[length - 1 - (index - length) % length];
+          double tap = kDaubechiesD[order / 2 - 1][j];
+          reflo += tap * value;
+          refhi += kDaubechiesD[order / 2 - 1][order - j - 1] *
+              ((order - j - 1) & 1? value : -value);
+        }
+        ASSERT_NEAR(reflo, lo[i], 1e-12) << order << " " << level << " " << i;
+        ASSERT_NEAR(refhi, hi[i], 1e-12) << order << " " << level << " " << i;
+        ASSERT_NEAR(lof[i], lo[i], 1e-4) << order << " " << level << " " << i;
+      }
+    }
+  }
+}
+
+namespace {
+
+/// The filter of the high stationary level spans more samples than
+/// the stack of the thread can hold
+void *HighStationaryLevel(void *arg) {
+  const int length = 1000, order = 76, level = 11;
+  std::vector<float> src(length), hi(length), lo(length);
+  std::vector<float> hina(length), lona(length);
+  std::vector<double> srcd(length), hid(length), lod(length);
+  for (int i = 0; i < length; i++) {
+    srcd[i] = src[i] = sinf(i * 0.1f) + (i % 7) * 0.5f;
+  }
+  stationary_wavelet_apply(WAVELET_TYPE_DAUBECHIES, order, level,
+                           EXTENSION_TYPE_PERIODIC, src.data(), length,
+                           hi.data(), lo.data());
+  stationary_wavelet_apply_na(WAVELET_TYPE_DAUBECHIES, order, level,
+                              EXTENSION_TYPE_PERIODIC, src.data(), length,
+                              hina.data(), lona.data());
+  stationary_wavelet_apply_double(WAVELET_TYPE_DAUBECHIES, order, level,
+                                  EXTENSION_TYPE_PERIODIC, srcd.data(), length,
+                                  hid.data(), lod.data());
+  bool *equal = static_cast<bool *>(arg);
+  *equal = true;
+  for (int i = 0; i < length; i++) {
+    *equal = *equal && fabs(hid[i] - hi[i]) < 1e-3 &&
+        fabs(lod[i] - lo[i]) < 1e-3 && fabs(hid[i] - hina[i]) < 1e-3 &&
+        fabs(lod[i] - lona[i]) < 1e-3;
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+TEST(Wavelet, SmallStack) {
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, 256 * 1024);
+  bool equal = false;
+  pthread_t thread;
+  ASSERT_EQ(0, pthread_create(&thread, &attr, HighStationaryLevel, &equal));
+  pthread_join(thread, nullptr);
+  pthread_attr_destroy(&attr);
+  EXPECT_TRUE(equal);
+}
+
+TEST(Wavelet, wavelet_lifting_apply) {
+  ASSERT_FALSE(wavelet_lifting_validate_order(WAVELET_TYPE_DAUBECHIES, 20));
+  const WaveletType types[] = { WAVELET_TYPE_DAUBECHIES, WAVELET_TYPE_SYMLET,
+                                WAVELET_TYPE_COIFLET };
+  const ExtensionType exts[] = { EXTENSION_TYPE_PERIODIC, EXTENSION_TYPE_MIRROR,
+                                 EXTENSION_TYPE_CONSTANT, EXTENSION_TYPE_ZERO };
+  for (auto type : types) {
+    for (int order = 2; order <= 16; order += 2) {
+      if (!wavelet_validate_order(type, order)) {
+        continue;
+      }
+      ASSERT_TRUE(wavelet_lifting_validate_order(type, order)) << order;
+      for (auto ext : exts) {
+        for (int length : { 256, order + order % 4 }) {
+          std::vector<float> data(length);
+          for (int i = 0; i < length; i++) {
+            data[i] = sinf(i * 0.1f) + cosf(i * 0.013f) * 3;
+          }
+          std::vector<float> hi(length / 2), lo(length / 2);
+          wavelet_apply_na(type, order, ext, data.data(), length,
+                           hi.data(), lo.data());
+          wavelet_lifting_apply(type, order, ext, data.data(), length);
+          for (int i = 0; i < length / 2; i++) {
+            ASSERT_EQF(lo[i], data[i * 2]) << type << " " << order << " "
+                                           << ext << " " << length << " " << i;
+            ASSERT_EQF(hi[i], data[i * 2 + 1]) << type << " " << order << " "
+                                               << ext << " " << length << " "
+                                               << i;
+          }
+        }
+      }
+    }
+  }
+}
+
 #ifdef BENCHMARK
 #ifdef SIMD
 TEST(Wavelet, SIMDSpeedup) {